@@ -0,0 +1,625 @@
+# --- BEGIN COPYRIGHT BLOCK ---
+# Copyright (C) 2026 Red Hat, Inc.
+# All rights reserved.
+#
+# License: GPL (version 3 or any later version).
+# See LICENSE for details.
+# --- END COPYRIGHT BLOCK ---
+#
+"""Benchmark helpers: synthetic directory, workload replay and results.
+
+A workload is a list of operations with their start time relative to the
+beginning of the run. It is either derived from an access log (text or
+JSON format) or generated from an operation mix. The DNs and the assertion
+values of the log are replaced by entries of the synthetic directory, so a
+production log can be replayed against a test instance: only the shape of
+the requests (base, scope, filter structure, attributes, operation mix and
+timing) is kept.
+
+The operations are started on schedule by a pool of workers, each one with
+its own connection, and the response time is measured from the scheduled
+start so that a slow server does not hide the operations it delayed.
+
+The results (throughput, latency percentiles per operation type, monitor
+counters and build version) are saved as JSON and two runs can be compared:
+
+    python3 replay.py compare baseline.json new.json [--tolerance 0.1]
+"""
+
+import argparse
+import json
+import logging
+import math
+import random
+import re
+import sys
+import threading
+import time
+from datetime import datetime
+
+log = logging.getLogger(__name__)
+
+USER_PASSWORD_PREFIX = 'Secret_'
+
+# Attributes whose values identify an entry, they are rewritten on replay
+IDENTITY_ATTRS = ('uid', 'cn', 'sn', 'givenname', 'mail', 'uidnumber', 'gidnumber',
+                  'member', 'uniquemember', 'memberof', 'displayname')
+
+OP_TYPES = ('search', 'bind', 'modify', 'add', 'delete', 'modrdn')
+
+DEFAULT_MIX = {'search': 80, 'bind': 15, 'modify': 5}
+
+_TEXT_LINE = re.compile(r'^\[(?P<ts>[^\]]*)\]\sconn=(?P<conn>\d+)\sop=(?P<op>-?\d+)\s(?P<action>[A-Z]+)\s?(?P<rem>.*)$')
+_QUOTED = re.compile(r'(\w+)="((?:[^"\\]|\\.)*)"')
+_SCOPE = re.compile(r'\sscope=(\d)')
+_ASSERTION = re.compile(r'\((?P<attr>[\w.;-]+)(?P<op>=|~=|>=|<=)(?P<value>(?:[^()\\]|\\.)*)\)')
+
+_TEXT_ACTIONS = {'SRCH': 'search', 'BIND': 'bind', 'MOD': 'modify', 'ADD': 'add',
+                 'DEL': 'delete', 'MODRDN': 'modrdn'}
+_JSON_ACTIONS = {'SEARCH': 'search', 'BIND': 'bind', 'MODIFY': 'modify', 'ADD': 'add',
+                 'DELETE': 'delete', 'MODRDN': 'modrdn'}
+
+
+class DirectoryShape(object):
+    """Size and shape of the synthetic directory
+
+    :param users: number of users
+    :param groups: number of groups
+    :param members: number of members of each group
+    :param ous: number of organizational units the users are spread in
+    :param suffix: suffix of the backend
+    """
+
+    def __init__(self, users=10000, groups=100, members=50, ous=10,
+                 suffix='dc=example,dc=com'):
+        self.users = users
+        self.groups = groups
+        self.members = min(members, users)
+        self.ous = max(ous, 1)
+        self.suffix = suffix
+
+    def uid(self, i):
+        return 'user%07d' % i
+
+    def user_dn(self, i):
+        return 'uid=%s,ou=people%d,%s' % (self.uid(i), i % self.ous, self.suffix)
+
+    def group_dn(self, i):
+        return 'cn=group%05d,ou=groups,%s' % (i, self.suffix)
+
+    def as_dict(self):
+        return {'users': self.users, 'groups': self.groups, 'members': self.members,
+                'ous': self.ous, 'suffix': self.suffix}
+
+    def write_ldif(self, ldif_file, seed=0):
+        """Write the whole directory in an LDIF file to import"""
+        rnd = random.Random(seed)
+        rdn = self.suffix.split(',')[0].split('=')
+        with open(ldif_file, 'w') as ldif:
+            ldif.write('dn: %s\nobjectClass: top\nobjectClass: domain\n%s: %s\n' %
+                       (self.suffix, rdn[0], rdn[1]))
+            ldif.write('aci: (targetattr!="userPassword")(version 3.0; acl "Replay read"; '
+                       'allow (read, search, compare) userdn="ldap:///anyone";)\n')
+            ldif.write('aci: (targetattr="description")(version 3.0; acl "Replay self write"; '
+                       'allow (write) userdn="ldap:///self";)\n\n')
+            for ou in ['groups'] + ['people%d' % i for i in range(self.ous)]:
+                ldif.write('dn: ou=%s,%s\nobjectClass: top\nobjectClass: organizationalUnit\n'
+                           'ou: %s\n\n' % (ou, self.suffix, ou))
+            for i in range(self.users):
+                uid = self.uid(i)
+                ldif.write('dn: %s\n' % self.user_dn(i))
+                ldif.write('objectClass: top\nobjectClass: person\nobjectClass: organizationalPerson\n'
+                           'objectClass: inetOrgPerson\nobjectClass: posixAccount\n')
+                ldif.write('uid: %s\ncn: %s\nsn: %s\ngivenName: %s\ndisplayName: %s\n' %
+                           (uid, uid, uid, uid, uid))
+                ldif.write('mail: %s@example.com\nuidNumber: %d\ngidNumber: %d\n' %
+                           (uid, 10000 + i, 10000 + i % max(self.groups, 1)))
+                ldif.write('homeDirectory: /home/%s\nuserPassword: %s%s\n' %
+                           (uid, USER_PASSWORD_PREFIX, uid))
+                ldif.write('description: %s\n\n' % ('x' * rnd.randint(16, 256)))
+            for g in range(self.groups):
+                ldif.write('dn: %s\nobjectClass: top\nobjectClass: groupOfNames\n'
+                           'cn: group%05d\n' % (self.group_dn(g), g))
+                for m in rnd.sample(range(self.users), self.members):
+                    ldif.write('member: %s\n' % self.user_dn(m))
+                ldif.write('\n')
+
+
+class Operation(object):
+    """One request of a workload
+
+    The DNs and filters may contain @@uid@@, @@dn@@, @@mail@@, @@uidnumber@@
+    and @@group@@ that are replaced by a random user or group at replay time.
+    """
+    __slots__ = ('time', 'conn', 'type', 'dn', 'scope', 'filter', 'attrs')
+
+    def __init__(self, time, conn, type, dn='', scope=2, filter=None, attrs=None):
+        self.time = time
+        self.conn = conn
+        self.type = type
+        self.dn = dn
+        self.scope = scope
+        self.filter = filter
+        self.attrs = attrs
+
+
+def _rewrite_dn(dn, log_suffix, suffix):
+    """Map a DN of the log on the synthetic directory"""
+    if dn is None or dn == '':
+        return ''
+    low = dn.lower().replace(', ', ',')
+    if low == 'cn=directory manager':
+        return 'cn=Directory Manager'
+    if log_suffix and low.endswith(log_suffix.lower()):
+        rdns = low[:-len(log_suffix)].rstrip(',')
+        if rdns == '':
+            return suffix
+        first = rdns.split(',')[0]
+        if first.startswith('cn=group') or ',ou=groups' in rdns:
+            return '@@group@@'
+        if first.startswith('ou='):
+            # A container, searching it is meaningful on its own
+            return suffix
+        return '@@dn@@'
+    if low.endswith('cn=config') or low.endswith('cn=monitor') or low == 'cn=schema':
+        return dn
+    if low.startswith(('uid=', 'cn=')):
+        return '@@dn@@'
+    if low.startswith(('dc=', 'o=', 'ou=')):
+        # a naming context or a container of another suffix
+        return suffix
+    return dn
+
+
+def _rewrite_filter(filt):
+    """Keep the structure of a filter, replace the values identifying entries"""
+    def subst(m):
+        attr = m.group('attr')
+        name = attr.split(';')[0].lower()
+        value = m.group('value')
+        if name not in IDENTITY_ATTRS or value == '*':
+            return m.group(0)
+        if name in ('member', 'uniquemember'):
+            new = '@@dn@@'
+        elif name == 'memberof':
+            new = '@@group@@'
+        elif name in ('uidnumber', 'gidnumber'):
+            new = '@@uidnumber@@'
+        elif name == 'mail':
+            new = '@@mail@@'
+        else:
+            new = '@@uid@@'
+        if '*' in value:
+            # substring, keep a prefix of the value
+            new = '@@prefix@@*'
+        return '(%s%s%s)' % (attr, m.group('op'), new)
+    return _ASSERTION.sub(subst, filt)
+
+
+def _parse_text_time(ts):
+    # 21/Apr/2020:10:00:00.123456789 +0000
+    stamp = ts.split(' ')[0]
+    if '.' in stamp:
+        stamp, frac = stamp.split('.', 1)
+    else:
+        frac = '0'
+    dt = datetime.strptime(stamp, '%d/%b/%Y:%H:%M:%S')
+    return dt.timestamp() + float('0.' + frac)
+
+
+def _parse_json_time(ts):
+    # 2025-02-12T17:00:47.663123181 -0500
+    stamp = ts.split(' ')[0]
+    if '.' in stamp:
+        stamp, frac = stamp.split('.', 1)
+    else:
+        frac = '0'
+    dt = datetime.strptime(stamp, '%Y-%m-%dT%H:%M:%S')
+    return dt.timestamp() + float('0.' + frac)
+
+
+def _parse_line(line):
+    """Return (time, conn, type, dn, scope, filter, attrs) or None"""
+    line = line.strip()
+    if line.startswith('{'):
+        try:
+            obj = json.loads(line)
+        except ValueError:
+            return None
+        optype = _JSON_ACTIONS.get(obj.get('operation'))
+        if optype is None or obj.get('internal_op'):
+            return None
+        attrs = obj.get('attrs')
+        if attrs and '...' in attrs:
+            attrs = None
+        return (_parse_json_time(obj['local_time']), int(obj.get('conn_id', 0)), optype,
+                obj.get('base_dn', obj.get('bind_dn', obj.get('target_dn', ''))),
+                int(obj.get('scope', 2)), obj.get('filter'), attrs)
+
+    m = _TEXT_LINE.match(line)
+    if m is None:
+        return None
+    optype = _TEXT_ACTIONS.get(m.group('action'))
+    if optype is None or m.group('op') == '-1':
+        return None
+    fields = dict((k, v.replace('\\"', '"')) for k, v in _QUOTED.findall(m.group('rem')))
+    scope = _SCOPE.search(m.group('rem'))
+    attrs = fields.get('attrs')
+    attrs = attrs.split() if attrs else None
+    return (_parse_text_time(m.group('ts')), int(m.group('conn')), optype,
+            fields.get('base', fields.get('dn', '')),
+            int(scope.group(1)) if scope else 2, fields.get('filter'), attrs)
+
+
+def parse_access_log(path, shape, log_suffix=None, max_idle=1.0):
+    """Derive a workload from an access log
+
+    :param path: access log, text or JSON format
+    :param shape: DirectoryShape the workload will run against
+    :param log_suffix: suffix of the logged server, its entries are replaced
+                       by entries of the synthetic directory
+    :param max_idle: longer gaps between two requests are shortened to this
+    :returns: list of Operation, sorted by time
+    """
+    ops = []
+    first = None
+    last = None
+    shift = 0.0
+    with open(path, 'r', errors='replace') as f:
+        for line in f:
+            parsed = _parse_line(line)
+            if parsed is None:
+                continue
+            ts, conn, optype, dn, scope, filt, attrs = parsed
+            if first is None:
+                first = last = ts
+            if ts - last > max_idle:
+                shift += ts - last - max_idle
+            last = max(last, ts)
+            op = Operation(ts - first - shift, conn, optype,
+                           _rewrite_dn(dn, log_suffix, shape.suffix), scope)
+            if optype == 'search':
+                op.filter = _rewrite_filter(filt or '(objectClass=*)')
+                op.attrs = attrs if attrs and attrs != ['ALL'] else None
+            ops.append(op)
+    ops.sort(key=lambda o: o.time)
+    log.info('Derived %d operations over %.1f seconds from %s', len(ops),
+             ops[-1].time if ops else 0.0, path)
+    return ops
+
+
+def generate_workload(nb_ops, rate, mix=None, conns=32, seed=0):
+    """Generate a workload with Poisson arrivals
+
+    :param nb_ops: number of operations
+    :param rate: operations per second
+    :param mix: weight of each operation type, e.g. {'search': 80, 'bind': 15, 'modify': 5}
+    :param conns: number of client connections
+    """
+    rnd = random.Random(seed)
+    mix = mix or DEFAULT_MIX
+    types = [t for t in mix if mix[t] > 0]
+    weights = [mix[t] for t in types]
+    searches = [('@@suffix@@', 2, '(uid=@@uid@@)', ['cn', 'mail']),
+                ('@@suffix@@', 2, '(&(objectClass=inetOrgPerson)(mail=@@mail@@))', None),
+                ('@@suffix@@', 2, '(cn=@@prefix@@*)', ['uid']),
+                ('@@suffix@@', 2, '(&(objectClass=groupOfNames)(member=@@dn@@))', ['cn']),
+                ('@@dn@@', 0, '(objectClass=*)', None)]
+    ops = []
+    t = 0.0
+    for i in range(nb_ops):
+        t += rnd.expovariate(rate)
+        optype = rnd.choices(types, weights)[0]
+        op = Operation(t, rnd.randrange(conns), optype, '@@dn@@')
+        if optype == 'search':
+            op.dn, op.scope, op.filter, op.attrs = rnd.choice(searches)
+        ops.append(op)
+    return ops
+
+
+class _Latencies(object):
+    def __init__(self):
+        self.values = {}
+        self.errors = {}
+        self.skipped = 0
+        self.lock = threading.Lock()
+
+    def add(self, optype, value, error=False):
+        with self.lock:
+            self.values.setdefault(optype, []).append(value)
+            if error:
+                self.errors[optype] = self.errors.get(optype, 0) + 1
+
+
+def _percentile(values, pct):
+    if not values:
+        return 0.0
+    idx = max(int(math.ceil(pct / 100.0 * len(values))) - 1, 0)
+    return values[min(idx, len(values) - 1)]
+
+
+def _summary(values, errors, duration):
+    values = sorted(values)
+    return {
+        'count': len(values),
+        'errors': errors,
+        'throughput': round(len(values) / duration, 2) if duration > 0 else 0.0,
+        'mean': round(sum(values) / len(values), 3) if values else 0.0,
+        'p50': round(_percentile(values, 50), 3),
+        'p90': round(_percentile(values, 90), 3),
+        'p99': round(_percentile(values, 99), 3),
+        'p999': round(_percentile(values, 99.9), 3),
+        'max': round(values[-1], 3) if values else 0.0,
+    }
+
+
+class _Worker(threading.Thread):
+    def __init__(self, num, uri, shape, ops, start, lat, deadline, dm_password):
+        super(_Worker, self).__init__(name='replay-%d' % num)
+        self.daemon = True
+        self.num = num
+        self.uri = uri
+        self.shape = shape
+        self.ops = ops
+        self.start_time = start
+        self.lat = lat
+        self.deadline = deadline
+        self.dm_password = dm_password
+        self.rnd = random.Random(num)
+        self.added = []
+        self.counter = 0
+        self.bound_dn = 'cn=Directory Manager'
+
+    def _values(self):
+        i = self.rnd.randrange(self.shape.users)
+        uid = self.shape.uid(i)
+        return {
+            '@@uid@@': uid,
+            '@@prefix@@': uid[:-2],
+            '@@dn@@': self.shape.user_dn(i),
+            '@@mail@@': '%s@example.com' % uid,
+            '@@uidnumber@@': str(10000 + i),
+            '@@group@@': self.shape.group_dn(self.rnd.randrange(max(self.shape.groups, 1))),
+            '@@suffix@@': self.shape.suffix,
+        }
+
+    @staticmethod
+    def _fill(template, values):
+        if template is None or '@@' not in template:
+            return template
+        for k, v in values.items():
+            template = template.replace(k, v)
+        return template
+
+    def _bind(self, conn, dn, values):
+        if dn == '':
+            conn.simple_bind_s('', '')
+        elif dn.lower() == 'cn=directory manager':
+            conn.simple_bind_s(dn, self.dm_password)
+        else:
+            dn = values['@@dn@@']
+            conn.simple_bind_s(dn, USER_PASSWORD_PREFIX + values['@@uid@@'])
+        self.bound_dn = dn
+
+    def _run_op(self, conn, op):
+        import ldap
+        values = self._values()
+        dn = self._fill(op.dn, values)
+        if op.type == 'search':
+            conn.search_ext_s(dn, op.scope, self._fill(op.filter, values), op.attrs, sizelimit=1000)
+        elif op.type == 'bind':
+            self._bind(conn, op.dn, values)
+        elif op.type == 'modify':
+            if self.bound_dn.startswith('uid='):
+                # users may only write their own entry
+                dn = self.bound_dn
+            elif not dn.startswith('uid='):
+                dn = values['@@dn@@']
+            conn.modify_s(dn, [(ldap.MOD_REPLACE, 'description',
+                                [('replay %d' % self.counter).encode()])])
+        elif op.type == 'add':
+            self.counter += 1
+            uid = 'replay-%d-%d-%d' % (self.num, self.counter, int(self.start_time))
+            new_dn = 'uid=%s,ou=people0,%s' % (uid, self.shape.suffix)
+            conn.add_s(new_dn, [('objectClass', [b'top', b'person', b'inetOrgPerson']),
+                                ('uid', [uid.encode()]), ('cn', [uid.encode()]),
+                                ('sn', [uid.encode()])])
+            self.added.append(new_dn)
+        elif op.type == 'delete':
+            if not self.added:
+                return False
+            conn.delete_s(self.added.pop(0))
+        elif op.type == 'modrdn':
+            if not self.added:
+                return False
+            old = self.added.pop(0)
+            self.counter += 1
+            new_rdn = 'uid=renamed-%d-%d-%d' % (self.num, self.counter, int(self.start_time))
+            conn.rename_s(old, new_rdn, delold=1)
+            self.added.append('%s,ou=people0,%s' % (new_rdn, self.shape.suffix))
+        return True
+
+    def run(self):
+        import ldap
+        conn = ldap.initialize(self.uri)
+        conn.set_option(ldap.OPT_REFERRALS, 0)
+        conn.simple_bind_s('cn=Directory Manager', self.dm_password)
+        for op in self.ops:
+            sched = self.start_time + op.time
+            if sched > self.deadline:
+                break
+            delay = sched - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+            error = False
+            try:
+                if not self._run_op(conn, op):
+                    with self.lat.lock:
+                        self.lat.skipped += 1
+                    continue
+            except ldap.SERVER_DOWN as e:
+                log.error('%s: server down: %s', self.name, e)
+                self.lat.add(op.type, (time.monotonic() - sched) * 1000.0, True)
+                return
+            except ldap.LDAPError as e:
+                log.debug('%s %s failed: %s', op.type, op.dn, e)
+                error = True
+            self.lat.add(op.type, (time.monotonic() - sched) * 1000.0, error)
+        # Remove what this worker added and did not delete
+        conn.simple_bind_s('cn=Directory Manager', self.dm_password)
+        self.bound_dn = 'cn=Directory Manager'
+        for dn in self.added:
+            try:
+                conn.delete_s(dn)
+            except ldap.LDAPError:
+                pass
+        conn.unbind_s()
+
+
+def _numeric_attrs(entry):
+    result = {}
+    for attr, vals in entry.get_all_attrs_utf8().items():
+        if attr.startswith('dbfile') or attr.startswith('dbi') or len(vals) != 1:
+            continue
+        try:
+            result[attr] = int(vals[0])
+        except ValueError:
+            try:
+                result[attr] = float(vals[0])
+            except ValueError:
+                pass
+    return result
+
+
+def monitor_snapshot(inst, suffix):
+    """Read the numeric counters of cn=monitor and of the backend monitors"""
+    from lib389.monitor import Monitor, MonitorLDBM
+    from lib389.backend import Backends
+    snap = {'server': _numeric_attrs(Monitor(inst)),
+            'ldbm': _numeric_attrs(MonitorLDBM(inst))}
+    be = Backends(inst).get(suffix)
+    snap['backend'] = _numeric_attrs(be.get_monitor())
+    return snap
+
+
+def _monitor_delta(before, after):
+    delta = {}
+    for section in after:
+        delta[section] = {}
+        for attr, val in after[section].items():
+            if attr in before.get(section, {}):
+                delta[section][attr] = round(val - before[section][attr], 3)
+    return delta
+
+
+def replay(inst, shape, ops, threads=16, duration=None, speed=1.0, dm_password='password'):
+    """Replay a workload against an instance
+
+    :param inst: DirSrv instance, online
+    :param shape: DirectoryShape loaded in the instance
+    :param ops: list of Operation
+    :param threads: number of workers (client connections), the operations
+                    of a logged connection always go to the same worker
+    :param duration: stop after this many seconds
+    :param speed: replay speed factor, 2.0 halves the gaps between requests
+    :returns: results dictionary
+    """
+    from lib389.monitor import Monitor
+    per_worker = [[] for _ in range(threads)]
+    for op in ops:
+        op_copy = Operation(op.time / speed, op.conn, op.type, op.dn, op.scope, op.filter, op.attrs)
+        per_worker[op.conn % threads].append(op_copy)
+
+    lat = _Latencies()
+    before = monitor_snapshot(inst, shape.suffix)
+    start = time.monotonic() + 1.0
+    deadline = start + duration if duration else float('inf')
+    uri = 'ldap://%s:%d' % (inst.host, inst.port)
+    workers = [_Worker(i, uri, shape, per_worker[i], start, lat, deadline, dm_password)
+               for i in range(threads) if per_worker[i]]
+    for w in workers:
+        w.start()
+    for w in workers:
+        w.join()
+    elapsed = time.monotonic() - start
+    after = monitor_snapshot(inst, shape.suffix)
+
+    all_values = []
+    operations = {}
+    for optype in OP_TYPES:
+        values = lat.values.get(optype, [])
+        if values:
+            operations[optype] = _summary(values, lat.errors.get(optype, 0), elapsed)
+            all_values.extend(values)
+    operations['all'] = _summary(all_values, sum(lat.errors.values()), elapsed)
+
+    return {
+        'version': Monitor(inst).get_attr_val_utf8('version'),
+        'date': datetime.now().isoformat(timespec='seconds'),
+        'directory': shape.as_dict(),
+        'threads': threads,
+        'speed': speed,
+        'scheduled': len(ops),
+        'skipped': lat.skipped,
+        'duration': round(elapsed, 3),
+        'unit': 'msec',
+        'operations': operations,
+        'monitor': _monitor_delta(before, after),
+    }
+
+
+def save_results(results, path):
+    with open(path, 'w') as f:
+        json.dump(results, f, indent=2, sort_keys=True)
+    log.info('Benchmark results written in %s', path)
+
+
+def compare_results(baseline, current, tolerance=0.10):
+    """List the regressions of current against baseline
+
+    The throughput of each operation type must not drop and its p50/p99
+    must not grow by more than tolerance (a ratio).
+    :returns: list of strings describing the regressions
+    """
+    regressions = []
+    for optype, base in baseline['operations'].items():
+        cur = current['operations'].get(optype)
+        if cur is None or base['count'] == 0:
+            continue
+        if cur['throughput'] < base['throughput'] * (1.0 - tolerance):
+            regressions.append('%s throughput %.2f -> %.2f ops/sec' %
+                               (optype, base['throughput'], cur['throughput']))
+        for key in ('p50', 'p99'):
+            if base[key] > 0 and cur[key] > base[key] * (1.0 + tolerance):
+                regressions.append('%s %s %.3f -> %.3f %s' %
+                                   (optype, key, base[key], cur[key], current.get('unit', '')))
+    return regressions
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description='Compare two benchmark result files')
+    sub = parser.add_subparsers(dest='cmd', required=True)
+    cmp_parser = sub.add_parser('compare', help='report the regressions of a run against a baseline')
+    cmp_parser.add_argument('baseline')
+    cmp_parser.add_argument('current')
+    cmp_parser.add_argument('--tolerance', type=float, default=0.10)
+    args = parser.parse_args(argv)
+
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    with open(args.current) as f:
+        current = json.load(f)
+    print('%-8s %12s %12s %10s %10s %10s %10s' % ('op', 'base ops/s', 'ops/s', 'base p50', 'p50', 'base p99', 'p99'))
+    for optype, base in baseline['operations'].items():
+        cur = current['operations'].get(optype, {})
+        print('%-8s %12.2f %12.2f %10.3f %10.3f %10.3f %10.3f' % (
+            optype, base['throughput'], cur.get('throughput', 0), base['p50'], cur.get('p50', 0),
+            base['p99'], cur.get('p99', 0)))
+    regressions = compare_results(baseline, current, args.tolerance)
+    for r in regressions:
+        print('REGRESSION: %s' % r)
+    return 1 if regressions else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
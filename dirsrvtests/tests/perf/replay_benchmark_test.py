@@ -0,0 +1,140 @@
+# --- BEGIN COPYRIGHT BLOCK ---
+# Copyright (C) 2026 Red Hat, Inc.
+# All rights reserved.
+#
+# License: GPL (version 3 or any later version).
+# See LICENSE for details.
+# --- END COPYRIGHT BLOCK ---
+#
+"""Benchmarks of the core paths, replaying workloads on a synthetic directory
+
+The directory and the workloads are configured with environment variables:
+
+    PERF_USERS, PERF_GROUPS, PERF_MEMBERS, PERF_OUS   size and shape of the directory
+    PERF_THREADS      client connections                            (16)
+    PERF_RATE         operations/sec of the generated mix           (500)
+    PERF_DURATION     seconds of each run                           (30)
+    PERF_MIX          generated mix, e.g. search:80,bind:15,modify:5
+    PERF_ACCESS_LOG   access log to replay (default: a small sample)
+    PERF_LOG_SUFFIX   suffix of the server that wrote the access log
+    PERF_SPEED        replay speed factor of the access log         (1.0)
+    PERF_RESULTS_DIR  where the JSON results are written            (/tmp)
+    PERF_BASELINE     directory of the results of a previous build, the
+                      run fails if it regressed by more than PERF_TOLERANCE
+"""
+
+import logging
+import os
+import pytest
+from lib389._constants import DEFAULT_SUFFIX, DATA_DIR, PW_DM
+from lib389.tasks import ImportTask
+from lib389.topologies import topology_st as topo
+from replay import (DirectoryShape, parse_access_log, generate_workload, replay,
+                    save_results, compare_results)
+
+pytestmark = pytest.mark.tier3
+
+log = logging.getLogger(__name__)
+
+THREADS = int(os.getenv('PERF_THREADS', '16'))
+RATE = float(os.getenv('PERF_RATE', '500'))
+DURATION = float(os.getenv('PERF_DURATION', '30'))
+RESULTS_DIR = os.getenv('PERF_RESULTS_DIR', '/tmp')
+BASELINE = os.getenv('PERF_BASELINE')
+TOLERANCE = float(os.getenv('PERF_TOLERANCE', '0.10'))
+
+
+def _check_results(name, results):
+    """Save the results and compare them with the baseline if any"""
+    save_results(results, os.path.join(RESULTS_DIR, '%s.json' % name))
+    for optype, stats in results['operations'].items():
+        log.info('%-7s %7d ops %9.2f ops/sec p50=%.3f p99=%.3f p99.9=%.3f max=%.3f msec' %
+                 (optype, stats['count'], stats['throughput'], stats['p50'],
+                  stats['p99'], stats['p999'], stats['max']))
+    if BASELINE:
+        import json
+        with open(os.path.join(BASELINE, '%s.json' % name)) as f:
+            baseline = json.load(f)
+        regressions = compare_results(baseline, results, TOLERANCE)
+        assert not regressions, 'Regressions against %s: %s' % (baseline['version'], regressions)
+
+
+@pytest.fixture(scope="module")
+def directory(topo):
+    """Import the synthetic directory in the default backend"""
+    inst = topo.standalone
+    shape = DirectoryShape(users=int(os.getenv('PERF_USERS', '10000')),
+                           groups=int(os.getenv('PERF_GROUPS', '100')),
+                           members=int(os.getenv('PERF_MEMBERS', '50')),
+                           ous=int(os.getenv('PERF_OUS', '10')),
+                           suffix=DEFAULT_SUFFIX)
+    ldif_file = os.path.join(inst.get_ldif_dir(), 'replay_benchmark.ldif')
+    shape.write_ldif(ldif_file)
+    task = ImportTask(inst)
+    task.import_suffix_from_ldif(ldiffile=ldif_file, suffix=DEFAULT_SUFFIX)
+    task.wait(timeout=None)
+    assert task.get_exit_code() == 0
+    os.remove(ldif_file)
+    return shape
+
+
+def test_replay_generated_mix(topo, directory):
+    """Run a generated operation mix at a fixed arrival rate
+
+    :id: 5a0e3d12-7c41-4b8e-9f26-2d81c7b4e903
+    :setup: Standalone instance with the synthetic directory
+    :steps:
+        1. Generate PERF_DURATION seconds of Poisson arrivals at PERF_RATE
+        2. Replay them with PERF_THREADS connections
+        3. Save the results and compare them with the baseline
+    :expectedresults:
+        1. Success
+        2. Every operation succeeds
+        3. No regression
+    """
+    mix = dict((k, int(v)) for k, v in
+               (item.split(':') for item in os.getenv('PERF_MIX', 'search:80,bind:15,modify:5').split(',')))
+    ops = generate_workload(int(RATE * DURATION), RATE, mix, conns=THREADS)
+    results = replay(topo.standalone, directory, ops, threads=THREADS, duration=DURATION,
+                     dm_password=PW_DM)
+    assert results['operations']['all']['count'] > 0
+    assert results['operations']['all']['errors'] == 0
+    _check_results('replay_generated_mix', results)
+
+
+def test_replay_access_log(topo, directory):
+    """Replay the requests of an access log
+
+    :id: c3f78a05-19d2-4e6b-a8c4-6b0f2e95d17a
+    :setup: Standalone instance with the synthetic directory
+    :steps:
+        1. Derive a workload from PERF_ACCESS_LOG, or from the sample log
+        2. Replay it at PERF_SPEED with PERF_THREADS connections
+        3. Save the results and compare them with the baseline
+    :expectedresults:
+        1. The searches, binds and modifications of the log are found
+        2. Every operation succeeds
+        3. No regression
+    """
+    inst = topo.standalone
+    access_log = os.getenv('PERF_ACCESS_LOG')
+    log_suffix = os.getenv('PERF_LOG_SUFFIX')
+    if access_log is None:
+        access_log = os.path.join(inst.getDir(__file__, DATA_DIR), 'perf', 'access.sample')
+        log_suffix = 'dc=corp,dc=example'
+
+    ops = parse_access_log(access_log, directory, log_suffix=log_suffix)
+    assert set(op.type for op in ops) >= {'search', 'bind', 'modify'}
+
+    results = replay(inst, directory, ops, threads=THREADS, duration=DURATION,
+                     speed=float(os.getenv('PERF_SPEED', '1.0')), dm_password=PW_DM)
+    assert results['operations']['search']['count'] > 0
+    assert results['operations']['all']['errors'] == 0
+    _check_results('replay_access_log', results)
+
+
+if __name__ == '__main__':
+    # Run isolated
+    # -s for DEBUG mode
+    CURRENT_FILE = os.path.realpath(__file__)
+    pytest.main(["-s", CURRENT_FILE])
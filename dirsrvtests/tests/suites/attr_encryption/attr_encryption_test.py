@@ -258,6 +258,56 @@ def test_attr_encryption_unindexed(topo, enable_user_attr_encryption):
         assert 'employeeNumber: 1000' not in ldif
 
 
+def test_attr_encryption_multivalued(topo, enable_user_attr_encryption):
+    """Check the values of an entry ciphered with different ciphers
+
+    :id: 6f2d8b41-c7e3-4a59-9d10-3b8e5a4c2f76
+    :setup: Standalone instance
+            Enable AES encryption config on employeenumber
+            Enable 3DES encryption config on telephoneNumber
+            Add a test user with encrypted attributes
+    :steps:
+         1. Add several telephoneNumber values and an employeeNumber to the user
+         2. Restart the server to read the entry from the database
+         3. Check all the values are decrypted
+         4. Search the user twice with each telephoneNumber value
+         5. Delete a value and search it
+    :expectedresults:
+         1. This should be successful
+         2. This should be successful
+         3. This should be successful
+         4. The user is found by every value
+         5. The user is not found by the deleted value
+    """
+    inst = topo.standalone
+    user = enable_user_attr_encryption
+    phones = ['55501%02d' % i for i in range(20)]
+
+    log.info("Add encrypted values with both ciphers")
+    user.replace('telephoneNumber', phones)
+    user.replace('employeeNumber', '2000')
+
+    log.info("Restart the server")
+    inst.restart()
+
+    log.info("Check the values are decrypted")
+    assert sorted(user.get_attr_vals_utf8('telephoneNumber')) == phones
+    assert user.get_attr_val_utf8('employeeNumber') == '2000'
+
+    log.info("Search the encrypted index keys")
+    users = UserAccounts(inst, DEFAULT_SUFFIX)
+    for phone in phones:
+        for _ in range(2):
+            assert len(users.filter('(telephoneNumber=%s)' % phone)) == 1
+
+    log.info("Search a deleted value")
+    user.remove('telephoneNumber', phones[0])
+    assert len(users.filter('(telephoneNumber=%s)' % phones[0])) == 0
+
+    user.replace('telephoneNumber', '1234567890')
+    user.replace('employeeNumber', '1000')
+
+
 def test_attr_encryption_multiple_backends(topo, enable_user_attr_encryption):
     """Tests Configuration of attribute encryption for multiple backends
        Where both the backends have attribute encryption
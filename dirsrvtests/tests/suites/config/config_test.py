@@ -10,6 +10,7 @@
 import logging
 import pytest
 import os
+import time
 from lib389 import DirSrv, pid_from_file
 from lib389.dseldif import DSEldif
 from lib389.tasks import *
@@ -899,6 +900,155 @@ def test_lmdb_autotuned_maxdbs(topology_m2, request):
 
 
 
+def test_result_writer_slow_reader(topo, request):
+    """A client that does not read its results does not block the others
+
+    :id: 5b0e7a52-8d6f-11f1-9c4e-482ae39447e5
+    :setup: Standalone Instance
+    :steps:
+        1. Check the invalid values of the result writer settings are rejected
+        2. Use one worker thread and an output limit above the search size
+        3. Add users with large values
+        4. Start a search of all the users without reading its results
+        5. Search from another connection
+        6. Read the results of the first search
+    :expectedresults:
+        1. Invalid values are rejected
+        2. Success
+        3. Success
+        4. Success
+        5. The search returns while the first one is not read
+        6. All the entries are returned
+    """
+    inst = topo.standalone
+    with pytest.raises(ldap.OPERATIONS_ERROR):
+        inst.config.replace('nsslapd-result-writer-threads', '65')
+    with pytest.raises(ldap.OPERATIONS_ERROR):
+        inst.config.replace('nsslapd-conn-output-max-bytes', '1024')
+
+    threadnumber = inst.config.get_attr_val_utf8('nsslapd-threadnumber')
+    inst.config.replace('nsslapd-result-writer-threads', '2')
+    inst.config.replace('nsslapd-conn-output-max-bytes', '8388608')
+    inst.config.replace('nsslapd-threadnumber', '1')
+    inst.restart()
+
+    users = UserAccounts(inst, DEFAULT_SUFFIX)
+    created = []
+    for idx in range(100):
+        created.append(users.create_test_user(uid=6000 + idx))
+        created[-1].replace('description', 'x' * 20000)
+
+    def fin():
+        for user in created:
+            user.delete()
+        inst.config.replace('nsslapd-threadnumber', threadnumber)
+        inst.restart()
+
+    request.addfinalizer(fin)
+
+    slow = ldap.initialize(inst.toLDAPURL())
+    slow.simple_bind_s(DN_DM, PW_DM)
+    msgid = slow.search_ext(DEFAULT_SUFFIX, ldap.SCOPE_SUBTREE, '(uid=test_user_6*)', ['description'])
+    time.sleep(2)
+
+    # The only worker is not sending the entries of the first search
+    assert len(users.filter('(uid=test_user_6000)')) == 1
+
+    rtype, rdata, rmsgid, rctrls = slow.result3(msgid)
+    assert len(rdata) == 100
+    slow.unbind_s()
+
+
+def test_result_writer_stalled_reader(topo, request):
+    """A client that stops reading its results is disconnected after ioblocktimeout
+
+    :id: 8e3d6c10-9a41-11f1-b6f2-482ae39447e5
+    :setup: Standalone Instance
+    :steps:
+        1. Set nsslapd-ioblocktimeout to 2 seconds
+        2. Add users with large values
+        3. Start a search of all the users without reading its results
+        4. Wait longer than ioblocktimeout, then read the results
+    :expectedresults:
+        1. Success
+        2. Success
+        3. Success
+        4. The connection was closed by the server
+    """
+    inst = topo.standalone
+    ioblocktimeout = inst.config.get_attr_val_utf8('nsslapd-ioblocktimeout')
+    inst.config.replace('nsslapd-ioblocktimeout', '2000')
+
+    users = UserAccounts(inst, DEFAULT_SUFFIX)
+    created = []
+    for idx in range(100):
+        created.append(users.create_test_user(uid=7000 + idx))
+        created[-1].replace('description', 'x' * 20000)
+
+    def fin():
+        for user in created:
+            user.delete()
+        inst.config.replace('nsslapd-ioblocktimeout', ioblocktimeout)
+
+    request.addfinalizer(fin)
+
+    stalled = ldap.initialize(inst.toLDAPURL())
+    stalled.simple_bind_s(DN_DM, PW_DM)
+    msgid = stalled.search_ext(DEFAULT_SUFFIX, ldap.SCOPE_SUBTREE, '(uid=test_user_7*)', ['description'])
+    time.sleep(6)
+
+    with pytest.raises(ldap.SERVER_DOWN):
+        stalled.result3(msgid)
+    assert inst.ds_access_log.match('.*Disconnect - .* - T2.*')
+
+
+def test_accept_threads(topo, request):
+    """Connections are accepted by several threads
+
+    :id: 0c7f3e9a-8e2b-11f1-8d1a-482ae39447e5
+    :setup: Standalone Instance
+    :steps:
+        1. Check the invalid values of nsslapd-accept-threads are rejected
+        2. Use 4 accept threads and 4 connection table lists, and restart
+        3. Check the error log reports the accept threads
+        4. Open many connections and search on each of them
+    :expectedresults:
+        1. Invalid values are rejected
+        2. Success
+        3. Success
+        4. All the connections are accepted and served
+    """
+    inst = topo.standalone
+    assert inst.config.get_attr_val_utf8('nsslapd-accept-threads') == '1'
+    for value in ('0', '17'):
+        with pytest.raises(ldap.OPERATIONS_ERROR):
+            inst.config.replace('nsslapd-accept-threads', value)
+
+    numlisteners = inst.config.get_attr_val_utf8('nsslapd-numlisteners')
+    inst.config.replace('nsslapd-accept-threads', '4')
+    inst.config.replace('nsslapd-numlisteners', '4')
+    inst.restart()
+
+    def fin():
+        inst.config.replace('nsslapd-accept-threads', '1')
+        inst.config.replace('nsslapd-numlisteners', numlisteners)
+        inst.restart()
+
+    request.addfinalizer(fin)
+
+    assert inst.ds_error_log.match('.*Accepting connections with 4 threads.*')
+
+    conns = []
+    for idx in range(64):
+        conn = ldap.initialize(inst.toLDAPURL())
+        conn.simple_bind_s(DN_DM, PW_DM)
+        conns.append(conn)
+    for conn in conns:
+        assert len(conn.search_s('', ldap.SCOPE_BASE, '(objectclass=*)', ['vendorName'])) == 1
+        conn.unbind_s()
+
+
+
 if __name__ == '__main__':
     # Run isolated
     # -s for DEBUG mode
@@ -9,12 +9,14 @@
 import logging
 import time
 import pytest, os, ldap
-from lib389.cos import  CosClassicDefinition, CosClassicDefinitions, CosTemplate
+from lib389.cos import  CosClassicDefinition, CosClassicDefinitions, CosTemplate, CosPointerDefinition
 from lib389._constants import DEFAULT_SUFFIX
 from lib389.topologies import topology_st as topo
 from lib389.idm.role import FilteredRoles
 from lib389.idm.nscontainer import nsContainer
 from lib389.idm.user import UserAccount
+from lib389.idm.organizationalunit import OrganizationalUnits
+from lib389.monitor import MonitorLDBM
 
 logging.getLogger(__name__).setLevel(logging.INFO)
 log = logging.getLogger(__name__)
@@ -144,6 +146,77 @@ def test_vattr_on_cos_definition(topo, reset_ignore_vattr):
     topo.standalone.restart()
     assert topo.standalone.config.get_attr_val_utf8('nsslapd-ignore-virtual-attrs') == "on"
 
+
+def _vattr_cache_hits(inst):
+    return int(MonitorLDBM(inst).get_attr_val_utf8('vattrCacheHits'))
+
+
+def test_vattr_cache_scoped_invalidation(topo, request):
+    """Check that a CoS change only invalidates the virtual attributes
+    cached under the target trees of the changed definitions
+
+    :id: 4f0f6b0e-1d4c-4a4e-9b8e-2c7b1f6f3a51
+    :setup: Standalone instance
+    :steps:
+        1. Add a pointer CoS definition and template in ou=cosA and in ou=cosB
+        2. Add a user in ou=cosA and read its postalCode twice
+        3. Change the definition of ou=cosB and read the postalCode of the user
+        4. Change the template of ou=cosA and read the postalCode of the user
+    :expectedresults:
+        1. Success
+        2. The template value is returned
+        3. The same value is returned from the entry vattr cache, vattrCacheHits increased
+        4. The new template value is returned
+    """
+    inst = topo.standalone
+    ous = OrganizationalUnits(inst, DEFAULT_SUFFIX)
+    cos = {}
+    for tree in ('cosA', 'cosB'):
+        ou = ous.create(properties={'ou': tree})
+        template = CosTemplate(inst, 'cn={}_template,{}'.format(tree, ou.dn))
+        template.create(properties={'cn': '{}_template'.format(tree),
+                                    'postalCode': '{}-1'.format(tree)})
+        cosdef = CosPointerDefinition(inst, 'cn={}_def,{}'.format(tree, ou.dn))
+        cosdef.create(properties={'cn': '{}_def'.format(tree),
+                                  'cosTemplateDn': template.dn,
+                                  'cosAttribute': 'postalCode'})
+        cos[tree] = (ou, template, cosdef)
+
+    user = UserAccount(inst, 'uid=cosuser,{}'.format(cos['cosA'][0].dn))
+    user.create(properties={'uid': 'cosuser',
+                            'cn': 'cosuser',
+                            'sn': 'user',
+                            'uidNumber': '1001',
+                            'gidNumber': '2001',
+                            'homeDirectory': '/home/cosuser'})
+
+    def fin():
+        user.delete()
+        for ou, template, cosdef in cos.values():
+            cosdef.delete()
+            template.delete()
+            ou.delete()
+
+    request.addfinalizer(fin)
+    # the cos cache is rebuilt asynchronously
+    time.sleep(2)
+
+    assert user.get_attr_val_utf8('postalCode') == 'cosA-1'
+    assert user.get_attr_val_utf8('postalCode') == 'cosA-1'
+
+    log.info('Change the definition of ou=cosB, the values cached in ou=cosA are kept')
+    cos['cosB'][2].add('cosAttribute', 'street')
+    time.sleep(2)
+    hits = _vattr_cache_hits(inst)
+    assert user.get_attr_val_utf8('postalCode') == 'cosA-1'
+    assert _vattr_cache_hits(inst) > hits
+
+    log.info('Change the template of ou=cosA, the new value is returned')
+    cos['cosA'][1].replace('postalCode', 'cosA-2')
+    time.sleep(2)
+    assert user.get_attr_val_utf8('postalCode') == 'cosA-2'
+
+
 if __name__ == "__main__":
     CURRENT_FILE = os.path.realpath(__file__)
     pytest.main("-s -v %s" % CURRENT_FILE)
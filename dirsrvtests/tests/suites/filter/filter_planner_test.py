@@ -0,0 +1,128 @@
+# --- BEGIN COPYRIGHT BLOCK ---
+# Copyright (C) 2025 Red Hat, Inc.
+# All rights reserved.
+#
+# License: GPL (version 3 or any later version).
+# See LICENSE for details.
+# --- END COPYRIGHT BLOCK ---
+#
+import os
+import logging
+import ldap
+import pytest
+from ldap.controls import LDAPControl
+from lib389._constants import DEFAULT_SUFFIX, DEFAULT_BENAME
+from lib389.topologies import topology_st as topo
+from lib389.backend import DatabaseConfig
+from lib389.idm.user import UserAccounts
+from lib389.tasks import IndexStatisticsTask
+
+pytestmark = pytest.mark.tier1
+
+log = logging.getLogger(__name__)
+
+FILTER_PLAN_OID = '2.16.840.1.113730.3.4.21'
+USER_COUNT = 200
+
+
+@pytest.fixture(scope="module")
+def users(topo, request):
+    inst = topo.standalone
+    users = UserAccounts(inst, DEFAULT_SUFFIX)
+    users_set = []
+    for i in range(USER_COUNT):
+        name = 'planner_%d' % i
+        users_set.append(users.create(properties={
+            'uid': name,
+            'sn': name,
+            'cn': name,
+            'uidNumber': str(1000 + i),
+            'gidNumber': '1000',
+            'homeDirectory': '/home/%s' % name,
+        }))
+
+    def fin():
+        for user in users_set:
+            user.delete()
+
+    request.addfinalizer(fin)
+    return users_set
+
+
+def _search_with_plan(inst, filterstr):
+    msgid = inst.search_ext(DEFAULT_SUFFIX, ldap.SCOPE_SUBTREE, filterstr, ['uid'],
+                            serverctrls=[LDAPControl(FILTER_PLAN_OID, False, None)])
+    rtype, rdata, rmsgid, rctrls = inst.result3(msgid)
+    plan = None
+    for ctrl in rctrls:
+        if ctrl.controlType == FILTER_PLAN_OID:
+            plan = (ctrl.encodedControlValue or b'').decode()
+    return sorted(dn for dn, attrs in rdata), plan
+
+
+def test_filter_planner(topo, users, request):
+    """Check that the filter planner ranks AND components by index statistics
+
+    :id: 2b3f4d8e-6c51-4f0a-9b7e-0c2d1e6a4f35
+    :setup: Standalone instance with 200 users
+    :steps:
+        1. Check nsslapd-search-filter-planner is on by default
+        2. Run the index statistics task on userRoot
+        3. Search an AND filter with the filter plan control
+        4. Check the most selective component is evaluated first
+        5. Check the same entries are returned with the planner disabled
+        6. Enable the filter plan stat log level and check the access log
+    :expectedresults:
+        1. Success
+        2. Success
+        3. Success
+        4. Success
+        5. Success
+        6. Success
+    """
+    inst = topo.standalone
+    db_cfg = DatabaseConfig(inst)
+
+    # Step 1
+    assert db_cfg.get_attr_val_utf8_l('nsslapd-search-filter-planner') == 'on'
+
+    # Step 2
+    task = IndexStatisticsTask(inst)
+    task.create(properties={'nsInstance': DEFAULT_BENAME})
+    task.wait()
+    assert task.get_exit_code() == 0
+
+    # Step 3
+    filterstr = '(&(objectclass=posixAccount)(uid=planner_42))'
+    planned, plan = _search_with_plan(inst, filterstr)
+    log.info('Filter plan: %s', plan)
+    assert len(planned) == 1
+    assert plan is not None
+
+    # Step 4
+    assert plan.startswith('AND[uid:eq est=1 got=1')
+
+    # Step 5
+    db_cfg.set([('nsslapd-search-filter-planner', 'off')])
+    unplanned, plan = _search_with_plan(inst, filterstr)
+    assert planned == unplanned
+    assert plan == ''
+    db_cfg.set([('nsslapd-search-filter-planner', 'on')])
+
+    # Step 6
+    inst.config.set('nsslapd-statlog-level', '2')
+    inst.search_s(DEFAULT_SUFFIX, ldap.SCOPE_SUBTREE, filterstr)
+    assert inst.ds_access_log.match('.*STAT filter plan: AND\\[uid:eq.*')
+
+    def fin():
+        db_cfg.set([('nsslapd-search-filter-planner', 'on')])
+        inst.config.set('nsslapd-statlog-level', '0')
+
+    request.addfinalizer(fin)
+
+
+if __name__ == '__main__':
+    # Run isolated
+    # -s for DEBUG mode
+    CURRENT_FILE = os.path.realpath(__file__)
+    pytest.main(["-s", CURRENT_FILE])
@@ -0,0 +1,248 @@
+# --- BEGIN COPYRIGHT BLOCK ---
+# Copyright (C) 2025 Red Hat, Inc.
+# All rights reserved.
+#
+# License: GPL (version 3 or any later version).
+# See LICENSE for details.
+# --- END COPYRIGHT BLOCK ---
+#
+import os
+import logging
+import ldap
+import pytest
+from ldap.controls import SimplePagedResultsControl
+from lib389._constants import DEFAULT_SUFFIX
+from lib389.topologies import topology_st as topo
+from lib389.backend import Backends, DatabaseConfig
+from lib389.idm.user import UserAccounts
+from lib389.idm.organizationalunit import OrganizationalUnits
+
+pytestmark = pytest.mark.tier1
+
+log = logging.getLogger(__name__)
+
+USER_COUNT = 300
+
+FILTERS = [
+    '(objectclass=posixAccount)',
+    '(&(objectclass=posixAccount)(gidNumber=1001))',
+    '(&(objectclass=posixAccount)(description=*))',
+    '(|(uid=stream_1)(uid=stream_2)(cn=stream_250))',
+    '(&(objectclass=posixAccount)(!(uid=stream_1)))',
+]
+
+
+@pytest.fixture(scope="module")
+def users(topo, request):
+    inst = topo.standalone
+    ous = OrganizationalUnits(inst, DEFAULT_SUFFIX)
+    ou = ous.create(properties={'ou': 'stream'})
+    users = UserAccounts(inst, DEFAULT_SUFFIX, rdn='ou=stream')
+    users_set = []
+    for i in range(USER_COUNT):
+        name = 'stream_%d' % i
+        users_set.append(users.create(properties={
+            'uid': name,
+            'sn': name,
+            'cn': name,
+            'uidNumber': str(1000 + i),
+            'gidNumber': str(1000 + i % 3),
+            'homeDirectory': '/home/%s' % name,
+        }))
+
+    def fin():
+        for user in users_set:
+            user.delete()
+        ou.delete()
+
+    request.addfinalizer(fin)
+    return users_set
+
+
+def _paged_search(inst, base, filterstr, page_size):
+    req_ctrl = SimplePagedResultsControl(True, size=page_size, cookie='')
+    results = []
+    while True:
+        msgid = inst.search_ext(base, ldap.SCOPE_SUBTREE, filterstr, ['uid'], serverctrls=[req_ctrl])
+        rtype, rdata, rmsgid, rctrls = inst.result3(msgid)
+        results.extend(dn for dn, attrs in rdata)
+        pctrls = [c for c in rctrls if c.controlType == SimplePagedResultsControl.controlType]
+        if not pctrls or not pctrls[0].cookie:
+            break
+        req_ctrl.cookie = pctrls[0].cookie
+    return results
+
+
+def test_stream_candidates(topo, users, request):
+    """Check that streamed subtree searches return the same entries
+
+    :id: 7c0e5b1a-3f4d-4e62-8a9b-5d1f2c3e4a70
+    :setup: Standalone instance with 300 users
+    :steps:
+        1. Search the filters with nsslapd-search-stream-threshold set to 0
+        2. Set nsslapd-search-stream-threshold to 1 to stream every search
+        3. Search the filters again, from the suffix and from the users ou
+        4. Search the filters again with paged results
+    :expectedresults:
+        1. Success
+        2. Success
+        3. The same entries are returned
+        4. The same entries are returned, without duplicates
+    """
+    inst = topo.standalone
+    db_cfg = DatabaseConfig(inst)
+    bases = [DEFAULT_SUFFIX, 'ou=stream,' + DEFAULT_SUFFIX]
+
+    # Step 1
+    db_cfg.set([('nsslapd-search-stream-threshold', '0')])
+    expected = {}
+    for base in bases:
+        for filterstr in FILTERS:
+            expected[(base, filterstr)] = sorted(dn for dn, attrs in inst.search_s(base, ldap.SCOPE_SUBTREE, filterstr, ['uid']))
+
+    # Step 2
+    db_cfg.set([('nsslapd-search-stream-threshold', '1')])
+
+    # Step 3
+    for base in bases:
+        for filterstr in FILTERS:
+            streamed = [dn for dn, attrs in inst.search_s(base, ldap.SCOPE_SUBTREE, filterstr, ['uid'])]
+            log.info('%s %s: %d entries', base, filterstr, len(streamed))
+            assert sorted(streamed) == expected[(base, filterstr)]
+
+    # Step 4
+    for base in bases:
+        for filterstr in FILTERS:
+            paged = _paged_search(inst, base, filterstr, 7)
+            assert len(paged) == len(set(paged))
+            assert sorted(paged) == expected[(base, filterstr)]
+
+    def fin():
+        db_cfg.set([('nsslapd-search-stream-threshold', '0')])
+
+    request.addfinalizer(fin)
+
+
+def test_stream_limits(topo, users, request):
+    """Check that streamed searches keep the limits of the unindexed searches
+
+    :id: 2b8d6e4f-91a7-4c3e-b5d0-7f6a1e8c4d92
+    :setup: Standalone instance with 300 users
+    :steps:
+        1. Set nsslapd-search-stream-threshold to 1 and nsslapd-require-index to on
+        2. Search an unindexed attribute in an AND filter
+        3. Set nsslapd-idlistscanlimit to 100 and search (objectclass=posixAccount)
+        4. Set nsslapd-require-index to off and search (objectclass=posixAccount)
+    :expectedresults:
+        1. Success
+        2. The user is returned and the search is logged with notes=U
+        3. The search is rejected as unindexed
+        4. The 300 users are returned and the search is logged with notes=A
+    """
+    inst = topo.standalone
+    db_cfg = DatabaseConfig(inst)
+    be = [be for be in Backends(inst).list()
+          if be.get_attr_val_utf8_l('nsslapd-suffix') == DEFAULT_SUFFIX][0]
+    base = 'ou=stream,' + DEFAULT_SUFFIX
+    scanlimit = db_cfg.get_attr_val_utf8('nsslapd-idlistscanlimit')
+
+    def fin():
+        be.set('nsslapd-require-index', 'off')
+        db_cfg.set([('nsslapd-idlistscanlimit', scanlimit),
+                    ('nsslapd-search-stream-threshold', '0')])
+
+    request.addfinalizer(fin)
+
+    # Step 1
+    db_cfg.set([('nsslapd-search-stream-threshold', '1')])
+    be.set('nsslapd-require-index', 'on')
+
+    # Step 2
+    assert len(inst.search_s(base, ldap.SCOPE_SUBTREE, '(&(objectclass=posixAccount)(homeDirectory=/home/stream_1))', ['uid'])) == 1
+    assert inst.ds_access_log.match(r'.*notes=U.*')
+
+    # Step 3
+    db_cfg.set([('nsslapd-idlistscanlimit', '100')])
+    with pytest.raises(ldap.UNWILLING_TO_PERFORM):
+        inst.search_s(base, ldap.SCOPE_SUBTREE, '(objectclass=posixAccount)', ['uid'])
+
+    # Step 4
+    be.set('nsslapd-require-index', 'off')
+    assert len(inst.search_s(base, ldap.SCOPE_SUBTREE, '(objectclass=posixAccount)', ['uid'])) == USER_COUNT
+    assert inst.ds_access_log.match(r'.*notes=A.*')
+
+
+def test_stream_index_deleted_between_pages(topo, users, request):
+    """Check that a paged streamed search survives the deletion of its index
+
+    :id: 4e9a1c7d-2b6f-48a3-9d05-c83e7f1b6a24
+    :setup: Standalone instance with 300 users
+    :steps:
+        1. Index gidNumber in equality and set nsslapd-search-stream-threshold to 1
+        2. Read the first page of a streamed paged search on gidNumber
+        3. Delete the gidNumber index
+        4. Read the next pages
+        5. Search the instance
+    :expectedresults:
+        1. Success
+        2. Success
+        3. Success
+        4. The remaining entries are returned, or the search fails with an
+           operations error, the key stream does not use the deleted index
+        5. The server is still running
+    """
+    inst = topo.standalone
+    db_cfg = DatabaseConfig(inst)
+    be = [be for be in Backends(inst).list()
+          if be.get_attr_val_utf8_l('nsslapd-suffix') == DEFAULT_SUFFIX][0]
+    base = 'ou=stream,' + DEFAULT_SUFFIX
+    filterstr = '(&(objectclass=posixAccount)(gidNumber=1001))'
+
+    def fin():
+        db_cfg.set([('nsslapd-search-stream-threshold', '0')])
+        try:
+            be.del_index('gidNumber')
+        except ValueError:
+            pass
+
+    request.addfinalizer(fin)
+
+    # Step 1
+    be.add_index('gidNumber', ['eq'])
+    be.reindex(['gidNumber'], wait=True)
+    db_cfg.set([('nsslapd-search-stream-threshold', '1')])
+    expected = sorted(dn for dn, attrs in inst.search_s(base, ldap.SCOPE_SUBTREE, filterstr, ['uid']))
+    assert len(expected) == USER_COUNT // 3
+
+    # Step 2
+    req_ctrl = SimplePagedResultsControl(True, size=7, cookie='')
+    msgid = inst.search_ext(base, ldap.SCOPE_SUBTREE, filterstr, ['uid'], serverctrls=[req_ctrl])
+    rtype, rdata, rmsgid, rctrls = inst.result3(msgid)
+    results = [dn for dn, attrs in rdata]
+    req_ctrl.cookie = [c for c in rctrls if c.controlType == SimplePagedResultsControl.controlType][0].cookie
+    assert req_ctrl.cookie
+
+    # Step 3
+    be.del_index('gidNumber')
+
+    # Step 4
+    try:
+        while req_ctrl.cookie:
+            msgid = inst.search_ext(base, ldap.SCOPE_SUBTREE, filterstr, ['uid'], serverctrls=[req_ctrl])
+            rtype, rdata, rmsgid, rctrls = inst.result3(msgid)
+            results.extend(dn for dn, attrs in rdata)
+            req_ctrl.cookie = [c for c in rctrls if c.controlType == SimplePagedResultsControl.controlType][0].cookie
+        assert sorted(results) == expected
+    except ldap.OPERATIONS_ERROR:
+        log.info('streamed search stopped after the index deletion')
+
+    # Step 5
+    assert inst.status()
+    assert len(inst.search_s(base, ldap.SCOPE_SUBTREE, '(uid=stream_1)', ['uid'])) == 1
+
+
+if __name__ == '__main__':
+    # Run isolated
+    # -s for DEBUG mode
+    CURRENT_FILE = os.path.realpath(__file__)
+    pytest.main(["-s", CURRENT_FILE])
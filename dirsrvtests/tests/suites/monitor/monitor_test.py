@@ -14,6 +14,8 @@ from lib389.backend import Backends, DatabaseConfig
 from lib389._constants import *
 from lib389.topologies import topology_st as topo
 from lib389._mapped_object import DSLdapObjects
+from lib389.idm.user import UserAccounts
+from lib389.plugins import MemberOfPlugin
 
 pytestmark = pytest.mark.tier1
 
@@ -153,6 +155,112 @@ def test_monitor_backend(topo):
         assert False
 
 
+def test_monitor_cache_memory(topo):
+    """Check the entry cache size follows the modifications of an entry
+
+    :id: 8d2f61c4-5b0e-4a37-9c18-e4a7f03b6d52
+    :setup: Single instance
+    :steps:
+        1. Add a user and read it to load it in the entry cache
+        2. Add a large value to the user
+        3. Check the entry cache size
+        4. Remove the large value
+        5. Check the entry cache size
+        6. Check the memory breakdown of the backend and of the database
+    :expectedresults:
+        1. Success
+        2. Success
+        3. The size grew by at least the size of the value
+        4. Success
+        5. The size went down by at least the size of the value
+        6. The total covers the entry and DN caches
+    """
+    inst = topo.standalone
+    be = Backends(inst).get(DEFAULT_SUFFIX)
+    monitor = be.get_monitor()
+    big = 'x' * 100000
+
+    # Step 1
+    user = UserAccounts(inst, DEFAULT_SUFFIX).create_test_user(uid=5100)
+    user.get_attr_val_utf8('cn')
+    before = monitor.get_attr_val_int('currentEntryCacheSize')
+
+    # Step 2
+    user.replace('description', big)
+    user.get_attr_val_utf8('description')
+
+    # Step 3
+    grown = monitor.get_attr_val_int('currentEntryCacheSize')
+    log.info('entry cache size %d -> %d' % (before, grown))
+    assert grown >= before + len(big)
+
+    # Step 4
+    user.replace('description', 'small')
+
+    # Step 5
+    shrunk = monitor.get_attr_val_int('currentEntryCacheSize')
+    log.info('entry cache size %d -> %d' % (grown, shrunk))
+    assert shrunk <= grown - len(big)
+
+    # Step 6
+    total = monitor.get_attr_val_int('currentCacheMemorySize')
+    assert total >= shrunk
+    assert monitor.get_attr_val_int('currentSearchSnapshotSize') >= 0
+    assert MonitorLDBM(inst).get_attr_val_int('currentVattrCacheSize') >= 0
+
+    user.delete()
+
+
+def test_monitor_plugin_calls(topo):
+    """Check the call statistics of the callbacks of a plugin
+
+    :id: 2b6f0d83-4e1a-4c57-a8f9-71d3c5e02a64
+    :setup: Single instance
+    :steps:
+        1. Enable the MemberOf plugin and restart the server
+        2. Log the plugin calls longer than 1 msec
+        3. Add a user
+        4. Read the monitor entry of the plugin
+        5. Disable the plugin and restart the server
+    :expectedresults:
+        1. Success
+        2. Success
+        3. Success
+        4. The betxn post add callback was called and its histogram
+           counts all the calls
+        5. The monitor entry of the plugin is gone
+    """
+    inst = topo.standalone
+
+    # Step 1
+    memberof = MemberOfPlugin(inst)
+    memberof.enable()
+    inst.restart()
+
+    # Step 2
+    inst.config.replace('nsslapd-plugin-slow-threshold', '1')
+
+    # Step 3
+    user = UserAccounts(inst, DEFAULT_SUFFIX).create_test_user(uid=5200)
+
+    # Step 4
+    monitor = MonitorPlugin(inst, 'MemberOf Plugin')
+    assert monitor.exists()
+    stats = [s for s in monitor.get_callstats() if s['callback'] == 'betxnpostadd']
+    log.info('MemberOf callbacks: %s' % stats)
+    assert stats
+    assert stats[0]['calls'] >= 1
+    assert sum(stats[0]['latency']) == stats[0]['calls']
+    assert monitor.get_attr_val_int('totalcalls') >= stats[0]['calls']
+
+    # Step 5
+    user.delete()
+    inst.config.replace('nsslapd-plugin-slow-threshold', '0')
+    memberof.disable()
+    inst.restart()
+    assert not monitor.exists()
+
+
 def test_num_subordinates_with_monitor_suffix(topo):
     """This test is to compare the numSubordinates value on the root entry with the actual number of direct subordinate(s).
 
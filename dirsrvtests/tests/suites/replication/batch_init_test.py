@@ -0,0 +1,97 @@
+# --- BEGIN COPYRIGHT BLOCK ---
+# Copyright (C) 2026 Red Hat, Inc.
+# All rights reserved.
+#
+# License: GPL (version 3 or any later version).
+# See LICENSE for details.
+# --- END COPYRIGHT BLOCK ---
+#
+import logging
+import pytest
+import os
+from lib389._constants import DEFAULT_SUFFIX
+from lib389.topologies import topology_m1c1 as topo
+from lib389.agreement import Agreements
+from lib389.replica import ReplicationManager
+from lib389.idm.user import UserAccounts
+
+pytestmark = pytest.mark.tier1
+
+DEBUGGING = os.getenv("DEBUGGING", default=False)
+if DEBUGGING:
+    logging.getLogger(__name__).setLevel(logging.DEBUG)
+else:
+    logging.getLogger(__name__).setLevel(logging.INFO)
+log = logging.getLogger(__name__)
+
+# More entries than a single batch holds
+USER_COUNT = 1200
+
+
+def test_batch_init(topo):
+    """Check a total update sending several entries per extended operation
+
+    :id: 5a1f8c3e-7d24-4b96-a0c5-e28b4f6d9173
+    :setup: One supplier and one consumer
+    :steps:
+        1. Add users on the supplier, one of them larger than a batch
+        2. Initialize the consumer
+        3. Compare the users on both servers
+        4. Modify a user on the supplier
+        5. Check the replication towards the consumer
+    :expectedresults:
+        1. Success
+        2. The total update succeeds
+        3. The users and their values are identical
+        4. Success
+        5. The modification is replicated
+    """
+    supplier = topo.ms['supplier1']
+    consumer = topo.cs['consumer1']
+    repl = ReplicationManager(DEFAULT_SUFFIX)
+
+    # Step 1
+    users = UserAccounts(supplier, DEFAULT_SUFFIX)
+    for i in range(USER_COUNT):
+        name = 'batch_%d' % i
+        users.create(properties={
+            'uid': name,
+            'sn': name,
+            'cn': name,
+            'uidNumber': str(9000 + i),
+            'gidNumber': '9000',
+            'homeDirectory': '/home/%s' % name,
+            'description': 'batch user %d' % i,
+        })
+    users.get('batch_7').replace('description', 'x' * (1024 * 1024))
+
+    # Step 2
+    agmt = Agreements(supplier).list()[0]
+    agmt.begin_reinit()
+    (done, error) = agmt.wait_reinit()
+    assert done is True
+    assert error is False
+
+    # Step 3
+    def _dump(inst):
+        return sorted((user.dn.lower(), user.get_attr_val_utf8('description'))
+                      for user in UserAccounts(inst, DEFAULT_SUFFIX).list()
+                      if user.get_attr_val_utf8_l('uid').startswith('batch_'))
+
+    expected = _dump(supplier)
+    assert len(expected) == USER_COUNT
+    assert _dump(consumer) == expected
+
+    # Step 4
+    users.get('batch_42').replace('description', 'after init')
+
+    # Step 5
+    repl.wait_for_replication(supplier, consumer)
+    assert UserAccounts(consumer, DEFAULT_SUFFIX).get('batch_42').get_attr_val_utf8('description') == 'after init'
+
+
+if __name__ == '__main__':
+    # Run isolated
+    # -s for DEBUG mode
+    CURRENT_FILE = os.path.realpath(__file__)
+    pytest.main(["-s", CURRENT_FILE])
@@ -0,0 +1,117 @@
+# --- BEGIN COPYRIGHT BLOCK ---
+# Copyright (C) 2026 Red Hat, Inc.
+# All rights reserved.
+#
+# License: GPL (version 3 or any later version).
+# See LICENSE for details.
+# --- END COPYRIGHT BLOCK ---
+#
+import logging
+import pytest
+import os
+from lib389._constants import DEFAULT_SUFFIX
+from lib389.topologies import topology_m1c1 as topo
+from lib389.agreement import Agreements
+from lib389.replica import Changelog, Replicas, ReplicationManager
+from lib389.idm.user import UserAccounts
+
+pytestmark = pytest.mark.tier1
+
+DEBUGGING = os.getenv("DEBUGGING", default=False)
+if DEBUGGING:
+    logging.getLogger(__name__).setLevel(logging.DEBUG)
+else:
+    logging.getLogger(__name__).setLevel(logging.INFO)
+log = logging.getLogger(__name__)
+
+USER_COUNT = 20
+
+
+def test_cl_compression(topo, request):
+    """Check that compressed changelog records are replayed
+
+    :id: 3c9e5a17-b2d8-4f60-8e41-6d0a7f2b9c58
+    :setup: One supplier and one consumer
+    :steps:
+        1. Enable nsslapd-changelogcompression on the supplier
+        2. Pause the agreement and add users with large values
+        3. Check the compression statistics of the replica
+        4. Restart the supplier and resume the agreement
+        5. Compare the users on both servers
+        6. Disable the compression and modify a user
+        7. Check the replication towards the consumer
+    :expectedresults:
+        1. Success
+        2. Success
+        3. Records are compressed and the stored size is smaller
+        4. Success
+        5. The users and their values are identical
+        6. Success
+        7. The modification is replicated
+    """
+    supplier = topo.ms['supplier1']
+    consumer = topo.cs['consumer1']
+    repl = ReplicationManager(DEFAULT_SUFFIX)
+    cl = Changelog(supplier, DEFAULT_SUFFIX)
+    agmt = Agreements(supplier).list()[0]
+
+    # Step 1
+    cl.replace('nsslapd-changelogcompression', 'on')
+
+    # Step 2
+    agmt.pause()
+    users = UserAccounts(supplier, DEFAULT_SUFFIX)
+    for i in range(USER_COUNT):
+        name = 'clzip_%d' % i
+        users.create(properties={
+            'uid': name,
+            'sn': name,
+            'cn': name,
+            'uidNumber': str(7000 + i),
+            'gidNumber': '7000',
+            'homeDirectory': '/home/%s' % name,
+            'description': 'compressed changelog record %d ' % i * 64,
+        })
+
+    # Step 3
+    replica = Replicas(supplier).get(DEFAULT_SUFFIX)
+    assert int(replica.get_attr_val_utf8('nsds5replicaChangelogCompressedRecords')) >= USER_COUNT
+    raw = int(replica.get_attr_val_utf8('nsds5replicaChangelogRawBytes'))
+    stored = int(replica.get_attr_val_utf8('nsds5replicaChangelogStoredBytes'))
+    log.info('changelog mods: %d bytes stored in %d bytes' % (raw, stored))
+    assert stored < raw
+
+    # Step 4
+    supplier.restart()
+    agmt.resume()
+    repl.wait_for_replication(supplier, consumer)
+
+    # Step 5
+    def _dump(inst):
+        return sorted((user.dn.lower(), user.get_attr_val_utf8('description'))
+                      for user in UserAccounts(inst, DEFAULT_SUFFIX).list()
+                      if user.get_attr_val_utf8_l('uid').startswith('clzip_'))
+
+    expected = _dump(supplier)
+    assert len(expected) == USER_COUNT
+    assert _dump(consumer) == expected
+
+    # Step 6
+    cl.replace('nsslapd-changelogcompression', 'off')
+    users.get('clzip_3').replace('description', 'not compressed')
+
+    # Step 7
+    repl.wait_for_replication(supplier, consumer)
+    assert UserAccounts(consumer, DEFAULT_SUFFIX).get('clzip_3').get_attr_val_utf8('description') == 'not compressed'
+
+    def fin():
+        cl.remove_all('nsslapd-changelogcompression')
+
+    request.addfinalizer(fin)
+
+
+if __name__ == '__main__':
+    # Run isolated
+    # -s for DEBUG mode
+    CURRENT_FILE = os.path.realpath(__file__)
+    pytest.main(["-s", CURRENT_FILE])
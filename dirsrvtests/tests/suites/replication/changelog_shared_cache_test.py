@@ -0,0 +1,94 @@
+# --- BEGIN COPYRIGHT BLOCK ---
+# Copyright (C) 2026 Red Hat, Inc.
+# All rights reserved.
+#
+# License: GPL (version 3 or any later version).
+# See LICENSE for details.
+# --- END COPYRIGHT BLOCK ---
+#
+import logging
+import pytest
+import os
+from lib389._constants import DEFAULT_SUFFIX
+from lib389.topologies import topology_m2c2 as topo
+from lib389.replica import ReplicationManager
+from lib389.idm.user import UserAccounts
+
+pytestmark = pytest.mark.tier1
+
+DEBUGGING = os.getenv("DEBUGGING", default=False)
+if DEBUGGING:
+    logging.getLogger(__name__).setLevel(logging.DEBUG)
+else:
+    logging.getLogger(__name__).setLevel(logging.INFO)
+log = logging.getLogger(__name__)
+
+USER_COUNT = 50
+
+
+def test_shared_decoded_changes(topo):
+    """Check that the agreements of a supplier replay the same changes
+
+    :id: 8d3f1b6a-52c7-4e09-a1d4-7b9e2c6f0a35
+    :setup: Two suppliers and two consumers
+    :steps:
+        1. Add users on supplier1
+        2. Modify, rename and delete some of them on supplier1
+        3. Wait for the replication towards all the replicas
+        4. Compare the users on all the replicas
+    :expectedresults:
+        1. Success
+        2. Success
+        3. Success
+        4. The users and their values are identical everywhere
+    """
+    supplier1 = topo.ms['supplier1']
+    replicas = [topo.ms['supplier2'], topo.cs['consumer1'], topo.cs['consumer2']]
+    repl = ReplicationManager(DEFAULT_SUFFIX)
+
+    # Step 1
+    users = UserAccounts(supplier1, DEFAULT_SUFFIX)
+    created = []
+    for i in range(USER_COUNT):
+        name = 'shared_%d' % i
+        created.append(users.create(properties={
+            'uid': name,
+            'sn': name,
+            'cn': name,
+            'uidNumber': str(5000 + i),
+            'gidNumber': '5000',
+            'homeDirectory': '/home/%s' % name,
+            'description': ['first %d' % i, 'second %d' % i],
+        }))
+
+    # Step 2
+    for i, user in enumerate(created):
+        if i % 3 == 0:
+            user.replace('description', 'replaced %d' % i)
+        elif i % 3 == 1:
+            user.add('mail', 'shared_%d@example.com' % i)
+    created[1].rename('uid=shared_renamed')
+    created[2].delete()
+
+    # Step 3
+    for replica in replicas:
+        repl.wait_for_replication(supplier1, replica)
+
+    # Step 4
+    def _dump(inst):
+        return sorted((user.dn.lower(), sorted(user.get_attr_vals_utf8_l('description')),
+                       sorted(user.get_attr_vals_utf8_l('mail')))
+                      for user in UserAccounts(inst, DEFAULT_SUFFIX).list()
+                      if user.get_attr_val_utf8_l('uid').startswith('shared_'))
+
+    expected = _dump(supplier1)
+    assert len(expected) == USER_COUNT - 1
+    for replica in replicas:
+        assert _dump(replica) == expected
+
+
+if __name__ == '__main__':
+    # Run isolated
+    # -s for DEBUG mode
+    CURRENT_FILE = os.path.realpath(__file__)
+    pytest.main(["-s", CURRENT_FILE])
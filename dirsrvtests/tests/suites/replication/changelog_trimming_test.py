@@ -278,6 +278,68 @@ def test_cl_trim_ignore_empty_ruv_element(topology_m1c1):
     # is missing from the changelog
     assert not s1.ds_error_log.match('.*Can.t locate CSN}.*')
 
+def test_cl_trim_segments(topology_m1c1):
+    """Test trimming removes whole changelog segments
+
+    :id: 7c2e9a51-3f84-4d1b-9b6e-0d5a8e2f4c13
+    :setup: single supplier and single consumer
+    :steps:
+        1. Set max entries on S1 and enable replication logging
+        2. Do more updates than a changelog segment holds
+        3. Wait for the replication and the trimming
+        4. Check whole segments were removed
+        5. Restart S1 and do an update
+        6. Check the update is replicated
+
+    :expectedresults:
+        1. Success
+        2. Success
+        3. Success
+        4. The trimming logs removed segments
+        5. Success
+        6. Success
+    """
+    s1 = topology_m1c1.ms['supplier1']
+    c1 = topology_m1c1.cs['consumer1']
+    repl = ReplicationManager(DEFAULT_SUFFIX)
+
+    # Step 1
+    s1.config.loglevel((ErrorLog.REPLICA,), 'error')
+    if ds_supports_new_changelog():
+        set_value(s1, MAXENTRIES, '100')
+        set_value(s1, MAXAGE, '0')
+        set_value(s1, TRIMINTERVAL, '300')
+    else:
+        cl = Changelog5(s1)
+        cl.set_max_entries('100')
+        cl.set_max_age('0')
+        cl.set_trim_interval('300')
+    s1.deleteErrorLogs()
+
+    # Step 2
+    do_mods(s1, 25000)
+
+    # Step 3
+    repl.wait_for_replication(s1, c1, timeout=300)
+    if ds_supports_new_changelog():
+        set_value(s1, TRIMINTERVAL, '2')
+    else:
+        cl.set_trim_interval('2')
+    time.sleep(10)
+
+    # Step 4
+    assert s1.ds_error_log.match('.*removed [1-9][0-9]* segments.*')
+
+    # Step 5
+    s1.restart()
+    test_users_s1 = UserAccounts(s1, DEFAULT_SUFFIX, rdn=None)
+    test_users_s1.create_test_user(uid=3000)
+
+    # Step 6
+    repl.wait_for_replication(s1, c1, timeout=20)
+    assert not s1.ds_error_log.match('.*Can.t locate CSN.*')
+
+
 if __name__ == '__main__':
     # Run isolated
     # -s for DEBUG mode
@@ -0,0 +1,117 @@
+# --- BEGIN COPYRIGHT BLOCK ---
+# Copyright (C) 2026 Red Hat, Inc.
+# All rights reserved.
+#
+# License: GPL (version 3 or any later version).
+# See LICENSE for details.
+# --- END COPYRIGHT BLOCK ---
+#
+import logging
+import pytest
+import os
+from lib389._constants import DEFAULT_SUFFIX
+from lib389.topologies import topology_m1c1 as topo
+from lib389.replica import Replicas, ReplicationManager
+from lib389.idm.user import UserAccounts
+from lib389.idm.organizationalunit import OrganizationalUnits
+
+pytestmark = pytest.mark.tier1
+
+DEBUGGING = os.getenv("DEBUGGING", default=False)
+if DEBUGGING:
+    logging.getLogger(__name__).setLevel(logging.DEBUG)
+else:
+    logging.getLogger(__name__).setLevel(logging.INFO)
+log = logging.getLogger(__name__)
+
+USER_COUNT = 100
+
+
+def test_parallel_apply(topo, request):
+    """Check that a consumer applying the updates in parallel converges
+
+    :id: 6c2e9f4a-1b73-4d58-b0a6-e3f7d92c5814
+    :setup: One supplier and one consumer
+    :steps:
+        1. Set nsds5ReplicaApplyThreads to 4 on the consumer
+        2. Add an OU and users below it on the supplier
+        3. Modify, rename and delete users, then delete the OU subtree
+        4. Wait for the replication
+        5. Compare the users on both servers
+        6. Check the apply monitor attributes of the consumer replica
+    :expectedresults:
+        1. Success
+        2. Success
+        3. Success
+        4. Success
+        5. The users and their values are identical
+        6. nsds5replicaApplyOps is set and the lag is reported
+    """
+    supplier = topo.ms['supplier1']
+    consumer = topo.cs['consumer1']
+    repl = ReplicationManager(DEFAULT_SUFFIX)
+    consumer_replica = Replicas(consumer).get(DEFAULT_SUFFIX)
+
+    # Step 1
+    consumer_replica.replace('nsds5ReplicaApplyThreads', '4')
+
+    # Step 2
+    ou = OrganizationalUnits(supplier, DEFAULT_SUFFIX).create(properties={'ou': 'parallel'})
+    users = UserAccounts(supplier, DEFAULT_SUFFIX, rdn='ou=parallel')
+    created = []
+    for i in range(USER_COUNT):
+        name = 'parallel_%d' % i
+        created.append(users.create(properties={
+            'uid': name,
+            'sn': name,
+            'cn': name,
+            'uidNumber': str(7000 + i),
+            'gidNumber': '7000',
+            'homeDirectory': '/home/%s' % name,
+        }))
+
+    # Step 3
+    for i, user in enumerate(created):
+        user.replace('description', 'first %d' % i)
+        user.replace('description', 'second %d' % i)
+        if i % 10 == 0:
+            user.rename('uid=parallel_renamed_%d' % i)
+        elif i % 10 == 1:
+            user.delete()
+
+    # Step 4
+    repl.wait_for_replication(supplier, consumer)
+
+    # Step 5
+    def _dump(inst):
+        return sorted((user.dn.lower(), user.get_attr_val_utf8_l('description'))
+                      for user in UserAccounts(inst, DEFAULT_SUFFIX, rdn='ou=parallel').list())
+
+    expected = _dump(supplier)
+    assert len(expected) == USER_COUNT - USER_COUNT // 10
+    assert _dump(consumer) == expected
+
+    # Step 6
+    monitor = consumer_replica.get_attrs_vals_utf8(['nsds5replicaApplyOps',
+                                                    'nsds5replicaApplyParallelOps',
+                                                    'nsds5replicaApplyMaxInFlight',
+                                                    'nsds5replicaApplyLag'])
+    log.info('consumer apply monitor: %s', monitor)
+    assert int(monitor['nsds5replicaApplyOps'][0]) > 0
+    assert int(monitor['nsds5replicaApplyMaxInFlight'][0]) <= 4
+    assert 'nsds5replicaApplyLag' in monitor
+
+    def fin():
+        for user in users.list():
+            user.delete()
+        ou.delete()
+        consumer_replica.remove_all('nsds5ReplicaApplyThreads')
+
+    request.addfinalizer(fin)
+
+
+if __name__ == '__main__':
+    # Run isolated
+    # -s for DEBUG mode
+    CURRENT_FILE = os.path.realpath(__file__)
+    pytest.main(["-s", CURRENT_FILE])
@@ -0,0 +1,257 @@
+# --- BEGIN COPYRIGHT BLOCK ---
+# Copyright (C) 2026 Red Hat, Inc.
+# All rights reserved.
+#
+# License: GPL (version 3 or any later version).
+# See LICENSE for details.
+# --- END COPYRIGHT BLOCK ---
+#
+import logging
+import time
+import ldap
+import pytest
+import os
+from lib389._constants import DEFAULT_SUFFIX, DEFAULT_BENAME
+from lib389.utils import get_default_db_lib
+from lib389.topologies import topology_m1c1 as topo
+from lib389.agreement import Agreements
+from lib389.backend import Backends, DatabaseConfig
+from lib389.replica import ReplicationManager
+from lib389.idm.user import UserAccounts
+
+pytestmark = pytest.mark.tier1
+
+DEBUGGING = os.getenv("DEBUGGING", default=False)
+if DEBUGGING:
+    logging.getLogger(__name__).setLevel(logging.DEBUG)
+else:
+    logging.getLogger(__name__).setLevel(logging.INFO)
+log = logging.getLogger(__name__)
+
+USER_COUNT = 200
+
+
+@pytest.mark.skipif(get_default_db_lib() != "mdb", reason="Snapshot initialization requires mdb")
+def test_snapshot_init(topo, request):
+    """Check that a consumer initialized from a snapshot is usable
+
+    :id: 0e7b5c29-8a41-4f6d-b3e2-91c6d4a8f517
+    :setup: One supplier and one consumer
+    :steps:
+        1. Add users on the supplier
+        2. Set nsds5ReplicaInitMode to snapshot and initialize the consumer
+        3. Compare the users on both servers
+        4. Search the consumer with an indexed filter
+        5. Modify a user on the supplier
+        6. Check the replication towards the consumer
+    :expectedresults:
+        1. Success
+        2. The total update succeeds
+        3. The users are identical
+        4. The user is found
+        5. Success
+        6. The modification is replicated
+    """
+    supplier = topo.ms['supplier1']
+    consumer = topo.cs['consumer1']
+    repl = ReplicationManager(DEFAULT_SUFFIX)
+
+    # Step 1
+    users = UserAccounts(supplier, DEFAULT_SUFFIX)
+    for i in range(USER_COUNT):
+        name = 'snapinit_%d' % i
+        users.create(properties={
+            'uid': name,
+            'sn': name,
+            'cn': name,
+            'uidNumber': str(8000 + i),
+            'gidNumber': '8000',
+            'homeDirectory': '/home/%s' % name,
+        })
+
+    # Step 2
+    agmt = Agreements(supplier).list()[0]
+    agmt.replace('nsds5ReplicaInitMode', 'snapshot')
+    agmt.begin_reinit()
+    (done, error) = agmt.wait_reinit()
+    assert done is True
+    assert error is False
+
+    # Step 3
+    def _dump(inst):
+        return sorted(user.dn.lower() for user in UserAccounts(inst, DEFAULT_SUFFIX).list()
+                      if user.get_attr_val_utf8_l('uid').startswith('snapinit_'))
+
+    assert _dump(consumer) == _dump(supplier)
+    assert len(_dump(consumer)) == USER_COUNT
+
+    # Step 4
+    assert UserAccounts(consumer, DEFAULT_SUFFIX).get('snapinit_42')
+
+    # Step 5
+    users.get('snapinit_42').replace('description', 'after snapshot')
+
+    # Step 6
+    repl.wait_for_replication(supplier, consumer)
+    assert UserAccounts(consumer, DEFAULT_SUFFIX).get('snapinit_42').get_attr_val_utf8('description') == 'after snapshot'
+
+    def fin():
+        agmt.remove_all('nsds5ReplicaInitMode')
+
+    request.addfinalizer(fin)
+
+
+@pytest.mark.skipif(get_default_db_lib() != "mdb", reason="Snapshot initialization requires mdb")
+def test_snapshot_init_missing_index(topo, request):
+    """Check that an index configured only on the consumer is rebuilt after a snapshot
+
+    :id: 5d2e8f41-7b36-4c0a-9e15-a3f6c8b2d749
+    :setup: One supplier and one consumer
+    :steps:
+        1. Add users with an employeeNumber on the supplier
+        2. Index employeeNumber on the consumer only
+        3. Initialize the consumer with a snapshot
+        4. Wait for the reindex task started by the snapshot installation
+        5. Search the consumer with an employeeNumber filter
+    :expectedresults:
+        1. Success
+        2. Success
+        3. The total update succeeds
+        4. The task rebuilds employeeNumber and succeeds
+        5. The user is found
+    """
+    supplier = topo.ms['supplier1']
+    consumer = topo.cs['consumer1']
+    be = Backends(consumer).get(DEFAULT_BENAME)
+    agmt = Agreements(supplier).list()[0]
+
+    # Step 1
+    users = UserAccounts(supplier, DEFAULT_SUFFIX)
+    for i in range(10):
+        name = 'snapidx_%d' % i
+        users.create(properties={
+            'uid': name,
+            'sn': name,
+            'cn': name,
+            'uidNumber': str(9000 + i),
+            'gidNumber': '9000',
+            'homeDirectory': '/home/%s' % name,
+            'employeeNumber': str(9000 + i),
+        })
+
+    # Step 2
+    be.add_index('employeeNumber', ['eq'])
+
+    def fin():
+        agmt.remove_all('nsds5ReplicaInitMode')
+        be.del_index('employeeNumber')
+
+    request.addfinalizer(fin)
+
+    # Step 3
+    agmt.replace('nsds5ReplicaInitMode', 'snapshot')
+    agmt.begin_reinit()
+    (done, error) = agmt.wait_reinit()
+    assert done is True
+    assert error is False
+
+    # Step 4
+    tasks = []
+    for _ in range(30):
+        tasks = consumer.search_s('cn=index,cn=tasks,cn=config', ldap.SCOPE_ONELEVEL,
+                                  '(&(cn=snapshot_*)(nsTaskExitCode=*))',
+                                  ['nsIndexAttribute', 'nsTaskExitCode'])
+        if tasks:
+            break
+        time.sleep(1)
+    assert tasks
+    attrs = tasks[0][1]
+    assert b'employeeNumber' in attrs['nsIndexAttribute']
+    assert attrs['nsTaskExitCode'] == [b'0']
+
+    # Step 5
+    assert len(consumer.search_s(DEFAULT_SUFFIX, ldap.SCOPE_SUBTREE, '(employeeNumber=9004)', ['uid'])) == 1
+
+
+@pytest.mark.skipif(get_default_db_lib() != "mdb", reason="Snapshot initialization requires mdb")
+def test_snapshot_init_failure(topo, request):
+    """Check that a consumer that can not store the snapshot is reported as failed
+
+    :id: 3a91c7e5-0d48-4b6f-8e27-c5b1f9d34a60
+    :setup: One supplier and one consumer
+    :steps:
+        1. Limit the database size of the consumer to its current size plus 8MB
+        2. Add 40MB of entries on the supplier
+        3. Initialize the consumer with a snapshot
+        4. Check the consumer reports that it must be reinitialized
+        5. Remove the entries, restore the consumer database size and
+           initialize the consumer again
+    :expectedresults:
+        1. Success
+        2. Success
+        3. The total update fails
+        4. Success
+        5. The total update succeeds and the consumer is in sync
+    """
+    supplier = topo.ms['supplier1']
+    consumer = topo.cs['consumer1']
+    repl = ReplicationManager(DEFAULT_SUFFIX)
+    agmt = Agreements(supplier).list()[0]
+    db_cfg = DatabaseConfig(consumer)
+    max_size = db_cfg.get()['nsslapd-mdb-max-size'][0]
+    users = UserAccounts(supplier, DEFAULT_SUFFIX)
+    big_users = []
+
+    def fin():
+        for user in big_users:
+            user.delete()
+        if db_cfg.get()['nsslapd-mdb-max-size'][0] != max_size:
+            db_cfg.set([('nsslapd-mdb-max-size', max_size)])
+            consumer.restart()
+        agmt.remove_all('nsds5ReplicaInitMode')
+
+    request.addfinalizer(fin)
+
+    # Step 1
+    db_file = os.path.join(consumer.ds_paths.db_dir, 'data.mdb')
+    db_cfg.set([('nsslapd-mdb-max-size', str(os.path.getsize(db_file) + 8 * 1024 * 1024))])
+    consumer.restart()
+
+    # Step 2
+    for i in range(80):
+        name = 'snapbig_%d' % i
+        big_users.append(users.create(properties={
+            'uid': name,
+            'sn': name,
+            'cn': name,
+            'uidNumber': str(10000 + i),
+            'gidNumber': '10000',
+            'homeDirectory': '/home/%s' % name,
+            'description': 'x' * (512 * 1024),
+        }))
+
+    # Step 3
+    agmt.replace('nsds5ReplicaInitMode', 'snapshot')
+    agmt.begin_reinit()
+    (done, error) = agmt.wait_reinit()
+    assert error is True
+
+    # Step 4
+    assert consumer.ds_error_log.match('.*must be reinitialized.*')
+
+    # Step 5
+    while big_users:
+        big_users.pop().delete()
+    db_cfg.set([('nsslapd-mdb-max-size', max_size)])
+    consumer.restart()
+    agmt.begin_reinit()
+    (done, error) = agmt.wait_reinit()
+    assert done is True
+    assert error is False
+    repl.wait_for_replication(supplier, consumer)
+
+if __name__ == '__main__':
+    # Run isolated
+    # -s for DEBUG mode
+    CURRENT_FILE = os.path.realpath(__file__)
+    pytest.main(["-s", CURRENT_FILE])
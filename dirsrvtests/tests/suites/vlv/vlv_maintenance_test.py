@@ -0,0 +1,155 @@
+# --- BEGIN COPYRIGHT BLOCK ---
+# Copyright (C) 2026 Red Hat, Inc.
+# All rights reserved.
+#
+# License: GPL (version 3 or any later version).
+# See LICENSE for details.
+# --- END COPYRIGHT BLOCK ---
+#
+import os
+import logging
+import ldap
+import pytest
+from ldap.controls.vlv import VLVRequestControl
+from ldap.controls.sss import SSSRequestControl
+from lib389._constants import DEFAULT_SUFFIX
+from lib389.properties import TASK_WAIT
+from lib389.topologies import topology_st as topo
+from lib389.backend import DatabaseConfig
+from lib389.index import VLVSearch, VLVIndex
+from lib389.tasks import Tasks
+from lib389.idm.user import UserAccounts
+from lib389.idm.organizationalunit import OrganizationalUnits
+
+pytestmark = pytest.mark.tier1
+
+log = logging.getLogger(__name__)
+
+USER_COUNT = 150
+OU_DN = 'ou=vlvmaint,' + DEFAULT_SUFFIX
+VLV_FILTER = '(&(uid=maint_*)(!(employeeType=hidden)))'
+BE_DN = 'cn=userRoot,cn=ldbm database,cn=plugins,cn=config'
+
+
+@pytest.fixture(scope="module")
+def vlv_users(topo, request):
+    inst = topo.standalone
+    ous = OrganizationalUnits(inst, DEFAULT_SUFFIX)
+    ou = ous.create(properties={'ou': 'vlvmaint'})
+    users = UserAccounts(inst, DEFAULT_SUFFIX, rdn='ou=vlvmaint')
+    for i in range(USER_COUNT):
+        name = 'maint_%03d' % i
+        users.create(properties={
+            'uid': name,
+            'sn': name,
+            'cn': name,
+            'uidNumber': str(1000 + i),
+            'gidNumber': '1000',
+            'homeDirectory': '/home/%s' % name,
+        })
+
+    vlv_search = VLVSearch(inst).create(basedn=BE_DN, properties={
+        'objectclass': ['top', 'vlvSearch'],
+        'cn': 'maintSrch',
+        'vlvbase': OU_DN,
+        'vlvfilter': VLV_FILTER,
+        'vlvscope': str(ldap.SCOPE_ONELEVEL),
+    })
+    vlv_index = VLVIndex(inst).create(basedn=vlv_search.dn, properties={
+        'objectclass': ['top', 'vlvIndex'],
+        'cn': 'maintIdx',
+        'vlvsort': 'sn',
+    })
+
+    def fin():
+        vlv_index.delete()
+        vlv_search.delete()
+        for user in users.list():
+            user.delete()
+        ou.delete()
+
+    request.addfinalizer(fin)
+    return users, vlv_index
+
+
+def _vlv_uids(inst):
+    vlv_control = VLVRequestControl(criticality=True, before_count=0,
+                                    after_count=USER_COUNT, offset=1,
+                                    content_count=0, greater_than_or_equal=None,
+                                    context_id=None)
+    sss_control = SSSRequestControl(criticality=True, ordering_rules=['sn'])
+    result = inst.search_ext_s(OU_DN, ldap.SCOPE_ONELEVEL, VLV_FILTER, ['uid'],
+                               serverctrls=[vlv_control, sss_control])
+    return [attrs['uid'][0].decode() for dn, attrs in result]
+
+
+def test_vlv_rebuild_and_modify(topo, vlv_users, request):
+    """Check the vlv index rebuilt in parallel and maintained on modify
+
+    :id: 2b6d9e41-7c8a-4f35-9e10-d4a3c5b7f862
+    :setup: Standalone instance with 150 users and a vlv index sorted on sn
+    :steps:
+        1. Set nsslapd-vlv-rebuild-threads to 4 and reindex the vlv index
+        2. Browse the index
+        3. Modify an attribute that is not used by the index
+        4. Browse the index
+        5. Modify the sort attribute of the first user
+        6. Browse the index
+        7. Modify the filter attribute of the last user
+        8. Browse the index
+    :expectedresults:
+        1. Success
+        2. All the users are returned, sorted by sn
+        3. Success
+        4. The same users are returned, in the same order
+        5. Success
+        6. The first user is now the last one
+        7. Success
+        8. The user is not returned anymore
+    """
+    inst = topo.standalone
+    users, vlv_index = vlv_users
+    db_cfg = DatabaseConfig(inst)
+
+    # Step 1
+    db_cfg.set([('nsslapd-vlv-rebuild-threads', '4')])
+    assert Tasks(inst).reindex(suffix=DEFAULT_SUFFIX, attrname=vlv_index.rdn,
+                               args={TASK_WAIT: True}, vlv=True) == 0
+
+    # Step 2
+    expected = ['maint_%03d' % i for i in range(USER_COUNT)]
+    assert _vlv_uids(inst) == expected
+
+    # Step 3
+    first = users.get('maint_000')
+    first.replace('description', 'not indexed')
+
+    # Step 4
+    assert _vlv_uids(inst) == expected
+
+    # Step 5
+    first.replace('sn', 'zzz_maint_000')
+
+    # Step 6
+    expected = expected[1:] + ['maint_000']
+    assert _vlv_uids(inst) == expected
+
+    # Step 7
+    last = users.get('maint_%03d' % (USER_COUNT - 1))
+    last.replace('employeeType', 'hidden')
+
+    # Step 8
+    expected.remove('maint_%03d' % (USER_COUNT - 1))
+    assert _vlv_uids(inst) == expected
+
+    def fin():
+        db_cfg.set([('nsslapd-vlv-rebuild-threads', '0')])
+
+    request.addfinalizer(fin)
+
+
+if __name__ == '__main__':
+    # Run isolated
+    # -s for DEBUG mode
+    CURRENT_FILE = os.path.realpath(__file__)
+    pytest.main(["-s", CURRENT_FILE])
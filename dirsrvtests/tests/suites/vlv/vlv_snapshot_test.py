@@ -0,0 +1,215 @@
+# --- BEGIN COPYRIGHT BLOCK ---
+# Copyright (C) 2026 Red Hat, Inc.
+# All rights reserved.
+#
+# License: GPL (version 3 or any later version).
+# See LICENSE for details.
+# --- END COPYRIGHT BLOCK ---
+#
+import os
+import logging
+import ldap
+import pytest
+from ldap.controls.vlv import VLVRequestControl
+from ldap.controls.sss import SSSRequestControl
+from lib389._constants import DEFAULT_SUFFIX
+from lib389.topologies import topology_st as topo
+from lib389.backend import Backend, DatabaseConfig
+from lib389.idm.domain import Domain
+from lib389.monitor import MonitorLDBM
+from lib389.idm.user import UserAccounts
+from lib389.idm.organizationalunit import OrganizationalUnit, OrganizationalUnits
+
+pytestmark = pytest.mark.tier1
+
+log = logging.getLogger(__name__)
+
+USER_COUNT = 200
+PAGE_SIZE = 20
+OU_DN = 'ou=snapshot,' + DEFAULT_SUFFIX
+OTHER_SUFFIX = 'dc=snapshot'
+VIEWER_PW = 'password'
+
+
+@pytest.fixture(scope="module")
+def users(topo, request):
+    inst = topo.standalone
+    ous = OrganizationalUnits(inst, DEFAULT_SUFFIX)
+    ou = ous.create(properties={'ou': 'snapshot'})
+    users = UserAccounts(inst, DEFAULT_SUFFIX, rdn='ou=snapshot')
+    for i in range(USER_COUNT):
+        name = 'snap_%03d' % i
+        users.create(properties={
+            'uid': name,
+            'sn': name,
+            'cn': name,
+            'uidNumber': str(1000 + i),
+            'gidNumber': '1000',
+            'homeDirectory': '/home/%s' % name,
+        })
+
+    def fin():
+        for user in users.list():
+            user.delete()
+        ou.delete()
+
+    request.addfinalizer(fin)
+    return users
+
+
+def _vlv_page(inst, offset):
+    vlv_control = VLVRequestControl(criticality=True, before_count=0,
+                                    after_count=PAGE_SIZE - 1, offset=offset,
+                                    content_count=0, greater_than_or_equal=None,
+                                    context_id=None)
+    sss_control = SSSRequestControl(criticality=True, ordering_rules=['cn'])
+    result = inst.search_ext_s(OU_DN, ldap.SCOPE_ONELEVEL, '(uid=snap_*)', ['uid'],
+                               serverctrls=[vlv_control, sss_control])
+    return [dn for dn, attrs in result]
+
+
+def _browse(inst):
+    dns = []
+    for offset in range(1, USER_COUNT + 1, PAGE_SIZE):
+        dns.extend(_vlv_page(inst, offset))
+    return dns
+
+
+def _snapshot_hits(inst):
+    return int(MonitorLDBM(inst).get_attr_val_utf8('searchSnapshotHits'))
+
+
+def test_vlv_snapshot(topo, users, request):
+    """Check that VLV pages are served from the sorted search snapshots
+
+    :id: 4f8a2c6e-9d13-4b7a-a0e5-6c2b8d1f3e94
+    :setup: Standalone instance with 200 users
+    :steps:
+        1. Browse the users with VLV without snapshot cache
+        2. Set nsslapd-search-snapshot-cachesize
+        3. Browse the users with VLV again
+        4. Check the snapshots were used
+        5. Write to another backend and browse the users again
+        6. Add a user and read the last page
+    :expectedresults:
+        1. Success
+        2. Success
+        3. The same entries are returned, in the same order
+        4. searchSnapshotHits increased by the number of pages but one
+        5. The snapshot is kept, searchSnapshotHits increased by the number
+           of pages
+        6. The new user is returned, the snapshot is invalidated by the write
+    """
+    inst = topo.standalone
+    db_cfg = DatabaseConfig(inst)
+    other_be = Backend(inst)
+    other_be.create(properties={'cn': 'snapshotRoot', 'nsslapd-suffix': OTHER_SUFFIX})
+    other_be.create_sample_entries('001004002')
+
+    def fin():
+        db_cfg.set([('nsslapd-search-snapshot-cachesize', '0')])
+        other_be.delete()
+
+    request.addfinalizer(fin)
+
+    # Step 1
+    db_cfg.set([('nsslapd-search-snapshot-cachesize', '0')])
+    expected = _browse(inst)
+    assert len(expected) == USER_COUNT
+
+    # Step 2
+    db_cfg.set([('nsslapd-search-snapshot-cachesize', '1048576')])
+
+    # Step 3
+    hits = _snapshot_hits(inst)
+    assert _browse(inst) == expected
+
+    # Step 4
+    npages = USER_COUNT // PAGE_SIZE
+    log.info('searchSnapshotHits %d -> %d', hits, _snapshot_hits(inst))
+    assert _snapshot_hits(inst) - hits == npages - 1
+
+    # Step 5
+    Domain(inst, OTHER_SUFFIX).replace('description', 'snapshot')
+    hits = _snapshot_hits(inst)
+    assert _browse(inst) == expected
+    assert _snapshot_hits(inst) - hits == npages
+
+    # Step 6
+    users.create(properties={
+        'uid': 'snap_999',
+        'sn': 'snap_999',
+        'cn': 'snap_999',
+        'uidNumber': '9999',
+        'gidNumber': '1000',
+        'homeDirectory': '/home/snap_999',
+    })
+    last_page = _vlv_page(inst, USER_COUNT + 1)
+    assert len(last_page) == 1
+    assert last_page[0].lower().startswith('uid=snap_999,')
+
+
+def test_vlv_snapshot_access_control(topo, users, request):
+    """Check that a snapshot is not shared by identities with different rights
+
+    :id: 9e1b7d3c-52a4-4f08-b6c9-3a7e0d5f1b28
+    :setup: Standalone instance with 200 users
+    :steps:
+        1. Add two viewers, both allowed to read the users, the second one
+           denied the users snap_0*
+        2. Browse the users with VLV as each viewer without snapshot cache
+        3. Set nsslapd-search-snapshot-cachesize
+        4. Browse the users with VLV as the first viewer, then as the second
+    :expectedresults:
+        1. Success
+        2. The second viewer does not see the users snap_0*
+        3. Success
+        4. Each viewer gets the entries of step 2
+    """
+    inst = topo.standalone
+    db_cfg = DatabaseConfig(inst)
+    ou = OrganizationalUnit(inst, OU_DN)
+    viewers = UserAccounts(inst, DEFAULT_SUFFIX)
+
+    # Step 1
+    viewer_a = viewers.create_test_user(uid=5001)
+    viewer_b = viewers.create_test_user(uid=5002)
+    for viewer in (viewer_a, viewer_b):
+        viewer.replace('userPassword', VIEWER_PW)
+    acis = [
+        '(targetattr="uid || cn")(version 3.0; acl "snapshot viewers"; allow (read, search, compare) '
+        '(userdn="ldap:///%s || ldap:///%s");)' % (viewer_a.dn, viewer_b.dn),
+        '(targetattr="*")(targetfilter="(uid=snap_0*)")(version 3.0; acl "snapshot viewer b"; deny (all) '
+        '(userdn="ldap:///%s");)' % viewer_b.dn,
+    ]
+    ou.add('aci', acis)
+
+    def fin():
+        db_cfg.set([('nsslapd-search-snapshot-cachesize', '0')])
+        ou.remove('aci', acis[0])
+        ou.remove('aci', acis[1])
+        viewer_a.delete()
+        viewer_b.delete()
+
+    request.addfinalizer(fin)
+
+    # Step 2
+    db_cfg.set([('nsslapd-search-snapshot-cachesize', '0')])
+    expected_a = _browse(viewer_a.bind(VIEWER_PW))
+    expected_b = _browse(viewer_b.bind(VIEWER_PW))
+    assert len(expected_a) == USER_COUNT
+    assert not [dn for dn in expected_b if dn.lower().startswith('uid=snap_0')]
+
+    # Step 3
+    db_cfg.set([('nsslapd-search-snapshot-cachesize', '1048576')])
+
+    # Step 4
+    assert _browse(viewer_a.bind(VIEWER_PW)) == expected_a
+    assert _browse(viewer_b.bind(VIEWER_PW)) == expected_b
+
+
+if __name__ == '__main__':
+    # Run isolated
+    # -s for DEBUG mode
+    CURRENT_FILE = os.path.realpath(__file__)
+    pytest.main(["-s", CURRENT_FILE])
@@ -213,6 +213,8 @@ acllist_insert_aci_needsLock_ext(Slapi_PBlock *pb, const Slapi_DN *e_sdn, const
     }
 
     slapi_ch_free((void **)&acl_str);
+    if (aci->aci_ruleType & (ACI_TIMEOFDAY_RULE | ACI_DAYOFWEEK_RULE))
+        plugin_acl_time_rule_add();
     acl_regen_aclsignature();
     if (aci->aci_elevel == ACI_ELEVEL_USERDN_ANYONE)
         aclanom_invalidateProfile();
@@ -372,6 +374,8 @@ acllist_remove_aci_needsLock(const Slapi_DN *sdn, const struct berval *attr)
     while (head) {
         if (head->aci_elevel == ACI_ELEVEL_USERDN_ANYONE)
             removed_anom_acl = 1;
+        if (head->aci_ruleType & (ACI_TIMEOFDAY_RULE | ACI_DAYOFWEEK_RULE))
+            plugin_acl_time_rule_remove();
 
         /* Free the acl */
         acllist_free_aci(head);
@@ -481,6 +485,8 @@ free_aci_avl_container(caddr_t d)
     while (head) {
         /* Free the acl */
         next = head->aci_next;
+        if (head->aci_ruleType & (ACI_TIMEOFDAY_RULE | ACI_DAYOFWEEK_RULE))
+            plugin_acl_time_rule_remove();
         acllist_free_aci(head);
         head = next;
     }
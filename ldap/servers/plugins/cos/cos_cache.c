@@ -235,6 +235,7 @@ static int cos_cache_build_definition_list(cosDefinitions **pDefs, int *vattr_ca
 static int cos_cache_add_dn_defs(char *dn, cosDefinitions **pDefs);
 static int cos_cache_add_defn(cosDefinitions **pDefs, cosAttrValue **dn, int cosType, cosAttrValue **tree, cosAttrValue **tmpDn, cosAttrValue **spec, cosAttrValue **pAttrs, cosAttrValue **pOverrides, cosAttrValue **pOperational, cosAttrValue **pCosMerge, cosAttrValue **pCosOpDefault);
 static int cos_cache_entry_is_cos_related(Slapi_Entry *e);
+static void cos_cache_vattrcache_invalidate(cosCache *pOldCache, cosCache *pNewCache);
 
 /* schema checking */
 static int cos_cache_schema_check(cosCache *pCache, int cache_attr_index, Slapi_Attr *pObjclasses);
@@ -480,8 +481,9 @@ cos_cache_create_unlock(void)
                          * like roles if there is no change in
                          * state
                          */
-                        if (pCache->vattr_cacheable)
-                            slapi_entrycache_vattrcache_watermark_invalidate();
+                        if (pCache->vattr_cacheable) {
+                            cos_cache_vattrcache_invalidate(pCache, pNewCache);
+                        }
                     } else {
                         if (pNewCache && pNewCache->vattr_cacheable) {
                             slapi_vattrcache_cache_all();
@@ -535,7 +537,7 @@ cos_cache_create_unlock(void)
          * state
          */
         if (pCache && pCache->vattr_cacheable)
-            slapi_entrycache_vattrcache_watermark_invalidate();
+            cos_cache_vattrcache_invalidate(pCache, NULL);
 
         pOldCache = pCache;
         pCache = NULL;
@@ -595,6 +597,159 @@ cos_cache_creation_lock(void)
     return ret;
 }
 
+/*
+    cos_cache_*_equal
+    -----------------
+    compare two definitions, with their templates, of an old and
+    a new cache. Any difference, including the order of the values,
+    counts as a change.
+*/
+static int
+cos_cache_string_equal(const char *s1, const char *s2)
+{
+    if (s1 == NULL || s2 == NULL) {
+        return s1 == s2;
+    }
+    return strcmp(s1, s2) == 0;
+}
+
+static int
+cos_cache_attrval_equal(cosAttrValue *pVal1, cosAttrValue *pVal2)
+{
+    while (pVal1 && pVal2) {
+        if (!cos_cache_string_equal(pVal1->val, pVal2->val)) {
+            return 0;
+        }
+        pVal1 = pVal1->list.pNext;
+        pVal2 = pVal2->list.pNext;
+    }
+    return pVal1 == pVal2;
+}
+
+static int
+cos_cache_template_equal(cosTemplates *pTmp1, cosTemplates *pTmp2)
+{
+    cosAttributes *pAttr1 = pTmp1->pAttrs;
+    cosAttributes *pAttr2 = pTmp2->pAttrs;
+
+    if (!cos_cache_attrval_equal(pTmp1->pDn, pTmp2->pDn) ||
+        !cos_cache_attrval_equal(pTmp1->pObjectclasses, pTmp2->pObjectclasses) ||
+        !cos_cache_string_equal(pTmp1->cosGrade, pTmp2->cosGrade) ||
+        pTmp1->template_default != pTmp2->template_default ||
+        pTmp1->cosPriority != pTmp2->cosPriority) {
+        return 0;
+    }
+    while (pAttr1 && pAttr2) {
+        if (!cos_cache_string_equal(pAttr1->pAttrName, pAttr2->pAttrName) ||
+            !cos_cache_attrval_equal(pAttr1->pAttrValue, pAttr2->pAttrValue) ||
+            !cos_cache_attrval_equal(pAttr1->pObjectclasses, pAttr2->pObjectclasses) ||
+            pAttr1->attr_override != pAttr2->attr_override ||
+            pAttr1->attr_operational != pAttr2->attr_operational ||
+            pAttr1->attr_operational_default != pAttr2->attr_operational_default ||
+            pAttr1->attr_cos_merge != pAttr2->attr_cos_merge) {
+            return 0;
+        }
+        pAttr1 = pAttr1->list.pNext;
+        pAttr2 = pAttr2->list.pNext;
+    }
+    return pAttr1 == pAttr2;
+}
+
+static int
+cos_cache_definition_equal(cosDefinitions *pDef1, cosDefinitions *pDef2)
+{
+    cosTemplates *pTmp1 = pDef1->pCosTmps;
+    cosTemplates *pTmp2 = pDef2->pCosTmps;
+
+    if (pDef1->cosType != pDef2->cosType ||
+        !cos_cache_attrval_equal(pDef1->pDn, pDef2->pDn) ||
+        !cos_cache_attrval_equal(pDef1->pCosTargetTree, pDef2->pCosTargetTree) ||
+        !cos_cache_attrval_equal(pDef1->pCosTemplateDn, pDef2->pCosTemplateDn) ||
+        !cos_cache_attrval_equal(pDef1->pCosSpecifier, pDef2->pCosSpecifier) ||
+        !cos_cache_attrval_equal(pDef1->pCosAttrs, pDef2->pCosAttrs) ||
+        !cos_cache_attrval_equal(pDef1->pCosOverrides, pDef2->pCosOverrides) ||
+        !cos_cache_attrval_equal(pDef1->pCosOperational, pDef2->pCosOperational) ||
+        !cos_cache_attrval_equal(pDef1->pCosOpDefault, pDef2->pCosOpDefault) ||
+        !cos_cache_attrval_equal(pDef1->pCosMerge, pDef2->pCosMerge)) {
+        return 0;
+    }
+    while (pTmp1 && pTmp2) {
+        if (!cos_cache_template_equal(pTmp1, pTmp2)) {
+            return 0;
+        }
+        pTmp1 = pTmp1->list.pNext;
+        pTmp2 = pTmp2->list.pNext;
+    }
+    return pTmp1 == pTmp2;
+}
+
+/* returns 1 if the cache holds the same definition */
+static int
+cos_cache_has_definition(cosCache *pCache, cosDefinitions *pDef)
+{
+    cosDefinitions *pCacheDef;
+
+    for (pCacheDef = pCache ? pCache->pDefs : NULL; pCacheDef; pCacheDef = pCacheDef->list.pNext) {
+        if (cos_cache_definition_equal(pCacheDef, pDef)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+    cos_cache_vattrcache_invalidate
+    -------------------------------
+    invalidates the virtual attributes cached in the entries
+    the definitions that differ between the old and the new cache
+    apply to: only their target trees, in a single invalidation
+    whatever their number. The other types are invalidated too, a
+    role may depend on a cos attribute.
+*/
+static void
+cos_cache_vattrcache_invalidate(cosCache *pOldCache, cosCache *pNewCache)
+{
+    cosCache *caches[2] = {pOldCache, pNewCache};
+    Slapi_DN **scopes = NULL;
+    size_t count = 0;
+    size_t size = 0;
+    int all = 0;
+
+    for (size_t i = 0; i < 2 && !all; i++) {
+        cosDefinitions *pDef = caches[i] ? caches[i]->pDefs : NULL;
+
+        for (; pDef && !all; pDef = pDef->list.pNext) {
+            cosAttrValue *pTargetTree = pDef->pCosTargetTree;
+
+            if (cos_cache_has_definition(caches[1 - i], pDef)) {
+                /* unchanged, its cached values are still valid */
+                continue;
+            }
+            if (pTargetTree == NULL) {
+                all = 1;
+            }
+            for (; pTargetTree; pTargetTree = pTargetTree->list.pNext) {
+                if (count + 1 >= size) {
+                    size = size ? 2 * size : 8;
+                    scopes = (Slapi_DN **)slapi_ch_realloc((char *)scopes, size * sizeof(Slapi_DN *));
+                }
+                scopes[count++] = slapi_sdn_new_dn_byref(pTargetTree->val);
+            }
+        }
+    }
+
+    if (all) {
+        slapi_entrycache_vattrcache_watermark_invalidate();
+    } else if (count) {
+        scopes[count] = NULL;
+        slapi_entrycache_vattrcache_invalidate_scopes(NULL, (const Slapi_DN **)scopes);
+    }
+    for (size_t i = 0; i < count; i++) {
+        slapi_sdn_free(&scopes[i]);
+    }
+    slapi_ch_free((void **)&scopes);
+}
+
 /*
     cos_cache_build_definition_list
     -------------------------------
@@ -28,6 +28,8 @@ typedef struct changelog5Config
     /* configuration of changelog encryption */
     char *encryptionAlgorithm;
     char *symmetricKey;
+    /* compression of the changelog records */
+    int compression;
 } changelog5Config;
 
 /* upgrade changelog*/
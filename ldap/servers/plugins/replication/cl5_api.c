@@ -34,6 +34,7 @@
 #include "plhash.h"
 #include "plstr.h"
 #include <pthread.h>
+#include "zlib.h"
 #include "cl5_clcache.h" /* To use the Changelog Cache */
 #include "repl5.h"       /* for agmt_get_consumer_rid() */
 
@@ -41,6 +42,11 @@
 #define VERSION_FILE "DBVERSION" /* name of the version file  */
 #define V_5 5                    /* changelog entry version */
 #define V_6 6                    /* changelog entry version that includes encrypted flag */
+#define V_7 7                    /* changelog entry version that includes flags */
+#define CL5_FLAG_ENCRYPTED 0x01  /* version 7 flag: the values are encrypted */
+#define CL5_FLAG_COMPRESSED 0x02 /* version 7 flag: the mods are compressed */
+#define CL5_COMPRESS_MIN_SIZE 256 /* mods smaller than this are stored as is */
+#define CL5_DICT_V1 1            /* id of cl5_mods_dictionary */
 #define CHUNK_SIZE 64 * 1024
 #define DBID_SIZE 64
 #define FILE_SEP "_" /* separates parts of the db file name */
@@ -58,6 +64,8 @@
                                 used to store purge RUV vector */
 #define MAX_RUV_TIME 333     /* this time is used to construct csn \
                                 used to store upper boundary RUV vector */
+#define SEGMENTS_TIME 444    /* this time is used to construct csn \
+                                used to store the segment index */
 
 #define HASH_BACKETS_COUNT 16 /* number of buckets in a hash table */
 
@@ -90,6 +98,10 @@
 #define MAX_RETRIES 10 /* Maximum number of retry in case of db retryable error */
 #define CL5_TRIM_MAX_PER_TRANSACTION 100
 #define CL5_TRIM_MAX_LOOKUP_PER_TRANSACTION 10000
+#define CL5_TRIM_SEGMENT_PER_TRANSACTION_BDB 1000
+#define CL5_TRIM_SEGMENT_PER_TRANSACTION_MDB 10000
+#define CL5_SEGMENT_MAX_CHANGES 10000 /* changes per changelog segment */
+#define CL5_SEGMENTS_VERSION 1
 
 /***** Data Definitions *****/
 
@@ -108,8 +120,37 @@ typedef struct cl5config
     int maxEntries;      /* maximum number of entries across all changelog files */
     int trimInterval;    /* trimming interval */
     char *encryptionAlgorithm; /* nsslapd-encryptionalgorithm */
+    int32_t compression; /* nsslapd-changelogcompression */
 } CL5Config;
 
+/*
+ * The changelog records are keyed by csn. The csn key space is split in
+ * segments: consecutive key ranges holding about CL5_SEGMENT_MAX_CHANGES
+ * changes. A segment starts at its first csn and ends before the first csn
+ * of the next one. For each replica id it keeps the first and the last csn
+ * written in the range, so the next change of a replica id is found without
+ * reading the changes of the other ones, and trimming removes whole segments
+ * without decoding their changes.
+ * The index is kept in memory, stored in a helper entry when the changelog is
+ * closed and rebuilt with the changelog RUVs otherwise.
+ */
+typedef struct cl5segmentrid
+{
+    ReplicaId rid;
+    CSN first; /* first change of the rid in the segment */
+    CSN last;  /* last change of the rid in the segment */
+} CL5SegmentRid;
+
+typedef struct cl5segment
+{
+    CSN first;           /* lowest csn of the segment */
+    CSN last;            /* highest csn of the segment */
+    time_t maxtime;      /* time of the most recent change */
+    PRUint32 count;      /* number of changes */
+    int nb_rids;         /* size of rids */
+    CL5SegmentRid *rids; /* sorted by rid */
+} CL5Segment;
+
 /* this structure represents one changelog file, Each changelog file contains
    changes applied to a single backend. Files are named by the database id */
 
@@ -140,6 +181,13 @@ struct cl5DBFileHandle
     CL5OpenMode dbOpenMode; /* how we open db */
     int32_t deleteFile;     /* Mark the changelog to be deleted */
     Slapi_Backend *be;      /* Backend (for dbimpl API) */
+    CL5Segment *segments;   /* per rid csn index of the changelog segments */
+    int nbSegments;         /* number of segments */
+    int maxSegments;        /* allocated size of segments */
+    pthread_mutex_t segLock; /* controls access to the segments */
+    Slapi_Counter *clRawBytes;    /* size of the mods written while compression is enabled */
+    Slapi_Counter *clStoredBytes; /* size they take in the changelog */
+    Slapi_Counter *clCompressedRecords; /* number of records with compressed mods */
 };
 
 /* structure that allows to iterate through entries to be sent to a consumer
@@ -198,6 +246,8 @@ typedef struct {
     DBLCI_EVENT_COUNT seen;           /* records seen */
     PRBool finished;                  /* Tells whether iteration should stop */
     ReplicaId rid2purge;              /* Specific to _cl5PurgeRid */
+    CSN endcsn;                       /* Specific to _cl5TrimSegments: end of the segment */
+    PRBool partial;                   /* Specific to _cl5TrimSegments: segment not fully removed */
 } DBLCI_CTX;
 
 /***** Forward Declarations *****/
@@ -213,7 +263,7 @@ static int _cl5DispatchTrimThread(Replica *replica);
 static int _cl5ExportFile(PRFileDesc *prFile, cldb_Handle *cldb);
 
 /* data storage and retrieval */
-static int _cl5Entry2DBData(const CL5Entry *entry, char **data, PRUint32 *len, void *clcrypt_handle);
+static int _cl5Entry2DBData(const CL5Entry *entry, char **data, PRUint32 *len, cldb_Handle *cldb);
 static int _cl5WriteOperation(cldb_Handle *cldb, const slapi_operation_parameters *op);
 static int _cl5WriteOperationTxn(cldb_Handle *cldb, const slapi_operation_parameters *op, void *txn);
 static const char *_cl5OperationType2Str(int type);
@@ -222,7 +272,9 @@ static void _cl5WriteString(const char *str, char **buff);
 static void _cl5ReadString(char **str, char **buff);
 static void _cl5WriteMods(LDAPMod **mods, char **buff, void *clcrypt_handle);
 static int _cl5WriteMod(LDAPMod *mod, char **buff, void *clcrypt_handle);
-static int _cl5ReadMods(LDAPMod ***mods, char **buff, void *clcrypt_handle);
+static void _cl5CompressMods(cldb_Handle *cldb, char *data, char *mods, char **buff);
+static int _cl5UncompressMods(char **buff, char **raw);
+static int _cl5ReadMods(LDAPMod ***mods, char **buff, void *clcrypt_handle, PRBool compressed);
 static int _cl5ReadMod(Slapi_Mod *mod, char **buff, void *clcrypt_handle);
 static int _cl5GetModsSize(LDAPMod **mods);
 static int _cl5GetModSize(LDAPMod *mod);
@@ -252,6 +304,15 @@ static int _cl5WriteRUV(cldb_Handle *cldb, PRBool purge);
 static int _cl5UpdateRUV (cldb_Handle *cldb, CSN *csn, PRBool newReplica, PRBool purge);
 static int _cl5GetRUV2Purge2(Replica *r, RUV **ruv);
 
+/* segment index */
+static void _cl5SegmentsAdd(cldb_Handle *cldb, const CSN *csn, time_t time);
+static void _cl5SegmentsDropFirst(cldb_Handle *cldb, const RUV *ruv);
+static void _cl5SegmentsRemoveRid(cldb_Handle *cldb, ReplicaId rid);
+static int _cl5SegmentsNextCSN(cldb_Handle *cldb, ReplicaId rid, const CSN *csn, PRBool strict, CSN *next);
+static void _cl5SegmentsFree(cldb_Handle *cldb);
+static int _cl5ReadSegments(cldb_Handle *cldb);
+static int _cl5WriteSegments(cldb_Handle *cldb);
+
 /* bakup/recovery, import/export */
 static int _cl5LDIF2Operation(char *ldifEntry, slapi_operation_parameters *op, char **replGen);
 static int _cl5Operation2LDIF(const slapi_operation_parameters *op, const char *replGen, char **ldifEntry, PRInt32 *lenLDIF);
@@ -807,6 +868,55 @@ cl5ConfigTrimming(Replica *replica, int maxEntries, const char *maxAge, int trim
     return CL5_SUCCESS;
 }
 
+/* Name:        cl5ConfigCompression
+   Description: enables or disables the compression of the changes written
+                from now on; the changes already in the changelog are kept as is.
+   Parameters:  compression - 0 to disable the compression
+   Return:      CL5_SUCCESS if successful;
+                CL5_BAD_STATE if changelog is not open
+ */
+int
+cl5ConfigCompression(Replica *replica, int compression)
+{
+    cldb_Handle *cldb = replica_get_cl_info(replica);
+
+    if (!cldb || cldb->dbState == CL5_STATE_CLOSED) {
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
+                      "cl5ConfigCompression - Changelog is not initialized\n");
+        return CL5_BAD_STATE;
+    }
+
+    slapi_atomic_store_32(&cldb->clConf.compression, compression ? 1 : 0, __ATOMIC_RELEASE);
+
+    return CL5_SUCCESS;
+}
+
+/* Name:        cl5GetCompressionStats
+   Description: adds the changelog compression statistics to a replica
+                monitor entry.
+ */
+void
+cl5GetCompressionStats(Replica *replica, Slapi_Entry *e)
+{
+    cldb_Handle *cldb = replica_get_cl_info(replica);
+    uint64_t raw;
+    uint64_t stored;
+    char ratio[32];
+
+    if (cldb == NULL || cldb->clRawBytes == NULL) {
+        return;
+    }
+    raw = slapi_counter_get_value(cldb->clRawBytes);
+    stored = slapi_counter_get_value(cldb->clStoredBytes);
+    PR_snprintf(ratio, sizeof(ratio), "%.2f", stored ? (double)raw / (double)stored : 1.0);
+
+    slapi_entry_attr_set_ulong(e, "nsds5replicaChangelogCompressedRecords",
+                               slapi_counter_get_value(cldb->clCompressedRecords));
+    slapi_entry_attr_set_ulong(e, "nsds5replicaChangelogRawBytes", raw);
+    slapi_entry_attr_set_ulong(e, "nsds5replicaChangelogStoredBytes", stored);
+    slapi_entry_add_string(e, "nsds5replicaChangelogCompressionRatio", ratio);
+}
+
 /* Name:        cl5DestroyIterator
    Description: destroys iterator once iteration through changelog is done
    Parameters:  iterator - iterator to destroy
@@ -1136,7 +1246,7 @@ cl5GetNextOperationToReplay(CL5ReplayIterator *iterator, CL5Entry *entry)
 
     /* there is an entry we should return */
     /* Callers of this function should cl5_operation_parameters_done(op) */
-    if (0 != cl5DBData2Entry(data, datalen, entry, iterator->it_cldb->clcrypt_handle)) {
+    if (0 != clcache_decode_change(iterator->clcache, csn, data, datalen, entry, iterator->it_cldb->clcrypt_handle)) {
         slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
                       "cl5GetNextOperationToReplay - %s - Failed to format entry rc=%d\n", agmt_name, rc);
         return rc;
@@ -1255,10 +1365,12 @@ cldb_UnSetReplicaDB(Replica *replica, void *arg)
         ruv_destroy(&cldb->maxRUV);
         ruv_destroy(&cldb->purgeRUV);
     }
+    _cl5SegmentsFree(cldb);
 
     /* Cleanup the pthread mutexes and friends */
     pthread_mutex_destroy(&(cldb->stLock));
     pthread_mutex_destroy(&(cldb->clLock));
+    pthread_mutex_destroy(&(cldb->segLock));
     pthread_condattr_destroy(&(cldb->clCAttr));
     pthread_cond_destroy(&(cldb->clCvar));
 
@@ -1270,6 +1382,9 @@ cldb_UnSetReplicaDB(Replica *replica, void *arg)
     }
 
     slapi_counter_destroy(&cldb->clThreads);
+    slapi_counter_destroy(&cldb->clRawBytes);
+    slapi_counter_destroy(&cldb->clStoredBytes);
+    slapi_counter_destroy(&cldb->clCompressedRecords);
 
     rc = replica_set_cl_info(replica, NULL);
 
@@ -1312,6 +1427,7 @@ cldb_SetReplicaDB(Replica *replica, void *arg)
         cldb->db = pDB;
         cldb->be = be;
         cldb->ident = ruv_get_replica_generation((RUV*)object_get_data (ruv_obj));
+        pthread_mutex_init(&(cldb->segLock), NULL);
         if (_cldb_CheckAndSetEnv(be, cldb) != CL5_SUCCESS) {
             slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
                           "cldb_SetReplicaDB - Failed to check be environment\n");
@@ -1330,6 +1446,9 @@ cldb_SetReplicaDB(Replica *replica, void *arg)
         cldb->dbOpenMode = CL5_OPEN_NORMAL;
     }
     cldb->clThreads = slapi_counter_new();
+    cldb->clRawBytes = slapi_counter_new();
+    cldb->clStoredBytes = slapi_counter_new();
+    cldb->clCompressedRecords = slapi_counter_new();
     cldb->dbState = CL5_STATE_OPEN;
     cldb->trimmingOnGoing = 0;
 
@@ -1383,6 +1502,7 @@ cldb_SetReplicaDB(Replica *replica, void *arg)
         cldb->clConf.encryptionAlgorithm = config.encryptionAlgorithm;
         cldb->clcrypt_handle = clcrypt_init(config.encryptionAlgorithm, be);
     }
+    cldb->clConf.compression = config.compression;
     changelog5_config_done(&config);
 
     slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name_cl,
@@ -1491,6 +1611,10 @@ _cldb_CheckAndSetEnv(Slapi_Backend *be, cldb_Handle *cldb)
    <null terminated uniqueid><null terminated targetdn>
    [<null terminated newrdn><1 byte deleteoldrdn>][<4 byte mod count><mod1><mod2>....]
 
+   Version 7 replaces "encrypted" by CL5_FLAG_* flags. It is only written
+   when the mods are compressed (CL5_FLAG_COMPRESSED), they are then stored as:
+   <1 byte dictionary id><4 byte mods size><4 byte compressed size><compressed mods>
+
 
    mod format:
    -----------
@@ -1498,10 +1622,12 @@ _cldb_CheckAndSetEnv(Slapi_Backend *be, cldb_Handle *cldb)
    <4 byte value size><value1><4 byte value size><value2>
 */
 static int
-_cl5Entry2DBData(const CL5Entry *entry, char **data, PRUint32 *len, void *clcrypt_handle)
+_cl5Entry2DBData(const CL5Entry *entry, char **data, PRUint32 *len, cldb_Handle *cldb)
 {
     int size = 1 /* version */ + 1 /* operation type */ + sizeof(time_t);
+    void *clcrypt_handle = cldb->clcrypt_handle;
     char *pos;
+    char *mods;
     PRUint32 t;
     slapi_operation_parameters *op;
     LDAPMod **add_mods = NULL;
@@ -1609,14 +1735,18 @@ _cl5Entry2DBData(const CL5Entry *entry, char **data, PRUint32 *len, void *clcryp
     case SLAPI_OPERATION_ADD:
         _cl5WriteString(op->p.p_add.parentuniqueid, &pos);
         _cl5WriteString(rawDN, &pos);
+        mods = pos;
         _cl5WriteMods(add_mods, &pos, clcrypt_handle);
+        _cl5CompressMods(cldb, *data, mods, &pos);
         slapi_ch_free((void **)&rawDN);
         ldap_mods_free(add_mods, 1);
         break;
 
     case SLAPI_OPERATION_MODIFY:
         _cl5WriteString(REPL_GET_DN(&op->target_address), &pos);
+        mods = pos;
         _cl5WriteMods(op->p.p_modify.modify_mods, &pos, clcrypt_handle);
+        _cl5CompressMods(cldb, *data, mods, &pos);
         break;
 
     case SLAPI_OPERATION_MODRDN:
@@ -1626,7 +1756,9 @@ _cl5Entry2DBData(const CL5Entry *entry, char **data, PRUint32 *len, void *clcryp
         pos++;
         _cl5WriteString(REPL_GET_DN(&op->p.p_modrdn.modrdn_newsuperior_address), &pos);
         _cl5WriteString(op->p.p_modrdn.modrdn_newsuperior_address.uniqueid, &pos);
+        mods = pos;
         _cl5WriteMods(op->p.p_modrdn.modrdn_mods, &pos, clcrypt_handle);
+        _cl5CompressMods(cldb, *data, mods, &pos);
         break;
 
     case SLAPI_OPERATION_DELETE:
@@ -1659,6 +1791,10 @@ _cl5Entry2DBData(const CL5Entry *entry, char **data, PRUint32 *len, void *clcryp
    <null terminated uniqueid><null terminated targetdn>
    [<null terminated newrdn><1 byte deleteoldrdn>][<4 byte mod count><mod1><mod2>....]
 
+   Version 7 replaces "encrypted" by CL5_FLAG_* flags. It is only written
+   when the mods are compressed (CL5_FLAG_COMPRESSED), they are then stored as:
+   <1 byte dictionary id><4 byte mods size><4 byte compressed size><compressed mods>
+
 
    mod format:
    -----------
@@ -1673,6 +1809,7 @@ cl5DBData2Entry(const char *data, PRUint32 len __attribute__((unused)), CL5Entry
     int rc;
     PRUint8 version;
     PRUint8 encrypted = 0;
+    PRBool compressed = PR_FALSE;
     char *pos = (char *)data;
     char *strCSN;
     PRUint32 thetime;
@@ -1688,7 +1825,7 @@ cl5DBData2Entry(const char *data, PRUint32 len __attribute__((unused)), CL5Entry
 
     /* read byte of version */
     version = (PRUint8)(*pos);
-    if (version != V_5 && version != V_6) {
+    if (version != V_5 && version != V_6 && version != V_7) {
         slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
                       "cl5DBData2Entry - Invalid data version: %d\n", version);
         return CL5_BAD_FORMAT;
@@ -1703,6 +1840,13 @@ cl5DBData2Entry(const char *data, PRUint32 len __attribute__((unused)), CL5Entry
             /* This cl entry is not encrypted, so don't try */
             clcrypt_handle = NULL;
         }
+    } else if (version == V_7) {
+        encrypted = (PRUint8)(*pos);
+        pos += sizeof(encrypted);
+        if (!(encrypted & CL5_FLAG_ENCRYPTED)) {
+            clcrypt_handle = NULL;
+        }
+        compressed = (encrypted & CL5_FLAG_COMPRESSED) ? PR_TRUE : PR_FALSE;
     }
 
     /* read change type */
@@ -1734,7 +1878,7 @@ cl5DBData2Entry(const char *data, PRUint32 len __attribute__((unused)), CL5Entry
         _cl5ReadString(&rawDN, &pos);
         op->target_address.sdn = slapi_sdn_new_dn_passin(rawDN);
         /* convert mods to entry */
-        rc = _cl5ReadMods(&add_mods, &pos, clcrypt_handle);
+        rc = _cl5ReadMods(&add_mods, &pos, clcrypt_handle, compressed);
         slapi_mods2entry(&(op->p.p_add.target_entry), rawDN, add_mods);
         ldap_mods_free(add_mods, 1);
         break;
@@ -1742,7 +1886,7 @@ cl5DBData2Entry(const char *data, PRUint32 len __attribute__((unused)), CL5Entry
     case SLAPI_OPERATION_MODIFY:
         _cl5ReadString(&rawDN, &pos);
         op->target_address.sdn = slapi_sdn_new_dn_passin(rawDN);
-        rc = _cl5ReadMods(&op->p.p_modify.modify_mods, &pos, clcrypt_handle);
+        rc = _cl5ReadMods(&op->p.p_modify.modify_mods, &pos, clcrypt_handle, compressed);
         break;
 
     case SLAPI_OPERATION_MODRDN:
@@ -1754,7 +1898,7 @@ cl5DBData2Entry(const char *data, PRUint32 len __attribute__((unused)), CL5Entry
         _cl5ReadString(&rawDN, &pos);
         op->p.p_modrdn.modrdn_newsuperior_address.sdn = slapi_sdn_new_dn_passin(rawDN);
         _cl5ReadString(&op->p.p_modrdn.modrdn_newsuperior_address.uniqueid, &pos);
-        rc = _cl5ReadMods(&op->p.p_modrdn.modrdn_mods, &pos, clcrypt_handle);
+        rc = _cl5ReadMods(&op->p.p_modrdn.modrdn_mods, &pos, clcrypt_handle, compressed);
         break;
 
     case SLAPI_OPERATION_DELETE:
@@ -1787,14 +1931,14 @@ cl5DBData2EntryTime(const char *data, time_t *entrytime)
 
     /* read byte of version */
     version = (PRUint8)(*pos);
-    if (version != V_5 && version != V_6) {
+    if (version != V_5 && version != V_6 && version != V_7) {
         slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
                       "cl5DBData2EntryTime - Invalid data version: %d\n", version);
         return CL5_BAD_FORMAT;
     }
     pos += sizeof(version);
 
-    if (version == V_6) {
+    if (version >= V_6) {
         /* In version 6 we set a flag to note if the changes are encrypted */
         pos += sizeof(PRUint8);
     }
@@ -1858,6 +2002,10 @@ _cl5Iterate(cldb_Handle *cldb, dbi_iterate_cb_t *action_cb, DBLCI_CTX *dblcictx,
 
     dblcictx->finished = PR_FALSE;
     dblcictx->cldb = cldb;
+    if (csn_get_time(&dblcictx->startcsn)) {
+        /* the caller tells where to start */
+        startcsn = &dblcictx->startcsn;
+    }
     while ((rc == CL5_SUCCESS && dblcictx->finished == PR_FALSE) ||
            (rc == CL5_DB_RETRY && nbtries < MAX_RETRIES))
     {
@@ -2086,6 +2234,152 @@ _cl5WriteMods(LDAPMod **mods, char **buff, void *clcrypt_handle)
     (*buff) = mod_start;
 }
 
+/*
+ * Preset zlib dictionary of the compressed mods: attribute types and values
+ * found in most of the replicated changes, the most frequent ones last. The
+ * records only store its id (CL5_DICT_V1), so it can not be changed: a new
+ * dictionary needs a new id, the old one being kept to read the existing
+ * records.
+ */
+static const char cl5_mods_dictionary[] =
+    "nsAccountLockpasswordExpirationTimepasswordRetryCountretryCountResetTime"
+    "passwordGraceUserTimepwdChangedTimepasswordAllowChangeTimeuserPassword"
+    "userCertificate;binarycACertificate;binaryjpegPhotoseeAlsomailmobile"
+    "telephoneNumbergivenNamedisplayNamedescriptionhomeDirectoryloginShell"
+    "gidNumberuidNumberposixAccountshadowAccountnsPersonnsAccountnsOrgPerson"
+    "inetOrgPersonorganizationalPersonpersonextensibleObjecttopuidsncn"
+    "groupOfUniqueNamesuniqueMembergroupOfNamesmemberOfmember,ou=Groups,"
+    ",ou=People,cn=directory manager"
+    "cn=ldbm database,cn=plugins,cn=configcn=Multisupplier Replication Plugin,cn=plugins,cn=config"
+    "nsUniqueIdnsParentUniqueIdnscpEntryDNentryUSNentryidparentid"
+    "creatorsNamecreateTimestampinternalCreatorsNameinternalModifiersName"
+    "internalModifyTimestampmodifiersNamemodifyTimestamp";
+
+/*
+ * Compresses in place the mods written by _cl5WriteMods from mods to *buff,
+ * if the changelog is configured so and that makes them smaller. The record
+ * is then marked as a version 7 one with CL5_FLAG_COMPRESSED.
+ */
+static void
+_cl5CompressMods(cldb_Handle *cldb, char *data, char *mods, char **buff)
+{
+    PRUint32 rawlen = (PRUint32)(*buff - mods);
+    PRUint32 zlen;
+    PRUint32 net_length;
+    uLong zsize;
+    char *zbuf = NULL;
+    z_stream zs = {0};
+    int rc;
+
+    if (!slapi_atomic_load_32(&cldb->clConf.compression, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    slapi_counter_add(cldb->clRawBytes, rawlen);
+    if (rawlen < CL5_COMPRESS_MIN_SIZE) {
+        slapi_counter_add(cldb->clStoredBytes, rawlen);
+        return;
+    }
+
+    rc = deflateInit(&zs, Z_BEST_SPEED);
+    if (rc == Z_OK) {
+        rc = deflateSetDictionary(&zs, (const Bytef *)cl5_mods_dictionary,
+                                  sizeof(cl5_mods_dictionary) - 1);
+    }
+    if (rc == Z_OK) {
+        zsize = deflateBound(&zs, rawlen);
+        zbuf = slapi_ch_malloc(zsize);
+        zs.next_in = (Bytef *)mods;
+        zs.avail_in = rawlen;
+        zs.next_out = (Bytef *)zbuf;
+        zs.avail_out = zsize;
+        rc = deflate(&zs, Z_FINISH);
+    }
+    zlen = (PRUint32)zs.total_out;
+    deflateEnd(&zs);
+
+    /* keep the mods as is if they do not shrink */
+    if (rc != Z_STREAM_END || 1 + 2 * sizeof(PRUint32) + zlen >= rawlen) {
+        slapi_counter_add(cldb->clStoredBytes, rawlen);
+        slapi_ch_free_string(&zbuf);
+        return;
+    }
+
+    *mods = CL5_DICT_V1;
+    mods++;
+    net_length = PR_htonl(rawlen);
+    memcpy(mods, &net_length, sizeof(net_length));
+    mods += sizeof(net_length);
+    net_length = PR_htonl(zlen);
+    memcpy(mods, &net_length, sizeof(net_length));
+    mods += sizeof(net_length);
+    memcpy(mods, zbuf, zlen);
+    *buff = mods + zlen;
+    slapi_ch_free_string(&zbuf);
+
+    data[0] = V_7;
+    data[1] |= CL5_FLAG_COMPRESSED;
+    slapi_counter_add(cldb->clStoredBytes, 1 + 2 * sizeof(PRUint32) + zlen);
+    slapi_counter_increment(cldb->clCompressedRecords);
+}
+
+/*
+ * Uncompresses the mods written by _cl5CompressMods. On success *raw is the
+ * allocated buffer of the mods and *buff is moved after the compressed data.
+ */
+static int
+_cl5UncompressMods(char **buff, char **raw)
+{
+    char *pos = *buff;
+    PRUint32 rawlen;
+    PRUint32 zlen;
+    z_stream zs = {0};
+    int rc;
+
+    if ((PRUint8)*pos != CL5_DICT_V1) {
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
+                      "_cl5UncompressMods - Unknown dictionary %d\n", (PRUint8)*pos);
+        return CL5_BAD_FORMAT;
+    }
+    pos++;
+    memcpy((char *)&rawlen, pos, sizeof(rawlen));
+    rawlen = PR_ntohl(rawlen);
+    pos += sizeof(rawlen);
+    memcpy((char *)&zlen, pos, sizeof(zlen));
+    zlen = PR_ntohl(zlen);
+    pos += sizeof(zlen);
+
+    *raw = slapi_ch_malloc(rawlen);
+    rc = inflateInit(&zs);
+    if (rc == Z_OK) {
+        zs.next_in = (Bytef *)pos;
+        zs.avail_in = zlen;
+        zs.next_out = (Bytef *)*raw;
+        zs.avail_out = rawlen;
+        rc = inflate(&zs, Z_FINISH);
+        if (rc == Z_NEED_DICT) {
+            rc = inflateSetDictionary(&zs, (const Bytef *)cl5_mods_dictionary,
+                                      sizeof(cl5_mods_dictionary) - 1);
+            if (rc == Z_OK) {
+                rc = inflate(&zs, Z_FINISH);
+            }
+        }
+        if (rc == Z_STREAM_END && zs.total_out != rawlen) {
+            rc = Z_DATA_ERROR;
+        }
+        inflateEnd(&zs);
+    }
+    if (rc != Z_STREAM_END) {
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
+                      "_cl5UncompressMods - Failed to uncompress %u bytes (zlib error %d)\n",
+                      zlen, rc);
+        slapi_ch_free_string(raw);
+        return CL5_BAD_FORMAT;
+    }
+
+    *buff = pos + zlen;
+    return CL5_SUCCESS;
+}
+
 /*
  * return values:
  *     positive: no need to encrypt && succeeded to write a mod
@@ -2181,18 +2475,29 @@ _cl5WriteMod(LDAPMod *mod, char **buff, void *clcrypt_handle)
  */
 
 static int
-_cl5ReadMods(LDAPMod ***mods, char **buff, void *clcrypt_handle)
+_cl5ReadMods(LDAPMod ***mods, char **buff, void *clcrypt_handle, PRBool compressed)
 {
     char *pos = *buff;
+    char *raw = NULL;
+    char *next = NULL;
     int i;
     int rc;
     PRInt32 mod_count;
     Slapi_Mods smods;
     Slapi_Mod smod;
 
+    if (compressed) {
+        next = pos;
+        rc = _cl5UncompressMods(&next, &raw);
+        if (rc != CL5_SUCCESS) {
+            return rc;
+        }
+        pos = raw;
+    }
+
     /* need to copy first, to skirt around alignment problems on certain
        architectures */
-    memcpy((char *)&mod_count, *buff, sizeof(mod_count));
+    memcpy((char *)&mod_count, pos, sizeof(mod_count));
     mod_count = PR_ntohl(mod_count);
     pos += sizeof(mod_count);
 
@@ -2202,13 +2507,15 @@ _cl5ReadMods(LDAPMod ***mods, char **buff, void *clcrypt_handle)
         rc = _cl5ReadMod(&smod, &pos, clcrypt_handle);
         if (rc != CL5_SUCCESS) {
             slapi_mods_done(&smods);
+            slapi_ch_free_string(&raw);
             return rc;
         }
 
         slapi_mods_add_smod(&smods, &smod);
     }
 
-    *buff = pos;
+    *buff = compressed ? next : pos;
+    slapi_ch_free_string(&raw);
 
     *mods = slapi_mods_get_ldapmods_passout(&smods);
     slapi_mods_done(&smods);
@@ -2710,6 +3017,7 @@ _cl5PurgeRID(cleanruv_data *data, cldb_Handle *cldb)
                      "again.",
                      rc);
     } else {
+        _cl5SegmentsRemoveRid(cldb, data->rid);
         cleanruv_log(data->task, data->rid, CLEANALLRUV_ID,
                      SLAPI_LOG_INFO,
                      "Scanned %ld records, and purged %ld records from the "
@@ -2720,6 +3028,38 @@ _cl5PurgeRID(cleanruv_data *data, cldb_Handle *cldb)
     return rc;
 }
 
+/*
+ * _cl5TrimReplica helper: tells whether csn is the anchor csn of its rid,
+ * i.e. the largest csn of the rid in the trimming ruv.
+ */
+static PRBool
+_cl5IsAnchorCSN(const RUV *ruv, const CSN *csn)
+{
+    CSN *maxcsn = NULL;
+    PRBool anchor;
+
+    ruv_get_largest_csn_for_replica(ruv, csn_get_replicaid(csn), &maxcsn);
+    anchor = (maxcsn && csn_compare(csn, maxcsn) == 0);
+    csn_free(&maxcsn);
+    return anchor;
+}
+
+/*
+ * _cl5TrimReplica helper: get the RID_INFO of a rid whose purge csn has
+ * to be updated. mincsn is set when its anchor csn is kept.
+ */
+static RID_INFO *
+_cl5TrimGetRidInfo(DBLCI_CTX *dblcictx, ReplicaId rid)
+{
+    RID_INFO *ridinfo = _cl5GetRidInfo(dblcictx, rid, PR_TRUE);
+
+    if (ridinfo->new) {
+        ridinfo->new = 0;
+        memset(&ridinfo->mincsn, 0, sizeof(CSN));
+    }
+    return ridinfo;
+}
+
 /*
  * _cl5TrimReplica helper: dblayer_cursor_iterate callback.
  * Returns:
@@ -2767,7 +3107,7 @@ _cl5TrimEntry(dbi_val_t *key, dbi_val_t *data, void *ctx)
          * so lets us mark the rid to update the purge ruv on a second phase
          */
         rid = csn_get_replicaid(&dblcictx->csn);
-        _cl5GetRidInfo(dblcictx, rid, PR_TRUE);
+        _cl5TrimGetRidInfo(dblcictx, rid);
     } else { /* ruv_covers_csn_strict */
         /* The changelog DB is time ordered. If we can not trim
          * a CSN, we will not be allowed to trim the rest of the
@@ -2777,12 +3117,7 @@ _cl5TrimEntry(dbi_val_t *key, dbi_val_t *data, void *ctx)
          * CSNs, otherwise a non-active replica ID could block
          * the trim forever.
          */
-        CSN *maxcsn = NULL;
-        ruv_get_largest_csn_for_replica(dblcictx->ruv, rid, &maxcsn);
-        rc = csn_compare(&dblcictx->csn, maxcsn);
-        if (maxcsn)
-            csn_free(&maxcsn);
-        if (rc) {
+        if (!_cl5IsAnchorCSN(dblcictx->ruv, &dblcictx->csn)) {
             /* csn is not anchor CSN */
             dblcictx->finished = PR_TRUE;
             return DBI_RC_NOTFOUND;
@@ -2790,12 +3125,123 @@ _cl5TrimEntry(dbi_val_t *key, dbi_val_t *data, void *ctx)
             slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name_cl,
                           "_cl5TrimEntry - Changelog purge skipped anchor csn %s\n",
                           (char*)key->data);
+            rid = csn_get_replicaid(&dblcictx->csn);
+            _cl5TrimGetRidInfo(dblcictx, rid)->mincsn = dblcictx->csn;
             return DBI_RC_SUCCESS;
         }
     }
     return DBI_RC_SUCCESS;
 }
 
+/*
+ * _cl5TrimSegments helper: dblayer_cursor_iterate callback.
+ * Remove the changes up to the end of the first segment.
+ * Returns:
+ *     DBI_RC_SUCCESS to iterate on next entry
+ *     DBI_RC_NOTFOUND to stop iteration with DBI_RC_SUCCESS code
+ *     other DBI_RC_ code to stop iteration with that error code.
+ */
+int
+_cl5TrimSegmentEntry(dbi_val_t *key, dbi_val_t *data, void *ctx)
+{
+    DBLCI_CTX *dblcictx = ctx;
+    ReplicaId rid = 0;
+    int rc = 0;
+
+    rc = _cl5CICbInit(key, data, dblcictx);
+    if (rc != DBI_RC_SUCCESS) {
+        return rc;
+    }
+
+    if (cl5HelperEntry(NULL, &dblcictx->csn) == PR_TRUE) {
+        return DBI_RC_SUCCESS;
+    }
+    if (csn_compare(&dblcictx->csn, &dblcictx->endcsn) >= 0) {
+        /* the segment is removed */
+        dblcictx->finished = PR_TRUE;
+        return DBI_RC_NOTFOUND;
+    }
+    rid = csn_get_replicaid(&dblcictx->csn);
+    if (ruv_covers_csn_strict(dblcictx->ruv, &dblcictx->csn)) {
+        rc = _cl5CICbRemoveEntry(dblcictx, __FUNCTION__);
+        if (rc == DBI_RC_SUCCESS) {
+            _cl5TrimGetRidInfo(dblcictx, rid);
+        }
+        return rc;
+    }
+    if (_cl5IsAnchorCSN(dblcictx->ruv, &dblcictx->csn)) {
+        _cl5TrimGetRidInfo(dblcictx, rid)->mincsn = dblcictx->csn;
+        return DBI_RC_SUCCESS;
+    }
+    /* A change the segment index does not know about: leave the
+     * rest of the segment to the change by change trimming
+     */
+    dblcictx->partial = PR_TRUE;
+    dblcictx->finished = PR_TRUE;
+    return DBI_RC_NOTFOUND;
+}
+
+/*
+ * _cl5TrimReplica helper: remove the leading segments whose changes can all
+ * be trimmed. The changes are removed without being decoded and in larger
+ * transactions than the change by change trimming.
+ * Returns the number of removed segments.
+ */
+static int
+_cl5TrimSegments(cldb_Handle *cldb, DBLCI_CTX *dblcictx)
+{
+    CL5Config *dbTrim = &cldb->clConf;
+    time_t now = slapi_current_utc_time();
+    int nbmax = dblcictx->changed.nbmax;
+    int dropped = 0;
+    int rc;
+
+    dblcictx->changed.nbmax = dblayer_is_lmdb(cldb->be) ?
+        CL5_TRIM_SEGMENT_PER_TRANSACTION_MDB : CL5_TRIM_SEGMENT_PER_TRANSACTION_BDB;
+    while (!slapi_is_shutting_down()) {
+        PRBool trim = PR_FALSE;
+        PRUint32 count = 0;
+
+        pthread_mutex_lock(&(cldb->segLock));
+        /* the last segment receives the new changes and is never removed */
+        if (cldb->nbSegments > 1) {
+            CL5Segment *seg = &cldb->segments[0];
+
+            count = seg->count;
+            trim = (dblcictx->numToTrim >= count) ||
+                   (dbTrim->maxAge && now - seg->maxtime > dbTrim->maxAge);
+            for (int i = 0; trim && i < seg->nb_rids; i++) {
+                trim = ruv_covers_csn_strict(dblcictx->ruv, &seg->rids[i].last) ||
+                       _cl5IsAnchorCSN(dblcictx->ruv, &seg->rids[i].last);
+            }
+            dblcictx->endcsn = cldb->segments[1].first;
+        }
+        pthread_mutex_unlock(&(cldb->segLock));
+        if (!trim) {
+            break;
+        }
+
+        dblcictx->partial = PR_FALSE;
+        memset(&dblcictx->startcsn, 0, sizeof(CSN));
+        rc = _cl5Iterate(cldb, _cl5TrimSegmentEntry, dblcictx, PR_FALSE);
+        if ((rc != CL5_SUCCESS && rc != CL5_NOTFOUND) || dblcictx->partial) {
+            break;
+        }
+
+        pthread_mutex_lock(&(cldb->segLock));
+        if (cldb->nbSegments > 1 && csn_compare(&cldb->segments[1].first, &dblcictx->endcsn) == 0) {
+            _cl5SegmentsDropFirst(cldb, dblcictx->ruv);
+        }
+        pthread_mutex_unlock(&(cldb->segLock));
+        dblcictx->numToTrim = (dblcictx->numToTrim > count) ? dblcictx->numToTrim - count : 0;
+        dropped++;
+    }
+    dblcictx->changed.nbmax = nbmax;
+    memset(&dblcictx->startcsn, 0, sizeof(CSN));
+
+    return dropped;
+}
+
 /*
  * _cl5TrimReplica helper: dblayer_cursor_iterate callback.
  * Update the purge ruv
@@ -2837,11 +3283,42 @@ _cl5TrimUpdateRuv(dbi_val_t *key, dbi_val_t *data, void *ctx)
      return DBI_RC_SUCCESS;
 }
 
+/*
+ * _cl5TrimReplica helper: set the purge csn of the trimmed rids to their
+ * first remaining change. That is the anchor csn when it was kept, otherwise
+ * the segment index tells where the next change of the rid is and only the
+ * changes from there are read.
+ */
+static void
+_cl5TrimUpdatePurgeRUV(cldb_Handle *cldb, DBLCI_CTX *dblcictx)
+{
+    for (size_t i = 0; i < dblcictx->nb_rids; i++) {
+        RID_INFO *ridinfo = &dblcictx->rids[i];
+        DBLCI_CTX ridctx = {0};
+        CSN start;
+
+        if (csn_get_time(&ridinfo->mincsn)) {
+            _cl5UpdateRUV(cldb, &ridinfo->mincsn, PR_FALSE, PR_TRUE);
+            continue;
+        }
+        if (_cl5SegmentsNextCSN(cldb, ridinfo->rid, &dblcictx->csn, PR_FALSE, &start) != CL5_SUCCESS) {
+            /* no change of the rid remains */
+            continue;
+        }
+        ridctx.startcsn = start;
+        ridctx.seen.nbmax = CL5_TRIM_MAX_LOOKUP_PER_TRANSACTION;
+        _cl5GetRidInfo(&ridctx, ridinfo->rid, PR_TRUE);
+        _cl5Iterate(cldb, _cl5TrimUpdateRuv, &ridctx, PR_TRUE);
+        slapi_ch_free((void **)&ridctx.rids);
+    }
+}
+
 void
 _cl5TrimReplica(Replica *r)
 {
     DBLCI_CTX dblcictx = {0};
     int rc = CL5_SUCCESS;
+    int dropped = 0;
 
     cldb_Handle *cldb = replica_get_cl_info(r);
     if (cldb == NULL) {
@@ -2861,14 +3338,24 @@ _cl5TrimReplica(Replica *r)
     dblcictx.r = r;
     dblcictx.seen.nbmax = CL5_TRIM_MAX_LOOKUP_PER_TRANSACTION;
     dblcictx.changed.nbmax = CL5_TRIM_MAX_PER_TRANSACTION;
+    dropped = _cl5TrimSegments(cldb, &dblcictx);
     rc = _cl5Iterate(cldb, _cl5TrimEntry, &dblcictx, PR_FALSE);
+    if (rc == CL5_SUCCESS || rc == CL5_NOTFOUND) {
+        /* forget the segments that are now before the first remaining change */
+        pthread_mutex_lock(&(cldb->segLock));
+        while (cldb->nbSegments > 1 && csn_compare(&cldb->segments[1].first, &dblcictx.csn) <= 0) {
+            _cl5SegmentsDropFirst(cldb, dblcictx.ruv);
+        }
+        pthread_mutex_unlock(&(cldb->segLock));
+    }
     ruv_destroy(&dblcictx.ruv);
-    rc = _cl5Iterate(cldb, _cl5TrimUpdateRuv, &dblcictx, PR_TRUE);
+    _cl5TrimUpdatePurgeRUV(cldb, &dblcictx);
     slapi_ch_free((void**)&dblcictx.rids);
 
     if (dblcictx.changed.tot) {
-        slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name_cl, "_cl5TrimReplica - Scanned %ld records, and trimmed %ld changes from the changelog\n",
-                      dblcictx.seen.tot, dblcictx.changed.tot);
+        slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name_cl, "_cl5TrimReplica - Scanned %ld records, removed %d segments, "
+                      "and trimmed %ld changes from the changelog\n",
+                      dblcictx.seen.tot, dropped, dblcictx.changed.tot);
     }
 }
 
@@ -2897,6 +3384,389 @@ _cl5CanTrim(time_t time, long *numToTrim, Replica *replica, CL5Config *dbTrim)
     }
 }
 
+/* Segment index helper: find or add the slot of a rid in a segment */
+static CL5SegmentRid *
+_cl5SegmentGetRid(CL5Segment *seg, ReplicaId rid, PRBool addifmissing)
+{
+    int i;
+
+    for (i = 0; i < seg->nb_rids && seg->rids[i].rid < rid; i++)
+        ;
+    if (i < seg->nb_rids && seg->rids[i].rid == rid) {
+        return &seg->rids[i];
+    }
+    if (addifmissing == PR_FALSE) {
+        return NULL;
+    }
+    seg->rids = (CL5SegmentRid *)slapi_ch_realloc((char *)seg->rids, (seg->nb_rids + 1) * sizeof(CL5SegmentRid));
+    memmove(&seg->rids[i + 1], &seg->rids[i], (seg->nb_rids - i) * sizeof(CL5SegmentRid));
+    memset(&seg->rids[i], 0, sizeof(CL5SegmentRid));
+    seg->rids[i].rid = rid;
+    seg->nb_rids++;
+    return &seg->rids[i];
+}
+
+/* Segment index helper: account a change of the segment */
+static void
+_cl5SegmentAddCSN(CL5Segment *seg, const CSN *csn)
+{
+    CL5SegmentRid *segrid = _cl5SegmentGetRid(seg, csn_get_replicaid(csn), PR_TRUE);
+
+    if (csn_get_time(&segrid->first) == 0 || csn_compare(csn, &segrid->first) < 0) {
+        segrid->first = *csn;
+    }
+    if (csn_compare(csn, &segrid->last) > 0) {
+        segrid->last = *csn;
+    }
+    if (csn_compare(csn, &seg->first) < 0) {
+        seg->first = *csn;
+    }
+    if (csn_compare(csn, &seg->last) > 0) {
+        seg->last = *csn;
+    }
+    seg->count++;
+}
+
+/* Segment index helper: add an empty segment starting at csn. segLock must be held */
+static CL5Segment *
+_cl5SegmentsAppend(cldb_Handle *cldb, const CSN *csn)
+{
+    CL5Segment *seg;
+
+    if (cldb->nbSegments >= cldb->maxSegments) {
+        cldb->maxSegments += 64;
+        cldb->segments = (CL5Segment *)slapi_ch_realloc((char *)cldb->segments, cldb->maxSegments * sizeof(CL5Segment));
+    }
+    seg = &cldb->segments[cldb->nbSegments++];
+    memset(seg, 0, sizeof(CL5Segment));
+    seg->first = *csn;
+    seg->last = *csn;
+    return seg;
+}
+
+/* Segment index helper: index of the segment holding csn. segLock must be held */
+static int
+_cl5SegmentsFind(cldb_Handle *cldb, const CSN *csn)
+{
+    int idx = 0;
+    int idx_min = 0;
+    int idx_max = cldb->nbSegments - 1;
+
+    while (idx_min <= idx_max) {
+        int i = (idx_min + idx_max) / 2;
+        if (csn_compare(&cldb->segments[i].first, csn) <= 0) {
+            idx = i;
+            idx_min = i + 1;
+        } else {
+            idx_max = i - 1;
+        }
+    }
+    return idx;
+}
+
+/* Add a change written in the changelog to the segment index */
+static void
+_cl5SegmentsAdd(cldb_Handle *cldb, const CSN *csn, time_t time)
+{
+    CL5Segment *seg;
+
+    pthread_mutex_lock(&(cldb->segLock));
+    if (cldb->nbSegments == 0) {
+        seg = _cl5SegmentsAppend(cldb, csn);
+    } else {
+        seg = &cldb->segments[cldb->nbSegments - 1];
+        if (csn_compare(csn, &seg->last) > 0) {
+            if (seg->count >= CL5_SEGMENT_MAX_CHANGES) {
+                seg = _cl5SegmentsAppend(cldb, csn);
+            }
+        } else {
+            /* a replicated change older than the last one, the first
+             * segment also holds the changes older than its first csn
+             */
+            seg = &cldb->segments[_cl5SegmentsFind(cldb, csn)];
+        }
+    }
+    _cl5SegmentAddCSN(seg, csn);
+    if (time > seg->maxtime) {
+        seg->maxtime = time;
+    }
+    pthread_mutex_unlock(&(cldb->segLock));
+}
+
+/*
+ * Remove the first segment from the index once its changes are trimmed.
+ * The kept anchor csns, the ones not covered by ruv, move to the next
+ * segment. segLock must be held and there must be a next segment.
+ */
+static void
+_cl5SegmentsDropFirst(cldb_Handle *cldb, const RUV *ruv)
+{
+    CL5Segment *seg = &cldb->segments[0];
+    CL5Segment *next = &cldb->segments[1];
+
+    for (int i = 0; i < seg->nb_rids; i++) {
+        if (!ruv_covers_csn_strict(ruv, &seg->rids[i].last)) {
+            _cl5SegmentAddCSN(next, &seg->rids[i].last);
+        }
+    }
+    slapi_ch_free((void **)&seg->rids);
+    cldb->nbSegments--;
+    memmove(cldb->segments, cldb->segments + 1, cldb->nbSegments * sizeof(CL5Segment));
+}
+
+/* Remove a cleaned rid from the segment index */
+static void
+_cl5SegmentsRemoveRid(cldb_Handle *cldb, ReplicaId rid)
+{
+    pthread_mutex_lock(&(cldb->segLock));
+    for (int i = 0; i < cldb->nbSegments; i++) {
+        CL5Segment *seg = &cldb->segments[i];
+        CL5SegmentRid *segrid = _cl5SegmentGetRid(seg, rid, PR_FALSE);
+
+        if (segrid) {
+            int idx = segrid - seg->rids;
+            memmove(segrid, segrid + 1, (seg->nb_rids - idx - 1) * sizeof(CL5SegmentRid));
+            seg->nb_rids--;
+        }
+    }
+    pthread_mutex_unlock(&(cldb->segLock));
+}
+
+/*
+ * Look up in the segment index the first change of rid after csn (or
+ * from csn if strict is PR_FALSE). next is set to a csn such that the
+ * changelog holds no change of rid between csn and next.
+ * Returns CL5_NOTFOUND if the index has no such change.
+ */
+static int
+_cl5SegmentsNextCSN(cldb_Handle *cldb, ReplicaId rid, const CSN *csn, PRBool strict, CSN *next)
+{
+    int rc = CL5_NOTFOUND;
+
+    pthread_mutex_lock(&(cldb->segLock));
+    for (int i = (cldb->nbSegments ? _cl5SegmentsFind(cldb, csn) : 0); i < cldb->nbSegments; i++) {
+        CL5SegmentRid *segrid = _cl5SegmentGetRid(&cldb->segments[i], rid, PR_FALSE);
+        int cmp;
+
+        if (segrid == NULL) {
+            continue;
+        }
+        cmp = csn_compare(&segrid->last, csn);
+        if (cmp > 0 || (cmp == 0 && !strict)) {
+            *next = (csn_compare(&segrid->first, csn) > 0) ? segrid->first : *csn;
+            rc = CL5_SUCCESS;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&(cldb->segLock));
+
+    return rc;
+}
+
+int
+cl5GetRidNextCSN(cldb_Handle *cldb, ReplicaId rid, const CSN *csn, CSN *next)
+{
+    if (cldb == NULL || csn == NULL) {
+        return CL5_BAD_DATA;
+    }
+    return _cl5SegmentsNextCSN(cldb, rid, csn, PR_TRUE, next);
+}
+
+static void
+_cl5SegmentsFree(cldb_Handle *cldb)
+{
+    pthread_mutex_lock(&(cldb->segLock));
+    for (int i = 0; i < cldb->nbSegments; i++) {
+        slapi_ch_free((void **)&cldb->segments[i].rids);
+    }
+    slapi_ch_free((void **)&cldb->segments);
+    cldb->nbSegments = 0;
+    cldb->maxSegments = 0;
+    pthread_mutex_unlock(&(cldb->segLock));
+}
+
+static void
+_cl5WriteUInt32(PRUint32 val, char **buff)
+{
+    val = PR_htonl(val);
+    memcpy(*buff, &val, sizeof(val));
+    (*buff) += sizeof(val);
+}
+
+static int
+_cl5ReadUInt32(PRUint32 *val, char **buff, const char *end)
+{
+    if (end - *buff < (ptrdiff_t)sizeof(*val)) {
+        return CL5_BAD_FORMAT;
+    }
+    memcpy(val, *buff, sizeof(*val));
+    *val = PR_ntohl(*val);
+    (*buff) += sizeof(*val);
+    return CL5_SUCCESS;
+}
+
+static void
+_cl5WriteCSN(const CSN *csn, char **buff)
+{
+    csn_as_string(csn, PR_FALSE, *buff);
+    (*buff) += CSN_STRSIZE;
+}
+
+static int
+_cl5ReadCSN(CSN *csn, char **buff, const char *end)
+{
+    if (end - *buff < CSN_STRSIZE || (*buff)[CSN_STRSIZE - 1] != '\0') {
+        return CL5_BAD_FORMAT;
+    }
+    csn_init_by_string(csn, *buff);
+    (*buff) += CSN_STRSIZE;
+    return CL5_SUCCESS;
+}
+
+/*
+ * The segment index helper entry holds:
+ *   version, number of segments
+ *   for each segment: first csn, last csn, max time, count, number of rids
+ *       and for each rid: first csn, last csn
+ * numbers are 32 bits in network order, csns are CSN_STRSIZE strings.
+ */
+static int
+_cl5WriteSegments(cldb_Handle *cldb)
+{
+    int rc;
+    dbi_val_t key = {0}, data = {0};
+    char csnStr[CSN_STRSIZE];
+    size_t size = 2 * sizeof(PRUint32);
+    char *buff;
+    char *pos;
+
+    pthread_mutex_lock(&(cldb->segLock));
+    for (int i = 0; i < cldb->nbSegments; i++) {
+        size += 2 * CSN_STRSIZE + 3 * sizeof(PRUint32) + cldb->segments[i].nb_rids * 2 * CSN_STRSIZE;
+    }
+    pos = buff = slapi_ch_malloc(size);
+    _cl5WriteUInt32(CL5_SEGMENTS_VERSION, &pos);
+    _cl5WriteUInt32(cldb->nbSegments, &pos);
+    for (int i = 0; i < cldb->nbSegments; i++) {
+        CL5Segment *seg = &cldb->segments[i];
+
+        _cl5WriteCSN(&seg->first, &pos);
+        _cl5WriteCSN(&seg->last, &pos);
+        _cl5WriteUInt32((PRUint32)seg->maxtime, &pos);
+        _cl5WriteUInt32(seg->count, &pos);
+        _cl5WriteUInt32(seg->nb_rids, &pos);
+        for (int j = 0; j < seg->nb_rids; j++) {
+            _cl5WriteCSN(&seg->rids[j].first, &pos);
+            _cl5WriteCSN(&seg->rids[j].last, &pos);
+        }
+    }
+    pthread_mutex_unlock(&(cldb->segLock));
+
+    key.data = _cl5GetHelperEntryKey(SEGMENTS_TIME, csnStr);
+    key.size = CSN_STRSIZE;
+    dblayer_value_set(cldb->be, &data, buff, size);
+
+    rc = dblayer_db_op(cldb->be, cldb->db, NULL, DBI_OP_PUT, &key, &data);
+    dblayer_value_free(cldb->be, &data);
+    if (rc != 0) {
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
+                      "_cl5WriteSegments - Failed to write segment index for file %s; db error - %d (%s)\n",
+                      cldb->ident, rc, dblayer_strerror(rc));
+        return CL5_DB_ERROR;
+    }
+    return CL5_SUCCESS;
+}
+
+static int
+_cl5DecodeSegments(cldb_Handle *cldb, char *pos, const char *end)
+{
+    PRUint32 version = 0;
+    PRUint32 nb = 0;
+
+    if (_cl5ReadUInt32(&version, &pos, end) != CL5_SUCCESS || version != CL5_SEGMENTS_VERSION ||
+        _cl5ReadUInt32(&nb, &pos, end) != CL5_SUCCESS) {
+        return CL5_BAD_FORMAT;
+    }
+    for (PRUint32 i = 0; i < nb; i++) {
+        CSN first, last;
+        PRUint32 maxtime, count, nb_rids;
+        CL5Segment *seg;
+
+        if (_cl5ReadCSN(&first, &pos, end) != CL5_SUCCESS ||
+            _cl5ReadCSN(&last, &pos, end) != CL5_SUCCESS ||
+            _cl5ReadUInt32(&maxtime, &pos, end) != CL5_SUCCESS ||
+            _cl5ReadUInt32(&count, &pos, end) != CL5_SUCCESS ||
+            _cl5ReadUInt32(&nb_rids, &pos, end) != CL5_SUCCESS ||
+            nb_rids > (PRUint32)(end - pos) / (2 * CSN_STRSIZE)) {
+            return CL5_BAD_FORMAT;
+        }
+        seg = _cl5SegmentsAppend(cldb, &first);
+        seg->last = last;
+        seg->maxtime = (time_t)maxtime;
+        seg->count = count;
+        seg->rids = (CL5SegmentRid *)slapi_ch_calloc(nb_rids ? nb_rids : 1, sizeof(CL5SegmentRid));
+        for (PRUint32 j = 0; j < nb_rids; j++) {
+            if (_cl5ReadCSN(&seg->rids[j].first, &pos, end) != CL5_SUCCESS ||
+                _cl5ReadCSN(&seg->rids[j].last, &pos, end) != CL5_SUCCESS) {
+                /* the caller frees the segments read so far */
+                return CL5_BAD_FORMAT;
+            }
+            seg->rids[j].rid = csn_get_replicaid(&seg->rids[j].first);
+            seg->nb_rids++;
+        }
+    }
+    return (pos == end) ? CL5_SUCCESS : CL5_BAD_FORMAT;
+}
+
+/*
+ * Read the segment index stored when the changelog was closed.
+ * Returns CL5_NOTFOUND if it has to be rebuilt.
+ */
+static int
+_cl5ReadSegments(cldb_Handle *cldb)
+{
+    int rc;
+    char csnStr[CSN_STRSIZE];
+    dbi_val_t key = {0}, data = {0};
+
+    _cl5SegmentsFree(cldb);
+    _cl5GetHelperEntryKey(SEGMENTS_TIME, csnStr);
+    dblayer_value_set_buffer(cldb->be, &key, csnStr, CSN_STRSIZE);
+    dblayer_value_init(cldb->be, &data);
+
+    rc = dblayer_db_op(cldb->be, cldb->db, NULL /*txn*/, DBI_OP_GET, &key, &data);
+    switch (rc) {
+    case 0:
+        pthread_mutex_lock(&(cldb->segLock));
+        rc = _cl5DecodeSegments(cldb, data.data, (char *)data.data + data.size);
+        pthread_mutex_unlock(&(cldb->segLock));
+        dblayer_value_free(cldb->be, &data);
+        /* delete the entry; it is re-added when file
+                               is successfully closed */
+        dblayer_db_op(cldb->be, cldb->db, NULL, DBI_OP_DEL, &key, NULL);
+        if (rc != CL5_SUCCESS) {
+            slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
+                          "_cl5ReadSegments - Invalid segment index for file %s, rebuilding it\n",
+                          cldb->ident);
+            _cl5SegmentsFree(cldb);
+            return CL5_NOTFOUND;
+        }
+        slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name_cl,
+                      "_cl5ReadSegments - %d segments for replica %s\n",
+                      cldb->nbSegments, cldb->ident);
+        return CL5_SUCCESS;
+
+    case DBI_RC_NOTFOUND: /* index is lost - need to construct */
+        return CL5_NOTFOUND;
+
+    default:
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name_cl,
+                      "_cl5ReadSegments - Failed to get segment index; db error - %d %s\n",
+                      rc, dblayer_strerror(rc));
+        return CL5_NOTFOUND;
+    }
+}
+
 static int
 _cl5ReadRUV (cldb_Handle *cldb, PRBool purge)
 {
@@ -2975,7 +3845,13 @@ _cl5ReadRUVs (cldb_Handle *cldb)
     if (rc == CL5_SUCCESS) {
         rc = _cl5ReadRUV(cldb, PR_FALSE);
     }
+    if (rc == CL5_SUCCESS) {
+        rc = _cl5ReadSegments(cldb);
+    }
     if (rc == CL5_NOTFOUND) {
+        /* the segment index is built while walking the changelog */
+        ruv_destroy(&cldb->purgeRUV);
+        ruv_destroy(&cldb->maxRUV);
         rc = _cl5ConstructRUVs(cldb);
     }
     if (rc == CL5_SUCCESS) {
@@ -3052,6 +3928,7 @@ _cl5GenRUVInfo(dbi_val_t *key, dbi_val_t *data, void *ctx)
     DBLCI_CTX *dblcictx = ctx;
     ReplicaId rid = 0;
     RID_INFO *ridinfo = NULL;
+    time_t entrytime = 0;
     int rc = _cl5CICbInit(key, data, dblcictx);
     if (rc != DBI_RC_SUCCESS) {
         return rc;
@@ -3076,6 +3953,10 @@ _cl5GenRUVInfo(dbi_val_t *key, dbi_val_t *data, void *ctx)
         ridinfo->mincsn = dblcictx->csn;
     }
     ridinfo->maxcsn = dblcictx->csn;
+    if (cl5DBData2EntryTime(data->data, &entrytime) != CL5_SUCCESS) {
+        entrytime = csn_get_time(&dblcictx->csn);
+    }
+    _cl5SegmentsAdd(dblcictx->cldb, &dblcictx->csn, entrytime);
     return DBI_RC_SUCCESS;
 }
 
@@ -3090,6 +3971,7 @@ _cl5ConstructRUVs (cldb_Handle *cldb)
     int rc = ruv_init_new(cldb->ident, 0, NULL, &cldb->purgeRUV);
     const char * bename = cldb->be ? cldb->be->be_name : "?" ;
 
+    _cl5SegmentsFree(cldb);
     if (rc != RUV_SUCCESS) {
         slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name_cl, "_cl5ConstructRUVs - "
                                                            "Failed to initialize purges RUV for %s changelog in backend %s; ruv error - %d\n",
@@ -3775,7 +4657,7 @@ _cl5WriteOperationTxn(cldb_Handle *cldb, const slapi_operation_parameters *op, v
     dblayer_value_set_buffer(cldb->be, &key, csnStr, CSN_STRSIZE);
 
     /* construct the data */
-    rc = _cl5Entry2DBData(&entry, &edata, &esize, cldb->clcrypt_handle);
+    rc = _cl5Entry2DBData(&entry, &edata, &esize, cldb);
     if (rc != CL5_SUCCESS) {
         slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name_cl,
                       "_cl5WriteOperationTxn - Failed to convert entry with csn (%s) "
@@ -3796,6 +4678,8 @@ _cl5WriteOperationTxn(cldb_Handle *cldb, const slapi_operation_parameters *op, v
                           "_cl5WriteOperationTxn - Failed to write entry; db error - %d %s\n",
                           rc, dblayer_strerror(rc));
             rc = CL5_DB_ERROR;
+        } else {
+            _cl5SegmentsAdd(cldb, op->csn, entry.time);
         }
         goto done;
     }
@@ -3880,6 +4764,7 @@ _cl5WriteOperationTxn(cldb_Handle *cldb, const slapi_operation_parameters *op, v
 
     /* update entry count - we assume that all entries are new */
     PR_AtomicIncrement(&cldb->entryCount);
+    _cl5SegmentsAdd(cldb, op->csn, entry.time);
 
     /* update purge vector if we have not seen any changes from this replica before */
     _cl5UpdateRUV(cldb, op->csn, PR_TRUE, PR_TRUE);
@@ -3918,7 +4803,7 @@ cl5HelperEntry(const char *csnstr, CSN *csnp)
     }
     csnTime = csn_get_time(csn);
 
-    if (csnTime == ENTRY_COUNT_TIME || csnTime == PURGE_RUV_TIME) {
+    if (csnTime == ENTRY_COUNT_TIME || csnTime == PURGE_RUV_TIME || csnTime == SEGMENTS_TIME) {
         retval = PR_TRUE;
     }
 
@@ -4403,6 +5288,7 @@ _cl5WriteReplicaRUV(Replica *r, void *arg)
     }
 
     _cl5WriteEntryCount(cldb);
+    _cl5WriteSegments(cldb);
     rc = _cl5WriteRUV(cldb, PR_TRUE);
     rc |= _cl5WriteRUV(cldb, PR_FALSE);
     ruv_destroy(&cldb->maxRUV);
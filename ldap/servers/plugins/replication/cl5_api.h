@@ -200,6 +200,21 @@ int cl5ImportLDIF(const char *clDir, const char *ldifFile, Replica *replica);
  */
 int cl5ConfigTrimming(Replica *replica, int maxEntries, const char *maxAge, int trimInterval);
 
+/* Name:        cl5ConfigCompression
+   Description: enables or disables the compression of the changes written
+                from now on
+   Parameters:  compression - 0 to disable the compression
+   Return:      CL5_SUCCESS if successful;
+                CL5_BAD_STATE if changelog has not been open
+ */
+int cl5ConfigCompression(Replica *replica, int compression);
+
+/* Name:        cl5GetCompressionStats
+   Description: adds the changelog compression statistics to a replica
+                monitor entry
+ */
+void cl5GetCompressionStats(Replica *replica, Slapi_Entry *e);
+
 void cl5DestroyIterator(void *iterator);
 
 /* Name:        cl5WriteOperationTxn
@@ -319,6 +334,19 @@ int cl5CreateDirIfNeeded(const char *dir);
 int cl5DBData2Entry(const char *data, PRUint32 len, CL5Entry *entry, void *clcrypt_handle);
 
 PRBool cl5HelperEntry(const char *csnstr, CSN *csn);
+
+/* Name: cl5GetRidNextCSN
+   Description: looks up in the changelog segment index where the first change
+                of a replica after a csn is.
+   Parameters:  cldb - changelog
+                rid - replica id of the change
+                csn - csn after which the change is looked up
+                next - set to a csn such that the changelog holds no change
+                       of rid between csn and next
+   Return:      CL5_SUCCESS if next is set,
+                CL5_NOTFOUND if the changelog holds no change of rid after csn
+ */
+int cl5GetRidNextCSN(cldb_Handle *cldb, ReplicaId rid, const CSN *csn, CSN *next);
 CSN **cl5BuildCSNList(const RUV *consRuv, const RUV *supRuv);
 void cl5DestroyCSNList(CSN ***csns);
 
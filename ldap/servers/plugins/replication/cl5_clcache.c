@@ -33,6 +33,19 @@
 #define DEFAULT_CLC_BUFFER_PAGE_SIZE 1024
 #define WORK_CLC_BUFFER_PAGE_SIZE 8 * DEFAULT_CLC_BUFFER_PAGE_SIZE
 
+/*
+ * Bytes of decoded changes shared by the agreements of a changelog.
+ * Agreements close to each other in the changelog replay the same
+ * changes within a short time, each of them used to decode (and decrypt)
+ * its own copy of the record.
+ * Only the decoding is shared: there is no read-ahead of the changelog,
+ * each agreement still reads the records itself in bulk loads.
+ * A change is accounted for the size of its record, a change larger than
+ * a quarter of the cache is not kept.
+ */
+#define CLC_CHANGE_CACHE_BYTES (8 * 1024 * 1024)
+#define CLC_CHANGE_CACHE_HASH 1024
+
 enum
 {
     CLC_STATE_READY = 0,         /* ready to iterate */
@@ -45,6 +58,7 @@ enum
 };
 
 typedef struct clc_busy_list CLC_Busy_List;
+typedef struct clc_change CLC_Change;
 
 struct csn_seq_ctrl_block
 {
@@ -67,6 +81,7 @@ struct clc_buffer
     ReplicaId buf_consumer_rid;  /* help checking threshold csn */
     const RUV *buf_consumer_ruv; /* used to skip change */
     const RUV *buf_local_ruv;    /* used to refresh local_maxcsn */
+    cldb_Handle *buf_cldb;       /* changelog, for its segment index */
     int buf_ignoreConsumerRID;   /* how to handle updates from consumer */
     int buf_load_cnt;            /* number of loads for session */
 
@@ -96,6 +111,7 @@ struct clc_buffer
     int buf_skipped_up_to_date;         /* number of changes skipped due to consumer being up-to-date for the given rid */
     int buf_skipped_csn_gt_ruv;         /* number of changes skipped due to preceedents are not covered by local RUV snapshot */
     int buf_skipped_csn_covered;        /* number of changes skipped due to CSNs already covered by consumer RUV */
+    int buf_change_hits;                /* number of changes found already decoded */
 
     /*
      * fields that should be accessed via bl_lock or pl_lock
@@ -112,8 +128,34 @@ struct clc_busy_list
     PRLock *bl_lock;
     dbi_db_t *bl_db;        /* changelog db handle */
     CLC_Buffer *bl_buffers; /* busy buffers of this list */
+    int32_t bl_buffer_cnt;  /* number of buffers of this list in a replay session, atomic */
     CLC_Busy_List *bl_next; /* next busy list in the pool */
     Slapi_Backend *bl_be;   /* backend (to use dbimpl API) */
+
+    /*
+     * decoded changes shared by the buffers, accessed via bl_changes_lock
+     */
+    PRLock *bl_changes_lock;
+    PLHashTable *bl_changes;      /* csn string -> CLC_Change */
+    CLC_Change *bl_changes_head;  /* most recently used */
+    CLC_Change *bl_changes_tail;  /* least recently used */
+    size_t bl_changes_size;       /* bytes accounted for the changes */
+};
+
+/*
+ * A decoded changelog record. A change evicted while an agreement is
+ * copying it is freed by the last reader.
+ */
+struct clc_change
+{
+    char ch_csn[CSN_STRSIZE];
+    slapi_operation_parameters *ch_op;
+    time_t ch_time;
+    size_t ch_size; /* accounted in bl_changes_size */
+    int ch_refcnt;  /* readers copying ch_op */
+    int ch_evicted; /* no longer in bl_changes */
+    CLC_Change *ch_prev;
+    CLC_Change *ch_next;
 };
 
 /*
@@ -135,6 +177,7 @@ static struct clc_pool *_pool = NULL; /* process's buffer pool */
 /* static prototypes */
 static int clcache_initial_anchorcsn(CLC_Buffer *buf, dbi_op_t *dbop);
 static int clcache_adjust_anchorcsn(CLC_Buffer *buf, dbi_op_t *dbop);
+static int clcache_jump_anchorcsn(CLC_Buffer *buf);
 static void clcache_refresh_consumer_maxcsns(CLC_Buffer *buf);
 static int clcache_refresh_local_maxcsns(CLC_Buffer *buf);
 static int clcache_skip_change(CLC_Buffer *buf);
@@ -149,6 +192,8 @@ static CLC_Busy_List *clcache_new_busy_list(void);
 static void clcache_delete_busy_list(CLC_Busy_List **bl);
 static int clcache_enqueue_busy_list(Replica *replica, dbi_db_t *db, CLC_Buffer *buf);
 static void csn_dup_or_init_by_csn(CSN **csn1, CSN *csn2);
+static void clcache_free_change(CLC_Change **change);
+static void clcache_unlink_change(CLC_Busy_List *bl, CLC_Change *change);
 
 /*
  * Initiates the process buffer pool. This should be done
@@ -232,6 +277,7 @@ clcache_get_buffer(Replica *replica, CLC_Buffer **buf, dbi_db_t *db, ReplicaId c
         (*buf)->buf_skipped_up_to_date = 0;
         (*buf)->buf_skipped_csn_gt_ruv = 0;
         (*buf)->buf_skipped_csn_covered = 0;
+        (*buf)->buf_change_hits = 0;
         (*buf)->buf_cscbs = (struct csn_seq_ctrl_block **)slapi_ch_calloc(MAX_NUM_OF_SUPPLIERS + 1,
                                                                           sizeof(struct csn_seq_ctrl_block *));
         (*buf)->buf_num_cscbs = 0;
@@ -257,8 +303,14 @@ clcache_get_buffer(Replica *replica, CLC_Buffer **buf, dbi_db_t *db, ReplicaId c
     if (NULL != *buf) {
         CSN *c_csn = NULL;
         CSN *l_csn = NULL;
+        /*
+         * The buffers of the agreements stay in the busy list, only count
+         * the sessions in progress: they are the ones sharing the changes.
+         */
+        slapi_atomic_incr_32(&(*buf)->buf_busy_list->bl_buffer_cnt, __ATOMIC_RELAXED);
         (*buf)->buf_consumer_ruv = consumer_ruv;
         (*buf)->buf_local_ruv = local_ruv;
+        (*buf)->buf_cldb = (cldb_Handle *)replica_get_cl_info(replica);
         ruv_get_largest_csn_for_replica(consumer_ruv, consumer_rid, &c_csn);
         ruv_get_largest_csn_for_replica(local_ruv, consumer_rid, &l_csn);
         if (l_csn && csn_compare(l_csn, c_csn) > 0) {
@@ -291,20 +343,22 @@ clcache_return_buffer(CLC_Buffer **buf)
     slapi_log_err(SLAPI_LOG_REPL, (*buf)->buf_agmt_name,
                   "clcache_return_buffer - session end: state=%d load=%d sent=%d skipped=%d skipped_new_rid=%d "
                   "skipped_csn_gt_cons_maxcsn=%d skipped_up_to_date=%d "
-                  "skipped_csn_gt_ruv=%d skipped_csn_covered=%d\n",
+                  "skipped_csn_gt_ruv=%d skipped_csn_covered=%d shared_decoded=%d\n",
                   (*buf)->buf_state,
                   (*buf)->buf_load_cnt,
                   (*buf)->buf_record_cnt - (*buf)->buf_record_skipped,
                   (*buf)->buf_record_skipped, (*buf)->buf_skipped_new_rid,
                   (*buf)->buf_skipped_csn_gt_cons_maxcsn,
                   (*buf)->buf_skipped_up_to_date, (*buf)->buf_skipped_csn_gt_ruv,
-                  (*buf)->buf_skipped_csn_covered);
+                  (*buf)->buf_skipped_csn_covered, (*buf)->buf_change_hits);
 
     for (i = 0; i < (*buf)->buf_num_cscbs; i++) {
         clcache_free_cscb(&(*buf)->buf_cscbs[i]);
     }
     slapi_ch_free((void **)&(*buf)->buf_cscbs);
 
+    slapi_atomic_decr_32(&(*buf)->buf_busy_list->bl_buffer_cnt, __ATOMIC_RELAXED);
+
     dblayer_cursor_op(&(*buf)->buf_cursor, DBI_OP_CLOSE, NULL, NULL);
 }
 
@@ -328,6 +382,7 @@ clcache_load_buffer(CLC_Buffer *buf, CSN **anchorCSN, int *continue_on_miss, cha
     int rc = 0;
     dbi_op_t dbop = DBI_OP_NEXT;
     CSN limit_csn = {0};
+    int jumped = 0;
 
     if (anchorCSN)
         *anchorCSN = NULL;
@@ -336,6 +391,9 @@ clcache_load_buffer(CLC_Buffer *buf, CSN **anchorCSN, int *continue_on_miss, cha
     if (buf->buf_load_cnt == 0) {
         clcache_refresh_consumer_maxcsns(buf);
         rc = clcache_initial_anchorcsn(buf, &dbop);
+        if (rc == 0) {
+            jumped = clcache_jump_anchorcsn(buf);
+        }
     } else {
         rc = clcache_adjust_anchorcsn(buf, &dbop);
     }
@@ -369,7 +427,12 @@ clcache_load_buffer(CLC_Buffer *buf, CSN **anchorCSN, int *continue_on_miss, cha
         buf->buf_state = CLC_STATE_READY;
         if (anchorCSN)
             *anchorCSN = buf->buf_current_csn;
-        rc = clcache_load_buffer_bulk(buf, dbop);
+        rc = clcache_load_buffer_bulk(buf, jumped ? DBI_OP_MOVE_NEAR_KEY : dbop);
+        if (rc == DBI_RC_NOTFOUND && jumped) {
+            /* the segment index was wrong, load from the anchor csn */
+            csn_as_string(buf->buf_current_csn, 0, (char *)buf->buf_key.data);
+            rc = clcache_load_buffer_bulk(buf, dbop);
+        }
 
         if (rc == DBI_RC_NOTFOUND && continue_on_miss && *continue_on_miss) {
             /* make replication going using next best startcsn */
@@ -567,6 +630,136 @@ clcache_get_next_change(CLC_Buffer *buf, void **key, size_t *keylen, void **data
     return rc;
 }
 
+/*
+ * Decodes the change returned by clcache_get_next_change into entry.
+ *
+ * The agreements of a changelog share the decoded changes: the first one
+ * to replay a change decodes the record and keeps a copy in the busy list,
+ * the others only duplicate that copy. With a single agreement the record
+ * is simply decoded.
+ *
+ * The caller owns entry->op, see cl5_operation_parameters_done.
+ */
+int
+clcache_decode_change(CLC_Buffer *buf, const CSN *csn, const char *data, size_t datalen, CL5Entry *entry, void *clcrypt_handle)
+{
+    CLC_Busy_List *bl = buf->buf_busy_list;
+    CLC_Change *change = NULL;
+    slapi_operation_parameters *sop = NULL;
+    char csnstr[CSN_STRSIZE];
+    int rc;
+
+    if (bl == NULL || bl->bl_changes == NULL || slapi_atomic_load_32(&bl->bl_buffer_cnt, __ATOMIC_RELAXED) < 2) {
+        return cl5DBData2Entry(data, datalen, entry, clcrypt_handle);
+    }
+    csn_as_string(csn, PR_FALSE, csnstr);
+
+    PR_Lock(bl->bl_changes_lock);
+    change = (CLC_Change *)PL_HashTableLookup(bl->bl_changes, csnstr);
+    if (change) {
+        change->ch_refcnt++;
+        /* move it at the head of the lru */
+        clcache_unlink_change(bl, change);
+        change->ch_next = bl->bl_changes_head;
+        if (bl->bl_changes_head) {
+            bl->bl_changes_head->ch_prev = change;
+        } else {
+            bl->bl_changes_tail = change;
+        }
+        bl->bl_changes_head = change;
+    }
+    PR_Unlock(bl->bl_changes_lock);
+
+    if (change) {
+        /* copy outside of the lock, the change can't be freed meanwhile */
+        sop = operation_parameters_dup(change->ch_op);
+        memcpy(entry->op, sop, sizeof(slapi_operation_parameters));
+        slapi_ch_free((void **)&sop);
+        entry->time = change->ch_time;
+        buf->buf_change_hits++;
+
+        PR_Lock(bl->bl_changes_lock);
+        change->ch_refcnt--;
+        if (change->ch_evicted && change->ch_refcnt == 0) {
+            clcache_free_change(&change);
+        }
+        PR_Unlock(bl->bl_changes_lock);
+        return CL5_SUCCESS;
+    }
+
+    rc = cl5DBData2Entry(data, datalen, entry, clcrypt_handle);
+    if (rc != CL5_SUCCESS) {
+        return rc;
+    }
+    if (sizeof(CLC_Change) + datalen > CLC_CHANGE_CACHE_BYTES / 4) {
+        /* it would evict most of the other changes */
+        return CL5_SUCCESS;
+    }
+
+    change = (CLC_Change *)slapi_ch_calloc(1, sizeof(CLC_Change));
+    memcpy(change->ch_csn, csnstr, sizeof(change->ch_csn));
+    change->ch_op = operation_parameters_dup(entry->op);
+    change->ch_time = entry->time;
+    change->ch_size = sizeof(CLC_Change) + datalen;
+
+    PR_Lock(bl->bl_changes_lock);
+    if (PL_HashTableLookup(bl->bl_changes, change->ch_csn)) {
+        /* another agreement decoded it meanwhile */
+        PR_Unlock(bl->bl_changes_lock);
+        clcache_free_change(&change);
+        return CL5_SUCCESS;
+    }
+    while (bl->bl_changes_size + change->ch_size > CLC_CHANGE_CACHE_BYTES && bl->bl_changes_tail) {
+        CLC_Change *old = bl->bl_changes_tail;
+
+        clcache_unlink_change(bl, old);
+        PL_HashTableRemove(bl->bl_changes, old->ch_csn);
+        bl->bl_changes_size -= old->ch_size;
+        old->ch_evicted = 1;
+        if (old->ch_refcnt == 0) {
+            clcache_free_change(&old);
+        }
+    }
+    PL_HashTableAdd(bl->bl_changes, change->ch_csn, change);
+    change->ch_next = bl->bl_changes_head;
+    if (bl->bl_changes_head) {
+        bl->bl_changes_head->ch_prev = change;
+    } else {
+        bl->bl_changes_tail = change;
+    }
+    bl->bl_changes_head = change;
+    bl->bl_changes_size += change->ch_size;
+    PR_Unlock(bl->bl_changes_lock);
+
+    return CL5_SUCCESS;
+}
+
+static void
+clcache_unlink_change(CLC_Busy_List *bl, CLC_Change *change)
+{
+    if (change->ch_prev) {
+        change->ch_prev->ch_next = change->ch_next;
+    } else {
+        bl->bl_changes_head = change->ch_next;
+    }
+    if (change->ch_next) {
+        change->ch_next->ch_prev = change->ch_prev;
+    } else {
+        bl->bl_changes_tail = change->ch_prev;
+    }
+    change->ch_prev = change->ch_next = NULL;
+}
+
+static void
+clcache_free_change(CLC_Change **change)
+{
+    if (change && *change) {
+        cl5_operation_parameters_done((*change)->ch_op);
+        slapi_ch_free((void **)&(*change)->ch_op);
+        slapi_ch_free((void **)change);
+    }
+}
+
 static void
 clcache_refresh_consumer_maxcsns(CLC_Buffer *buf)
 {
@@ -712,6 +905,73 @@ clcache_initial_anchorcsn(CLC_Buffer *buf, dbi_op_t *dbop)
     return buf->buf_state;
 }
 
+/*
+ * The initial anchor csn is the oldest change one of the RIDs has to send,
+ * the changes that follow it are read and skipped until the next change of
+ * each RID. The changelog segment index tells where the next change of
+ * each RID is: start the load at the oldest of them.
+ * The anchor csn is still looked up, to detect it is missing from the
+ * changelog as when the load starts from it.
+ *
+ * Returns 1 if buf_key is set after the anchor csn.
+ */
+static int
+clcache_jump_anchorcsn(CLC_Buffer *buf)
+{
+    struct csn_seq_ctrl_block *cscb;
+    Slapi_Backend *be = buf->buf_busy_list->bl_be;
+    dbi_val_t data = {0};
+    CSN jumpcsn = {0};
+    CSN next;
+    int found = 0;
+    int rc;
+    int i;
+
+    if (buf->buf_cldb == NULL) {
+        return 0;
+    }
+    for (i = 0; i < buf->buf_num_cscbs; i++) {
+        cscb = buf->buf_cscbs[i];
+        if (cscb->consumer_maxcsn == NULL) {
+            /* the consumer hasn't seen changes for this RID */
+            if (cscb->local_mincsn == NULL) {
+                continue;
+            }
+            next = *cscb->local_mincsn;
+        } else if (csn_compare(cscb->local_maxcsn, cscb->consumer_maxcsn) > 0) {
+            if (cl5GetRidNextCSN(buf->buf_cldb, cscb->rid, cscb->consumer_maxcsn, &next) != CL5_SUCCESS) {
+                return 0;
+            }
+        } else {
+            continue;
+        }
+        if (!found || csn_compare(&next, &jumpcsn) < 0) {
+            jumpcsn = next;
+            found = 1;
+        }
+    }
+    if (!found || csn_compare(&jumpcsn, buf->buf_current_csn) <= 0) {
+        return 0;
+    }
+
+    dblayer_value_init(be, &data);
+    rc = dblayer_db_op(be, buf->buf_busy_list->bl_db, NULL, DBI_OP_GET, &buf->buf_key, &data);
+    dblayer_value_free(be, &data);
+    if (rc != 0) {
+        return 0;
+    }
+    csn_as_string(&jumpcsn, 0, (char *)buf->buf_key.data);
+    buf->buf_key.size = CSN_STRSIZE;
+    if (slapi_is_loglevel_set(SLAPI_LOG_REPL)) {
+        char anchor[CSN_STRSIZE];
+        csn_as_string(buf->buf_current_csn, 0, anchor);
+        slapi_log_err(SLAPI_LOG_REPL, buf->buf_agmt_name,
+                      "clcache_jump_anchorcsn - anchor is %s, load starts at %s\n",
+                      anchor, (char *)buf->buf_key.data);
+    }
+    return 1;
+}
+
 static int
 clcache_adjust_anchorcsn(CLC_Buffer *buf, dbi_op_t *dbop)
 {
@@ -1001,6 +1261,12 @@ clcache_new_busy_list(void)
         if (NULL == (bl->bl_lock = PR_NewLock()))
             break;
 
+        if (NULL == (bl->bl_changes_lock = PR_NewLock()))
+            break;
+
+        bl->bl_changes = PL_NewHashTable(CLC_CHANGE_CACHE_HASH, PL_HashString, PL_CompareStrings,
+                                         PL_CompareValues, NULL, NULL);
+
         /*
         if ( NULL == (bl->bl_max_csn = csn_new ()) )
             break;
@@ -1032,6 +1298,19 @@ clcache_delete_busy_list(CLC_Busy_List **bl)
         }
         (*bl)->bl_buffers = NULL;
         (*bl)->bl_db = NULL;
+        while ((*bl)->bl_changes_head) {
+            CLC_Change *change = (*bl)->bl_changes_head;
+            clcache_unlink_change(*bl, change);
+            clcache_free_change(&change);
+        }
+        if ((*bl)->bl_changes) {
+            PL_HashTableDestroy((*bl)->bl_changes);
+            (*bl)->bl_changes = NULL;
+        }
+        if ((*bl)->bl_changes_lock) {
+            PR_DestroyLock((*bl)->bl_changes_lock);
+            (*bl)->bl_changes_lock = NULL;
+        }
         if ((*bl)->bl_lock) {
             PR_Unlock((*bl)->bl_lock);
             PR_DestroyLock((*bl)->bl_lock);
@@ -26,6 +26,7 @@ int clcache_get_buffer(Replica *replica, CLC_Buffer **buf, dbi_db_t *db, Replica
 int clcache_load_buffer(CLC_Buffer *buf, CSN **anchorCSN, int *continue_on_miss, char *initial_starting_csn);
 void clcache_return_buffer(CLC_Buffer **buf);
 int clcache_get_next_change(CLC_Buffer *buf, void **key, size_t *keylen, void **data, size_t *datalen, CSN **csn, char *initial_starting_csn);
+int clcache_decode_change(CLC_Buffer *buf, const CSN *csn, const char *data, size_t datalen, CL5Entry *entry, void *clcrypt_handle);
 void clcache_destroy(void);
 
 #endif
@@ -237,6 +237,7 @@ cldb_config_modify(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_Entry *entryAfter, in
     changelog5Config config;
     changelog5Config *originalConfig = NULL;
     Replica *replica = (Replica *)arg;
+    int compression = CL5_NUM_IGNORE;
 
 
     changelog5_extract_config(e, &config);
@@ -308,6 +309,21 @@ cldb_config_modify(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_Entry *entryAfter, in
                         *returncode = LDAP_UNWILLING_TO_PERFORM;
                         goto done;
                     }
+                } else if (strcasecmp(config_attr, CONFIG_CHANGELOG_COMPRESSION_ATTRIBUTE) == 0) {
+                    if (config_attr_value && strcasecmp(config_attr_value, "on") == 0) {
+                        compression = 1;
+                    } else if (config_attr_value && strcasecmp(config_attr_value, "off") == 0) {
+                        compression = 0;
+                    } else {
+                        if (returntext) {
+                            PR_snprintf(returntext, SLAPI_DSE_RETURNTEXT_SIZE,
+                                        "%s: invalid value \"%s\", must be \"on\" or \"off\"",
+                                        CONFIG_CHANGELOG_COMPRESSION_ATTRIBUTE,
+                                        config_attr_value ? config_attr_value : "null");
+                        }
+                        *returncode = LDAP_UNWILLING_TO_PERFORM;
+                        goto done;
+                    }
                 } else if (strcasecmp(config_attr, CONFIG_CHANGELOG_SYMMETRIC_KEY) == 0) {
                     slapi_ch_free_string(&config.symmetricKey);
                     config.symmetricKey = slapi_ch_strdup(config_attr_value);
@@ -341,6 +357,17 @@ cldb_config_modify(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_Entry *entryAfter, in
             config.maxAge = slapi_ch_strdup(originalConfig->maxAge);
     }
 
+    if (compression != CL5_NUM_IGNORE) {
+        rc = cl5ConfigCompression(replica, compression);
+        if (rc != CL5_SUCCESS) {
+            *returncode = 1;
+            if (returntext) {
+                PR_snprintf(returntext, SLAPI_DSE_RETURNTEXT_SIZE, "failed to configure changelog compression; error - %d", rc);
+            }
+            goto done;
+        }
+    }
+
     /* one of the changelog parameters is modified */
     if (config.maxEntries != CL5_NUM_IGNORE ||
         config.trimInterval != CL5_NUM_IGNORE ||
@@ -442,6 +469,11 @@ changelog5_extract_config(Slapi_Entry *entry, changelog5Config *config)
         config->maxAge = slapi_ch_strdup(CL5_STR_IGNORE);
     }
 
+    arg = slapi_entry_attr_get_ref(entry, CONFIG_CHANGELOG_COMPRESSION_ATTRIBUTE);
+    if (arg && strcasecmp(arg, "on") == 0) {
+        config->compression = 1;
+    }
+
     /*
      * changelog encryption
      */
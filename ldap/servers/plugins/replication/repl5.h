@@ -67,6 +67,16 @@
  * new set of start and response extops. */
 #define REPL_START_NSDS90_REPLICATION_REQUEST_OID "2.16.840.1.113730.3.5.12"
 #define REPL_NSDS90_REPLICATION_RESPONSE_OID      "2.16.840.1.113730.3.5.13"
+/* Total update shipping a snapshot of the supplier databases instead of the
+ * entries. The consumer stores the database records as they are, so there is
+ * no import nor reindexing. The chunk extop is also the way the supplier finds
+ * out if the consumer supports it. */
+#define REPL_NSDS_SNAPSHOT_TOTAL_PROTOCOL_OID     "2.16.840.1.113730.3.6.10"
+#define REPL_NSDS_SNAPSHOT_CHUNK_REQUEST_OID      "2.16.840.1.113730.3.5.17"
+/* Total update sending several entries, zlib compressed, in each extop */
+#define REPL_NSDS_BATCH_ENTRIES_REQUEST_OID       "2.16.840.1.113730.3.5.18"
+#define REPL_IS_TOTAL_PROTOCOL_OID(oid) ((strcmp(REPL_NSDS50_TOTAL_PROTOCOL_OID, (oid)) == 0) || \
+                                         (strcmp(REPL_NSDS_SNAPSHOT_TOTAL_PROTOCOL_OID, (oid)) == 0))
 /* cleanallruv extended ops */
 #define REPL_CLEANRUV_OID              "2.16.840.1.113730.3.6.5"
 #define REPL_ABORT_CLEANRUV_OID        "2.16.840.1.113730.3.6.6"
@@ -126,6 +136,8 @@
 
 #define DEFAULT_PROTOCOL_TIMEOUT 120
 #define DEFAULT_REPLICA_KEEPALIVE_UPDATE_INTERVAL 3600
+#define DEFAULT_REPLICA_APPLY_THREADS 1
+#define REPLICA_APPLY_THREADS_MAX 64
 #define REPLICA_KEEPALIVE_UPDATE_INTERVAL_MIN 60
 
 /* To Allow Consumer Initialization when adding an agreement - */
@@ -161,6 +173,7 @@ extern const char *type_nsds5ReplicaFlowControlWindow;
 extern const char *type_nsds5ReplicaFlowControlPause;
 extern const char *type_replicaProtocolTimeout;
 extern const char *type_replicaReleaseTimeout;
+extern const char *type_replicaApplyThreads;
 extern const char *type_replicaBackoffMin;
 extern const char *type_replicaBackoffMax;
 extern const char *type_replicaPrecisePurge;
@@ -195,6 +208,11 @@ extern const char *type_nsds5BeginReplicaRefresh;
 /* For tuning replica release */
 extern const char *type_nsds5WaitForAsyncResults;
 
+/* Total update mode of an agreement */
+extern const char *type_nsds5ReplicaInitMode;
+#define REPL_INIT_MODE_ENTRY    0 /* Send the entries, the consumer rebuilds the indexes */
+#define REPL_INIT_MODE_SNAPSHOT 1 /* Send a snapshot of the databases */
+
 /* replica related attributes */
 extern const char *attr_replicaId;
 extern const char *attr_replicaRoot;
@@ -295,6 +313,17 @@ struct berval *NSDS90StartReplicationRequest_new(const char *protocol_oid,
 
 /* In repl5_total.c */
 int multisupplier_extop_NSDS50ReplicationEntry(Slapi_PBlock *pb);
+size_t snapshot_record_size(const back_info_snapshot_record *rec);
+char *snapshot_record_put(char *p, const back_info_snapshot_record *rec);
+struct berval *snapshot_chunk2bv(const char *records, size_t len);
+typedef struct tot_batch Tot_Batch;
+Tot_Batch *tot_batch_new(void);
+void tot_batch_free(Tot_Batch **batch);
+int tot_batch_add_entry(Tot_Batch *batch, BerElement *bere);
+PRBool tot_batch_is_full(const Tot_Batch *batch);
+size_t tot_batch_count(const Tot_Batch *batch);
+struct berval *tot_batch2bv(Tot_Batch *batch);
+void tot_batch_decoder_free(void **decoder);
 
 /* From repl_globals.c */
 extern char *repl_changenumber;
@@ -482,6 +511,8 @@ void add_agmt_maxcsns(Slapi_Entry *e, Replica *r);
 void agmt_remove_maxcsn(Repl_Agmt *ra);
 int agmt_maxcsn_to_smod(Replica *r, Slapi_Mod *smod);
 int agmt_set_WaitForAsyncResults(Repl_Agmt *ra, const Slapi_Entry *e);
+int agmt_set_init_mode(Repl_Agmt *ra, const Slapi_Entry *e);
+int agmt_get_init_mode(Repl_Agmt *ra);
 
 /* In repl5_agmtlist.c */
 int agmtlist_config_init(void);
@@ -552,6 +583,8 @@ typedef struct consumer_connection_extension
     Slapi_Connection *connection;
     PRLock *lock;    /* protects entire structure */
     int in_use_opid; /* the id of the operation actively using this, else -1 */
+    back_info_snapshot *snapshot; /* backend state of a snapshot total update */
+    void *batch_decoder;          /* decompression stream of the batched total update */
 } consumer_connection_extension;
 
 /* extension construct/destructor */
@@ -562,6 +595,10 @@ void consumer_connection_extension_destructor(void *ext, void *object, void *par
 consumer_connection_extension *consumer_connection_extension_acquire_exclusive_access(void *conn, uint64_t connid, int opid);
 int consumer_connection_extension_relinquish_exclusive_access(void *conn, uint64_t connid, int opid, PRBool force);
 
+/* snapshot total update, in repl5_total.c */
+int consumer_snapshot_start(consumer_connection_extension *connext, const Slapi_DN *repl_root_sdn);
+int consumer_snapshot_done(consumer_connection_extension *connext, const Slapi_DN *repl_root_sdn, PRBool abort);
+
 /* mapping tree extension - stores replica object */
 typedef struct multisupplier_mtnode_extension
 {
@@ -605,7 +642,11 @@ typedef enum {
     CONN_IS_WIN2K3,
     CONN_NOT_WIN2K3,
     CONN_SUPPORTS_DS90_REPL,
-    CONN_DOES_NOT_SUPPORT_DS90_REPL
+    CONN_DOES_NOT_SUPPORT_DS90_REPL,
+    CONN_SUPPORTS_SNAPSHOT_INIT,
+    CONN_DOES_NOT_SUPPORT_SNAPSHOT_INIT,
+    CONN_SUPPORTS_BATCH_INIT,
+    CONN_DOES_NOT_SUPPORT_BATCH_INIT
 } ConnResult;
 
 char *conn_result2string(int result);
@@ -626,6 +667,8 @@ void conn_cancel_linger(Repl_Connection *conn);
 ConnResult conn_replica_supports_ds5_repl(Repl_Connection *conn);
 ConnResult conn_replica_supports_ds71_repl(Repl_Connection *conn);
 ConnResult conn_replica_supports_ds90_repl(Repl_Connection *conn);
+ConnResult conn_replica_supports_snapshot_init(Repl_Connection *conn);
+ConnResult conn_replica_supports_batch_init(Repl_Connection *conn);
 ConnResult conn_replica_is_readonly(Repl_Connection *conn);
 
 ConnResult conn_read_entry_attribute(Repl_Connection *conn, const char *dn, char *type, struct berval ***returned_bvals);
@@ -770,6 +813,11 @@ uint64_t replica_get_protocol_timeout(Replica *r);
 void replica_set_protocol_timeout(Replica *r, uint64_t timeout);
 uint64_t replica_get_release_timeout(Replica *r);
 void replica_set_release_timeout(Replica *r, uint64_t timeout);
+uint64_t replica_get_apply_threads(Replica *r);
+void replica_set_apply_threads(Replica *r, uint64_t nthreads);
+void replica_update_apply_stats(Replica *r, int32_t inflight, int32_t dep_waited);
+void replica_update_apply_lag(Replica *r, const CSN *csn);
+void replica_get_apply_stats(Replica *r, Slapi_Entry *e);
 void replica_set_groupdn_checkinterval(Replica *r, int timeout);
 uint64_t replica_get_backoff_min(Replica *r);
 uint64_t replica_get_backoff_max(Replica *r);
@@ -149,6 +149,7 @@ typedef struct repl5agmt
     Slapi_RWLock *attr_lock;           /* RW lock for all the stripped attrs */
     int64_t WaitForAsyncResults;       /* Pass to DS_Sleep(PR_MillisecondsToInterval(WaitForAsyncResults))
                                         * in repl5_inc_waitfor_async_results */
+    int64_t initMode;                  /* REPL_INIT_MODE_xxx: how the consumer is initialized */
     char *bootstrapBindDN;             /* Bootstrap bind dn */
     struct berval *bootstrapCreds;     /* Bootstrap credentials */
     int64_t bootstrapBindmethod;       /* Bootstrap Bind Method: simple, TLS, client auth, etc */
@@ -405,6 +406,7 @@ agmt_new_from_entry(Slapi_Entry *e)
     ra->transport_flags = 0;
     (void)agmt_set_transportinfo_no_lock(ra, e);
     (void)agmt_set_WaitForAsyncResults(ra, e);
+    (void)agmt_set_init_mode(ra, e);
 
     /* DN to use when binding. May be empty if certain SASL auth is to be used e.g. EXTERNAL GSSAPI. */
     ra->binddn = slapi_entry_attr_get_charptr(e, type_nsds5ReplicaBindDN);
@@ -2094,6 +2096,32 @@ agmt_get_WaitForAsyncResults(Repl_Agmt *ra)
     return ra->WaitForAsyncResults;
 }
 
+int
+agmt_set_init_mode(Repl_Agmt *ra, const Slapi_Entry *e)
+{
+    const char *mode = NULL;
+    if (e) {
+        mode = slapi_entry_attr_get_ref((Slapi_Entry *)e, type_nsds5ReplicaInitMode);
+    }
+    if (mode && strcasecmp(mode, "snapshot") == 0) {
+        ra->initMode = REPL_INIT_MODE_SNAPSHOT;
+    } else {
+        if (mode && strcasecmp(mode, "entry") != 0) {
+            slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name, "agmt_set_init_mode - "
+                          "%s: invalid value (%s) for %s, the entries are sent during the total update\n",
+                          slapi_entry_get_dn_const(e), mode, type_nsds5ReplicaInitMode);
+        }
+        ra->initMode = REPL_INIT_MODE_ENTRY;
+    }
+    return 0;
+}
+
+int
+agmt_get_init_mode(Repl_Agmt *ra)
+{
+    return ra->initMode;
+}
+
 int
 agmt_set_transportinfo_from_entry(Repl_Agmt *ra, const Slapi_Entry *e, PRBool bootstrap)
 {
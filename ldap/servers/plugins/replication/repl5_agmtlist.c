@@ -608,6 +608,12 @@ agmtlist_modify_callback(Slapi_PBlock *pb,
             } else {
                 (void)agmt_set_WaitForAsyncResults(agmt, e);
             }
+        } else if (slapi_attr_types_equivalent(mods[i]->mod_type, type_nsds5ReplicaInitMode)) {
+            if (mods[i]->mod_op & LDAP_MOD_DELETE) {
+                (void)agmt_set_init_mode(agmt, NULL);
+            } else {
+                (void)agmt_set_init_mode(agmt, e);
+            }
         } else if ((0 == windows_handle_modify_agreement(agmt, mods[i]->mod_type, e)) &&
                    (0 == id_extended_agreement(agmt, mods, e))) {
             slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name, "agmtlist_modify_callback - "
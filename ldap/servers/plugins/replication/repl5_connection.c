@@ -48,6 +48,8 @@ typedef struct repl_connection
     int supports_ds40_repl; /* 1 if does, 0 if doesn't, -1 if not determined */
     int supports_ds71_repl; /* 1 if does, 0 if doesn't, -1 if not determined */
     int supports_ds90_repl; /* 1 if does, 0 if doesn't, -1 if not determined */
+    int supports_snapshot_init; /* 1 if does, 0 if doesn't, -1 if not determined */
+    int supports_batch_init;    /* 1 if does, 0 if doesn't, -1 if not determined */
     int linger_time;        /* time in seconds to leave an idle connection open */
     PRBool linger_active;
     Slapi_Eq_Context *linger_event;
@@ -162,6 +164,14 @@ conn_result2string(int result)
         return "consumer supports all DS90 extop";
     case CONN_DOES_NOT_SUPPORT_DS90_REPL:
         return "consumer does not support all DS90 extop";
+    case CONN_SUPPORTS_SNAPSHOT_INIT:
+        return "consumer supports snapshot total update";
+    case CONN_DOES_NOT_SUPPORT_SNAPSHOT_INIT:
+        return "consumer does not support snapshot total update";
+    case CONN_SUPPORTS_BATCH_INIT:
+        return "consumer supports batched total update";
+    case CONN_DOES_NOT_SUPPORT_BATCH_INIT:
+        return "consumer does not support batched total update";
     default:
         return NULL;
     }
@@ -194,6 +204,8 @@ conn_new(Repl_Agmt *agmt)
     rpc->supports_ds50_repl = -1;
     rpc->supports_ds71_repl = -1;
     rpc->supports_ds90_repl = -1;
+    rpc->supports_snapshot_init = -1;
+    rpc->supports_batch_init = -1;
 
     rpc->linger_active = PR_FALSE;
     rpc->delete_after_linger = PR_FALSE;
@@ -604,7 +616,10 @@ check_flow_control_tot_init(Repl_Connection *conn, int optype, const char *extop
     int rcv_msgid;
     int once;
 
-    if ((sent_msgid != 0) && (optype == CONN_EXTENDED_OPERATION) && (strcmp(extop_oid, REPL_NSDS50_REPLICATION_ENTRY_REQUEST_OID) == 0)) {
+    if ((sent_msgid != 0) && (optype == CONN_EXTENDED_OPERATION) &&
+        ((strcmp(extop_oid, REPL_NSDS50_REPLICATION_ENTRY_REQUEST_OID) == 0) ||
+         (strcmp(extop_oid, REPL_NSDS_BATCH_ENTRIES_REQUEST_OID) == 0) ||
+         (strcmp(extop_oid, REPL_NSDS_SNAPSHOT_CHUNK_REQUEST_OID) == 0))) {
         /* We are sending entries part of the total update of a consumer
          * Wait a bit if the consumer needs to catchup from the current sent entries
          */
@@ -1281,6 +1296,8 @@ close_connection_internal(Repl_Connection *conn)
     conn->supports_ds50_repl = -1;
     conn->supports_ds71_repl = -1;
     conn->supports_ds90_repl = -1;
+    conn->supports_snapshot_init = -1;
+    conn->supports_batch_init = -1;
     /* do this last, to minimize the chance that another thread
        might read conn->state as not disconnected and attempt
        to use conn->ld */
@@ -1490,6 +1507,111 @@ conn_replica_supports_ds90_repl(Repl_Connection *conn)
     return return_value;
 }
 
+/*
+ * Determine if the remote replica lists extop_oid in its supportedExtension.
+ * *supported caches the answer for the connection (1 if does, 0 if doesn't,
+ * -1 if not determined).
+ * Return codes:
+ * 1 - the remote replica supports it
+ * 0 - the remote replica does not support it
+ * CONN_OPERATION_FAILED - it could not be determined
+ * CONN_NOT_CONNECTED - no connection was active.
+ */
+static int
+conn_replica_supports_extop(Repl_Connection *conn, const char *extop_oid, int *supported)
+{
+    int return_value;
+    int ldap_rc;
+
+    PR_Lock(conn->lock);
+    if (conn_connected(conn)) {
+        if (*supported == -1) {
+            LDAPMessage *res = NULL;
+            LDAPMessage *entry = NULL;
+            char *attrs[] = {"supportedcontrol", "supportedextension", NULL};
+
+            conn->status = STATUS_SEARCHING;
+            ldap_rc = ldap_search_ext_s(conn->ld, "", LDAP_SCOPE_BASE,
+                                        "(objectclass=*)", attrs, 0 /* attrsonly */,
+                                        NULL /* server controls */, NULL /* client controls */,
+                                        &conn->timeout, LDAP_NO_LIMIT, &res);
+            if (LDAP_SUCCESS == ldap_rc) {
+                entry = ldap_first_entry(conn->ld, res);
+                *supported = attribute_string_value_present(conn->ld, entry, "supportedextension", extop_oid) ? 1 : 0;
+                return_value = *supported;
+            } else {
+                if (IS_DISCONNECT_ERROR(ldap_rc)) {
+                    conn->last_ldap_error = ldap_rc; /* specific reason */
+                    close_connection_internal(conn);
+                    return_value = CONN_NOT_CONNECTED;
+                } else {
+                    return_value = CONN_OPERATION_FAILED;
+                }
+            }
+            if (NULL != res)
+                ldap_msgfree(res);
+        } else {
+            return_value = *supported;
+        }
+    } else {
+        /* Not connected */
+        return_value = CONN_NOT_CONNECTED;
+    }
+    PR_Unlock(conn->lock);
+
+    return return_value;
+}
+
+/*
+ * Determine if the remote replica can be initialized with a snapshot of the
+ * supplier databases.
+ * Return codes:
+ * CONN_SUPPORTS_SNAPSHOT_INIT - the remote replica supports it
+ * CONN_DOES_NOT_SUPPORT_SNAPSHOT_INIT - the remote replica does not
+ * support it.
+ * CONN_OPERATION_FAILED - it could not be determined if the remote
+ * replica supports it.
+ * CONN_NOT_CONNECTED - no connection was active.
+ */
+ConnResult
+conn_replica_supports_snapshot_init(Repl_Connection *conn)
+{
+    int rc = conn_replica_supports_extop(conn, REPL_NSDS_SNAPSHOT_CHUNK_REQUEST_OID,
+                                         &conn->supports_snapshot_init);
+
+    if (rc == 1) {
+        return CONN_SUPPORTS_SNAPSHOT_INIT;
+    } else if (rc == 0) {
+        return CONN_DOES_NOT_SUPPORT_SNAPSHOT_INIT;
+    }
+    return rc;
+}
+
+/*
+ * Determine if the remote replica accepts several entries per extop during
+ * a total update.
+ * Return codes:
+ * CONN_SUPPORTS_BATCH_INIT - the remote replica supports it
+ * CONN_DOES_NOT_SUPPORT_BATCH_INIT - the remote replica does not
+ * support it.
+ * CONN_OPERATION_FAILED - it could not be determined if the remote
+ * replica supports it.
+ * CONN_NOT_CONNECTED - no connection was active.
+ */
+ConnResult
+conn_replica_supports_batch_init(Repl_Connection *conn)
+{
+    int rc = conn_replica_supports_extop(conn, REPL_NSDS_BATCH_ENTRIES_REQUEST_OID,
+                                         &conn->supports_batch_init);
+
+    if (rc == 1) {
+        return CONN_SUPPORTS_BATCH_INIT;
+    } else if (rc == 0) {
+        return CONN_DOES_NOT_SUPPORT_BATCH_INIT;
+    }
+    return rc;
+}
+
 /* Determine if the replica is read-only */
 ConnResult
 conn_replica_is_readonly(Repl_Connection *conn)
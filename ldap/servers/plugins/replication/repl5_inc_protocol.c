@@ -80,6 +80,8 @@ typedef struct result_data
     int stop_result_thread; /* Flag used to tell the result thread to exit */
     int last_message_id_sent;
     int last_message_id_received;
+    int num_updates_sent;     /* updates sent asynchronously in this session */
+    int num_results_received; /* results read for them, the consumer may answer out of order */
     int flowcontrol_detection;
     int result; /* The UPDATE_TRANSIENT_ERROR etc */
     int WaitForAsyncResults;
@@ -171,20 +173,29 @@ repl5_int_push_operation(result_data *rd, repl5_inc_operation *it)
     PR_Unlock(rd->lock);
 }
 
-/* Pop the next operation in line to respond from the list */
-/* The caller is expected to free the operation item */
+/*
+ * Remove the operation answered by message_id from the list. The consumer
+ * may apply the updates in parallel and answer them out of order, so the
+ * result goes to the operation with the same message id. The head of the
+ * list is returned when the result has no message id (connection error).
+ * The caller is expected to free the operation item.
+ */
 static repl5_inc_operation *
-repl5_inc_pop_operation(result_data *rd)
+repl5_inc_pop_operation(result_data *rd, int message_id)
 {
-    repl5_inc_operation *head = NULL;
+    repl5_inc_operation **prev = NULL;
+    repl5_inc_operation *prev_op = NULL;
     repl5_inc_operation *ret = NULL;
     PR_Lock(rd->lock);
-    head = rd->operation_list_head;
-    if (head) {
-        ret = head;
-        rd->operation_list_head = head->next;
-        if (rd->operation_list_tail == head) {
-            rd->operation_list_tail = NULL;
+    for (prev = &rd->operation_list_head; *prev; prev_op = *prev, prev = &(*prev)->next) {
+        if (message_id == 0 || (*prev)->ldap_message_id == message_id) {
+            ret = *prev;
+            *prev = ret->next;
+            if (rd->operation_list_tail == ret) {
+                rd->operation_list_tail = prev_op;
+            }
+            ret->next = NULL;
+            break;
         }
     }
     PR_Unlock(rd->lock);
@@ -311,12 +322,15 @@ repl5_inc_result_threadmain(void *param)
             int return_value;
             int should_finish = 0;
             if (message_id) {
-                rd->last_message_id_received = message_id;
+                if (message_id > rd->last_message_id_received) {
+                    rd->last_message_id_received = message_id;
+                }
+                rd->num_results_received++;
             }
             /* Handle any error etc */
 
             /* Get the stored operation details from the queue, unless we timed out... */
-            op = repl5_inc_pop_operation(rd);
+            op = repl5_inc_pop_operation(rd, message_id);
             if (op) {
                 csn_str = op->csn_str;
                 replica_id = op->replica_id;
@@ -457,8 +471,8 @@ static void
 repl5_inc_flow_control_results(Repl_Agmt *agmt, result_data *rd)
 {
     PR_Lock(rd->lock);
-    if ((rd->last_message_id_received <= rd->last_message_id_sent) &&
-        ((rd->last_message_id_sent - rd->last_message_id_received) >= agmt_get_flowcontrolwindow(agmt))) {
+    if ((rd->num_results_received <= rd->num_updates_sent) &&
+        ((rd->num_updates_sent - rd->num_results_received) >= agmt_get_flowcontrolwindow(agmt))) {
         rd->flowcontrol_detection++;
         PR_Unlock(rd->lock);
         DS_Sleep(PR_MillisecondsToInterval(agmt_get_flowcontrolpause(agmt)));
@@ -474,7 +488,7 @@ repl5_inc_waitfor_async_results(result_data *rd)
     int loops = 0;
     int rc = UPDATE_NO_MORE_UPDATES;
 
-    /* Keep pulling results off the LDAP connection until we catch up to the last message id stored in the rd */
+    /* Keep pulling results off the LDAP connection until we got one for each update sent */
     while (!done && !slapi_is_shutting_down()) {
         /* Lock the structure to force memory barrier */
         PR_Lock(rd->lock);
@@ -482,7 +496,7 @@ repl5_inc_waitfor_async_results(result_data *rd)
         slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name,
                       "repl5_inc_waitfor_async_results - sid=\"%s\" - %d %d\n",
                       agmt_get_session_id((Repl_Agmt *) rd->prp->agmt), rd->last_message_id_received, rd->last_message_id_sent);
-        if (rd->last_message_id_received >= rd->last_message_id_sent) {
+        if (rd->num_results_received >= rd->num_updates_sent) {
             /* If so then we're done */
             done = 1;
         } else if (rd->abort && (rd->result == UPDATE_CONNECTION_LOST)) {
@@ -1708,6 +1722,7 @@ send_updates(Private_Repl_Protocol *prp, RUV *remote_update_vector, PRUint32 *nu
                 replay_crc = replay_update(prp, entry.op, &message_id);
                 if (message_id) {
                     rd->last_message_id_sent = message_id;
+                    rd->num_updates_sent++;
                 }
                 /* If we're talking to an old non-async replica, we need to pick up the response here */
                 if (CONN_OPERATION_SUCCESS != replay_crc) {
@@ -60,6 +60,8 @@ static char *end_name_list[] = {
 static char *total_oid_list[] = {
     REPL_NSDS50_REPLICATION_ENTRY_REQUEST_OID,
     REPL_NSDS71_REPLICATION_ENTRY_REQUEST_OID,
+    REPL_NSDS_SNAPSHOT_CHUNK_REQUEST_OID,
+    REPL_NSDS_BATCH_ENTRIES_REQUEST_OID,
     NULL};
 static char *total_name_list[] = {
     NSDS_REPL_NAME_PREFIX " Total Update Entry",
@@ -1189,6 +1189,9 @@ process_postop(Slapi_PBlock *pb)
     slapi_pblock_get(pb, SLAPI_RESULT_CODE, &retval);
     if (retval == LDAP_SUCCESS) {
         agmtlist_notify_all(pb);
+        if (is_replicated_operation) {
+            replica_update_apply_lag(replica_get_replica_for_op(pb), opcsn);
+        }
         rc = SLAPI_PLUGIN_SUCCESS;
     } else if (opcsn) {
         rc = cancel_opcsn(pb);
@@ -1358,6 +1361,8 @@ process_operation(Slapi_PBlock *pb, const CSN *csn)
     Replica *r;
     Object *ruv_obj;
     RUV *ruv;
+    int32_t inflight;
+    int32_t dep_waited = 0;
     int rc;
 
     r = replica_get_replica_for_op(pb);
@@ -1376,7 +1381,14 @@ process_operation(Slapi_PBlock *pb, const CSN *csn)
     ruv = (RUV *)object_get_data(ruv_obj);
     PR_ASSERT(ruv);
 
+    /*
+     * If the session applies updates in parallel, the CSNs must still enter
+     * the pending list in the order the supplier sent them
+     */
+    inflight = slapi_op_repl_apply_turn(pb, &dep_waited);
     rc = ruv_add_csn_inprogress(r, ruv, csn);
+    slapi_op_repl_apply_passed(pb);
+    replica_update_apply_stats(r, inflight, dep_waited);
 
     object_release(ruv_obj);
 
@@ -72,7 +72,7 @@ extern Private_Repl_Protocol *Windows_Tot_Protocol_new(Repl_Protocol *rp);
 #define PROTOCOL_BUSY_BACKOFF_MAXIMUM PROTOCOL_BUSY_BACKOFF_MINIMUM
 
 /* protocol related functions */
-void release_replica(Private_Repl_Protocol *prp);
+int release_replica(Private_Repl_Protocol *prp);
 int acquire_replica(Private_Repl_Protocol *prp, char *prot_oid, RUV **ruv);
 BerElement *entry2bere(const Slapi_Entry *e, char **excluded_attrs);
 CSN *get_current_csn(Slapi_DN *replarea_sdn);
@@ -188,7 +188,7 @@ acquire_replica(Private_Repl_Protocol *prp, char *prot_oid, RUV **ruv)
                 struct berval *data = NULL;
 
                 /* Check if this is a total or incremental update. */
-                if (strcmp(REPL_NSDS50_TOTAL_PROTOCOL_OID, prot_oid) == 0) {
+                if (REPL_IS_TOTAL_PROTOCOL_OID(prot_oid)) {
                     is_total = 1;
                 }
 
@@ -334,8 +334,7 @@ acquire_replica(Private_Repl_Protocol *prp, char *prot_oid, RUV **ruv)
                         /* Someone else is updating the replica. Try later. */
                         /* if acquire_replica is called for replica
                            initialization, log REPLICA_BUSY, too */
-                        if (strcmp(REPL_NSDS50_TOTAL_PROTOCOL_OID,
-                                   prot_oid) == 0) {
+                        if (REPL_IS_TOTAL_PROTOCOL_OID(prot_oid)) {
                             slapi_log_err(SLAPI_LOG_NOTICE, repl_plugin_name,
                                           "acquire_replica - "
                                           "%s: Unable to acquire replica: "
@@ -393,7 +392,7 @@ acquire_replica(Private_Repl_Protocol *prp, char *prot_oid, RUV **ruv)
                             int is_total = 0;
 
                             /* Check if this is a total or incremental update. */
-                            if (strcmp(REPL_NSDS50_TOTAL_PROTOCOL_OID, prot_oid) == 0) {
+                            if (REPL_IS_TOTAL_PROTOCOL_OID(prot_oid)) {
                                 is_total = 1;
                             }
 
@@ -510,10 +509,12 @@ error:
 
 /*
  * Release a replica by sending an "end replication" extended request.
+ * Returns 0 if the consumer accepted the end of the session.
  */
-void
+int
 release_replica(Private_Repl_Protocol *prp)
 {
+    int rval = -1;
     int rc;
     struct berval *retdata = NULL;
     char *retoid = NULL;
@@ -527,7 +528,7 @@ release_replica(Private_Repl_Protocol *prp)
     PR_ASSERT(NULL != prp->conn);
 
     if (!prp->replica_acquired) {
-        return;
+        return 0;
     }
 
     replarea_sdn = agmt_get_replarea(prp->agmt);
@@ -586,6 +587,7 @@ release_replica(Private_Repl_Protocol *prp)
             if (NSDS50_REPL_REPLICA_RELEASE_SUCCEEDED == extop_result) {
                 slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name,
                               "release_replica - %s: Successfully released consumer\n", agmt_get_long_name(prp->agmt));
+                rval = 0;
             } else {
                 slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name,
                               "release_replica - %s: Unable to release consumer: response code %d\n",
@@ -614,6 +616,7 @@ release_replica(Private_Repl_Protocol *prp)
     conn_start_linger(prp->conn);
 error:
     prp->replica_acquired = PR_FALSE;
+    return rval;
 }
 
 /* converts consumer's response to a string */
@@ -65,6 +65,12 @@ struct replica
     Slapi_Counter *precise_purging;    /* Enable precise tombstone purging */
     uint64_t agmt_count;               /* Number of agmts */
     Slapi_Counter *release_timeout;    /* The amount of time to wait before releasing active replica */
+    Slapi_Counter *apply_threads;      /* Updates of a supplier session applied in parallel */
+    Slapi_Counter *apply_ops;          /* Updates applied through the parallel apply pipeline */
+    Slapi_Counter *apply_parallel_ops; /* ... while other updates of the session were in flight */
+    Slapi_Counter *apply_dep_waits;    /* ... after waiting for an update of the same, parent or child entry */
+    Slapi_Counter *apply_max_inflight; /* Highest number of updates in flight */
+    Slapi_Counter *apply_lag;          /* Age in seconds of the last replicated update applied */
     uint64_t abort_session;            /* Abort the current replica session */
     cldb_Handle *cldb;                 /* database info for the changelog */
     int64_t keepalive_update_interval; /* interval to do dummy update to keep RUV fresh */
@@ -189,6 +195,12 @@ replica_new_from_entry(Slapi_Entry *e, char *errortext, PRBool is_add_operation,
     /* init the slapi_counter/atomic settings */
     r->protocol_timeout = slapi_counter_new();
     r->release_timeout = slapi_counter_new();
+    r->apply_threads = slapi_counter_new();
+    r->apply_ops = slapi_counter_new();
+    r->apply_parallel_ops = slapi_counter_new();
+    r->apply_dep_waits = slapi_counter_new();
+    r->apply_max_inflight = slapi_counter_new();
+    r->apply_lag = slapi_counter_new();
     r->backoff_min = slapi_counter_new();
     r->backoff_max = slapi_counter_new();
     r->precise_purging = slapi_counter_new();
@@ -405,6 +417,12 @@ replica_destroy(void **arg)
 
     slapi_counter_destroy(&r->protocol_timeout);
     slapi_counter_destroy(&r->release_timeout);
+    slapi_counter_destroy(&r->apply_threads);
+    slapi_counter_destroy(&r->apply_ops);
+    slapi_counter_destroy(&r->apply_parallel_ops);
+    slapi_counter_destroy(&r->apply_dep_waits);
+    slapi_counter_destroy(&r->apply_max_inflight);
+    slapi_counter_destroy(&r->apply_lag);
     slapi_counter_destroy(&r->backoff_min);
     slapi_counter_destroy(&r->backoff_max);
     slapi_counter_destroy(&r->precise_purging);
@@ -1032,6 +1050,69 @@ replica_set_release_timeout(Replica *r, uint64_t limit)
     }
 }
 
+uint64_t
+replica_get_apply_threads(Replica *r)
+{
+    if (r) {
+        return slapi_counter_get_value(r->apply_threads);
+    } else {
+        return DEFAULT_REPLICA_APPLY_THREADS;
+    }
+}
+
+void
+replica_set_apply_threads(Replica *r, uint64_t nthreads)
+{
+    if (r) {
+        slapi_counter_set_value(r->apply_threads, nthreads);
+    }
+}
+
+/*
+ * Account an update that registered its CSN through the apply pipeline of a
+ * consumer session (see slapi_op_repl_apply_turn)
+ */
+void
+replica_update_apply_stats(Replica *r, int32_t inflight, int32_t dep_waited)
+{
+    if (r == NULL || inflight <= 0) {
+        return;
+    }
+    slapi_counter_increment(r->apply_ops);
+    if (inflight > 1) {
+        slapi_counter_increment(r->apply_parallel_ops);
+    }
+    if (dep_waited) {
+        slapi_counter_increment(r->apply_dep_waits);
+    }
+    if ((uint64_t)inflight > slapi_counter_get_value(r->apply_max_inflight)) {
+        slapi_counter_set_value(r->apply_max_inflight, inflight);
+    }
+}
+
+void
+replica_update_apply_lag(Replica *r, const CSN *csn)
+{
+    time_t now = slapi_current_utc_time();
+    time_t csn_time;
+
+    if (r == NULL || csn == NULL) {
+        return;
+    }
+    csn_time = csn_get_time(csn);
+    slapi_counter_set_value(r->apply_lag, (now > csn_time) ? now - csn_time : 0);
+}
+
+void
+replica_get_apply_stats(Replica *r, Slapi_Entry *e)
+{
+    slapi_entry_attr_set_ulong(e, "nsds5replicaApplyOps", slapi_counter_get_value(r->apply_ops));
+    slapi_entry_attr_set_ulong(e, "nsds5replicaApplyParallelOps", slapi_counter_get_value(r->apply_parallel_ops));
+    slapi_entry_attr_set_ulong(e, "nsds5replicaApplyDependencyWaits", slapi_counter_get_value(r->apply_dep_waits));
+    slapi_entry_attr_set_ulong(e, "nsds5replicaApplyMaxInFlight", slapi_counter_get_value(r->apply_max_inflight));
+    slapi_entry_attr_set_ulong(e, "nsds5replicaApplyLag", slapi_counter_get_value(r->apply_lag));
+}
+
 void
 replica_set_protocol_timeout(Replica *r, uint64_t timeout)
 {
@@ -1950,6 +2031,7 @@ _replica_init_from_config(Replica *r, Slapi_Entry *e, char *errortext)
     int64_t backoff_max;
     int64_t ptimeout = 0;
     int64_t release_timeout = 0;
+    int64_t apply_threads = 0;
     int64_t interval = 0;
     int64_t rtype = 0;
     int rc;
@@ -2050,6 +2132,16 @@ _replica_init_from_config(Replica *r, Slapi_Entry *e, char *errortext)
         slapi_counter_set_value(r->release_timeout, 0);
     }
 
+    /* Get the number of updates a supplier session may apply in parallel */
+    if ((val = (char*)slapi_entry_attr_get_ref(e, type_replicaApplyThreads))) {
+        if (repl_config_valid_num(type_replicaApplyThreads, val, 1, REPLICA_APPLY_THREADS_MAX, &rc, errortext, &apply_threads) != 0) {
+            return LDAP_UNWILLING_TO_PERFORM;
+        }
+        slapi_counter_set_value(r->apply_threads, apply_threads);
+    } else {
+        slapi_counter_set_value(r->apply_threads, DEFAULT_REPLICA_APPLY_THREADS);
+    }
+
     /* check for precise tombstone purging */
     precise_purging = (char*)slapi_entry_attr_get_ref(e, type_replicaPrecisePurge);
     if (precise_purging) {
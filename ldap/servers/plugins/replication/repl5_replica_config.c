@@ -374,6 +374,9 @@ replica_config_modify(Slapi_PBlock *pb,
                 } else if (strcasecmp(config_attr, type_replicaReleaseTimeout) == 0) {
                     if (apply_mods)
                         replica_set_release_timeout(r, 0);
+                } else if (strcasecmp(config_attr, type_replicaApplyThreads) == 0) {
+                    if (apply_mods)
+                        replica_set_apply_threads(r, DEFAULT_REPLICA_APPLY_THREADS);
                 } else {
                     *returncode = LDAP_UNWILLING_TO_PERFORM;
                     PR_snprintf(errortext, SLAPI_DSE_RETURNTEXT_SIZE, "Deletion of %s attribute is not allowed", config_attr);
@@ -549,6 +552,15 @@ replica_config_modify(Slapi_PBlock *pb,
                             break;
                         }
                     }
+                } else if (strcasecmp(config_attr, type_replicaApplyThreads) == 0) {
+                    if (apply_mods) {
+                        int64_t val;
+                        if (repl_config_valid_num(config_attr, config_attr_value, 1, REPLICA_APPLY_THREADS_MAX, returncode, errortext, &val) == 0) {
+                            replica_set_apply_threads(r, val);
+                        } else {
+                            break;
+                        }
+                    }
                 } else {
                     *returncode = LDAP_UNWILLING_TO_PERFORM;
                     PR_snprintf(errortext, SLAPI_DSE_RETURNTEXT_SIZE,
@@ -870,9 +882,11 @@ replica_config_search(Slapi_PBlock *pb,
         Replica *replica = (Replica *)object_get_data(mtnode_ext->replica);
         if (cldb_is_open(replica)) {
             changeCount = cl5GetOperationCount(replica);
+            cl5GetCompressionStats(replica, e);
         }
         if (replica) {
             reapActive = replica_get_tombstone_reap_active(replica);
+            replica_get_apply_stats(replica, e);
         }
         /* Check if the in memory ruv is requested */
         if (search_requested_attr(pb, type_ruvElement)) {
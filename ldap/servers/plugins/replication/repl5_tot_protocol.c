@@ -53,17 +53,35 @@ typedef struct callback_data
     int last_message_id_sent;
     int last_message_id_received;
     int flowcontrol_detection;
+    Tot_Batch *batch;                        /* Entries not sent yet, if the consumer accepts several entries per extop */
 } callback_data;
 
+/* Records of a snapshot total update not sent yet */
+typedef struct snapshot_data
+{
+    callback_data *cb_data;
+    char *buf;
+    size_t len;
+    size_t size;
+    uint64_t nbchunks;
+    uint64_t sent_bytes; /* uncompressed */
+} snapshot_data;
+
 /*
  * Number of window seconds to wait until we programmatically decide
  * that the replica has got out of BUSY state
  */
 #define SLEEP_ON_BUSY_WINDOW (10)
 
+/* Uncompressed size of the database records sent in a snapshot chunk */
+#define SNAPSHOT_CHUNK_SIZE (1024 * 1024)
+
 /* Helper functions */
 static void get_result(int rc, void *cb_data);
 static int send_entry(Slapi_Entry *e, void *callback_data);
+static int send_entry_batch(callback_data *cb_data);
+static PRBool repl5_tot_use_snapshot(Private_Repl_Protocol *prp, const Slapi_DN *area_sdn);
+static void repl5_tot_send_snapshot(Private_Repl_Protocol *prp, Slapi_Backend *be, callback_data *cb_data);
 static void repl5_tot_delete(Private_Repl_Protocol **prp);
 
 #define LOST_CONN_ERR(xx) ((xx == -2) || (xx == LDAP_SERVER_DOWN) || (xx == LDAP_CONNECT_ERROR))
@@ -354,6 +372,7 @@ repl5_tot_run(Private_Repl_Protocol *prp)
     ReplicaId rid = 0; /* Used to create the replica keep alive subentry */
     char **instances = NULL;
     Slapi_Backend *be = NULL;
+    PRBool snapshot = PR_FALSE;
 
     PR_ASSERT(NULL != prp);
 
@@ -373,8 +392,10 @@ repl5_tot_run(Private_Repl_Protocol *prp)
 
     /* acquire remote replica */
     agmt_set_last_init_start(prp->agmt, slapi_current_utc_time());
+    snapshot = repl5_tot_use_snapshot(prp, area_sdn);
 retry:
-    rc = acquire_replica(prp, REPL_NSDS50_TOTAL_PROTOCOL_OID, NULL /* ruv */);
+    rc = acquire_replica(prp, snapshot ? REPL_NSDS_SNAPSHOT_TOTAL_PROTOCOL_OID : REPL_NSDS50_TOTAL_PROTOCOL_OID,
+                         NULL /* ruv */);
     /* We never retry total protocol, even in case a transient error.
        This is because if somebody already updated the replica we don't
        want to do it again */
@@ -392,6 +413,13 @@ retry:
                           ldaprc, wait_retry);
             DS_Sleep(PR_SecondsToInterval(wait_retry));
             goto retry;
+        } else if (snapshot && rc == ACQUIRE_FATAL_ERROR) {
+            /* The consumer backend can not install a snapshot */
+            slapi_log_err(SLAPI_LOG_WARNING, repl_plugin_name, "repl5_tot_run - %s - "
+                          "Consumer refused the snapshot total update, sending the entries instead.\n",
+                          agmt_get_long_name(prp->agmt));
+            snapshot = PR_FALSE;
+            goto retry;
         } else {
             agmt_set_last_init_status(prp->agmt, ldaprc,
                                       prp->last_acquire_response_code, 0, NULL);
@@ -457,6 +485,20 @@ retry:
         goto done;
     }
 
+    if (snapshot) {
+        /* Time to make sure it exists a keep alive subentry for that replica,
+         * it must be part of the snapshot */
+        if (prp->replica) {
+            rid = replica_get_rid(prp->replica);
+        }
+        replica_subentry_check(slapi_sdn_get_dn(area_sdn), rid);
+
+        cb_data.prp = prp;
+        pthread_mutex_init(&(cb_data.lock), NULL);
+        repl5_tot_send_snapshot(prp, be, &cb_data);
+        goto update_done;
+    }
+
     /*
      * Supporting entries out of order -- parent could have a larger id than its children.
      * Entires are retireved sorted by parentid without the allid threshold.
@@ -475,6 +517,11 @@ retry:
 
     cb_data.prp = prp;
     cb_data.rc = 0;
+    if (!prp->repl50consumer &&
+        conn_replica_supports_batch_init(prp->conn) == CONN_SUPPORTS_BATCH_INIT) {
+        /* Send several compressed entries per extop */
+        cb_data.batch = tot_batch_new();
+    }
     cb_data.num_entries = 1UL;
     cb_data.sleep_on_busy = 0;
     cb_data.last_busy = slapi_current_rel_time_t();
@@ -538,6 +585,11 @@ retry:
                                       get_result /* result callback */,
                                       send_entry /* entry callback */,
                                       NULL /* referral callback*/);
+    if (cb_data.batch && cb_data.rc == CONN_OPERATION_SUCCESS &&
+        tot_batch_count(cb_data.batch) > 0) {
+        /* Send the last entries */
+        send_entry_batch(&cb_data);
+    }
 
     /*
      * After completing the sending operation (or optionally failing), we need to clean up
@@ -563,12 +615,15 @@ retry:
      * If it failed, then cb_data.rc contains the error code, and
      * suitable messages will have been logged to the error log about the failure.
      */
-
+update_done:
     agmt_set_last_init_end(prp->agmt, slapi_current_utc_time());
     rc = cb_data.rc;
     agmt_set_update_in_progress(prp->agmt, PR_FALSE);
     agmt_update_done(prp->agmt, 1);
-    release_replica(prp);
+    if (release_replica(prp) != 0 && snapshot && rc == CONN_OPERATION_SUCCESS) {
+        /* The consumer failed to install the snapshot */
+        rc = -1;
+    }
 
     if (rc != CONN_OPERATION_SUCCESS) {
         slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name,
@@ -577,8 +632,8 @@ retry:
         agmt_set_last_init_status(prp->agmt, 0, 0, rc, "Total update aborted");
     } else {
         slapi_log_err(SLAPI_LOG_INFO, repl_plugin_name,
-                      "repl5_tot_run - Finished total update of replica \"%s\". Sent %lu entries.\n",
-                      agmt_get_long_name(prp->agmt), cb_data.num_entries);
+                      "repl5_tot_run - Finished %stotal update of replica \"%s\". Sent %lu entries.\n",
+                      snapshot ? "snapshot " : "", agmt_get_long_name(prp->agmt), cb_data.num_entries);
         agmt_set_last_init_status(prp->agmt, 0, 0, 0, "Total update succeeded");
         agmt_set_last_update_status(prp->agmt, 0, 0, NULL);
     }
@@ -597,6 +652,7 @@ done:
                       type_nsds5ReplicaFlowControlWindow);
     }
     conn_set_tot_update_cb(prp->conn, NULL);
+    tot_batch_free(&cb_data.batch);
     pthread_mutex_destroy(&(cb_data.lock));
     prp->stopped = 1;
 }
@@ -826,6 +882,19 @@ send_entry(Slapi_Entry *e, void *cb_data)
         goto error;
     }
 
+    if (((callback_data *)cb_data)->batch) {
+        Tot_Batch *batch = ((callback_data *)cb_data)->batch;
+
+        rc = tot_batch_add_entry(batch, bere);
+        ber_free(bere, 1);
+        if (rc != 0) {
+            ((callback_data *)cb_data)->rc = -1;
+            return -1;
+        }
+        (*num_entriesp)++;
+        return tot_batch_is_full(batch) ? send_entry_batch((callback_data *)cb_data) : 0;
+    }
+
     rc = ber_flatten(bere, &bv);
     ber_free(bere, 1);
     if (rc != 0) {
@@ -891,3 +960,206 @@ send_entry(Slapi_Entry *e, void *cb_data)
 error:
     return retval;
 }
+
+/*
+ * Tell whether the replica can be initialized by shipping a snapshot of the
+ * databases. Both sides must support it and the agreement must replicate
+ * all the attributes, otherwise the entries are sent.
+ */
+static PRBool
+repl5_tot_use_snapshot(Private_Repl_Protocol *prp, const Slapi_DN *area_sdn)
+{
+    back_info_snapshot info = {0};
+    Slapi_Backend *be = NULL;
+    const char *reason = NULL;
+
+    if (agmt_get_init_mode(prp->agmt) != REPL_INIT_MODE_SNAPSHOT) {
+        return PR_FALSE;
+    }
+    if (agmt_is_fractional(prp->agmt)) {
+        reason = "the agreement is fractional";
+    } else {
+        be = slapi_be_select(area_sdn);
+        info.state = BACK_SNAPSHOT_CHECK;
+        if (be == NULL || !slapi_be_issuffix(be, area_sdn) ||
+            slapi_back_ctrl_info(be, BACK_INFO_SNAPSHOT_EXPORT, &info) != 0) {
+            reason = "the local backend can not export a snapshot";
+        } else if (conn_connect(prp->conn) != CONN_OPERATION_SUCCESS ||
+                   conn_replica_supports_snapshot_init(prp->conn) != CONN_SUPPORTS_SNAPSHOT_INIT) {
+            reason = "the consumer does not support it";
+        }
+    }
+    if (reason) {
+        slapi_log_err(SLAPI_LOG_WARNING, repl_plugin_name,
+                      "repl5_tot_use_snapshot - %s - Can not send a snapshot because %s, "
+                      "sending the entries instead.\n",
+                      agmt_get_long_name(prp->agmt), reason);
+        return PR_FALSE;
+    }
+    return PR_TRUE;
+}
+
+/* Send the records buffered in a snapshot chunk extop */
+static int
+send_snapshot_chunk(snapshot_data *sd)
+{
+    callback_data *cb_data = sd->cb_data;
+    Private_Repl_Protocol *prp = cb_data->prp;
+    struct berval *bv;
+    int message_id = 0;
+    int rc;
+
+    if (prp->terminate) {
+        conn_disconnect(prp->conn);
+        cb_data->rc = -1;
+        return -1;
+    }
+
+    /* see if the result reader thread encountered
+       a fatal error */
+    pthread_mutex_lock(&(cb_data->lock));
+    rc = cb_data->abort;
+    pthread_mutex_unlock(&(cb_data->lock));
+    if (rc) {
+        conn_disconnect(prp->conn);
+        cb_data->rc = -1;
+        return -1;
+    }
+
+    if ((bv = snapshot_chunk2bv(sd->buf, sd->len)) == NULL) {
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name, "%s: send_snapshot_chunk: Encoding Error\n",
+                      agmt_get_long_name(prp->agmt));
+        cb_data->rc = -1;
+        return -1;
+    }
+    rc = conn_send_extended_operation(prp->conn, REPL_NSDS_SNAPSHOT_CHUNK_REQUEST_OID,
+                                      bv /* payload */, NULL /* update_control */, &message_id);
+    ber_bvfree(bv);
+    if (message_id) {
+        cb_data->last_message_id_sent = message_id;
+    }
+    sd->nbchunks++;
+    sd->sent_bytes += sd->len;
+    sd->len = 0;
+
+    /* see send_entry */
+    if (CONN_NOT_CONNECTED == rc) {
+        cb_data->rc = -2;
+        return -1;
+    }
+    cb_data->rc = rc;
+    return (CONN_OPERATION_SUCCESS == rc) ? 0 : -1;
+}
+
+/* Called by the backend for every record of the snapshot */
+static int
+send_snapshot_record(back_info_snapshot_record *rec, void *arg)
+{
+    snapshot_data *sd = (snapshot_data *)arg;
+    size_t reclen = snapshot_record_size(rec);
+
+    if (sd->len > 0 && sd->len + reclen > SNAPSHOT_CHUNK_SIZE) {
+        if (send_snapshot_chunk(sd)) {
+            return -1;
+        }
+    }
+    if (sd->len + reclen > sd->size) {
+        /* a single record may be larger than a chunk */
+        sd->size = (sd->len + reclen > SNAPSHOT_CHUNK_SIZE) ? sd->len + reclen : SNAPSHOT_CHUNK_SIZE;
+        sd->buf = slapi_ch_realloc(sd->buf, sd->size);
+    }
+    snapshot_record_put(sd->buf + sd->len, rec);
+    sd->len += reclen;
+    return 0;
+}
+
+/*
+ * Send a consistent snapshot of the backend databases to the consumer.
+ * The database records are packed in compressed chunks, the consumer
+ * stores them as they are. cb_data->rc is set like for the entries.
+ */
+static void
+repl5_tot_send_snapshot(Private_Repl_Protocol *prp, Slapi_Backend *be, callback_data *cb_data)
+{
+    snapshot_data sd = {0};
+    back_info_snapshot info = {0};
+    int rc;
+
+    cb_data->rc = 0;
+    cb_data->num_entries = 0UL;
+    cb_data->last_busy = slapi_current_rel_time_t();
+    sd.cb_data = cb_data;
+
+    /* This allows during perform_operation to check the callback data
+     * especially to do flow contol on delta send msgid / recv msgid
+     */
+    conn_set_tot_update_cb(prp->conn, (void *)cb_data);
+
+    rc = repl5_tot_create_async_result_thread(cb_data);
+    if (rc) {
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name, "repl5_tot_send_snapshot - %s - "
+                      "repl5_tot_create_async_result_thread failed; error - %d\n",
+                      agmt_get_long_name(prp->agmt), rc);
+        cb_data->rc = -1;
+        return;
+    }
+
+    info.state = BACK_SNAPSHOT_START;
+    info.record_cb = send_snapshot_record;
+    info.cb_arg = &sd;
+    rc = slapi_back_ctrl_info(be, BACK_INFO_SNAPSHOT_EXPORT, &info);
+    if (rc == 0 && sd.len > 0) {
+        rc = send_snapshot_chunk(&sd);
+    }
+    if (rc && cb_data->rc == CONN_OPERATION_SUCCESS) {
+        /* the backend failed to walk the snapshot */
+        conn_disconnect(prp->conn);
+        cb_data->rc = -1;
+    }
+
+    if (cb_data->rc == CONN_OPERATION_SUCCESS) { /* no need to wait if we already failed */
+        repl5_tot_waitfor_async_results(cb_data);
+    }
+    rc = repl5_tot_destroy_async_result_thread(cb_data);
+    if (rc) {
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name, "repl5_tot_send_snapshot - %s - "
+                      "repl5_tot_destroy_async_result_thread failed; error - %d\n",
+                      agmt_get_long_name(prp->agmt), rc);
+    }
+    cb_data->num_entries = info.nbentries;
+    slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name,
+                  "repl5_tot_send_snapshot - %s - Sent %" PRIu64 " bytes of records in %" PRIu64 " chunks\n",
+                  agmt_get_long_name(prp->agmt), sd.sent_bytes, sd.nbchunks);
+    slapi_ch_free_string(&sd.buf);
+}
+
+/* Send the entries added to the batch in a single extop */
+static int
+send_entry_batch(callback_data *cb_data)
+{
+    Private_Repl_Protocol *prp = cb_data->prp;
+    struct berval *bv;
+    int message_id = 0;
+    int rc;
+
+    if ((bv = tot_batch2bv(cb_data->batch)) == NULL) {
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name, "%s: send_entry_batch: Encoding Error\n",
+                      agmt_get_long_name(prp->agmt));
+        cb_data->rc = -1;
+        return -1;
+    }
+    rc = conn_send_extended_operation(prp->conn, REPL_NSDS_BATCH_ENTRIES_REQUEST_OID,
+                                      bv /* payload */, NULL /* update_control */, &message_id);
+    ber_bvfree(bv);
+    if (message_id) {
+        cb_data->last_message_id_sent = message_id;
+    }
+
+    /* see send_entry */
+    if (CONN_NOT_CONNECTED == rc) {
+        cb_data->rc = -2;
+        return -1;
+    }
+    cb_data->rc = rc;
+    return (CONN_OPERATION_SUCCESS == rc) ? 0 : -1;
+}
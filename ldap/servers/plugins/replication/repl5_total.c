@@ -44,9 +44,44 @@
           }
         CSN OCTET STRING,
     }
+
+ The requestValue of the snapshot chunk extop (snapshot total update) looks
+ like this:
+
+     requestValue ::= SEQUENCE {
+         recordsLength INTEGER,
+         records OCTET STRING
+     }
+
+ records is zlib compressed, recordsLength is its uncompressed length. Once
+ uncompressed it is a sequence of database records, each of them being:
+
+     4 bytes dbname length (network order, including the final NUL), dbname
+     4 bytes key length, key
+     4 bytes data length, data
+
+ dbname is the database file name without the backend name (i.e id2entry.db)
+
+ The requestValue of the batched entries extop (batched total update) looks
+ like this:
+
+     requestValue ::= SEQUENCE {
+         entriesLength INTEGER,
+         entries OCTET STRING
+     }
+
+ entries is a piece of a single zlib stream that lasts for the whole total
+ update, using tot_batch_dictionary as preset dictionary. Each extop ends
+ with a sync flush so it can be inflated on its own, but the attribute types
+ and values repeated from an entry to the other are compressed across the
+ extops. Once uncompressed, the entriesLength bytes are a sequence of:
+
+     4 bytes length (network order), requestValue of NSDS50ReplicationEntry
 */
 
 #include "repl5.h"
+#include <arpa/inet.h> /* htonl/ntohl */
+#include "zlib.h"
 
 #define CSN_TYPE_VALUE_UPDATED_ON_WIRE 1
 #define CSN_TYPE_VALUE_DELETED_ON_WIRE 2
@@ -65,6 +100,8 @@ static int my_ber_printf_value(BerElement *ber, const char *type, const Slapi_Va
 static int my_ber_printf_attr(BerElement *ber, Slapi_Attr *attr, PRBool deleted);
 static int my_ber_scanf_attr(BerElement *ber, Slapi_Attr **attr, PRBool *deleted);
 static int my_ber_scanf_value(BerElement *ber, Slapi_Value **value, PRBool *deleted);
+static int multisupplier_extop_snapshot_chunk(Slapi_PBlock *pb);
+static int multisupplier_extop_batch_entries(Slapi_PBlock *pb);
 
 /*
  * Get a Slapi_Entry ready to send over the wire as part of
@@ -616,35 +653,26 @@ loser:
 }
 
 /*
- * Extract the payload from a total update extended operation,
- * decode it, and produce a Slapi_Entry structure representing a new
- * entry to be added to the local database.
+ * Decode an entry of a total update (see entry2bere) and produce a
+ * Slapi_Entry structure representing a new entry to be added to the
+ * local database.
  */
 static int
-decode_total_update_extop(Slapi_PBlock *pb, Slapi_Entry **ep)
+decode_total_update_entry(struct berval *extop_value, Slapi_Entry **ep)
 {
     BerElement *tmp_bere = NULL;
     Slapi_Entry *e = NULL;
     Slapi_Attr *attr = NULL;
     char *str = NULL;
-    struct berval *extop_value = NULL;
-    char *extop_oid = NULL;
     ber_len_t len;
     char *lasto;
     ber_tag_t tag;
     int rc;
     PRBool deleted;
 
-    PR_ASSERT(NULL != pb);
     PR_ASSERT(NULL != ep);
 
-    slapi_pblock_get(pb, SLAPI_EXT_OP_REQ_OID, &extop_oid);
-    slapi_pblock_get(pb, SLAPI_EXT_OP_REQ_VALUE, &extop_value);
-
-    if ((NULL == extop_oid) ||
-        ((strcmp(extop_oid, REPL_NSDS50_REPLICATION_ENTRY_REQUEST_OID) != 0) &&
-         (strcmp(extop_oid, REPL_NSDS71_REPLICATION_ENTRY_REQUEST_OID) != 0)) ||
-        !BV_HAS_DATA(extop_value)) {
+    if (!BV_HAS_DATA(extop_value)) {
         /* Bogus */
         goto loser;
     }
@@ -733,7 +761,7 @@ loser:
         slapi_entry_free(e);
     }
     *ep = NULL;
-    slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name, "decode_total_update_extop - Could not decode extended "
+    slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name, "decode_total_update_entry - Could not decode extended "
                                                    "operation containing entry for total update.\n");
 
 free_and_return:
@@ -744,6 +772,32 @@ free_and_return:
     return rc;
 }
 
+/*
+ * Extract the payload from a total update extended operation and decode it.
+ */
+static int
+decode_total_update_extop(Slapi_PBlock *pb, Slapi_Entry **ep)
+{
+    struct berval *extop_value = NULL;
+    char *extop_oid = NULL;
+
+    PR_ASSERT(NULL != pb);
+
+    slapi_pblock_get(pb, SLAPI_EXT_OP_REQ_OID, &extop_oid);
+    slapi_pblock_get(pb, SLAPI_EXT_OP_REQ_VALUE, &extop_value);
+
+    if ((NULL == extop_oid) ||
+        ((strcmp(extop_oid, REPL_NSDS50_REPLICATION_ENTRY_REQUEST_OID) != 0) &&
+         (strcmp(extop_oid, REPL_NSDS71_REPLICATION_ENTRY_REQUEST_OID) != 0))) {
+        /* Bogus */
+        *ep = NULL;
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name, "decode_total_update_extop - Unexpected extended "
+                                                       "operation for total update.\n");
+        return -1;
+    }
+    return decode_total_update_entry(extop_value, ep);
+}
+
 /*
  * This plugin entry point is called whenever an NSDS50ReplicationEntry
  * extended operation is received.
@@ -756,6 +810,15 @@ multisupplier_extop_NSDS50ReplicationEntry(Slapi_PBlock *pb)
     Slapi_Connection *conn = NULL;
     PRUint64 connid = 0;
     int opid = 0;
+    char *extop_oid = NULL;
+
+    slapi_pblock_get(pb, SLAPI_EXT_OP_REQ_OID, &extop_oid);
+    if (extop_oid && strcmp(extop_oid, REPL_NSDS_SNAPSHOT_CHUNK_REQUEST_OID) == 0) {
+        return multisupplier_extop_snapshot_chunk(pb);
+    }
+    if (extop_oid && strcmp(extop_oid, REPL_NSDS_BATCH_ENTRIES_REQUEST_OID) == 0) {
+        return multisupplier_extop_batch_entries(pb);
+    }
 
     slapi_pblock_get(pb, SLAPI_CONN_ID, &connid);
     slapi_pblock_get(pb, SLAPI_OPERATION_ID, &opid);
@@ -813,3 +876,752 @@ multisupplier_extop_NSDS50ReplicationEntry(Slapi_PBlock *pb)
 
     return rc;
 }
+
+/*
+ * Snapshot total update
+ */
+
+static void
+snapshot_put_u32(char **p, uint32_t v)
+{
+    v = htonl(v);
+    memcpy(*p, &v, sizeof v);
+    *p += sizeof v;
+}
+
+static int
+snapshot_get_u32(const char **p, const char *end, uint32_t *v)
+{
+    if (end - *p < (ptrdiff_t)sizeof *v) {
+        return -1;
+    }
+    memcpy(v, *p, sizeof *v);
+    *v = ntohl(*v);
+    *p += sizeof *v;
+    return 0;
+}
+
+/*
+ * Size of a database record once packed in a snapshot chunk.
+ */
+size_t
+snapshot_record_size(const back_info_snapshot_record *rec)
+{
+    return 3 * sizeof(uint32_t) + strlen(rec->dbname) + 1 + rec->key.bv_len + rec->data.bv_len;
+}
+
+/*
+ * Append a database record to the buffer of a snapshot chunk. The caller
+ * must have reserved snapshot_record_size(rec) bytes. Returns the end of
+ * the record.
+ */
+char *
+snapshot_record_put(char *p, const back_info_snapshot_record *rec)
+{
+    size_t namelen = strlen(rec->dbname) + 1;
+
+    snapshot_put_u32(&p, namelen);
+    memcpy(p, rec->dbname, namelen);
+    p += namelen;
+    snapshot_put_u32(&p, rec->key.bv_len);
+    memcpy(p, rec->key.bv_val, rec->key.bv_len);
+    p += rec->key.bv_len;
+    snapshot_put_u32(&p, rec->data.bv_len);
+    memcpy(p, rec->data.bv_val, rec->data.bv_len);
+    p += rec->data.bv_len;
+    return p;
+}
+
+/*
+ * Compress a set of records and build the payload of a snapshot chunk extop.
+ * Returns NULL on failure.
+ */
+struct berval *
+snapshot_chunk2bv(const char *records, size_t len)
+{
+    BerElement *ber = NULL;
+    struct berval *bv = NULL;
+    uLongf zlen = compressBound(len);
+    char *zbuf = slapi_ch_malloc(zlen);
+    int rc;
+
+    rc = compress2((Bytef *)zbuf, &zlen, (const Bytef *)records, len, Z_BEST_SPEED);
+    if (rc != Z_OK) {
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name,
+                      "snapshot_chunk2bv - Failed to compress %lu bytes (zlib error %d)\n",
+                      (unsigned long)len, rc);
+        goto done;
+    }
+    if ((ber = ber_alloc()) == NULL) {
+        goto done;
+    }
+    if (ber_printf(ber, "{io}", (ber_int_t)len, zbuf, (ber_len_t)zlen) == -1 ||
+        ber_flatten(ber, &bv) == -1) {
+        bv = NULL;
+    }
+done:
+    if (ber) {
+        ber_free(ber, 1);
+    }
+    slapi_ch_free_string(&zbuf);
+    return bv;
+}
+
+/*
+ * Uncompress the payload of a snapshot chunk extop and split it in records.
+ * The records point into *buf which must be freed by the caller, together
+ * with *records.
+ */
+static int
+decode_snapshot_chunk(struct berval *extop_value, char **buf, back_info_snapshot_record **records, size_t *nbrecords)
+{
+    BerElement *ber = NULL;
+    struct berval zbv = {0};
+    ber_int_t len = 0;
+    uLongf ulen;
+    const char *p, *end;
+    size_t nb = 0, size = 0;
+    back_info_snapshot_record *recs = NULL;
+    int rc = -1;
+
+    *buf = NULL;
+    if (!BV_HAS_DATA(extop_value) || (ber = ber_init(extop_value)) == NULL) {
+        goto done;
+    }
+    if (ber_scanf(ber, "{io}", &len, &zbv) == LBER_ERROR || len <= 0) {
+        goto done;
+    }
+    *buf = slapi_ch_malloc(len);
+    ulen = len;
+    if (uncompress((Bytef *)*buf, &ulen, (const Bytef *)zbv.bv_val, zbv.bv_len) != Z_OK ||
+        ulen != (uLongf)len) {
+        goto done;
+    }
+
+    p = *buf;
+    end = *buf + len;
+    while (p < end) {
+        back_info_snapshot_record *rec;
+        uint32_t l;
+
+        if (nb == size) {
+            size = size ? 2 * size : 64;
+            recs = (back_info_snapshot_record *)slapi_ch_realloc((char *)recs, size * sizeof *recs);
+        }
+        rec = &recs[nb];
+        /* dbname must be a NUL terminated string */
+        if (snapshot_get_u32(&p, end, &l) || l == 0 || (ptrdiff_t)l > end - p || p[l - 1] != '\0') {
+            goto done;
+        }
+        rec->dbname = (char *)p;
+        p += l;
+        if (snapshot_get_u32(&p, end, &l) || (ptrdiff_t)l > end - p) {
+            goto done;
+        }
+        rec->key.bv_len = l;
+        rec->key.bv_val = (char *)p;
+        p += l;
+        if (snapshot_get_u32(&p, end, &l) || (ptrdiff_t)l > end - p) {
+            goto done;
+        }
+        rec->data.bv_len = l;
+        rec->data.bv_val = (char *)p;
+        p += l;
+        nb++;
+    }
+    rc = 0;
+
+done:
+    if (ber) {
+        ber_free(ber, 1);
+    }
+    slapi_ch_free_string(&zbv.bv_val);
+    if (rc) {
+        slapi_ch_free_string(buf);
+        slapi_ch_free((void **)&recs);
+        nb = 0;
+    }
+    *records = recs;
+    *nbrecords = nb;
+    return rc;
+}
+
+/*
+ * Called when a snapshot total update starts: the backend holding the
+ * replicated area is emptied and put offline.
+ */
+int
+consumer_snapshot_start(consumer_connection_extension *connext, const Slapi_DN *repl_root_sdn)
+{
+    Slapi_Backend *be = slapi_be_select(repl_root_sdn);
+    back_info_snapshot *snapshot;
+
+    if (be == NULL || !slapi_be_issuffix(be, repl_root_sdn)) {
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name,
+                      "consumer_snapshot_start - No backend for replicated area %s\n",
+                      slapi_sdn_get_dn(repl_root_sdn));
+        return LDAP_OPERATIONS_ERROR;
+    }
+    snapshot = (back_info_snapshot *)slapi_ch_calloc(1, sizeof(back_info_snapshot));
+    snapshot->state = BACK_SNAPSHOT_START;
+    if (slapi_back_ctrl_info(be, BACK_INFO_SNAPSHOT_IMPORT, snapshot) != 0) {
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name,
+                      "consumer_snapshot_start - Backend %s can not install a snapshot\n",
+                      slapi_be_get_name(be));
+        slapi_ch_free((void **)&snapshot);
+        return LDAP_OPERATIONS_ERROR;
+    }
+    connext->snapshot = snapshot;
+    return LDAP_SUCCESS;
+}
+
+/*
+ * Called when a snapshot total update ends. If it completed, the backend is
+ * put back online, otherwise it is left empty.
+ */
+int
+consumer_snapshot_done(consumer_connection_extension *connext, const Slapi_DN *repl_root_sdn, PRBool abort)
+{
+    back_info_snapshot *snapshot = connext->snapshot;
+    Slapi_Backend *be = slapi_be_select(repl_root_sdn);
+    int rc = -1;
+
+    if (snapshot == NULL) {
+        return LDAP_SUCCESS;
+    }
+    snapshot->state = abort ? BACK_SNAPSHOT_ABORT : BACK_SNAPSHOT_DONE;
+    snapshot->records = NULL;
+    snapshot->nbrecords = 0;
+    if (be) {
+        rc = slapi_back_ctrl_info(be, BACK_INFO_SNAPSHOT_IMPORT, snapshot);
+    }
+    if (abort) {
+        /* The backend is left empty and offline */
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name,
+                      "consumer_snapshot_done - Snapshot of %s aborted, "
+                      "the replica must be reinitialized\n",
+                      slapi_sdn_get_dn(repl_root_sdn));
+        rc = -1;
+    } else if (rc) {
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name,
+                      "consumer_snapshot_done - Failed to complete the snapshot of %s (%d)\n",
+                      slapi_sdn_get_dn(repl_root_sdn), rc);
+    } else {
+        slapi_log_err(SLAPI_LOG_INFO, repl_plugin_name,
+                      "consumer_snapshot_done - Snapshot of %s completed: %" PRIu64 " entries installed\n",
+                      slapi_sdn_get_dn(repl_root_sdn), snapshot->nbentries);
+    }
+    slapi_ch_free((void **)&connext->snapshot);
+    return rc ? LDAP_OPERATIONS_ERROR : LDAP_SUCCESS;
+}
+
+/*
+ * Store the records of a snapshot chunk extended operation.
+ */
+static int
+multisupplier_extop_snapshot_chunk(Slapi_PBlock *pb)
+{
+    consumer_connection_extension *connext = NULL;
+    back_info_snapshot_record *records = NULL;
+    struct berval *extop_value = NULL;
+    Slapi_Connection *conn = NULL;
+    Slapi_Backend *be = NULL;
+    PRUint64 connid = 0;
+    size_t nbrecords = 0;
+    char *buf = NULL;
+    int opid = 0;
+    int rc = -1;
+
+    slapi_pblock_get(pb, SLAPI_CONNECTION, &conn);
+    slapi_pblock_get(pb, SLAPI_CONN_ID, &connid);
+    slapi_pblock_get(pb, SLAPI_OPERATION_ID, &opid);
+    slapi_pblock_get(pb, SLAPI_EXT_OP_REQ_VALUE, &extop_value);
+
+    connext = consumer_connection_extension_acquire_exclusive_access(conn, connid, opid);
+    if (connext == NULL || connext->snapshot == NULL || connext->replica_acquired == NULL) {
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name,
+                      "multisupplier_extop_snapshot_chunk - conn=%" PRIu64 " op=%d "
+                      "Snapshot chunk received outside of a snapshot total update\n",
+                      connid, opid);
+        goto done;
+    }
+    if (decode_snapshot_chunk(extop_value, &buf, &records, &nbrecords)) {
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name,
+                      "multisupplier_extop_snapshot_chunk - conn=%" PRIu64 " op=%d "
+                      "Could not decode the snapshot chunk\n",
+                      connid, opid);
+        goto done;
+    }
+    be = slapi_be_select(replica_get_root(connext->replica_acquired));
+    connext->snapshot->state = BACK_SNAPSHOT_ADD;
+    connext->snapshot->records = records;
+    connext->snapshot->nbrecords = nbrecords;
+    rc = be ? slapi_back_ctrl_info(be, BACK_INFO_SNAPSHOT_IMPORT, connext->snapshot) : -1;
+    connext->snapshot->records = NULL;
+    connext->snapshot->nbrecords = 0;
+    if (rc) {
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name,
+                      "multisupplier_extop_snapshot_chunk - conn=%" PRIu64 " op=%d "
+                      "Error %d: could not store the %lu records of the snapshot chunk\n",
+                      connid, opid, rc, (unsigned long)nbrecords);
+    }
+
+done:
+    if (connext) {
+        consumer_connection_extension_relinquish_exclusive_access(conn, connid, opid, PR_FALSE);
+    }
+    slapi_ch_free_string(&buf);
+    slapi_ch_free((void **)&records);
+    if (rc && conn) {
+        /* just disconnect from the supplier, the snapshot is aborted when
+           connection object is destroyed */
+        slapi_disconnect_server(conn);
+    }
+    return rc;
+}
+
+/*
+ * Batched total update
+ */
+
+/* Limits of the entries sent in a batched total update extop */
+#define TOT_BATCH_MAX_ENTRIES 512
+#define TOT_BATCH_MAX_BYTES (512 * 1024)
+
+/*
+ * Preset zlib dictionary of the batched total update: strings found in most
+ * of the entries, the most frequent ones last. Both sides must use the same
+ * dictionary, so it can not be changed without a new extop OID.
+ */
+static const char tot_batch_dictionary[] =
+    "nsTombstonenscpEntryDNnsParentUniqueIdnsds5ReplConflictgroupOfUniqueNames"
+    "uniqueMembergroupOfNamesmembermemberOfnsAccountLockpasswordExpirationTime"
+    "pwdChangedTimeuserPasswordmailtelephoneNumbergivenNamedisplayNamedescription"
+    "homeDirectoryloginShellgidNumberuidNumberposixAccountnsPersonnsAccount"
+    "nsOrgPersoninetOrgPersonorganizationalPersonpersonorganizationalUnit"
+    "ldapsubentrydomainoudccnsnuid"
+    "creatorsNamecreateTimestampmodifiersNamemodifyTimestampnsUniqueId"
+    "objectClasstop";
+
+struct tot_batch
+{
+    z_stream zs; /* compression stream of the whole total update */
+    char *buf;   /* uncompressed entries of the next extop */
+    size_t len;
+    size_t size;
+    size_t count;
+};
+
+Tot_Batch *
+tot_batch_new(void)
+{
+    Tot_Batch *batch = (Tot_Batch *)slapi_ch_calloc(1, sizeof(Tot_Batch));
+    int rc;
+
+    rc = deflateInit(&batch->zs, Z_BEST_SPEED);
+    if (rc == Z_OK) {
+        rc = deflateSetDictionary(&batch->zs, (const Bytef *)tot_batch_dictionary,
+                                  sizeof(tot_batch_dictionary) - 1);
+        if (rc != Z_OK) {
+            deflateEnd(&batch->zs);
+        }
+    }
+    if (rc != Z_OK) {
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name,
+                      "tot_batch_new - Failed to initialize the compression (zlib error %d)\n", rc);
+        slapi_ch_free((void **)&batch);
+    }
+    return batch;
+}
+
+void
+tot_batch_free(Tot_Batch **batch)
+{
+    if (batch && *batch) {
+        deflateEnd(&(*batch)->zs);
+        slapi_ch_free_string(&(*batch)->buf);
+        slapi_ch_free((void **)batch);
+    }
+}
+
+/* Add an entry (see entry2bere) to the next extop */
+int
+tot_batch_add_entry(Tot_Batch *batch, BerElement *bere)
+{
+    struct berval *bv = NULL;
+    char *p;
+
+    if (ber_flatten(bere, &bv) != 0) {
+        return -1;
+    }
+    if (batch->len + sizeof(uint32_t) + bv->bv_len > batch->size) {
+        batch->size = batch->len + sizeof(uint32_t) + bv->bv_len;
+        if (batch->size < TOT_BATCH_MAX_BYTES) {
+            batch->size = TOT_BATCH_MAX_BYTES;
+        }
+        batch->buf = slapi_ch_realloc(batch->buf, batch->size);
+    }
+    p = batch->buf + batch->len;
+    snapshot_put_u32(&p, bv->bv_len);
+    memcpy(p, bv->bv_val, bv->bv_len);
+    batch->len += sizeof(uint32_t) + bv->bv_len;
+    batch->count++;
+    ber_bvfree(bv);
+    return 0;
+}
+
+PRBool
+tot_batch_is_full(const Tot_Batch *batch)
+{
+    return (batch->count >= TOT_BATCH_MAX_ENTRIES || batch->len >= TOT_BATCH_MAX_BYTES);
+}
+
+size_t
+tot_batch_count(const Tot_Batch *batch)
+{
+    return batch->count;
+}
+
+/*
+ * Compress the pending entries and build the payload of a batched entries
+ * extop. The batch is emptied. Returns NULL on failure, the compression
+ * stream is then unusable.
+ */
+struct berval *
+tot_batch2bv(Tot_Batch *batch)
+{
+    BerElement *ber = NULL;
+    struct berval *bv = NULL;
+    /* a sync flush adds a few bytes to the deflated data */
+    uLong zsize = deflateBound(&batch->zs, batch->len) + 64;
+    uLong zlen = 0;
+    char *zbuf = slapi_ch_malloc(zsize);
+    int rc;
+
+    batch->zs.next_in = (Bytef *)batch->buf;
+    batch->zs.avail_in = batch->len;
+    do {
+        if (zlen == zsize) {
+            zsize *= 2;
+            zbuf = slapi_ch_realloc(zbuf, zsize);
+        }
+        batch->zs.next_out = (Bytef *)zbuf + zlen;
+        batch->zs.avail_out = zsize - zlen;
+        rc = deflate(&batch->zs, Z_SYNC_FLUSH);
+        zlen = zsize - batch->zs.avail_out;
+    } while (rc == Z_OK && batch->zs.avail_out == 0);
+    if ((rc != Z_OK && rc != Z_BUF_ERROR) || batch->zs.avail_in != 0) {
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name,
+                      "tot_batch2bv - Failed to compress %lu entries (zlib error %d)\n",
+                      (unsigned long)batch->count, rc);
+        goto done;
+    }
+    if ((ber = ber_alloc()) == NULL) {
+        goto done;
+    }
+    if (ber_printf(ber, "{io}", (ber_int_t)batch->len, zbuf, (ber_len_t)zlen) == -1 ||
+        ber_flatten(ber, &bv) == -1) {
+        bv = NULL;
+    }
+done:
+    if (ber) {
+        ber_free(ber, 1);
+    }
+    slapi_ch_free_string(&zbuf);
+    batch->len = 0;
+    batch->count = 0;
+    return bv;
+}
+
+void
+tot_batch_decoder_free(void **decoder)
+{
+    if (decoder && *decoder) {
+        inflateEnd((z_stream *)*decoder);
+        slapi_ch_free(decoder);
+    }
+}
+
+/*
+ * Uncompress the payload of a batched entries extop with the decompression
+ * stream of the total update. *buf must be freed by the caller.
+ */
+static int
+decode_batch_entries(void **decoder, struct berval *extop_value, char **buf, size_t *len)
+{
+    BerElement *ber = NULL;
+    struct berval zbv = {0};
+    ber_int_t blen = 0;
+    z_stream *zs = (z_stream *)*decoder;
+    int rc = -1;
+    int zrc;
+
+    *buf = NULL;
+    *len = 0;
+    if (zs == NULL) {
+        zs = (z_stream *)slapi_ch_calloc(1, sizeof(z_stream));
+        if (inflateInit(zs) != Z_OK) {
+            slapi_ch_free((void **)&zs);
+            return -1;
+        }
+        *decoder = zs;
+    }
+    if (!BV_HAS_DATA(extop_value) || (ber = ber_init(extop_value)) == NULL) {
+        goto done;
+    }
+    if (ber_scanf(ber, "{io}", &blen, &zbv) == LBER_ERROR || blen <= 0) {
+        goto done;
+    }
+    /* one more byte so that the whole input, up to the sync flush marker,
+     * is consumed */
+    *buf = slapi_ch_malloc(blen + 1);
+    zs->next_in = (Bytef *)zbv.bv_val;
+    zs->avail_in = zbv.bv_len;
+    zs->next_out = (Bytef *)*buf;
+    zs->avail_out = blen + 1;
+    do {
+        zrc = inflate(zs, Z_SYNC_FLUSH);
+        if (zrc == Z_NEED_DICT) {
+            zrc = inflateSetDictionary(zs, (const Bytef *)tot_batch_dictionary,
+                                       sizeof(tot_batch_dictionary) - 1);
+        }
+    } while (zrc == Z_OK && zs->avail_in > 0 && zs->avail_out > 0);
+    if (zrc != Z_OK || zs->avail_in != 0 || zs->avail_out != 1) {
+        goto done;
+    }
+    *len = blen;
+    rc = 0;
+
+done:
+    if (ber) {
+        ber_free(ber, 1);
+    }
+    slapi_ch_free_string(&zbv.bv_val);
+    if (rc) {
+        slapi_ch_free_string(buf);
+    }
+    return rc;
+}
+
+/*
+ * Parallel decoding of the entries of a batch
+ *
+ * Inflating the batch is sequential (one zlib stream for the whole total
+ * update), but the entries are then decoded by up to
+ * TOT_BATCH_DECODE_THREADS threads, TOT_BATCH_DECODE_CHUNK entries at a
+ * time, while the extop thread queues them to the bulk import in their
+ * order (parents first). The extop thread decodes the next chunk itself
+ * when no decoding thread took it yet.
+ */
+#define TOT_BATCH_DECODE_THREADS 3
+#define TOT_BATCH_DECODE_CHUNK 32
+
+typedef struct tot_batch_item
+{
+    struct berval bv;
+    Slapi_Entry *e;
+    int rc;
+    int done;
+} tot_batch_item;
+
+typedef struct tot_batch_job
+{
+    tot_batch_item *items;
+    size_t count;
+    size_t next; /* first entry not taken by a decoding thread */
+    int stop;    /* the import failed, stop decoding */
+    pthread_mutex_t lock;
+    pthread_cond_t cv;
+} tot_batch_job;
+
+/* Decode the next chunk, called with the job lock held. Returns 0 if none is left */
+static int
+tot_batch_decode_chunk(tot_batch_job *job)
+{
+    size_t start = job->next;
+    size_t end;
+
+    if (job->stop || start >= job->count) {
+        return 0;
+    }
+    end = (start + TOT_BATCH_DECODE_CHUNK < job->count) ? start + TOT_BATCH_DECODE_CHUNK : job->count;
+    job->next = end;
+    pthread_mutex_unlock(&job->lock);
+    for (size_t i = start; i < end; i++) {
+        job->items[i].rc = decode_total_update_entry(&job->items[i].bv, &job->items[i].e);
+    }
+    pthread_mutex_lock(&job->lock);
+    for (size_t i = start; i < end; i++) {
+        job->items[i].done = 1;
+    }
+    pthread_cond_broadcast(&job->cv);
+    return 1;
+}
+
+static void
+tot_batch_decode_thread(void *arg)
+{
+    tot_batch_job *job = (tot_batch_job *)arg;
+
+    pthread_mutex_lock(&job->lock);
+    while (tot_batch_decode_chunk(job))
+        ;
+    pthread_mutex_unlock(&job->lock);
+}
+
+/* Wait until the entry i is decoded, or decode it */
+static tot_batch_item *
+tot_batch_get_item(tot_batch_job *job, size_t i)
+{
+    pthread_mutex_lock(&job->lock);
+    while (!job->items[i].done) {
+        if (job->next <= i) {
+            tot_batch_decode_chunk(job);
+        } else {
+            pthread_cond_wait(&job->cv, &job->lock);
+        }
+    }
+    pthread_mutex_unlock(&job->lock);
+    return &job->items[i];
+}
+
+/*
+ * Split the uncompressed entries of a batch, see the requestValue of the
+ * batched entries extop. Returns the number of entries, or -1.
+ */
+static int64_t
+tot_batch_split(const char *buf, size_t len, tot_batch_item **items)
+{
+    const char *p = buf;
+    const char *end = buf + len;
+    size_t count = 0;
+    size_t size = 0;
+
+    *items = NULL;
+    while (p < end) {
+        uint32_t l;
+
+        if (snapshot_get_u32(&p, end, &l) || (ptrdiff_t)l > end - p) {
+            slapi_ch_free((void **)items);
+            return -1;
+        }
+        if (count == size) {
+            size = size ? 2 * size : TOT_BATCH_MAX_ENTRIES;
+            *items = (tot_batch_item *)slapi_ch_realloc((char *)*items, size * sizeof(tot_batch_item));
+        }
+        memset(&(*items)[count], 0, sizeof(tot_batch_item));
+        (*items)[count].bv.bv_len = l;
+        (*items)[count].bv.bv_val = (char *)p;
+        p += l;
+        count++;
+    }
+    return (int64_t)count;
+}
+
+/*
+ * Import the entries of a batched entries extended operation.
+ * The entries are queued to the bulk import like the ones sent one by one.
+ */
+static int
+multisupplier_extop_batch_entries(Slapi_PBlock *pb)
+{
+    consumer_connection_extension *connext = NULL;
+    struct berval *extop_value = NULL;
+    Slapi_Connection *conn = NULL;
+    tot_batch_job job = {0};
+    PRThread *threads[TOT_BATCH_DECODE_THREADS];
+    size_t nthreads = 0;
+    PRUint64 connid = 0;
+    int64_t nentries = 0;
+    size_t len = 0;
+    size_t count = 0;
+    char *buf = NULL;
+    int opid = 0;
+    int rc = -1;
+
+    slapi_pblock_get(pb, SLAPI_CONNECTION, &conn);
+    slapi_pblock_get(pb, SLAPI_CONN_ID, &connid);
+    slapi_pblock_get(pb, SLAPI_OPERATION_ID, &opid);
+    slapi_pblock_get(pb, SLAPI_EXT_OP_REQ_VALUE, &extop_value);
+
+    connext = consumer_connection_extension_acquire_exclusive_access(conn, connid, opid);
+    if (connext == NULL || connext->replica_acquired == NULL ||
+        connext->repl_protocol_version != REPL_PROTOCOL_50_TOTALUPDATE) {
+        slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name,
+                      "multisupplier_extop_batch_entries - conn=%" PRIu64 " op=%d "
+                      "Batched entries received outside of a total update\n",
+                      connid, opid);
+    } else {
+        rc = decode_batch_entries(&connext->batch_decoder, extop_value, &buf, &len);
+        if (rc) {
+            slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name,
+                          "multisupplier_extop_batch_entries - conn=%" PRIu64 " op=%d "
+                          "Could not decode the batched entries\n",
+                          connid, opid);
+        }
+    }
+    if (connext) {
+        consumer_connection_extension_relinquish_exclusive_access(conn, connid, opid, PR_FALSE);
+    }
+
+    if (rc == 0 && (nentries = tot_batch_split(buf, len, &job.items)) < 0) {
+        rc = -1;
+    }
+    if (rc == 0 && nentries > 0) {
+        job.count = (size_t)nentries;
+        pthread_mutex_init(&job.lock, NULL);
+        pthread_cond_init(&job.cv, NULL);
+        /* the extop thread decodes too, no thread for a single chunk */
+        while (nthreads < TOT_BATCH_DECODE_THREADS &&
+               (nthreads + 1) * TOT_BATCH_DECODE_CHUNK < job.count &&
+               (threads[nthreads] = PR_CreateThread(PR_USER_THREAD, tot_batch_decode_thread, (void *)&job,
+                                                    PR_PRIORITY_NORMAL, PR_GLOBAL_THREAD, PR_JOINABLE_THREAD,
+                                                    SLAPD_DEFAULT_THREAD_STACKSIZE)) != NULL) {
+            nthreads++;
+        }
+        for (size_t i = 0; i < job.count; i++) {
+            tot_batch_item *item = tot_batch_get_item(&job, i);
+
+            if (item->rc) {
+                rc = -1;
+                break;
+            }
+            rc = slapi_import_entry(pb, item->e);
+            if (rc != LDAP_SUCCESS) {
+                /* We still own the entry, it is freed below */
+                slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name,
+                              "multisupplier_extop_batch_entries - "
+                              "Error %d: could not import entry dn %s for total update operation conn=%" PRIu64 " op=%d\n",
+                              rc, slapi_entry_get_dn_const(item->e), connid, opid);
+                rc = -1;
+                break;
+            }
+            item->e = NULL;
+            count++;
+        }
+        pthread_mutex_lock(&job.lock);
+        job.stop = 1;
+        pthread_mutex_unlock(&job.lock);
+        for (size_t i = 0; i < nthreads; i++) {
+            (void)PR_JoinThread(threads[i]);
+        }
+        for (size_t i = 0; i < job.count; i++) {
+            slapi_entry_free(job.items[i].e);
+        }
+        pthread_cond_destroy(&job.cv);
+        pthread_mutex_destroy(&job.lock);
+    }
+    slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name,
+                  "multisupplier_extop_batch_entries - conn=%" PRIu64 " op=%d "
+                  "%lu entries imported\n",
+                  connid, opid, (unsigned long)count);
+    slapi_ch_free((void **)&job.items);
+    slapi_ch_free_string(&buf);
+
+    if (rc && conn) {
+        /* just disconnect from the supplier. bulk import is stopped when
+           connection object is destroyed */
+        slapi_disconnect_server(conn);
+    }
+    return rc;
+}
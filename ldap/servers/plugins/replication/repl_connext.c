@@ -38,6 +38,8 @@ consumer_connection_extension_constructor(void *object __attribute__((unused)),
         ext->supplier_ruv = NULL;
         ext->connection = NULL;
         ext->in_use_opid = -1;
+        ext->snapshot = NULL;
+        ext->batch_decoder = NULL;
         ext->lock = PR_NewLock();
         if (NULL == ext->lock) {
             slapi_log_err(SLAPI_LOG_PLUGIN, repl_plugin_name, "consumer_connection_extension_constructor - "
@@ -77,7 +79,11 @@ consumer_connection_extension_destructor(void *ext, void *object __attribute__((
                                   "Aborting total update in progress for replicated "
                                   "area %s connid=%" PRIu64 "\n",
                                   slapi_sdn_get_dn(repl_root_sdn), connid);
-                    slapi_stop_bulk_import(pb);
+                    if (connext->snapshot) {
+                        consumer_snapshot_done(connext, repl_root_sdn, PR_TRUE);
+                    } else {
+                        slapi_stop_bulk_import(pb);
+                    }
                 } else {
                     slapi_log_err(SLAPI_LOG_ERR, repl_plugin_name,
                                   "consumer_connection_extension_destructor - Can't determine root "
@@ -96,6 +102,8 @@ consumer_connection_extension_destructor(void *ext, void *object __attribute__((
             ruv_destroy((RUV **)&connext->supplier_ruv);
         }
 
+        tot_batch_decoder_free(&connext->batch_decoder);
+
         if (connext->lock) {
             PR_DestroyLock(connext->lock);
             connext->lock = NULL;
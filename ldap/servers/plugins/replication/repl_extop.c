@@ -688,6 +688,7 @@ multisupplier_extop_StartNSDS50ReplicationRequest(Slapi_PBlock *pb)
     PRUint64 connid = 0;
     int opid = 0;
     PRBool isInc = PR_FALSE;   /* true if incremental update */
+    PRBool isSnapshot = PR_FALSE; /* true if total update shipping a database snapshot */
     char *locking_purl = NULL; /* the supplier contacting us */
     char *current_purl = NULL; /* the supplier which already has exclusive access */
     char locking_session[42] = {0};
@@ -771,6 +772,30 @@ multisupplier_extop_StartNSDS50ReplicationRequest(Slapi_PBlock *pb)
                       "conn=%" PRIu64 " op=%d repl=\"%s\": Begin total protocol\n",
                       connid, opid, repl_root);
         isInc = PR_FALSE;
+    } else if (strcmp(protocol_oid, REPL_NSDS_SNAPSHOT_TOTAL_PROTOCOL_OID) == 0) {
+        if (repl_session_plugin_call_recv_acquire_cb(repl_root, 1 /* is_total == TRUE */,
+                                                     data_guid, data)) {
+            slapi_ch_free_string(&data_guid);
+            ber_bvfree(data);
+            data = NULL;
+            response = NSDS50_REPL_DISABLED;
+            goto send_response;
+        } else {
+            slapi_ch_free_string(&data_guid);
+            ber_bvfree(data);
+            data = NULL;
+        }
+
+        /* Stash info that this is a total update session */
+        if (NULL != connext) {
+            connext->repl_protocol_version = REPL_PROTOCOL_50_TOTALUPDATE;
+        }
+        slapi_log_err(SLAPI_LOG_REPL, repl_plugin_name,
+                      "multisupplier_extop_StartNSDS50ReplicationRequest - "
+                      "conn=%" PRIu64 " op=%d repl=\"%s\": Begin snapshot total protocol\n",
+                      connid, opid, repl_root);
+        isInc = PR_FALSE;
+        isSnapshot = PR_TRUE;
     } else if (strcmp(protocol_oid, REPL_NSDS71_INCREMENTAL_PROTOCOL_OID) == 0) {
         /* Stash info that this is an incremental update session */
         connext->repl_protocol_version = REPL_PROTOCOL_50_INCREMENTAL;
@@ -988,9 +1013,14 @@ multisupplier_extop_StartNSDS50ReplicationRequest(Slapi_PBlock *pb)
         /* LPREPL - check the return code.
          * But what do we do if mapping tree could not be updated ? */
 
-        /* start the bulk import */
+        /* start the bulk import, or empty the backend for the snapshot */
         slapi_pblock_set(pb, SLAPI_TARGET_SDN, repl_root_sdn);
-        rc = slapi_start_bulk_import(pb);
+        tot_batch_decoder_free(&connext->batch_decoder);
+        if (isSnapshot) {
+            rc = consumer_snapshot_start(connext, repl_root_sdn);
+        } else {
+            rc = slapi_start_bulk_import(pb);
+        }
         if (rc != LDAP_SUCCESS) {
             response = NSDS50_REPL_INTERNAL_ERROR;
             /* reset the mapping tree state to what it was before
@@ -1036,6 +1066,10 @@ multisupplier_extop_StartNSDS50ReplicationRequest(Slapi_PBlock *pb)
     connext->isreplicationsession = 1;
     /* Save away the connection */
     slapi_pblock_get(pb, SLAPI_CONNECTION, &connext->connection);
+    /* The incremental updates that don't depend on each other may be applied in parallel */
+    slapi_connection_set_repl_apply_threads(connext->connection,
+                                            (REPL_PROTOCOL_50_TOTALUPDATE == connext->repl_protocol_version) ?
+                                            1 : replica_get_apply_threads(replica));
 
 send_response:
     if (connext && replica &&
@@ -1318,7 +1352,23 @@ multisupplier_extop_EndNSDS50ReplicationRequest(Slapi_PBlock *pb)
                 }
                 slapi_pblock_set(pb, SLAPI_TARGET_SDN, repl_root_sdn);
 
-                slapi_stop_bulk_import(pb);
+                if (connext->snapshot) {
+                    if (consumer_snapshot_done(connext, repl_root_sdn, PR_FALSE) != LDAP_SUCCESS) {
+                        /* The replica does not hold the supplier data: do not
+                         * install its ruv nor seed the changelog from it */
+                        tot_batch_decoder_free(&connext->batch_decoder);
+                        replica_set_tombstone_reap_stop(r, PR_FALSE);
+                        replica_relinquish_exclusive_access(r, connid, opid);
+                        connext->replica_acquired = NULL;
+                        connext->isreplicationsession = 0;
+                        slapi_pblock_set(pb, SLAPI_CONN_IS_REPLICATION_SESSION, &zero);
+                        response = NSDS50_REPL_INTERNAL_ERROR;
+                        goto send_response;
+                    }
+                } else {
+                    slapi_stop_bulk_import(pb);
+                }
+                tot_batch_decoder_free(&connext->batch_decoder);
 
                 /* ONREPL - this is a bit of a hack. Once bulk import is finished,
                    the replication function that responds to backend state change
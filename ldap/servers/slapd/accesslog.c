@@ -800,6 +800,7 @@ slapd_log_access_search(slapd_log_pblock *logpb)
  * const char *key
  * const char *value
  * int32_t count
+ * const char *plan
  */
 int32_t
 slapd_log_access_stat(slapd_log_pblock *logpb)
@@ -812,7 +813,9 @@ slapd_log_access_stat(slapd_log_pblock *logpb)
         return rc;
     }
 
-    if (logpb->stat_etime) {
+    if (logpb->stat_plan) {
+        json_object_object_add(json_obj, "stat_filter_plan", json_obj_add_str(logpb->stat_plan));
+    } else if (logpb->stat_etime) {
         /* this is the summary stat */
         json_object_object_add(json_obj, "stat_etime", json_obj_add_str(logpb->stat_etime));
     } else {
@@ -0,0 +1,212 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * arena.c - bump allocator for the short lived objects of an operation
+ *
+ * An arena is a list of chunks. Allocating moves the used offset of the
+ * current chunk, a new chunk is added when it is full. Nothing is freed
+ * before the arena is released (to a mark) or destroyed, then its chunks
+ * go back to a small per thread pool and are reused by the next arena of
+ * the thread without calling malloc.
+ *
+ * The arena structure itself is stored in its first chunk.
+ */
+
+#include "slap.h"
+
+#define ARENA_CHUNK_SIZE 8192 /* usable bytes of a pooled chunk */
+#define ARENA_POOL_MAX 32     /* chunks kept per thread */
+#define ARENA_ALIGN 16
+#define ARENA_ROUND(s) (((s) + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1))
+
+typedef struct arena_chunk
+{
+    struct arena_chunk *ac_prev; /* previous chunk of the arena or next free chunk of the pool */
+    size_t ac_size;              /* usable bytes */
+    size_t ac_used;
+} arena_chunk;
+
+#define ARENA_CHUNK_HDR ARENA_ROUND(sizeof(arena_chunk))
+#define ARENA_CHUNK_DATA(c) ((char *)(c) + ARENA_CHUNK_HDR)
+
+struct slapi_arena
+{
+    arena_chunk *a_chunk; /* current chunk */
+};
+
+typedef struct arena_pool
+{
+    arena_chunk *ap_free;
+    int32_t ap_count;
+} arena_pool;
+
+/* Called by the thread data destructor when a thread exits */
+void
+arena_pool_destroy(void *priv)
+{
+    arena_pool *pool = (arena_pool *)priv;
+    arena_chunk *chunk;
+
+    if (pool == NULL) {
+        return;
+    }
+    while ((chunk = pool->ap_free) != NULL) {
+        pool->ap_free = chunk->ac_prev;
+        slapi_ch_free((void **)&chunk);
+    }
+    slapi_ch_free((void **)&pool);
+}
+
+static arena_chunk *
+arena_chunk_get(size_t size)
+{
+    arena_chunk *chunk;
+
+    if (size <= ARENA_CHUNK_SIZE) {
+        arena_pool *pool = slapi_td_get_arena_pool();
+
+        if (pool && pool->ap_free) {
+            chunk = pool->ap_free;
+            pool->ap_free = chunk->ac_prev;
+            pool->ap_count--;
+            chunk->ac_prev = NULL;
+            chunk->ac_used = 0;
+            return chunk;
+        }
+        size = ARENA_CHUNK_SIZE;
+    }
+    chunk = (arena_chunk *)slapi_ch_malloc(ARENA_CHUNK_HDR + size);
+    chunk->ac_prev = NULL;
+    chunk->ac_size = size;
+    chunk->ac_used = 0;
+    return chunk;
+}
+
+static void
+arena_chunk_put(arena_chunk *chunk)
+{
+    if (chunk->ac_size == ARENA_CHUNK_SIZE) {
+        arena_pool *pool = slapi_td_get_arena_pool();
+
+        if (pool == NULL) {
+            pool = (arena_pool *)slapi_ch_calloc(1, sizeof(arena_pool));
+            if (slapi_td_set_arena_pool(pool) != PR_SUCCESS) {
+                slapi_ch_free((void **)&pool);
+            }
+        }
+        if (pool && pool->ap_count < ARENA_POOL_MAX) {
+            chunk->ac_prev = pool->ap_free;
+            pool->ap_free = chunk;
+            pool->ap_count++;
+            return;
+        }
+    }
+    /* oversized chunk or full pool */
+    slapi_ch_free((void **)&chunk);
+}
+
+Slapi_Arena *
+slapi_arena_new(void)
+{
+    arena_chunk *chunk = arena_chunk_get(sizeof(struct slapi_arena));
+    Slapi_Arena *arena = (Slapi_Arena *)ARENA_CHUNK_DATA(chunk);
+
+    chunk->ac_used = ARENA_ROUND(sizeof(struct slapi_arena));
+    arena->a_chunk = chunk;
+    return arena;
+}
+
+void
+slapi_arena_destroy(Slapi_Arena **arena)
+{
+    arena_chunk *chunk;
+
+    if (arena == NULL || *arena == NULL) {
+        return;
+    }
+    /* the last chunk holds the arena, do not touch it after */
+    chunk = (*arena)->a_chunk;
+    *arena = NULL;
+    while (chunk) {
+        arena_chunk *prev = chunk->ac_prev;
+        arena_chunk_put(chunk);
+        chunk = prev;
+    }
+}
+
+void *
+slapi_arena_alloc(Slapi_Arena *arena, size_t size)
+{
+    arena_chunk *chunk = arena->a_chunk;
+    void *ptr;
+
+    size = ARENA_ROUND(size ? size : 1);
+    if (chunk->ac_size - chunk->ac_used < size) {
+        chunk = arena_chunk_get(size);
+        chunk->ac_prev = arena->a_chunk;
+        arena->a_chunk = chunk;
+    }
+    ptr = ARENA_CHUNK_DATA(chunk) + chunk->ac_used;
+    chunk->ac_used += size;
+    return ptr;
+}
+
+void *
+slapi_arena_calloc(Slapi_Arena *arena, size_t nelem, size_t size)
+{
+    void *ptr;
+
+    if (size && nelem > SIZE_MAX / size) {
+        slapi_log_err(SLAPI_LOG_ERR, "slapi_arena_calloc",
+                      "Overflow with %lu elements of %lu bytes\n", (u_long)nelem, (u_long)size);
+        slapi_ch_oom("slapi_arena_calloc");
+    }
+    ptr = slapi_arena_alloc(arena, nelem * size);
+    memset(ptr, 0, nelem * size);
+    return ptr;
+}
+
+char *
+slapi_arena_strdup(Slapi_Arena *arena, const char *s)
+{
+    size_t len;
+    char *dup;
+
+    if (s == NULL) {
+        return NULL;
+    }
+    len = strlen(s) + 1;
+    dup = (char *)slapi_arena_alloc(arena, len);
+    memcpy(dup, s, len);
+    return dup;
+}
+
+void
+slapi_arena_mark(Slapi_Arena *arena, Slapi_Arena_Mark *mark)
+{
+    mark->am_chunk = arena->a_chunk;
+    mark->am_used = arena->a_chunk->ac_used;
+}
+
+void
+slapi_arena_release(Slapi_Arena *arena, const Slapi_Arena_Mark *mark)
+{
+    while (arena->a_chunk != mark->am_chunk) {
+        arena_chunk *chunk = arena->a_chunk;
+
+        PR_ASSERT(chunk->ac_prev);
+        arena->a_chunk = chunk->ac_prev;
+        arena_chunk_put(chunk);
+    }
+    arena->a_chunk->ac_used = mark->am_used;
+}
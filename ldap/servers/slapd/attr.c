@@ -208,11 +208,25 @@ slapi_attr_types_equivalent(const char *t1, const char *t2)
 {
     int retval = 0;
     struct asyntaxinfo *asi1, *asi2;
+    asyntaxref ref1 = {0}, ref2 = {0};
+    int found1, found2;
 
     if (NULL == t1 || NULL == t2) {
         return 0;
     }
 
+    /* With the snapshot, the types are the same if they have the same id */
+    found1 = attr_syntax_get_ref(t1, 0, &ref1, NULL);
+    found2 = attr_syntax_get_ref(t2, 0, &ref2, NULL);
+    if (found1 != ATTR_SYNTAX_REF_UNAVAILABLE && found2 != ATTR_SYNTAX_REF_UNAVAILABLE) {
+        if (found1 == ATTR_SYNTAX_REF_FOUND && found2 == ATTR_SYNTAX_REF_FOUND) {
+            return ref1.asr_id == ref2.asr_id;
+        } else if (found1 == ATTR_SYNTAX_REF_FOUND || found2 == ATTR_SYNTAX_REF_FOUND) {
+            return 0;
+        }
+        return strcasecmp(t1, t2) == 0;
+    }
+
     asi1 = attr_syntax_get_by_name(t1, 0);
     asi2 = attr_syntax_get_by_name(t2, 0);
     if (NULL != asi1) {
@@ -248,7 +262,7 @@ slapi_attr_types_equivalent(const char *t1, const char *t2)
 Slapi_Attr *
 slapi_attr_new()
 {
-    Slapi_Attr *a = (Slapi_Attr *)slapi_ch_calloc(1, sizeof(Slapi_Attr));
+    Slapi_Attr *a = (Slapi_Attr *)slab_alloc(SLAB_CLASS_ATTR);
     if (!counters_created) {
         PR_CREATE_COUNTER(slapi_attr_counter_created, "Slapi_Attr", "created", "");
         PR_CREATE_COUNTER(slapi_attr_counter_deleted, "Slapi_Attr", "deleted", "");
@@ -271,6 +285,7 @@ slapi_attr_init_syntax(Slapi_Attr *a)
 {
     int rc = 1;
     struct asyntaxinfo *asi = NULL;
+    asyntaxref ref = {0};
     char *tmp = 0;
     const char *basetype = NULL;
     char buf[SLAPD_TYPICAL_ATTRIBUTE_NAME_MAX_LENGTH];
@@ -280,8 +295,14 @@ slapi_attr_init_syntax(Slapi_Attr *a)
     if (tmp) {
         basetype = buf;
     }
-    asi = attr_syntax_get_by_name_with_default(basetype);
-    if (asi) {
+    if (attr_syntax_get_ref(basetype, 1, &ref, NULL) != ATTR_SYNTAX_REF_UNAVAILABLE) {
+        rc = 0;
+        a->a_plugin = ref.asr_plugin;
+        a->a_flags = ref.asr_flags;
+        a->a_mr_eq_plugin = ref.asr_mr_eq_plugin;
+        a->a_mr_ord_plugin = ref.asr_mr_ord_plugin;
+        a->a_mr_sub_plugin = ref.asr_mr_sub_plugin;
+    } else if ((asi = attr_syntax_get_by_name_with_default(basetype))) {
         rc = 0;
         a->a_plugin = asi->asi_plugin;
         a->a_flags = asi->asi_flags;
@@ -302,7 +323,11 @@ slapi_attr_init_locking_optional(Slapi_Attr *a, const char *type, PRBool use_loc
     if (NULL != a) {
         struct asyntaxinfo *asi = NULL;
         const char *basetype = NULL;
+        const char *name = NULL; /* name of the type in the schema */
+        char *refname = NULL;
         char *tmp = NULL;
+        asyntaxref ref = {0};
+        int found = ATTR_SYNTAX_REF_UNAVAILABLE;
 
         if (type != NULL) {
             char buf[SLAPD_TYPICAL_ATTRIBUTE_NAME_MAX_LENGTH];
@@ -311,17 +336,30 @@ slapi_attr_init_locking_optional(Slapi_Attr *a, const char *type, PRBool use_loc
             if (tmp != NULL) {
                 basetype = tmp; /* basetype was malloc'd */
             }
-            asi = attr_syntax_get_by_name_locking_optional(basetype, use_lock, 0);
+            /* Without use_lock the caller may be changing the schema */
+            if (use_lock) {
+                found = attr_syntax_get_ref(basetype, 1, &ref, &refname);
+            }
+            if (found == ATTR_SYNTAX_REF_UNAVAILABLE) {
+                asi = attr_syntax_get_by_name_locking_optional(basetype, use_lock, 0);
+            }
         }
-        if (NULL == asi) {
+        if (found == ATTR_SYNTAX_REF_FOUND) {
+            name = refname;
+        } else if (NULL != asi) {
+            name = asi->asi_name;
+        }
+        if (NULL == name) {
             a->a_type = attr_syntax_normalize_no_lookup(type);
             /*
              * no syntax for this type... return Octet String
              * syntax.  we accomplish this by looking up a well known
              * attribute type that has that syntax.
              */
-            asi = attr_syntax_get_by_name_locking_optional(
-                ATTR_WITH_OCTETSTRING_SYNTAX, use_lock, 0);
+            if (found == ATTR_SYNTAX_REF_UNAVAILABLE) {
+                asi = attr_syntax_get_by_name_locking_optional(
+                    ATTR_WITH_OCTETSTRING_SYNTAX, use_lock, 0);
+            }
         } else {
             char *attroptions = NULL;
 
@@ -330,7 +368,7 @@ slapi_attr_init_locking_optional(Slapi_Attr *a, const char *type, PRBool use_loc
             }
 
             if (NULL == attroptions) {
-                a->a_type = slapi_ch_strdup(asi->asi_name);
+                a->a_type = slapi_ch_strdup(name);
             } else {
                 /*
                  * If the original type includes any attribute options,
@@ -341,11 +379,17 @@ slapi_attr_init_locking_optional(Slapi_Attr *a, const char *type, PRBool use_loc
                 char *normalized_options;
 
                 normalized_options = attr_syntax_normalize_no_lookup(attroptions);
-                a->a_type = slapi_ch_smprintf("%s%s", asi->asi_name, normalized_options);
+                a->a_type = slapi_ch_smprintf("%s%s", name, normalized_options);
                 slapi_ch_free_string(&normalized_options);
             }
         }
-        if (asi != NULL) {
+        if (found != ATTR_SYNTAX_REF_UNAVAILABLE) {
+            a->a_plugin = ref.asr_plugin;
+            a->a_flags = ref.asr_flags;
+            a->a_mr_eq_plugin = ref.asr_mr_eq_plugin;
+            a->a_mr_ord_plugin = ref.asr_mr_ord_plugin;
+            a->a_mr_sub_plugin = ref.asr_mr_sub_plugin;
+        } else if (asi != NULL) {
             a->a_plugin = asi->asi_plugin;
             a->a_flags = asi->asi_flags;
             a->a_mr_eq_plugin = asi->asi_mr_eq_plugin;
@@ -360,6 +404,7 @@ slapi_attr_init_locking_optional(Slapi_Attr *a, const char *type, PRBool use_loc
         }
 
         attr_syntax_return_locking_optional(asi, use_lock);
+        slapi_ch_free_string(&refname);
 
         if (NULL != tmp) {
             slapi_ch_free_string(&tmp);
@@ -405,7 +450,7 @@ slapi_attr_free(Slapi_Attr **ppa)
     if (ppa != NULL && *ppa != NULL) {
         Slapi_Attr *a = *ppa;
         attr_done(a);
-        slapi_ch_free((void **)&a);
+        slab_free(SLAB_CLASS_ATTR, a);
         PR_INCREMENT_COUNTER(slapi_attr_counter_deleted);
         PR_DECREMENT_COUNTER(slapi_attr_counter_exist);
     }
@@ -795,6 +840,7 @@ slapi_attr_set_type(Slapi_Attr *a, const char *type)
     } else {
         slapi_ch_free_string(&a->a_type);
         a->a_type = slapi_ch_strdup(type);
+        attrlist_type_changed();
     }
     return rc;
 }
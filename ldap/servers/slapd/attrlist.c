@@ -14,6 +14,211 @@
 
 #include "slap.h"
 
+/*
+ * Return the link to the attribute of type type in alist, or to the NULL
+ * ending the list.
+ */
+static Slapi_Attr **
+attrlist_find_link(Slapi_Attr **alist, const char *type)
+{
+    Slapi_Attr **a;
+
+    for (a = alist; *a != NULL; a = &(*a)->a_next) {
+        if (strcasecmp((*a)->a_type, type) == 0) {
+            break;
+        }
+    }
+    return a;
+}
+
+/*
+ * Index of the attributes of a list by type, built on the first lookup
+ * of a list of at least ATTRLIST_INDEX_MIN attributes (see
+ * attrlist_index_find). The readers of a shared entry may build it
+ * concurrently, so an index is never changed once published: when the
+ * list changes, a new one replaces it, and the stale ones are kept until
+ * the owner frees the index. Past ATTRLIST_INDEX_MAX_STALE of them, the
+ * list is scanned instead.
+ *
+ * An index is valid while the list keeps the head and the head keeps the
+ * version it had when the index was built. The head of a list gets a
+ * version when the list is first indexed, and a new one on each change
+ * of the list made through the attrlist_* functions afterwards. A change
+ * of the type of an attribute (slapi_attr_set_type) makes all the indexes
+ * stale.
+ */
+#define ATTRLIST_INDEX_MIN 16
+#define ATTRLIST_INDEX_MAX_STALE 4
+
+struct attrlist_index
+{
+    struct attrlist_index *ai_stale; /* the index this one replaced */
+    size_t ai_nstale;
+    Slapi_Attr *ai_head;
+    uint32_t ai_version;
+    uint64_t ai_types_generation;
+    size_t ai_mask;
+    Slapi_Attr *ai_slots[]; /* open addressing by the hash of the type */
+};
+
+/* the last version given to the head of a list, never 0 */
+static uint32_t attrlist_version = 0;
+/* the number of changes of the type of an attribute */
+static uint64_t attrlist_types_generation = 0;
+
+static uint32_t
+attrlist_new_version(void)
+{
+    uint32_t version;
+
+    do {
+        version = __atomic_add_fetch(&attrlist_version, 1, __ATOMIC_RELAXED);
+    } while (version == 0);
+    return version;
+}
+
+/* The version of the head of a list, before a change */
+static uint32_t
+attrlist_get_version(Slapi_Attr **alist)
+{
+    return *alist ? __atomic_load_n(&(*alist)->a_list_version, __ATOMIC_ACQUIRE) : 0;
+}
+
+/* After a change of an indexed list, give its head a new version */
+static void
+attrlist_changed(Slapi_Attr **alist, uint32_t version)
+{
+    if (version && *alist) {
+        __atomic_store_n(&(*alist)->a_list_version, attrlist_new_version(), __ATOMIC_RELEASE);
+    }
+}
+
+void
+attrlist_type_changed(void)
+{
+    __atomic_add_fetch(&attrlist_types_generation, 1, __ATOMIC_RELEASE);
+}
+
+static size_t
+attrlist_hash_type(const char *type)
+{
+    size_t hash = 5381;
+
+    for (; *type; type++) {
+        hash = hash * 33 + (unsigned char)tolower((unsigned char)*type);
+    }
+    return hash;
+}
+
+static int
+attrlist_index_isvalid(const struct attrlist_index *index, Slapi_Attr *alist)
+{
+    return index->ai_head == alist &&
+           index->ai_version == __atomic_load_n(&alist->a_list_version, __ATOMIC_ACQUIRE) &&
+           index->ai_types_generation == __atomic_load_n(&attrlist_types_generation, __ATOMIC_ACQUIRE);
+}
+
+/* Build the index of alist and publish it */
+static void
+attrlist_index_build(struct attrlist_index **index, struct attrlist_index *stale, Slapi_Attr *alist)
+{
+    struct attrlist_index *new_index;
+    uint32_t version = __atomic_load_n(&alist->a_list_version, __ATOMIC_ACQUIRE);
+    size_t count = 0;
+    size_t nslots = 1;
+
+    if (version == 0) {
+        uint32_t new_version = attrlist_new_version();
+
+        if (__atomic_compare_exchange_n(&alist->a_list_version, &version, new_version, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            version = new_version;
+        }
+    }
+    for (Slapi_Attr *a = alist; a != NULL; a = a->a_next) {
+        count++;
+    }
+    /* at most 3/4 full */
+    while (nslots * 3 < count * 4) {
+        nslots <<= 1;
+    }
+    new_index = (struct attrlist_index *)slapi_ch_calloc(1, sizeof(struct attrlist_index) + nslots * sizeof(Slapi_Attr *));
+    new_index->ai_stale = stale;
+    new_index->ai_nstale = stale ? stale->ai_nstale + 1 : 0;
+    new_index->ai_head = alist;
+    new_index->ai_version = version;
+    new_index->ai_types_generation = __atomic_load_n(&attrlist_types_generation, __ATOMIC_ACQUIRE);
+    new_index->ai_mask = nslots - 1;
+    for (Slapi_Attr *a = alist; a != NULL; a = a->a_next) {
+        size_t i;
+
+        for (i = attrlist_hash_type(a->a_type) & new_index->ai_mask; new_index->ai_slots[i] != NULL; i = (i + 1) & new_index->ai_mask) {
+            if (strcasecmp(new_index->ai_slots[i]->a_type, a->a_type) == 0) {
+                /* keep the first one, as the scan does */
+                break;
+            }
+        }
+        if (new_index->ai_slots[i] == NULL) {
+            new_index->ai_slots[i] = a;
+        }
+    }
+    if (!__atomic_compare_exchange_n(index, &stale, new_index, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        /* published by another reader */
+        slapi_ch_free((void **)&new_index);
+    }
+}
+
+/*
+ * Return the attribute of type type in alist, like attrlist_find, using
+ * the index of the list kept in *index by its owner. The owner frees it
+ * with attrlist_index_free when it frees the list.
+ */
+Slapi_Attr *
+attrlist_index_find(struct attrlist_index **index, Slapi_Attr *alist, const char *type)
+{
+    struct attrlist_index *current;
+    Slapi_Attr *found = NULL;
+    size_t count = 0;
+
+    if (alist == NULL) {
+        return NULL;
+    }
+    current = __atomic_load_n(index, __ATOMIC_ACQUIRE);
+    if (current && attrlist_index_isvalid(current, alist)) {
+        for (size_t i = attrlist_hash_type(type) & current->ai_mask; current->ai_slots[i]; i = (i + 1) & current->ai_mask) {
+            if (strcasecmp(current->ai_slots[i]->a_type, type) == 0) {
+                return current->ai_slots[i];
+            }
+        }
+        return NULL;
+    }
+
+    /* past the attribute, only count up to ATTRLIST_INDEX_MIN */
+    for (Slapi_Attr *a = alist; a != NULL && (found == NULL || count < ATTRLIST_INDEX_MIN); a = a->a_next, count++) {
+        if (found == NULL && strcasecmp(a->a_type, type) == 0) {
+            found = a;
+        }
+    }
+    if (count >= ATTRLIST_INDEX_MIN && (current == NULL || current->ai_nstale < ATTRLIST_INDEX_MAX_STALE)) {
+        attrlist_index_build(index, current, alist);
+    }
+    return found;
+}
+
+void
+attrlist_index_free(struct attrlist_index **index)
+{
+    struct attrlist_index *current = *index;
+
+    while (current) {
+        struct attrlist_index *stale = current->ai_stale;
+
+        slapi_ch_free((void **)&current);
+        current = stale;
+    }
+    *index = NULL;
+}
+
 void
 attrlist_free(Slapi_Attr *alist)
 {
@@ -41,16 +246,15 @@ attrlist_find_or_create_locking_optional(Slapi_Attr **alist, const char *type, S
 {
     int rc = 0; /* found */
     if (*a == NULL) {
-        for (*a = alist; **a != NULL; *a = &(**a)->a_next) {
-            if (strcasecmp((**a)->a_type, type) == 0) {
-                break;
-            }
-        }
+        *a = attrlist_find_link(alist, type);
     }
 
     if (**a == NULL) {
+        uint32_t version = attrlist_get_version(alist);
+
         **a = slapi_attr_new();
         slapi_attr_init_locking_optional(**a, type, use_lock);
+        attrlist_changed(alist, version);
         rc = 1; /* created */
     }
     return rc;
@@ -65,8 +269,11 @@ attrlist_append_nosyntax_init(Slapi_Attr **alist, const char *type, Slapi_Attr *
     }
 
     if (**a == NULL) {
+        uint32_t version = attrlist_get_version(alist);
+
         **a = slapi_attr_new();
         slapi_attr_init_nosyntax(**a, type);
+        attrlist_changed(alist, version);
         rc = 1; /* created */
     }
     return rc;
@@ -108,13 +315,7 @@ attrlist_merge_valuearray(Slapi_Attr **alist, const char *type, Slapi_Value **va
 Slapi_Attr *
 attrlist_find(Slapi_Attr *a, const char *type)
 {
-    for (; a != NULL; a = a->a_next) {
-        if (strcasecmp(a->a_type, type) == 0) {
-            return (a);
-        }
-    }
-
-    return (NULL);
+    return (*attrlist_find_link(&a, type));
 }
 
 
@@ -205,14 +406,16 @@ attrlist_remove(Slapi_Attr **attrs, const char *type)
 {
     Slapi_Attr **a;
     Slapi_Attr *save = NULL;
-    for (a = attrs; *a != NULL; a = &(*a)->a_next) {
-        if (strcasecmp((*a)->a_type, type) == 0) {
-            break;
-        }
-    }
+
+    a = attrlist_find_link(attrs, type);
     if (*a != NULL) {
+        uint32_t version = attrlist_get_version(attrs);
+
         save = *a;
         *a = (*a)->a_next;
+        attrlist_changed(attrs, version);
+        /* it may be added again as the head of a list */
+        __atomic_store_n(&save->a_list_version, 0, __ATOMIC_RELEASE);
     }
     return save;
 }
@@ -220,8 +423,11 @@ attrlist_remove(Slapi_Attr **attrs, const char *type)
 void
 attrlist_add(Slapi_Attr **attrs, Slapi_Attr *a)
 {
+    uint32_t version = attrlist_get_version(attrs);
+
     a->a_next = *attrs;
     *attrs = a;
+    attrlist_changed(attrs, version);
 }
 
 /*
@@ -236,6 +442,7 @@ attrlist_delete(Slapi_Attr **attrs, const char *type)
 {
     Slapi_Attr **a;
     Slapi_Attr *save;
+    uint32_t version = attrlist_get_version(attrs);
 
     for (a = attrs; *a != NULL; a = &(*a)->a_next) {
         if (strcasecmp((*a)->a_type, type) == 0) {
@@ -249,6 +456,7 @@ attrlist_delete(Slapi_Attr **attrs, const char *type)
 
     save = *a;
     *a = (*a)->a_next;
+    attrlist_changed(attrs, version);
     slapi_attr_free(&save);
 
     return (0);
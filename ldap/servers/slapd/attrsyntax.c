@@ -68,6 +68,18 @@ static int asi_locking = 1;
     }
 
 
+/*
+ * Bumped under the write lock by every change of name2asi or oid2asi: a
+ * schema snapshot built for an older generation is not used.
+ */
+static uint64_t asi_generation = 1;
+
+static void
+attr_syntax_changed(void)
+{
+    __atomic_add_fetch(&asi_generation, 1, __ATOMIC_SEQ_CST);
+}
+
 static struct asyntaxinfo *default_asi = NULL;
 
 static void *attr_syntax_get_plugin_by_name_with_default(const char *type);
@@ -233,6 +245,7 @@ attr_syntax_add_by_oid(const char *oid, struct asyntaxinfo *a, PRUint32 schema_f
         }
 
         PL_HashTableAdd(oid2asi, oid, a);
+        attr_syntax_changed();
 
         if (lock) {
             AS_UNLOCK_WRITE(oid2asi_lock);
@@ -442,6 +455,7 @@ attr_syntax_add_by_name(struct asyntaxinfo *a, PRUint32 schema_flags, int lock)
                 PL_HashTableAdd(name2asi, a->asi_aliases[i], a);
             }
         }
+        attr_syntax_changed();
 
         if (lock) {
             AS_UNLOCK_WRITE(name2asi_lock);
@@ -486,6 +500,8 @@ attr_syntax_delete_no_lock(struct asyntaxinfo *asi,
 
     if (schema_flags & DSE_SCHEMA_LOCKED) {
         using_tmp_ht = 1;
+    } else {
+        attr_syntax_changed();
     }
     if (oid2asi && remove_from_oidtable) {
         if (using_tmp_ht) {
@@ -533,14 +549,15 @@ char *
 slapi_attr_syntax_normalize(const char *s)
 {
     struct asyntaxinfo *asi = NULL;
+    asyntaxref ref = {0};
     char *r = NULL;
 
-    if ((asi = attr_syntax_get_by_name(s, 0)) != NULL) {
+    if (attr_syntax_get_ref(s, 0, &ref, &r) == ATTR_SYNTAX_REF_UNAVAILABLE &&
+        (asi = attr_syntax_get_by_name(s, 0)) != NULL) {
         r = slapi_ch_strdup(asi->asi_name);
         attr_syntax_return(asi);
     }
-    if (NULL == asi) {
-        slapi_ch_free_string(&r);
+    if (NULL == r) {
         r = attr_syntax_normalize_no_lookup(s);
     }
     return r;
@@ -557,14 +574,15 @@ char *
 slapi_attr_syntax_normalize_ext(char *s, int flags)
 {
     struct asyntaxinfo *asi = NULL;
+    asyntaxref ref = {0};
     char *r = NULL;
 
-    if ((asi = attr_syntax_get_by_name(s, flags)) != NULL) {
+    if (attr_syntax_get_ref(s, 0, &ref, &r) == ATTR_SYNTAX_REF_UNAVAILABLE &&
+        (asi = attr_syntax_get_by_name(s, flags)) != NULL) {
         r = slapi_ch_strdup(asi->asi_name);
         attr_syntax_return(asi);
     }
-    if (NULL == asi) {
-        slapi_ch_free_string(&r);
+    if (NULL == r) {
         r = attr_syntax_normalize_no_lookup_ext(s, flags);
     }
     return r;
@@ -578,9 +596,11 @@ int
 attr_syntax_exists(const char *attr_name)
 {
     struct asyntaxinfo *asi;
+    asyntaxref ref = {0};
     char *check_attr_name = NULL;
     char *p = NULL;
     int free_attr = 0;
+    int rc;
 
     /* Ignore any attribute subtypes. */
     if ((p = strchr(attr_name, ';'))) {
@@ -593,17 +613,18 @@ attr_syntax_exists(const char *attr_name)
         check_attr_name = (char *)attr_name;
     }
 
-    asi = attr_syntax_get_by_name(check_attr_name, 0);
-    attr_syntax_return(asi);
+    rc = attr_syntax_get_ref(check_attr_name, 0, &ref, NULL);
+    if (rc == ATTR_SYNTAX_REF_UNAVAILABLE) {
+        asi = attr_syntax_get_by_name(check_attr_name, 0);
+        attr_syntax_return(asi);
+        rc = asi ? ATTR_SYNTAX_REF_FOUND : ATTR_SYNTAX_REF_NOT_FOUND;
+    }
 
     if (free_attr) {
         slapi_ch_free_string(&check_attr_name);
     }
 
-    if (asi != NULL) {
-        return 1;
-    }
-    return 0;
+    return rc == ATTR_SYNTAX_REF_FOUND;
 }
 
 static void default_dirstring_normalize_int(char *s, int trim_spaces);
@@ -774,8 +795,13 @@ static void *
 attr_syntax_get_plugin_by_name_with_default(const char *type)
 {
     struct asyntaxinfo *asi;
+    asyntaxref ref = {0};
     void *plugin = NULL;
 
+    if (attr_syntax_get_ref(type, 1, &ref, NULL) != ATTR_SYNTAX_REF_UNAVAILABLE) {
+        return ref.asr_plugin;
+    }
+
     /*
      * first we look for this attribute type explictly
      */
@@ -1189,11 +1215,23 @@ slapi_attr_is_dn_syntax_type(char *type)
     const char *syntaxoid = NULL;
     int dn_syntax = 0; /* not DN, by default */
     struct asyntaxinfo *asi;
+    struct slapdplugin *plugin = NULL;
+    asyntaxref ref = {0};
 
-    asi = attr_syntax_get_by_name(type, 0);
+    switch (attr_syntax_get_ref(type, 0, &ref, NULL)) {
+    case ATTR_SYNTAX_REF_FOUND:
+        plugin = ref.asr_plugin;
+        break;
+    case ATTR_SYNTAX_REF_UNAVAILABLE:
+        if ((asi = attr_syntax_get_by_name(type, 0)) != NULL) {
+            plugin = asi->asi_plugin;
+            attr_syntax_return(asi);
+        }
+        break;
+    }
 
-    if (asi && asi->asi_plugin) { /* If not set, there is no way to get the info */
-        if ((syntaxoid = asi->asi_plugin->plg_syntax_oid)) {
+    if (plugin) { /* If not set, there is no way to get the info */
+        if ((syntaxoid = plugin->plg_syntax_oid)) {
             dn_syntax = ((0 == strcmp(syntaxoid, NAMEANDOPTIONALUID_SYNTAX_OID)) || (0 == strcmp(syntaxoid, DN_SYNTAX_OID)));
         }
     }
@@ -1354,6 +1392,7 @@ attr_syntax_clear_flag_callback(struct asyntaxinfo *asip, void *arg)
     PR_ASSERT(fi != NULL);
 
     asip->asi_flags &= ~(fi->asef_flag);
+    attr_syntax_changed();
 
     return ATTR_SYNTAX_ENUM_NEXT;
 }
@@ -1571,6 +1610,7 @@ slapi_add_internal_attr_syntax(const char *name, const char *oid, const char *sy
                               "Failed to stash internal asyntaxinfo: %s.\n",
                               asip->asi_name);
             }
+            attr_syntax_snapshot_publish();
         } else {
             attr_syntax_free(asip);
         }
@@ -1662,4 +1702,283 @@ attr_syntax_swap_ht()
     oid2asi_tmp = NULL;
     global_at = global_at_tmp;
     global_at_tmp = NULL;
+    attr_syntax_changed();
+}
+
+/*
+ * Schema snapshot
+ *
+ * The syntax of a type is looked up for most attributes of most operations,
+ * and the lookups above take the read locks and a reference each time. The
+ * snapshot is an immutable copy of what the hot paths need, published after
+ * each schema change: a reader finds it with an atomic load in an epoch
+ * section (see epoch.c), and a replaced snapshot is freed once the sections
+ * that may have read it are over.
+ *
+ * A snapshot built for an older asi_generation is not used, the readers go
+ * back to the locked lookups until the schema change publishes a new one.
+ *
+ * Each type gets an id, interned by its name when it is first published.
+ * The ids start at 1 and are never reused, so they can be kept and compared
+ * across the snapshots and the schema reloads: two types have the same id
+ * if and only if they have the same name.
+ */
+typedef struct attr_syntax_snapentry
+{
+    asyntaxref ase_ref;
+    char *ase_name;
+    char *ase_oid;
+    char **ase_aliases;
+} attr_syntax_snapentry;
+
+typedef struct attr_syntax_snapshot
+{
+    uint64_t ass_generation;
+    PLHashTable *ass_names;              /* names, aliases and OIDs to the entries */
+    attr_syntax_snapentry *ass_entries;
+    size_t ass_count;
+    attr_syntax_snapentry **ass_by_id;   /* by id, NULL for the deleted types */
+    int32_t ass_nids;
+    attr_syntax_snapentry *ass_octetstring; /* returned for the unknown types */
+    attr_syntax_snapentry ass_default;
+} attr_syntax_snapshot;
+
+static attr_syntax_snapshot *asi_snapshot = NULL;
+/* serializes the publications, and protects asi_ids */
+static pthread_mutex_t asi_snapshot_lock = PTHREAD_MUTEX_INITIALIZER;
+/* interned type names to their ids */
+static PLHashTable *asi_ids = NULL;
+static int32_t asi_nids = 0;
+
+static int32_t
+attr_syntax_intern(const char *name)
+{
+    intptr_t id;
+
+    if (asi_ids == NULL) {
+        asi_ids = PL_NewHashTable(2047, hashNocaseString,
+                                  hashNocaseCompare,
+                                  PL_CompareValues, 0, 0);
+    }
+    id = (intptr_t)PL_HashTableLookup_const(asi_ids, name);
+    if (id == 0) {
+        id = ++asi_nids;
+        PL_HashTableAdd(asi_ids, slapi_ch_strdup(name), (void *)id);
+    }
+    return (int32_t)id;
+}
+
+static void
+attr_syntax_snapentry_set(attr_syntax_snapentry *entry, struct asyntaxinfo *asi)
+{
+    entry->ase_ref.asr_flags = asi->asi_flags;
+    entry->ase_ref.asr_plugin = asi->asi_plugin;
+    entry->ase_ref.asr_mr_eq_plugin = asi->asi_mr_eq_plugin;
+    entry->ase_ref.asr_mr_sub_plugin = asi->asi_mr_sub_plugin;
+    entry->ase_ref.asr_mr_ord_plugin = asi->asi_mr_ord_plugin;
+    entry->ase_name = slapi_ch_strdup(asi->asi_name);
+    entry->ase_oid = slapi_ch_strdup(asi->asi_oid);
+    entry->ase_aliases = cool_charray_dup(asi->asi_aliases);
+}
+
+static void
+attr_syntax_snapentry_done(attr_syntax_snapentry *entry)
+{
+    cool_charray_free(entry->ase_aliases);
+    slapi_ch_free_string(&entry->ase_name);
+    slapi_ch_free_string(&entry->ase_oid);
+}
+
+/* Like name2asi, the most recently added type wins a shared name */
+static void
+attr_syntax_snapshot_add_key(attr_syntax_snapshot *snap, const char *key, attr_syntax_snapentry *entry)
+{
+    if (key && PL_HashTableLookup_const(snap->ass_names, key) == NULL) {
+        PL_HashTableAdd(snap->ass_names, key, entry);
+    }
+}
+
+static void
+attr_syntax_snapshot_free(void *obj)
+{
+    attr_syntax_snapshot *snap = (attr_syntax_snapshot *)obj;
+
+    for (size_t i = 0; i < snap->ass_count; i++) {
+        attr_syntax_snapentry_done(&snap->ass_entries[i]);
+    }
+    attr_syntax_snapentry_done(&snap->ass_default);
+    PL_HashTableDestroy(snap->ass_names);
+    slapi_ch_free((void **)&snap->ass_entries);
+    slapi_ch_free((void **)&snap->ass_by_id);
+    slapi_ch_free((void **)&snap);
+}
+
+/* Copy the attribute types, the read lock and asi_snapshot_lock are held */
+static attr_syntax_snapshot *
+attr_syntax_snapshot_build(void)
+{
+    attr_syntax_snapshot *snap;
+    struct asyntaxinfo *asi;
+    size_t count = 0;
+
+    snap = (attr_syntax_snapshot *)slapi_ch_calloc(1, sizeof(attr_syntax_snapshot));
+    snap->ass_names = PL_NewHashTable(2047, hashNocaseString,
+                                      hashNocaseCompare,
+                                      PL_CompareValues, 0, 0);
+    for (asi = global_at; asi; asi = asi->asi_next) {
+        count++;
+    }
+    snap->ass_entries = (attr_syntax_snapentry *)slapi_ch_calloc(count + 1, sizeof(attr_syntax_snapentry));
+
+    /* global_at starts with the most recently added types */
+    for (asi = global_at; asi; asi = asi->asi_next) {
+        attr_syntax_snapentry *entry;
+
+        if (asi->asi_marked_for_delete) {
+            continue;
+        }
+        entry = &snap->ass_entries[snap->ass_count++];
+        attr_syntax_snapentry_set(entry, asi);
+        entry->ase_ref.asr_id = attr_syntax_intern(asi->asi_name);
+        attr_syntax_snapshot_add_key(snap, entry->ase_name, entry);
+        for (size_t i = 0; entry->ase_aliases && entry->ase_aliases[i]; i++) {
+            attr_syntax_snapshot_add_key(snap, entry->ase_aliases[i], entry);
+        }
+    }
+    /* An OID is only looked up when no name matches */
+    for (size_t i = 0; i < snap->ass_count; i++) {
+        attr_syntax_snapshot_add_key(snap, snap->ass_entries[i].ase_oid, &snap->ass_entries[i]);
+    }
+
+    snap->ass_nids = asi_nids;
+    snap->ass_by_id = (attr_syntax_snapentry **)slapi_ch_calloc(asi_nids + 1, sizeof(attr_syntax_snapentry *));
+    for (size_t i = 0; i < snap->ass_count; i++) {
+        snap->ass_by_id[snap->ass_entries[i].ase_ref.asr_id] = &snap->ass_entries[i];
+    }
+
+    if (default_asi) {
+        attr_syntax_snapentry_set(&snap->ass_default, default_asi);
+    }
+    snap->ass_octetstring = (attr_syntax_snapentry *)PL_HashTableLookup_const(snap->ass_names, ATTR_WITH_OCTETSTRING_SYNTAX);
+    if (snap->ass_octetstring == NULL) {
+        snap->ass_octetstring = &snap->ass_default;
+    }
+
+    return snap;
+}
+
+/*
+ * Publish a snapshot of the current attribute types, if they changed since
+ * the last one. Called after the changes of the schema, without the
+ * attr_syntax locks.
+ */
+void
+attr_syntax_snapshot_publish(void)
+{
+    attr_syntax_snapshot *snap, *old;
+
+    if (0 != attr_syntax_init()) {
+        return;
+    }
+
+    pthread_mutex_lock(&asi_snapshot_lock);
+    if (asi_snapshot && asi_snapshot->ass_generation == __atomic_load_n(&asi_generation, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_unlock(&asi_snapshot_lock);
+        return;
+    }
+    attr_syntax_read_lock();
+    snap = attr_syntax_snapshot_build();
+    snap->ass_generation = __atomic_load_n(&asi_generation, __ATOMIC_SEQ_CST);
+    attr_syntax_unlock_read();
+    old = __atomic_exchange_n(&asi_snapshot, snap, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&asi_snapshot_lock);
+
+    if (old) {
+        epoch_retire(old, attr_syntax_snapshot_free);
+    }
+}
+
+/*
+ * Enter an epoch section and return the snapshot if it is current, NULL
+ * if the locked lookups must be used. The section is left by the caller.
+ */
+static attr_syntax_snapshot *
+attr_syntax_snapshot_enter(void)
+{
+    attr_syntax_snapshot *snap;
+
+    if (!epoch_enter()) {
+        return NULL;
+    }
+    snap = __atomic_load_n(&asi_snapshot, __ATOMIC_SEQ_CST);
+    if (snap == NULL || snap->ass_generation != __atomic_load_n(&asi_generation, __ATOMIC_SEQ_CST)) {
+        epoch_leave();
+        return NULL;
+    }
+    return snap;
+}
+
+/*
+ * Copy in ref the syntax of the type name, which can be a name, an alias or
+ * an OID, like attr_syntax_get_by_name() does but without lock or reference.
+ * If normalized is not NULL, it is set to a copy of the name of the type.
+ * With with_default, ref is set to the octet string syntax when the type is
+ * unknown, like attr_syntax_get_by_name_with_default().
+ *
+ * Returns ATTR_SYNTAX_REF_FOUND, ATTR_SYNTAX_REF_NOT_FOUND, or
+ * ATTR_SYNTAX_REF_UNAVAILABLE when the snapshot can not be used: the caller
+ * then uses the locked lookups.
+ */
+int
+attr_syntax_get_ref(const char *name, int with_default, asyntaxref *ref, char **normalized)
+{
+    attr_syntax_snapshot *snap;
+    attr_syntax_snapentry *entry;
+    int rc = ATTR_SYNTAX_REF_FOUND;
+
+    if ((snap = attr_syntax_snapshot_enter()) == NULL) {
+        return ATTR_SYNTAX_REF_UNAVAILABLE;
+    }
+    entry = (attr_syntax_snapentry *)PL_HashTableLookup_const(snap->ass_names, name);
+    if (entry == NULL) {
+        rc = ATTR_SYNTAX_REF_NOT_FOUND;
+        if (with_default) {
+            entry = snap->ass_octetstring;
+        }
+    } else if (normalized) {
+        *normalized = slapi_ch_strdup(entry->ase_name);
+    }
+    if (entry) {
+        *ref = entry->ase_ref;
+    }
+    epoch_leave();
+
+    return rc;
+}
+
+/*
+ * Same as attr_syntax_get_ref() for an id found in a previous ref. The type
+ * may have been deleted since.
+ */
+int
+attr_syntax_get_ref_by_id(int32_t id, asyntaxref *ref, char **name)
+{
+    attr_syntax_snapshot *snap;
+    attr_syntax_snapentry *entry = NULL;
+
+    if ((snap = attr_syntax_snapshot_enter()) == NULL) {
+        return ATTR_SYNTAX_REF_UNAVAILABLE;
+    }
+    if (id > 0 && id <= snap->ass_nids) {
+        entry = snap->ass_by_id[id];
+    }
+    if (entry) {
+        *ref = entry->ase_ref;
+        if (name) {
+            *name = slapi_ch_strdup(entry->ase_name);
+        }
+    }
+    epoch_leave();
+
+    return entry ? ATTR_SYNTAX_REF_FOUND : ATTR_SYNTAX_REF_NOT_FOUND;
 }
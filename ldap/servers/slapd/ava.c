@@ -19,13 +19,46 @@
 #include <sys/socket.h>
 #include "slap.h"
 
+static char *
+ava_arena_bvdup(Slapi_Arena *arena, const struct berval *bv)
+{
+    char *s = (char *)slapi_arena_alloc(arena, bv->bv_len + 1);
+
+    memcpy(s, bv->bv_val, bv->bv_len);
+    s[bv->bv_len] = '\0';
+    return s;
+}
+
+/*
+ * Decode an ava. With an arena, the type and the value are copied from
+ * the ber buffer into the arena and must not be freed with ava_done().
+ */
 int
 get_ava(
     BerElement *ber,
-    struct ava *ava)
+    struct ava *ava,
+    Slapi_Arena *arena)
 {
     char *type = NULL;
 
+    if (arena) {
+        struct berval type_bv = {0};
+        struct berval value_bv = {0};
+        char *norm;
+
+        if (ber_scanf(ber, "{mm}", &type_bv, &value_bv) == LBER_ERROR) {
+            slapi_log_err(SLAPI_LOG_ERR, "get_ava", "ber_scanf\n");
+            return (LDAP_PROTOCOL_ERROR);
+        }
+        norm = slapi_attr_syntax_normalize(ava_arena_bvdup(arena, &type_bv));
+        ava->ava_type = slapi_arena_strdup(arena, norm);
+        slapi_ch_free_string(&norm);
+        ava->ava_value.bv_val = ava_arena_bvdup(arena, &value_bv);
+        ava->ava_value.bv_len = value_bv.bv_len;
+        ava->ava_private = NULL;
+        return (0);
+    }
+
     if (ber_scanf(ber, "{ao}", &type, &ava->ava_value) == LBER_ERROR) {
         slapi_ch_free_string(&type);
         ava_done(ava);
@@ -194,6 +194,14 @@ extern int ldbm_warn_if_no_db;
  */
 #define FILTER_TEST_THRESHOLD (NIDS)10
 
+/*
+ * Estimated cost of filter testing one candidate, expressed in IDs read
+ * from an index.  The filter planner stops fetching the remaining AND
+ * components once the candidate list times this ratio is cheaper than
+ * reading the next component's IDL.
+ */
+#define FILTER_PLAN_TEST_RATIO (uint64_t)32
+
 /* flags to indicate what kind of startup the dblayer should do */
 #define DBLAYER_IMPORT_MODE                 0x1
 #define DBLAYER_NORMAL_MODE                 0x2
@@ -277,6 +285,9 @@ typedef struct _idlist_set
     IDList *complement_head;
 } IDListSet;
 
+/* Lazily evaluated candidate list, see idl_stream.c */
+typedef struct idl_stream idl_stream;
+
 #define ALLIDS(idl)         ((idl)->b_nmax == ALLIDSBLOCK)
 #define INDIRECT_BLOCK(idl) ((idl)->b_nids == INDBLOCK)
 #define IDL_NIDS(idl)       (idl ? (idl)->b_nids : (NIDS)0)
@@ -438,6 +449,24 @@ struct index_idlistsizeinfo
     Slapi_ValueSet *ai_values; /* index keys to apply the max id list size to */
 };
 
+/*
+ * Per index type key cardinality statistics, see idxstats.c.
+ * ais_ids is maintained incrementally, ais_keys is computed by the
+ * "index statistics" task.
+ */
+typedef struct attr_index_stats
+{
+    uint64_t ais_keys;    /* number of distinct keys */
+    uint64_t ais_ids;     /* number of key/id pairs */
+    time_t ais_refreshed; /* last time the index was walked */
+} attr_index_stats;
+
+#define IDXSTATS_PRES   0
+#define IDXSTATS_EQ     1
+#define IDXSTATS_APPROX 2
+#define IDXSTATS_SUB    3
+#define IDXSTATS_MAX    4
+
 /* for the cache of attribute information (which are indexed, etc.) */
 struct attrinfo
 {
@@ -492,6 +521,7 @@ struct attrinfo
                              */
     Slapi_Attr ai_sattr;                 /* interface to syntax and matching rule plugins */
     DataList *ai_idlistinfo;             /* fine grained id list */
+    attr_index_stats ai_idxstats[IDXSTATS_MAX]; /* key cardinality, used by the filter planner */
 };
 
 struct id_array
@@ -591,6 +621,11 @@ struct ldbminfo
     int li_filter_bypass;       /* bypass filter testing, when possible */
     int li_filter_bypass_check; /* check that filter bypass is doing the right thing */
     int li_use_vlv;             /* use vlv indexes to short-circuit matches when possible */
+    int li_filter_planner;      /* order AND components by estimated cost (filterindex.c) */
+    int li_stream_threshold;    /* stream the candidates of subtree searches above this estimate, 0 = never */
+    uint64_t li_snapshot_cachesize;             /* max memory of the sorted search snapshots, 0 = disabled */
+    struct search_snapshot_cache *li_snapshots; /* sorted search snapshots (search_snapshot.c) */
+    int li_vlv_rebuild_threads; /* threads building the vlv keys in db2index, 0 = hardware threads */
     void *li_identity;          /* The ldbm plugin needs to keep track of its identity so it can
                                  * perform internal ops.  Its identity is given to it when
                                  * its init function is called. */
@@ -785,6 +820,7 @@ typedef struct ldbm_instance
     int require_index;               /* set to 1 to require an index be used in search */
     int require_internalop_index;    /* set to 1 to require an index be used in an internal search */
     struct cache inst_dncache;       /* The dn cache for this instance. */
+    uint64_t inst_snapshot_generation; /* bumped by every write committed to this instance */
 } ldbm_instance;
 
 /*
@@ -805,8 +841,12 @@ typedef struct _back_search_result_set
     int sr_current_sizelimit;     /* Current sizelimit */
     Slapi_Filter *sr_norm_filter; /* search filter pre-normalized */
     Slapi_Filter *sr_norm_filter_intent; /* intended search filter pre-normalized */
+    idl_stream *sr_stream;        /* streamed search results, replaces sr_candidates */
+    char *sr_snapshot_key;        /* key of the sorted candidates to keep (search_snapshot.c) */
+    uint64_t sr_snapshot_generation; /* snapshot generation before building the candidates */
 } back_search_result_set;
 #define SR_FLAG_MUST_APPLY_FILTER_TEST 1 /* If set in sr_flags, means that we MUST apply the filter test */
+#define SR_FLAG_RECORD_FILTER_PLAN     2 /* If set in sr_flags, the filter planner records its plan */
 
 #include "proto-back-ldbm.h"
 #include "ldbm_config.h"
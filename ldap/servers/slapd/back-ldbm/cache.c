@@ -1173,7 +1173,12 @@ entrycache_replace(struct cache *cache, struct backentry *olde, struct backentry
     newuuid = slapi_entry_get_uniqueid(newe->ep_entry);
 #endif
     newndn = slapi_sdn_get_ndn(backentry_get_sdn(newe));
-    entry_size = cache_entry_size(newe);
+    if (newe->ep_size == 0) {
+        entry_size = cache_entry_size(newe);
+    } else {
+        /* updated from the size of olde by the caller (modify) */
+        entry_size = newe->ep_size;
+    }
 
     /* Might have added/removed a referral */
     if (slapi_entry_attr_find(newe->ep_entry, "ref", &attr) && attr) {
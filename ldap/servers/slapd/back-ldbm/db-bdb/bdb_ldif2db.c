@@ -27,6 +27,7 @@
 #define DB2LDIF_ENTRYRDN 0x4      /* export entryrdn */
 #define DB2INDEX_OBJECTCLASS 0x10 /* for reindexing "objectclass: nstombstone" */
 #define DB2INDEX_NSUNIQUEID 0x20  /* for reindexing RUV tombstone */
+#define DB2INDEX_VLV_BATCH 1000   /* entries added to the vlv indexes at once */
 
 #define LDIF2LDBM_EXTBITS(x) ((x)&0xf)
 
@@ -1301,6 +1302,39 @@ bdb_bdb2index_bad_vlv(Slapi_Task *task, ldbm_instance *inst, char *index)
     slapi_ch_free_string(&text);
 }
 
+/*
+ * Add a batch of entries to the vlv indexes being rebuilt, the entries
+ * are freed.
+ */
+static int
+bdb_db2index_vlv_flush(ldbm_instance *inst, Slapi_Task *task, struct vlvIndex **pvlv, int numvlv, struct backentry **batch, int *nbatch, int run_from_cmdline)
+{
+    struct ldbminfo *li = inst->inst_li;
+    int nthreads = li->li_vlv_rebuild_threads;
+    int rc;
+
+    if (nthreads == 0) {
+        nthreads = (int)util_get_hardware_threads();
+    }
+    rc = vlv_rebuild_entries(inst->inst_be, pvlv, numvlv, batch, *nbatch, !run_from_cmdline, nthreads);
+    if (rc) {
+        slapi_log_err(SLAPI_LOG_ERR,
+                      "bdb_db2index", "%s: Failed to update the vlv indexes\n",
+                      inst->inst_name);
+        slapi_log_err(SLAPI_LOG_ERR,
+                      "bdb_db2index", "%s: Error %d: %s\n", inst->inst_name, rc,
+                      dblayer_strerror(rc));
+        slapi_task_log_notice(task,
+                "%s: ERROR: failed to update the vlv indexes (err %d: %s)",
+                inst->inst_name, rc, dblayer_strerror(rc));
+    }
+    for (int i = 0; i < *nbatch; i++) {
+        backentry_free(&batch[i]);
+    }
+    *nbatch = 0;
+    return rc;
+}
+
 int
 bdb_db2index(Slapi_PBlock *pb)
 {
@@ -1335,6 +1369,8 @@ bdb_db2index(Slapi_PBlock *pb)
     ID suffixid = NOID; /* holds the id of the suffix entry */
     Slapi_Value **nstombstone_vals = NULL;
     int istombstone = 0;
+    struct backentry **vlv_batch = NULL; /* entries waiting for the vlv indexes */
+    int nbatch = 0;
 
     slapi_log_err(SLAPI_LOG_TRACE, "bdb_db2index", "=>\n");
     if (g_get_shutdown() || c_get_shutdown()) {
@@ -1570,6 +1606,9 @@ bdb_db2index(Slapi_PBlock *pb)
     }
 
     dblayer_txn_init(li, &txn);
+    if (numvlv) {
+        vlv_batch = (struct backentry **)slapi_ch_calloc(DB2INDEX_VLV_BATCH, sizeof(struct backentry *));
+    }
 
     while (1) {
         if (g_get_shutdown() || c_get_shutdown()) {
@@ -1924,59 +1963,6 @@ bdb_db2index(Slapi_PBlock *pb)
             }
         }
 
-        /*
-         * If it is NOT a tombstone entry, update the Virtual List View indexes.
-         */
-        for (vlvidx = 0; !istombstone && (vlvidx < numvlv); vlvidx++) {
-            char *ai = "Unknown index";
-
-            if (g_get_shutdown() || c_get_shutdown()) {
-                goto err_out;
-            }
-            if (indexAttrs && indexAttrs[vlvidx]) {
-                ai = indexAttrs[vlvidx];
-            }
-            if (!run_from_cmdline) {
-                rc = dblayer_txn_begin(be, NULL, &txn);
-                if (0 != rc) {
-                    slapi_log_err(SLAPI_LOG_ERR,
-                                  "bdb_db2index", "%s: Failed to begin txn for update index '%s'\n",
-                                  inst->inst_name, ai);
-                    slapi_log_err(SLAPI_LOG_ERR,
-                                  "bdb_db2index", "%s: Error %d: %s\n", inst->inst_name, rc,
-                                  dblayer_strerror(rc));
-                    slapi_task_log_notice(task,
-                            "%s: ERROR: failed to begin txn for update index '%s' (err %d: %s)",
-                            inst->inst_name, ai, rc, dblayer_strerror(rc));
-                    return_value = -2;
-                    goto err_out;
-                }
-            }
-            /*
-             * lock is needed around vlv_update_index to protect the
-             * vlv structure.
-             */
-            vlv_acquire_lock(be);
-            vlv_update_index(pvlv[vlvidx], &txn, li, pb, NULL, ep);
-            vlv_release_lock(be);
-            if (!run_from_cmdline) {
-                rc = dblayer_txn_commit(be, &txn);
-                if (0 != rc) {
-                    slapi_log_err(SLAPI_LOG_ERR,
-                                  "bdb_db2index", "%s: Failed to commit txn for update index '%s'\n",
-                                  inst->inst_name, ai);
-                    slapi_log_err(SLAPI_LOG_ERR,
-                                  "bdb_db2index", "%s: Error %d: %s\n", inst->inst_name, rc,
-                                  dblayer_strerror(rc));
-                    slapi_task_log_notice(task,
-                            "%s: ERROR: failed to commit txn for update index '%s' (err %d: %s)",
-                            inst->inst_name, ai, rc, dblayer_strerror(rc));
-                    return_value = -2;
-                    goto err_out;
-                }
-            }
-        }
-
         /*
          * Update the ancestorid and entryrdn index
          */
@@ -2071,9 +2057,30 @@ bdb_db2index(Slapi_PBlock *pb)
                           inst->inst_name, count, percent);
         }
 
+        /*
+         * If it is NOT a tombstone entry, update the Virtual List View indexes.
+         * The keys of a batch of entries are built in parallel, see
+         * vlv_rebuild_entries.
+         */
+        if (!istombstone && numvlv) {
+            vlv_batch[nbatch++] = ep;
+            ep = NULL;
+            if (nbatch == DB2INDEX_VLV_BATCH &&
+                bdb_db2index_vlv_flush(inst, task, pvlv, numvlv, vlv_batch, &nbatch, run_from_cmdline)) {
+                return_value = -2;
+                goto err_out;
+            }
+        }
+
         backentry_free(&ep);
     }
 
+    if (nbatch &&
+        bdb_db2index_vlv_flush(inst, task, pvlv, numvlv, vlv_batch, &nbatch, run_from_cmdline)) {
+        return_value = -2;
+        goto err_out;
+    }
+
     /* if we got here, we finished successfully */
 
     /* activate all the indexes we added */
@@ -2094,6 +2101,10 @@ bdb_db2index(Slapi_PBlock *pb)
     return_value = 0; /* success */
 err_out:
     backentry_free(&ep); /* if ep or *ep is NULL, it does nothing */
+    for (i = 0; i < nbatch; i++) {
+        backentry_free(&vlv_batch[i]);
+    }
+    slapi_ch_free((void **)&vlv_batch);
     if (idl) {
         idl_free(&idl);
     } else {
@@ -757,6 +757,29 @@ dbmdb_task_finish(ImportJob *job, int ret)
     }
 }
 
+/* Bring back online the vlv indexes that were offline and have been rebuilt
+ * (i.e: the ones missing from a replication snapshot)
+ */
+static void
+dbmdb_vlv_go_online(ImportJob *job)
+{
+    ImportCtx_t *ctx = job->writer_ctx;
+    backend *be = job->inst->inst_be;
+    struct vlvSearch *ps = NULL;
+
+    slapi_rwlock_rdlock(be->vlvSearchList_lock);
+    for (ps = (struct vlvSearch *)be->vlvSearchList; ps != NULL; ps = ps->vlv_next) {
+        struct vlvIndex *pi = NULL;
+        for (pi = ps->vlv_index; pi != NULL; pi = pi->vlv_next) {
+            if (!vlvIndex_online(pi) &&
+                is_reindexed_attr(pi->vlv_attrinfo->ai_type, ctx, ctx->indexVlvs)) {
+                vlvIndex_go_online(pi, be);
+            }
+        }
+    }
+    slapi_rwlock_unlock(be->vlvSearchList_lock);
+}
+
 /* when the import is done, this function is called to bring stuff back up.
  * returns 0 on success; anything else is an error
  */
@@ -799,6 +822,9 @@ dbmdb_import_all_done(ImportJob *job, int ret)
              * and these functions have to be reverted accordingly.
              */
             if (job->flags & FLAG_REINDEXING) {
+                if (ret == 0) {
+                    dbmdb_vlv_go_online(job);
+                }
                 instance_set_not_busy(inst);
             } else {
                 slapi_mtn_be_enable(inst->inst_be);
@@ -1660,6 +1686,442 @@ dbmdb_ldbm_back_wire_import(Slapi_PBlock *pb)
     return -1;
 }
 
+/****************************************************************************/
+/******** Snapshot shipping (replication total update) specific code *******/
+/****************************************************************************/
+
+/*
+ * Instead of sending the entries one by one and rebuilding all the indexes
+ * on the consumer, the supplier may walk a read only txn over the backend
+ * databases and the consumer stores the records as they are.
+ * The records of an index that the consumer does not know are dropped
+ * (so the index must be rebuilt on the consumer if it is configured later on)
+ * and the indexes that the consumer has but that got no record from the
+ * snapshot are taken offline then rebuilt by a reindex task once the
+ * backend is online again (that includes the indexes that are empty on the
+ * supplier, which is harmless).
+ */
+typedef struct {
+    char *dbname;           /* Database of the previous record */
+    dbmdb_dbi_t *dbi;       /* Its dbi (NULL if its records are dropped) */
+    dbi_txn_t *txn;
+    uint64_t nbrecords;
+    char **indexes;         /* Indexes that got records from the snapshot */
+    char **missing_attrs;   /* Attribute indexes to rebuild */
+    char **missing_vlvs;    /* VLV indexes to rebuild */
+} dbmdb_snapshot_ctx_t;
+
+/* Number of records installed in a single write txn */
+#define DBMDB_SNAPSHOT_TXN_RECORDS 10000
+
+static int
+dbmdb_snapshot_is_id2entry(const char *dbname)
+{
+    return (strcasecmp(dbname, ID2ENTRY LDBM_FILENAME_SUFFIX) == 0);
+}
+
+int
+dbmdb_snapshot_export(backend *be, back_info_snapshot *info)
+{
+    ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+    struct ldbminfo *li = (struct ldbminfo *)be->be_database->plg_private;
+    dbmdb_ctx_t *ctx = MDB_CONFIG(li);
+    back_info_snapshot_record rec = {0};
+    dbmdb_dbi_t **dbilist = NULL;
+    dbi_txn_t *txn = NULL;
+    MDB_cursor *cur = NULL;
+    MDB_val key = {0};
+    MDB_val data = {0};
+    int size = 0;
+    int cbrc = 0;
+    int rc = 0;
+    int i;
+
+    if (inst->attrcrypt_configured) {
+        /* The consumer does not have the keys of the encrypted attributes */
+        return -1;
+    }
+    if (info->state == BACK_SNAPSHOT_CHECK) {
+        return 0;
+    }
+    if (info->state != BACK_SNAPSHOT_START || info->record_cb == NULL) {
+        return -1;
+    }
+
+    info->nbentries = 0;
+    dbilist = dbmdb_list_dbis(ctx, be, NULL, PR_FALSE, &size);
+    rc = START_TXN(&txn, NULL, TXNFL_RDONLY);
+    for (i = 0; rc == 0 && cbrc == 0 && i < size; i++) {
+        dbmdb_dbi_t *dbi = dbilist[i];
+        const char *fname = strchr(dbi->dbname, '/');
+
+        if (fname == NULL || strstr(fname, CHANGELOG_PATTERN)) {
+            /* The changelog is not part of the snapshot */
+            continue;
+        }
+        fname++;
+        if (dbi->state.state & DBIST_DIRTY) {
+            slapi_log_err(SLAPI_LOG_WARNING, "dbmdb_snapshot_export",
+                          "Database %s is being rebuilt, unable to export backend %s.\n",
+                          dbi->dbname, inst->inst_name);
+            rc = -1;
+            break;
+        }
+        rc = MDB_CURSOR_OPEN(TXN(txn), dbi->dbi, &cur);
+        if (rc) {
+            break;
+        }
+        rec.dbname = (char *)fname;
+        rc = MDB_CURSOR_GET(cur, &key, &data, MDB_FIRST);
+        while (rc == 0) {
+            rec.key.bv_val = key.mv_data;
+            rec.key.bv_len = key.mv_size;
+            rec.data.bv_val = data.mv_data;
+            rec.data.bv_len = data.mv_size;
+            cbrc = info->record_cb(&rec, info->cb_arg);
+            if (cbrc) {
+                break;
+            }
+            if (dbmdb_snapshot_is_id2entry(fname)) {
+                info->nbentries++;
+            }
+            rc = MDB_CURSOR_GET(cur, &key, &data, MDB_NEXT);
+        }
+        MDB_CURSOR_CLOSE(cur);
+        if (rc == MDB_NOTFOUND) {
+            rc = 0;
+        }
+    }
+    if (txn) {
+        /* Read only txn is always aborted */
+        END_TXN(&txn, 0);
+    }
+    slapi_ch_free((void **)&dbilist);
+    if (rc) {
+        slapi_log_err(SLAPI_LOG_ERR, "dbmdb_snapshot_export",
+                      "Failed to export backend %s, error %d: %s\n",
+                      inst->inst_name, rc, dblayer_strerror(rc));
+        return -1;
+    }
+    return cbrc;
+}
+
+/* Find out the dbi of the consumer in which the records are stored */
+static int
+dbmdb_snapshot_open_dbi(backend *be, dbmdb_snapshot_ctx_t *sctx, const char *dbname)
+{
+    int dbi_flags = MDB_CREATE|MDB_MARK_DIRTY_DBI|MDB_OPEN_DIRTY_DBI|MDB_TRUNCATE_DBI;
+    struct attrinfo *ai = NULL;
+    char *type = NULL;
+    size_t len = strlen(dbname);
+    int rc = 0;
+
+    slapi_ch_free_string(&sctx->dbname);
+    sctx->dbname = slapi_ch_strdup(dbname);
+    sctx->dbi = NULL;
+
+    if (len > strlen(LDBM_FILENAME_SUFFIX) &&
+        strcasecmp(dbname + len - strlen(LDBM_FILENAME_SUFFIX), LDBM_FILENAME_SUFFIX) == 0) {
+        len -= strlen(LDBM_FILENAME_SUFFIX);
+    }
+    type = slapi_ch_malloc(len + 1);
+    memcpy(type, dbname, len);
+    type[len] = '\0';
+
+    if (strchr(type, '/') || strstr(type, CHANGELOG_PATTERN)) {
+        /* Not a backend database */
+        goto done;
+    } else if (strcasecmp(type, ID2ENTRY) == 0) {
+        ai = NULL;
+    } else if (strncasecmp(type, "vlv#", 4) == 0) {
+        struct vlvIndex *p = vlv_find_indexname(type, be);
+        if (p == NULL) {
+            goto done;
+        }
+        ai = p->vlv_attrinfo;
+    } else {
+        ainfo_get(be, type, &ai);
+        if (ai == NULL || strcasecmp(ai->ai_type, type) != 0) {
+            /* Index is not configured on this server */
+            goto done;
+        }
+    }
+    rc = dbmdb_open_dbi_from_filename(&sctx->dbi, be, dbname, ai, dbi_flags);
+    if (rc == 0 && ai && !charray_inlist(sctx->indexes, type)) {
+        charray_add(&sctx->indexes, slapi_ch_strdup(type));
+    }
+
+done:
+    if (rc == 0 && sctx->dbi == NULL) {
+        slapi_log_err(SLAPI_LOG_WARNING, "dbmdb_snapshot_open_dbi",
+                      "Backend %s: database %s is not configured locally, its records are ignored.\n",
+                      be->be_name, dbname);
+    }
+    slapi_ch_free_string(&type);
+    return rc;
+}
+
+static int
+dbmdb_snapshot_add(backend *be, dbmdb_snapshot_ctx_t *sctx, back_info_snapshot *info)
+{
+    MDB_val key = {0};
+    MDB_val data = {0};
+    int rc = 0;
+    size_t i;
+
+    for (i = 0; rc == 0 && i < info->nbrecords; i++) {
+        back_info_snapshot_record *rec = &info->records[i];
+
+        if (sctx->dbname == NULL || strcmp(sctx->dbname, rec->dbname) != 0) {
+            /* dbi cannot be opened while a txn is pending */
+            if (sctx->txn) {
+                rc = END_TXN(&sctx->txn, 0);
+            }
+            if (rc == 0) {
+                rc = dbmdb_snapshot_open_dbi(be, sctx, rec->dbname);
+            }
+            if (rc) {
+                break;
+            }
+        }
+        if (sctx->dbi == NULL) {
+            continue;
+        }
+        if (sctx->txn == NULL) {
+            rc = START_TXN(&sctx->txn, NULL, 0);
+            if (rc) {
+                break;
+            }
+        }
+        key.mv_data = rec->key.bv_val;
+        key.mv_size = rec->key.bv_len;
+        data.mv_data = rec->data.bv_val;
+        data.mv_size = rec->data.bv_len;
+        /* Records are walked in the database order so they can usually be appended */
+        rc = MDB_PUT(TXN(sctx->txn), sctx->dbi->dbi, &key, &data,
+                     (sctx->dbi->state.flags & MDB_DUPSORT) ? MDB_APPENDDUP : MDB_APPEND);
+        if (rc == MDB_KEYEXIST) {
+            rc = MDB_PUT(TXN(sctx->txn), sctx->dbi->dbi, &key, &data, 0);
+            if (rc == MDB_KEYEXIST) {
+                /* Same key and data already in a duplicate database */
+                rc = 0;
+            }
+        }
+        if (rc == 0 && dbmdb_snapshot_is_id2entry(rec->dbname)) {
+            info->nbentries++;
+        }
+        if (rc == 0 && (++sctx->nbrecords % DBMDB_SNAPSHOT_TXN_RECORDS) == 0) {
+            rc = END_TXN(&sctx->txn, 0);
+        }
+    }
+    if (sctx->txn) {
+        int rc2 = END_TXN(&sctx->txn, rc);
+        rc = rc ? rc : rc2;
+    }
+    if (rc) {
+        slapi_log_err(SLAPI_LOG_ERR, "dbmdb_snapshot_add",
+                      "Backend %s: failed to store a record in %s, error %d: %s\n",
+                      be->be_name, sctx->dbname ? sctx->dbname : "?", rc, dblayer_strerror(rc));
+    }
+    return rc;
+}
+
+/* avl_apply callback that takes offline the attribute indexes missing from the snapshot */
+static int
+dbmdb_snapshot_check_index(caddr_t data, caddr_t arg)
+{
+    struct attrinfo *ai = (struct attrinfo *)data;
+    dbmdb_snapshot_ctx_t *sctx = (dbmdb_snapshot_ctx_t *)arg;
+
+    if (ai->ai_indexmask == 0 || (ai->ai_indexmask & INDEX_OFFLINE) ||
+        charray_inlist(sctx->indexes, ai->ai_type)) {
+        return 0;
+    }
+    ai->ai_indexmask |= INDEX_OFFLINE;
+    charray_add(&sctx->missing_attrs, slapi_ch_strdup(ai->ai_type));
+    return 0;
+}
+
+/* Take offline the indexes that are configured but missing from the snapshot */
+static void
+dbmdb_snapshot_check_indexes(backend *be, dbmdb_snapshot_ctx_t *sctx)
+{
+    ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+    struct vlvSearch *ps = NULL;
+
+    avl_apply(inst->inst_attrs, dbmdb_snapshot_check_index, (caddr_t)sctx, -1, AVL_INORDER);
+
+    slapi_rwlock_rdlock(be->vlvSearchList_lock);
+    for (ps = (struct vlvSearch *)be->vlvSearchList; ps != NULL; ps = ps->vlv_next) {
+        struct vlvIndex *pi = NULL;
+        for (pi = ps->vlv_index; pi != NULL; pi = pi->vlv_next) {
+            if (pi->vlv_name && vlvIndex_online(pi) &&
+                !charray_inlist(sctx->indexes, pi->vlv_attrinfo->ai_type)) {
+                vlvIndex_go_offline(pi, be);
+                charray_add(&sctx->missing_vlvs, slapi_ch_strdup(pi->vlv_name));
+            }
+        }
+    }
+    slapi_rwlock_unlock(be->vlvSearchList_lock);
+}
+
+/* Start a reindex task for the indexes taken offline by dbmdb_snapshot_check_indexes */
+static void
+dbmdb_snapshot_reindex(backend *be, dbmdb_snapshot_ctx_t *sctx)
+{
+    ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+    struct ldbminfo *li = (struct ldbminfo *)be->be_database->plg_private;
+    Slapi_PBlock *pb = NULL;
+    Slapi_Entry *e = NULL;
+    char *cn = NULL;
+    int rc = 0;
+    size_t i;
+
+    if (sctx->missing_attrs == NULL && sctx->missing_vlvs == NULL) {
+        return;
+    }
+    cn = slapi_ch_smprintf("snapshot_%s_%ld", inst->inst_name, (long)slapi_current_utc_time());
+    e = slapi_entry_alloc();
+    slapi_entry_init(e, slapi_create_dn_string("cn=%s,cn=index,cn=tasks,cn=config", cn), NULL);
+    slapi_entry_add_string(e, "objectclass", "top");
+    slapi_entry_add_string(e, "objectclass", "extensibleObject");
+    slapi_entry_add_string(e, "cn", cn);
+    slapi_entry_add_string(e, "nsInstance", inst->inst_name);
+    for (i = 0; sctx->missing_attrs && sctx->missing_attrs[i]; i++) {
+        slapi_log_err(SLAPI_LOG_WARNING, "dbmdb_snapshot_reindex",
+                      "Backend %s: index %s is not in the snapshot, it is offline until it is rebuilt.\n",
+                      inst->inst_name, sctx->missing_attrs[i]);
+        slapi_entry_add_string(e, "nsIndexAttribute", sctx->missing_attrs[i]);
+    }
+    for (i = 0; sctx->missing_vlvs && sctx->missing_vlvs[i]; i++) {
+        slapi_log_err(SLAPI_LOG_WARNING, "dbmdb_snapshot_reindex",
+                      "Backend %s: vlv index %s is not in the snapshot, it is offline until it is rebuilt.\n",
+                      inst->inst_name, sctx->missing_vlvs[i]);
+        slapi_entry_add_string(e, "nsIndexVlvAttribute", sctx->missing_vlvs[i]);
+    }
+
+    pb = slapi_pblock_new();
+    slapi_add_entry_internal_set_pb(pb, e, NULL, li->li_identity, 0);
+    slapi_add_internal_pb(pb);
+    slapi_pblock_get(pb, SLAPI_PLUGIN_INTOP_RESULT, &rc);
+    slapi_pblock_destroy(pb);
+    if (rc != LDAP_SUCCESS) {
+        slapi_log_err(SLAPI_LOG_ERR, "dbmdb_snapshot_reindex",
+                      "Backend %s: failed to start the reindex task %s (%d), "
+                      "the offline indexes must be rebuilt manually.\n",
+                      inst->inst_name, cn, rc);
+    }
+    slapi_ch_free_string(&cn);
+}
+
+static void
+dbmdb_snapshot_free_ctx(back_info_snapshot *info)
+{
+    dbmdb_snapshot_ctx_t *sctx = (dbmdb_snapshot_ctx_t *)info->state_priv;
+
+    slapi_ch_free_string(&sctx->dbname);
+    charray_free(sctx->indexes);
+    charray_free(sctx->missing_attrs);
+    charray_free(sctx->missing_vlvs);
+    slapi_ch_free((void **)&info->state_priv);
+}
+
+int
+dbmdb_snapshot_import(backend *be, back_info_snapshot *info)
+{
+    ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+    dbmdb_snapshot_ctx_t *sctx = (dbmdb_snapshot_ctx_t *)info->state_priv;
+    int rc = 0;
+
+    switch (info->state) {
+    case BACK_SNAPSHOT_CHECK:
+        /* The entries would be stored unencrypted */
+        return inst->attrcrypt_configured ? -1 : 0;
+    case BACK_SNAPSHOT_START:
+        if (inst->attrcrypt_configured) {
+            return -1;
+        }
+        PR_Lock(inst->inst_config_mutex);
+        if (inst->inst_flags & INST_FLAG_BUSY) {
+            PR_Unlock(inst->inst_config_mutex);
+            slapi_log_err(SLAPI_LOG_WARNING, "dbmdb_snapshot_import",
+                          "'%s' is already in the middle of another task and cannot be disturbed.\n",
+                          inst->inst_name);
+            return SLAPI_BI_ERR_BUSY;
+        }
+        inst->inst_flags |= INST_FLAG_BUSY;
+        PR_Unlock(inst->inst_config_mutex);
+
+        /* Same as the bulk import: take the backend offline and clear it */
+        slapi_mtn_be_disable(be);
+        cache_clear(&inst->inst_cache, CACHE_TYPE_ENTRY);
+        cache_clear(&inst->inst_dncache, CACHE_TYPE_DN);
+        dblayer_instance_close(be);
+        dbmdb_delete_instance_dir(be);
+        rc = dbmdb_instance_start(be, DBLAYER_IMPORT_MODE);
+        if (rc) {
+            instance_set_not_busy(inst);
+            return rc;
+        }
+        info->nbentries = 0;
+        info->state_priv = slapi_ch_calloc(1, sizeof(dbmdb_snapshot_ctx_t));
+        slapi_log_err(SLAPI_LOG_INFO, "dbmdb_snapshot_import",
+                      "Backend %s: installing a snapshot of the supplier databases.\n",
+                      inst->inst_name);
+        return 0;
+    case BACK_SNAPSHOT_ADD:
+        if (sctx == NULL) {
+            return -1;
+        }
+        return dbmdb_snapshot_add(be, sctx, info);
+    case BACK_SNAPSHOT_DONE:
+    case BACK_SNAPSHOT_ABORT:
+        if (sctx == NULL) {
+            return -1;
+        }
+        cache_clear(&inst->inst_cache, CACHE_TYPE_ENTRY);
+        cache_clear(&inst->inst_dncache, CACHE_TYPE_DN);
+        if (info->state == BACK_SNAPSHOT_ABORT) {
+            /* Do not leave half a database. As after a failed bulk import,
+             * the backend stays disabled in the mapping tree and, once
+             * restarted, the empty database has no RUV so the suppliers
+             * report that the replica must be initialized.
+             */
+            dbmdb_snapshot_free_ctx(info);
+            dblayer_instance_close(be);
+            dbmdb_delete_instance_dir(be);
+            instance_set_not_busy(inst);
+            slapi_log_err(SLAPI_LOG_ERR, "dbmdb_snapshot_import",
+                          "Backend %s: snapshot installation aborted, the backend is left "
+                          "empty and offline until it is reinitialized.\n",
+                          inst->inst_name);
+            return -1;
+        }
+        dbmdb_clear_dirty_flags(be);
+        dblayer_instance_close(be);
+        rc = dbmdb_instance_start(be, DBLAYER_NORMAL_MODE);
+        if (rc == 0) {
+            /* Reset USN slapi_counter with the last key of the entryUSN index */
+            ldbm_set_last_usn(be);
+            /* Searches must not use the empty indexes */
+            dbmdb_snapshot_check_indexes(be, sctx);
+            slapi_be_set_flag(be, SLAPI_BE_FLAG_POST_IMPORT);
+            slapi_mtn_be_enable(be);
+            slapi_log_err(SLAPI_LOG_INFO, "dbmdb_snapshot_import",
+                          "Backend %s is now online (%" PRIu64 " entries installed).\n",
+                          inst->inst_name, info->nbentries);
+        }
+        instance_set_not_busy(inst);
+        if (rc == 0) {
+            dbmdb_snapshot_reindex(be, sctx);
+        }
+        dbmdb_snapshot_free_ctx(info);
+        return rc;
+    default:
+        return -1;
+    }
+}
+
 /*
  * Debug function (to use when debbuging with gdb)
  */
@@ -1542,6 +1542,14 @@ dbmdb_back_ctrl(Slapi_Backend *be, int cmd, void *info)
         slapi_pblock_destroy(pb);
         break;
     }
+    case BACK_INFO_SNAPSHOT_EXPORT: {
+        rc = dbmdb_snapshot_export(be, (back_info_snapshot *)info);
+        break;
+    }
+    case BACK_INFO_SNAPSHOT_IMPORT: {
+        rc = dbmdb_snapshot_import(be, (back_info_snapshot *)info);
+        break;
+    }
     default:
         break;
     }
@@ -397,6 +397,8 @@ int dbmdb_import_file_check(ldbm_instance *inst);
 void dbmdb_import_configure_index_buffer_size(size_t size);
 size_t dbmdb_import_get_index_buffer_size(void);
 int dbmdb_ldbm_back_wire_import(Slapi_PBlock *pb);
+int dbmdb_snapshot_export(backend *be, back_info_snapshot *info);
+int dbmdb_snapshot_import(backend *be, back_info_snapshot *info);
 void *dbmdb_factory_constructor(void *object, void *parent);
 void dbmdb_factory_destructor(void *extension, void *object, void *parent);
 int dbmdb_check_db_version(struct ldbminfo *li, int *action);
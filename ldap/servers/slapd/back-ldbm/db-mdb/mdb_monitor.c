@@ -59,6 +59,7 @@ dbmdb_monitor_instance_search(Slapi_PBlock *pb __attribute__((unused)),
     uint64_t nentries;
     int64_t maxentries;
     uint64_t size, maxsize;
+    uint64_t cachemem = 0;
     dbmdb_stats_t *stats = NULL;
     int i, j, flags;
 
@@ -107,6 +108,7 @@ dbmdb_monitor_instance_search(Slapi_PBlock *pb __attribute__((unused)),
     MSET("currentEntryCacheCount");
     sprintf(buf, "%" PRId64, maxentries);
     MSET("maxEntryCacheCount");
+    cachemem = size;
 
     /* fetch cache statistics */
     cache_get_stats(&(inst->inst_dncache), &hits, &tries,
@@ -125,6 +127,15 @@ dbmdb_monitor_instance_search(Slapi_PBlock *pb __attribute__((unused)),
     MSET("currentDnCacheCount");
     sprintf(buf, "%" PRId64, maxentries);
     MSET("maxDnCacheCount");
+    cachemem += size;
+
+    /* memory used by this backend in the caches, for capacity planning */
+    size = search_snapshot_get_be_size(li, inst->inst_be);
+    sprintf(buf, "%" PRIu64, size);
+    MSET("currentSearchSnapshotSize");
+    cachemem += size;
+    sprintf(buf, "%" PRIu64, cachemem);
+    MSET("currentCacheMemorySize");
 
 #ifdef DEBUG
     {
@@ -243,6 +254,26 @@ dbmdb_monitor_search(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_Entry *entryAfter,
         MSET("currentNormalizedDnCacheCount");
     }
 
+    /* sorted search snapshots */
+    search_snapshot_get_stats(li, &hits, &tries, &size, &count);
+    sprintf(buf, "%" PRIu64, tries);
+    MSET("searchSnapshotTries");
+    sprintf(buf, "%" PRIu64, hits);
+    MSET("searchSnapshotHits");
+    sprintf(buf, "%" PRIu64, size);
+    MSET("currentSearchSnapshotSize");
+    sprintf(buf, "%" PRIu64, count);
+    MSET("currentSearchSnapshotCount");
+
+    /* virtual attributes cached in the entries */
+    sprintf(buf, "%" PRIu64, slapi_entry_vattrcache_size());
+    MSET("currentVattrCacheSize");
+    slapi_entry_vattrcache_get_stats(&hits, &tries);
+    sprintf(buf, "%" PRIu64, tries);
+    MSET("vattrCacheTries");
+    sprintf(buf, "%" PRIu64, hits);
+    MSET("vattrCacheHits");
+
     *returncode = LDAP_SUCCESS;
     return SLAPI_DSE_CALLBACK_OK;
 }
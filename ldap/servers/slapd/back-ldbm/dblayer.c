@@ -75,6 +75,8 @@
 #define PREFIX_ENV "PREFIX"
 
 static int dblayer_post_restore = 0;
+static backend **dblayer_pvt_txn_take_written(back_txn *txn, size_t *count);
+static void dblayer_pvt_txn_written(backend *be, backend **written, size_t count);
 
 #define MEGABYTE (1024 * 1024)
 #define GIGABYTE (1024 * MEGABYTE)
@@ -807,7 +809,11 @@ int
 dblayer_txn_commit(backend *be, back_txn *txn)
 {
     struct ldbminfo *li = (struct ldbminfo *)be->be_database->plg_private;
+    backend **written = NULL;
+    size_t nwritten = 0;
     int rc;
+
+    written = dblayer_pvt_txn_take_written(txn, &nwritten);
     if (DBLOCK_INSIDE_TXN(li)) {
         if (SERIALLOCK(li)) {
             dblayer_unlock_backend(be);
@@ -819,6 +825,11 @@ dblayer_txn_commit(backend *be, back_txn *txn)
             dblayer_unlock_backend(be);
         }
     }
+    if (rc == 0) {
+        /* the sorted search snapshots of be may not match the database anymore */
+        dblayer_pvt_txn_written(be, written, nwritten);
+    }
+    slapi_ch_free((void **)&written);
     return rc;
 }
 
@@ -1384,6 +1395,8 @@ typedef struct dblayer_txn_stack
 {
     PRCList list;
     back_txn txn;
+    backend **written; /* backends written by the nested txns committed so far */
+    size_t nwritten;
 } dblayer_txn_stack;
 
 static void
@@ -1393,6 +1406,7 @@ dblayer_cleanup_txn_stack(void *arg)
     while (txn_stack && !PR_CLIST_IS_EMPTY(&txn_stack->list)) {
         dblayer_txn_stack *elem = (dblayer_txn_stack *)PR_LIST_HEAD(&txn_stack->list);
         PR_REMOVE_LINK(&elem->list);
+        slapi_ch_free((void **)&elem->written);
         slapi_ch_free((void **)&elem);
     }
     if (txn_stack) {
@@ -1442,11 +1456,76 @@ dblayer_pop_pvt_txn(void)
     if (txn_stack && !PR_CLIST_IS_EMPTY(&txn_stack->list)) {
         elem = (dblayer_txn_stack *)PR_LIST_TAIL(&txn_stack->list);
         PR_REMOVE_LINK(&elem->list);
+        slapi_ch_free((void **)&elem->written);
         slapi_ch_free((void **)&elem);
     }
     return;
 }
 
+/*
+ * A nested txn is only visible once its parent commits: the backends it
+ * wrote are kept with the parent txn, and the search snapshots of all of
+ * them are invalidated when the outermost txn commits.
+ *
+ * Take the backends recorded with txn, if it is the current txn, before
+ * it is committed (the commit pops it from the stack).
+ */
+static backend **
+dblayer_pvt_txn_take_written(back_txn *txn, size_t *count)
+{
+    dblayer_txn_stack *txn_stack = PR_GetThreadPrivate(thread_private_txn_stack);
+    dblayer_txn_stack *elem = NULL;
+    backend **written = NULL;
+
+    *count = 0;
+    if (txn_stack && !PR_CLIST_IS_EMPTY(&txn_stack->list)) {
+        elem = (dblayer_txn_stack *)PR_LIST_TAIL(&txn_stack->list);
+        if (txn == NULL || txn->back_txn_txn == NULL || elem->txn.back_txn_txn == txn->back_txn_txn) {
+            written = elem->written;
+            *count = elem->nwritten;
+            elem->written = NULL;
+            elem->nwritten = 0;
+        }
+    }
+    return written;
+}
+
+static void
+dblayer_pvt_txn_add_written(dblayer_txn_stack *elem, backend *be)
+{
+    for (size_t i = 0; i < elem->nwritten; i++) {
+        if (elem->written[i] == be) {
+            return;
+        }
+    }
+    elem->written = (backend **)slapi_ch_realloc((char *)elem->written,
+                                                 (elem->nwritten + 1) * sizeof(backend *));
+    elem->written[elem->nwritten++] = be;
+}
+
+/* be, and the backends written by the nested txns, were committed */
+static void
+dblayer_pvt_txn_written(backend *be, backend **written, size_t count)
+{
+    dblayer_txn_stack *txn_stack = PR_GetThreadPrivate(thread_private_txn_stack);
+
+    if (txn_stack && !PR_CLIST_IS_EMPTY(&txn_stack->list)) {
+        /* still in the parent txn */
+        dblayer_txn_stack *parent = (dblayer_txn_stack *)PR_LIST_TAIL(&txn_stack->list);
+        dblayer_pvt_txn_add_written(parent, be);
+        for (size_t i = 0; i < count; i++) {
+            dblayer_pvt_txn_add_written(parent, written[i]);
+        }
+        return;
+    }
+    search_snapshot_invalidate(be);
+    for (size_t i = 0; i < count; i++) {
+        if (written[i] != be) {
+            search_snapshot_invalidate(written[i]);
+        }
+    }
+}
+
 void
 dblayer_destroy_txn_stack(void)
 {
@@ -719,6 +719,233 @@ filter_is_subtype(Slapi_Filter *f)
     return issubtype;
 }
 
+/*
+ * Filter planner
+ *
+ * Without the planner list_candidates fetches the IDL of every AND
+ * component in filter order.  When nsslapd-search-filter-planner is on,
+ * the components are ranked by the number of IDs they are expected to
+ * return (index key cardinality, see idxstats.c) and fetched cheapest
+ * first.  Once the partial intersection is small enough that filter
+ * testing its candidates is cheaper than reading the next IDL, the
+ * remaining components are not fetched at all and the filter test is
+ * forced instead.
+ */
+#define FILTER_PLAN_COST_UNKNOWN (UINT64_MAX - 1) /* indexed, no statistics */
+#define FILTER_PLAN_COST_ALLIDS  UINT64_MAX       /* unindexed */
+
+typedef struct filter_plan_step
+{
+    Slapi_Filter *fps_filter;
+    uint64_t fps_cost;  /* estimated number of IDs returned */
+    size_t fps_order;   /* position in the filter, keeps the sort stable */
+    int fps_isnot;      /* !(attr=value) component, subtracted from the set */
+    int64_t fps_nids;   /* IDs actually returned, -1 if not fetched */
+} filter_plan_step;
+
+static uint64_t
+filter_plan_index_cost(backend *be, Slapi_Filter *f, const char *indextype, int indexmask)
+{
+    struct attrinfo *ai = NULL;
+    char *type = NULL;
+    char *basetype;
+    char typebuf[SLAPD_TYPICAL_ATTRIBUTE_NAME_MAX_LENGTH];
+
+    if (slapi_filter_get_attribute_type(f, &type) != 0 || type == NULL) {
+        return FILTER_PLAN_COST_UNKNOWN;
+    }
+    basetype = slapi_attr_basetype(type, typebuf, sizeof(typebuf));
+    ainfo_get(be, basetype ? basetype : typebuf, &ai);
+    slapi_ch_free_string(&basetype);
+
+    if (ai == NULL || !(ai->ai_indexmask & indexmask) || (ai->ai_indexmask & INDEX_OFFLINE)) {
+        return FILTER_PLAN_COST_ALLIDS;
+    }
+    if (ai->ai_idxstats[idxstats_type2slot(indextype)].ais_refreshed == 0) {
+        /* the statistics task never ran on this index */
+        return FILTER_PLAN_COST_UNKNOWN;
+    }
+    return idxstats_estimate(ai, indextype);
+}
+
+static uint64_t
+filter_plan_estimate(backend *be, Slapi_Filter *f)
+{
+    Slapi_Filter *sub;
+    uint64_t cost, subcost;
+
+    switch (slapi_filter_get_choice(f)) {
+    case LDAP_FILTER_EQUALITY:
+        return filter_plan_index_cost(be, f, indextype_EQUALITY, INDEX_EQUALITY);
+    case LDAP_FILTER_APPROX:
+        return filter_plan_index_cost(be, f, indextype_APPROX, INDEX_APPROX);
+    case LDAP_FILTER_SUBSTRINGS:
+        return filter_plan_index_cost(be, f, indextype_SUB, INDEX_SUB);
+    case LDAP_FILTER_PRESENT:
+        return filter_plan_index_cost(be, f, indextype_PRESENCE, INDEX_PRESENCE);
+    case LDAP_FILTER_GE:
+    case LDAP_FILTER_LE:
+        /* a single bound matches half of the indexed IDs on average */
+        cost = filter_plan_index_cost(be, f, indextype_EQUALITY, INDEX_EQUALITY);
+        if (cost < FILTER_PLAN_COST_UNKNOWN) {
+            struct attrinfo *ai = NULL;
+            char *type = NULL;
+
+            slapi_filter_get_attribute_type(f, &type);
+            ainfo_get(be, type, &ai);
+            if (ai) {
+                cost = slapi_atomic_load_64(&ai->ai_idxstats[IDXSTATS_EQ].ais_ids, __ATOMIC_RELAXED) / 2;
+            }
+        }
+        return cost;
+    case LDAP_FILTER_AND:
+        cost = FILTER_PLAN_COST_UNKNOWN;
+        for (sub = slapi_filter_list_first(f); sub; sub = slapi_filter_list_next(f, sub)) {
+            subcost = filter_plan_estimate(be, sub);
+            if (subcost < cost) {
+                cost = subcost;
+            }
+        }
+        return cost;
+    case LDAP_FILTER_OR:
+        cost = 0;
+        for (sub = slapi_filter_list_first(f); sub; sub = slapi_filter_list_next(f, sub)) {
+            subcost = filter_plan_estimate(be, sub);
+            if (subcost >= FILTER_PLAN_COST_UNKNOWN) {
+                return subcost;
+            }
+            cost = (cost + subcost < cost) ? FILTER_PLAN_COST_UNKNOWN : cost + subcost;
+        }
+        return cost;
+    default:
+        return FILTER_PLAN_COST_UNKNOWN;
+    }
+}
+
+static int
+filter_plan_step_cmp(const void *a, const void *b)
+{
+    const filter_plan_step *sa = (const filter_plan_step *)a;
+    const filter_plan_step *sb = (const filter_plan_step *)b;
+
+    /* complements never shrink the intersection, apply them last */
+    if (sa->fps_isnot != sb->fps_isnot) {
+        return sa->fps_isnot - sb->fps_isnot;
+    }
+    if (sa->fps_cost != sb->fps_cost) {
+        return (sa->fps_cost < sb->fps_cost) ? -1 : 1;
+    }
+    return (sa->fps_order < sb->fps_order) ? -1 : 1;
+}
+
+/*
+ * Is it cheaper to filter test the current candidates than to
+ * read the IDL of the next component ?
+ */
+static int
+filter_plan_should_stop(IDListSet *idl_set, filter_plan_step *next)
+{
+    if (idl_set->minimum == NULL || next->fps_cost == FILTER_PLAN_COST_UNKNOWN) {
+        return 0;
+    }
+    return ((uint64_t)idl_set->minimum->b_nids * FILTER_PLAN_TEST_RATIO) < next->fps_cost;
+}
+
+static int
+filter_plan_is_recorded(back_search_result_set *sr)
+{
+    return (sr && (sr->sr_flags & SR_FLAG_RECORD_FILTER_PLAN)) ||
+           (LDAP_STAT_FILTER_PLAN & config_get_statlog_level());
+}
+
+static const char *
+filter_plan_choice2str(Slapi_Filter *f, int isnot)
+{
+    if (isnot) {
+        return "not";
+    }
+    switch (slapi_filter_get_choice(f)) {
+    case LDAP_FILTER_EQUALITY:
+        return "eq";
+    case LDAP_FILTER_APPROX:
+        return "approx";
+    case LDAP_FILTER_SUBSTRINGS:
+        return "sub";
+    case LDAP_FILTER_PRESENT:
+        return "pres";
+    case LDAP_FILTER_GE:
+        return "ge";
+    case LDAP_FILTER_LE:
+        return "le";
+    case LDAP_FILTER_AND:
+        return "and";
+    case LDAP_FILTER_OR:
+        return "or";
+    case LDAP_FILTER_NOT:
+        return "not";
+    default:
+        return "ext";
+    }
+}
+
+/*
+ * Append the plan of one AND component list to the operation, it is
+ * returned in the filter plan response control and logged in the stat log.
+ * Example: AND[uid:eq est=1 got=1, objectclass:eq est=250000 skipped]
+ */
+static void
+filter_plan_record(Slapi_PBlock *pb, filter_plan_step *plan, size_t nsteps)
+{
+    Op_stat *op_stat = op_stat_get_operation_extension(pb);
+    char *str = slapi_ch_strdup("AND[");
+    char *tmp;
+
+    if (op_stat == NULL || op_stat->search_stat == NULL) {
+        slapi_ch_free_string(&str);
+        return;
+    }
+    for (size_t i = 0; i < nsteps; i++) {
+        Slapi_Filter *f = plan[i].fps_filter;
+        char *type = NULL;
+        char est[32];
+        char got[32];
+
+        if (plan[i].fps_isnot) {
+            f = slapi_filter_list_first(f);
+        }
+        if (slapi_filter_get_attribute_type(f, &type) != 0 || type == NULL) {
+            type = "-";
+        }
+        if (plan[i].fps_cost == FILTER_PLAN_COST_ALLIDS) {
+            PL_strncpyz(est, "allids", sizeof(est));
+        } else if (plan[i].fps_cost == FILTER_PLAN_COST_UNKNOWN) {
+            PL_strncpyz(est, "?", sizeof(est));
+        } else {
+            snprintf(est, sizeof(est), "%" PRIu64, plan[i].fps_cost);
+        }
+        if (plan[i].fps_nids == -1) {
+            PL_strncpyz(got, "skipped", sizeof(got));
+        } else if (plan[i].fps_nids < 0) {
+            PL_strncpyz(got, "got=allids", sizeof(got));
+        } else {
+            snprintf(got, sizeof(got), "got=%" PRId64, plan[i].fps_nids);
+        }
+        tmp = slapi_ch_smprintf("%s%s%s:%s est=%s %s", str, i ? ", " : "", type,
+                                filter_plan_choice2str(plan[i].fps_filter, plan[i].fps_isnot), est, got);
+        slapi_ch_free_string(&str);
+        str = tmp;
+    }
+
+    if (op_stat->search_stat->filter_plan) {
+        tmp = slapi_ch_smprintf("%s %s]", op_stat->search_stat->filter_plan, str);
+        slapi_ch_free_string(&op_stat->search_stat->filter_plan);
+    } else {
+        tmp = slapi_ch_smprintf("%s]", str);
+    }
+    slapi_ch_free_string(&str);
+    op_stat->search_stat->filter_plan = tmp;
+}
+
 static IDList *
 list_candidates(
     Slapi_PBlock *pb,
@@ -731,7 +958,7 @@ list_candidates(
 {
     IDList *idl;
     IDList *tmp;
-    Slapi_Filter *f, *nextf, *f_head;
+    Slapi_Filter *f, *nextf;
     int range = 0;
     int isnot;
     int f_count = 0, le_count = 0, ge_count = 0, is_bounded_range = 1;
@@ -743,6 +970,11 @@ list_candidates(
     int is_and = 0;
     IDListSet *idl_set = NULL;
     back_search_result_set *sr = NULL;
+    struct ldbminfo *li = (struct ldbminfo *)be->be_database->plg_private;
+    filter_plan_step *plan = NULL;
+    size_t nsteps = 0;
+    size_t i;
+    int planned = 0;
 
     slapi_pblock_get(pb, SLAPI_SEARCH_RESULT_SET, &sr);
 
@@ -842,22 +1074,50 @@ list_candidates(
         idl_set = idl_set_create();
     }
 
+    /*
+     * Build the evaluation order of the components. Unless the planner
+     * reorders an AND, it is the filter order.
+     */
+    for (f = slapi_filter_list_first(flist); f != NULL; f = slapi_filter_list_next(flist, f)) {
+        nsteps++;
+    }
+    plan = (filter_plan_step *)slapi_ch_calloc(nsteps ? nsteps : 1, sizeof(filter_plan_step));
+    nsteps = 0;
+    for (f = slapi_filter_list_first(flist); f != NULL; f = slapi_filter_list_next(flist, f)) {
+        if (fpairs[0] == f) {
+            /* evaluated together with fpairs[1] */
+            continue;
+        }
+        plan[nsteps].fps_filter = f;
+        plan[nsteps].fps_order = nsteps;
+        plan[nsteps].fps_nids = -1;
+        /* Look for NOT foo type filter elements where foo is simple equality */
+        plan[nsteps].fps_isnot = (LDAP_FILTER_NOT == slapi_filter_get_choice(f)) &&
+                                 (LDAP_FILTER_AND == ftype &&
+                                  (LDAP_FILTER_EQUALITY == slapi_filter_get_choice(slapi_filter_list_first(f))));
+        nsteps++;
+    }
+    if (ftype == LDAP_FILTER_AND && nsteps > 1 && li->li_filter_planner) {
+        planned = 1;
+        for (i = 0; i < nsteps; i++) {
+            f = plan[i].fps_filter;
+            plan[i].fps_cost = filter_plan_estimate(be, plan[i].fps_isnot ? slapi_filter_list_first(f) : f);
+        }
+        qsort(plan, nsteps, sizeof(filter_plan_step), filter_plan_step_cmp);
+    }
+
     idl = NULL;
     nextf = NULL;
-    for (f_head = f = slapi_filter_list_first(flist); f != NULL;
-         f = slapi_filter_list_next(flist, f)) {
-
-        /* Look for NOT foo type filter elements where foo is simple equality */
-        isnot = (LDAP_FILTER_NOT == slapi_filter_get_choice(f)) &&
-                (LDAP_FILTER_AND == ftype &&
-                 (LDAP_FILTER_EQUALITY == slapi_filter_get_choice(slapi_filter_list_first(f))));
+    for (i = 0; i < nsteps; i++) {
+        f = plan[i].fps_filter;
+        isnot = plan[i].fps_isnot;
 
         if (isnot) {
             /*
              * If this is the first filter, make sure we have something to
              * subtract from.
              */
-            if (f == f_head) {
+            if (i == 0) {
                 idl = idl_allids(be);
                 idl_set_insert_idl(idl_set, idl);
             }
@@ -881,9 +1141,7 @@ list_candidates(
                                      LDAP_FILTER_EQUALITY, nextf, range, err, allidslimit);
             }
         } else {
-            if (fpairs[0] == f) {
-                continue;
-            } else if (fpairs[1] == f) {
+            if (fpairs[1] == f) {
                 Slapi_Attr sattr;
 
                 slapi_attr_init(&sattr, tpairs[0]);
@@ -915,6 +1173,7 @@ list_candidates(
         if (tmp == NULL) {
             tmp = idl_alloc(0);
         }
+        plan[i].fps_nids = idl_is_allids(tmp) ? (int64_t)-2 : (int64_t)IDL_NIDS(tmp);
 
         /*
          * At this point we have the idl set from the subfilter. In idl_set,
@@ -948,6 +1207,19 @@ list_candidates(
             sr->sr_flags |= SR_FLAG_MUST_APPLY_FILTER_TEST;
             goto apply_set_op;
         }
+
+        if (planned && sr && i + 1 < nsteps && filter_plan_should_stop(idl_set, &plan[i + 1])) {
+            /*
+             * The remaining components are more expensive to read than
+             * testing the candidates we already have against the filter.
+             */
+            slapi_log_err(SLAPI_LOG_FILTER, "list_candidates",
+                          "planner skips %lu component(s) - must apply filter test\n",
+                          (u_long)(nsteps - i - 1));
+            sr->sr_flags |= SR_FLAG_MUST_APPLY_FILTER_TEST;
+            slapi_pblock_set_flag_operation_notes(pb, SLAPI_OP_NOTE_FILTER_PLANNED);
+            goto apply_set_op;
+        }
     }
 
     /*
@@ -975,7 +1247,11 @@ apply_set_op:
     }
 
     slapi_log_err(SLAPI_LOG_TRACE, "list_candidates", "<= idl len %lu\n", (u_long)IDL_NIDS(idl));
+    if (planned && filter_plan_is_recorded(sr)) {
+        filter_plan_record(pb, plan, nsteps);
+    }
 out:
+    slapi_ch_free((void **)&plan);
     idl_set_destroy(idl_set);
     if (is_and) {
         /*
@@ -1180,3 +1456,164 @@ keys2idl(
 
     return (idl);
 }
+
+/*
+ * Estimated number of candidates of a filter from the index statistics,
+ * UINT64_MAX - 1 when unknown, UINT64_MAX when not indexed.
+ */
+uint64_t
+filter_candidates_estimate(backend *be, Slapi_Filter *f)
+{
+    return filter_plan_estimate(be, f);
+}
+
+/*
+ * Stream the key of an equality or presence component. NULL is returned if
+ * the key can not be streamed, and *fallback is set if filter_candidates
+ * would not use the index for it (unindexed or offline index, ids over the
+ * allids limit, nsIndexIDListScanLimit set on the attribute, invalid
+ * attribute): the search must then use filter_candidates, which sets the
+ * notes and applies nsslapd-require-index.
+ */
+static idl_stream *
+filter_stream_index_key(backend *be, Slapi_Filter *f, int ftype, int allidslimit, int *fallback)
+{
+    struct ldbminfo *li = (struct ldbminfo *)be->be_database->plg_private;
+    struct attrinfo *ai = NULL;
+    char *type = NULL;
+    struct berval *bval = NULL;
+    char *basetype;
+    char typebuf[SLAPD_TYPICAL_ATTRIBUTE_NAME_MAX_LENGTH];
+    Slapi_Attr sattr;
+    Slapi_Value sv;
+    Slapi_Value **ivals = NULL;
+    idl_stream *s = NULL;
+    uint64_t count = 0;
+    size_t limit;
+
+    if (f->f_flags & (SLAPI_FILTER_INVALID_ATTR_WARN | SLAPI_FILTER_INVALID_ATTR_UNDEFINE)) {
+        /* keep the notes and the rejection of filter_candidates */
+        *fallback = 1;
+        return NULL;
+    }
+    if (ftype == LDAP_FILTER_PRESENT) {
+        if (slapi_filter_get_type(f, &type) != 0) {
+            return NULL;
+        }
+    } else if (slapi_filter_get_ava(f, &type, &bval) != 0) {
+        return NULL;
+    }
+
+    basetype = slapi_attr_basetype(type, typebuf, sizeof(typebuf));
+    ainfo_get(be, basetype ? basetype : typebuf, &ai);
+    slapi_ch_free_string(&basetype);
+    if (ai == NULL || (ai->ai_indexmask & INDEX_OFFLINE) ||
+        !(ai->ai_indexmask & (ftype == LDAP_FILTER_PRESENT ? INDEX_PRESENCE : INDEX_EQUALITY)) ||
+        ai->ai_idlistinfo) {
+        *fallback = 1;
+        return NULL;
+    }
+    /*
+     * Only plain equality and presence keys: encrypted and entrydn keys
+     * are built differently by index_read_ext_allids.
+     */
+    if (ai->ai_attrcrypt || strcasecmp(ai->ai_type, LDBM_ENTRYDN_STR) == 0) {
+        return NULL;
+    }
+    if (ftype == LDAP_FILTER_PRESENT) {
+        s = idl_stream_new_key(ai, INDEX_PRESENCE, index_index2prefix(indextype_PRESENCE), NULL);
+    } else {
+        slapi_attr_init(&sattr, type);
+        slapi_value_init_berval(&sv, bval);
+        slapi_attr_assertion2keys_ava_sv(&sattr, &sv, &ivals, LDAP_FILTER_EQUALITY);
+        value_done(&sv);
+        attr_done(&sattr);
+        /* a single key, short enough not to be hashed */
+        if (ivals && ivals[0] && ivals[1] == NULL &&
+            slapi_value_get_length(ivals[0]) < li->li_max_key_len) {
+            s = idl_stream_new_key(ai, INDEX_EQUALITY, index_index2prefix(indextype_EQUALITY),
+                                   slapi_value_get_berval(ivals[0]));
+        }
+        valuearray_free(&ivals);
+    }
+
+    /* idl_new_fetch would return allids for this key */
+    limit = idl_get_allidslimit(ai, allidslimit);
+    if (s && (idl_stream_key_count(be, s, &count) != 0 ||
+              (limit != (size_t)-1 && count > limit))) {
+        idl_stream_free(&s);
+        *fallback = 1;
+    }
+    return s;
+}
+
+static idl_stream *
+filter_stream_build(backend *be, Slapi_Filter *f, int allidslimit, int *fallback)
+{
+    idl_stream *s = NULL;
+    idl_stream *child;
+    Slapi_Filter *sub;
+    int ftype = slapi_filter_get_choice(f);
+    size_t nchildren = 0;
+
+    switch (ftype) {
+    case LDAP_FILTER_EQUALITY:
+    case LDAP_FILTER_PRESENT:
+        s = filter_stream_index_key(be, f, ftype, allidslimit, fallback);
+        break;
+    case LDAP_FILTER_AND:
+        /*
+         * Like an allids component, an indexed component that cannot be
+         * streamed does not restrict the intersection: the filter test
+         * removes the entries it does not match.
+         */
+        s = idl_stream_new_set(ftype);
+        for (sub = slapi_filter_list_first(f); sub && !*fallback; sub = slapi_filter_list_next(f, sub)) {
+            if ((child = filter_stream_build(be, sub, allidslimit, fallback)) != NULL) {
+                idl_stream_add(s, child);
+                nchildren++;
+            }
+        }
+        if (nchildren == 0) {
+            idl_stream_free(&s);
+        }
+        break;
+    case LDAP_FILTER_OR:
+        s = idl_stream_new_set(ftype);
+        for (sub = slapi_filter_list_first(f); sub; sub = slapi_filter_list_next(f, sub)) {
+            if ((child = filter_stream_build(be, sub, allidslimit, fallback)) == NULL) {
+                idl_stream_free(&s);
+                break;
+            }
+            idl_stream_add(s, child);
+        }
+        break;
+    default:
+        if (filter_plan_estimate(be, f) == FILTER_PLAN_COST_ALLIDS) {
+            *fallback = 1;
+        }
+        break;
+    }
+    if (*fallback) {
+        idl_stream_free(&s);
+    }
+    return s;
+}
+
+/*
+ * Build a lazily evaluated candidate list for the filter, see idl_stream.c.
+ * Only AND/OR of indexed equality and presence components can be streamed,
+ * NULL is returned for any other filter and the caller must fall back to
+ * filter_candidates. NULL is also returned when filter_candidates would
+ * find an unindexed component or a key over allidslimit, so that these
+ * searches keep their notes, nsslapd-require-index and the allids
+ * threshold. The stream may return a superset of the matching entries,
+ * they must be filter tested.
+ */
+idl_stream *
+filter_candidates_stream(backend *be, Slapi_Filter *f, int allidslimit)
+{
+    int fallback = 0;
+
+    return filter_stream_build(be, f, allidslimit, &fallback);
+}
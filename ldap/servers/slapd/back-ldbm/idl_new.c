@@ -332,6 +332,61 @@ error:
     return idl;
 }
 
+/*
+ * Number of IDs stored under a key, without reading them (0 if the key
+ * does not exist). Used to check a streamed key against the allidslimit.
+ */
+int
+idl_new_key_count(backend *be, dbi_db_t *db, dbi_val_t *inkey, dbi_txn_t *txn, struct attrinfo *a, uint64_t *count)
+{
+    int ret = 0;
+    int ret2 = 0;
+    dbi_cursor_t cursor = {0};
+    dbi_val_t key = {0};
+    dbi_val_t data = {0};
+    dbi_recno_t nids = 0;
+    ID id = 0;
+    back_txn s_txn = {0};
+    struct ldbminfo *li = (struct ldbminfo *)be->be_database->plg_private;
+    char *index_id = get_index_name(be, db, a);
+
+    *count = 0;
+    dblayer_txn_init(li, &s_txn);
+    if (txn) {
+        dblayer_read_txn_begin(be, txn, &s_txn);
+    }
+
+    ret = dblayer_new_cursor(be, db, s_txn.back_txn_txn, &cursor);
+    if (0 != ret) {
+        ldbm_nasty("idl_new_key_count - idl_new.c", index_id, 81, ret);
+        goto error;
+    }
+    dblayer_value_set_buffer(be, &key, inkey->data, inkey->size);
+    dblayer_value_set_buffer(be, &data, &id, sizeof(id));
+
+    ret = dblayer_cursor_op(&cursor, DBI_OP_MOVE_TO_KEY, &key, &data);
+    if (DBI_RC_NOTFOUND == ret) {
+        ret = 0;
+    } else if (0 == ret) {
+        ret = dblayer_cursor_get_count(&cursor, &nids);
+        *count = (uint64_t)nids;
+    } else {
+        ldbm_nasty("idl_new_key_count - idl_new.c", index_id, 82, ret);
+    }
+
+    ret2 = dblayer_cursor_op(&cursor, DBI_OP_CLOSE, NULL, NULL);
+    if (ret2 && !ret) {
+        ret = ret2;
+    }
+error:
+    if (ret) {
+        dblayer_read_txn_abort(be, &s_txn);
+    } else {
+        dblayer_read_txn_commit(be, &s_txn);
+    }
+    return ret;
+}
+
 
 
 /* This function compares two index keys.  It is assumed
@@ -35,6 +35,7 @@ int idl_new_init_private(backend *be, struct attrinfo *a);
 int idl_new_release_private(struct attrinfo *a);
 size_t idl_new_get_allidslimit(struct attrinfo *a, int allidslimit);
 IDList *idl_new_fetch(backend *be, dbi_db_t *db, dbi_val_t *key, dbi_txn_t *txn, struct attrinfo *a, int *err, int allidslimit);
+int idl_new_key_count(backend *be, dbi_db_t *db, dbi_val_t *key, dbi_txn_t *txn, struct attrinfo *a, uint64_t *count);
 int idl_new_insert_key(backend *be, dbi_db_t *db, dbi_val_t *key, ID id, dbi_txn_t *txn, struct attrinfo *a, int *disposition);
 int idl_new_delete_key(backend *be, dbi_db_t *db, dbi_val_t *key, ID id, dbi_txn_t *txn, struct attrinfo *a);
 int idl_new_store_block(backend *be, dbi_db_t *db, dbi_val_t *key, IDList *idl, dbi_txn_t *txn, struct attrinfo *a);
@@ -111,6 +112,17 @@ idl_fetch_ext(backend *be, dbi_db_t *db, dbi_val_t *key, dbi_txn_t *txn, struct
     }
 }
 
+/* Only the new idl can count the IDs of a key without reading them */
+int
+idl_key_count(backend *be, dbi_db_t *db, dbi_val_t *key, dbi_txn_t *txn, struct attrinfo *a, uint64_t *count)
+{
+    if (idl_new) {
+        return idl_new_key_count(be, db, key, txn, a, count);
+    } else {
+        return DBI_RC_UNSUPPORTED;
+    }
+}
+
 IDList *
 idl_fetch(backend *be, dbi_db_t *db, dbi_val_t *key, dbi_txn_t *txn, struct attrinfo *a, int *err)
 {
@@ -0,0 +1,400 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "back-ldbm.h"
+
+/*
+ * idl_stream.c - lazily evaluated candidate lists
+ *
+ * A subtree search over millions of entries normally fetches the IDL of
+ * every filter component, intersects them with the ancestorid IDL of the
+ * base, and only then starts returning entries. An idl_stream is a tree
+ * of the same set operations, but evaluated on demand:
+ *
+ *  - a key stream reads the ids of one index key, IDL_STREAM_CHUNK ids
+ *    at a time. The cursor is closed between two chunks, so a stream can
+ *    outlive the operation (paged results) without pinning a transaction.
+ *    For the same reason it keeps the attribute name, not its attrinfo:
+ *    the index may be deleted or reconfigured between two pages, so the
+ *    attrinfo is looked up again before each chunk.
+ *  - an AND stream intersects its children by "leapfrogging": each child
+ *    is asked for its first id >= the current candidate until all agree.
+ *  - an OR stream returns the smallest head of its children.
+ *  - an idl stream walks an already built IDList.
+ *
+ * All streams return ids in increasing order. Memory is bounded by one
+ * chunk per key stream, and the first entry can be returned after reading
+ * a single chunk of each key.
+ *
+ * The index keys are stored as sorted duplicates (new idl layout). The
+ * caller must not build key streams for the old idl layout, encrypted
+ * indexes or hashed keys.
+ */
+
+#define IDL_STREAM_CHUNK 1024
+
+#define IDL_STREAM_KEY 1
+#define IDL_STREAM_IDL 2
+#define IDL_STREAM_AND LDAP_FILTER_AND
+#define IDL_STREAM_OR  LDAP_FILTER_OR
+
+struct idl_stream
+{
+    int is_type;
+    ID is_last;   /* last id returned by idl_stream_next */
+    int is_unget; /* return is_last again on the next call */
+    /* IDL_STREAM_KEY */
+    char *is_attr;
+    int is_index;     /* INDEX_EQUALITY or INDEX_PRESENCE */
+    char *is_key;
+    size_t is_keylen;
+    ID *is_ids;       /* current chunk */
+    size_t is_nids;
+    size_t is_pos;
+    int is_keyeof;    /* the chunk holds the last ids of the key */
+    /* IDL_STREAM_IDL */
+    IDList *is_idl;
+    /* IDL_STREAM_AND, IDL_STREAM_OR */
+    idl_stream **is_children;
+    size_t is_nchildren;
+};
+
+static ID idl_stream_seek(backend *be, idl_stream *s, ID target, int *err);
+
+/*
+ * Stream the ids of the key <prefix><val> of the 'index' index
+ * (INDEX_EQUALITY or INDEX_PRESENCE) of attribute 'ai'.
+ * A NULL val is the presence key.
+ */
+idl_stream *
+idl_stream_new_key(struct attrinfo *ai, int index, const char *prefix, const struct berval *val)
+{
+    idl_stream *s = (idl_stream *)slapi_ch_calloc(1, sizeof(idl_stream));
+    size_t plen = strlen(prefix);
+    size_t vlen = val ? val->bv_len : 0;
+
+    s->is_type = IDL_STREAM_KEY;
+    s->is_attr = slapi_ch_strdup(ai->ai_type);
+    s->is_index = index;
+    /* same layout as index_read_ext_allids: prefix, value, trailing NUL */
+    s->is_keylen = plen + vlen + 1;
+    s->is_key = slapi_ch_malloc(s->is_keylen);
+    memcpy(s->is_key, prefix, plen);
+    if (vlen) {
+        memcpy(s->is_key + plen, val->bv_val, vlen);
+    }
+    s->is_key[plen + vlen] = '\0';
+    s->is_ids = (ID *)slapi_ch_malloc(IDL_STREAM_CHUNK * sizeof(ID));
+    return s;
+}
+
+/*
+ * Current attrinfo of the index of a key stream, or NULL if the index
+ * was deleted, taken offline or changed since the stream was built.
+ */
+static struct attrinfo *
+idl_stream_get_ai(backend *be, idl_stream *s)
+{
+    struct attrinfo *ai = NULL;
+
+    ainfo_get(be, s->is_attr, &ai);
+    if (ai == NULL || strcasecmp(ai->ai_type, s->is_attr) != 0 ||
+        (ai->ai_indexmask & INDEX_OFFLINE) || !(ai->ai_indexmask & s->is_index) ||
+        ai->ai_idlistinfo || ai->ai_attrcrypt) {
+        slapi_log_err(SLAPI_LOG_ERR, "idl_stream_get_ai",
+                      "%s: index of %s changed during the search\n",
+                      be->be_name, s->is_attr);
+        return NULL;
+    }
+    return ai;
+}
+
+/*
+ * Number of ids of the key of a key stream, without reading them.
+ */
+int
+idl_stream_key_count(backend *be, idl_stream *s, uint64_t *count)
+{
+    struct attrinfo *ai = NULL;
+    dbi_db_t *db = NULL;
+    dbi_val_t key = {0};
+    int ret;
+
+    PR_ASSERT(s->is_type == IDL_STREAM_KEY);
+    if ((ai = idl_stream_get_ai(be, s)) == NULL) {
+        return DBI_RC_OTHER;
+    }
+    if ((ret = dblayer_get_index_file(be, ai, &db, 0)) != 0) {
+        return ret;
+    }
+    dblayer_value_set_buffer(be, &key, s->is_key, s->is_keylen);
+    ret = idl_key_count(be, db, &key, NULL, ai, count);
+    dblayer_release_index_file(be, ai, db);
+    return ret;
+}
+
+/*
+ * Stream an existing IDList, the stream takes the ownership of idl.
+ */
+idl_stream *
+idl_stream_new_idl(IDList *idl)
+{
+    idl_stream *s = (idl_stream *)slapi_ch_calloc(1, sizeof(idl_stream));
+
+    s->is_type = IDL_STREAM_IDL;
+    s->is_idl = idl;
+    return s;
+}
+
+/*
+ * Intersection (LDAP_FILTER_AND) or union (LDAP_FILTER_OR) of the
+ * streams added with idl_stream_add.
+ */
+idl_stream *
+idl_stream_new_set(int ftype)
+{
+    idl_stream *s = (idl_stream *)slapi_ch_calloc(1, sizeof(idl_stream));
+
+    PR_ASSERT(ftype == IDL_STREAM_AND || ftype == IDL_STREAM_OR);
+    s->is_type = ftype;
+    return s;
+}
+
+void
+idl_stream_add(idl_stream *set, idl_stream *child)
+{
+    set->is_children = (idl_stream **)slapi_ch_realloc((char *)set->is_children,
+                                                        (set->is_nchildren + 1) * sizeof(idl_stream *));
+    set->is_children[set->is_nchildren++] = child;
+}
+
+void
+idl_stream_free(idl_stream **s)
+{
+    if (s == NULL || *s == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < (*s)->is_nchildren; i++) {
+        idl_stream_free(&(*s)->is_children[i]);
+    }
+    slapi_ch_free((void **)&(*s)->is_children);
+    slapi_ch_free((void **)&(*s)->is_ids);
+    slapi_ch_free_string(&(*s)->is_attr);
+    slapi_ch_free_string(&(*s)->is_key);
+    idl_free(&(*s)->is_idl);
+    slapi_ch_free((void **)s);
+}
+
+/*
+ * Read the next chunk of a key stream, starting at the first id >= from.
+ */
+static int
+idl_stream_fill(backend *be, idl_stream *s, ID from)
+{
+    struct ldbminfo *li = (struct ldbminfo *)be->be_database->plg_private;
+    struct attrinfo *ai = NULL;
+    dbi_cursor_t cursor = {0};
+    dbi_db_t *db = NULL;
+    dbi_val_t key = {0};
+    dbi_val_t data = {0};
+    back_txn s_txn = {0};
+    ID id = from;
+    int retry_count = 0;
+    int ret;
+
+    s->is_nids = 0;
+    s->is_pos = 0;
+    if ((ai = idl_stream_get_ai(be, s)) == NULL) {
+        return DBI_RC_OTHER;
+    }
+    if ((ret = dblayer_get_index_file(be, ai, &db, 0)) != 0) {
+        ldbm_nasty("idl_stream_fill", s->is_attr, 1, ret);
+        return ret;
+    }
+
+retry:
+    s->is_nids = 0;
+    id = from;
+    dblayer_txn_init(li, &s_txn);
+    ret = dblayer_new_cursor(be, db, s_txn.back_txn_txn, &cursor);
+    if (ret) {
+        ldbm_nasty("idl_stream_fill", s->is_attr, 2, ret);
+        goto done;
+    }
+    dblayer_value_set_buffer(be, &key, s->is_key, s->is_keylen);
+    dblayer_value_set_buffer(be, &data, &id, sizeof(id));
+    /* Position the cursor on the smallest id >= from */
+    ret = dblayer_cursor_op(&cursor, DBI_OP_MOVE_NEAR_DATA, &key, &data);
+    while (ret == 0) {
+        s->is_ids[s->is_nids++] = id;
+        if (s->is_nids == IDL_STREAM_CHUNK) {
+            break;
+        }
+        ret = dblayer_cursor_op(&cursor, DBI_OP_NEXT_DATA, &key, &data);
+    }
+    dblayer_cursor_op(&cursor, DBI_OP_CLOSE, NULL, NULL);
+
+    if (ret == DBI_RC_RETRY && ++retry_count < IDL_FETCH_RETRY_COUNT) {
+        ldbm_nasty("idl_stream_fill", "index read retrying transaction", 3, ret);
+        DS_Sleep(PR_MillisecondsToInterval(slapi_rand() % 100));
+        goto retry;
+    }
+    if (ret == DBI_RC_NOTFOUND) {
+        s->is_keyeof = 1;
+        ret = 0;
+    } else if (ret) {
+        ldbm_nasty("idl_stream_fill", s->is_attr, 4, ret);
+    }
+    if (s->is_nids == 1 && s->is_ids[0] == ALLID) {
+        /* An allids marker, should not happen with the new idl layout */
+        ret = DBI_RC_OTHER;
+    }
+
+done:
+    dblayer_release_index_file(be, ai, db);
+    return ret;
+}
+
+static ID
+idl_stream_seek_key(backend *be, idl_stream *s, ID target, int *err)
+{
+    for (;;) {
+        /* chunks are short, and most seeks land close to the last id */
+        while (s->is_pos < s->is_nids) {
+            if (s->is_ids[s->is_pos] >= target) {
+                return s->is_ids[s->is_pos];
+            }
+            s->is_pos++;
+        }
+        if (s->is_keyeof) {
+            return NOID;
+        }
+        if ((*err = idl_stream_fill(be, s, target)) != 0) {
+            return NOID;
+        }
+    }
+}
+
+static ID
+idl_stream_seek_idl(idl_stream *s, ID target)
+{
+    IDList *idl = s->is_idl;
+
+    if (idl == NULL) {
+        return NOID;
+    }
+    /* is_pos only moves forward, the targets are increasing */
+    while (s->is_pos < idl->b_nids && idl->b_ids[s->is_pos] < target) {
+        s->is_pos++;
+    }
+    return (s->is_pos < idl->b_nids) ? idl->b_ids[s->is_pos] : NOID;
+}
+
+static ID
+idl_stream_seek_and(backend *be, idl_stream *s, ID target, int *err)
+{
+    ID candidate = target;
+    size_t agreed = 0;
+    size_t i = 0;
+
+    if (s->is_nchildren == 0) {
+        return NOID;
+    }
+    /* Leapfrog: stop once every child agrees on the candidate */
+    while (agreed < s->is_nchildren) {
+        ID id = idl_stream_seek(be, s->is_children[i], candidate, err);
+        if (id == NOID) {
+            return NOID;
+        }
+        if (id == candidate) {
+            agreed++;
+        } else {
+            candidate = id;
+            agreed = 1;
+        }
+        i = (i + 1) % s->is_nchildren;
+    }
+    return candidate;
+}
+
+static ID
+idl_stream_seek_or(backend *be, idl_stream *s, ID target, int *err)
+{
+    ID min = NOID;
+
+    for (size_t i = 0; i < s->is_nchildren; i++) {
+        ID id = idl_stream_seek(be, s->is_children[i], target, err);
+        if (*err) {
+            return NOID;
+        }
+        if (id != NOID && (min == NOID || id < min)) {
+            min = id;
+        }
+    }
+    return min;
+}
+
+/*
+ * Return the smallest id >= target, or NOID. The targets given to a
+ * stream must never decrease.
+ */
+static ID
+idl_stream_seek(backend *be, idl_stream *s, ID target, int *err)
+{
+    switch (s->is_type) {
+    case IDL_STREAM_KEY:
+        return idl_stream_seek_key(be, s, target, err);
+    case IDL_STREAM_IDL:
+        return idl_stream_seek_idl(s, target);
+    case IDL_STREAM_AND:
+        return idl_stream_seek_and(be, s, target, err);
+    case IDL_STREAM_OR:
+        return idl_stream_seek_or(be, s, target, err);
+    default:
+        PR_ASSERT(0);
+        return NOID;
+    }
+}
+
+/*
+ * Next candidate of the stream, NOID at the end of the stream or on
+ * error (*err is set).
+ */
+ID
+idl_stream_next(backend *be, idl_stream *s, int *err)
+{
+    ID id;
+
+    *err = 0;
+    if (s->is_unget) {
+        s->is_unget = 0;
+        return s->is_last;
+    }
+    if (s->is_last == NOID) {
+        return NOID;
+    }
+    id = idl_stream_seek(be, s, s->is_last + 1, err);
+    s->is_last = id;
+    return id;
+}
+
+/*
+ * Push back the last candidate, it will be returned again by the next
+ * call to idl_stream_next (see ldbm_back_prev_search_results).
+ */
+void
+idl_stream_unget(idl_stream *s)
+{
+    if (s->is_last != 0 && s->is_last != NOID) {
+        s->is_unget = 1;
+    }
+}
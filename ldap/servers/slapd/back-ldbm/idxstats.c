@@ -0,0 +1,412 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * idxstats.c - index key cardinality statistics
+ *
+ * Each attrinfo keeps, per index type (pres, eq, approx, sub), the number
+ * of distinct keys and the number of key/id pairs stored in the index.
+ * The filter planner (filterindex.c) derives from them the expected size
+ * of the IDL a filter component will return, so it can fetch the cheap
+ * components first and stop fetching once the candidate list is small
+ * enough to be filter tested.
+ *
+ * The key/id pair count is maintained incrementally by addordel_values_sv.
+ * Updates belonging to an aborted transaction are not rolled back, so the
+ * counters are only an estimate; the "index statistics" task walks the
+ * index files and resynchronizes both counters:
+ *
+ *  dn: cn=stats_userroot,cn=index statistics,cn=tasks,cn=config
+ *  objectclass: top
+ *  objectclass: extensibleObject
+ *  cn: stats_userroot
+ *  nsInstance: userRoot
+ *  nsIndexAttribute: uid        (optional, multi-valued)
+ */
+
+#include "back-ldbm.h"
+
+#define IDXSTATS_TASK "index statistics task"
+
+struct idxstats_task_data
+{
+    char *instance_name;
+    char **attrs;
+};
+
+struct idxstats_walk_ctx
+{
+    attr_index_stats stats[IDXSTATS_MAX];
+    char *lastkey;
+    size_t lastkeylen;
+    size_t lastkeysize;
+    Slapi_Task *task;
+    int stop;
+};
+
+/*
+ * Map an index type ("eq", "pres", ...) to its slot in ai_idxstats.
+ * Returns -1 for index types we do not keep statistics for (matching
+ * rules, vlv, ...).
+ */
+int
+idxstats_type2slot(const char *indextype)
+{
+    if (indextype == NULL) {
+        return -1;
+    }
+    if (indextype == indextype_EQUALITY || strcmp(indextype, indextype_EQUALITY) == 0) {
+        return IDXSTATS_EQ;
+    }
+    if (indextype == indextype_PRESENCE || strcmp(indextype, indextype_PRESENCE) == 0) {
+        return IDXSTATS_PRES;
+    }
+    if (indextype == indextype_SUB || strcmp(indextype, indextype_SUB) == 0) {
+        return IDXSTATS_SUB;
+    }
+    if (indextype == indextype_APPROX || strcmp(indextype, indextype_APPROX) == 0) {
+        return IDXSTATS_APPROX;
+    }
+    return -1;
+}
+
+static int
+idxstats_prefix2slot(char prefix)
+{
+    switch (prefix) {
+    case EQ_PREFIX:
+        return IDXSTATS_EQ;
+    case PRES_PREFIX:
+        return IDXSTATS_PRES;
+    case SUB_PREFIX:
+        return IDXSTATS_SUB;
+    case APPROX_PREFIX:
+        return IDXSTATS_APPROX;
+    default:
+        return -1;
+    }
+}
+
+/*
+ * Account for 'count' key/id pairs added to (BE_INDEX_ADD) or removed from
+ * the index 'indextype' of attribute 'a'.
+ */
+void
+idxstats_update(struct attrinfo *a, const char *indextype, int flags, uint64_t count)
+{
+    int slot = idxstats_type2slot(indextype);
+    attr_index_stats *st;
+
+    if (a == NULL || slot < 0 || count == 0) {
+        return;
+    }
+    st = &a->ai_idxstats[slot];
+    if (flags & BE_INDEX_ADD) {
+        __atomic_add_fetch_8(&st->ais_ids, count, __ATOMIC_RELAXED);
+    } else {
+        /* never wrap below zero, the stats task will resync the value */
+        uint64_t cur = slapi_atomic_load_64(&st->ais_ids, __ATOMIC_RELAXED);
+        uint64_t next;
+        do {
+            next = (cur > count) ? cur - count : 0;
+        } while (!__atomic_compare_exchange_n(&st->ais_ids, &cur, next, 1,
+                                              __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    }
+}
+
+/*
+ * Expected number of ids returned by reading one key of the index
+ * 'indextype' of attribute 'a'.
+ * Returns 0 when no statistics are available yet, in which case the
+ * caller falls back to its static heuristics.
+ */
+uint64_t
+idxstats_estimate(struct attrinfo *a, const char *indextype)
+{
+    int slot = idxstats_type2slot(indextype);
+    uint64_t keys;
+    uint64_t ids;
+
+    if (a == NULL || slot < 0) {
+        return 0;
+    }
+    ids = slapi_atomic_load_64(&a->ai_idxstats[slot].ais_ids, __ATOMIC_RELAXED);
+    keys = slapi_atomic_load_64(&a->ai_idxstats[slot].ais_keys, __ATOMIC_RELAXED);
+    if (ids == 0) {
+        return 0;
+    }
+    if (slot == IDXSTATS_PRES || keys == 0) {
+        /* single key index, or keys never counted: the whole index */
+        return ids;
+    }
+    return (ids + keys - 1) / keys;
+}
+
+static int
+idxstats_walk_cb(dbi_val_t *key, dbi_val_t *data __attribute__((unused)), void *ctx)
+{
+    struct idxstats_walk_ctx *wctx = (struct idxstats_walk_ctx *)ctx;
+    int slot;
+
+    if (key->size == 0 || key->data == NULL) {
+        return 0;
+    }
+    slot = idxstats_prefix2slot(*(char *)key->data);
+    if (slot < 0) {
+        /* matching rule or continuation key */
+        return 0;
+    }
+    wctx->stats[slot].ais_ids++;
+    if (wctx->lastkey == NULL || wctx->lastkeylen != key->size ||
+        memcmp(wctx->lastkey, key->data, key->size) != 0) {
+        /* cursor returns the keys in order: a new key starts here */
+        wctx->stats[slot].ais_keys++;
+        if (key->size > wctx->lastkeysize) {
+            wctx->lastkeysize = key->size;
+            wctx->lastkey = slapi_ch_realloc(wctx->lastkey, wctx->lastkeysize);
+        }
+        memcpy(wctx->lastkey, key->data, key->size);
+        wctx->lastkeylen = key->size;
+    }
+    if (slapi_is_shutting_down() ||
+        (wctx->task && slapi_task_get_state(wctx->task) == SLAPI_TASK_CANCELLED)) {
+        wctx->stop = 1;
+        return DBI_RC_NOTFOUND;
+    }
+    return 0;
+}
+
+/*
+ * Walk the index file of attribute 'ai' and recompute its statistics.
+ */
+int
+idxstats_compute(backend *be, struct attrinfo *ai, Slapi_Task *task)
+{
+    struct ldbminfo *li = (struct ldbminfo *)be->be_database->plg_private;
+    struct idxstats_walk_ctx wctx = {0};
+    dbi_cursor_t cursor = {0};
+    dbi_db_t *db = NULL;
+    back_txn s_txn = {0};
+    time_t now = slapi_current_rel_time_t();
+    int ret;
+
+    if (!(ai->ai_indexmask & (INDEX_PRESENCE | INDEX_EQUALITY | INDEX_APPROX | INDEX_SUB)) ||
+        (ai->ai_indexmask & INDEX_OFFLINE)) {
+        return 0;
+    }
+    if (strcasecmp(ai->ai_type, LDBM_ENTRYRDN_STR) == 0 ||
+        strcasecmp(ai->ai_type, LDBM_ANCESTORID_STR) == 0) {
+        /* scope indexes, never part of a search filter */
+        return 0;
+    }
+
+    ret = dblayer_get_index_file(be, ai, &db, 0);
+    if (ret) {
+        slapi_log_err(SLAPI_LOG_ERR, "idxstats_compute",
+                      "Unable to open the %s index file (%d)\n", ai->ai_type, ret);
+        return ret;
+    }
+
+    dblayer_txn_init(li, &s_txn);
+    ret = dblayer_new_cursor(be, db, s_txn.back_txn_txn, &cursor);
+    if (ret) {
+        ldbm_nasty("idxstats_compute", ai->ai_type, 1, ret);
+        dblayer_release_index_file(be, ai, db);
+        return ret;
+    }
+
+    wctx.task = task;
+    ret = dblayer_cursor_iterate(&cursor, idxstats_walk_cb, NULL, &wctx);
+    if (ret == DBI_RC_NOTFOUND) {
+        ret = 0;
+    }
+    dblayer_cursor_op(&cursor, DBI_OP_CLOSE, NULL, NULL);
+    dblayer_release_index_file(be, ai, db);
+    slapi_ch_free_string(&wctx.lastkey);
+
+    if (ret) {
+        ldbm_nasty("idxstats_compute", ai->ai_type, 2, ret);
+        return ret;
+    }
+    if (wctx.stop) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < IDXSTATS_MAX; i++) {
+        slapi_atomic_store_64(&ai->ai_idxstats[i].ais_keys, wctx.stats[i].ais_keys, __ATOMIC_RELAXED);
+        slapi_atomic_store_64(&ai->ai_idxstats[i].ais_ids, wctx.stats[i].ais_ids, __ATOMIC_RELAXED);
+        ai->ai_idxstats[i].ais_refreshed = now;
+    }
+    if (task) {
+        slapi_task_log_notice(task, "%s: eq keys=%" PRIu64 " ids=%" PRIu64
+                                    ", pres ids=%" PRIu64 ", sub keys=%" PRIu64 " ids=%" PRIu64 "\n",
+                              ai->ai_type,
+                              wctx.stats[IDXSTATS_EQ].ais_keys, wctx.stats[IDXSTATS_EQ].ais_ids,
+                              wctx.stats[IDXSTATS_PRES].ais_ids,
+                              wctx.stats[IDXSTATS_SUB].ais_keys, wctx.stats[IDXSTATS_SUB].ais_ids);
+    }
+    return 0;
+}
+
+#define IDXSTATS_STOP_APPLY (-8)
+
+struct idxstats_apply_ctx
+{
+    backend *be;
+    Slapi_Task *task;
+    int count;
+    int rc;
+};
+
+static int
+idxstats_count_cb(caddr_t data __attribute__((unused)), caddr_t arg)
+{
+    ((struct idxstats_apply_ctx *)arg)->count++;
+    return 0;
+}
+
+static int
+idxstats_compute_cb(caddr_t data, caddr_t arg)
+{
+    struct attrinfo *ai = (struct attrinfo *)data;
+    struct idxstats_apply_ctx *actx = (struct idxstats_apply_ctx *)arg;
+
+    actx->rc = idxstats_compute(actx->be, ai, actx->task);
+    slapi_task_inc_progress(actx->task);
+    return actx->rc ? IDXSTATS_STOP_APPLY : 0;
+}
+
+static void
+idxstats_task_destructor(Slapi_Task *task)
+{
+    if (task) {
+        struct idxstats_task_data *mydata = (struct idxstats_task_data *)slapi_task_get_data(task);
+        while (slapi_task_get_refcount(task) > 0) {
+            /* Yield to wait for the task to finish */
+            DS_Sleep(PR_MillisecondsToInterval(100));
+        }
+        if (mydata) {
+            slapi_ch_free_string(&mydata->instance_name);
+            charray_free(mydata->attrs);
+            slapi_ch_free((void **)&mydata);
+        }
+    }
+}
+
+static void
+idxstats_task_thread(void *arg)
+{
+    Slapi_Task *task = (Slapi_Task *)arg;
+    struct idxstats_task_data *td = (struct idxstats_task_data *)slapi_task_get_data(task);
+    struct idxstats_apply_ctx actx = {0};
+    ldbm_instance *inst = NULL;
+    backend *be = NULL;
+    int rc = 0;
+
+    slapi_task_inc_refcount(task);
+
+    be = slapi_be_select_by_instance_name(td->instance_name);
+    if (be == NULL || (inst = (ldbm_instance *)be->be_instance_info) == NULL) {
+        slapi_task_log_notice(task, "No such backend: %s\n", td->instance_name);
+        rc = LDAP_NO_SUCH_OBJECT;
+        goto done;
+    }
+    if (instance_set_busy(inst) != 0) {
+        slapi_task_log_notice(task, "Backend %s is busy, try again later\n", td->instance_name);
+        rc = LDAP_BUSY;
+        goto done;
+    }
+
+    actx.be = be;
+    actx.task = task;
+    if (td->attrs) {
+        for (size_t i = 0; td->attrs[i]; i++) {
+            actx.count++;
+        }
+        slapi_task_begin(task, actx.count);
+        for (size_t i = 0; td->attrs[i] && actx.rc == 0; i++) {
+            struct attrinfo *ai = NULL;
+
+            ainfo_get(be, td->attrs[i], &ai);
+            if (ai == NULL || strcasecmp(ai->ai_type, td->attrs[i]) != 0) {
+                slapi_task_log_notice(task, "%s is not indexed, skipping\n", td->attrs[i]);
+            } else {
+                actx.rc = idxstats_compute(be, ai, task);
+            }
+            slapi_task_inc_progress(task);
+        }
+    } else {
+        avl_apply(inst->inst_attrs, idxstats_count_cb, (caddr_t)&actx, IDXSTATS_STOP_APPLY, AVL_INORDER);
+        slapi_task_begin(task, actx.count);
+        avl_apply(inst->inst_attrs, idxstats_compute_cb, (caddr_t)&actx, IDXSTATS_STOP_APPLY, AVL_INORDER);
+    }
+    rc = actx.rc;
+    instance_set_not_busy(inst);
+
+done:
+    slapi_task_log_status(task, "Index statistics task %s for backend %s\n",
+                          rc ? "failed" : "finished", td->instance_name);
+    slapi_task_finish(task, rc);
+    slapi_task_dec_refcount(task);
+}
+
+static int
+idxstats_task_add(Slapi_PBlock *pb __attribute__((unused)),
+                  Slapi_Entry *e,
+                  Slapi_Entry *eAfter __attribute__((unused)),
+                  int *returncode,
+                  char *returntext,
+                  void *arg __attribute__((unused)))
+{
+    struct idxstats_task_data *td = NULL;
+    Slapi_Task *task = NULL;
+    PRThread *thread = NULL;
+    const char *instance_name;
+
+    *returncode = LDAP_SUCCESS;
+    if ((instance_name = slapi_entry_attr_get_ref(e, "nsInstance")) == NULL) {
+        snprintf(returntext, SLAPI_DSE_RETURNTEXT_SIZE,
+                 "Index statistics task requires a 'nsInstance' attribute");
+        *returncode = LDAP_OBJECT_CLASS_VIOLATION;
+        return SLAPI_DSE_CALLBACK_ERROR;
+    }
+    if (slapi_be_select_by_instance_name(instance_name) == NULL) {
+        snprintf(returntext, SLAPI_DSE_RETURNTEXT_SIZE, "No such backend: %s", instance_name);
+        *returncode = LDAP_NO_SUCH_OBJECT;
+        return SLAPI_DSE_CALLBACK_ERROR;
+    }
+
+    task = slapi_new_task(slapi_entry_get_ndn(e));
+    slapi_task_set_destructor_fn(task, idxstats_task_destructor);
+
+    td = (struct idxstats_task_data *)slapi_ch_calloc(1, sizeof(struct idxstats_task_data));
+    td->instance_name = slapi_ch_strdup(instance_name);
+    td->attrs = slapi_entry_attr_get_charray(e, "nsIndexAttribute");
+    slapi_task_set_data(task, td);
+
+    thread = PR_CreateThread(PR_USER_THREAD, idxstats_task_thread,
+                             (void *)task, PR_PRIORITY_NORMAL, PR_GLOBAL_THREAD,
+                             PR_UNJOINABLE_THREAD, SLAPD_DEFAULT_THREAD_STACKSIZE);
+    if (thread == NULL) {
+        slapi_log_err(SLAPI_LOG_ERR, IDXSTATS_TASK, "Unable to create index statistics thread!\n");
+        *returncode = LDAP_OPERATIONS_ERROR;
+        slapi_task_finish(task, *returncode);
+        return SLAPI_DSE_CALLBACK_ERROR;
+    }
+    return SLAPI_DSE_CALLBACK_OK;
+}
+
+int
+idxstats_register_task(void)
+{
+    return slapi_task_register_handler("index statistics", idxstats_task_add);
+}
@@ -1881,6 +1881,8 @@ addordel_values_sv(
 
         if (rc != 0) {
             ldbm_nasty(NASTY_MSG("addordel_values_sv"), index_id, 1120, rc);
+        } else {
+            idxstats_update(a, indextype, flags, 1);
         }
         dblayer_value_free(be, &key);
         index_free_prefix(prefix);
@@ -1981,6 +1983,7 @@ addordel_values_sv(
             ldbm_nasty(NASTY_MSG("addordel_values_sv"), index_id, 1130, rc);
             break;
         }
+        idxstats_update(a, indextype, flags, 1);
         if (NULL != key.dptr && realbuf != key.dptr) { /* realloc'ed */
             tmpbuf = key.dptr;
             tmpbuflen = key.size;
@@ -76,6 +76,11 @@ ldbm_back_init(Slapi_PBlock *pb)
         goto fail;
     }
 
+    if (search_snapshot_init(li) != 0) {
+        slapi_log_err(SLAPI_LOG_CRIT, "ldbm_back_init", "PR_NewLock failed\n");
+        goto fail;
+    }
+
     /* set all of the necessary database plugin callback functions */
     rc |= slapi_pblock_set(pb, SLAPI_PLUGIN_VERSION,
                            (void *)SLAPI_PLUGIN_VERSION_03);
@@ -257,6 +257,8 @@ ldbm_instance_start(backend *be)
 
     rc = dblayer_instance_start(be, DBLAYER_NORMAL_MODE);
     be->be_state = BE_STATE_STARTED;
+    /* the database may have been imported or restored, ids are not the same */
+    search_snapshot_invalidate(be);
 
     PR_Unlock(be->be_state_lock);
 
@@ -1061,7 +1061,6 @@ grok_and_rewrite_filter(Slapi_Filter *f)
     int has = 0;
     int num = 0;
     char *rhs = NULL;
-    struct berval rhs_berval;
 
     switch (f->f_choice) {
     case LDAP_FILTER_EQUALITY:
@@ -1084,15 +1083,15 @@ grok_and_rewrite_filter(Slapi_Filter *f)
                 rhs_number = atoi(rhs);
                 if (rhs_number > 0) {
 
-                    char *theType = f->f_ava.ava_type;
-                    rhs_berval = f->f_ava.ava_value;
-                    slapi_filter_replace_ex(f, "(&(numsubordinates=*)(numsubordinates=x))");
-                    /* Now fixup the resulting filter so that x = rhs */
-                    slapi_ch_free((void **)&(f->f_and->f_next->f_ava.ava_value.bv_val));
-                    /*free type also */
-                    slapi_ch_free((void **)&theType);
+                    Slapi_Filter save_f = *f;
 
-                    f->f_and->f_next->f_ava.ava_value = rhs_berval;
+                    if (slapi_filter_replace_ex(f, "(&(numsubordinates=*)(numsubordinates=x))") == 0) {
+                        /* Now fixup the resulting filter so that x = rhs */
+                        slapi_ch_free((void **)&(f->f_and->f_next->f_ava.ava_value.bv_val));
+                        slapi_ber_bvcpy(&f->f_and->f_next->f_ava.ava_value, &save_f.f_ava.ava_value);
+                        /* the old ava may be in the operation arena */
+                        slapi_filter_free_bits(&save_f);
+                    }
                 } else {
                     if (rhs_number == 0) {
                         /* This is the same as hassubordinates=FALSE */
@@ -1121,16 +1120,15 @@ grok_and_rewrite_filter(Slapi_Filter *f)
                 slapi_filter_replace_strfilter(f, "(objectclass=*)");
             } else {
                 /* Rewrite to present and GE the rhs */
-                char *theType = f->f_ava.ava_type;
-                rhs_berval = f->f_ava.ava_value;
-
-                slapi_filter_replace_ex(f, "(&(numsubordinates=*)(numsubordinates>=x))");
-                /* Now fixup the resulting filter so that x = rhs */
-                slapi_ch_free((void **)&(f->f_and->f_next->f_ava.ava_value.bv_val));
-                /*free type also */
-                slapi_ch_free((void **)&theType);
+                Slapi_Filter save_f = *f;
 
-                f->f_and->f_next->f_ava.ava_value = rhs_berval;
+                if (slapi_filter_replace_ex(f, "(&(numsubordinates=*)(numsubordinates>=x))") == 0) {
+                    /* Now fixup the resulting filter so that x = rhs */
+                    slapi_ch_free((void **)&(f->f_and->f_next->f_ava.ava_value.bv_val));
+                    slapi_ber_bvcpy(&f->f_and->f_next->f_ava.ava_value, &save_f.f_ava.ava_value);
+                    /* the old ava may be in the operation arena */
+                    slapi_filter_free_bits(&save_f);
+                }
             }
             return 0;
         }
@@ -38,6 +38,22 @@ attrcrypt_cipher_entry attrcrypt_cipher_list[] =
  * We maintain one of these structures per cipher that we handle
  */
 
+/*
+ * The values are ciphered with a fixed IV: an index key always gives the
+ * same encrypted key. The last encrypted index keys are kept in a direct
+ * mapped cache, so the frequent keys (search filters, index updates of
+ * common values) skip the cipher operation. Like the decrypted entries of
+ * the entry cache, the plain keys are only kept in memory.
+ */
+#define ATTRCRYPT_KEY_CACHE_SLOTS 4096
+#define ATTRCRYPT_KEY_CACHE_MAX_LEN 256
+
+typedef struct _attrcrypt_key_slot
+{
+    struct berval *plain;
+    struct berval *crypted;
+} attrcrypt_key_slot;
+
 typedef struct _attrcrypt_cipher_state
 {
     char *cipher_display_name;
@@ -45,8 +61,23 @@ typedef struct _attrcrypt_cipher_state
     PK11SlotInfo *slot;
     PK11SymKey *key;
     attrcrypt_cipher_entry *ace;
+    attrcrypt_key_slot *key_cache; /* protected by cipher_lock */
 } attrcrypt_cipher_state;
 
+/*
+ * A cipher context used for all the values of an entry. Creating the
+ * context and its IV parameter costs more than ciphering a short value,
+ * the context is only restarted between two values.
+ */
+typedef struct _attrcrypt_batch
+{
+    attrcrypt_cipher_state *acs;
+    int encrypt;
+    SECItem *param;
+    PK11Context *context;
+    int used;
+} attrcrypt_batch;
+
 struct _attrcrypt_state_private
 {
     attrcrypt_cipher_state *acs_array[1];
@@ -71,6 +102,9 @@ static int _back_crypt_cleanup_private(attrcrypt_state_private **state_priv);
 static void _back_crypt_acs_list_add(attrcrypt_state_private **state_priv, attrcrypt_cipher_state *acs);
 static int _back_crypt_keymgmt_get_key(attrcrypt_cipher_state *acs, SECKEYPrivateKey *private_key, PK11SymKey **key_from_store, const char *dn_string);
 static int _back_crypt_crypto_op(attrcrypt_private *priv, attrcrypt_cipher_state *acs, char *in_data, size_t in_size, char **out_data, size_t *out_size, int encrypt, backend *be, struct attrinfo *ai /* just for debugging */);
+static int _back_crypt_batch_init(attrcrypt_cipher_state *acs, int encrypt, attrcrypt_batch *batch);
+static int _back_crypt_batch_op(attrcrypt_batch *batch, char *in_data, size_t in_size, char **out_data, size_t *out_size);
+static void _back_crypt_batch_done(attrcrypt_batch *batch);
 
 /*
  * Copied from front-end because it's private to plugins
@@ -447,6 +481,8 @@ attrcrypt_cipher_init(ldbm_instance *li, attrcrypt_cipher_entry *ace, SECKEYPriv
     if (NULL == acs->cipher_lock) {
         slapi_log_err(SLAPI_LOG_ERR, "attrcrypt_cipher_init",
                       "Failed to create cipher lock\n");
+    } else {
+        acs->key_cache = (attrcrypt_key_slot *)slapi_ch_calloc(ATTRCRYPT_KEY_CACHE_SLOTS, sizeof(attrcrypt_key_slot));
     }
     acs->slot = slapd_pk11_GetInternalKeySlot();
     if (NULL == acs->slot) {
@@ -610,6 +646,13 @@ attrcrypt_cleanup(attrcrypt_cipher_state *acs)
     if (acs->cipher_lock) {
         PR_DestroyLock(acs->cipher_lock);
     }
+    if (acs->key_cache) {
+        for (size_t i = 0; i < ATTRCRYPT_KEY_CACHE_SLOTS; i++) {
+            ber_bvfree(acs->key_cache[i].plain);
+            ber_bvfree(acs->key_cache[i].crypted);
+        }
+        slapi_ch_free((void **)&acs->key_cache);
+    }
     slapi_log_err(SLAPI_LOG_TRACE, "attrcrypt_cleanup", "<-\n");
     return 0;
 }
@@ -701,8 +744,27 @@ attrcrypt_crypto_op(attrcrypt_private *priv, backend *be, struct attrinfo *ai, c
     return ret;
 }
 
+/* Cipher a value with the batch context, (re)started for the cipher of the attribute */
 static int
-attrcrypt_crypto_op_value(attrcrypt_private *priv, backend *be, struct attrinfo *ai, Slapi_Value *invalue, Slapi_Value **outvalue, int encrypt)
+attrcrypt_batch_op(attrcrypt_batch *batch, backend *be, struct attrinfo *ai, char *in_data, size_t in_size, char **out_data, size_t *out_size, int encrypt)
+{
+    attrcrypt_cipher_state *acs = attrcrypt_get_acs(be, ai->ai_attrcrypt);
+
+    if (NULL == acs) {
+        /* This happens if SSL/NSS has not been enabled */
+        return -1;
+    }
+    if (batch->acs != acs || batch->encrypt != encrypt) {
+        _back_crypt_batch_done(batch);
+        if (_back_crypt_batch_init(acs, encrypt, batch)) {
+            return -1;
+        }
+    }
+    return _back_crypt_batch_op(batch, in_data, in_size, out_data, out_size);
+}
+
+static int
+attrcrypt_crypto_op_value(attrcrypt_batch *batch, backend *be, struct attrinfo *ai, Slapi_Value *invalue, Slapi_Value **outvalue, int encrypt)
 {
     int ret = 0;
     char *in_data = NULL;
@@ -717,7 +779,7 @@ attrcrypt_crypto_op_value(attrcrypt_private *priv, backend *be, struct attrinfo
     in_data = bval->bv_val;
     in_size = bval->bv_len;
 
-    ret = attrcrypt_crypto_op(priv, be, ai, in_data, in_size, &out_data, &out_size, encrypt);
+    ret = attrcrypt_batch_op(batch, be, ai, in_data, in_size, &out_data, &out_size, encrypt);
 
     if (0 == ret) {
         struct berval outbervalue = {0};
@@ -764,7 +826,27 @@ attrcrypt_crypto_op_value_replace(attrcrypt_private *priv, backend *be, struct a
 }
 
 static int
-attrcrypt_crypto_op_values(attrcrypt_private *priv, backend *be, struct attrinfo *ai, Slapi_Value **invalues, Slapi_Value ***outvalues, int encrypt)
+attrcrypt_batch_value_replace(attrcrypt_batch *batch, backend *be, struct attrinfo *ai, Slapi_Value *inoutvalue, int encrypt)
+{
+    int ret = 0;
+    char *out_data = NULL;
+    size_t out_size = 0;
+    struct berval *bval = (struct berval *)slapi_value_get_berval(inoutvalue);
+
+    ret = attrcrypt_batch_op(batch, be, ai, bval->bv_val, bval->bv_len, &out_data, &out_size, encrypt);
+    if (0 == ret) {
+        struct berval outbervalue = {0};
+        outbervalue.bv_len = out_size;
+        outbervalue.bv_val = out_data;
+        /* This takes a copy of the payload, so we need to free it now */
+        slapi_value_set_berval(inoutvalue, &outbervalue);
+        slapi_ch_free((void **)&out_data);
+    }
+    return ret;
+}
+
+static int
+attrcrypt_crypto_op_values(attrcrypt_batch *batch, backend *be, struct attrinfo *ai, Slapi_Value **invalues, Slapi_Value ***outvalues, int encrypt)
 {
     int ret = 0;
     int i = 0;
@@ -775,7 +857,7 @@ attrcrypt_crypto_op_values(attrcrypt_private *priv, backend *be, struct attrinfo
     for (i = 0; (invalues[i] != NULL) && (ret == 0); i++) {
         Slapi_Value *encrypted_value = NULL;
 
-        ret = attrcrypt_crypto_op_value(priv, be, ai, invalues[i], &encrypted_value, encrypt);
+        ret = attrcrypt_crypto_op_value(batch, be, ai, invalues[i], &encrypted_value, encrypt);
         if (ret) {                              /* If failed even once, free the entire Slapi_Value */
             valuearray_free(&encrypted_values); /* encrypted_values is set to NULL */
             break;
@@ -789,7 +871,7 @@ attrcrypt_crypto_op_values(attrcrypt_private *priv, backend *be, struct attrinfo
 }
 
 static int
-attrcrypt_crypto_op_values_replace(attrcrypt_private *priv, backend *be, struct attrinfo *ai, Slapi_Value **invalues, int encrypt)
+attrcrypt_crypto_op_values_replace(attrcrypt_batch *batch, backend *be, struct attrinfo *ai, Slapi_Value **invalues, int encrypt)
 {
     int ret = 0;
     int i = 0;
@@ -797,7 +879,7 @@ attrcrypt_crypto_op_values_replace(attrcrypt_private *priv, backend *be, struct
     slapi_log_err(SLAPI_LOG_TRACE, "attrcrypt_crypto_op_values_replace", "->\n");
     for (i = 0; (invalues[i] != NULL) && (ret == 0); i++) {
 
-        ret = attrcrypt_crypto_op_value_replace(priv, be, ai, invalues[i], encrypt);
+        ret = attrcrypt_batch_value_replace(batch, be, ai, invalues[i], encrypt);
         if (ret) {
             break;
         }
@@ -815,6 +897,7 @@ attrcrypt_decrypt_entry(backend *be, struct backentry *e)
     Slapi_Attr *attr = NULL;
     char *type = NULL;
     ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+    attrcrypt_batch batch = {0};
 
     if (!inst->attrcrypt_configured) {
         /*
@@ -839,10 +922,10 @@ attrcrypt_decrypt_entry(backend *be, struct backentry *e)
             i = slapi_attr_first_value(attr, &value);
             while (NULL != value && i != -1) {
                 /* Now decrypt the attribute values in place on the original entry */
-                ret = attrcrypt_crypto_op_value_replace(ai->ai_attrcrypt, be, ai, value, 0);
+                ret = attrcrypt_batch_value_replace(&batch, be, ai, value, 0);
                 if (ret) {
                     slapi_log_err(SLAPI_LOG_ERR, "attrcrypt_decrypt_entry", "Decryption operation failed: %d\n", ret);
-                    return ret;
+                    goto done;
                 }
                 i = slapi_attr_next_value(attr, i, &value);
             }
@@ -850,15 +933,17 @@ attrcrypt_decrypt_entry(backend *be, struct backentry *e)
             i = attr_first_deleted_value(attr, &value);
             while (NULL != value && i != -1) {
                 /* Now decrypt the attribute values in place on the original entry */
-                ret = attrcrypt_crypto_op_value_replace(ai->ai_attrcrypt, be, ai, value, 0);
+                ret = attrcrypt_batch_value_replace(&batch, be, ai, value, 0);
                 if (ret) {
                     slapi_log_err(SLAPI_LOG_ERR, "attrcrypt_decrypt_entry", "Decryption operation 2 failed: %d\n", ret);
-                    return ret;
+                    goto done;
                 }
                 i = attr_next_deleted_value(attr, i, &value);
             }
         }
     }
+done:
+    _back_crypt_batch_done(&batch);
     slapi_log_err(SLAPI_LOG_TRACE, "attrcrypt_decrypt_entry", "<- %d\n", ret);
     return ret;
 }
@@ -874,6 +959,7 @@ attrcrypt_encrypt_entry_inplace(backend *be, const struct backentry *inout)
     Slapi_Attr *attr = NULL;
     Slapi_Value **svals = NULL;
     ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+    attrcrypt_batch batch = {0};
 
     if (!inst->attrcrypt_configured) {
         /*
@@ -898,10 +984,11 @@ attrcrypt_encrypt_entry_inplace(backend *be, const struct backentry *inout)
             svals = attr_get_present_values(attr);
             if (svals) {
                 /* Now encrypt the attribute values in place on the new entry */
-                ret = attrcrypt_crypto_op_values_replace(ai->ai_attrcrypt, be, ai, svals, 1);
+                ret = attrcrypt_crypto_op_values_replace(&batch, be, ai, svals, 1);
             }
         }
     }
+    _back_crypt_batch_done(&batch);
     slapi_log_err(SLAPI_LOG_TRACE, "attrcrypt_encrypt_entry_inplace", "<- %d\n", ret);
     return ret;
 }
@@ -919,6 +1006,7 @@ attrcrypt_encrypt_entry(backend *be, const struct backentry *in, struct backentr
     char *type = NULL;
     Slapi_Attr *attr = NULL;
     ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+    attrcrypt_batch batch = {0};
 
     if (!inst->attrcrypt_configured) {
         /*
@@ -950,7 +1038,7 @@ attrcrypt_encrypt_entry(backend *be, const struct backentry *in, struct backentr
                     new_entry = backentry_dup((struct backentry *)in);
                 }
                 /* Now encrypt the attribute values in place on the new entry */
-                ret = attrcrypt_crypto_op_values(ai->ai_attrcrypt, be, ai, svals, &new_vals, 1);
+                ret = attrcrypt_crypto_op_values(&batch, be, ai, svals, &new_vals, 1);
                 if (ret) {
                     slapi_log_err(SLAPI_LOG_ERR, "attrcrypt_encrypt_entry", "Failed to encrypt value, error %d\n",
                                   ret);
@@ -963,11 +1051,77 @@ attrcrypt_encrypt_entry(backend *be, const struct backentry *in, struct backentr
             }
         }
     }
+    _back_crypt_batch_done(&batch);
     *out = new_entry;
     slapi_log_err(SLAPI_LOG_TRACE, "attrcrypt_encrypt_entry", "<- %d\n", ret);
     return ret;
 }
 
+static attrcrypt_key_slot *
+attrcrypt_key_cache_slot(attrcrypt_cipher_state *acs, const struct berval *key)
+{
+    uint32_t hash = 2166136261U; /* FNV-1a */
+
+    if (NULL == acs || NULL == acs->key_cache || key->bv_len > ATTRCRYPT_KEY_CACHE_MAX_LEN) {
+        return NULL;
+    }
+    for (size_t i = 0; i < key->bv_len; i++) {
+        hash ^= (unsigned char)key->bv_val[i];
+        hash *= 16777619U;
+    }
+    return &acs->key_cache[hash % ATTRCRYPT_KEY_CACHE_SLOTS];
+}
+
+/* Returns 1 and a copy of the encrypted key if it is in the cache */
+static int
+attrcrypt_key_cache_get(attrcrypt_cipher_state *acs, const struct berval *in, struct berval **out)
+{
+    attrcrypt_key_slot *slot = attrcrypt_key_cache_slot(acs, in);
+    int found = 0;
+
+    if (NULL == slot) {
+        return 0;
+    }
+    PR_Lock(acs->cipher_lock);
+    if (slot->plain && slot->plain->bv_len == in->bv_len &&
+        memcmp(slot->plain->bv_val, in->bv_val, in->bv_len) == 0) {
+        *out = ber_bvdup(slot->crypted);
+        found = (*out != NULL);
+    }
+    PR_Unlock(acs->cipher_lock);
+    return found;
+}
+
+static void
+attrcrypt_key_cache_put(attrcrypt_cipher_state *acs, const struct berval *in, const struct berval *crypted)
+{
+    attrcrypt_key_slot *slot = attrcrypt_key_cache_slot(acs, in);
+    struct berval *plain;
+    struct berval *crypted_dup;
+    struct berval *old_plain;
+    struct berval *old_crypted;
+
+    if (NULL == slot) {
+        return;
+    }
+    plain = ber_bvdup((struct berval *)in);
+    crypted_dup = ber_bvdup((struct berval *)crypted);
+    if (NULL == plain || NULL == crypted_dup) {
+        ber_bvfree(plain);
+        ber_bvfree(crypted_dup);
+        return;
+    }
+    PR_Lock(acs->cipher_lock);
+    /* swap the new key in, free the old one out of the lock */
+    old_plain = slot->plain;
+    old_crypted = slot->crypted;
+    slot->plain = plain;
+    slot->crypted = crypted_dup;
+    PR_Unlock(acs->cipher_lock);
+    ber_bvfree(old_plain);
+    ber_bvfree(old_crypted);
+}
+
 /*
  * Encrypt an index key. There is never any need to decrypt index keys since
  * we only ever look them up using plain text (except entryrdn).
@@ -989,7 +1143,13 @@ attrcrypt_encrypt_index_key(backend *be, struct attrinfo *ai, const struct berva
     }
 
     if (ai->ai_attrcrypt) {
+        attrcrypt_cipher_state *acs = attrcrypt_get_acs(be, ai->ai_attrcrypt);
+
         slapi_log_err(SLAPI_LOG_TRACE, "attrcrypt_encrypt_index_key", "->\n");
+        if (attrcrypt_key_cache_get(acs, in, out)) {
+            slapi_log_err(SLAPI_LOG_TRACE, "attrcrypt_encrypt_index_key", "<- cached\n");
+            return ret;
+        }
         ret = attrcrypt_crypto_op(ai->ai_attrcrypt, be, ai, in_data, in_size, &out_data, &out_size, 1);
         if (0 == ret) {
             out_berval = (struct berval *)ber_alloc();
@@ -1001,6 +1161,7 @@ attrcrypt_encrypt_index_key(backend *be, struct attrinfo *ai, const struct berva
             /* It's now the responsibility of our caller to free that data */
             out_berval->bv_val = out_data;
             *out = out_berval;
+            attrcrypt_key_cache_put(acs, in, out_berval);
         }
         slapi_log_err(SLAPI_LOG_TRACE, "attrcrypt_encrypt_index_key", "<- %d\n", ret);
     }
@@ -1574,155 +1735,201 @@ _back_crypt_acs_list_add(attrcrypt_state_private **state_priv,
     return;
 }
 
-/* Either encipher or decipher an attribute value */
+/* Create the cipher context of a batch, with the key and IV of the cipher */
 static int
-_back_crypt_crypto_op(attrcrypt_private *priv __attribute__((unused)),
-                      attrcrypt_cipher_state *acs,
-                      char *in_data,
-                      size_t in_size,
-                      char **out_data,
-                      size_t *out_size,
-                      int encrypt,
-                      backend *be __attribute__((unused)),
-                      struct attrinfo *ai __attribute__((unused)) /* just for debugging */)
+_back_crypt_batch_init(attrcrypt_cipher_state *acs, int encrypt, attrcrypt_batch *batch)
 {
-    int rc = -1;
-    SECStatus secret = 0;
-    PK11Context *sec_context = NULL;
     SECItem iv_item = {0};
-    SECItem *security_parameter = NULL;
-    int output_buffer_length = 0;
-    int output_buffer_size1 = 0;
-    unsigned int output_buffer_size2 = 0;
-    unsigned char *output_buffer = NULL;
 
-    slapi_log_err(SLAPI_LOG_TRACE, "_back_crypt_crypto_op", "->\n");
-    if (NULL == acs) {
-        goto bail;
-    }
-    if (encrypt) {
-        slapi_log_err(SLAPI_LOG_BACKLDBM, "_back_crypt_crypto_op",
-                      "Encrypt '%s' (%lu)\n",
-                      in_data, (long unsigned int)in_size);
-    } else {
-        slapi_log_err(SLAPI_LOG_BACKLDBM, "_back_crypt_crypto_op",
-                      "Decrypt (%lu)\n", (long unsigned int)in_size);
-    }
-    /* Allocate the output buffer */
-    output_buffer_length = in_size + BACK_CRYPT_OUTBUFF_EXTLEN;
-    output_buffer = (unsigned char *)slapi_ch_malloc(output_buffer_length);
-    /* Now call NSS to do the cipher op */
+    batch->acs = NULL;
+    batch->encrypt = encrypt;
+    batch->used = 0;
     iv_item.data = (unsigned char *)"aaaaaaaaaaaaaaaa"; /* ptr to an array
                                                            of IV bytes */
     iv_item.len = acs->ace->iv_length;                  /* length of the array of IV bytes */
-    security_parameter = slapd_pk11_ParamFromIV(acs->ace->cipher_mechanism,
-                                                &iv_item);
-    if (NULL == security_parameter) {
+    batch->param = slapd_pk11_ParamFromIV(acs->ace->cipher_mechanism, &iv_item);
+    if (NULL == batch->param) {
         int errorCode = PR_GetError();
-        slapi_log_err(SLAPI_LOG_ERR, "_back_crypt_crypto_op",
+        slapi_log_err(SLAPI_LOG_ERR, "_back_crypt_batch_init",
                       "Failed to make IV for cipher %s : %d - %s\n",
                       acs->ace->cipher_display_name, errorCode,
                       slapd_pr_strerror(errorCode));
-        goto error;
+        return -1;
     }
-    sec_context = slapd_pk11_createContextBySymKey(acs->ace->cipher_mechanism,
-                                                   (encrypt ? CKA_ENCRYPT : CKA_DECRYPT),
-                                                   acs->key, security_parameter);
-    if (NULL == sec_context) {
+    batch->context = slapd_pk11_createContextBySymKey(acs->ace->cipher_mechanism,
+                                                      (encrypt ? CKA_ENCRYPT : CKA_DECRYPT),
+                                                      acs->key, batch->param);
+    if (NULL == batch->context) {
         int errorCode = PR_GetError();
-        slapi_log_err(SLAPI_LOG_ERR, "_back_crypt_crypto_op",
+        slapi_log_err(SLAPI_LOG_ERR, "_back_crypt_batch_init",
                       "Failed on cipher %s : %d - %s\n",
                       acs->ace->cipher_display_name, errorCode,
                       slapd_pr_strerror(errorCode));
-        goto error;
+        _back_crypt_batch_done(batch);
+        return -1;
+    }
+    batch->acs = acs;
+    return 0;
+}
+
+static void
+_back_crypt_batch_done(attrcrypt_batch *batch)
+{
+    if (batch->context) {
+        slapd_pk11_destroyContext(batch->context, PR_TRUE);
+        batch->context = NULL;
+    }
+    if (batch->param) {
+        SECITEM_FreeItem(batch->param, PR_TRUE);
+        batch->param = NULL;
+    }
+    batch->acs = NULL;
+    batch->used = 0;
+}
+
+/* Either encipher or decipher a value with the context of the batch */
+static int
+_back_crypt_batch_op(attrcrypt_batch *batch,
+                     char *in_data,
+                     size_t in_size,
+                     char **out_data,
+                     size_t *out_size)
+{
+    attrcrypt_cipher_state *acs = batch->acs;
+    SECStatus secret = 0;
+    int output_buffer_length = 0;
+    int output_buffer_size1 = 0;
+    unsigned int output_buffer_size2 = 0;
+    unsigned char *output_buffer = NULL;
+
+    if (batch->encrypt) {
+        slapi_log_err(SLAPI_LOG_BACKLDBM, "_back_crypt_batch_op",
+                      "Encrypt '%s' (%lu)\n",
+                      in_data, (long unsigned int)in_size);
+    } else {
+        slapi_log_err(SLAPI_LOG_BACKLDBM, "_back_crypt_batch_op",
+                      "Decrypt (%lu)\n", (long unsigned int)in_size);
+    }
+    /* The previous value finalized the context, restart it with the same key and IV */
+    if (batch->used) {
+        secret = slapd_pk11_DigestBegin(batch->context);
+        if (SECSuccess != secret) {
+            int errorCode = PR_GetError();
+            slapi_log_err(SLAPI_LOG_ERR, "_back_crypt_batch_op",
+                          "Failed to restart cipher %s : %d - %s\n",
+                          acs->ace->cipher_display_name, errorCode,
+                          slapd_pr_strerror(errorCode));
+            return -1;
+        }
     }
-    secret = slapd_pk11_cipherOp(sec_context, output_buffer,
+    batch->used = 1;
+    /* Allocate the output buffer */
+    output_buffer_length = in_size + BACK_CRYPT_OUTBUFF_EXTLEN;
+    output_buffer = (unsigned char *)slapi_ch_malloc(output_buffer_length);
+    secret = slapd_pk11_cipherOp(batch->context, output_buffer,
                                  &output_buffer_size1, output_buffer_length,
                                  (unsigned char *)in_data, in_size);
     if (SECSuccess != secret) {
         int errorCode = PR_GetError();
-        slapi_log_err(SLAPI_LOG_ERR, "_back_crypt_crypto_op",
+        slapi_log_err(SLAPI_LOG_ERR, "_back_crypt_batch_op",
                       "Failed on cipher %s : %d - %s\n",
                       acs->ace->cipher_display_name, errorCode,
                       slapd_pr_strerror(errorCode));
         goto error;
     }
-    secret = slapd_pk11_DigestFinal(sec_context,
+    secret = slapd_pk11_DigestFinal(batch->context,
                                     output_buffer + output_buffer_size1,
                                     &output_buffer_size2,
                                     output_buffer_length - output_buffer_size1);
     if (SECSuccess != secret) {
         int errorCode = PR_GetError();
-        slapi_log_err(SLAPI_LOG_ERR, "_back_crypt_crypto_op",
+        slapi_log_err(SLAPI_LOG_ERR, "_back_crypt_batch_op",
                       "Digest final failed on cipher %s : %d - %s\n",
                       acs->ace->cipher_display_name,
                       errorCode, slapd_pr_strerror(errorCode));
         goto error;
-    } else {
+    }
+    *out_size = output_buffer_size1 + output_buffer_size2;
+    *out_data = (char *)output_buffer;
+    return 0;
+
+error:
+    slapi_ch_free_string((char **)&output_buffer);
+    return -1;
+}
+
+/* Either encipher or decipher an attribute value */
+static int
+_back_crypt_crypto_op(attrcrypt_private *priv __attribute__((unused)),
+                      attrcrypt_cipher_state *acs,
+                      char *in_data,
+                      size_t in_size,
+                      char **out_data,
+                      size_t *out_size,
+                      int encrypt,
+                      backend *be __attribute__((unused)),
+                      struct attrinfo *ai __attribute__((unused)) /* just for debugging */)
+{
+    int rc = -1;
+    attrcrypt_batch batch = {0};
+#if defined(DEBUG_ATTRCRYPT)
+    int recurse = (*out_size != -1);
+#endif
+
+    slapi_log_err(SLAPI_LOG_TRACE, "_back_crypt_crypto_op", "->\n");
+    if (NULL == acs) {
+        goto bail;
+    }
+    if (0 == _back_crypt_batch_init(acs, encrypt, &batch)) {
+        rc = _back_crypt_batch_op(&batch, in_data, in_size, out_data, out_size);
+    }
+    _back_crypt_batch_done(&batch);
 #if defined(DEBUG_ATTRCRYPT)
-        int recurse = 1;
+    if (0 == rc) {
         if (encrypt) {
             log_bytes("slapd_pk11_DigestFinal '%s' (%d)\n",
-                      output_buffer, output_buffer_size1 + output_buffer_size2);
+                      (unsigned char *)*out_data, *out_size);
         } else {
             slapi_log_err(SLAPI_LOG_DEBUG, "DEBUG_ATTRCRYPT",
                           "slapd_pk11_DigestFinal '%s', %u\n",
-                          output_buffer, output_buffer_size1 + output_buffer_size2);
-        }
-        if (*out_size == -1) {
-            recurse = 0;
+                          *out_data, *out_size);
         }
-#endif
-        *out_size = output_buffer_size1 + output_buffer_size2;
-        *out_data = (char *)output_buffer;
-        rc = 0; /* success */
-#if defined(DEBUG_ATTRCRYPT)
-        if (recurse) {
-            char *redo_data = NULL;
-            size_t redo_size = -1;
-            int redo_ret;
-
+    }
+    if (0 == rc && recurse) {
+        char *redo_data = NULL;
+        size_t redo_size = -1;
+        int redo_ret;
+
+        slapi_log_err(SLAPI_LOG_DEBUG, "_back_crypt_crypto_op",
+                      "------> check result of crypto op\n");
+        if (priv && be && ai) {
+            redo_ret = attrcrypt_crypto_op(priv, be, ai,
+                                           *out_data, *out_size,
+                                           &redo_data, &redo_size,
+                                           !encrypt);
             slapi_log_err(SLAPI_LOG_DEBUG, "_back_crypt_crypto_op",
-                          "------> check result of crypto op\n");
-            if (priv && be && ai) {
-                redo_ret = attrcrypt_crypto_op(priv, be, ai,
-                                               *out_data, *out_size,
-                                               &redo_data, &redo_size,
-                                               !encrypt);
-                slapi_log_err(SLAPI_LOG_DEBUG, "_back_crypt_crypto_op",
-                              "attrcrypt_crypto_op returned (%d) "
-                              "orig length %u redone length %u\n",
-                              redo_ret, in_size, redo_size);
-            } else {
-                redo_ret = _back_crypt_crypto_op(NULL, acs,
-                                                 *out_data, *out_size,
-                                                 &redo_data, &redo_size,
-                                                 !encrypt, NULL, NULL);
-                slapi_log_err(SLAPI_LOG_DEBUG, "_back_crypt_crypto_op",
-                              "_back_crypt_crypto_op returned (%d) "
-                              "orig length %u redone length %u\n",
-                              redo_ret, in_size, redo_size);
-            }
-            log_bytes("DEBUG_ATTRCRYPT orig bytes '%s' (%d)\n",
-                      (unsigned char *)in_data, in_size);
-            log_bytes("DEBUG_ATTRCRYPT redo bytes '%s' (%d)\n",
-                      (unsigned char *)redo_data, redo_size);
-
+                          "attrcrypt_crypto_op returned (%d) "
+                          "orig length %u redone length %u\n",
+                          redo_ret, in_size, redo_size);
+        } else {
+            redo_ret = _back_crypt_crypto_op(NULL, acs,
+                                             *out_data, *out_size,
+                                             &redo_data, &redo_size,
+                                             !encrypt, NULL, NULL);
             slapi_log_err(SLAPI_LOG_DEBUG, "_back_crypt_crypto_op",
-                          "<------ check result of crypto op\n");
+                          "_back_crypt_crypto_op returned (%d) "
+                          "orig length %u redone length %u\n",
+                          redo_ret, in_size, redo_size);
         }
-#endif
-    }
-error:
-    if (sec_context) {
-        slapd_pk11_destroyContext(sec_context, PR_TRUE);
-    }
-    if (security_parameter) {
-        SECITEM_FreeItem(security_parameter, PR_TRUE);
-    }
-    if (rc) {
-        slapi_ch_free_string((char **)&output_buffer);
+        log_bytes("DEBUG_ATTRCRYPT orig bytes '%s' (%d)\n",
+                  (unsigned char *)in_data, in_size);
+        log_bytes("DEBUG_ATTRCRYPT redo bytes '%s' (%d)\n",
+                  (unsigned char *)redo_data, redo_size);
+
+        slapi_log_err(SLAPI_LOG_DEBUG, "_back_crypt_crypto_op",
+                      "<------ check result of crypto op\n");
     }
+#endif
 bail:
     slapi_log_err(SLAPI_LOG_TRACE, "_back_crypt_crypto_op",
                   "<- (returning %d)\n", rc);
@@ -864,6 +864,115 @@ ldbm_config_get_use_vlv_index(void *arg)
     return (void *)((uintptr_t)li->li_use_vlv);
 }
 
+static int
+ldbm_config_set_filter_planner(void *arg,
+                               void *value,
+                               char *errorbuf __attribute__((unused)),
+                               int phase __attribute__((unused)),
+                               int apply)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+    int val = (int)((uintptr_t)value);
+
+    if (apply) {
+        li->li_filter_planner = val ? 1 : 0;
+    }
+    return LDAP_SUCCESS;
+}
+
+static void *
+ldbm_config_get_filter_planner(void *arg)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+
+    return (void *)((uintptr_t)li->li_filter_planner);
+}
+
+static int
+ldbm_config_set_stream_threshold(void *arg,
+                                 void *value,
+                                 char *errorbuf,
+                                 int phase __attribute__((unused)),
+                                 int apply)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+    int val = (int)((uintptr_t)value);
+
+    if (val < 0) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE,
+                              "Invalid value for %s (%d). Must be greater or equal to 0",
+                              CONFIG_STREAM_THRESHOLD, val);
+        return LDAP_UNWILLING_TO_PERFORM;
+    }
+    if (apply) {
+        li->li_stream_threshold = val;
+    }
+    return LDAP_SUCCESS;
+}
+
+static void *
+ldbm_config_get_stream_threshold(void *arg)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+
+    return (void *)((uintptr_t)li->li_stream_threshold);
+}
+
+static int
+ldbm_config_set_snapshot_cachesize(void *arg,
+                                   void *value,
+                                   char *errorbuf __attribute__((unused)),
+                                   int phase __attribute__((unused)),
+                                   int apply)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+    uint64_t val = (uint64_t)((uintptr_t)value);
+
+    if (apply) {
+        li->li_snapshot_cachesize = val;
+        search_snapshot_resize(li);
+    }
+    return LDAP_SUCCESS;
+}
+
+static void *
+ldbm_config_get_snapshot_cachesize(void *arg)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+
+    return (void *)((uintptr_t)li->li_snapshot_cachesize);
+}
+
+static int
+ldbm_config_set_vlv_rebuild_threads(void *arg,
+                                    void *value,
+                                    char *errorbuf,
+                                    int phase __attribute__((unused)),
+                                    int apply)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+    int val = (int)((uintptr_t)value);
+
+    if (val < 0) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE,
+                              "Invalid value for %s (%d). Must be greater or equal to 0",
+                              CONFIG_VLV_REBUILD_THREADS, val);
+        return LDAP_UNWILLING_TO_PERFORM;
+    }
+    if (apply) {
+        li->li_vlv_rebuild_threads = val;
+    }
+    return LDAP_SUCCESS;
+}
+
+static void *
+ldbm_config_get_vlv_rebuild_threads(void *arg)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+
+    return (void *)((uintptr_t)li->li_vlv_rebuild_threads);
+}
+
 static int
 ldbm_config_exclude_from_export_set(void *arg,
                                     void *value,
@@ -939,6 +1048,10 @@ static config_info ldbm_config[] = {
     {CONFIG_IDL_UPDATE, CONFIG_TYPE_ONOFF, "on", &ldbm_config_idl_get_update, &ldbm_config_idl_set_update, 0},
     {CONFIG_BYPASS_FILTER_TEST, CONFIG_TYPE_STRING, "on", &ldbm_config_get_bypass_filter_test, &ldbm_config_set_bypass_filter_test, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
     {CONFIG_USE_VLV_INDEX, CONFIG_TYPE_ONOFF, "on", &ldbm_config_get_use_vlv_index, &ldbm_config_set_use_vlv_index, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
+    {CONFIG_FILTER_PLANNER, CONFIG_TYPE_ONOFF, "on", &ldbm_config_get_filter_planner, &ldbm_config_set_filter_planner, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
+    {CONFIG_STREAM_THRESHOLD, CONFIG_TYPE_INT, "0", &ldbm_config_get_stream_threshold, &ldbm_config_set_stream_threshold, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
+    {CONFIG_SNAPSHOT_CACHESIZE, CONFIG_TYPE_UINT64, "0", &ldbm_config_get_snapshot_cachesize, &ldbm_config_set_snapshot_cachesize, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
+    {CONFIG_VLV_REBUILD_THREADS, CONFIG_TYPE_INT, "0", &ldbm_config_get_vlv_rebuild_threads, &ldbm_config_set_vlv_rebuild_threads, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
     {CONFIG_EXCLUDE_FROM_EXPORT, CONFIG_TYPE_STRING, CONFIG_EXCLUDE_FROM_EXPORT_DEFAULT_VALUE, &ldbm_config_exclude_from_export_get, &ldbm_config_exclude_from_export_set, CONFIG_FLAG_ALWAYS_SHOW},
     {CONFIG_SERIAL_LOCK, CONFIG_TYPE_ONOFF, "on", &ldbm_config_serial_lock_get, &ldbm_config_serial_lock_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
     {CONFIG_USE_LEGACY_ERRORCODE, CONFIG_TYPE_ONOFF, "off", &ldbm_config_legacy_errcode_get, &ldbm_config_legacy_errcode_set, 0},
@@ -1746,6 +1859,7 @@ ldbm_config_destroy(struct ldbminfo *li)
     if (li->li_config_mutex) {
         PR_DestroyLock(li->li_config_mutex);
     }
+    search_snapshot_destroy(li);
 
     /* Finally free the ldbminfo */
     slapi_ch_free((void **)&li);
@@ -124,6 +124,10 @@ struct config_info
 #define CONFIG_IDL_UPDATE "nsslapd-idl-update"
 #define CONFIG_BYPASS_FILTER_TEST "nsslapd-search-bypass-filter-test"
 #define CONFIG_USE_VLV_INDEX "nsslapd-search-use-vlv-index"
+#define CONFIG_FILTER_PLANNER "nsslapd-search-filter-planner"
+#define CONFIG_STREAM_THRESHOLD "nsslapd-search-stream-threshold"
+#define CONFIG_SNAPSHOT_CACHESIZE "nsslapd-search-snapshot-cachesize"
+#define CONFIG_VLV_REBUILD_THREADS "nsslapd-vlv-rebuild-threads"
 #define CONFIG_SERIAL_LOCK "nsslapd-serial-lock"
 #define CONFIG_BACKEND_OPT_LEVEL "nsslapd-backend-opt-level"
 
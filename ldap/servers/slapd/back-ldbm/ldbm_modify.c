@@ -490,6 +490,36 @@ done:
     return rc;
 }
 
+/*
+ * Set the cache size of ec from the one of e. As index_add_mods does, trust
+ * the mods to tell which attributes differ between both entries: only they
+ * are measured again, not all the values of the entry. This runs after the
+ * pre-op plugins, so the state information purged from ec by the replication
+ * is measured too.
+ */
+static void
+modify_update_entry_size(struct backentry *e, struct backentry *ec, LDAPMod **mods, Slapi_Mods *smods_add_rdn)
+{
+    LDAPMod **rdn_mods = smods_add_rdn ? slapi_mods_get_ldapmods_byref(smods_add_rdn) : NULL;
+    char **types = NULL;
+
+    if (e->ep_size == 0 || ec->ep_size != 0) {
+        /* the cache computes it */
+        return;
+    }
+    for (size_t i = 0; mods && mods[i]; i++) {
+        charray_add(&types, mods[i]->mod_type);
+    }
+    for (size_t i = 0; rdn_mods && rdn_mods[i]; i++) {
+        charray_add(&types, rdn_mods[i]->mod_type);
+    }
+    /* the object classes may be expanded by the schema check */
+    charray_add(&types, (char *)SLAPI_ATTR_OBJECTCLASS);
+    ec->ep_size = entry_size_update(e->ep_entry, e->ep_size, ec->ep_entry, types);
+    /* the types belong to the mods */
+    slapi_ch_free((void **)&types);
+}
+
 int
 ldbm_back_modify(Slapi_PBlock *pb)
 {
@@ -985,6 +1015,7 @@ ldbm_back_modify(Slapi_PBlock *pb)
         }
     }
 
+    modify_update_entry_size(e, ec, mods, smods_add_rdn);
     if (cache_replace(&inst->inst_cache, e, ec) != 0) {
         MOD_SET_ERROR(ldap_result_code, LDAP_OPERATIONS_ERROR, retry_count);
         goto error_return;
@@ -29,10 +29,12 @@
 #define LDBM_SRCH_DEFAULT_RESULT (-1)
 
 /* prototypes */
-static int build_candidate_list(Slapi_PBlock *pb, backend *be, struct backentry *e, const char *base, int scope, int *lookup_returned_allidsp, IDList **candidates);
+static int build_candidate_list(Slapi_PBlock *pb, backend *be, struct backentry *e, const char *base, int scope, int *lookup_returned_allidsp, IDList **candidates, IDList *snapshot);
 static IDList *base_candidates(Slapi_PBlock *pb, struct backentry *e);
 static IDList *onelevel_candidates(Slapi_PBlock *pb, backend *be, const char *base, Slapi_Filter *filter, int *lookup_returned_allidsp, int *err);
+static idl_stream *subtree_candidates_stream(Slapi_PBlock *pb, backend *be, const struct backentry *e, Slapi_Filter *filter);
 static back_search_result_set *new_search_result_set(IDList *idl, int vlv, int lookthroughlimit);
+static void filter_plan_make_response_control(Slapi_PBlock *pb);
 static void delete_search_result_set(Slapi_PBlock *pb, back_search_result_set **sr);
 static int can_skip_filter_test(Slapi_PBlock *pb, struct slapi_filter *f, int scope, IDList *idl);
 static void stat_add_srch_lookup(Op_stat *op_stat,  struct component_keys_lookup *key_stat, char * attribute_type, const char* index_type, char *key_value, int lookup_cnt);
@@ -493,6 +495,11 @@ ldbm_back_search(Slapi_PBlock *pb)
                                                 SLAPI_FAIL_GENERAL, &vlv_request_control, NULL, candidates);
             }
         }
+
+        /* Does the client want to know how the filter was evaluated ? */
+        if (slapi_control_present(controls, LDAP_CONTROL_FILTER_PLAN, NULL, NULL)) {
+            sr->sr_flags |= SR_FLAG_RECORD_FILTER_PLAN;
+        }
     }
     if ((virtual_list_view || sort) && backend_count > 0) {
         char *ctrlstr = NULL;
@@ -608,6 +615,7 @@ ldbm_back_search(Slapi_PBlock *pb)
         int lookthrough_limit = 0;
         struct vlv_response vlv_response_control;
         int abandoned = 0;
+        int snapshot_hit = 0;
         int vlv_rc;
         /*
          * Build a list of IDs for this entry and scope
@@ -662,8 +670,26 @@ ldbm_back_search(Slapi_PBlock *pb)
             }
         }
         if (candidates == NULL) {
-            int rc = build_candidate_list(pb, be, e, base, scope,
-                                          &lookup_returned_allids, &candidates);
+            IDList *snapshot = NULL;
+            int rc;
+
+            /*
+             * A previous page of this sorted search may have left its
+             * sorted candidates behind.
+             */
+            if (sort && (sr->sr_snapshot_key = search_snapshot_key(pb, be, basesdn, scope, sort_control, virtual_list_view))) {
+                int snapshot_flags = 0;
+
+                sr->sr_snapshot_generation = search_snapshot_generation(be);
+                snapshot = search_snapshot_get(be, sr->sr_snapshot_key, &lookup_returned_allids, &snapshot_flags);
+                if (snapshot) {
+                    sr->sr_flags |= snapshot_flags;
+                    slapi_ch_free_string(&sr->sr_snapshot_key);
+                    snapshot_hit = 1;
+                }
+            }
+            rc = build_candidate_list(pb, be, e, base, scope,
+                                      &lookup_returned_allids, &candidates, snapshot);
             if (rc) {
                 /* Error result sent by build_candidate_list */
                 if (virtual_list_view) {
@@ -673,6 +699,9 @@ ldbm_back_search(Slapi_PBlock *pb)
                                                 LDBM_SRCH_DEFAULT_RESULT, NULL, rc,
                                                 &vlv_request_control, e, candidates);
             }
+            if (sr->sr_flags & SR_FLAG_RECORD_FILTER_PLAN) {
+                filter_plan_make_response_control(pb);
+            }
             /*
              * If we're sorting then we must check what administrative
              * limits should be imposed.  Work out at what time to give
@@ -690,7 +719,7 @@ ldbm_back_search(Slapi_PBlock *pb)
              * If we're presenting a virtual list view, then apply the
              * search filter before sorting.
              */
-            if (virtual_list_view && candidates) {
+            if (virtual_list_view && candidates && !snapshot_hit) {
                 IDList *idl = NULL;
                 Slapi_Filter *filter = NULL;
                 slapi_pblock_get(pb, SLAPI_SEARCH_FILTER, &filter);
@@ -742,6 +771,21 @@ ldbm_back_search(Slapi_PBlock *pb)
                                                         "Sort Response Control", -1,
                                                         &vlv_request_control, e, candidates);
                     }
+                } else if (snapshot_hit) {
+                    /* The snapshot candidates are already sorted */
+                    if (!operation_is_flag_set(operation, OP_FLAG_INTERNAL)) {
+                        sort_log_access(pb, sort_control, candidates, PR_FALSE);
+                    }
+                    if (LDAP_SUCCESS !=
+                        sort_make_sort_response_control(pb, LDAP_SUCCESS, NULL)) {
+                        if (virtual_list_view) {
+                            vlv_print_access_log(pb, &vlv_request_control, NULL, sort_control);
+                        }
+                        return ldbm_back_search_cleanup(pb, li, sort_control,
+                                                        LDAP_PROTOCOL_ERROR,
+                                                        "Sort Response Control", -1,
+                                                        &vlv_request_control, e, candidates);
+                    }
                 } else {
                     /* Before we haste off to sort the candidates, we need to
                      * prepare some information for the purpose of imposing the
@@ -777,6 +821,12 @@ ldbm_back_search(Slapi_PBlock *pb)
                          * we don't want to override an error from vlv
                          * vlv_response_control.result= LDAP_SUCCESS;
                          */
+                        if (sr->sr_snapshot_key && vlv_response_control.result == LDAP_SUCCESS) {
+                            /* keep the sorted candidates for the next pages */
+                            search_snapshot_put(be, sr->sr_snapshot_key, sr->sr_snapshot_generation,
+                                                candidates, lookup_returned_allids,
+                                                sr->sr_flags & SR_FLAG_MUST_APPLY_FILTER_TEST);
+                        }
                         break;
                     case LDAP_PROTOCOL_ERROR: /* A protocol error */
                         if (virtual_list_view) {
@@ -1044,7 +1094,7 @@ bail:
  *
  */
 static int
-build_candidate_list(Slapi_PBlock *pb, backend *be, struct backentry *e, const char *base, int scope, int *lookup_returned_allidsp, IDList **candidates)
+build_candidate_list(Slapi_PBlock *pb, backend *be, struct backentry *e, const char *base, int scope, int *lookup_returned_allidsp, IDList **candidates, IDList *snapshot)
 {
     struct ldbminfo *li = (struct ldbminfo *)be->be_database->plg_private;
     int managedsait = 0;
@@ -1054,6 +1104,7 @@ build_candidate_list(Slapi_PBlock *pb, backend *be, struct backentry *e, const c
     int r = 0;
     char logbuf[1024] = {0};
     Slapi_Operation *operation;
+    back_search_result_set *sr = NULL;
 
     slapi_pblock_get(pb, SLAPI_SEARCH_FILTER, &filter);
     if (NULL == filter) {
@@ -1078,7 +1129,11 @@ build_candidate_list(Slapi_PBlock *pb, backend *be, struct backentry *e, const c
         slapi_log_err(SLAPI_LOG_FILTER, "ldbm_back_search", "Optimised ONE filter to - %s\n",
              slapi_filter_to_string(filter_exec, logbuf, sizeof(logbuf)));
 
-        *candidates = onelevel_candidates(pb, be, base, filter_exec, lookup_returned_allidsp, &err);
+        if (snapshot) {
+            *candidates = snapshot;
+        } else {
+            *candidates = onelevel_candidates(pb, be, base, filter_exec, lookup_returned_allidsp, &err);
+        }
 
         slapi_pblock_set(pb, SLAPI_SEARCH_FILTER, filter_exec);
         slapi_pblock_set(pb, SLAPI_SEARCH_FILTER_INTENDED, filter);
@@ -1104,7 +1159,17 @@ build_candidate_list(Slapi_PBlock *pb, backend *be, struct backentry *e, const c
         slapi_log_err(SLAPI_LOG_FILTER, "ldbm_back_search", "Optimised SUB filter to - %s\n",
              slapi_filter_to_string(filter_exec, logbuf, sizeof(logbuf)));
 
-        *candidates = subtree_candidates(pb, be, base, e, filter_exec, lookup_returned_allidsp, &err);
+        slapi_pblock_get(pb, SLAPI_SEARCH_RESULT_SET, &sr);
+        if (snapshot) {
+            *candidates = snapshot;
+        } else if (sr && (sr->sr_stream = subtree_candidates_stream(pb, be, e, filter_exec)) != NULL) {
+            /* the candidates are evaluated by ldbm_back_next_search_entry */
+            slapi_log_err(SLAPI_LOG_FILTER, "ldbm_back_search", "Streaming the candidates\n");
+            sr->sr_flags |= SR_FLAG_MUST_APPLY_FILTER_TEST;
+            *candidates = NULL;
+        } else {
+            *candidates = subtree_candidates(pb, be, base, e, filter_exec, lookup_returned_allidsp, &err);
+        }
 
         slapi_pblock_set(pb, SLAPI_SEARCH_FILTER, filter_exec);
         slapi_pblock_set(pb, SLAPI_SEARCH_FILTER_INTENDED, filter);
@@ -1368,6 +1433,65 @@ subtree_candidates(
     return (candidates);
 }
 
+/*
+ * Streamed alternative to subtree_candidates for searches expected to
+ * match more than nsslapd-search-stream-threshold entries: instead of
+ * fetching the IDLs of the filter and of the ancestorid key of the base,
+ * they are merged as the entries are returned (see idl_stream.c).
+ * Returns NULL when the search cannot be streamed.
+ */
+static idl_stream *
+subtree_candidates_stream(Slapi_PBlock *pb, backend *be, const struct backentry *e, Slapi_Filter *filter)
+{
+    struct ldbminfo *li = (struct ldbminfo *)be->be_database->plg_private;
+    struct attrinfo *ai = NULL;
+    Operation *op = NULL;
+    idl_stream *fstream;
+    idl_stream *scope;
+    idl_stream *stream;
+    IDList *baseidl;
+    struct berval bv;
+    char keybuf[24];
+
+    if (li->li_stream_threshold <= 0 || e == NULL || !idl_get_idl_new()) {
+        return NULL;
+    }
+    /* Sorting and reverse order need the whole candidate list */
+    slapi_pblock_get(pb, SLAPI_OPERATION, &op);
+    if (op == NULL ||
+        operation_is_flag_set(op, OP_FLAG_SERVER_SIDE_SORTING | OP_FLAG_REVERSE_CANDIDATE_ORDER | OP_FLAG_BULK_IMPORT)) {
+        return NULL;
+    }
+    /* tombstone entries are not indexed in the ancestorid index */
+    if (filter->f_flags & SLAPI_FILTER_TOMBSTONE) {
+        return NULL;
+    }
+    if (filter_candidates_estimate(be, filter) < (uint64_t)li->li_stream_threshold) {
+        return NULL;
+    }
+    ainfo_get(be, LDBM_ANCESTORID_STR, &ai);
+    if (ai == NULL || strcasecmp(ai->ai_type, LDBM_ANCESTORID_STR) != 0) {
+        return NULL;
+    }
+    if ((fstream = filter_candidates_stream(be, filter, compute_allids_limit(pb, li))) == NULL) {
+        return NULL;
+    }
+
+    /* (|(ancestorid=<base id>)(base entry)) */
+    bv.bv_val = keybuf;
+    bv.bv_len = PR_snprintf(keybuf, sizeof(keybuf), "%lu", (u_long)e->ep_id);
+    baseidl = idl_alloc(1);
+    idl_append(baseidl, e->ep_id);
+    scope = idl_stream_new_set(LDAP_FILTER_OR);
+    idl_stream_add(scope, idl_stream_new_key(ai, INDEX_EQUALITY, index_index2prefix(indextype_EQUALITY), &bv));
+    idl_stream_add(scope, idl_stream_new_idl(baseidl));
+
+    stream = idl_stream_new_set(LDAP_FILTER_AND);
+    idl_stream_add(stream, fstream);
+    idl_stream_add(stream, scope);
+    return stream;
+}
+
 static int grok_filter(struct slapi_filter *f);
 
 /* Helper function for can_skip_filter_test() */
@@ -1708,6 +1832,18 @@ ldbm_back_next_search_entry(Slapi_PBlock *pb)
                 /* we're done */
                 id = NOID;
             }
+        } else if (sr->sr_stream) {
+            /* Evaluate the streamed candidates up to the next one */
+            id = idl_stream_next(be, sr->sr_stream, &err);
+            if (err) {
+                slapi_log_err(SLAPI_LOG_ERR, "ldbm_back_next_search_entry",
+                              "candidate stream db err %d\n", err);
+                slapi_send_ldap_result(pb, LDAP_OPERATIONS_ERROR, NULL, NULL, 0, NULL);
+                slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_ENTRY, NULL);
+                delete_search_result_set(pb, &sr);
+                rc = SLAPI_FAIL_GENERAL;
+                goto bail;
+            }
         } else {
             /* Process the candidate list in the normal order. */
             id = idl_iterator_dereference_increment(&(sr->sr_current), sr->sr_candidates);
@@ -2004,12 +2140,38 @@ ldbm_back_prev_search_results(Slapi_PBlock *pb)
             CACHE_RETURN(&inst->inst_cache, &(sr->sr_entry));
             sr->sr_entry = NULL;
         }
-        idl_iterator_decrement(&(sr->sr_current));
+        if (sr->sr_stream) {
+            idl_stream_unget(sr->sr_stream);
+        } else {
+            idl_iterator_decrement(&(sr->sr_current));
+        }
         --sr->sr_lookthroughcount;
     }
     return;
 }
 
+/*
+ * Return the evaluation order chosen by the filter planner to the client.
+ * The value is the same string that is logged with the "filter plan" stat
+ * level, it is empty if no AND component list was planned.
+ */
+static void
+filter_plan_make_response_control(Slapi_PBlock *pb)
+{
+    Op_stat *op_stat = op_stat_get_operation_extension(pb);
+    LDAPControl new_ctrl = {0};
+    char *plan = "";
+
+    if (op_stat && op_stat->search_stat && op_stat->search_stat->filter_plan) {
+        plan = op_stat->search_stat->filter_plan;
+    }
+    new_ctrl.ldctl_oid = LDAP_CONTROL_FILTER_PLAN;
+    new_ctrl.ldctl_value.bv_val = plan;
+    new_ctrl.ldctl_value.bv_len = strlen(plan);
+    new_ctrl.ldctl_iscritical = 0;
+    slapi_pblock_set(pb, SLAPI_ADD_RESCONTROL, &new_ctrl);
+}
+
 static back_search_result_set *
 new_search_result_set(IDList *idl, int vlv, int lookthroughlimit)
 {
@@ -2042,6 +2204,8 @@ delete_search_result_set(Slapi_PBlock *pb, back_search_result_set **sr)
     if (NULL != (*sr)->sr_candidates) {
         idl_free(&((*sr)->sr_candidates));
     }
+    idl_stream_free(&((*sr)->sr_stream));
+    slapi_ch_free_string(&((*sr)->sr_snapshot_key));
     rc = slapi_filter_apply((*sr)->sr_norm_filter, ldbm_search_free_compiled_filter,
                             NULL, &filt_errs);
     if (rc != SLAPI_FILTER_SCAN_NOMORE) {
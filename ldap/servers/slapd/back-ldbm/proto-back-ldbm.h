@@ -159,6 +159,8 @@ struct backentry *uniqueid2entry(backend *be, const char *uniqueid, back_txn *tx
  */
 IDList *filter_candidates(Slapi_PBlock *pb, backend *be, const char *base, Slapi_Filter *f, Slapi_Filter *nextf, int range, int *err);
 IDList *filter_candidates_ext(Slapi_PBlock *pb, backend *be, const char *base, Slapi_Filter *f, Slapi_Filter *nextf, int range, int *err, int allidslimit);
+uint64_t filter_candidates_estimate(backend *be, Slapi_Filter *f);
+idl_stream *filter_candidates_stream(backend *be, Slapi_Filter *f, int allidslimit);
 
 /*
  * findentry.c
@@ -208,6 +210,7 @@ int idl_delete(IDList **idl, ID id);
 IDList *idl_allids(backend *be);
 IDList *idl_fetch(backend *be, dbi_db_t *db, dbi_val_t *key, dbi_txn_t *txn, struct attrinfo *a, int *err);
 IDList *idl_fetch_ext(backend *be, dbi_db_t *db, dbi_val_t *key, dbi_txn_t *txn, struct attrinfo *a, int *err, int allidslimit);
+int idl_key_count(backend *be, dbi_db_t *db, dbi_val_t *key, dbi_txn_t *txn, struct attrinfo *a, uint64_t *count);
 int idl_insert_key(backend *be, dbi_db_t *db, dbi_val_t *key, ID id, back_txn *txn, struct attrinfo *a, int *disposition);
 int idl_delete_key(backend *be, dbi_db_t *db, dbi_val_t *key, ID id, back_txn *txn, struct attrinfo *a);
 IDList *idl_intersection(backend *be, IDList *a, IDList *b);
@@ -249,6 +252,27 @@ int64_t idl_set_intersection_shortcut(IDListSet *idl_set);
 IDList *idl_set_union(IDListSet *idl_set, backend *be);
 IDList *idl_set_intersect(IDListSet *idl_set, backend *be);
 
+/*
+ * idl_stream.c
+ */
+idl_stream *idl_stream_new_key(struct attrinfo *ai, int index, const char *prefix, const struct berval *val);
+int idl_stream_key_count(backend *be, idl_stream *s, uint64_t *count);
+idl_stream *idl_stream_new_idl(IDList *idl);
+idl_stream *idl_stream_new_set(int ftype);
+void idl_stream_add(idl_stream *set, idl_stream *child);
+void idl_stream_free(idl_stream **s);
+ID idl_stream_next(backend *be, idl_stream *s, int *err);
+void idl_stream_unget(idl_stream *s);
+
+/*
+ * idxstats.c
+ */
+int idxstats_type2slot(const char *indextype);
+void idxstats_update(struct attrinfo *a, const char *indextype, int flags, uint64_t count);
+uint64_t idxstats_estimate(struct attrinfo *a, const char *indextype);
+int idxstats_compute(backend *be, struct attrinfo *ai, Slapi_Task *task);
+int idxstats_register_task(void);
+
 /*
  * index.c
  */
@@ -418,6 +442,21 @@ int parse_sort_spec(struct berval *sort_spec_ber, sort_spec **ps);
 struct berval *attr_value_lowest(struct berval **values, value_compare_fn_type compare_fn);
 int sort_attr_compare(struct berval **value_a, struct berval **value_b, value_compare_fn_type compare_fn);
 const char *sort_log_access(Slapi_PBlock *pb, sort_spec_thing *s, IDList *candidates, PRBool just_copy);
+char *sort_spec_string(sort_spec *s);
+
+/*
+ * search_snapshot.c
+ */
+int search_snapshot_init(struct ldbminfo *li);
+void search_snapshot_destroy(struct ldbminfo *li);
+void search_snapshot_invalidate(backend *be);
+uint64_t search_snapshot_generation(backend *be);
+void search_snapshot_resize(struct ldbminfo *li);
+char *search_snapshot_key(Slapi_PBlock *pb, backend *be, const Slapi_DN *base, int scope, sort_spec *sort_control, int vlv);
+IDList *search_snapshot_get(backend *be, const char *key, int *allids, int *sr_flags);
+void search_snapshot_put(backend *be, const char *key, uint64_t generation, IDList *idl, int allids, int sr_flags);
+void search_snapshot_get_stats(struct ldbminfo *li, uint64_t *hits, uint64_t *tries, uint64_t *size, uint64_t *count);
+uint64_t search_snapshot_get_be_size(struct ldbminfo *li, backend *be);
 
 /*
  * dbsize.c
@@ -491,6 +530,7 @@ char *vlv_getindexnames(backend *be);
 int vlv_search_build_candidate_list(Slapi_PBlock *pb, const Slapi_DN *base, int *rc, const sort_spec *sort_control, const struct vlv_request *vlv_request_control, IDList **candidates, struct vlv_response *vlv_response_control);
 int vlv_update_index(struct vlvIndex *p, back_txn *txn, struct ldbminfo *li, Slapi_PBlock *pb, struct backentry *oldEntry, struct backentry *newEntry);
 int vlv_update_all_indexes(back_txn *txn, backend *be, Slapi_PBlock *pb, struct backentry *oldEntry, struct backentry *newEntry);
+int vlv_rebuild_entries(backend *be, struct vlvIndex **pvlv, int numvlv, struct backentry **entries, int nentries, int use_txn, int nthreads);
 int vlv_filter_candidates(backend *be, Slapi_PBlock *pb, const IDList *candidates, const Slapi_DN *base, int scope, Slapi_Filter *filter, IDList **filteredCandidates, int lookthrough_limit, struct timespec *expire_time);
 int vlv_trim_candidates_txn(backend *be, const IDList *candidates, const sort_spec *sort_control, const struct vlv_request *vlv_request_control, IDList **filteredCandidates, struct vlv_response *pResponse, back_txn *txn);
 int vlv_trim_candidates(backend *be, const IDList *candidates, const sort_spec *sort_control, const struct vlv_request *vlv_request_control, IDList **filteredCandidates, struct vlv_response *pResponse);
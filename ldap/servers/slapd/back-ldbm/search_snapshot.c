@@ -0,0 +1,380 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * search_snapshot.c - sorted search result snapshots
+ *
+ * A client browsing a large sorted list (VLV without a matching vlv index,
+ * or a server side sort) sends one search per page. Without help each of
+ * them walks the indexes, filters and sorts the whole candidate list again
+ * before returning a few entries.
+ *
+ * The snapshot cache keeps the sorted id array of such searches, keyed by
+ * backend, normalized base dn, scope, filter string, sort keys, vlv flag,
+ * manageDSAit and access control context. The next page finds the sorted
+ * array and only has to slice it (vlv_trim_candidates) or walk it.
+ *
+ * For VLV searches the array has already been filter tested (with the
+ * access control of the requestor) by vlv_filter_candidates. For a plain
+ * sort the entries are still filter tested when they are returned. The key
+ * therefore holds everything the bind rules of an aci can depend on: the
+ * bound and the proxied identity, the authentication method, the SSF and
+ * the client address (ip and dns rules). When acis with timeofday or
+ * dayofweek rules are loaded, the key also holds the current minute, so
+ * the snapshots expire at the end of their minute.
+ *
+ * Every write committed to a backend gives it a new generation
+ * (dblayer_txn_commit), a snapshot built with another generation of its
+ * backend is never returned. The generations are taken from a counter of
+ * the cache, so they are unique across the backends and a restarted or
+ * recreated backend never matches the snapshots of its previous life.
+ * Stale snapshots are dropped when they are looked up, and the least
+ * recently used snapshots are evicted to keep the cache below
+ * nsslapd-search-snapshot-cachesize bytes. A size of 0 disables the cache.
+ */
+
+#include "back-ldbm.h"
+
+typedef struct search_snapshot
+{
+    char *ss_key;
+    IDList *ss_idl;       /* sorted candidates, b_nmax == b_nids */
+    int ss_allids;        /* the index lookup returned allids */
+    int ss_sr_flags;      /* sr_flags set while building the candidates */
+    uint64_t ss_generation;
+    uint64_t ss_size;
+    struct search_snapshot *ss_prev; /* toward the most recently used */
+    struct search_snapshot *ss_next;
+} search_snapshot;
+
+struct search_snapshot_cache
+{
+    PRLock *ssc_lock;
+    PLHashTable *ssc_hash;   /* ss_key -> search_snapshot */
+    search_snapshot *ssc_head; /* most recently used */
+    search_snapshot *ssc_tail; /* least recently used */
+    uint64_t ssc_size;
+    uint64_t ssc_count;
+    uint64_t ssc_generation; /* last generation given to a backend */
+    uint64_t ssc_hits;
+    uint64_t ssc_tries;
+};
+
+int
+search_snapshot_init(struct ldbminfo *li)
+{
+    struct search_snapshot_cache *ssc;
+
+    ssc = (struct search_snapshot_cache *)slapi_ch_calloc(1, sizeof(struct search_snapshot_cache));
+    if ((ssc->ssc_lock = PR_NewLock()) == NULL) {
+        slapi_ch_free((void **)&ssc);
+        return -1;
+    }
+    ssc->ssc_hash = PL_NewHashTable(64, PL_HashString, PL_CompareStrings,
+                                    PL_CompareValues, NULL, NULL);
+    li->li_snapshots = ssc;
+    return 0;
+}
+
+static void
+search_snapshot_unlink(struct search_snapshot_cache *ssc, search_snapshot *ss)
+{
+    if (ss->ss_prev) {
+        ss->ss_prev->ss_next = ss->ss_next;
+    } else {
+        ssc->ssc_head = ss->ss_next;
+    }
+    if (ss->ss_next) {
+        ss->ss_next->ss_prev = ss->ss_prev;
+    } else {
+        ssc->ssc_tail = ss->ss_prev;
+    }
+    ss->ss_prev = ss->ss_next = NULL;
+}
+
+static void
+search_snapshot_push(struct search_snapshot_cache *ssc, search_snapshot *ss)
+{
+    ss->ss_prev = NULL;
+    ss->ss_next = ssc->ssc_head;
+    if (ssc->ssc_head) {
+        ssc->ssc_head->ss_prev = ss;
+    } else {
+        ssc->ssc_tail = ss;
+    }
+    ssc->ssc_head = ss;
+}
+
+/* Remove a snapshot from the cache and free it, called with ssc_lock held */
+static void
+search_snapshot_drop(struct search_snapshot_cache *ssc, search_snapshot *ss)
+{
+    search_snapshot_unlink(ssc, ss);
+    PL_HashTableRemove(ssc->ssc_hash, ss->ss_key);
+    ssc->ssc_size -= ss->ss_size;
+    ssc->ssc_count--;
+    slapi_ch_free_string(&ss->ss_key);
+    idl_free(&ss->ss_idl);
+    slapi_ch_free((void **)&ss);
+}
+
+/* Evict snapshots until 'needed' more bytes fit, called with ssc_lock held */
+static void
+search_snapshot_evict(struct search_snapshot_cache *ssc, uint64_t maxsize, uint64_t needed)
+{
+    while (ssc->ssc_tail && ssc->ssc_size + needed > maxsize) {
+        search_snapshot_drop(ssc, ssc->ssc_tail);
+    }
+}
+
+void
+search_snapshot_destroy(struct ldbminfo *li)
+{
+    struct search_snapshot_cache *ssc = li->li_snapshots;
+
+    if (ssc == NULL) {
+        return;
+    }
+    while (ssc->ssc_head) {
+        search_snapshot_drop(ssc, ssc->ssc_head);
+    }
+    PL_HashTableDestroy(ssc->ssc_hash);
+    PR_DestroyLock(ssc->ssc_lock);
+    slapi_ch_free((void **)&li->li_snapshots);
+}
+
+/*
+ * Called after a write is committed to be: the snapshots of be built so
+ * far may not match the database anymore.
+ */
+void
+search_snapshot_invalidate(backend *be)
+{
+    struct ldbminfo *li = (struct ldbminfo *)be->be_database->plg_private;
+    ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+    uint64_t generation;
+
+    if (li->li_snapshots == NULL || inst == NULL) {
+        return;
+    }
+    generation = slapi_atomic_incr_64(&li->li_snapshots->ssc_generation, __ATOMIC_ACQ_REL);
+    slapi_atomic_store_64(&inst->inst_snapshot_generation, generation, __ATOMIC_RELEASE);
+}
+
+/*
+ * The generation must be read before the candidates are built, so a
+ * write committed meanwhile invalidates the snapshot being built.
+ */
+uint64_t
+search_snapshot_generation(backend *be)
+{
+    ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+
+    return slapi_atomic_load_64(&inst->inst_snapshot_generation, __ATOMIC_ACQUIRE);
+}
+
+/* Apply a new nsslapd-search-snapshot-cachesize */
+void
+search_snapshot_resize(struct ldbminfo *li)
+{
+    struct search_snapshot_cache *ssc = li->li_snapshots;
+
+    if (ssc == NULL) {
+        return;
+    }
+    PR_Lock(ssc->ssc_lock);
+    search_snapshot_evict(ssc, li->li_snapshot_cachesize, 0);
+    PR_Unlock(ssc->ssc_lock);
+}
+
+/*
+ * Build the key of a sorted search, NULL if the search results can not be
+ * kept (cache disabled, base scope, internal operation, unexpected request).
+ */
+char *
+search_snapshot_key(Slapi_PBlock *pb, backend *be, const Slapi_DN *base, int scope, sort_spec *sort_control, int vlv)
+{
+    struct ldbminfo *li = (struct ldbminfo *)be->be_database->plg_private;
+    Connection *conn = NULL;
+    char *fstr = NULL;
+    char *requestor = NULL;
+    char *proxydn = NULL;
+    char *errtext = NULL;
+    char *authmethod = NULL;
+    char *sortstr = NULL;
+    char *key = NULL;
+    char addrbuf[PR_NETDB_BUF_SIZE] = {0};
+    PRNetAddr addr = {0};
+    int managedsait = 0;
+    int sasl_ssf = 0;
+    int ssl_ssf = 0;
+    int local_ssf = 0;
+    int64_t minute = 0;
+
+    if (li->li_snapshots == NULL || li->li_snapshot_cachesize == 0 ||
+        sort_control == NULL || scope == LDAP_SCOPE_BASE) {
+        return NULL;
+    }
+    slapi_pblock_get(pb, SLAPI_SEARCH_STRFILTER, &fstr);
+    slapi_pblock_get(pb, SLAPI_CONNECTION, &conn);
+    if (fstr == NULL || conn == NULL) {
+        return NULL;
+    }
+    if (proxyauth_get_dn(pb, &proxydn, &errtext) != LDAP_SUCCESS) {
+        slapi_ch_free_string(&proxydn);
+        return NULL;
+    }
+    slapi_pblock_get(pb, SLAPI_REQUESTOR_NDN, &requestor);
+    slapi_pblock_get(pb, SLAPI_MANAGEDSAIT, &managedsait);
+    slapi_pblock_get(pb, SLAPI_CONN_AUTHMETHOD, &authmethod);
+    slapi_pblock_get(pb, SLAPI_CONN_SASL_SSF, &sasl_ssf);
+    slapi_pblock_get(pb, SLAPI_CONN_SSL_SSF, &ssl_ssf);
+    slapi_pblock_get(pb, SLAPI_CONN_LOCAL_SSF, &local_ssf);
+    slapi_pblock_get(pb, SLAPI_CONN_CLIENTNETADDR, &addr);
+    if (PR_NetAddrToString(&addr, addrbuf, sizeof(addrbuf)) != PR_SUCCESS) {
+        addrbuf[0] = '\0';
+    }
+    if (plugin_acl_has_time_rules()) {
+        minute = (int64_t)(slapi_current_utc_time() / 60);
+    }
+    sortstr = sort_spec_string(sort_control);
+    key = slapi_ch_smprintf("%s\n%s\n%d\n%d\n%d\n%s\n%s\n%s\n%s\n%d/%d/%d\n%s\n%" PRId64 "\n%s",
+                            be->be_name, slapi_sdn_get_ndn(base), scope, vlv ? 1 : 0,
+                            managedsait ? 1 : 0, sortstr,
+                            requestor ? requestor : "", proxydn ? proxydn : "",
+                            authmethod ? authmethod : "", sasl_ssf, ssl_ssf, local_ssf,
+                            addrbuf, minute, fstr);
+    slapi_ch_free_string(&sortstr);
+    slapi_ch_free_string(&authmethod);
+    slapi_ch_free_string(&proxydn);
+    return key;
+}
+
+/*
+ * Return a copy of the sorted candidates of a search, or NULL. allids and
+ * sr_flags are set to the values they had when the snapshot was built.
+ */
+IDList *
+search_snapshot_get(backend *be, const char *key, int *allids, int *sr_flags)
+{
+    struct ldbminfo *li = (struct ldbminfo *)be->be_database->plg_private;
+    struct search_snapshot_cache *ssc = li->li_snapshots;
+    uint64_t generation = search_snapshot_generation(be);
+    search_snapshot *ss;
+    IDList *idl = NULL;
+
+    PR_Lock(ssc->ssc_lock);
+    ssc->ssc_tries++;
+    ss = (search_snapshot *)PL_HashTableLookup(ssc->ssc_hash, key);
+    if (ss && ss->ss_generation != generation) {
+        search_snapshot_drop(ssc, ss);
+        ss = NULL;
+    }
+    if (ss) {
+        ssc->ssc_hits++;
+        search_snapshot_unlink(ssc, ss);
+        search_snapshot_push(ssc, ss);
+        idl = idl_alloc(ss->ss_idl->b_nids);
+        idl->b_nids = ss->ss_idl->b_nids;
+        memcpy(idl->b_ids, ss->ss_idl->b_ids, idl->b_nids * sizeof(ID));
+        *allids = ss->ss_allids;
+        *sr_flags = ss->ss_sr_flags;
+    }
+    PR_Unlock(ssc->ssc_lock);
+    return idl;
+}
+
+/*
+ * Keep a copy of the sorted candidates of a search. generation is the
+ * value returned by search_snapshot_generation before the candidates
+ * were built.
+ */
+void
+search_snapshot_put(backend *be, const char *key, uint64_t generation, IDList *idl, int allids, int sr_flags)
+{
+    struct ldbminfo *li = (struct ldbminfo *)be->be_database->plg_private;
+    struct search_snapshot_cache *ssc = li->li_snapshots;
+    uint64_t maxsize = li->li_snapshot_cachesize;
+    search_snapshot *ss;
+    search_snapshot *old;
+    uint64_t size;
+
+    if (idl == NULL || ALLIDS(idl) ||
+        generation != search_snapshot_generation(be)) {
+        return;
+    }
+    size = sizeof(search_snapshot) + strlen(key) + 1 + sizeof(IDList) + idl->b_nids * sizeof(ID);
+    if (size > maxsize) {
+        return;
+    }
+
+    ss = (search_snapshot *)slapi_ch_calloc(1, sizeof(search_snapshot));
+    ss->ss_key = slapi_ch_strdup(key);
+    ss->ss_idl = idl_alloc(idl->b_nids);
+    ss->ss_idl->b_nids = idl->b_nids;
+    memcpy(ss->ss_idl->b_ids, idl->b_ids, idl->b_nids * sizeof(ID));
+    ss->ss_allids = allids;
+    ss->ss_sr_flags = sr_flags;
+    ss->ss_generation = generation;
+    ss->ss_size = size;
+
+    PR_Lock(ssc->ssc_lock);
+    old = (search_snapshot *)PL_HashTableLookup(ssc->ssc_hash, key);
+    if (old) {
+        /* another page of the same search was faster */
+        search_snapshot_drop(ssc, old);
+    }
+    search_snapshot_evict(ssc, maxsize, size);
+    PL_HashTableAdd(ssc->ssc_hash, ss->ss_key, ss);
+    search_snapshot_push(ssc, ss);
+    ssc->ssc_size += size;
+    ssc->ssc_count++;
+    PR_Unlock(ssc->ssc_lock);
+}
+
+void
+search_snapshot_get_stats(struct ldbminfo *li, uint64_t *hits, uint64_t *tries, uint64_t *size, uint64_t *count)
+{
+    struct search_snapshot_cache *ssc = li->li_snapshots;
+
+    *hits = *tries = *size = *count = 0;
+    if (ssc == NULL) {
+        return;
+    }
+    PR_Lock(ssc->ssc_lock);
+    *hits = ssc->ssc_hits;
+    *tries = ssc->ssc_tries;
+    *size = ssc->ssc_size;
+    *count = ssc->ssc_count;
+    PR_Unlock(ssc->ssc_lock);
+}
+
+/* Bytes of the snapshots of one backend, their keys start with its name */
+uint64_t
+search_snapshot_get_be_size(struct ldbminfo *li, backend *be)
+{
+    struct search_snapshot_cache *ssc = li->li_snapshots;
+    size_t len = strlen(be->be_name);
+    uint64_t size = 0;
+
+    if (ssc == NULL) {
+        return size;
+    }
+    PR_Lock(ssc->ssc_lock);
+    for (search_snapshot *ss = ssc->ssc_head; ss; ss = ss->ss_next) {
+        if (strncmp(ss->ss_key, be->be_name, len) == 0 && ss->ss_key[len] == '\n') {
+            size += ss->ss_size;
+        }
+    }
+    PR_Unlock(ssc->ssc_lock);
+    return size;
+}
@@ -271,6 +271,19 @@ print_out_sort_spec(char *buffer, sort_spec *s, int *size)
     }
 }
 
+/* The sort keys, as printed in the access log */
+char *
+sort_spec_string(sort_spec *s)
+{
+    int size = 0;
+    char *buffer = NULL;
+
+    print_out_sort_spec(NULL, s, &size);
+    buffer = slapi_ch_malloc(size + 1);
+    print_out_sort_spec(buffer, s, &size);
+    return buffer;
+}
+
 int
 parse_sort_spec(struct berval *sort_spec_ber, sort_spec **ps)
 {
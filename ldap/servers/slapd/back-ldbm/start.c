@@ -162,6 +162,7 @@ ldbm_back_start(Slapi_PBlock *pb)
     /* dynamically created. Code below should only be called once */
     if (!initialized) {
         ldbm_compute_init();
+        idxstats_register_task();
 
         initialized = 1;
     }
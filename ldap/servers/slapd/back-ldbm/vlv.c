@@ -853,21 +853,18 @@ error:
 }
 
 /*
- * Insert or Delete the entry to or from the index
+ * Insert or Delete a key of the index
  */
 
 static int
-do_vlv_update_index(back_txn *txn, struct ldbminfo *li, Slapi_PBlock *pb, struct vlvIndex *pIndex, struct backentry *entry, int insert)
+vlv_update_index_key(back_txn *txn, struct ldbminfo *li, backend *be, struct vlvIndex *pIndex, struct vlv_key *key, ID id, int insert)
 {
-    backend *be;
     int rc = 0;
     dbi_db_t *db = NULL;
     dbi_txn_t *db_txn = NULL;
-    struct vlv_key *key = NULL;
     dbi_val_t data = {0};
     dblayer_private *priv = NULL;
 
-    slapi_pblock_get(pb, SLAPI_BACKEND, &be);
     priv = (dblayer_private *)li->li_dblayer_private;
 
     rc = dblayer_get_index_file(be, pIndex->vlv_attrinfo, &db, DBOPEN_CREATE);
@@ -878,14 +875,6 @@ do_vlv_update_index(back_txn *txn, struct ldbminfo *li, Slapi_PBlock *pb, struct
         return rc;
     }
 
-    key = vlv_create_key(pIndex, entry);
-    if (key == NULL) {
-        slapi_log_err(SLAPI_LOG_ERR, "vlv_create_key", "Unable to generate vlv %s index key."
-                      " There may be a configuration issue.\n", pIndex->vlv_name);
-        dblayer_release_index_file(be, pIndex->vlv_attrinfo, db);
-        return rc;
-    }
-
     if (NULL != txn) {
         db_txn = txn->back_txn_txn;
     } else {
@@ -895,8 +884,8 @@ do_vlv_update_index(back_txn *txn, struct ldbminfo *li, Slapi_PBlock *pb, struct
         /* If there is a txn and it is not an import pseudo txn then clear the vlv cache */
         priv->dblayer_clear_vlv_cache_fn(be, db_txn, db);
     }
-    data.size = sizeof(entry->ep_id);
-    data.data = &entry->ep_id;
+    data.size = sizeof(id);
+    data.data = &id;
 
     if (insert) {
         if (txn && txn->back_special_handling_fn) {
@@ -907,7 +896,7 @@ do_vlv_update_index(back_txn *txn, struct ldbminfo *li, Slapi_PBlock *pb, struct
         if (rc == 0) {
             slapi_log_err(SLAPI_LOG_TRACE,
                           "vlv_update_index", "%s Insert %s ID=%lu\n",
-                          pIndex->vlv_name, (char *)key->key.data, (u_long)entry->ep_id);
+                          pIndex->vlv_name, (char *)key->key.data, (u_long)id);
             if (txn && txn->back_special_handling_fn) {
                 /* In import only one thread works on a given vlv index */
                 pIndex->vlv_indexlength++;
@@ -921,7 +910,7 @@ do_vlv_update_index(back_txn *txn, struct ldbminfo *li, Slapi_PBlock *pb, struct
              * Identical multi valued attr values could do this. */
             slapi_log_err(SLAPI_LOG_TRACE,
                           "vlv_update_index", "%s Insert %s ID=%lu FAILED\n",
-                          pIndex->vlv_name, (char *)key->key.data, (u_long)entry->ep_id);
+                          pIndex->vlv_name, (char *)key->key.data, (u_long)id);
         }
     } else {
         slapi_log_err(SLAPI_LOG_TRACE,
@@ -948,11 +937,34 @@ do_vlv_update_index(back_txn *txn, struct ldbminfo *li, Slapi_PBlock *pb, struct
         }
     }
 
-    vlv_key_delete(&key);
     dblayer_release_index_file(be, pIndex->vlv_attrinfo, db);
     return rc;
 }
 
+/*
+ * Insert or Delete the entry to or from the index
+ */
+
+static int
+do_vlv_update_index(back_txn *txn, struct ldbminfo *li, Slapi_PBlock *pb, struct vlvIndex *pIndex, struct backentry *entry, int insert)
+{
+    backend *be;
+    int rc = 0;
+    struct vlv_key *key = NULL;
+
+    slapi_pblock_get(pb, SLAPI_BACKEND, &be);
+
+    key = vlv_create_key(pIndex, entry);
+    if (key == NULL) {
+        slapi_log_err(SLAPI_LOG_ERR, "vlv_create_key", "Unable to generate vlv %s index key."
+                      " There may be a configuration issue.\n", pIndex->vlv_name);
+        return rc;
+    }
+    rc = vlv_update_index_key(txn, li, be, pIndex, key, entry->ep_id, insert);
+    vlv_key_delete(&key);
+    return rc;
+}
+
 /*
  * Given an entry modification check if a VLV index needs to be updated.
  */
@@ -982,6 +994,73 @@ vlv_update_index(struct vlvIndex *p, back_txn *txn, struct ldbminfo *li, Slapi_P
     return return_value;
 }
 
+/*
+ * Does a MOD change the values of the attribute 'type', or of one of its
+ * subtypes?
+ */
+static int
+vlv_attr_changed(Slapi_Entry *olde, Slapi_Entry *newe, const char *type)
+{
+    Slapi_Attr *a;
+    int nold = 0;
+    int nnew = 0;
+
+    for (a = olde->e_attrs; a != NULL; a = a->a_next) {
+        Slapi_Attr *b;
+        Slapi_Value *v = NULL;
+
+        if (slapi_attr_type_cmp(type, a->a_type, SLAPI_TYPE_CMP_BASE) != 0) {
+            continue;
+        }
+        nold++;
+        b = attrlist_find(newe->e_attrs, a->a_type);
+        if (b == NULL ||
+            slapi_valueset_count(&a->a_present_values) != slapi_valueset_count(&b->a_present_values)) {
+            return 1;
+        }
+        for (int i = slapi_attr_first_value(a, &v); i != -1; i = slapi_attr_next_value(a, i, &v)) {
+            if (slapi_valueset_find(b, &b->a_present_values, v) == NULL) {
+                return 1;
+            }
+        }
+    }
+    for (a = newe->e_attrs; a != NULL; a = a->a_next) {
+        if (slapi_attr_type_cmp(type, a->a_type, SLAPI_TYPE_CMP_BASE) == 0) {
+            nnew++;
+        }
+    }
+    return nold != nnew;
+}
+
+/*
+ * Can a MOD (same dn) change the membership or the position of the entry
+ * in the index? The attributes already compared for another index of the
+ * same operation are remembered in changed/unchanged.
+ */
+static int
+vlv_index_is_affected(struct vlvIndex *p, Slapi_Entry *olde, Slapi_Entry *newe, char ***changed, char ***unchanged)
+{
+    if (p->vlv_attrs_any) {
+        return 1;
+    }
+    for (size_t i = 0; p->vlv_attrs && p->vlv_attrs[i]; i++) {
+        char *type = p->vlv_attrs[i];
+
+        if (charray_inlist(*changed, type)) {
+            return 1;
+        }
+        if (charray_inlist(*unchanged, type)) {
+            continue;
+        }
+        if (vlv_attr_changed(olde, newe, type)) {
+            charray_add(changed, slapi_ch_strdup(type));
+            return 1;
+        }
+        charray_add(unchanged, slapi_ch_strdup(type));
+    }
+    return 0;
+}
+
 /*
  * Given an entry modification check if a VLV index needs to be updated.
  *
@@ -994,8 +1073,7 @@ vlv_update_index(struct vlvIndex *p, back_txn *txn, struct ldbminfo *li, Slapi_P
  * DEL: oldEntry!=NULL && newEntry==NULL
  * MOD: oldEntry!=NULL && newEntry!=NULL
  *
- * JCM: If only non-sorted attributes are changed, then the indexes don't need updating.
- * JCM: Detecting this fact, given multi-valued atribibutes, might be tricky...
+ * MOD: only the indexes filtering or sorting on a modified attribute are updated.
  * Read lock (traverse vlvSearchList; no change on vlvSearchList/vlvIndex lists)
  */
 
@@ -1005,18 +1083,187 @@ vlv_update_all_indexes(back_txn *txn, backend *be, Slapi_PBlock *pb, struct back
     int return_value = LDAP_SUCCESS;
     struct vlvSearch *ps = NULL;
     struct ldbminfo *li = ((ldbm_instance *)be->be_instance_info)->inst_li;
+    /* A MOD keeping the dn can only move the entry in, out of, or inside
+     * the indexes filtering or sorting on a modified attribute */
+    int is_modify = oldEntry && newEntry &&
+                    slapi_sdn_compare(backentry_get_sdn(oldEntry), backentry_get_sdn(newEntry)) == 0;
+    char **changed = NULL;
+    char **unchanged = NULL;
 
     slapi_rwlock_rdlock(be->vlvSearchList_lock);
     ps = (struct vlvSearch *)be->vlvSearchList;
     for (; ps != NULL; ps = ps->vlv_next) {
         struct vlvIndex *pi = ps->vlv_index;
-        for (return_value = LDAP_SUCCESS; return_value == LDAP_SUCCESS && pi != NULL; pi = pi->vlv_next)
+        for (return_value = LDAP_SUCCESS; return_value == LDAP_SUCCESS && pi != NULL; pi = pi->vlv_next) {
+            if (is_modify &&
+                !vlv_index_is_affected(pi, oldEntry->ep_entry, newEntry->ep_entry, &changed, &unchanged)) {
+                continue;
+            }
             return_value = vlv_update_index(pi, txn, li, pb, oldEntry, newEntry);
+        }
     }
     slapi_rwlock_unlock(be->vlvSearchList_lock);
+    charray_free(changed);
+    charray_free(unchanged);
     return return_value;
 }
 
+/*
+ * Rebuild support for db2index: add a batch of entries to several vlv
+ * indexes.
+ *
+ * Testing the entries and building their keys is the expensive part, it
+ * is done by up to 'nthreads' threads, each of them owning a subset of the
+ * indexes. The keys are then written by the calling thread, one
+ * transaction per index if use_txn is set.
+ */
+struct vlv_rebuild_worker
+{
+    backend *be;
+    struct vlvIndex **pvlv;
+    int numvlv;
+    struct backentry **entries;
+    int nentries;
+    int nworkers;
+    int worker;
+    struct vlv_key **keys; /* [index * nentries + entry], NULL: not in the index */
+};
+
+static int
+vlv_rebuild_owner(struct vlvIndex *p, int idx, int nworkers)
+{
+    /* The matching rule indexers are not known to be thread safe, keep
+     * all the indexes using one in the same thread */
+    for (int n = 0; p->vlv_sortkey && p->vlv_mrpb && p->vlv_sortkey[n] != NULL; n++) {
+        if (p->vlv_mrpb[n] != NULL) {
+            return 0;
+        }
+    }
+    return idx % nworkers;
+}
+
+static void
+vlv_rebuild_compute(void *arg)
+{
+    struct vlv_rebuild_worker *w = (struct vlv_rebuild_worker *)arg;
+    Slapi_PBlock *pb = slapi_pblock_new();
+
+    slapi_pblock_set(pb, SLAPI_BACKEND, w->be);
+    slapi_rwlock_rdlock(w->be->vlvSearchList_lock);
+    for (int i = 0; i < w->numvlv; i++) {
+        struct vlvIndex *p = w->pvlv[i];
+
+        if (vlv_rebuild_owner(p, i, w->nworkers) != w->worker) {
+            continue;
+        }
+        for (int j = 0; j < w->nentries; j++) {
+            struct backentry *e = w->entries[j];
+
+            if (slapi_sdn_scope_test(backentry_get_sdn(e), vlvIndex_getBase(p), vlvIndex_getScope(p)) &&
+                slapi_filter_test(pb, e->ep_entry, vlvIndex_getFilter(p), 0 /* No ACL Check */) == 0) {
+                w->keys[i * w->nentries + j] = vlv_create_key(p, e);
+                if (w->keys[i * w->nentries + j] == NULL) {
+                    slapi_log_err(SLAPI_LOG_ERR, "vlv_create_key", "Unable to generate vlv %s index key."
+                                  " There may be a configuration issue.\n", p->vlv_name);
+                }
+            }
+        }
+    }
+    slapi_rwlock_unlock(w->be->vlvSearchList_lock);
+    slapi_pblock_destroy(pb);
+}
+
+int
+vlv_rebuild_entries(backend *be, struct vlvIndex **pvlv, int numvlv, struct backentry **entries, int nentries, int use_txn, int nthreads)
+{
+    struct ldbminfo *li = ((ldbm_instance *)be->be_instance_info)->inst_li;
+    struct vlv_key **keys = NULL;
+    struct vlv_rebuild_worker *workers = NULL;
+    PRThread **threads = NULL;
+    int rc = 0;
+
+    if (numvlv == 0 || nentries == 0) {
+        return 0;
+    }
+    if (nthreads > numvlv) {
+        nthreads = numvlv;
+    }
+    if (nthreads < 1) {
+        nthreads = 1;
+    }
+    keys = (struct vlv_key **)slapi_ch_calloc((size_t)numvlv * nentries, sizeof(struct vlv_key *));
+    workers = (struct vlv_rebuild_worker *)slapi_ch_calloc(nthreads, sizeof(struct vlv_rebuild_worker));
+    threads = (PRThread **)slapi_ch_calloc(nthreads, sizeof(PRThread *));
+    for (int w = 0; w < nthreads; w++) {
+        workers[w].be = be;
+        workers[w].pvlv = pvlv;
+        workers[w].numvlv = numvlv;
+        workers[w].entries = entries;
+        workers[w].nentries = nentries;
+        workers[w].nworkers = nthreads;
+        workers[w].worker = w;
+        workers[w].keys = keys;
+    }
+    /* the calling thread is worker 0 */
+    for (int w = 1; w < nthreads; w++) {
+        threads[w] = PR_CreateThread(PR_USER_THREAD, vlv_rebuild_compute, &workers[w],
+                                     PR_PRIORITY_NORMAL, PR_GLOBAL_THREAD,
+                                     PR_JOINABLE_THREAD, SLAPD_DEFAULT_THREAD_STACKSIZE);
+        if (threads[w] == NULL) {
+            vlv_rebuild_compute(&workers[w]);
+        }
+    }
+    vlv_rebuild_compute(&workers[0]);
+    for (int w = 1; w < nthreads; w++) {
+        if (threads[w]) {
+            PR_JoinThread(threads[w]);
+        }
+    }
+
+    for (int i = 0; rc == 0 && i < numvlv; i++) {
+        back_txn txn;
+
+        dblayer_txn_init(li, &txn);
+        if (use_txn && (rc = dblayer_txn_begin(be, NULL, &txn)) != 0) {
+            slapi_log_err(SLAPI_LOG_ERR, "vlv_rebuild_entries",
+                          "Failed to begin txn for update index '%s' (err %d)\n",
+                          pvlv[i]->vlv_name, rc);
+            break;
+        }
+        /* lock is needed around the index update to protect the vlv structure */
+        vlv_acquire_lock(be);
+        for (int j = 0; rc == 0 && j < nentries; j++) {
+            struct vlv_key *key = keys[i * nentries + j];
+            if (key) {
+                rc = vlv_update_index_key(&txn, li, be, pvlv[i], key, entries[j]->ep_id, 1 /* Insert Key */);
+            }
+        }
+        vlv_release_lock(be);
+        if (use_txn) {
+            if (rc) {
+                dblayer_txn_abort(be, &txn);
+            } else {
+                rc = dblayer_txn_commit(be, &txn);
+            }
+        }
+        if (rc) {
+            slapi_log_err(SLAPI_LOG_ERR, "vlv_rebuild_entries",
+                          "Failed to update index '%s' (err %d)\n",
+                          pvlv[i]->vlv_name, rc);
+        }
+    }
+
+    for (size_t k = 0; k < (size_t)numvlv * nentries; k++) {
+        if (keys[k]) {
+            vlv_key_delete(&keys[k]);
+        }
+    }
+    slapi_ch_free((void **)&keys);
+    slapi_ch_free((void **)&workers);
+    slapi_ch_free((void **)&threads);
+    return rc;
+}
+
 /*
  * Determine the range of record numbers to return.
  * Prevent an underrun, or overrun.
@@ -467,6 +467,54 @@ vlvIndex_new()
     return p;
 }
 
+static int
+vlvIndex_add_filter_attr(Slapi_Filter *f, void *arg)
+{
+    struct vlvIndex *p = (struct vlvIndex *)arg;
+    char *type = NULL;
+
+    if (slapi_filter_get_attribute_type(f, &type) != 0 || type == NULL) {
+        /* e.g. an extensible match without attribute type */
+        p->vlv_attrs_any = 1;
+    } else {
+        char *base = slapi_attr_basetype(type, NULL, 0);
+        char *norm = slapi_attr_syntax_normalize(base);
+
+        if (!charray_inlist(p->vlv_attrs, norm)) {
+            charray_add(&p->vlv_attrs, norm);
+        } else {
+            slapi_ch_free_string(&norm);
+        }
+        slapi_ch_free_string(&base);
+    }
+    return SLAPI_FILTER_SCAN_CONTINUE;
+}
+
+/*
+ * Collect the attributes that decide whether an entry belongs to the
+ * index, and where: the filter and the sort attributes.
+ */
+static void
+vlvIndex_init_attrs(struct vlvIndex *p, struct vlvSearch *pSearch)
+{
+    int err = 0;
+
+    if (pSearch->vlv_slapifilter) {
+        slapi_filter_apply(pSearch->vlv_slapifilter, vlvIndex_add_filter_attr, p, &err);
+    }
+    for (int n = 0; p->vlv_sortkey[n] != NULL; n++) {
+        char *base = slapi_attr_basetype(p->vlv_sortkey[n]->sk_attrtype, NULL, 0);
+        char *norm = slapi_attr_syntax_normalize(base);
+
+        if (!charray_inlist(p->vlv_attrs, norm)) {
+            charray_add(&p->vlv_attrs, norm);
+        } else {
+            slapi_ch_free_string(&norm);
+        }
+        slapi_ch_free_string(&base);
+    }
+}
+
 /*
  * Destroy an existing vlvIndex object
  */
@@ -486,6 +534,7 @@ vlvIndex_delete(struct vlvIndex **ppvs)
             }
         }
         internal_ldap_free_sort_keylist((*ppvs)->vlv_sortkey);
+        charray_free((*ppvs)->vlv_attrs);
         dblayer_erase_index_file((*ppvs)->vlv_be, (*ppvs)->vlv_attrinfo, PR_FALSE, 1 /* chkpt if not busy */);
         attrinfo_delete(&((*ppvs)->vlv_attrinfo));
         slapi_ch_free((void **)&((*ppvs)->vlv_name));
@@ -537,6 +586,7 @@ vlvIndex_init(struct vlvIndex *p, backend *be, struct vlvSearch *pSearch, const
             }
         }
     }
+    vlvIndex_init_attrs(p, pSearch);
 
     /* Create an index filename for the search */
     filename = vlvIndex_build_filename(p->vlv_name);
@@ -79,6 +79,11 @@ struct vlvIndex
     /* Matching Rule PBlock. One for each LDAPsortkey */
     Slapi_PBlock **vlv_mrpb;
 
+    /* Base types of the filter and sort attributes, the index is only
+     * updated when a modify changes one of them (vlv_update_all_indexes) */
+    char **vlv_attrs;
+    int vlv_attrs_any; /* the filter may match any attribute */
+
     /* Keep track of the index length */
     PRLock *vlv_indexlength_lock;
     int vlv_indexlength_cached;
@@ -19,6 +19,7 @@
 #include <string.h> /* strdup */
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <malloc.h> /* malloc_usable_size */
 #include "slap.h"
 
 #define OOM_PREALLOC_SIZE 65536
@@ -288,6 +289,19 @@ slapi_ch_free(void **ptr)
     return;
 }
 
+/*
+ * Bytes really used by a block of slapi_ch_malloc and friends, rounded
+ * up by the allocator, to account memory (the entry cache size).
+ * ptr must be the start of a block or NULL.
+ */
+size_t
+slapi_ch_usable_size(const void *ptr)
+{
+    if (ptr == NULL) {
+        return 0;
+    }
+    return malloc_usable_size((void *)ptr);
+}
 
 /* just like slapi_ch_free, takes the address of the struct berval pointer */
 void
@@ -31,6 +31,8 @@ typedef Connection work_q_item;
 static void connection_threadmain(void *arg);
 static void connection_add_operation(Connection *conn, Operation *op);
 static void connection_free_private_buffer(Connection *conn);
+static void connection_activity_rank(Connection *conn, int rate);
+static void connection_activity_unrank(Connection *conn);
 static void op_copy_identity(Connection *conn, Operation *op);
 static void connection_set_ssl_ssf(Connection *conn);
 static int is_ber_too_big(const Connection *conn, ber_len_t ber_len);
@@ -155,6 +157,7 @@ connection_done(Connection *conn)
     if (NULL != conn->c_pdumutex) {
         PR_DestroyLock(conn->c_pdumutex);
     }
+    result_writer_conn_free(conn);
     /* PAGED_RESULTS */
     pagedresults_cleanup_all(conn, 0);
 
@@ -179,6 +182,9 @@ connection_cleanup(Connection *conn)
 
     /* Call the plugin extension destructors */
     factory_destroy_extension(connection_type, conn, NULL /*Parent*/, &(conn->c_extension));
+    if (conn->c_private) {
+        connection_activity_unrank(conn);
+    }
     /*
      * We hang onto these, since we can reuse them.
      * Sockbuf *c_sb;
@@ -186,6 +192,7 @@ connection_cleanup(Connection *conn)
      * PRLock *c_pdumutex;
      * Conn_private *c_private;
      */
+    result_writer_conn_reset(conn);
     if (conn->c_prfd) {
         PR_Close(conn->c_prfd);
     }
@@ -203,6 +210,9 @@ connection_cleanup(Connection *conn)
     conn->c_ldapversion = 0;
 
     conn->c_isreplication_session = 0;
+    if (conn->c_repl_apply) {
+        connection_repl_apply_free(&conn->c_repl_apply);
+    }
     slapi_ch_free((void **)&conn->cin_addr);
     slapi_ch_free((void **)&conn->cin_destaddr);
     slapi_ch_free((void **)&conn->cin_addr_aclip);
@@ -869,8 +879,72 @@ struct Conn_private
     size_t c_buffer_bytes;            /* number of bytes currently stored in the buffer */
     size_t c_buffer_offset;           /* offset to the location of new data in the buffer */
     int use_buffer;                   /* if true, use the buffer - if false, ber_get_next reads directly from socket */
+    int activity_ranked;              /* if true, the connection is counted in the activity histogram */
+    int activity_bucket;              /* the histogram bucket of operation_rate */
 };
 
+/*
+ * Activity histogram of the active connections, used to rank them for the
+ * turbo mode without walking the connection table.
+ * Every active connection is counted in the bucket of its last operation
+ * rate: the rates below CONN_ACTIVITY_LINEAR have their own bucket, then
+ * each power of two is split in CONN_ACTIVITY_SUB buckets. The rank of a
+ * connection is the number of connections in the buckets above its own,
+ * the connections sharing a bucket are considered equally active.
+ * The buckets are updated atomically under the c_mutex of the connection
+ * that moves, and read without lock.
+ */
+#define CONN_ACTIVITY_SUB_BITS 2
+#define CONN_ACTIVITY_SUB (1 << CONN_ACTIVITY_SUB_BITS)
+#define CONN_ACTIVITY_LINEAR (2 * CONN_ACTIVITY_SUB)
+#define CONN_ACTIVITY_BUCKETS ((32 - CONN_ACTIVITY_SUB_BITS) * CONN_ACTIVITY_SUB)
+
+static uint64_t conn_activity_histo[CONN_ACTIVITY_BUCKETS];
+static uint64_t conn_activity_total; /* number of ranked connections */
+
+static int
+connection_activity_bucket(int rate)
+{
+    int msb;
+
+    if (rate < CONN_ACTIVITY_LINEAR) {
+        return rate < 0 ? 0 : rate;
+    }
+    msb = 31 - __builtin_clz((unsigned int)rate);
+    return (msb - CONN_ACTIVITY_SUB_BITS + 1) * CONN_ACTIVITY_SUB +
+           ((rate >> (msb - CONN_ACTIVITY_SUB_BITS)) & (CONN_ACTIVITY_SUB - 1));
+}
+
+/* Count the connection in the bucket of this rate, c_mutex must be held */
+static void
+connection_activity_rank(Connection *conn, int rate)
+{
+    int bucket = connection_activity_bucket(rate);
+
+    if (conn->c_private->activity_ranked) {
+        if (bucket == conn->c_private->activity_bucket) {
+            return;
+        }
+        slapi_atomic_decr_64(&conn_activity_histo[conn->c_private->activity_bucket], __ATOMIC_RELAXED);
+    } else {
+        slapi_atomic_incr_64(&conn_activity_total, __ATOMIC_RELAXED);
+        conn->c_private->activity_ranked = 1;
+    }
+    slapi_atomic_incr_64(&conn_activity_histo[bucket], __ATOMIC_RELAXED);
+    conn->c_private->activity_bucket = bucket;
+}
+
+/* The connection is no longer active, c_mutex must be held */
+static void
+connection_activity_unrank(Connection *conn)
+{
+    if (conn->c_private->activity_ranked) {
+        slapi_atomic_decr_64(&conn_activity_histo[conn->c_private->activity_bucket], __ATOMIC_RELAXED);
+        slapi_atomic_decr_64(&conn_activity_total, __ATOMIC_RELAXED);
+        conn->c_private->activity_ranked = 0;
+    }
+}
+
 /* Copy up to bytes_to_read bytes from b into return_buffer.
  * Returns a count of bytes copied (always >= 0).
  */
@@ -958,11 +1032,13 @@ connection_new_private(Connection *conn)
         size_t c_buffer_size = conn->c_private->c_buffer_size;
         int use_buffer = conn->c_private->use_buffer;
 
+        connection_activity_unrank(conn);
         memset(conn->c_private, 0, sizeof(Conn_private));
         conn->c_private->c_buffer = c_buffer;
         conn->c_private->c_buffer_size = c_buffer_size;
         conn->c_private->use_buffer = use_buffer;
     }
+    connection_activity_rank(conn, 0);
 
     return 0;
 }
@@ -1005,7 +1081,10 @@ connection_free_private_buffer(Connection *conn)
  * currently in turbo mode or not. Activity is measured as
  * the number of operations initiated since the last check was done.
  * The N connections with the highest activity level are allowed
- * to enter turbo mode. If the current connection is in the top N,
+ * to enter turbo mode. The rank of a connection is read from an
+ * activity histogram maintained as the rates are sampled, so the
+ * check does not depend on the number of connections.
+ * If the current connection is in the top N,
  * then we decide to enter turbo mode. If the current connection
  * is no longer in the top N, then we leave turbo mode.
  * The decision to enter or leave turbo mode is taken under
@@ -1548,6 +1627,10 @@ connection_read_operation(Connection *conn, Operation *op, ber_tag_t *tag, int *
         break;
     }
     op->o_tag = *tag;
+    if (conn->c_repl_apply) {
+        /* order in which the updates must be applied, see connection_repl_apply_enter */
+        op->o_repl_seq = ++conn->c_repl_apply->next_seq;
+    }
 done:
     pthread_mutex_unlock(&(conn->c_mutex));
     return ret;
@@ -1585,6 +1668,8 @@ connection_check_activity_level(Connection *conn)
     delta_count = current_count - conn->c_private->previous_op_count;
     /* delta is the rate, store that */
     conn->c_private->operation_rate = delta_count;
+    /* and move the connection to its new rank */
+    connection_activity_rank(conn, delta_count);
     /* store current count in the previous count slot */
     conn->c_private->previous_op_count = current_count;
     /* update the last checked time */
@@ -1593,37 +1678,20 @@ connection_check_activity_level(Connection *conn)
     slapi_log_err(SLAPI_LOG_CONNS, "connection_check_activity_level", "conn %" PRIu64 " activity level = %d\n", conn->c_connid, delta_count);
 }
 
-typedef struct table_iterate_info_struct
-{
-    int connection_count;
-    int rank_count;
-    int our_rate;
-} table_iterate_info;
-
-int
-table_iterate_function(Connection *conn, void *arg)
-{
-    int ret = 0;
-    table_iterate_info *pinfo = (table_iterate_info *)arg;
-    pinfo->connection_count++;
-    if (conn->c_private->operation_rate > pinfo->our_rate) {
-        pinfo->rank_count++;
-    }
-    return ret;
-}
-
 /*
- * Scan the list of active connections, evaluate our relative rank
- * for connection activity.
+ * Evaluate our relative rank for connection activity: the number of
+ * active connections more active than this one.
  */
 void
 connection_find_our_rank(Connection *conn, int *connection_count, int *our_rank)
 {
-    table_iterate_info info = {0};
-    info.our_rate = conn->c_private->operation_rate;
-    connection_table_iterate_active_connections(the_connection_table, &info, &table_iterate_function);
-    *connection_count = info.connection_count;
-    *our_rank = info.rank_count;
+    uint64_t rank = 0;
+
+    for (size_t i = conn->c_private->activity_bucket + 1; i < CONN_ACTIVITY_BUCKETS; i++) {
+        rank += slapi_atomic_load_64(&conn_activity_histo[i], __ATOMIC_RELAXED);
+    }
+    *connection_count = (int)slapi_atomic_load_64(&conn_activity_total, __ATOMIC_RELAXED);
+    *our_rank = (int)rank;
 }
 
 /*
@@ -1693,6 +1761,357 @@ connection_enter_leave_turbo(Connection *conn, int current_turbo_flag, int *new_
     *new_turbo_flag = new_mode;
 }
 
+/*
+ * Switch the turbo mode of the thread, keeping the monitor counters
+ */
+static int
+connection_set_turbo(int current_turbo_flag, int new_turbo_flag)
+{
+    if (new_turbo_flag && !current_turbo_flag) {
+        slapi_counter_increment(turbo_mode_count);
+        slapi_counter_increment(conns_in_turbo);
+    } else if (!new_turbo_flag && current_turbo_flag) {
+        slapi_counter_decrement(conns_in_turbo);
+    }
+    return new_turbo_flag;
+}
+
+/*
+ * Parallel apply of the updates received on a replication connection.
+ *
+ * A replication connection is normally made readable again only once its
+ * current operation is complete, so the updates sent by a supplier are
+ * applied one at a time.  When the replica allows several apply threads
+ * (slapi_connection_set_repl_apply_threads), the updates that do not depend
+ * on each other (no common, parent or child DN) are dispatched as soon as
+ * they are read.  Each operation read on the connection gets a sequence
+ * number (o_repl_seq) and:
+ *  - the operations enter the pipeline in that order;
+ *  - the replication plugin adds the operation CSN to the RUV pending list in
+ *    that order (slapi_op_repl_apply_turn/slapi_op_repl_apply_passed), so the
+ *    RUV only moves past a CSN once all the previous ones are committed;
+ *  - anything else than add/modify/delete/modrdn waits for the updates in
+ *    flight and is processed alone, as before.
+ */
+typedef struct repl_apply_op
+{
+    Operation *op;
+    uint64_t seq;
+    Slapi_DN **sdns;    /* DNs the update depends on */
+    int32_t passed;     /* the CSN of the update was registered */
+    int32_t dep_waited; /* the update waited for a dependency to be applied */
+    struct repl_apply_op *next;
+} repl_apply_op;
+
+struct repl_apply_pipeline
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cv;
+    int32_t max_inflight;
+    int32_t inflight;
+    uint64_t next_seq; /* last sequence number given, protected by c_mutex */
+    uint64_t entered;  /* last sequence number that entered the pipeline */
+    uint64_t turn;     /* last sequence number that registered its CSN */
+    repl_apply_op *ops;
+};
+
+static void
+connection_repl_apply_free_dns(Slapi_DN ***sdns)
+{
+    if (*sdns) {
+        for (size_t i = 0; (*sdns)[i]; i++) {
+            slapi_sdn_free(&(*sdns)[i]);
+        }
+        slapi_ch_free((void **)sdns);
+    }
+}
+
+static void
+connection_repl_apply_free(struct repl_apply_pipeline **pipe)
+{
+    repl_apply_op *rop;
+
+    while ((rop = (*pipe)->ops)) {
+        (*pipe)->ops = rop->next;
+        connection_repl_apply_free_dns(&rop->sdns);
+        slapi_ch_free((void **)&rop);
+    }
+    pthread_cond_destroy(&(*pipe)->cv);
+    pthread_mutex_destroy(&(*pipe)->lock);
+    slapi_ch_free((void **)pipe);
+}
+
+/*
+ * Peek the DNs touched by an update, without consuming the request.
+ * Returns NULL if the operation must not run in parallel.
+ */
+static Slapi_DN **
+connection_repl_apply_get_dns(Operation *op, ber_tag_t tag)
+{
+    BerElement *ber = ber_dup(op->o_ber);
+    Slapi_DN **sdns = NULL;
+    char *rawdn = NULL;
+    char *newrdn = NULL;
+    char *newsuperior = NULL;
+    ber_int_t deloldrdn = 0;
+    ber_len_t len = 0;
+    ber_tag_t rc = LBER_ERROR;
+
+    if (ber == NULL) {
+        return NULL;
+    }
+    switch (tag) {
+    case LDAP_REQ_ADD:
+    case LDAP_REQ_MODIFY:
+        rc = ber_scanf(ber, "{a", &rawdn);
+        break;
+    case LDAP_REQ_DELETE:
+        rc = ber_scanf(ber, "a", &rawdn);
+        break;
+    case LDAP_REQ_MODRDN:
+        rc = ber_scanf(ber, "{aab", &rawdn, &newrdn, &deloldrdn);
+        if ((rc != LBER_ERROR) && (ber_peek_tag(ber, &len) == LDAP_TAG_NEWSUPERIOR)) {
+            rc = ber_scanf(ber, "a", &newsuperior);
+        }
+        break;
+    default:
+        break;
+    }
+    ber_free(ber, 0);
+
+    if ((rc != LBER_ERROR) && rawdn) {
+        sdns = (Slapi_DN **)slapi_ch_calloc(3, sizeof(Slapi_DN *));
+        sdns[0] = slapi_sdn_new_dn_byval(rawdn);
+        if (newrdn) {
+            /* the entry is also known by its new DN once renamed */
+            Slapi_DN parent;
+
+            slapi_sdn_init(&parent);
+            if (newsuperior) {
+                slapi_sdn_set_dn_byval(&parent, newsuperior);
+            } else {
+                slapi_sdn_get_parent(sdns[0], &parent);
+            }
+            if (slapi_sdn_isempty(&parent)) {
+                sdns[1] = slapi_sdn_new_dn_byval(newrdn);
+            } else {
+                sdns[1] = slapi_sdn_new_dn_passin(slapi_ch_smprintf("%s,%s", newrdn, slapi_sdn_get_dn(&parent)));
+            }
+            slapi_sdn_done(&parent);
+        }
+        for (size_t i = 0; sdns[i]; i++) {
+            if (slapi_sdn_get_ndn(sdns[i]) == NULL) {
+                /* invalid DN, let the operation report it in order */
+                connection_repl_apply_free_dns(&sdns);
+                break;
+            }
+        }
+    }
+    slapi_ch_free_string(&rawdn);
+    slapi_ch_free_string(&newrdn);
+    slapi_ch_free_string(&newsuperior);
+    return sdns;
+}
+
+/* Caller must hold pipe->lock */
+static int32_t
+connection_repl_apply_depends(struct repl_apply_pipeline *pipe, Slapi_DN **sdns)
+{
+    for (repl_apply_op *rop = pipe->ops; rop; rop = rop->next) {
+        for (size_t i = 0; rop->sdns[i]; i++) {
+            for (size_t j = 0; sdns[j]; j++) {
+                if (slapi_sdn_issuffix(rop->sdns[i], sdns[j]) ||
+                    slapi_sdn_issuffix(sdns[j], rop->sdns[i])) {
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+/* Caller must hold pipe->lock */
+static repl_apply_op *
+connection_repl_apply_find(struct repl_apply_pipeline *pipe, Operation *op)
+{
+    repl_apply_op *rop;
+
+    for (rop = pipe->ops; rop && (rop->op != op); rop = rop->next)
+        ;
+    return rop;
+}
+
+/*
+ * Called before dispatching an operation read on a connection having a
+ * pipeline.  Returns 1 if the operation runs in parallel with the others,
+ * in which case the connection can be made readable right away.
+ */
+static int32_t
+connection_repl_apply_enter(Connection *conn, Operation *op, ber_tag_t tag, int32_t allowed)
+{
+    struct repl_apply_pipeline *pipe = conn->c_repl_apply;
+    repl_apply_op *rop = NULL;
+    Slapi_DN **sdns = NULL;
+    int32_t dep_waited = 0;
+
+    if (allowed) {
+        sdns = connection_repl_apply_get_dns(op, tag);
+    }
+
+    pthread_mutex_lock(&pipe->lock);
+    while (pipe->entered + 1 != op->o_repl_seq) {
+        pthread_cond_wait(&pipe->cv, &pipe->lock);
+    }
+    if (sdns && (pipe->max_inflight > 1)) {
+        while (1) {
+            if (connection_repl_apply_depends(pipe, sdns)) {
+                dep_waited = 1;
+            } else if (pipe->inflight < pipe->max_inflight) {
+                break;
+            }
+            pthread_cond_wait(&pipe->cv, &pipe->lock);
+        }
+        rop = (repl_apply_op *)slapi_ch_calloc(1, sizeof(repl_apply_op));
+        rop->op = op;
+        rop->seq = op->o_repl_seq;
+        rop->sdns = sdns;
+        rop->dep_waited = dep_waited;
+        rop->next = pipe->ops;
+        pipe->ops = rop;
+        pipe->inflight++;
+    } else {
+        /* processed alone, once all the previous updates are applied */
+        while (pipe->inflight > 0) {
+            pthread_cond_wait(&pipe->cv, &pipe->lock);
+        }
+        pipe->turn = op->o_repl_seq;
+        connection_repl_apply_free_dns(&sdns);
+    }
+    pipe->entered = op->o_repl_seq;
+    pthread_cond_broadcast(&pipe->cv);
+    pthread_mutex_unlock(&pipe->lock);
+
+    return rop ? 1 : 0;
+}
+
+static void
+connection_repl_apply_leave(Connection *conn, Operation *op)
+{
+    struct repl_apply_pipeline *pipe = conn->c_repl_apply;
+    repl_apply_op **prev;
+    repl_apply_op *rop;
+
+    pthread_mutex_lock(&pipe->lock);
+    for (prev = &pipe->ops; *prev && ((*prev)->op != op); prev = &(*prev)->next)
+        ;
+    rop = *prev;
+    if (rop) {
+        if (!rop->passed) {
+            /* the update was rejected before registering its CSN */
+            while (pipe->turn + 1 != rop->seq) {
+                pthread_cond_wait(&pipe->cv, &pipe->lock);
+            }
+            pipe->turn = rop->seq;
+        }
+        *prev = rop->next;
+        pipe->inflight--;
+        pthread_cond_broadcast(&pipe->cv);
+    }
+    pthread_mutex_unlock(&pipe->lock);
+
+    if (rop) {
+        connection_repl_apply_free_dns(&rop->sdns);
+        slapi_ch_free((void **)&rop);
+    }
+}
+
+void
+slapi_connection_set_repl_apply_threads(Slapi_Connection *conn, int32_t nthreads)
+{
+    struct repl_apply_pipeline *pipe;
+
+    if (conn == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&(conn->c_mutex));
+    pipe = conn->c_repl_apply;
+    if ((pipe == NULL) && (nthreads > 1)) {
+        pipe = (struct repl_apply_pipeline *)slapi_ch_calloc(1, sizeof(struct repl_apply_pipeline));
+        pthread_mutex_init(&pipe->lock, NULL);
+        pthread_cond_init(&pipe->cv, NULL);
+        conn->c_repl_apply = pipe;
+    }
+    if (pipe) {
+        pthread_mutex_lock(&pipe->lock);
+        pipe->max_inflight = (nthreads > 1) ? nthreads : 1;
+        pthread_mutex_unlock(&pipe->lock);
+    }
+    pthread_mutex_unlock(&(conn->c_mutex));
+}
+
+/*
+ * Wait until all the updates read before this one registered their CSN.
+ * Returns the number of updates in flight on the connection, 0 if the
+ * operation is not part of a pipeline.
+ */
+int32_t
+slapi_op_repl_apply_turn(Slapi_PBlock *pb, int32_t *dep_waited)
+{
+    Connection *conn = NULL;
+    Operation *op = NULL;
+    struct repl_apply_pipeline *pipe;
+    repl_apply_op *rop;
+    int32_t inflight = 0;
+
+    slapi_pblock_get(pb, SLAPI_CONNECTION, &conn);
+    slapi_pblock_get(pb, SLAPI_OPERATION, &op);
+    if ((conn == NULL) || (op == NULL) || (op->o_repl_seq == 0) || (conn->c_repl_apply == NULL)) {
+        return 0;
+    }
+    pipe = conn->c_repl_apply;
+
+    pthread_mutex_lock(&pipe->lock);
+    rop = connection_repl_apply_find(pipe, op);
+    if (rop && !rop->passed) {
+        while (pipe->turn + 1 != rop->seq) {
+            pthread_cond_wait(&pipe->cv, &pipe->lock);
+        }
+        inflight = pipe->inflight;
+        if (dep_waited) {
+            *dep_waited = rop->dep_waited;
+        }
+    }
+    pthread_mutex_unlock(&pipe->lock);
+
+    return inflight;
+}
+
+/* The CSN of the update is registered, let the next update register its own */
+void
+slapi_op_repl_apply_passed(Slapi_PBlock *pb)
+{
+    Connection *conn = NULL;
+    Operation *op = NULL;
+    struct repl_apply_pipeline *pipe;
+    repl_apply_op *rop;
+
+    slapi_pblock_get(pb, SLAPI_CONNECTION, &conn);
+    slapi_pblock_get(pb, SLAPI_OPERATION, &op);
+    if ((conn == NULL) || (op == NULL) || (op->o_repl_seq == 0) || (conn->c_repl_apply == NULL)) {
+        return;
+    }
+    pipe = conn->c_repl_apply;
+
+    pthread_mutex_lock(&pipe->lock);
+    rop = connection_repl_apply_find(pipe, op);
+    if (rop && !rop->passed && (pipe->turn + 1 == rop->seq)) {
+        rop->passed = 1;
+        pipe->turn = rop->seq;
+        pthread_cond_broadcast(&pipe->cv);
+    }
+    pthread_mutex_unlock(&pipe->lock);
+}
+
 static void
 connection_threadmain(void *arg)
 {
@@ -1707,6 +2126,7 @@ connection_threadmain(void *arg)
     int ret = 0;
     int more_data = 0;
     int replication_connection = 0; /* If this connection is from a replication supplier, we want to ensure that operation processing is serialized */
+    int32_t repl_pipelined = 0;     /* ... unless the update is applied in parallel with the previous ones */
     int doshutdown = 0;
     int maxthreads = 0;
     long bypasspollcnt = 0;
@@ -1721,6 +2141,8 @@ connection_threadmain(void *arg)
         int is_timedout = 0;
         time_t curtime = 0;
 
+        repl_pipelined = 0;
+
         if (op_shutdown) {
             slapi_log_err(SLAPI_LOG_TRACE, "connection_threadmain",
                           "op_thread received shutdown signal\n");
@@ -1858,15 +2280,15 @@ connection_threadmain(void *arg)
                 connection_check_activity_level(conn);
                 /* And if appropriate, change into or out of turbo mode */
                 connection_enter_leave_turbo(conn, thread_turbo_flag, &new_turbo_flag);
-                thread_turbo_flag = new_turbo_flag;
+                thread_turbo_flag = connection_set_turbo(thread_turbo_flag, new_turbo_flag);
             } else {
-                thread_turbo_flag = 0;
+                thread_turbo_flag = connection_set_turbo(thread_turbo_flag, 0);
             }
         }
 
         /* turn off turbo mode immediately if any pb waiting in global queue */
         if (thread_turbo_flag && !WORK_Q_EMPTY) {
-            thread_turbo_flag = 0;
+            thread_turbo_flag = connection_set_turbo(thread_turbo_flag, 0);
             slapi_log_err(SLAPI_LOG_CONNS, "connection_threadmain",
                           "conn %" PRIu64 " leaving turbo mode - pb_q is not empty %d\n",
                           conn->c_connid, work_q_size);
@@ -1878,7 +2300,7 @@ connection_threadmain(void *arg)
         /* This means that the connection was closed, so clear turbo mode */
         /*FALLTHROUGH*/
         case CONN_TIMEDOUT:
-            thread_turbo_flag = 0;
+            thread_turbo_flag = connection_set_turbo(thread_turbo_flag, 0);
             is_timedout = 1;
             /* In the case of CONN_DONE, more_data could have been set to 1
                  * in connection_read_operation before an error was encountered.
@@ -1936,10 +2358,14 @@ connection_threadmain(void *arg)
          * more_data: [blackflag 624234]
          * If the connection is from a replication supplier, don't make it readable here.
          * We want to ensure that replication operations are processed strictly in the order
-         * they are received off the wire.
+         * they are received off the wire, unless the replica allows to apply the updates
+         * that don't depend on each other in parallel.
          */
         replication_connection = conn->c_isreplication_session;
-        if ((tag != LDAP_REQ_UNBIND) && !thread_turbo_flag && !replication_connection) {
+        if (op->o_repl_seq) {
+            repl_pipelined = connection_repl_apply_enter(conn, op, tag, !thread_turbo_flag);
+        }
+        if ((tag != LDAP_REQ_UNBIND) && !thread_turbo_flag && (!replication_connection || repl_pipelined)) {
             if (!more_data) {
                 conn->c_flags &= ~CONN_FLAG_MAX_THREADS;
                 pthread_mutex_lock(&(conn->c_mutex));
@@ -2048,6 +2474,10 @@ connection_threadmain(void *arg)
          * there's more work to do right now on this conn.
          */
 
+        if (repl_pipelined) {
+            connection_repl_apply_leave(conn, op);
+        }
+
         /* number of ops on this connection */
         PR_AtomicIncrement(&conn->c_opscompleted);
         /* total number of ops for the server */
@@ -2100,7 +2530,7 @@ connection_threadmain(void *arg)
                      * Don't release the connection now.
                      * But note down what to do.
                      */
-                    if (replication_connection || (1 == is_timedout)) {
+                    if ((replication_connection && !repl_pipelined) || (1 == is_timedout)) {
                         connection_make_readable_nolock(conn);
                         need_wakeup = 1;
                     }
@@ -2661,6 +3091,12 @@ int
 connection_call_io_layer_callbacks(Connection *c)
 {
     int rv = 0;
+
+    /* the queued results are sent with the current layers */
+    if ((c->c_pop_io_layer_cb || c->c_push_io_layer_cb) && result_writer_drain(c)) {
+        slapi_log_err(SLAPI_LOG_CONNS, "connection_call_io_layer_callbacks",
+                      "Queued results of connection %" PRIu64 " were not sent\n", c->c_connid);
+    }
     if (c->c_pop_io_layer_cb) {
         rv = (c->c_pop_io_layer_cb)(c, c->c_io_layer_cb_data);
         c->c_pop_io_layer_cb = NULL;
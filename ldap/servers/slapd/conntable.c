@@ -217,6 +217,7 @@ connection_table_new(int table_size)
                 slapi_log_err(SLAPI_LOG_ERR, "connection_table_new", "PR_NewLock failed\n");
                 exit(1);
             }
+            result_writer_conn_init(&(ct->c[ct_list][i]));
 
             /* Ready to rock, mark as such. */
             ct->c[ct_list][i].c_state = CONN_STATE_INIT;
@@ -309,9 +310,9 @@ connection_table_disconnect_all(Connection_Table *ct)
 /* Given a file descriptor for a socket, this function will return
  * a slot in the connection table to use.
  *
- * Note: this function is only called from the slapd_daemon (listener)
- * thread, which means it will never be called by two threads at
- * the same time.
+ * Note: this function is called by the accept threads, possibly by
+ * several of them at the same time.  The freelist is only touched under
+ * ct->table_mutex, so each caller gets a slot no other thread holds.
  *
  * Returns a Connection on success
  * Returns NULL on failure
@@ -350,8 +351,9 @@ connection_table_get_connection(Connection_Table *ct, int sd)
 
     /*
      * Note: no need to lock c->c_mutex because this function is only
-     * called by one thread (the slapd_daemon thread), and if we got this
-     * far then `c' is not being used by any operation threads, etc. The
+     * called by the accept threads, and if we got this far then `c' was
+     * taken off the freelist by this thread and is not being used by any
+     * operation threads, etc. The
      * memory ordering will be provided by the work queue sending c to a
      * thread.
      */
@@ -549,8 +551,13 @@ connection_table_move_connection_on_to_active_list(Connection_Table *ct, Connect
     connection_table_dump_active_connection(c);
 #endif
 
-    /* Get the least used ct list and incremant its number of active connections. */
-    c->c_ct_list = connection_table_get_list(ct);
+    /*
+     * The accept thread normally chose the ct list already, before it registered
+     * the connection with that list's epoll. Otherwise use the least used list.
+     */
+    if (c->c_ct_list < 0 || (size_t)c->c_ct_list >= ct->list_num) {
+        c->c_ct_list = connection_table_get_list(ct);
+    }
     (*(ct->num_active + c->c_ct_list))++;
 
     c->c_next = ct->c[c->c_ct_list][0].c_next;
@@ -583,12 +590,49 @@ connection_table_get_list(Connection_Table *ct)
     return list;
 }
 
+/*
+ * Find the ct list a connection accepted by the accept thread number shard
+ * (of nshards) should go to.  Each accept thread has its own lists when there
+ * are enough of them, lists shard, shard + nshards, ..., and takes the least
+ * used one, so that the accept threads do not all pile their connections on
+ * the same list.
+ */
+int
+connection_table_get_accept_list(Connection_Table *ct, int shard, int nshards)
+{
+    size_t i;
+    int list;
+    int lowest;
+
+    if (nshards < 1 || shard < 0) {
+        shard = 0;
+        nshards = 1;
+    }
+    if ((size_t)nshards > ct->list_num) {
+        return shard % ct->list_num;
+    }
+
+    PR_Lock(ct->table_mutex);
+    list = shard;
+    lowest = ct->num_active[shard];
+    for (i = shard + nshards; i < ct->list_num; i += nshards) {
+        if (*(ct->num_active + i) < lowest) {
+            lowest = *(ct->num_active + i);
+            list = i;
+        }
+    }
+    PR_Unlock(ct->table_mutex);
+    return list;
+}
+
 /*
  * Replace the following attributes within the entry 'e' with
  * information about the connection table:
  *    connection            // multivalued; one value for each active connection
  *    currentconnections    // single valued; an integer count
  *    totalconnections        // single valued; an integer count
+ *    currentconnectionsinturbo // single valued; an integer count
+ *    turbomodehits         // single valued; an integer count
  *    dtablesize            // single valued; an integer size
  *    readwaiters            // single valued; an integer count
  */
@@ -718,6 +762,16 @@ connection_table_as_entry(Connection_Table *ct, Slapi_Entry *e)
     val.bv_len = strlen(buf);
     attrlist_replace(&e->e_attrs, "maxthreadsperconnhits", vals);
 
+    snprintf(buf, sizeof(buf), "%" PRIu64, slapi_counter_get_value(conns_in_turbo));
+    val.bv_val = buf;
+    val.bv_len = strlen(buf);
+    attrlist_replace(&e->e_attrs, "currentconnectionsinturbo", vals);
+
+    snprintf(buf, sizeof(buf), "%" PRIu64, slapi_counter_get_value(turbo_mode_count));
+    val.bv_val = buf;
+    val.bv_len = strlen(buf);
+    attrlist_replace(&e->e_attrs, "turbomodehits", vals);
+
     snprintf(buf, sizeof(buf), "%d", (ct != NULL ? ct->size : 0));
     val.bv_val = buf;
     val.bv_len = strlen(buf);
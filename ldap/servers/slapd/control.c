@@ -93,6 +93,10 @@ init_controls(void)
     slapi_register_supported_control(LDAP_CONTROL_PAGEDRESULTS,
                                      SLAPI_OPERATION_SEARCH);
 
+    /* LDAP_CONTROL_FILTER_PLAN is shared by request and response */
+    slapi_register_supported_control(LDAP_CONTROL_FILTER_PLAN,
+                                     SLAPI_OPERATION_SEARCH);
+
     /* LDAP_CONTROL_X_SESSION_TRACKING only supported by request */
     slapi_register_supported_control(LDAP_CONTROL_X_SESSION_TRACKING,
                                      SLAPI_OPERATION_BIND | SLAPI_OPERATION_UNBIND | SLAPI_OPERATION_ABANDON | SLAPI_OPERATION_EXTENDED | SLAPI_OPERATION_SEARCH | SLAPI_OPERATION_COMPARE | SLAPI_OPERATION_ADD | SLAPI_OPERATION_DELETE | SLAPI_OPERATION_MODIFY | SLAPI_OPERATION_MODDN);
@@ -286,7 +286,7 @@ csnset_size(CSNSet *csnset)
     size_t s = 0;
     CSNSet *n = csnset;
     while (n != NULL) {
-        s += sizeof(CSNSet);
+        s += slapi_ch_usable_size(n);
         n = n->next;
     }
     return s;
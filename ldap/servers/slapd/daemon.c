@@ -89,7 +89,8 @@ short slapd_housekeeping_timer = 10;
 static signal_pipe *signalpipes;
 static PRInt32 ct_shutdown = 0;
 static PRThread *disk_thread_p = NULL;
-static PRThread *accept_thread_p = NULL;
+static PRThread **accept_threads_p = NULL;
+static PRInt32 accept_threads_running = 0; /* the last one to exit closes the listeners */
 static pthread_cond_t diskmon_cvar;
 static pthread_mutex_t diskmon_mutex;
 
@@ -108,13 +109,22 @@ typedef struct listener_info
     struct ns_job_t *ns_job; /* the ns accept job */
 } listener_info;
 
+/* One per accept thread, with the listener sockets of its shard */
+typedef struct accept_thread_info
+{
+    daemon_ports_t *ports;
+    int shard;                     /* number of this accept thread */
+    int nshards;                   /* number of accept threads */
+    size_t listeners;              /* number of listener sockets of this thread */
+    listener_info *listener_idxs;  /* array of indexes of listener sockets in the fds array */
+} accept_thread_info;
+
 #ifdef ENABLE_EPOLL
 /* Don't be tempted to use EPOLLEXCLUSIVE, it will not wake the correct threads */
 #define EPOLL_EVENTS (EPOLLIN | EPOLLHUP | EPOLLRDHUP | EPOLLERR)
 #endif /* ENABLE_EPOLL */
 
-static size_t listeners = 0;                /* number of listener sockets */
-static listener_info *listener_idxs = NULL; /* array of indexes of listener sockets in the ct->fd array */
+static accept_thread_info *accept_infos = NULL;
 static PRFileDesc *tls_listener = NULL; /* Stashed tls listener for get_ssl_listener_fd */
 
 #define SLAPD_POLL_LISTEN_READY(xxflagsxx) (xxflagsxx & PR_POLL_READ)
@@ -127,14 +137,15 @@ static void get_loopback_by_addr(void);
 static PRFileDesc **createprlistensockets(unsigned short port,
                                           PRNetAddr **listenaddr,
                                           int secure,
-                                          int local);
+                                          int local,
+                                          int shards);
 static const char *netaddr2string(const PRNetAddr *addr, char *addrbuf, size_t addrbuflen);
 static void set_shutdown(int);
 static void setup_pr_ct_firsttime_pds(Connection_Table *ct);
 #ifdef ENABLE_EPOLL
-static PRIntn setup_pr_accept_pds(PRFileDesc **n_tcps, PRFileDesc **s_tcps, PRFileDesc **i_unix, int epoll_fd);
+static PRIntn setup_pr_accept_pds(accept_thread_info *ati, PRFileDesc **n_tcps, PRFileDesc **s_tcps, PRFileDesc **i_unix, int epoll_fd);
 #else
-static PRIntn setup_pr_accept_pds(PRFileDesc **n_tcps, PRFileDesc **s_tcps, PRFileDesc **i_unix, struct POLL_STRUCT **fds);
+static PRIntn setup_pr_accept_pds(accept_thread_info *ati, PRFileDesc **n_tcps, PRFileDesc **s_tcps, PRFileDesc **i_unix, struct POLL_STRUCT **fds);
 #endif /* ENABLE_EPOLL */
 static PRIntn setup_pr_read_pds(Connection_Table *ct, int num_ct_lists);
 
@@ -178,7 +189,7 @@ accept_and_configure(int s __attribute__((unused)), PRFileDesc *listenfd, PRNetA
 /*
  * This is the shiny new re-born daemon function, without all the hair
  */
-static int handle_new_connection(Connection_Table *ct, int tcps, PRFileDesc *listenfd, int secure, int local, Connection **newconn);
+static int handle_new_connection(Connection_Table *ct, int tcps, PRFileDesc *listenfd, int secure, int local, int shard, int nshards, Connection **newconn);
 #ifdef ENABLE_EPOLL
 static void handle_pr_read_ready(Connection_Table *ct, int list_num, struct epoll_event *events, int num_poll);
 #else /* !ENABLE_EPOLL */
@@ -189,6 +200,30 @@ static void unfurl_banners(Connection_Table *ct, daemon_ports_t *ports, PRFileDe
 static int write_pid_file(void);
 static int init_shutdown_detect(void);
 
+/*
+ * Number of accept threads.  Several threads need one listener socket each
+ * per address, which the kernel balances the connections between with
+ * SO_REUSEPORT; without it (or without epoll) there is a single accept thread.
+ */
+static int
+daemon_accept_shards(void)
+{
+    int shards = config_get_accept_threads();
+
+    if (shards < 1) {
+        shards = 1;
+    }
+#if !defined(ENABLE_EPOLL) || !defined(SO_REUSEPORT)
+    if (shards > 1) {
+        slapi_log_err(SLAPI_LOG_WARNING, "daemon_accept_shards",
+                      "%s is %d but listener sockets can not be shared on this platform, using a single accept thread\n",
+                      CONFIG_ACCEPT_THREADS, shards);
+        shards = 1;
+    }
+#endif
+    return shards;
+}
+
 /* Globals which are used to store the sockets between
  * calls to daemon_pre_setuid_init() and the daemon thread
  * creation. */
@@ -198,14 +233,18 @@ daemon_pre_setuid_init(daemon_ports_t *ports)
 {
     int rc = 0;
 
+    ports->accept_shards = daemon_accept_shards();
+
     if (0 != ports->n_port) {
         ports->n_socket = createprlistensockets(ports->n_port,
-                                                ports->n_listenaddr, 0, 0);
+                                                ports->n_listenaddr, 0, 0,
+                                                ports->accept_shards);
     }
 
     if (config_get_security() && (0 != ports->s_port)) {
         ports->s_socket = createprlistensockets((unsigned short)ports->s_port,
-                                                ports->s_listenaddr, 1, 0);
+                                                ports->s_listenaddr, 1, 0,
+                                                ports->accept_shards);
     } else {
         ports->s_socket = SLAPD_INVALID_SOCKET;
     }
@@ -213,7 +252,8 @@ daemon_pre_setuid_init(daemon_ports_t *ports)
 #if defined(ENABLE_LDAPI)
     /* ldapi */
     if (0 != ports->i_port) {
-        ports->i_socket = createprlistensockets(1, ports->i_listenaddr, 0, 1);
+        /* The accept thread 0 is the only one listening for LDAPI */
+        ports->i_socket = createprlistensockets(1, ports->i_listenaddr, 0, 1, 1);
     }
 #endif /* ENABLE_LDAPI */
 
@@ -796,7 +836,7 @@ disk_monitoring_thread(void *nothing __attribute__((unused)))
 
 char *epoll_event_flags_to_string(PRUint32 events)
 {
-    static char buf[64];
+    static __thread char buf[64]; /* used by the accept and ct list threads */
     int len = 0;
 
     if (events & EPOLLIN) {
@@ -842,7 +882,7 @@ char *epoll_event_flags_to_string(PRUint32 events)
 
 #ifdef ENABLE_EPOLL
 static void
-handle_listeners(struct epoll_event *events, int event_count)
+handle_listeners(accept_thread_info *ati, struct epoll_event *events, int event_count)
 {
     Connection_Table *ct = the_connection_table;
     int ctlist = 0;
@@ -855,7 +895,8 @@ handle_listeners(struct epoll_event *events, int event_count)
         if (listenfd) {
             if (events[idx].events & EPOLLIN) {
                /* accept() the new connection, put it on the active list for handle_pr_read_ready */
-                ctlist = handle_new_connection(ct, SLAPD_INVALID_SOCKET, listenfd, secure, local, NULL);
+                ctlist = handle_new_connection(ct, SLAPD_INVALID_SOCKET, listenfd, secure, local,
+                                               ati->shard, ati->nshards, NULL);
                 if (ctlist < 0) {
                     slapi_log_err(SLAPI_LOG_CONNS, "handle_listeners", "Error accepting new connection listenfd=%d\n",
                                   PR_FileDesc2NativeHandle(listenfd));
@@ -871,22 +912,23 @@ handle_listeners(struct epoll_event *events, int event_count)
 }
 #else /* !ENABLE_EPOLL */
 static void
-handle_listeners(struct POLL_STRUCT *fds)
+handle_listeners(accept_thread_info *ati, struct POLL_STRUCT *fds)
 {
     Connection_Table *ct = the_connection_table;
     size_t idx;
     int ctlist = 0;
-    for (idx = 0; idx < listeners; ++idx) {
-        int fdidx = listener_idxs[idx].idx;
-        PRFileDesc *listenfd = listener_idxs[idx].listenfd;
-        int secure = listener_idxs[idx].secure;
-        int local = listener_idxs[idx].local;
+    for (idx = 0; idx < ati->listeners; ++idx) {
+        int fdidx = ati->listener_idxs[idx].idx;
+        PRFileDesc *listenfd = ati->listener_idxs[idx].listenfd;
+        int secure = ati->listener_idxs[idx].secure;
+        int local = ati->listener_idxs[idx].local;
         if (listenfd) {
             PR_ASSERT(fds != NULL);
             PR_ASSERT(listenfd == fds[fdidx].fd);
             if (SLAPD_POLL_LISTEN_READY(fds[fdidx].out_flags)) {
                /* accept() the new connection, put it on the active list for handle_pr_read_ready */
-                ctlist = handle_new_connection(ct, SLAPD_INVALID_SOCKET, listenfd, secure, local, NULL);
+                ctlist = handle_new_connection(ct, SLAPD_INVALID_SOCKET, listenfd, secure, local,
+                                               ati->shard, ati->nshards, NULL);
                 if (ctlist < 0) {
                     slapi_log_err(SLAPI_LOG_CONNS, "handle_listeners", "Error accepting new connection listenfd=%d\n",
                                   PR_FileDesc2NativeHandle(listenfd));
@@ -904,9 +946,10 @@ handle_listeners(struct POLL_STRUCT *fds)
 
 #ifdef ENABLE_EPOLL
 void
-accept_thread(void *vports)
+accept_thread(void *varg)
 {
-    daemon_ports_t *ports = (daemon_ports_t *)vports;
+    accept_thread_info *ati = (accept_thread_info *)varg;
+    daemon_ports_t *ports = ati->ports;
     Connection_Table *ct = the_connection_table;
     PRIntn num_poll = 0;
     int epoll_fd = -1;
@@ -930,7 +973,7 @@ accept_thread(void *vports)
     }
     slapi_log_err(SLAPI_LOG_DEBUG, "epoll_accept_thread", "epoll_create1() created epoll fd %d\n",
                   epoll_fd);
-    num_poll = setup_pr_accept_pds(n_tcps, s_tcps, i_unix, epoll_fd);
+    num_poll = setup_pr_accept_pds(ati, n_tcps, s_tcps, i_unix, epoll_fd);
 
     events = (struct epoll_event *)slapi_ch_calloc(num_poll, sizeof(struct epoll_event));
 
@@ -954,7 +997,7 @@ accept_thread(void *vports)
             }
         }
 
-        select_return = epoll_wait(epoll_fd, events, listeners, slapd_wakeup_timer);
+        select_return = epoll_wait(epoll_fd, events, num_poll, slapd_wakeup_timer);
         switch (select_return) {
         case 0: /* Timeout */
             break;
@@ -964,7 +1007,7 @@ accept_thread(void *vports)
                           prerr, slapd_system_strerror(prerr));
             break;
         default: /* a new connection */
-            handle_listeners(events, select_return);
+            handle_listeners(ati, events, select_return);
             break;
         }
         last_accept_new_connections = accept_new_connections;
@@ -975,16 +1018,19 @@ accept_thread(void *vports)
     if (epoll_fd != -1) {
         close(epoll_fd);
     }
-    slapi_ch_free((void **)&listener_idxs);
-    slapd_sockets_ports_free(ports);
+    slapi_ch_free((void **)&ati->listener_idxs);
+    if (PR_AtomicDecrement(&accept_threads_running) == 0) {
+        slapd_sockets_ports_free(ports);
+    }
     g_decr_active_threadcnt();
-    slapi_log_err(SLAPI_LOG_INFO, "slapd_daemon", "slapd shutting down - accept_thread\n");
+    slapi_log_err(SLAPI_LOG_INFO, "slapd_daemon", "slapd shutting down - accept_thread %d\n", ati->shard);
 }
 #else /* !ENABLE_EPOLL */
 void
-accept_thread(void *vports)
+accept_thread(void *varg)
 {
-    daemon_ports_t *ports = (daemon_ports_t *)vports;
+    accept_thread_info *ati = (accept_thread_info *)varg;
+    daemon_ports_t *ports = ati->ports;
     Connection_Table *ct = the_connection_table;
     PRIntn num_poll = 0;
     struct POLL_STRUCT *fds = NULL;
@@ -1001,7 +1047,7 @@ accept_thread(void *vports)
     i_unix = ports->i_socket;
 #endif /* ENABLE_LDAPI */
 
-    num_poll = setup_pr_accept_pds(n_tcps, s_tcps, i_unix, &fds);
+    num_poll = setup_pr_accept_pds(ati, n_tcps, s_tcps, i_unix, &fds);
 
     while (!g_get_shutdown()) {
         /* Do we need to accept new connections, account for ct->size including list heads. */
@@ -1033,18 +1079,20 @@ accept_thread(void *vports)
                           prerr, slapd_system_strerror(prerr));
             break;
         default: /* a new connection */
-            handle_listeners(fds);
+            handle_listeners(ati, fds);
             break;
         }
         last_accept_new_connections = accept_new_connections;
     }
 
     /* free the listener indexes */
-    slapi_ch_free((void **)&listener_idxs);
-    slapd_sockets_ports_free(ports);
+    slapi_ch_free((void **)&ati->listener_idxs);
+    if (PR_AtomicDecrement(&accept_threads_running) == 0) {
+        slapd_sockets_ports_free(ports);
+    }
     slapi_ch_free((void **)&fds);
     g_decr_active_threadcnt();
-    slapi_log_err(SLAPI_LOG_INFO, "slapd_daemon", "slapd shutting down - accept_thread\n");
+    slapi_log_err(SLAPI_LOG_INFO, "slapd_daemon", "slapd shutting down - accept_thread %d\n", ati->shard);
 }
 #endif /* !ENABLE_EPOLL */
 
@@ -1105,6 +1153,7 @@ has_idletimeout_expired(Connection *c, time_t curtime)
 {
     return (c->c_state != CONN_STATE_FREE && !c->c_gettingber &&
             c->c_idletimeout > 0 && NULL == c->c_ops &&
+            result_writer_pending(c) == 0 &&
             curtime - c->c_idlesince >= c->c_idletimeout);
 }
 
@@ -1157,6 +1206,7 @@ slapd_daemon(daemon_ports_t *ports)
     PRFileDesc **i_unix = NULL;
     PRFileDesc **fdesp = NULL;
     uint64_t threads;
+    int nshards = ports->accept_shards < 1 ? 1 : ports->accept_shards;
     int in_referral_mode = config_check_referral_mode();
     int connection_table_size = get_connection_table_size();
     the_connection_table = connection_table_new(connection_table_size);
@@ -1205,6 +1255,7 @@ slapd_daemon(daemon_ports_t *ports)
     }
 
     init_ct_list_threads();
+    init_result_writer_threads();
     init_op_threads();
 
     /* Start the SNMP collator if counters are enabled. */
@@ -1262,38 +1313,36 @@ slapd_daemon(daemon_ports_t *ports)
 
     /* We are now ready to accept incoming connections */
     if (n_tcps != NULL) {
-        PRNetAddr **nap = ports->n_listenaddr;
-        for (fdesp = n_tcps; fdesp && *fdesp; fdesp++, nap++) {
+        for (fdesp = n_tcps; fdesp && *fdesp; fdesp++) {
             if (PR_Listen(*fdesp, config_get_listen_backlog_size()) == PR_FAILURE) {
                 PRErrorCode prerr = PR_GetError();
+                PRNetAddr *nap = ports->n_listenaddr[(fdesp - n_tcps) / nshards];
                 char addrbuf[256];
 
                 slapi_log_err(SLAPI_LOG_EMERG, "slapd_daemon",
                               "PR_Listen() on %s port %d failed: %s error %d (%s)\n",
-                              netaddr2string(*nap, addrbuf, sizeof(addrbuf)),
+                              netaddr2string(nap, addrbuf, sizeof(addrbuf)),
                               ports->n_port, SLAPI_COMPONENT_NAME_NSPR, prerr,
                               slapd_pr_strerror(prerr));
                 g_set_shutdown(SLAPI_SHUTDOWN_EXIT);
             }
-            listeners++;
         }
     }
 
     if (s_tcps != NULL) {
-        PRNetAddr **sap = ports->s_listenaddr;
-        for (fdesp = s_tcps; fdesp && *fdesp; fdesp++, sap++) {
+        for (fdesp = s_tcps; fdesp && *fdesp; fdesp++) {
             if (PR_Listen(*fdesp, config_get_listen_backlog_size()) == PR_FAILURE) {
                 PRErrorCode prerr = PR_GetError();
+                PRNetAddr *sap = ports->s_listenaddr[(fdesp - s_tcps) / nshards];
                 char addrbuf[256];
 
                 slapi_log_err(SLAPI_LOG_EMERG, "slapd_daemon",
                               "PR_Listen() on %s port %d failed: %s error %d (%s)\n",
-                              netaddr2string(*sap, addrbuf, sizeof(addrbuf)),
+                              netaddr2string(sap, addrbuf, sizeof(addrbuf)),
                               ports->s_port, SLAPI_COMPONENT_NAME_NSPR, prerr,
                               slapd_pr_strerror(prerr));
                 g_set_shutdown(SLAPI_SHUTDOWN_EXIT);
             }
-            listeners++;
         }
     }
 
@@ -1310,13 +1359,15 @@ slapd_daemon(daemon_ports_t *ports)
                               slapd_pr_strerror(prerr));
                 g_set_shutdown(SLAPI_SHUTDOWN_EXIT);
             }
-            listeners++;
         }
         initialize_ldapi_auth_dn_mappings(LDAPI_STARTUP);
     }
 #endif /* ENABLE_LDAPI */
 
-    listener_idxs = (listener_info *)slapi_ch_calloc(listeners, sizeof(*listener_idxs));
+    /* Only the LDAPI listener left, the other accept threads would have nothing to do */
+    if (n_tcps == NULL && s_tcps == NULL) {
+        nshards = 1;
+    }
 
     /* Now we write the pid file, indicating that the server is finally and listening for connections */
     write_pid_file();
@@ -1327,19 +1378,36 @@ slapd_daemon(daemon_ports_t *ports)
     /* The server is ready and listening for connections. Logging "slapd started" message. */
     unfurl_banners(the_connection_table, ports, n_tcps, s_tcps, i_unix);
 
-    /* Create a thread to accept new connections */
-    accept_thread_p = PR_CreateThread(PR_SYSTEM_THREAD,
-                                     (VFP)(void *)accept_thread, (void*)ports,
-                                     PR_PRIORITY_NORMAL, PR_GLOBAL_THREAD,
-                                     PR_JOINABLE_THREAD,
-                                     SLAPD_DEFAULT_THREAD_STACKSIZE);
-    if (NULL == accept_thread_p) {
-        PRErrorCode errorCode = PR_GetError();
-        slapi_log_err(SLAPI_LOG_EMERG, "slapd_daemon", "Unable to fd accept thread - Shutting Down (" SLAPI_COMPONENT_NAME_NSPR " error %d - %s)\n",
-                      errorCode, slapd_pr_strerror(errorCode));
-        g_set_shutdown(SLAPI_SHUTDOWN_EXIT);
-    } else{
-        g_incr_active_threadcnt();
+    /*
+     * Create the threads to accept new connections, each one with its own
+     * listener sockets and its own subset of the connection table lists.
+     */
+    accept_infos = (accept_thread_info *)slapi_ch_calloc(nshards, sizeof(accept_thread_info));
+    accept_threads_p = (PRThread **)slapi_ch_calloc(nshards, sizeof(PRThread *));
+    PR_AtomicSet(&accept_threads_running, nshards);
+    for (int shard = 0; shard < nshards; shard++) {
+        accept_infos[shard].ports = ports;
+        accept_infos[shard].shard = shard;
+        accept_infos[shard].nshards = nshards;
+        accept_threads_p[shard] = PR_CreateThread(PR_SYSTEM_THREAD,
+                                                  (VFP)(void *)accept_thread, (void *)&accept_infos[shard],
+                                                  PR_PRIORITY_NORMAL, PR_GLOBAL_THREAD,
+                                                  PR_JOINABLE_THREAD,
+                                                  SLAPD_DEFAULT_THREAD_STACKSIZE);
+        if (NULL == accept_threads_p[shard]) {
+            PRErrorCode errorCode = PR_GetError();
+            slapi_log_err(SLAPI_LOG_EMERG, "slapd_daemon", "Unable to fd accept thread - Shutting Down (" SLAPI_COMPONENT_NAME_NSPR " error %d - %s)\n",
+                          errorCode, slapd_pr_strerror(errorCode));
+            g_set_shutdown(SLAPI_SHUTDOWN_EXIT);
+            if (PR_AtomicDecrement(&accept_threads_running) == 0) {
+                slapd_sockets_ports_free(ports);
+            }
+        } else {
+            g_incr_active_threadcnt();
+        }
+    }
+    if (nshards > 1) {
+        slapi_log_err(SLAPI_LOG_INFO, "slapd_daemon", "Accepting connections with %d threads\n", nshards);
     }
 
 #ifdef WITH_SYSTEMD
@@ -1353,6 +1421,7 @@ slapd_daemon(daemon_ports_t *ports)
                         slapi_current_rel_time_t(),
                         MILLISECONDS_PER_SECOND);
 #endif /* !ENABLE_EPOLL */
+    slab_trim_start();
     /* The meat of the operation is in a loop on a call to select */
     while (!g_get_shutdown()) {
 
@@ -1509,7 +1578,13 @@ slapd_daemon(daemon_ports_t *ports)
     }
 
     /* final cleanup for ASAN and other analyzers */
-    PR_JoinThread(accept_thread_p);
+    for (int shard = 0; shard < nshards; shard++) {
+        if (accept_threads_p[shard]) {
+            PR_JoinThread(accept_threads_p[shard]);
+        }
+    }
+    slapi_ch_free((void **)&accept_threads_p);
+    slapi_ch_free((void **)&accept_infos);
     free_worker_thread_indexes();
     free_server_dataversion();
 }
@@ -1618,29 +1693,38 @@ clear_signal(struct POLL_STRUCT *fds, int list_num)
 
 static PRIntn
 #ifdef ENABLE_EPOLL
-setup_pr_accept_pds(PRFileDesc **n_tcps, PRFileDesc **s_tcps, PRFileDesc **i_unix,
+setup_pr_accept_pds(accept_thread_info *ati, PRFileDesc **n_tcps, PRFileDesc **s_tcps, PRFileDesc **i_unix,
     int epoll_fd)
 #else /* !ENABLE_EPOLL */
-setup_pr_accept_pds(PRFileDesc **n_tcps, PRFileDesc **s_tcps, PRFileDesc **i_unix,
+setup_pr_accept_pds(accept_thread_info *ati, PRFileDesc **n_tcps, PRFileDesc **s_tcps, PRFileDesc **i_unix,
     struct POLL_STRUCT **fds)
 #endif /* ENABLE_EPOLL */
 {
     LBER_SOCKET socketdesc = SLAPD_INVALID_SOCKET;
     PRIntn count = 0;
     size_t n_listeners = 0;
+    listener_info *listener_idxs = NULL;
 #ifdef ENABLE_EPOLL
     struct epoll_event event;
 #endif /* ENABLE_EPOLL */
     struct POLL_STRUCT *myfds = NULL;
 
+    /*
+     * The TCP sockets of this accept thread are the ones of its shard,
+     * and only the first accept thread listens for LDAPI.
+     */
+    if (ati->shard != 0) {
+        i_unix = NULL;
+    }
+
     /* How many fds do we have? */
     if (n_tcps != NULL) {
         PRFileDesc **fdesc = NULL;
-        for (fdesc = n_tcps; fdesc && *fdesc; fdesc++, count++) { }
+        for (fdesc = n_tcps + ati->shard; *fdesc; fdesc += ati->nshards, count++) { }
     }
     if (s_tcps != NULL) {
         PRFileDesc **fdesc = NULL;
-        for (fdesc = s_tcps; fdesc && *fdesc; fdesc++, count++) { }
+        for (fdesc = s_tcps + ati->shard; *fdesc; fdesc += ati->nshards, count++) { }
     }
 #if defined(ENABLE_LDAPI)
     if (i_unix != NULL) {
@@ -1649,6 +1733,10 @@ setup_pr_accept_pds(PRFileDesc **n_tcps, PRFileDesc **s_tcps, PRFileDesc **i_uni
     }
 #endif
 
+    listener_idxs = (listener_info *)slapi_ch_calloc(count + 1, sizeof(listener_info));
+    ati->listener_idxs = listener_idxs;
+    ati->listeners = count;
+
 #ifndef ENABLE_EPOLL
     /* Setup the return ptr and alloc the struct */
     myfds = (struct POLL_STRUCT *)slapi_ch_calloc(1, (count + 1) * sizeof(struct POLL_STRUCT));
@@ -1660,7 +1748,7 @@ setup_pr_accept_pds(PRFileDesc **n_tcps, PRFileDesc **s_tcps, PRFileDesc **i_uni
 
     if (n_tcps != NULL) {
         PRFileDesc **fdesc = NULL;
-        for (fdesc = n_tcps; fdesc && *fdesc; fdesc++, count++) {
+        for (fdesc = n_tcps + ati->shard; *fdesc; fdesc += ati->nshards, count++) {
 #ifndef ENABLE_EPOLL
             myfds[count].fd = *fdesc;
             myfds[count].in_flags = SLAPD_POLL_FLAGS;
@@ -1685,9 +1773,11 @@ setup_pr_accept_pds(PRFileDesc **n_tcps, PRFileDesc **s_tcps, PRFileDesc **i_uni
          * To enable get_ssl_listener_fd to work, we need to stash the first
          * TLS listener that we have.
          */
-        tls_listener = *s_tcps;
+        if (ati->shard == 0) {
+            tls_listener = *s_tcps;
+        }
 
-        for (fdesc = s_tcps; fdesc && *fdesc; fdesc++, count++) {
+        for (fdesc = s_tcps + ati->shard; *fdesc; fdesc += ati->nshards, count++) {
 #ifndef ENABLE_EPOLL
             myfds[count].fd = *fdesc;
             myfds[count].in_flags = SLAPD_POLL_FLAGS;
@@ -1730,10 +1820,8 @@ setup_pr_accept_pds(PRFileDesc **n_tcps, PRFileDesc **s_tcps, PRFileDesc **i_uni
         }
     }
 #endif
-    if (n_listeners < listeners) {
-        listener_idxs[n_listeners].idx = 0;
-        listener_idxs[n_listeners].listenfd = NULL;
-    }
+    listener_idxs[n_listeners].idx = 0;
+    listener_idxs[n_listeners].listenfd = NULL;
 
     return count;
 }
@@ -1810,9 +1898,11 @@ setup_pr_read_pds(Connection_Table *ct, int listnum)
                  * this connection should be closed by calling
                  * disconnect_server(). Move this connection out of the active
                  * list then the last thread to use the connection will close
-                 * it.
+                 * it. The results queued before the close are sent first.
                  */
-                connection_table_move_connection_out_of_active_list(ct, c);
+                if (!result_writer_close_pending(c)) {
+                    connection_table_move_connection_out_of_active_list(ct, c);
+                }
             } else if (c->c_sd == SLAPD_INVALID_SOCKET) {
                 connection_table_move_connection_out_of_active_list(ct, c);
             } else if (c->c_prfd != NULL) {
@@ -2148,6 +2238,9 @@ openldap_write_function(Sockbuf_IO_Desc *sbiod, void *buf, ber_len_t len)
 
     PR_ASSERT(fd != SLAPD_INVALID_SOCKET);
 
+    if (result_writer_enabled()) {
+        return result_writer_write(conn, buf, len);
+    }
     return write_function(0, buf, len, fd);
 }
 
@@ -2197,11 +2290,12 @@ handle_closed_connection(Connection *conn)
     ber_sockbuf_remove_io(conn->c_sb, &openldap_sockbuf_io, LBER_SBIOD_LEVEL_PROVIDER);
 }
 
-/* NOTE: this routine is not reentrant
+/* NOTE: this routine is called concurrently by the accept threads, shard being
+ * the number of the calling one (of nshards)
  * this function returns the connection table list the new connection is in
  */
 static int
-handle_new_connection(Connection_Table *ct, int tcps, PRFileDesc *listenfd, int secure, int local, Connection **newconn)
+handle_new_connection(Connection_Table *ct, int tcps, PRFileDesc *listenfd, int secure, int local, int shard, int nshards, Connection **newconn)
 {
     int ns = 0;
     Connection *conn = NULL;
@@ -2228,6 +2322,12 @@ handle_new_connection(Connection_Table *ct, int tcps, PRFileDesc *listenfd, int
         return -1;
     }
 
+    /*
+     * Choose the ct list now, among the ones of this accept thread: the
+     * connection is registered with the epoll of that list right below.
+     */
+    conn->c_ct_list = connection_table_get_accept_list(ct, shard, nshards);
+
 #ifdef ENABLE_EPOLL
     /* Set up the epoll event for this connection */
     conn->c_event->events = EPOLL_EVENTS;
@@ -2589,8 +2689,14 @@ slapd_wait4child(int sig __attribute__((unused)))
     (void)SIGNAL(SIGCHLD, slapd_wait4child);
 }
 
+/*
+ * With several accept shards, each address gets one socket per shard, all
+ * bound with SO_REUSEPORT, and the socket of shard s for the address a is at
+ * index a * shards + s.  The array ends with one NULL per shard so that each
+ * accept thread can step through its own sockets.
+ */
 static PRFileDesc **
-createprlistensockets(PRUint16 port, PRNetAddr **listenaddr, int secure __attribute__((unused)), int local)
+createprlistensockets(PRUint16 port, PRNetAddr **listenaddr, int secure __attribute__((unused)), int local, int shards)
 {
     PRFileDesc **sock;
     PRNetAddr sa_server;
@@ -2607,6 +2713,10 @@ createprlistensockets(PRUint16 port, PRNetAddr **listenaddr, int secure __attrib
     if (!port)
         goto suppressed;
 
+    if (shards < 1 || local) {
+        shards = 1;
+    }
+
     PR_ASSERT(listenaddr != NULL);
 
     /* need to know the count */
@@ -2620,10 +2730,11 @@ createprlistensockets(PRUint16 port, PRNetAddr **listenaddr, int secure __attrib
                       "There is no address to listen\n");
         goto failed;
     }
-    sock = (PRFileDesc **)slapi_ch_calloc(sockcnt + 1, sizeof(PRFileDesc *));
+    sock = (PRFileDesc **)slapi_ch_calloc((sockcnt + 1) * shards, sizeof(PRFileDesc *));
     pr_socketoption.option = PR_SockOpt_Reuseaddr;
     pr_socketoption.value.reuse_addr = 1;
-    for (i = 0, lap = listenaddr; lap && *lap && i < sockcnt; i++, lap++) {
+    for (i = 0; i < sockcnt * shards; i++) {
+        lap = listenaddr + i / shards;
         /* create TCP socket */
         socktype = PR_NetAddrFamily(*lap);
 #if defined(ENABLE_LDAPI)
@@ -2653,6 +2764,19 @@ createprlistensockets(PRUint16 port, PRNetAddr **listenaddr, int secure __attrib
             goto failed;
         }
 
+#if defined(SO_REUSEPORT)
+        if (shards > 1) {
+            int reuse_port = 1;
+            if (setsockopt(PR_FileDesc2NativeHandle(sock[i]), SOL_SOCKET, SO_REUSEPORT,
+                           (void *)&reuse_port, sizeof(reuse_port)) == -1) {
+                slapi_log_err(SLAPI_LOG_ERR, logname,
+                              "setsockopt(SO_REUSEPORT) failed: error %d (%s)\n",
+                              errno, slapd_system_strerror(errno));
+                goto failed;
+            }
+        }
+#endif /* SO_REUSEPORT */
+
         /* set up listener address, including port */
         memcpy(&sa_server, *lap, sizeof(sa_server));
 
@@ -2698,6 +2698,19 @@ sdn_dump(const Slapi_DN *sdn, const char *text)
 }
 #endif
 
+/* memory used by a string of a Slapi_DN, only the owned ones are malloc'ed */
+static size_t
+sdn_string_size(const Slapi_DN *sdn, const char *s, int flag)
+{
+    if (s == NULL) {
+        return 0;
+    }
+    if (slapi_isbitset_uchar(sdn->flag, flag)) {
+        return slapi_ch_usable_size(s);
+    }
+    return strlen(s) + 1;
+}
+
 size_t
 slapi_sdn_get_size(const Slapi_DN *sdn)
 {
@@ -2709,13 +2722,12 @@ slapi_sdn_get_size(const Slapi_DN *sdn)
     if (NULL == sdn) {
         return sz;
     }
-    sz += slapi_sdn_get_ndn_len(sdn) + 1 /* '\0' */;
-    if (sdn->dn && sdn->ndn) {
-        sz *= 2;
-    }
-    if (sdn->udn) {
-        sz += strlen(sdn->udn) + 1;
+    (void)slapi_sdn_get_ndn_len(sdn);
+    sz += sdn_string_size(sdn, sdn->dn, FLAG_DN);
+    if (sdn->ndn != sdn->dn) {
+        sz += sdn_string_size(sdn, sdn->ndn, FLAG_NDN);
     }
+    sz += sdn_string_size(sdn, sdn->udn, FLAG_UDN);
     sz += sizeof(Slapi_DN);
     return sz;
 }
@@ -39,6 +39,7 @@ static int _entry_set_tombstone_rdn(Slapi_Entry *e, const char *normdn);
 #define VATTR_WRITE_UNLOCK(e) slapi_rwlock_unlock(e->e_virtual_lock)
 static size_t entry_vattr_size(Slapi_Entry *e);
 static struct _entry_vattr *entry_vattr_lookup_nolock(const Slapi_Entry *e, const char *attr_name);
+static int entry_vattr_isvalid(const Slapi_Entry *e, struct _entry_vattr *vattr);
 static void entry_vattr_add_nolock(Slapi_Entry *e, const char *type, Slapi_Attr *attr);
 static void entry_vattr_free_nolock(Slapi_Entry *e);
 
@@ -86,11 +87,18 @@ struct attrs_in_extension attrs_in_extension[] =
  */
 struct _entry_vattr
 {
-    char *attrname;   /* if NULL, the attribute name is the one in attr->a_type */
-    Slapi_Attr *attr; /* attribute computed by a SP */
+    char *attrname;     /* if NULL, the attribute name is the one in attr->a_type */
+    Slapi_Attr *attr;   /* attribute computed by a SP */
+    size_t size;        /* memory used by this cached attribute */
+    uint32_t watermark; /* global watermark when it was computed */
     struct _entry_vattr *next;
 };
 
+/* memory used by the virtual attributes cached in all the entries */
+static uint64_t vattrcache_size = 0;
+static uint64_t vattrcache_tries = 0;
+static uint64_t vattrcache_hits = 0;
+
 /*
  * An attribute name is of the form 'basename[;option]'.
  * The state informaion is encoded in options. For example:
@@ -1851,7 +1859,7 @@ PR_DEFINE_COUNTER(slapi_entry_counter_exist);
 Slapi_Entry *
 slapi_entry_alloc()
 {
-    Slapi_Entry *e = (Slapi_Entry *)slapi_ch_calloc(1, sizeof(struct slapi_entry));
+    Slapi_Entry *e = (Slapi_Entry *)slab_alloc(SLAB_CLASS_ENTRY);
     slapi_sdn_init(&e->e_sdn);
     slapi_rdn_init(&e->e_srdn);
 
@@ -1913,6 +1921,7 @@ slapi_entry_free(Slapi_Entry *e) /* JCM - Should be ** so that we can NULL the p
         csnset_free(&e->e_dncsnset);
         csn_free(&e->e_maxcsn);
         slapi_ch_free((void **)&e->e_uniqueid);
+        attrlist_index_free(&e->e_attrs_index);
         attrlist_free(e->e_attrs);
         attrlist_free(e->e_deleted_attrs);
         VATTR_WRITE_LOCK(e);
@@ -1920,12 +1929,30 @@ slapi_entry_free(Slapi_Entry *e) /* JCM - Should be ** so that we can NULL the p
         VATTR_WRITE_UNLOCK(e);
         if (e->e_virtual_lock)
             slapi_destroy_rwlock(e->e_virtual_lock);
-        slapi_ch_free((void **)&e);
+        slab_free(SLAB_CLASS_ENTRY, e);
         PR_INCREMENT_COUNTER(slapi_entry_counter_deleted);
         PR_DECREMENT_COUNTER(slapi_entry_counter_exist);
     }
 }
 
+/* memory used by one attribute, allocator overhead included */
+static size_t
+slapi_attr_size(Slapi_Attr *a)
+{
+    size_t size = slab_class_size(SLAB_CLASS_ATTR);
+
+    size += slapi_ch_usable_size(a->a_type);
+    size += valueset_size(&a->a_present_values);
+    size += valueset_size(&a->a_deleted_values);
+    /* Don't bother with a_listtofree. This is only set
+     * by a call to slapi_attr_get_values, which should
+     * never be used on a cache entry since it can cause
+     * the entry to grow without bound.
+     */
+    size += slapi_ch_usable_size(a->a_deletioncsn);
+    return size;
+}
+
 static size_t
 slapi_attrlist_size(Slapi_Attr *attrs)
 {
@@ -1933,46 +1960,43 @@ slapi_attrlist_size(Slapi_Attr *attrs)
     Slapi_Attr *a;
 
     for (a = attrs; a; a = a->a_next) {
-        if (a->a_type)
-            size += strlen(a->a_type) + 1;
-        size += valueset_size(&a->a_present_values);
-        size += valueset_size(&a->a_deleted_values);
-        /* Don't bother with a_listtofree. This is only set
-         * by a call to slapi_attr_get_values, which should
-         * never be used on a cache entry since it can cause
-         * the entry to grow without bound.
-         */
-        if (a->a_deletioncsn)
-            size += sizeof(CSN);
-        size += sizeof(Slapi_Attr);
+        size += slapi_attr_size(a);
     }
 
     return size;
 }
 
-/* return the approximate size of an entry --
- * useful for checking cache sizes, etc
- */
-size_t
-slapi_entry_size(Slapi_Entry *e)
+/* memory used by the attributes of a type in the lists of an entry */
+static size_t
+entry_type_size(const Slapi_Entry *e, const char *type)
+{
+    Slapi_Attr *lists[] = {e->e_attrs, e->e_deleted_attrs, e->e_aux_attrs};
+    size_t size = 0;
+
+    for (size_t i = 0; i < sizeof(lists) / sizeof(lists[0]); i++) {
+        for (Slapi_Attr *a = lists[i]; a; a = a->a_next) {
+            if (slapi_attr_type_cmp(a->a_type, type, SLAPI_TYPE_CMP_BASE) == 0) {
+                size += slapi_attr_size(a);
+            }
+        }
+    }
+    return size;
+}
+
+/* memory used by an entry, except its real and virtual attributes */
+static size_t
+entry_base_size(Slapi_Entry *e)
 {
     size_t size = 0;
 
-    if (e->e_uniqueid)
-        size += strlen(e->e_uniqueid) + 1;
-    if (e->e_dncsnset)
-        size += csnset_size(e->e_dncsnset);
-    if (e->e_maxcsn)
-        size += sizeof(CSN);
+    size += slapi_ch_usable_size(e->e_uniqueid);
+    size += csnset_size(e->e_dncsnset);
+    size += slapi_ch_usable_size(e->e_maxcsn);
     if (e->e_virtual_lock)
         size += slapi_rwlock_get_size();
     /* Slapi_DN and RDN are included in Slapi_Entry */
     size += (slapi_sdn_get_size(&e->e_sdn) - sizeof(Slapi_DN));
     size += (slapi_rdn_get_size(&e->e_srdn) - sizeof(Slapi_RDN));
-    size += slapi_attrlist_size(e->e_attrs);
-    size += slapi_attrlist_size(e->e_deleted_attrs);
-    size += slapi_attrlist_size(e->e_aux_attrs);
-    size += entry_vattr_size(e);
     if (e->e_extension) {
         struct attrs_in_extension *aiep;
         int cnt;
@@ -1986,11 +2010,77 @@ slapi_entry_size(Slapi_Entry *e)
         }
         size += cnt * sizeof(void *);
     }
-    size += sizeof(Slapi_Entry);
+    size += slab_class_size(SLAB_CLASS_ENTRY);
+
+    return size;
+}
+
+/* return the size of an entry --
+ * the memory it really uses, to check the cache sizes, etc
+ */
+size_t
+slapi_entry_size(Slapi_Entry *e)
+{
+    size_t size = entry_base_size(e);
 
+    size += entry_vattr_size(e);
+    size += slapi_attrlist_size(e->e_attrs);
+    size += slapi_attrlist_size(e->e_deleted_attrs);
+    size += slapi_attrlist_size(e->e_aux_attrs);
     return size;
 }
 
+/* add type to the list of the types to measure unless it is already there */
+static void
+entry_size_add_type(char ***types, const char *type)
+{
+    for (size_t i = 0; *types && (*types)[i]; i++) {
+        if (slapi_attr_type_cmp((*types)[i], type, SLAPI_TYPE_CMP_BASE) == 0) {
+            return;
+        }
+    }
+    charray_add(types, (char *)type);
+}
+
+/*
+ * Size of newe, a modified copy of olde whose size was oldsize, when only
+ * the attributes of the given types were changed: the other attributes
+ * are not walked again, but for the ones with deleted values that the
+ * replication may have purged from newe. The virtual attributes are left
+ * out: they are cached after the size of olde was set, newe does not get
+ * them, and they are reported apart in currentVattrCacheSize.
+ */
+size_t
+entry_size_update(Slapi_Entry *olde, size_t oldsize, Slapi_Entry *newe, char **types)
+{
+    Slapi_Attr *lists[] = {olde->e_attrs, olde->e_deleted_attrs};
+    size_t added = entry_base_size(newe);
+    size_t removed = entry_base_size(olde);
+    char **measured = NULL;
+
+    for (size_t i = 0; types && types[i]; i++) {
+        entry_size_add_type(&measured, types[i]);
+    }
+    for (size_t i = 0; i < sizeof(lists) / sizeof(lists[0]); i++) {
+        for (Slapi_Attr *a = lists[i]; a; a = a->a_next) {
+            if (!valueset_isempty(&a->a_deleted_values)) {
+                entry_size_add_type(&measured, a->a_type);
+            }
+        }
+    }
+    for (size_t i = 0; measured && measured[i]; i++) {
+        added += entry_type_size(newe, measured[i]);
+        removed += entry_type_size(olde, measured[i]);
+    }
+    /* the types belong to the caller and to olde */
+    slapi_ch_free((void **)&measured);
+    if (removed > oldsize + added) {
+        /* oldsize was computed differently, start again */
+        return slapi_entry_size(newe);
+    }
+    return oldsize + added - removed;
+}
+
 
 /*
  * return a complete copy of entry pointed to by "e"
@@ -2237,7 +2327,8 @@ slapi_entry_attr_find(const Slapi_Entry *e, const char *type, Slapi_Attr **a)
     if (e == NULL) {
         return r;
     }
-    *a = attrlist_find(e->e_attrs, type);
+    /* the index is built by the readers, the entry may be shared */
+    *a = attrlist_index_find(&((Slapi_Entry *)e)->e_attrs_index, e->e_attrs, type);
     if (*a != NULL) {
         if (valueset_isempty(&((*a)->a_present_values))) {
             /*
@@ -2257,6 +2348,124 @@ slapi_entry_attr_find(const Slapi_Entry *e, const char *type, Slapi_Attr **a)
 
 static int32_t g_virtual_watermark = 0; /* good enough to init */
 
+/*
+ * Each invalidation of the cached virtual attributes advances the global
+ * watermark, and may be limited to one type and to a list of subtrees. A virtual
+ * attribute cached at an older watermark is still valid if none of the
+ * invalidations since then covers its type and its entry, so a change of a
+ * CoS definition does not discard the virtual attributes of the whole
+ * directory. The last VATTRCACHE_INVAL_MAX invalidations are kept, the
+ * attributes cached before them are invalid.
+ */
+#define VATTRCACHE_INVAL_MAX 64
+
+typedef struct vattrcache_inval
+{
+    uint32_t vi_watermark;
+    char *vi_type;        /* NULL for all the types */
+    Slapi_DN **vi_scopes; /* NULL terminated, NULL for all the entries */
+} vattrcache_inval;
+
+static vattrcache_inval g_vattrcache_inval[VATTRCACHE_INVAL_MAX];
+/* protects g_vattrcache_inval, g_virtual_watermark is advanced under it */
+static pthread_rwlock_t g_vattrcache_inval_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+static void
+vattrcache_inval_free_scopes(vattrcache_inval *inval)
+{
+    for (size_t i = 0; inval->vi_scopes && inval->vi_scopes[i]; i++) {
+        slapi_sdn_free(&inval->vi_scopes[i]);
+    }
+    slapi_ch_free((void **)&inval->vi_scopes);
+}
+
+static void
+vattrcache_invalidate(const char *type, const Slapi_DN **scopes)
+{
+    vattrcache_inval *inval;
+    uint32_t watermark;
+    size_t count = 0;
+
+    pthread_rwlock_wrlock(&g_vattrcache_inval_lock);
+    /* Make sure the value is never 0 */
+    watermark = (uint32_t)slapi_atomic_load_32(&g_virtual_watermark, __ATOMIC_ACQUIRE) + 1;
+    if (watermark == 0) {
+        watermark = 1;
+    }
+    inval = &g_vattrcache_inval[watermark % VATTRCACHE_INVAL_MAX];
+    slapi_ch_free_string(&inval->vi_type);
+    vattrcache_inval_free_scopes(inval);
+    inval->vi_watermark = watermark;
+    inval->vi_type = slapi_ch_strdup(type);
+    if (scopes) {
+        while (scopes[count]) {
+            count++;
+        }
+        inval->vi_scopes = (Slapi_DN **)slapi_ch_calloc(count + 1, sizeof(Slapi_DN *));
+        for (size_t i = 0; i < count; i++) {
+            inval->vi_scopes[i] = slapi_sdn_dup(scopes[i]);
+        }
+    }
+    slapi_atomic_store_32(&g_virtual_watermark, (int32_t)watermark, __ATOMIC_RELEASE);
+    pthread_rwlock_unlock(&g_vattrcache_inval_lock);
+}
+
+/*
+ * A cached virtual attribute is valid if the entry was not invalidated and
+ * if no invalidation since it was computed covers it.  Once checked against
+ * the invalidations, the attribute is stamped with the current watermark so
+ * that the next lookups take the fast path instead of the ring lock.  The
+ * callers may only hold the entry read lock, hence the atomic accesses.
+ */
+static int
+entry_vattr_isvalid(const Slapi_Entry *e, struct _entry_vattr *vattr)
+{
+    const char *type = vattr->attrname ? vattr->attrname : vattr->attr->a_type;
+    uint32_t vattr_watermark;
+    uint32_t current;
+    int valid = 1;
+
+    vattr_watermark = (uint32_t)slapi_atomic_load_32((int32_t *)&vattr->watermark, __ATOMIC_ACQUIRE);
+    if (e->e_virtual_watermark == 0 || vattr_watermark == 0) {
+        return 0;
+    }
+    current = (uint32_t)slapi_atomic_load_32(&g_virtual_watermark, __ATOMIC_ACQUIRE);
+    if (vattr_watermark == current) {
+        return 1;
+    }
+
+    pthread_rwlock_rdlock(&g_vattrcache_inval_lock);
+    current = (uint32_t)slapi_atomic_load_32(&g_virtual_watermark, __ATOMIC_ACQUIRE);
+    if (current - vattr_watermark >= VATTRCACHE_INVAL_MAX) {
+        valid = 0;
+    }
+    for (uint32_t watermark = vattr_watermark + 1; valid && watermark != current + 1; watermark++) {
+        vattrcache_inval *inval = &g_vattrcache_inval[watermark % VATTRCACHE_INVAL_MAX];
+
+        if (watermark == 0 || inval->vi_watermark != watermark) {
+            continue;
+        }
+        if (inval->vi_type && slapi_attr_type_cmp(inval->vi_type, type, SLAPI_TYPE_CMP_BASE)) {
+            continue;
+        }
+        if (inval->vi_scopes == NULL) {
+            valid = 0;
+        }
+        for (size_t i = 0; valid && inval->vi_scopes && inval->vi_scopes[i]; i++) {
+            if (slapi_sdn_issuffix(slapi_entry_get_sdn_const(e), inval->vi_scopes[i])) {
+                valid = 0;
+            }
+        }
+    }
+    pthread_rwlock_unlock(&g_vattrcache_inval_lock);
+
+    if (valid) {
+        /* None of the invalidations up to current covers it */
+        slapi_atomic_store_32((int32_t *)&vattr->watermark, (int32_t)current, __ATOMIC_RELEASE);
+    }
+    return valid;
+}
+
 int
 slapi_entry_vattrcache_watermark_isvalid(const Slapi_Entry *e)
 {
@@ -2279,10 +2488,21 @@ slapi_entry_vattrcache_watermark_invalidate(Slapi_Entry *e)
 void
 slapi_entrycache_vattrcache_watermark_invalidate()
 {
-    /* Make sure the value is never 0 */
-    if (slapi_atomic_incr_32(&g_virtual_watermark, __ATOMIC_RELEASE) == 0) {
-        slapi_atomic_incr_32(&g_virtual_watermark, __ATOMIC_RELEASE);
-    }
+    vattrcache_invalidate(NULL, NULL);
+}
+
+void
+slapi_entrycache_vattrcache_invalidate_scope(const char *type, const Slapi_DN *scope)
+{
+    const Slapi_DN *scopes[2] = {scope, NULL};
+
+    vattrcache_invalidate(type, scope ? scopes : NULL);
+}
+
+void
+slapi_entrycache_vattrcache_invalidate_scopes(const char *type, const Slapi_DN **scopes)
+{
+    vattrcache_invalidate(type, scopes);
 }
 
 /* The following functions control the virtual attribute cache
@@ -2302,11 +2522,7 @@ entry_vattr_size(Slapi_Entry *e)
     VATTR_READ_LOCK(e);
 
     for (vattr = e->e_virtual_attrs; vattr != NULL; vattr = vattr->next) {
-        if (vattr->attrname != NULL) {
-            size += strlen(vattr->attrname);
-        }
-        size += slapi_attrlist_size(vattr->attr);
-        size += sizeof(Slapi_Vattr);
+        size += vattr->size;
     }
 
     VATTR_READ_UNLOCK(e);
@@ -2362,12 +2578,63 @@ entry_vattr_add_nolock(Slapi_Entry *e, const char *type, Slapi_Attr *attr)
     } else {
         vattr->attrname = NULL;
     }
+    vattr->size = slapi_ch_usable_size(vattr) + slapi_ch_usable_size(vattr->attrname) +
+                  slapi_attrlist_size(vattr->attr);
+    vattr->watermark = (uint32_t)slapi_atomic_load_32(&g_virtual_watermark, __ATOMIC_ACQUIRE);
+    __atomic_add_fetch(&vattrcache_size, vattr->size, __ATOMIC_RELAXED);
 
     vattr->next = e->e_virtual_attrs;
     e->e_virtual_attrs = vattr;
 }
 
 
+/* memory used by the virtual attributes cached in the entries, for the monitor */
+uint64_t
+slapi_entry_vattrcache_size(void)
+{
+    return __atomic_load_n(&vattrcache_size, __ATOMIC_RELAXED);
+}
+
+/* lookups of the cached virtual attributes, and the ones that found a valid value */
+void
+slapi_entry_vattrcache_get_stats(uint64_t *hits, uint64_t *tries)
+{
+    *hits = __atomic_load_n(&vattrcache_hits, __ATOMIC_RELAXED);
+    *tries = __atomic_load_n(&vattrcache_tries, __ATOMIC_RELAXED);
+}
+
+/* Look up a valid cached attribute, the caller must hold e_virtual_lock */
+static Slapi_Vattr *
+entry_vattr_lookup_valid_nolock(const Slapi_Entry *e, const char *type)
+{
+    Slapi_Vattr *vattr = entry_vattr_lookup_nolock(e, type);
+
+    __atomic_add_fetch(&vattrcache_tries, 1, __ATOMIC_RELAXED);
+    if (vattr == NULL || !entry_vattr_isvalid(e, vattr)) {
+        return NULL;
+    }
+    __atomic_add_fetch(&vattrcache_hits, 1, __ATOMIC_RELAXED);
+    return vattr;
+}
+
+/* Remove a stale attribute, the caller must hold e_virtual_lock in write mode */
+static void
+entry_vattr_remove_nolock(Slapi_Entry *e, Slapi_Vattr *stale)
+{
+    Slapi_Vattr **prev;
+
+    for (prev = &e->e_virtual_attrs; *prev != NULL; prev = &(*prev)->next) {
+        if (*prev == stale) {
+            *prev = stale->next;
+            __atomic_sub_fetch(&vattrcache_size, stale->size, __ATOMIC_RELAXED);
+            attrlist_free(stale->attr);
+            slapi_ch_free((void **)&stale->attrname);
+            slapi_ch_free((void **)&stale);
+            return;
+        }
+    }
+}
+
 /* The caller must hold e_virtual_lock in write mode */
 static void
 entry_vattr_free_nolock(Slapi_Entry *e)
@@ -2376,6 +2643,7 @@ entry_vattr_free_nolock(Slapi_Entry *e)
 
     for (vattr = e->e_virtual_attrs, next = NULL; vattr != NULL; vattr = next) {
         next = vattr->next;
+        __atomic_sub_fetch(&vattrcache_size, vattr->size, __ATOMIC_RELAXED);
         attrlist_free(vattr->attr);
         slapi_ch_free((void **)&vattr->attrname);
         slapi_ch_free((void **)&vattr);
@@ -2409,17 +2677,18 @@ slapi_entry_vattrcache_findAndTest(const Slapi_Entry *e, const char *type, Slapi
     int r = SLAPI_ENTRY_VATTR_NOT_RESOLVED; /* assume not resolved yet */
     *rc = -1;
 
-    if (!slapi_entry_vattrcache_watermark_isvalid(e)) {
+    if (e->e_virtual_watermark == 0) {
         /* there is not virtual attribute cached or they are all invalid
                  * just return
                  */
+        __atomic_add_fetch(&vattrcache_tries, 1, __ATOMIC_RELAXED);
         return r;
     }
 
     /* Check if the attribute is already cached */
     VATTR_READ_LOCK(e);
 
-    if ((vattr = entry_vattr_lookup_nolock(e, type))) {
+    if ((vattr = entry_vattr_lookup_valid_nolock(e, type))) {
         /* That means this 'type' vattr was already evaluated */
 
         if ((vattr->attr == NULL) || valueset_isempty(&(vattr->attr->a_present_values))) {
@@ -2475,16 +2744,17 @@ slapi_entry_vattrcache_find_values_and_type_ex(const Slapi_Entry *e,
 
     int r = SLAPI_ENTRY_VATTR_NOT_RESOLVED; /* assume not resolved yet */
 
-    if (!slapi_entry_vattrcache_watermark_isvalid(e)) {
+    if (e->e_virtual_watermark == 0) {
         /* there is not virtual attribute cached or they are all invalid
                  * just return
                  */
+        __atomic_add_fetch(&vattrcache_tries, 1, __ATOMIC_RELAXED);
         return r;
     }
 
     /* check if the attribute is not already cached */
     VATTR_READ_LOCK(e);
-    if ((vattr = entry_vattr_lookup_nolock(e, type))) {
+    if ((vattr = entry_vattr_lookup_valid_nolock(e, type))) {
         /* That means this 'type' vattr was already evaluated */
 
         if ((vattr->attr == NULL) || valueset_isempty(&(vattr->attr->a_present_values))) {
@@ -2527,16 +2797,17 @@ slapi_entry_vattrcache_find_values_and_type(const Slapi_Entry *e,
 
     int r = SLAPI_ENTRY_VATTR_NOT_RESOLVED; /* assume not resolved yet */
 
-    if (!slapi_entry_vattrcache_watermark_isvalid(e)) {
+    if (e->e_virtual_watermark == 0) {
         /* there is not virtual attribute cached or they are all invalid
                  * just return
                  */
+        __atomic_add_fetch(&vattrcache_tries, 1, __ATOMIC_RELAXED);
         return r;
     }
 
     /* Check if the attribute is already cached */
     VATTR_READ_LOCK(e);
-    if ((vattr = entry_vattr_lookup_nolock(e, type))) {
+    if ((vattr = entry_vattr_lookup_valid_nolock(e, type))) {
         /* That means this 'type' vattr was already evaluated */
 
         if ((vattr->attr == NULL) || valueset_isempty(&(vattr->attr->a_present_values))) {
@@ -2598,7 +2869,7 @@ slapi_entry_vattrcache_merge_sv(Slapi_Entry *e, const char *type, Slapi_ValueSet
 
         VATTR_WRITE_LOCK(e);
 
-        if (!slapi_entry_vattrcache_watermark_isvalid(e)) {
+        if (e->e_virtual_watermark == 0) {
             /* free the previous set of vattrs */
             entry_vattr_free_nolock(e);
         }
@@ -2608,6 +2879,11 @@ slapi_entry_vattrcache_merge_sv(Slapi_Entry *e, const char *type, Slapi_ValueSet
 
         /* Add the vals in the virtual attribute cache  */
         vattr = entry_vattr_lookup_nolock(e, type);
+        if (vattr && !entry_vattr_isvalid(e, vattr)) {
+            /* only this one is recomputed */
+            entry_vattr_remove_nolock(e, vattr);
+            vattr = NULL;
+        }
         if (vattr) {
             if (vattr->attr) {
                 /* virtual attribute already cached, add the value */
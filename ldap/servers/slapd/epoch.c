@@ -0,0 +1,188 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * epoch.c - epoch based reclamation of read mostly structures
+ *
+ * A structure published through an atomic pointer is read without lock
+ * between epoch_enter() and epoch_leave(). A writer that replaces it passes
+ * the old one to epoch_retire(), and the old one is freed once no thread is
+ * still in a section entered before the replacement.
+ *
+ * Each thread has a slot where it announces the global epoch it read when
+ * it entered its outermost section, 0 when it is outside. Retiring an object
+ * advances the global epoch and tags the object with the epoch before the
+ * advance: the object is freed when every active slot announces a later
+ * epoch. A reader only writes its own slot.
+ *
+ * The list of the slots and the list of the retired objects are protected
+ * by epoch_lock, taken by the writers, by the first section of a thread, and
+ * by a reader that leaves its section while retired objects are waiting.
+ * The slot of a thread that exits is reused by the next new thread.
+ */
+
+#include "slap.h"
+
+typedef struct epoch_slot
+{
+    uint64_t es_epoch; /* epoch announced by the thread, 0 outside the sections */
+    int32_t es_depth;  /* nesting of the sections, only used by the thread */
+    int32_t es_free;   /* the thread exited */
+    struct epoch_slot *es_next;
+} epoch_slot;
+
+typedef struct epoch_retired
+{
+    void *er_obj;
+    void (*er_free)(void *obj);
+    uint64_t er_epoch;
+    struct epoch_retired *er_next;
+} epoch_retired;
+
+static pthread_mutex_t epoch_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t epoch_global = 1;
+static int32_t epoch_pending; /* retired objects are waiting */
+static epoch_slot *epoch_slots;
+static epoch_retired *epoch_retired_list;
+
+/* Free the retired objects no section can see anymore, epoch_lock is held */
+static void
+epoch_reclaim_locked(void)
+{
+    epoch_retired **prev = &epoch_retired_list;
+    uint64_t oldest = UINT64_MAX;
+
+    for (epoch_slot *slot = epoch_slots; slot; slot = slot->es_next) {
+        uint64_t epoch = __atomic_load_n(&slot->es_epoch, __ATOMIC_SEQ_CST);
+        if (epoch && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+
+    while (*prev) {
+        epoch_retired *retired = *prev;
+        if (retired->er_epoch < oldest) {
+            *prev = retired->er_next;
+            retired->er_free(retired->er_obj);
+            slapi_ch_free((void **)&retired);
+        } else {
+            prev = &retired->er_next;
+        }
+    }
+    __atomic_store_n(&epoch_pending, epoch_retired_list != NULL, __ATOMIC_RELAXED);
+}
+
+/* Return the slot of the thread, NULL if there is no thread data */
+static epoch_slot *
+epoch_get_slot(void)
+{
+    epoch_slot *slot = slapi_td_get_epoch_slot();
+
+    if (slot) {
+        return slot;
+    }
+
+    pthread_mutex_lock(&epoch_lock);
+    for (slot = epoch_slots; slot && !slot->es_free; slot = slot->es_next)
+        ;
+    if (slot == NULL) {
+        slot = (epoch_slot *)slapi_ch_calloc(1, sizeof(epoch_slot));
+        slot->es_next = epoch_slots;
+        epoch_slots = slot;
+    }
+    slot->es_free = 0;
+    if (slapi_td_set_epoch_slot(slot) != PR_SUCCESS) {
+        slot->es_free = 1;
+        slot = NULL;
+    }
+    pthread_mutex_unlock(&epoch_lock);
+
+    return slot;
+}
+
+/*
+ * Enter a read section. Returns 0 if the thread can not use the epochs
+ * (no thread data in the tools and the tests): the caller must then use
+ * the locked path, and must not call epoch_leave().
+ */
+int32_t
+epoch_enter(void)
+{
+    epoch_slot *slot = epoch_get_slot();
+
+    if (slot == NULL) {
+        return 0;
+    }
+    if (slot->es_depth++ == 0) {
+        /* The announce must be visible before the reads of the section */
+        __atomic_store_n(&slot->es_epoch, __atomic_load_n(&epoch_global, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+    }
+    return 1;
+}
+
+void
+epoch_leave(void)
+{
+    epoch_slot *slot = slapi_td_get_epoch_slot();
+
+    PR_ASSERT(slot && slot->es_depth > 0);
+    if (slot == NULL || slot->es_depth == 0) {
+        return;
+    }
+    if (--slot->es_depth == 0) {
+        __atomic_store_n(&slot->es_epoch, 0, __ATOMIC_RELEASE);
+        if (__atomic_load_n(&epoch_pending, __ATOMIC_RELAXED) &&
+            pthread_mutex_trylock(&epoch_lock) == 0) {
+            epoch_reclaim_locked();
+            pthread_mutex_unlock(&epoch_lock);
+        }
+    }
+}
+
+/*
+ * Free obj with free_fn once the sections that may have read it are over.
+ * The caller has already replaced obj, new sections can not find it.
+ */
+void
+epoch_retire(void *obj, void (*free_fn)(void *obj))
+{
+    epoch_retired *retired = (epoch_retired *)slapi_ch_malloc(sizeof(epoch_retired));
+
+    retired->er_obj = obj;
+    retired->er_free = free_fn;
+
+    pthread_mutex_lock(&epoch_lock);
+    retired->er_epoch = __atomic_fetch_add(&epoch_global, 1, __ATOMIC_SEQ_CST);
+    retired->er_next = epoch_retired_list;
+    epoch_retired_list = retired;
+    epoch_reclaim_locked();
+    pthread_mutex_unlock(&epoch_lock);
+}
+
+/* Called by the thread data destructor when a thread exits */
+void
+epoch_slot_release(void *priv)
+{
+    epoch_slot *slot = (epoch_slot *)priv;
+
+    if (slot == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&epoch_lock);
+    __atomic_store_n(&slot->es_epoch, 0, __ATOMIC_RELEASE);
+    slot->es_depth = 0;
+    slot->es_free = 1;
+    if (epoch_retired_list) {
+        epoch_reclaim_locked();
+    }
+    pthread_mutex_unlock(&epoch_lock);
+}
@@ -24,6 +24,8 @@ extern Slapi_Counter *ops_initiated;
 extern Slapi_Counter *ops_completed;
 extern Slapi_Counter *max_threads_count;
 extern Slapi_Counter *conns_in_maxthreads;
+extern Slapi_Counter *turbo_mode_count;
+extern Slapi_Counter *conns_in_turbo;
 extern PRThread *listener_tid;
 extern PRThread *listener_tid;
 extern Slapi_Counter *num_conns;
@@ -119,6 +121,7 @@ Connection *connection_table_get_next_active_connection(Connection_Table *ct, Co
 typedef int (*Connection_Table_Iterate_Function)(Connection *c, void *arg);
 int connection_table_iterate_active_connections(Connection_Table *ct, void *arg, Connection_Table_Iterate_Function f);
 int connection_table_get_list(Connection_Table *ct);
+int connection_table_get_accept_list(Connection_Table *ct, int shard, int nshards);
 
 /*
  * daemon.c
@@ -133,6 +136,19 @@ int daemon_register_reslimits(void);
 PRFileDesc *get_ssl_listener_fd(void);
 int configure_pr_socket(PRFileDesc **pr_socket, int secure, int local);
 
+/*
+ * result_writer.c
+ */
+int result_writer_enabled(void);
+void result_writer_conn_init(Connection *conn);
+void result_writer_conn_reset(Connection *conn);
+int result_writer_close_pending(Connection *conn);
+void result_writer_conn_free(Connection *conn);
+uint64_t result_writer_pending(Connection *conn);
+ber_slen_t result_writer_write(Connection *conn, void *buf, ber_len_t len);
+int result_writer_drain(Connection *conn);
+void init_result_writer_threads(void);
+
 /*
  * sasl_io.c
  */
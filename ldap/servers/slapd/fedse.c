@@ -103,6 +103,11 @@ static const char *internal_entries[] =
         "objectclass:extensibleObject\n"
         "cn:counters\n",
 
+        "dn:cn=plugins,cn=monitor\n"
+        "objectclass:top\n"
+        "objectclass:extensibleObject\n"
+        "cn:plugins\n",
+
         "dn:cn=sasl,cn=config\n"
         "objectclass:top\n"
         "objectclass:nsContainer\n"
@@ -2904,11 +2909,13 @@ setup_internal_backends(char *configdir)
         Slapi_DN saslmapping;
         Slapi_DN plugins;
         Slapi_DN diskspace;
+        Slapi_DN pluginsmonitor;
 
         slapi_sdn_init_ndn_byref(&monitor, "cn=monitor");
         slapi_sdn_init_ndn_byref(&counters, "cn=counters,cn=monitor");
         slapi_sdn_init_ndn_byref(&snmp, "cn=snmp,cn=monitor");
         slapi_sdn_init_ndn_byref(&diskspace, "cn=disk space,cn=monitor");
+        slapi_sdn_init_ndn_byref(&pluginsmonitor, PLUGIN_MONITOR_BASE_DN);
         slapi_sdn_init_ndn_byref(&root, "");
 
         slapi_sdn_init_ndn_byref(&encryption, "cn=encryption,cn=config");
@@ -2919,6 +2926,7 @@ setup_internal_backends(char *configdir)
         dse_register_callback(pfedse, SLAPI_OPERATION_SEARCH, DSE_FLAG_PREOP, &config, LDAP_SCOPE_BASE, "(objectclass=*)", read_config_dse, NULL, NULL);
         dse_register_callback(pfedse, SLAPI_OPERATION_SEARCH, DSE_FLAG_PREOP, &monitor, LDAP_SCOPE_BASE, "(objectclass=*)", monitor_info, NULL, NULL);
         dse_register_callback(pfedse, SLAPI_OPERATION_SEARCH, DSE_FLAG_PREOP, &diskspace, LDAP_SCOPE_BASE, "(objectclass=*)", monitor_disk_info, NULL, NULL);
+        dse_register_callback(pfedse, SLAPI_OPERATION_SEARCH, DSE_FLAG_PREOP, &pluginsmonitor, LDAP_SCOPE_ONELEVEL, "(objectclass=*)", plugin_monitor_info, NULL, NULL);
         dse_register_callback(pfedse, SLAPI_OPERATION_SEARCH, DSE_FLAG_PREOP, &root, LDAP_SCOPE_BASE, "(objectclass=*)", read_root_dse, NULL, NULL);
         dse_register_callback(pfedse, SLAPI_OPERATION_SEARCH, DSE_FLAG_PREOP, &monitor, LDAP_SCOPE_SUBTREE, EGG_FILTER, search_easter_egg, NULL, NULL); /* Egg */
         dse_register_callback(pfedse, SLAPI_OPERATION_SEARCH, DSE_FLAG_PREOP, &counters, LDAP_SCOPE_BASE, "(objectclass=*)", search_counters, NULL, NULL);
@@ -2943,6 +2951,8 @@ setup_internal_backends(char *configdir)
 
         /* Write */
         dse_register_callback(pfedse, DSE_OPERATION_WRITE, DSE_FLAG_PREOP, &monitor, LDAP_SCOPE_SUBTREE, EGG_FILTER, dont_allow_that, NULL, NULL); /* Egg */
+        /* The monitor entries of the plugins are added when the plugins start */
+        dse_register_callback(pfedse, DSE_OPERATION_WRITE, DSE_FLAG_PREOP, &pluginsmonitor, LDAP_SCOPE_ONELEVEL, "(objectclass=*)", dont_allow_that, NULL, NULL);
 
         /* Add */
         dse_register_callback(pfedse, SLAPI_OPERATION_ADD, DSE_FLAG_PREOP, &saslmapping, LDAP_SCOPE_SUBTREE, "(objectclass=nsSaslMapping)", sasl_map_config_add, NULL, NULL);
@@ -2971,6 +2981,7 @@ setup_internal_backends(char *configdir)
         slapi_sdn_done(&root);
         slapi_sdn_done(&saslmapping);
         slapi_sdn_done(&plugins);
+        slapi_sdn_done(&pluginsmonitor);
     } else {
         slapi_log_err(SLAPI_LOG_ERR, "setup_internal_backends",
                       "Please edit the file to correct the reported problems"
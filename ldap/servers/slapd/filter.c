@@ -22,12 +22,12 @@
 #include "slapi-plugin.h"
 
 static int
-get_filter_list(Connection *conn, BerElement *ber, struct slapi_filter **f, char **fstr, int maxdepth, int curdepth, int *subentry_dont_rewrite, int *has_tombstone_filter, int *has_ruv_filter);
+get_filter_list(Connection *conn, BerElement *ber, struct slapi_filter **f, char **fstr, int maxdepth, int curdepth, int *subentry_dont_rewrite, int *has_tombstone_filter, int *has_ruv_filter, Slapi_Arena *arena);
 static int
 get_substring_filter(Connection *conn, BerElement *ber, struct slapi_filter *f, char **fstr);
 static int get_extensible_filter(BerElement *ber, mr_filter_t *);
 
-static int get_filter_internal(Connection *conn, BerElement *ber, struct slapi_filter **filt, char **fstr, int maxdepth, int curdepth, int *subentry_dont_rewrite, int *has_tombstone_filter, int *has_ruv_filter);
+static int get_filter_internal(Connection *conn, BerElement *ber, struct slapi_filter **filt, char **fstr, int maxdepth, int curdepth, int *subentry_dont_rewrite, int *has_tombstone_filter, int *has_ruv_filter, Slapi_Arena *arena);
 static int tombstone_check_filter(Slapi_Filter *f);
 static int ruv_check_filter(Slapi_Filter *f);
 
@@ -35,6 +35,8 @@ static int ruv_check_filter(Slapi_Filter *f);
 /*
  * Read a filter off the wire and create a slapi_filter and string representation.
  * Both filt and fstr are allocated by this function, so must be freed by the caller.
+ * With an arena, the filter nodes and their avas are allocated in it: freeing
+ * the filter then only frees the other parts, the arena releases the rest.
  *
  * If the scope is not base and (objectclass=ldapsubentry) does not occur
  * in the filter then we add (!(objectclass=ldapsubentry)) to the filter
@@ -44,7 +46,7 @@ static int ruv_check_filter(Slapi_Filter *f);
  * the filter as is.
  */
 int
-get_filter(Connection *conn, BerElement *ber, int scope, struct slapi_filter **filt, char **fstr)
+get_filter(Connection *conn, BerElement *ber, int scope, struct slapi_filter **filt, char **fstr, Slapi_Arena *arena)
 {
     int subentry_dont_rewrite = 0; /* Re-write unless we're told not to */
     int has_tombstone_filter = 0;  /* Check if nsTombstone appears */
@@ -56,7 +58,7 @@ get_filter(Connection *conn, BerElement *ber, int scope, struct slapi_filter **f
     return_value = get_filter_internal(conn, ber, filt, fstr,
                                        config_get_max_filter_nest_level(), /* maximum depth */
                                        0, /* current depth */ &subentry_dont_rewrite,
-                                       &has_tombstone_filter, &has_ruv_filter);
+                                       &has_tombstone_filter, &has_ruv_filter, arena);
 
     if (0 == return_value) { /* Don't try to re-write if there was an error */
         if (subentry_dont_rewrite || scope == LDAP_SCOPE_BASE) {
@@ -166,7 +168,7 @@ slapi_filter_escape_filter_value(char* filter_attr, char *filter_value)
  *    calls this function again.
  */
 static int
-get_filter_internal(Connection *conn, BerElement *ber, struct slapi_filter **filt, char **fstr, int maxdepth, int curdepth, int *subentry_dont_rewrite, int *has_tombstone_filter, int *has_ruv_filter)
+get_filter_internal(Connection *conn, BerElement *ber, struct slapi_filter **filt, char **fstr, int maxdepth, int curdepth, int *subentry_dont_rewrite, int *has_tombstone_filter, int *has_ruv_filter, Slapi_Arena *arena)
 {
     ber_len_t len;
     int err;
@@ -224,7 +226,12 @@ get_filter_internal(Connection *conn, BerElement *ber, struct slapi_filter **fil
      *    }
      */
 
-    f = (struct slapi_filter *)slapi_ch_calloc(1, sizeof(struct slapi_filter));
+    if (arena) {
+        f = (struct slapi_filter *)slapi_arena_calloc(arena, 1, sizeof(struct slapi_filter));
+        f->f_flags = SLAPI_FILTER_ARENA_NODE;
+    } else {
+        f = (struct slapi_filter *)slapi_ch_calloc(1, sizeof(struct slapi_filter));
+    }
 
     err = 0;
     *fstr = NULL;
@@ -232,7 +239,10 @@ get_filter_internal(Connection *conn, BerElement *ber, struct slapi_filter **fil
     switch (f->f_choice) {
     case LDAP_FILTER_EQUALITY:
         slapi_log_err(SLAPI_LOG_FILTER, "get_filter_internal", "EQUALITY\n");
-        if ((err = get_ava(ber, &f->f_ava)) == 0) {
+        if ((err = get_ava(ber, &f->f_ava, arena)) == 0) {
+            if (arena) {
+                f->f_flags |= SLAPI_FILTER_ARENA_AVA;
+            }
 
             if (0 == strcasecmp(f->f_avtype, "objectclass")) {
                 /* Process objectclass oid's here */
@@ -240,8 +250,13 @@ get_filter_internal(Connection *conn, BerElement *ber, struct slapi_filter **fil
                     char *ocname = oc_find_name(f->f_avvalue.bv_val);
 
                     if (NULL != ocname) {
-                        slapi_ch_free((void **)&f->f_avvalue.bv_val);
-                        f->f_avvalue.bv_val = ocname;
+                        if (arena) {
+                            f->f_avvalue.bv_val = slapi_arena_strdup(arena, ocname);
+                            slapi_ch_free_string(&ocname);
+                        } else {
+                            slapi_ch_free((void **)&f->f_avvalue.bv_val);
+                            f->f_avvalue.bv_val = ocname;
+                        }
                         f->f_avvalue.bv_len = strlen(f->f_avvalue.bv_val);
                     }
                 }
@@ -286,14 +301,20 @@ get_filter_internal(Connection *conn, BerElement *ber, struct slapi_filter **fil
 
     case LDAP_FILTER_GE:
         slapi_log_err(SLAPI_LOG_FILTER, "get_filter_internal", "GE\n");
-        if ((err = get_ava(ber, &f->f_ava)) == 0) {
+        if ((err = get_ava(ber, &f->f_ava, arena)) == 0) {
+            if (arena) {
+                f->f_flags |= SLAPI_FILTER_ARENA_AVA;
+            }
             *fstr = filter_escape_filter_value(f, FILTER_GE_FMT, FILTER_GE_LEN);
         }
         break;
 
     case LDAP_FILTER_LE:
         slapi_log_err(SLAPI_LOG_FILTER, "get_filter_internal", "LE\n");
-        if ((err = get_ava(ber, &f->f_ava)) == 0) {
+        if ((err = get_ava(ber, &f->f_ava, arena)) == 0) {
+            if (arena) {
+                f->f_flags |= SLAPI_FILTER_ARENA_AVA;
+            }
             *fstr = filter_escape_filter_value(f, FILTER_LE_FMT, FILTER_LE_LEN);
         }
         break;
@@ -314,7 +335,10 @@ get_filter_internal(Connection *conn, BerElement *ber, struct slapi_filter **fil
 
     case LDAP_FILTER_APPROX:
         slapi_log_err(SLAPI_LOG_FILTER, "get_filter_internal", "APPROX\n");
-        if ((err = get_ava(ber, &f->f_ava)) == 0) {
+        if ((err = get_ava(ber, &f->f_ava, arena)) == 0) {
+            if (arena) {
+                f->f_flags |= SLAPI_FILTER_ARENA_AVA;
+            }
             *fstr = filter_escape_filter_value(f, FILTER_APROX_FMT, FILTER_APROX_LEN);
         }
         break;
@@ -349,7 +373,7 @@ get_filter_internal(Connection *conn, BerElement *ber, struct slapi_filter **fil
         slapi_log_err(SLAPI_LOG_FILTER, "get_filter_internal", "AND\n");
         if ((err = get_filter_list(conn, ber, &f->f_and, &ftmp, maxdepth,
                                    curdepth, subentry_dont_rewrite,
-                                   has_tombstone_filter, has_ruv_filter)) == 0) {
+                                   has_tombstone_filter, has_ruv_filter, arena)) == 0) {
             filter_compute_hash(f);
             *fstr = slapi_ch_smprintf("(&%s)", ftmp);
             slapi_ch_free((void **)&ftmp);
@@ -360,7 +384,7 @@ get_filter_internal(Connection *conn, BerElement *ber, struct slapi_filter **fil
         slapi_log_err(SLAPI_LOG_FILTER, "get_filter_internal", "OR\n");
         if ((err = get_filter_list(conn, ber, &f->f_or, &ftmp, maxdepth,
                                    curdepth, subentry_dont_rewrite,
-                                   has_tombstone_filter, has_ruv_filter)) == 0) {
+                                   has_tombstone_filter, has_ruv_filter, arena)) == 0) {
             filter_compute_hash(f);
             *fstr = slapi_ch_smprintf("(|%s)", ftmp);
             slapi_ch_free((void **)&ftmp);
@@ -372,7 +396,7 @@ get_filter_internal(Connection *conn, BerElement *ber, struct slapi_filter **fil
         (void)ber_skip_tag(ber, &len);
         if ((err = get_filter_internal(conn, ber, &f->f_not, &ftmp, maxdepth,
                                        curdepth, subentry_dont_rewrite,
-                                       has_tombstone_filter, has_ruv_filter)) == 0) {
+                                       has_tombstone_filter, has_ruv_filter, arena)) == 0) {
             filter_compute_hash(f);
             *fstr = slapi_ch_smprintf("(!%s)", ftmp);
             slapi_ch_free((void **)&ftmp);
@@ -397,13 +421,18 @@ get_filter_internal(Connection *conn, BerElement *ber, struct slapi_filter **fil
 }
 
 static int
-get_filter_list(Connection *conn, BerElement *ber, struct slapi_filter **f, char **fstr, int maxdepth, int curdepth, int *subentry_dont_rewrite, int *has_tombstone_filter, int *has_ruv_filter)
+get_filter_list(Connection *conn, BerElement *ber, struct slapi_filter **f, char **fstr, int maxdepth, int curdepth, int *subentry_dont_rewrite, int *has_tombstone_filter, int *has_ruv_filter, Slapi_Arena *arena)
 {
     struct slapi_filter **new;
     int err;
     ber_tag_t tag;
     ber_len_t len = LBER_ERROR;
     char *last;
+    /* strings of the components, joined once at the end */
+    char **parts = NULL;
+    size_t nparts = 0;
+    size_t maxparts = 0;
+    size_t fstr_len = 0;
 
     slapi_log_err(SLAPI_LOG_FILTER, "get_filter_list", "=>\n");
 
@@ -415,25 +444,42 @@ get_filter_list(Connection *conn, BerElement *ber, struct slapi_filter **f, char
         char *ftmp;
         if ((err = get_filter_internal(conn, ber, new, &ftmp, maxdepth,
                                        curdepth, subentry_dont_rewrite,
-                                       has_tombstone_filter, has_ruv_filter)) != 0) {
-            if (*fstr != NULL) {
-                slapi_ch_free((void **)fstr);
+                                       has_tombstone_filter, has_ruv_filter, arena)) != 0) {
+            for (size_t i = 0; i < nparts; i++) {
+                slapi_ch_free_string(&parts[i]);
             }
             return (err);
         }
-        if (*fstr == NULL) {
-            *fstr = ftmp;
-        } else {
-            *fstr = slapi_ch_realloc(*fstr, strlen(*fstr) +
-                                                strlen(ftmp) + 1);
-            strcat(*fstr, ftmp);
-            slapi_ch_free((void **)&ftmp);
+        if (nparts == maxparts) {
+            char **grown;
+
+            maxparts = maxparts ? maxparts * 2 : 8;
+            grown = (char **)slapi_arena_alloc(arena, maxparts * sizeof(char *));
+            if (nparts) {
+                memcpy(grown, parts, nparts * sizeof(char *));
+            }
+            parts = grown;
         }
+        parts[nparts++] = ftmp;
+        fstr_len += strlen(ftmp);
         new = &(*new)->f_next;
         len = -1;
     }
     *new = NULL;
 
+    if (nparts) {
+        char *p = *fstr = slapi_ch_malloc(fstr_len + 1);
+
+        for (size_t i = 0; i < nparts; i++) {
+            size_t part_len = strlen(parts[i]);
+
+            memcpy(p, parts[i], part_len);
+            p += part_len;
+            slapi_ch_free_string(&parts[i]);
+        }
+        *p = '\0';
+    }
+
     /* openldap does not return LBER_END_OF_SEQORSET -
        so check for len == -1 - openldap ber_next_element will not set
        len if it has reached the end, and -1 is not a valid value
@@ -691,7 +737,7 @@ slapi_filter_dup(Slapi_Filter *f)
 
     out->f_choice = f->f_choice;
     out->f_hash = f->f_hash;
-    out->f_flags = f->f_flags;
+    out->f_flags = f->f_flags & ~SLAPI_FILTER_ARENA;
 
     slapi_log_err(SLAPI_LOG_FILTER, "slapi_filter_dup", "type 0x%lX\n", f->f_choice);
     switch (f->f_choice) {
@@ -750,6 +796,33 @@ slapi_filter_dup(Slapi_Filter *f)
     return out;
 }
 
+/* the type and value of an arena ava go away with the arena */
+static void
+filter_ava_done(struct slapi_filter *f)
+{
+    if (f->f_flags & SLAPI_FILTER_ARENA_AVA) {
+        f->f_ava.ava_type = NULL;
+        f->f_ava.ava_value.bv_val = NULL;
+        f->f_ava.ava_value.bv_len = 0;
+        f->f_flags &= ~SLAPI_FILTER_ARENA_AVA;
+    } else {
+        ava_done(&f->f_ava);
+    }
+}
+
+/* copy an arena ava to the heap, before one of its strings is replaced */
+static void
+filter_ava_to_heap(struct slapi_filter *f)
+{
+    if (f->f_flags & SLAPI_FILTER_ARENA_AVA) {
+        struct berval value = f->f_ava.ava_value;
+
+        f->f_ava.ava_type = slapi_ch_strdup(f->f_ava.ava_type);
+        slapi_ber_bvcpy(&f->f_ava.ava_value, &value);
+        f->f_flags &= ~SLAPI_FILTER_ARENA_AVA;
+    }
+}
+
 void
 slapi_filter_free(struct slapi_filter *f, int recurse)
 {
@@ -763,7 +836,7 @@ slapi_filter_free(struct slapi_filter *f, int recurse)
     case LDAP_FILTER_GE:
     case LDAP_FILTER_LE:
     case LDAP_FILTER_APPROX:
-        ava_done(&f->f_ava);
+        filter_ava_done(f);
         break;
 
     case LDAP_FILTER_SUBSTRINGS:
@@ -810,7 +883,9 @@ slapi_filter_free(struct slapi_filter *f, int recurse)
                       f->f_choice);
         break;
     }
-    slapi_ch_free((void **)&f);
+    if (!(f->f_flags & SLAPI_FILTER_ARENA_NODE)) {
+        slapi_ch_free((void **)&f);
+    }
 }
 
 struct slapi_filter *
@@ -891,7 +966,7 @@ slapi_filter_join_ex(int ftype, struct slapi_filter *f1, struct slapi_filter *f2
          * Make sure we sync the filter flags. The origin filters may have flags
          * we still need on the outer layer!
          */
-        add_to->f_flags |= add_this->f_flags;
+        add_to->f_flags |= add_this->f_flags & ~SLAPI_FILTER_ARENA;
         filter_compute_hash(add_to);
         return_this = add_to;
     } else {
@@ -907,7 +982,7 @@ slapi_filter_join_ex(int ftype, struct slapi_filter *f1, struct slapi_filter *f2
             f1->f_next = f2;
         }
         /* Make sure any flags that were set move to the outer parent */
-        fjoin->f_flags |= f1->f_flags | f2->f_flags;
+        fjoin->f_flags |= (f1->f_flags | f2->f_flags) & ~SLAPI_FILTER_ARENA;
         filter_compute_hash(fjoin);
         return_this = fjoin;
     }
@@ -1044,6 +1119,7 @@ slapi_filter_replace_ex(Slapi_Filter *f, char *s)
 {
     Slapi_Filter *newf = NULL;
     Slapi_Filter *temp = NULL;
+    int arena_node;
     char *buf = slapi_ch_strdup(s);
 
     newf = slapi_str2filter(buf);
@@ -1056,8 +1132,10 @@ slapi_filter_replace_ex(Slapi_Filter *f, char *s)
     /* Now take the parts of newf and put them in f */
     /* An easy way to do this is to preserve the "next" ptr */
     temp = f->f_next;
+    arena_node = f->f_flags & SLAPI_FILTER_ARENA_NODE;
     *f = *newf;
     f->f_next = temp;
+    f->f_flags |= arena_node;
     /* Free the new filter husk */
     slapi_ch_free((void **)&newf);
     return 0;
@@ -1076,7 +1154,7 @@ slapi_filter_free_bits(Slapi_Filter *f)
     case LDAP_FILTER_GE:
     case LDAP_FILTER_LE:
     case LDAP_FILTER_APPROX:
-        ava_done(&f->f_ava);
+        filter_ava_done(f);
         break;
 
     case LDAP_FILTER_PRESENT:
@@ -1117,6 +1195,7 @@ filter_normalize_ava(struct slapi_filter *f, PRBool norm_values)
         return;
     }
 
+    filter_ava_to_heap(f);
     ava = &f->f_ava;
     tmp = ava->ava_type;
     ava->ava_type = slapi_attr_syntax_normalize(tmp);
@@ -1823,6 +1902,7 @@ slapi_filter_changetype(Slapi_Filter *f, const char *newtype)
     case LDAP_FILTER_GE:
     case LDAP_FILTER_LE:
     case LDAP_FILTER_APPROX:
+        filter_ava_to_heap(f);
         target = &f->f_ava.ava_type;
         break;
 
@@ -1242,6 +1242,22 @@ static struct config_get_and_set
      NULL, 0,
      (void **)&global_slapdFrontendConfig.listen_backlog_size, CONFIG_INT,
      (ConfigGetFunc)config_get_listen_backlog_size, DAEMON_LISTEN_SIZE_STR, NULL},
+    {CONFIG_PLUGIN_SLOW_THRESHOLD, config_set_plugin_slow_threshold,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.plugin_slow_threshold, CONFIG_INT,
+     (ConfigGetFunc)config_get_plugin_slow_threshold, SLAPD_DEFAULT_PLUGIN_SLOW_THRESHOLD_STR, NULL},
+    {CONFIG_RESULT_WRITER_THREADS, config_set_result_writer_threads,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.result_writer_threads, CONFIG_INT,
+     (ConfigGetFunc)config_get_result_writer_threads, SLAPD_DEFAULT_RESULT_WRITER_THREADS_STR, NULL},
+    {CONFIG_CONN_OUTPUT_MAX_BYTES, config_set_conn_output_max_bytes,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.conn_output_max_bytes, CONFIG_INT,
+     (ConfigGetFunc)config_get_conn_output_max_bytes, SLAPD_DEFAULT_CONN_OUTPUT_MAX_BYTES_STR, NULL},
+    {CONFIG_ACCEPT_THREADS, config_set_accept_threads,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.accept_threads, CONFIG_INT,
+     (ConfigGetFunc)config_get_accept_threads, SLAPD_DEFAULT_ACCEPT_THREADS_STR, NULL},
     {CONFIG_DYNAMIC_PLUGINS, config_set_dynamic_plugins,
      NULL, 0,
      (void **)&global_slapdFrontendConfig.dynamic_plugins, CONFIG_ON_OFF,
@@ -2036,6 +2052,10 @@ FrontendConfig_init(void)
     init_connection_nocanon = cfg->connection_nocanon = LDAP_ON;
     init_plugin_logging = cfg->plugin_logging = LDAP_OFF;
     cfg->listen_backlog_size = DAEMON_LISTEN_SIZE;
+    cfg->plugin_slow_threshold = SLAPD_DEFAULT_PLUGIN_SLOW_THRESHOLD;
+    cfg->result_writer_threads = SLAPD_DEFAULT_RESULT_WRITER_THREADS;
+    cfg->conn_output_max_bytes = SLAPD_DEFAULT_CONN_OUTPUT_MAX_BYTES;
+    cfg->accept_threads = SLAPD_DEFAULT_ACCEPT_THREADS;
     init_ignore_time_skew = cfg->ignore_time_skew = LDAP_OFF;
     init_dynamic_plugins = cfg->dynamic_plugins = LDAP_OFF;
     init_cn_uses_dn_syntax_in_dns = cfg->cn_uses_dn_syntax_in_dns = LDAP_OFF;
@@ -8886,6 +8906,140 @@ config_get_listen_backlog_size()
     return retVal;
 }
 
+int
+config_set_plugin_slow_threshold(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    long threshold;
+    char *endp;
+
+    if (config_value_is_null(attrname, value, errorbuf, 0)) {
+        return LDAP_OPERATIONS_ERROR;
+    }
+
+    errno = 0;
+    threshold = strtol(value, &endp, 10);
+    if (*endp != '\0' || errno == ERANGE || threshold < 0 || threshold > INT_MAX) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE,
+                              "(%s) value (%s) is invalid, it must be between 0 and %d\n",
+                              attrname, value, INT_MAX);
+        return LDAP_OPERATIONS_ERROR;
+    }
+
+    if (apply) {
+        slapi_atomic_store_32(&(slapdFrontendConfig->plugin_slow_threshold), threshold, __ATOMIC_RELEASE);
+    }
+    return LDAP_SUCCESS;
+}
+
+int
+config_get_plugin_slow_threshold(void)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    return slapi_atomic_load_32(&(slapdFrontendConfig->plugin_slow_threshold), __ATOMIC_ACQUIRE);
+}
+
+/* Read at startup, the change needs a restart */
+int
+config_set_result_writer_threads(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    long threads;
+    char *endp;
+
+    if (config_value_is_null(attrname, value, errorbuf, 0)) {
+        return LDAP_OPERATIONS_ERROR;
+    }
+
+    errno = 0;
+    threads = strtol(value, &endp, 10);
+    if (*endp != '\0' || errno == ERANGE || threads < 0 || threads > 64) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE,
+                              "(%s) value (%s) is invalid, it must be between 0 and 64\n",
+                              attrname, value);
+        return LDAP_OPERATIONS_ERROR;
+    }
+
+    if (apply) {
+        slapi_atomic_store_32(&(slapdFrontendConfig->result_writer_threads), threads, __ATOMIC_RELEASE);
+    }
+    return LDAP_SUCCESS;
+}
+
+int
+config_get_result_writer_threads(void)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    return slapi_atomic_load_32(&(slapdFrontendConfig->result_writer_threads), __ATOMIC_ACQUIRE);
+}
+
+int
+config_set_conn_output_max_bytes(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    long size;
+    char *endp;
+
+    if (config_value_is_null(attrname, value, errorbuf, 0)) {
+        return LDAP_OPERATIONS_ERROR;
+    }
+
+    errno = 0;
+    size = strtol(value, &endp, 10);
+    if (*endp != '\0' || errno == ERANGE || size < 4096 || size > INT_MAX) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE,
+                              "(%s) value (%s) is invalid, it must be between 4096 and %d\n",
+                              attrname, value, INT_MAX);
+        return LDAP_OPERATIONS_ERROR;
+    }
+
+    if (apply) {
+        slapi_atomic_store_32(&(slapdFrontendConfig->conn_output_max_bytes), size, __ATOMIC_RELEASE);
+    }
+    return LDAP_SUCCESS;
+}
+
+int
+config_get_conn_output_max_bytes(void)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    return slapi_atomic_load_32(&(slapdFrontendConfig->conn_output_max_bytes), __ATOMIC_ACQUIRE);
+}
+
+/* Read when the listeners are created, the change needs a restart */
+int
+config_set_accept_threads(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    long threads;
+    char *endp;
+
+    if (config_value_is_null(attrname, value, errorbuf, 0)) {
+        return LDAP_OPERATIONS_ERROR;
+    }
+
+    errno = 0;
+    threads = strtol(value, &endp, 10);
+    if (*endp != '\0' || errno == ERANGE || threads < 1 || threads > 16) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE,
+                              "(%s) value (%s) is invalid, it must be between 1 and 16\n",
+                              attrname, value);
+        return LDAP_OPERATIONS_ERROR;
+    }
+
+    if (apply) {
+        slapi_atomic_store_32(&(slapdFrontendConfig->accept_threads), threads, __ATOMIC_RELEASE);
+    }
+    return LDAP_SUCCESS;
+}
+
+int
+config_get_accept_threads(void)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    return slapi_atomic_load_32(&(slapdFrontendConfig->accept_threads), __ATOMIC_ACQUIRE);
+}
+
 int
 config_get_enable_nunc_stans()
 {
@@ -224,6 +224,7 @@ operation_done(Slapi_Operation **op, Connection *conn)
         }
         slapi_ch_free_string(&(*op)->o_results.result_matched);
         slapi_ch_free_string(&(*op)->o_results.result_text);
+        slapi_arena_destroy(&(*op)->o_arena);
         int options = 0;
         /* save the old options */
         if ((*op)->o_ber) {
@@ -250,6 +251,16 @@ operation_free(Slapi_Operation **op, Connection *conn)
     }
 }
 
+/* The arena is created on the first use */
+Slapi_Arena *
+slapi_operation_get_arena(Slapi_Operation *op)
+{
+    if (op->o_arena == NULL) {
+        op->o_arena = slapi_arena_new();
+    }
+    return op->o_arena;
+}
+
 void
 slapi_operation_set_csngen_handler(Slapi_Operation *op, void *callback)
 {
@@ -723,6 +734,7 @@ op_stat_destructor(void *extension, void *object __attribute__((unused)), void *
             slapi_ch_free((void **) &keys);
             keys = next;
         }
+        slapi_ch_free_string(&op_statp->search_stat->filter_plan);
         slapi_ch_free((void **) &op_statp->search_stat);
     }
     slapi_ch_free((void **) &op_statp);
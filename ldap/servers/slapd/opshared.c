@@ -50,6 +50,7 @@ op_shared_is_allowed_attr(const char *attr_name, int replicated_op)
 
     if (!replicated_op) {
         struct asyntaxinfo *asi;
+        asyntaxref ref = {0};
         int no_user_mod = 0;
 
         /* check list of attributes that no client is allowed to specify */
@@ -63,13 +64,20 @@ op_shared_is_allowed_attr(const char *attr_name, int replicated_op)
          * check to see if attribute is marked as one clients can't modify
          */
 
-        asi = attr_syntax_get_by_name(attr_name, 0);
-        if (NULL != asi &&
-            0 != (asi->asi_flags & SLAPI_ATTR_FLAG_NOUSERMOD)) {
-            /* this attribute is not allowed */
-            no_user_mod = 1;
+        switch (attr_syntax_get_ref(attr_name, 0, &ref, NULL)) {
+        case ATTR_SYNTAX_REF_FOUND:
+            no_user_mod = (0 != (ref.asr_flags & SLAPI_ATTR_FLAG_NOUSERMOD));
+            break;
+        case ATTR_SYNTAX_REF_UNAVAILABLE:
+            asi = attr_syntax_get_by_name(attr_name, 0);
+            if (NULL != asi &&
+                0 != (asi->asi_flags & SLAPI_ATTR_FLAG_NOUSERMOD)) {
+                /* this attribute is not allowed */
+                no_user_mod = 1;
+            }
+            attr_syntax_return(asi);
+            break;
         }
-        attr_syntax_return(asi);
 
         if (no_user_mod) {
             return (0);
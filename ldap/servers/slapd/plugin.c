@@ -45,6 +45,9 @@ static char *critical_plugins[] = {"cn=ldbm database,cn=plugins,cn=config",
 static int plugin_call_list(struct slapdplugin *list, int operation, Slapi_PBlock *pb);
 static int plugin_call_one(struct slapdplugin *list, int operation, Slapi_PBlock *pb);
 static int plugin_call_func(struct slapdplugin *list, int operation, Slapi_PBlock *pb, int call_one);
+static int plugin_call_dispatch(int operation, Slapi_PBlock *pb);
+static void plugin_dispatch_rebuild(void);
+static void plugin_monitor_add(struct slapdplugin *main_plugin);
 
 static PRBool plugin_invoke_plugin_pb(struct slapdplugin *plugin, int operation, Slapi_PBlock *pb);
 static PRBool plugin_matches_operation(Slapi_DN *target_spec, PluginTargetData *ptd, PRBool bindop, PRBool isroot, PRBool islocal, ber_tag_t method);
@@ -143,6 +146,8 @@ add_plugin_to_list(struct slapdplugin **list, struct slapdplugin *plugin)
     if (!plugin_added) {
         *tmp = plugin;
     }
+
+    plugin_dispatch_rebuild();
 }
 
 struct slapdplugin *
@@ -304,16 +309,17 @@ slapi_register_plugin_ext(
     return rc;
 }
 
-int
-plugin_call_plugins(Slapi_PBlock *pb, int whichfunction)
+/*
+ * Return the plugin list of an operation callback, -1 if the function is not
+ * an operation callback. *always is set if the callback is allowed during
+ * startup.
+ */
+static int
+plugin_get_callback_list(int whichfunction, int *always)
 {
-    int plugin_list_number = -1;
-    int rc = 0;
-    int do_op = global_plugin_callbacks_enabled;
+    int list_number = -1;
 
-    if (pb == NULL) {
-        return (0);
-    }
+    *always = 0;
 
     switch (whichfunction) {
     case SLAPI_PLUGIN_PRE_BIND_FN:
@@ -328,7 +334,7 @@ plugin_call_plugins(Slapi_PBlock *pb, int whichfunction)
     case SLAPI_PLUGIN_PRE_ENTRY_FN:
     case SLAPI_PLUGIN_PRE_REFERRAL_FN:
     case SLAPI_PLUGIN_PRE_RESULT_FN:
-        plugin_list_number = PLUGIN_LIST_PREOPERATION;
+        list_number = PLUGIN_LIST_PREOPERATION;
         break;
     case SLAPI_PLUGIN_POST_BIND_FN:
     case SLAPI_PLUGIN_POST_UNBIND_FN:
@@ -343,15 +349,15 @@ plugin_call_plugins(Slapi_PBlock *pb, int whichfunction)
     case SLAPI_PLUGIN_POST_ENTRY_FN:
     case SLAPI_PLUGIN_POST_REFERRAL_FN:
     case SLAPI_PLUGIN_POST_RESULT_FN:
-        plugin_list_number = PLUGIN_LIST_POSTOPERATION;
+        list_number = PLUGIN_LIST_POSTOPERATION;
         break;
     case SLAPI_PLUGIN_BE_PRE_MODIFY_FN:
     case SLAPI_PLUGIN_BE_PRE_MODRDN_FN:
     case SLAPI_PLUGIN_BE_PRE_ADD_FN:
     case SLAPI_PLUGIN_BE_PRE_DELETE_FN:
     case SLAPI_PLUGIN_BE_PRE_CLOSE_FN:
-        plugin_list_number = PLUGIN_LIST_BEPREOPERATION;
-        do_op = 1; /* always allow backend callbacks (even during startup) */
+        list_number = PLUGIN_LIST_BEPREOPERATION;
+        *always = 1; /* always allow backend callbacks (even during startup) */
         break;
     case SLAPI_PLUGIN_BE_POST_MODIFY_FN:
     case SLAPI_PLUGIN_BE_POST_MODRDN_FN:
@@ -360,45 +366,65 @@ plugin_call_plugins(Slapi_PBlock *pb, int whichfunction)
     case SLAPI_PLUGIN_BE_POST_OPEN_FN:
     case SLAPI_PLUGIN_BE_POST_EXPORT_FN:
     case SLAPI_PLUGIN_BE_POST_IMPORT_FN:
-        plugin_list_number = PLUGIN_LIST_BEPOSTOPERATION;
-        do_op = 1; /* always allow backend callbacks (even during startup) */
+        list_number = PLUGIN_LIST_BEPOSTOPERATION;
+        *always = 1; /* always allow backend callbacks (even during startup) */
         break;
     case SLAPI_PLUGIN_INTERNAL_PRE_MODIFY_FN:
     case SLAPI_PLUGIN_INTERNAL_PRE_MODRDN_FN:
     case SLAPI_PLUGIN_INTERNAL_PRE_ADD_FN:
     case SLAPI_PLUGIN_INTERNAL_PRE_DELETE_FN:
     case SLAPI_PLUGIN_INTERNAL_PRE_BIND_FN:
-        plugin_list_number = PLUGIN_LIST_INTERNAL_PREOPERATION;
+        list_number = PLUGIN_LIST_INTERNAL_PREOPERATION;
         break;
     case SLAPI_PLUGIN_INTERNAL_POST_MODIFY_FN:
     case SLAPI_PLUGIN_INTERNAL_POST_MODRDN_FN:
     case SLAPI_PLUGIN_INTERNAL_POST_ADD_FN:
     case SLAPI_PLUGIN_INTERNAL_POST_DELETE_FN:
-        plugin_list_number = PLUGIN_LIST_INTERNAL_POSTOPERATION;
+        list_number = PLUGIN_LIST_INTERNAL_POSTOPERATION;
         break;
     case SLAPI_PLUGIN_BE_TXN_PRE_MODIFY_FN:
     case SLAPI_PLUGIN_BE_TXN_PRE_MODRDN_FN:
     case SLAPI_PLUGIN_BE_TXN_PRE_ADD_FN:
     case SLAPI_PLUGIN_BE_TXN_PRE_DELETE_FN:
     case SLAPI_PLUGIN_BE_TXN_PRE_DELETE_TOMBSTONE_FN:
-        plugin_list_number = PLUGIN_LIST_BETXNPREOPERATION;
-        do_op = 1; /* always allow backend callbacks (even during startup) */
+        list_number = PLUGIN_LIST_BETXNPREOPERATION;
+        *always = 1; /* always allow backend callbacks (even during startup) */
         break;
     case SLAPI_PLUGIN_BE_TXN_POST_MODIFY_FN:
     case SLAPI_PLUGIN_BE_TXN_POST_MODRDN_FN:
     case SLAPI_PLUGIN_BE_TXN_POST_ADD_FN:
     case SLAPI_PLUGIN_BE_TXN_POST_DELETE_FN:
-        plugin_list_number = PLUGIN_LIST_BETXNPOSTOPERATION;
-        do_op = 1; /* always allow backend callbacks (even during startup) */
+        list_number = PLUGIN_LIST_BETXNPOSTOPERATION;
+        *always = 1; /* always allow backend callbacks (even during startup) */
         break;
     case SLAPI_PLUGIN_PRE_EXTOP_FN:
-        plugin_list_number = PLUGIN_LIST_PREEXTENDED_OPERATION;
+        list_number = PLUGIN_LIST_PREEXTENDED_OPERATION;
         break;
     case SLAPI_PLUGIN_POST_EXTOP_FN:
-        plugin_list_number = PLUGIN_LIST_POSTEXTENDED_OPERATION;
+        list_number = PLUGIN_LIST_POSTEXTENDED_OPERATION;
         break;
     }
 
+    return list_number;
+}
+
+int
+plugin_call_plugins(Slapi_PBlock *pb, int whichfunction)
+{
+    int plugin_list_number = -1;
+    int rc = 0;
+    int always = 0;
+    int do_op = global_plugin_callbacks_enabled;
+
+    if (pb == NULL) {
+        return (0);
+    }
+
+    plugin_list_number = plugin_get_callback_list(whichfunction, &always);
+    if (always) {
+        do_op = 1;
+    }
+
     if (plugin_list_number != -1 && do_op) {
         /* We stash the pblock plugin pointer to preserve the callers context */
         struct slapdplugin *p;
@@ -411,7 +437,7 @@ plugin_call_plugins(Slapi_PBlock *pb, int whichfunction)
 
         slapi_pblock_get(pb, SLAPI_PLUGIN, &p);
         /* Call the operation on the Global Plugins */
-        rc = plugin_call_list(global_plugin_list[plugin_list_number], whichfunction, pb);
+        rc = plugin_call_dispatch(whichfunction, pb);
         slapi_pblock_set(pb, SLAPI_PLUGIN, p);
 
         if (!locked) {
@@ -988,6 +1014,9 @@ plugin_set_plugins_started(struct slapdplugin *plugin_entry)
             plugin = plugin->plg_next;
         }
     }
+    /* the start functions may have registered new callbacks */
+    plugin_dispatch_rebuild();
+    plugin_monitor_add(plugin_entry);
 }
 /*
  * A plugin dependency changed, update the dependency list
@@ -1946,6 +1975,477 @@ plugin_call_one(struct slapdplugin *list, int operation, Slapi_PBlock *pb)
 }
 
 
+/*
+ * Call statistics of the operation callbacks.
+ *
+ * A plugin keeps, for each callback of the dispatch tables it implements,
+ * the number of calls and of failed calls, their total and maximum duration
+ * and a histogram of their duration: the bucket i counts the calls that
+ * took less than 2^i microseconds, the last one counts all the slower calls.
+ * The counters are updated without lock, so a reader may see a call in the
+ * count before it is in the histogram.
+ * The statistics are created with the dispatch tables and are kept by the
+ * plugin until it is freed, a rebuild of the tables reuses them.
+ */
+#define PLUGIN_LATENCY_BUCKETS 24
+
+typedef struct plugin_call_stats
+{
+    int operation;
+    uint64_t calls;
+    uint64_t failed;
+    uint64_t total_usec;
+    uint64_t max_usec;
+    uint64_t latency[PLUGIN_LATENCY_BUCKETS];
+    struct plugin_call_stats *next;
+} plugin_call_stats;
+
+static const struct
+{
+    int operation;
+    const char *name;
+} plugin_callback_names[] = {
+    {SLAPI_PLUGIN_PRE_BIND_FN, "prebind"},
+    {SLAPI_PLUGIN_PRE_UNBIND_FN, "preunbind"},
+    {SLAPI_PLUGIN_PRE_SEARCH_FN, "presearch"},
+    {SLAPI_PLUGIN_PRE_COMPARE_FN, "precompare"},
+    {SLAPI_PLUGIN_PRE_MODIFY_FN, "premodify"},
+    {SLAPI_PLUGIN_PRE_MODRDN_FN, "premodrdn"},
+    {SLAPI_PLUGIN_PRE_ADD_FN, "preadd"},
+    {SLAPI_PLUGIN_PRE_DELETE_FN, "predelete"},
+    {SLAPI_PLUGIN_PRE_ABANDON_FN, "preabandon"},
+    {SLAPI_PLUGIN_PRE_ENTRY_FN, "preentry"},
+    {SLAPI_PLUGIN_PRE_REFERRAL_FN, "prereferral"},
+    {SLAPI_PLUGIN_PRE_RESULT_FN, "preresult"},
+    {SLAPI_PLUGIN_PRE_EXTOP_FN, "preextop"},
+    {SLAPI_PLUGIN_INTERNAL_PRE_ADD_FN, "internalpreadd"},
+    {SLAPI_PLUGIN_INTERNAL_PRE_MODIFY_FN, "internalpremodify"},
+    {SLAPI_PLUGIN_INTERNAL_PRE_MODRDN_FN, "internalpremodrdn"},
+    {SLAPI_PLUGIN_INTERNAL_PRE_DELETE_FN, "internalpredelete"},
+    {SLAPI_PLUGIN_INTERNAL_PRE_BIND_FN, "internalprebind"},
+    {SLAPI_PLUGIN_BE_PRE_ADD_FN, "bepreadd"},
+    {SLAPI_PLUGIN_BE_PRE_MODIFY_FN, "bepremodify"},
+    {SLAPI_PLUGIN_BE_PRE_MODRDN_FN, "bepremodrdn"},
+    {SLAPI_PLUGIN_BE_PRE_DELETE_FN, "bepredelete"},
+    {SLAPI_PLUGIN_BE_PRE_CLOSE_FN, "bepreclose"},
+    {SLAPI_PLUGIN_BE_TXN_PRE_ADD_FN, "betxnpreadd"},
+    {SLAPI_PLUGIN_BE_TXN_PRE_MODIFY_FN, "betxnpremodify"},
+    {SLAPI_PLUGIN_BE_TXN_PRE_MODRDN_FN, "betxnpremodrdn"},
+    {SLAPI_PLUGIN_BE_TXN_PRE_DELETE_FN, "betxnpredelete"},
+    {SLAPI_PLUGIN_BE_TXN_PRE_DELETE_TOMBSTONE_FN, "betxnpredeletetombstone"},
+    {SLAPI_PLUGIN_POST_BIND_FN, "postbind"},
+    {SLAPI_PLUGIN_POST_UNBIND_FN, "postunbind"},
+    {SLAPI_PLUGIN_POST_SEARCH_FN, "postsearch"},
+    {SLAPI_PLUGIN_POST_COMPARE_FN, "postcompare"},
+    {SLAPI_PLUGIN_POST_MODIFY_FN, "postmodify"},
+    {SLAPI_PLUGIN_POST_MODRDN_FN, "postmodrdn"},
+    {SLAPI_PLUGIN_POST_ADD_FN, "postadd"},
+    {SLAPI_PLUGIN_POST_DELETE_FN, "postdelete"},
+    {SLAPI_PLUGIN_POST_ABANDON_FN, "postabandon"},
+    {SLAPI_PLUGIN_POST_ENTRY_FN, "postentry"},
+    {SLAPI_PLUGIN_POST_REFERRAL_FN, "postreferral"},
+    {SLAPI_PLUGIN_POST_RESULT_FN, "postresult"},
+    {SLAPI_PLUGIN_POST_SEARCH_FAIL_FN, "postsearchfail"},
+    {SLAPI_PLUGIN_POST_EXTOP_FN, "postextop"},
+    {SLAPI_PLUGIN_INTERNAL_POST_ADD_FN, "internalpostadd"},
+    {SLAPI_PLUGIN_INTERNAL_POST_MODIFY_FN, "internalpostmodify"},
+    {SLAPI_PLUGIN_INTERNAL_POST_MODRDN_FN, "internalpostmodrdn"},
+    {SLAPI_PLUGIN_INTERNAL_POST_DELETE_FN, "internalpostdelete"},
+    {SLAPI_PLUGIN_BE_POST_ADD_FN, "bepostadd"},
+    {SLAPI_PLUGIN_BE_POST_MODIFY_FN, "bepostmodify"},
+    {SLAPI_PLUGIN_BE_POST_MODRDN_FN, "bepostmodrdn"},
+    {SLAPI_PLUGIN_BE_POST_DELETE_FN, "bepostdelete"},
+    {SLAPI_PLUGIN_BE_POST_OPEN_FN, "bepostopen"},
+    {SLAPI_PLUGIN_BE_POST_EXPORT_FN, "bepostexport"},
+    {SLAPI_PLUGIN_BE_POST_IMPORT_FN, "bepostimport"},
+    {SLAPI_PLUGIN_BE_TXN_POST_ADD_FN, "betxnpostadd"},
+    {SLAPI_PLUGIN_BE_TXN_POST_MODIFY_FN, "betxnpostmodify"},
+    {SLAPI_PLUGIN_BE_TXN_POST_MODRDN_FN, "betxnpostmodrdn"},
+    {SLAPI_PLUGIN_BE_TXN_POST_DELETE_FN, "betxnpostdelete"},
+    {0, NULL}};
+
+static const char *
+plugin_callback_name(int operation)
+{
+    for (size_t i = 0; plugin_callback_names[i].name; i++) {
+        if (plugin_callback_names[i].operation == operation) {
+            return plugin_callback_names[i].name;
+        }
+    }
+    return "unknown";
+}
+
+/* Return the statistics of a callback of the plugin, create them if needed */
+static plugin_call_stats *
+plugin_call_stats_get(struct slapdplugin *plugin, int operation)
+{
+    plugin_call_stats *stats;
+
+    for (stats = plugin->plg_call_stats; stats; stats = stats->next) {
+        if (stats->operation == operation) {
+            return stats;
+        }
+    }
+    stats = (plugin_call_stats *)slapi_ch_calloc(1, sizeof(plugin_call_stats));
+    stats->operation = operation;
+    stats->next = plugin->plg_call_stats;
+    plugin->plg_call_stats = stats;
+
+    return stats;
+}
+
+static void
+plugin_call_stats_free(struct slapdplugin *plugin)
+{
+    while (plugin->plg_call_stats) {
+        plugin_call_stats *next = plugin->plg_call_stats->next;
+        slapi_ch_free((void **)&plugin->plg_call_stats);
+        plugin->plg_call_stats = next;
+    }
+}
+
+/*
+ * Account a call that started at *start, and log it if it took longer than
+ * nsslapd-plugin-slow-threshold
+ */
+static void
+plugin_call_stats_record(struct slapdplugin *plugin, plugin_call_stats *stats, Slapi_PBlock *pb, struct timespec *start, int rc)
+{
+    struct timespec now;
+    struct timespec elapsed;
+    uint64_t usec;
+    uint64_t max;
+    size_t bucket;
+    int32_t threshold;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    slapi_timespec_diff(&now, start, &elapsed);
+    usec = (uint64_t)elapsed.tv_sec * 1000000 + elapsed.tv_nsec / 1000;
+
+    bucket = usec ? 64 - __builtin_clzll(usec) : 0;
+    if (bucket >= PLUGIN_LATENCY_BUCKETS) {
+        bucket = PLUGIN_LATENCY_BUCKETS - 1;
+    }
+    __atomic_add_fetch(&stats->calls, 1, __ATOMIC_RELAXED);
+    if (rc) {
+        __atomic_add_fetch(&stats->failed, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_add_fetch(&stats->total_usec, usec, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->latency[bucket], 1, __ATOMIC_RELAXED);
+    max = __atomic_load_n(&stats->max_usec, __ATOMIC_RELAXED);
+    while (usec > max &&
+           !__atomic_compare_exchange_n(&stats->max_usec, &max, usec, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+
+    threshold = config_get_plugin_slow_threshold();
+    if (threshold > 0 && usec >= (uint64_t)threshold * 1000) {
+        uint64_t connid = 0;
+        int32_t opid = 0;
+
+        slapi_pblock_get(pb, SLAPI_CONN_ID, &connid);
+        slapi_pblock_get(pb, SLAPI_OPERATION_ID, &opid);
+        slapi_log_err(SLAPI_LOG_WARNING, "plugin_call_plugin_func",
+                      "conn=%" PRIu64 " op=%d - Plugin \"%s\" %s callback took %" PRIu64 " usec (rc=%d)\n",
+                      connid, opid, plugin->plg_name ? plugin->plg_name : "noname",
+                      plugin_callback_name(stats->operation), usec, rc);
+    }
+}
+
+/* Return the upper bound of the latency of the given fraction of the calls */
+static uint64_t
+plugin_call_stats_percentile(const uint64_t *latency, uint64_t calls, uint64_t max, double fraction)
+{
+    uint64_t rank = (uint64_t)(calls * fraction);
+    uint64_t seen = 0;
+
+    for (size_t i = 0; i < PLUGIN_LATENCY_BUCKETS - 1; i++) {
+        seen += latency[i];
+        if (seen > rank) {
+            return (uint64_t)1 << i;
+        }
+    }
+    return max;
+}
+
+/*
+ * Add the statistics of the callbacks of a plugin and of the plugin
+ * functions it registered to its monitor entry:
+ *
+ *   totalcalls          calls of all the callbacks
+ *   totalfailedcalls    calls that returned an error
+ *   totalcallusec       time spent in the callbacks
+ *   callstats           one value per callback of each plugin function:
+ *     plugin="<name>" callback="<callback>" calls="<n>" failed="<n>"
+ *     totalusec="<usec>" maxusec="<usec>" p50usec="<usec>" p99usec="<usec>"
+ *     latency="<n0>,<n1>,...,<n23>"
+ *
+ * The percentiles are the upper bound of the histogram bucket, and the
+ * bucket i of latency counts the calls shorter than 2^i microseconds.
+ */
+static void
+plugin_call_stats_to_entry(struct slapdplugin *main_plugin, Slapi_Entry *e)
+{
+    uint64_t total_calls = 0;
+    uint64_t total_failed = 0;
+    uint64_t total_usec = 0;
+
+    for (int type = 0; type < PLUGIN_LIST_GLOBAL_MAX; type++) {
+        for (struct slapdplugin *p = global_plugin_list[type]; p; p = p->plg_next) {
+            if (!plugin_cmp_plugins(main_plugin, p)) {
+                continue;
+            }
+            for (plugin_call_stats *stats = p->plg_call_stats; stats; stats = stats->next) {
+                uint64_t latency[PLUGIN_LATENCY_BUCKETS];
+                uint64_t calls = __atomic_load_n(&stats->calls, __ATOMIC_RELAXED);
+                uint64_t failed = __atomic_load_n(&stats->failed, __ATOMIC_RELAXED);
+                uint64_t usec = __atomic_load_n(&stats->total_usec, __ATOMIC_RELAXED);
+                uint64_t max = __atomic_load_n(&stats->max_usec, __ATOMIC_RELAXED);
+                uint64_t hcalls = 0;
+                char histo[PLUGIN_LATENCY_BUCKETS * 21];
+                size_t len = 0;
+                char *value;
+
+                for (size_t i = 0; i < PLUGIN_LATENCY_BUCKETS; i++) {
+                    latency[i] = __atomic_load_n(&stats->latency[i], __ATOMIC_RELAXED);
+                    hcalls += latency[i];
+                    len += snprintf(histo + len, sizeof(histo) - len, "%s%" PRIu64,
+                                    i ? "," : "", latency[i]);
+                }
+                value = slapi_ch_smprintf("plugin=\"%s\" callback=\"%s\" calls=\"%" PRIu64 "\" failed=\"%" PRIu64
+                                          "\" totalusec=\"%" PRIu64 "\" maxusec=\"%" PRIu64 "\" p50usec=\"%" PRIu64
+                                          "\" p99usec=\"%" PRIu64 "\" latency=\"%s\"",
+                                          p->plg_name ? p->plg_name : "noname",
+                                          plugin_callback_name(stats->operation),
+                                          calls, failed, usec, max,
+                                          plugin_call_stats_percentile(latency, hcalls, max, 0.50),
+                                          plugin_call_stats_percentile(latency, hcalls, max, 0.99),
+                                          histo);
+                slapi_entry_add_string(e, "callstats", value);
+                slapi_ch_free_string(&value);
+
+                total_calls += calls;
+                total_failed += failed;
+                total_usec += usec;
+            }
+        }
+    }
+    slapi_entry_attr_set_ulong(e, "totalcalls", total_calls);
+    slapi_entry_attr_set_ulong(e, "totalfailedcalls", total_failed);
+    slapi_entry_attr_set_ulong(e, "totalcallusec", total_usec);
+}
+
+/*
+ * DN of the monitor entry of a plugin.  The plugin name is escaped as an RDN
+ * value, it may contain characters such as ',' or '+'.  Returns NULL if the
+ * RDN can not be built.
+ */
+static char *
+plugin_monitor_dn(struct slapdplugin *plugin)
+{
+    LDAPAVA ava = {0};
+    LDAPAVA *rdn[2] = {&ava, NULL};
+    char *rdnstr = NULL;
+    char *dn;
+
+    if (plugin->plg_name == NULL) {
+        return NULL;
+    }
+    ava.la_attr.bv_val = "cn";
+    ava.la_attr.bv_len = 2;
+    ava.la_value.bv_val = plugin->plg_name;
+    ava.la_value.bv_len = strlen(plugin->plg_name);
+    ava.la_flags = LDAP_AVA_STRING;
+    if (ldap_rdn2str(rdn, &rdnstr, LDAP_DN_FORMAT_LDAPV3) != LDAP_SUCCESS || rdnstr == NULL) {
+        slapi_log_err(SLAPI_LOG_ERR, "plugin_monitor_dn",
+                      "Failed to build the monitor RDN of plugin %s\n", plugin->plg_name);
+        return NULL;
+    }
+    dn = slapi_ch_smprintf("%s,%s", rdnstr, PLUGIN_MONITOR_BASE_DN);
+    ldap_memfree(rdnstr);
+    return dn;
+}
+
+/*
+ * Add the monitor entry of a started plugin, if the plugin or the plugin
+ * functions it registered implement operation callbacks.
+ */
+static void
+plugin_monitor_add(struct slapdplugin *main_plugin)
+{
+    Slapi_PBlock *pb;
+    Slapi_Entry *e;
+    Slapi_DN *sdn;
+    char *dn;
+    int dont_write = 1;
+    int has_stats = 0;
+    int rc = 0;
+
+    for (int type = 0; type < PLUGIN_LIST_GLOBAL_MAX && !has_stats; type++) {
+        for (struct slapdplugin *p = global_plugin_list[type]; p && !has_stats; p = p->plg_next) {
+            has_stats = p->plg_call_stats && plugin_cmp_plugins(main_plugin, p);
+        }
+    }
+    if (!has_stats || (dn = plugin_monitor_dn(main_plugin)) == NULL) {
+        return;
+    }
+
+    e = slapi_entry_alloc();
+    /* this function consumes dn */
+    sdn = slapi_sdn_new_dn_passin(dn);
+    slapi_entry_init_ext(e, sdn, NULL);
+    slapi_sdn_free(&sdn);
+    slapi_entry_add_string(e, "objectclass", "top");
+    slapi_entry_add_string(e, "objectclass", "extensibleObject");
+    slapi_entry_add_rdn_values(e);
+
+    pb = slapi_pblock_new();
+    slapi_add_entry_internal_set_pb(pb, e, NULL, plugin_get_default_component_id(), 0);
+    slapi_pblock_set(pb, SLAPI_DSE_DONT_WRITE_WHEN_ADDING, (void *)&dont_write);
+    slapi_add_internal_pb(pb);
+    slapi_pblock_get(pb, SLAPI_PLUGIN_INTOP_RESULT, &rc);
+    if (rc != LDAP_SUCCESS && rc != LDAP_ALREADY_EXISTS) {
+        slapi_log_err(SLAPI_LOG_PLUGIN, "plugin_monitor_add",
+                      "Failed to add the monitor entry of plugin %s (%d)\n",
+                      main_plugin->plg_name, rc);
+    }
+    slapi_pblock_destroy(pb);
+}
+
+static void
+plugin_monitor_delete(const char *dn)
+{
+    Slapi_PBlock *pb = slapi_pblock_new();
+
+    slapi_delete_internal_set_pb(pb, dn, NULL, NULL, plugin_get_default_component_id(), 0);
+    slapi_delete_internal_pb(pb);
+    slapi_pblock_destroy(pb);
+}
+
+/*
+ * Search callback of the monitor entries of the plugins
+ */
+int32_t
+plugin_monitor_info(Slapi_PBlock *pb __attribute__((unused)),
+                    Slapi_Entry *e,
+                    Slapi_Entry *entryAfter __attribute__((unused)),
+                    int *returncode,
+                    char *returntext __attribute__((unused)),
+                    void *arg __attribute__((unused)))
+{
+    const Slapi_DN *sdn = slapi_entry_get_sdn_const(e);
+    int locked = slapi_td_get_plugin_locked();
+
+    if (!locked) {
+        slapi_rwlock_rdlock(global_rwlock);
+    }
+    for (int type = 0; type < PLUGIN_LIST_GLOBAL_MAX; type++) {
+        for (struct slapdplugin *p = global_plugin_list[type]; p; p = p->plg_next) {
+            Slapi_DN *monitor_sdn;
+            char *monitor_dn;
+            int found;
+
+            if (p->plg_group || p->plg_dn == NULL || (monitor_dn = plugin_monitor_dn(p)) == NULL) {
+                continue;
+            }
+            monitor_sdn = slapi_sdn_new_dn_passin(monitor_dn);
+            found = (slapi_sdn_compare(monitor_sdn, sdn) == 0);
+            slapi_sdn_free(&monitor_sdn);
+            if (found) {
+                plugin_call_stats_to_entry(p, e);
+                goto done;
+            }
+        }
+    }
+done:
+    if (!locked) {
+        slapi_rwlock_unlock(global_rwlock);
+    }
+
+    *returncode = LDAP_SUCCESS;
+    return SLAPI_DSE_CALLBACK_OK;
+}
+
+/*
+ * Call the function of one plugin. Returns non-zero if the plugins that
+ * follow in the list must not be called.
+ */
+static int
+plugin_call_plugin_func(struct slapdplugin *plugin, int32_t (*func)(Slapi_PBlock *), int operation, Slapi_PBlock *pb, int count, int *return_value, plugin_call_stats *stats)
+{
+    char *n = plugin->plg_name;
+    int rc = 0;
+
+    slapi_log_err(SLAPI_LOG_TRACE, "plugin_call_func",
+                  "Calling plugin '%s' #%d type %d\n",
+                  (n == NULL ? "noname" : n), count, operation);
+    /* counters_to_errors_log("before plugin call"); */
+
+    /*
+     * Only call the plugin function if:
+     *
+     *  [1]  The plugin is started, and we are NOT trying to restart it.
+     *  [2]  The plugin is started, and we are stopping it.
+     *  [3]  The plugin is stopped, and we are trying to start it.
+     *
+     *  This frees up the plugins from having to check if the plugin is already started when
+     *  calling the START and CLOSE functions - prevents double starts and stops.
+     */
+    slapi_plugin_op_started(plugin);
+    if ((SLAPI_PLUGIN_START_FN == operation && !plugin->plg_started) || /* Starting it up for the first time */
+        (SLAPI_PLUGIN_CLOSE_FN == operation && !plugin->plg_stopped) || /* Shutting down, plugin has been stopped */
+        (SLAPI_PLUGIN_START_FN != operation && plugin->plg_started)) {  /* Started, and not trying to start again */
+        if (stats) {
+            struct timespec start;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            rc = func(pb);
+            plugin_call_stats_record(plugin, stats, pb, &start, rc);
+        } else {
+            rc = func(pb);
+        }
+    }
+    if (rc != 0) {
+        slapi_plugin_op_finished(plugin);
+        if (SLAPI_PLUGIN_PREOPERATION == plugin->plg_type ||
+            SLAPI_PLUGIN_INTERNAL_PREOPERATION == plugin->plg_type ||
+            SLAPI_PLUGIN_PREEXTOPERATION == plugin->plg_type ||
+            SLAPI_PLUGIN_START_FN == operation) {
+            /*
+             * We bail out of plugin processing for preop plugins
+             * that return a non-zero return code. This allows preop
+             * plugins to cause further preop processing to terminate, and
+             * causes the operation to be vetoed.
+             */
+            *return_value = rc;
+            return 1;
+        } else if (SLAPI_PLUGIN_BEPREOPERATION == plugin->plg_type ||
+                   SLAPI_PLUGIN_BETXNPREOPERATION == plugin->plg_type ||
+                   SLAPI_PLUGIN_BEPOSTOPERATION == plugin->plg_type ||
+                   SLAPI_PLUGIN_BETXNPOSTOPERATION == plugin->plg_type) {
+            /*
+             * respect fatal error SLAPI_PLUGIN_FAILURE (-1);
+             * should not OR it.
+             */
+            if (SLAPI_PLUGIN_FAILURE == rc) {
+                *return_value = rc;
+            } else if (SLAPI_PLUGIN_FAILURE != *return_value) {
+                /* OR the result into the return value
+                 * for be pre/postops */
+                *return_value |= rc;
+            }
+        }
+    } else {
+        if (SLAPI_PLUGIN_CLOSE_FN == operation) {
+            /* successfully stopped the plugin */
+            plugin->plg_stopped = 1;
+        }
+        slapi_plugin_op_finished(plugin);
+    }
+    /* counters_to_errors_log("after plugin call"); */
+
+    return 0;
+}
+
 /*
  * Return codes:
  * - For preoperation plugins, returns the return code passed back from the first
@@ -1959,7 +2459,6 @@ static int
 plugin_call_func(struct slapdplugin *list, int operation, Slapi_PBlock *pb, int call_one)
 {
     /* Invoke the operation on the plugins that are registered for the subtree effected by the operation. */
-    int rc;
     int return_value = 0;
     int count = 0;
 
@@ -1972,65 +2471,9 @@ plugin_call_func(struct slapdplugin *list, int operation, Slapi_PBlock *pb, int
             func != NULL &&
             plugin_invoke_plugin_pb(list, operation, pb) &&
             list->plg_closed == 0) {
-            char *n = list->plg_name;
-
-            slapi_log_err(SLAPI_LOG_TRACE, "plugin_call_func",
-                          "Calling plugin '%s' #%d type %d\n",
-                          (n == NULL ? "noname" : n), count, operation);
-            /* counters_to_errors_log("before plugin call"); */
-
-            /*
-             * Only call the plugin function if:
-             *
-             *  [1]  The plugin is started, and we are NOT trying to restart it.
-             *  [2]  The plugin is started, and we are stopping it.
-             *  [3]  The plugin is stopped, and we are trying to start it.
-             *
-             *  This frees up the plugins from having to check if the plugin is already started when
-             *  calling the START and CLOSE functions - prevents double starts and stops.
-             */
-            slapi_plugin_op_started(list);
-            if (((SLAPI_PLUGIN_START_FN == operation && !list->plg_started) || /* Starting it up for the first time */
-                 (SLAPI_PLUGIN_CLOSE_FN == operation && !list->plg_stopped) || /* Shutting down, plugin has been stopped */
-                 (SLAPI_PLUGIN_START_FN != operation && list->plg_started)) && /* Started, and not trying to start again */
-                (rc = func(pb)) != 0) {
-                slapi_plugin_op_finished(list);
-                if (SLAPI_PLUGIN_PREOPERATION == list->plg_type ||
-                    SLAPI_PLUGIN_INTERNAL_PREOPERATION == list->plg_type ||
-                    SLAPI_PLUGIN_PREEXTOPERATION == list->plg_type ||
-                    SLAPI_PLUGIN_START_FN == operation) {
-                    /*
-                     * We bail out of plugin processing for preop plugins
-                     * that return a non-zero return code. This allows preop
-                     * plugins to cause further preop processing to terminate, and
-                     * causes the operation to be vetoed.
-                     */
-                    return_value = rc;
-                    break;
-                } else if (SLAPI_PLUGIN_BEPREOPERATION == list->plg_type ||
-                           SLAPI_PLUGIN_BETXNPREOPERATION == list->plg_type ||
-                           SLAPI_PLUGIN_BEPOSTOPERATION == list->plg_type ||
-                           SLAPI_PLUGIN_BETXNPOSTOPERATION == list->plg_type) {
-                    /*
-                     * respect fatal error SLAPI_PLUGIN_FAILURE (-1);
-                     * should not OR it.
-                     */
-                    if (SLAPI_PLUGIN_FAILURE == rc) {
-                        return_value = rc;
-                    } else if (SLAPI_PLUGIN_FAILURE != return_value) {
-                        /* OR the result into the return value
-                         * for be pre/postops */
-                        return_value |= rc;
-                    }
-                }
-            } else {
-                if (SLAPI_PLUGIN_CLOSE_FN == operation) {
-                    /* successfully stopped the plugin */
-                    list->plg_stopped = 1;
-                }
-                slapi_plugin_op_finished(list);
+            if (plugin_call_plugin_func(list, func, operation, pb, count, &return_value, NULL)) {
+                break;
             }
-            /* counters_to_errors_log("after plugin call"); */
         }
 
         count++;
@@ -2042,6 +2485,194 @@ plugin_call_func(struct slapdplugin *list, int operation, Slapi_PBlock *pb, int
     return (return_value);
 }
 
+/*
+ * Dispatch tables of the operation callbacks.
+ *
+ * For each callback called by plugin_call_plugins(), the table holds, in
+ * calling order, the plugins of its list that implement the callback and
+ * their function, so an operation no longer walks the whole list and looks
+ * the function up in every plugin. The plugins invoked for any target (the
+ * default configuration) are flagged so that their scope is not evaluated
+ * for each call.
+ * The tables are rebuilt when a plugin is added, started or removed. The
+ * plugins are started by plugin_dependency_startall() without the global
+ * plugin write lock while other threads call the plugins, so a rebuild
+ * publishes a new set of tables and retires the old one through the epochs:
+ * the callers walk the tables in an epoch section.
+ */
+#define PLUGIN_DISPATCH_FIRST SLAPI_PLUGIN_PRE_BIND_FN
+#define PLUGIN_DISPATCH_LAST SLAPI_PLUGIN_BE_TXN_POST_DELETE_FN
+#define PLUGIN_DISPATCH_MAX (PLUGIN_DISPATCH_LAST - PLUGIN_DISPATCH_FIRST + 1)
+
+typedef struct plugin_dispatch_entry
+{
+    struct slapdplugin *plugin;
+    int32_t (*func)(Slapi_PBlock *);
+    PRBool any_target; /* invoked for all the non bind operations */
+    PRBool any_bind;   /* invoked for all the bind operations */
+    plugin_call_stats *stats;
+} plugin_dispatch_entry;
+
+typedef struct plugin_dispatch_table
+{
+    size_t count;
+    plugin_dispatch_entry *entries;
+} plugin_dispatch_table;
+
+typedef struct plugin_dispatch_set
+{
+    plugin_dispatch_table tables[PLUGIN_DISPATCH_MAX];
+} plugin_dispatch_set;
+
+static plugin_dispatch_set *global_plugin_dispatch;
+/* serializes the rebuilds */
+static pthread_mutex_t global_plugin_dispatch_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static PRBool
+ptd_is_empty(const PluginTargetData *ptd)
+{
+    for (int i = 0; i < PLGC_DATA_MAX; i++) {
+        if (ptd_is_special_data_set(ptd, i)) {
+            return PR_FALSE;
+        }
+    }
+    return ptd_get_subtree_count(ptd) == 0;
+}
+
+static void
+plugin_dispatch_set_free(void *obj)
+{
+    plugin_dispatch_set *set = (plugin_dispatch_set *)obj;
+
+    for (size_t i = 0; i < PLUGIN_DISPATCH_MAX; i++) {
+        slapi_ch_free((void **)&set->tables[i].entries);
+    }
+    slapi_ch_free((void **)&set);
+}
+
+static void
+plugin_dispatch_rebuild(void)
+{
+    Slapi_PBlock *pb;
+    plugin_dispatch_set *set, *old;
+
+    pthread_mutex_lock(&global_plugin_dispatch_lock);
+    pb = slapi_pblock_new();
+    set = (plugin_dispatch_set *)slapi_ch_calloc(1, sizeof(plugin_dispatch_set));
+
+    for (size_t i = 0; i < PLUGIN_DISPATCH_MAX; i++) {
+        plugin_dispatch_table *table = &set->tables[i];
+        int operation = PLUGIN_DISPATCH_FIRST + i;
+        struct slapdplugin *list;
+        int always;
+        int list_number = plugin_get_callback_list(operation, &always);
+        size_t count = 0;
+
+        if (list_number == -1) {
+            continue;
+        }
+
+        for (list = global_plugin_list[list_number]; list != NULL; list = list->plg_next) {
+            count++;
+        }
+        if (count == 0) {
+            continue;
+        }
+        table->entries = (plugin_dispatch_entry *)slapi_ch_calloc(count, sizeof(plugin_dispatch_entry));
+
+        for (list = global_plugin_list[list_number]; list != NULL; list = list->plg_next) {
+            int32_t (*func)(Slapi_PBlock *) = NULL;
+            struct pluginconfig *config;
+            plugin_dispatch_entry *entry;
+
+            slapi_pblock_set(pb, SLAPI_PLUGIN, list);
+            if (slapi_pblock_get(pb, operation, &func) != 0 || func == NULL) {
+                continue;
+            }
+            /* The result handlers are stored in the plugin, set them once */
+            set_db_default_result_handlers(pb);
+
+            config = plugin_get_config(list);
+            entry = &table->entries[table->count++];
+            entry->plugin = list;
+            entry->func = func;
+            entry->stats = plugin_call_stats_get(list, operation);
+            if (config->plgc_invoke_for_replop) {
+                entry->any_target = plugin_is_global(&config->plgc_target_subtrees) &&
+                                    ptd_is_empty(&config->plgc_excluded_target_subtrees);
+                entry->any_bind = plugin_is_global(&config->plgc_bind_subtrees) &&
+                                  ptd_is_empty(&config->plgc_excluded_bind_subtrees);
+            }
+        }
+    }
+
+    slapi_pblock_set(pb, SLAPI_PLUGIN, NULL);
+    slapi_pblock_destroy(pb);
+
+    old = __atomic_exchange_n(&global_plugin_dispatch, set, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&global_plugin_dispatch_lock);
+
+    if (old) {
+        epoch_retire(old, plugin_dispatch_set_free);
+    }
+}
+
+/*
+ * Call an operation callback on the plugins of its dispatch table, with the
+ * return codes of plugin_call_func()
+ *
+ * A thread without thread data (the tools) can not enter an epoch section,
+ * it is then the only thread calling the plugins and rebuilding the tables.
+ */
+static int
+plugin_call_dispatch(int operation, Slapi_PBlock *pb)
+{
+    plugin_dispatch_set *set;
+    plugin_dispatch_table *table;
+    Operation *pb_op = NULL;
+    PRBool bindop = PR_FALSE;
+    int return_value = 0;
+    int32_t in_epoch;
+
+    PR_ASSERT(operation >= PLUGIN_DISPATCH_FIRST && operation <= PLUGIN_DISPATCH_LAST);
+    in_epoch = epoch_enter();
+    set = __atomic_load_n(&global_plugin_dispatch, __ATOMIC_SEQ_CST);
+    if (set == NULL) {
+        if (in_epoch) {
+            epoch_leave();
+        }
+        return 0;
+    }
+    table = &set->tables[operation - PLUGIN_DISPATCH_FIRST];
+
+    slapi_pblock_get(pb, SLAPI_OPERATION, &pb_op);
+    if (pb_op) {
+        unsigned long op_type = operation_get_type(pb_op);
+        bindop = (op_type == SLAPI_OPERATION_BIND || op_type == SLAPI_OPERATION_UNBIND);
+    }
+
+    for (size_t i = 0; i < table->count; i++) {
+        plugin_dispatch_entry *entry = &table->entries[i];
+
+        if (entry->plugin->plg_closed) {
+            continue;
+        }
+        slapi_pblock_set(pb, SLAPI_PLUGIN, entry->plugin);
+        if (!(pb_op && (bindop ? entry->any_bind : entry->any_target)) &&
+            !plugin_invoke_plugin_pb(entry->plugin, operation, pb)) {
+            continue;
+        }
+        if (plugin_call_plugin_func(entry->plugin, entry->func, operation, pb, (int)i, &return_value, entry->stats)) {
+            break;
+        }
+    }
+    if (in_epoch) {
+        epoch_leave();
+    }
+
+    return (return_value);
+}
+
 int
 slapi_berval_cmp(const struct berval *L, const struct berval *R) /* JCM - This does not belong here. But, where should it go? */
 {
@@ -2672,6 +3303,7 @@ plugin_free(struct slapdplugin *plugin)
     }
     release_componentid(plugin->plg_identity);
     slapi_counter_destroy(&plugin->plg_op_counter);
+    plugin_call_stats_free(plugin);
     if (!plugin->plg_group) {
         plugin_config_cleanup(&plugin->plg_conf);
     }
@@ -3402,6 +4034,9 @@ plugin_remove_plugins(struct slapdplugin *plugin_entry, char *plugin_type __attr
                      * Plugin is still busy, and we might be blocking it
                      * by holding global plugin lock so return for now.
                      */
+                    if (removed) {
+                        plugin_dispatch_rebuild();
+                    }
                     return PLUGIN_BUSY;
                 }
                 Slapi_PBlock *pb = slapi_pblock_new();
@@ -3430,6 +4065,7 @@ plugin_remove_plugins(struct slapdplugin *plugin_entry, char *plugin_type __attr
         }
     }
     if (removed) {
+        plugin_dispatch_rebuild();
         /*
          * Now free the marked plugins, we could not do this earlier because
          * we also needed to check for plugins registered functions.  As both
@@ -3450,6 +4086,7 @@ plugin_delete(Slapi_Entry *plugin_entry, char *returntext, int locked)
     struct slapdplugin **plugin_list = NULL;
     struct slapdplugin *plugin = NULL;
     const char *plugin_dn = slapi_entry_get_dn_const(plugin_entry);
+    char *monitor_dn = NULL;
     char *value = NULL;
     int removed = PLUGIN_BUSY;
     int type = 0;
@@ -3518,6 +4155,8 @@ plugin_delete(Slapi_Entry *plugin_entry, char *returntext, int locked)
                         rc = -1;
                         break;
                     }
+                    slapi_ch_free_string(&monitor_dn);
+                    monitor_dn = plugin_monitor_dn(plugin);
                     removed = plugin_remove_plugins(plugin, value);
                     break;
                 }
@@ -3541,6 +4180,11 @@ done:
         rc = -1;
     }
 
+    if (removed == PLUGIN_REMOVED && monitor_dn) {
+        plugin_monitor_delete(monitor_dn);
+    }
+    slapi_ch_free_string(&monitor_dn);
+
     return rc;
 }
 
@@ -18,6 +18,9 @@
 
 #include "slap.h"
 
+/* number of acis with timeofday or dayofweek bind rules */
+static int32_t acl_time_rules = 0;
+
 static int
 acl_default_access(Slapi_PBlock *pb, Slapi_Entry *e, int access)
 {
@@ -223,3 +226,26 @@ slapi_acl_verify_aci_syntax(Slapi_PBlock *pb, Slapi_Entry *e, char **errbuf)
 {
     return (plugin_call_acl_verify_syntax(pb, e, errbuf));
 }
+
+/*
+ * Called by the access control plugin for each aci with timeofday or
+ * dayofweek bind rules it loads or drops: the rights granted by those
+ * change with the time, results checked for a requestor can not be kept.
+ */
+void
+plugin_acl_time_rule_add(void)
+{
+    slapi_atomic_incr_32(&acl_time_rules, __ATOMIC_RELEASE);
+}
+
+void
+plugin_acl_time_rule_remove(void)
+{
+    slapi_atomic_decr_32(&acl_time_rules, __ATOMIC_RELEASE);
+}
+
+PRBool
+plugin_acl_has_time_rules(void)
+{
+    return slapi_atomic_load_32(&acl_time_rules, __ATOMIC_ACQUIRE) > 0 ? PR_TRUE : PR_FALSE;
+}
@@ -67,6 +67,7 @@ const char *attr_get_syntax_oid(const Slapi_Attr *attr);
  * attrlist.c
  */
 
+struct attrlist_index;
 void attrlist_free(Slapi_Attr *alist);
 int attrlist_find_or_create(Slapi_Attr **alist, const char *type, Slapi_Attr ***a);
 int attrlist_find_or_create_locking_optional(Slapi_Attr **alist, const char *type, Slapi_Attr ***a, PRBool use_lock);
@@ -75,6 +76,9 @@ void attrlist_merge(Slapi_Attr **alist, const char *type, struct berval **vals);
 void attrlist_merge_valuearray(Slapi_Attr **alist, const char *type, Slapi_Value **vals);
 int attrlist_delete(Slapi_Attr **attrs, const char *type);
 Slapi_Attr *attrlist_find(Slapi_Attr *a, const char *type);
+Slapi_Attr *attrlist_index_find(struct attrlist_index **index, Slapi_Attr *alist, const char *type);
+void attrlist_index_free(struct attrlist_index **index);
+void attrlist_type_changed(void);
 Slapi_Attr *attrlist_remove(Slapi_Attr **attrs, const char *type);
 void attrlist_add(Slapi_Attr **attrs, Slapi_Attr *a);
 int attrlist_count_subtypes(Slapi_Attr *a, const char *type);
@@ -116,6 +120,9 @@ void attr_syntax_return(struct asyntaxinfo *asi);
 void attr_syntax_return_locking_optional(struct asyntaxinfo *asi, PRBool use_lock);
 void attr_syntax_delete_all(void);
 void attr_syntax_delete_all_for_schemareload(unsigned long flag);
+void attr_syntax_snapshot_publish(void);
+int attr_syntax_get_ref(const char *name, int with_default, asyntaxref *ref, char **normalized);
+int attr_syntax_get_ref_by_id(int32_t id, asyntaxref *ref, char **name);
 
 /*
  * value.c
@@ -169,7 +176,7 @@ int valuearray_subtract_bvalues(Slapi_Value **va, struct berval **bvals);
 /*
  * ava.c
  */
-int get_ava(BerElement *ber, struct ava *ava);
+int get_ava(BerElement *ber, struct ava *ava, Slapi_Arena *arena);
 void ava_done(struct ava *ava);
 int rdn2ava(char *rdn, struct ava *ava);
 
@@ -414,6 +421,10 @@ int config_set_unhashed_pw_switch(const char *attrname, char *value, char *error
 int config_set_return_orig_type_switch(const char *attrname, char *value, char *errorbuf, int apply);
 int config_set_sasl_maxbufsize(const char *attrname, char *value, char *errorbuf, int apply);
 int config_set_listen_backlog_size(const char *attrname, char *value, char *errorbuf, int apply);
+int config_set_plugin_slow_threshold(const char *attrname, char *value, char *errorbuf, int apply);
+int config_set_result_writer_threads(const char *attrname, char *value, char *errorbuf, int apply);
+int config_set_conn_output_max_bytes(const char *attrname, char *value, char *errorbuf, int apply);
+int config_set_accept_threads(const char *attrname, char *value, char *errorbuf, int apply);
 int config_set_ignore_time_skew(const char *attrname, char *value, char *errorbuf, int apply);
 int config_set_global_backend_lock(const char *attrname, char *value, char *errorbuf, int apply);
 #if defined(LINUX)
@@ -607,6 +618,10 @@ int config_get_plugin_logging(void);
 int config_set_connection_nocanon(const char *attrname, char *value, char *errorbuf, int apply);
 int config_set_plugin_logging(const char *attrname, char *value, char *errorbuf, int apply);
 int config_get_listen_backlog_size(void);
+int config_get_plugin_slow_threshold(void);
+int config_get_result_writer_threads(void);
+int config_get_conn_output_max_bytes(void);
+int config_get_accept_threads(void);
 int config_set_dynamic_plugins(const char *attrname, char *value, char *errorbuf, int apply);
 int config_get_dynamic_plugins(void);
 int config_set_cn_uses_dn_syntax_in_dns(const char *attrname, char *value, char *errorbuf, int apply);
@@ -727,7 +742,7 @@ void init_features(void);
 /*
  * filter.c
  */
-int get_filter(Connection *conn, BerElement *ber, int scope, struct slapi_filter **filt, char **fstr);
+int get_filter(Connection *conn, BerElement *ber, int scope, struct slapi_filter **filt, char **fstr, Slapi_Arena *arena);
 void filter_print(struct slapi_filter *f);
 void filter_normalize(struct slapi_filter *f);
 
@@ -850,7 +865,7 @@ int lock_fclose(FILE *fp, FILE *lfp);
 #define LDAP_DEBUG_ALL_LEVELS 0xFFFFFF
 
 #define LDAP_STAT_READ_INDEX  0x00000001  /*         1 */
-#define LDAP_STAT_FREE_1      0x00000002  /*         2 */
+#define LDAP_STAT_FILTER_PLAN 0x00000002  /*         2 */
 
 extern int slapd_ldap_debug;
 
@@ -1012,6 +1027,7 @@ int plugin_add(Slapi_Entry *entry, char *returntext, int locked);
 int plugin_delete(Slapi_Entry *entry, char *returntext, int locked);
 void plugin_update_dep_entries(Slapi_Entry *plugin_entry);
 int plugin_restart(Slapi_Entry *entryBefore, Slapi_Entry *entryAfter);
+int32_t plugin_monitor_info(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_Entry *entryAfter, int *returncode, char *returntext, void *arg);
 void plugin_op_all_finished(struct slapdplugin *p);
 void plugin_set_stopped(struct slapdplugin *p);
 void plugin_set_started(struct slapdplugin *p);
@@ -1232,6 +1248,7 @@ SECItem *slapd_pk11_ParamFromIV(CK_MECHANISM_TYPE type, SECItem *iv);
 PK11SymKey *slapd_pk11_PubUnwrapSymKey(SECKEYPrivateKey *wrappingKey, SECItem *wrappedKey, CK_MECHANISM_TYPE target, CK_ATTRIBUTE_TYPE operation, int keySize);
 unsigned slapd_SECKEY_PublicKeyStrength(SECKEYPublicKey *pubk);
 SECStatus slapd_pk11_Finalize(PK11Context *context);
+SECStatus slapd_pk11_DigestBegin(PK11Context *context);
 SECStatus slapd_pk11_DigestFinal(PK11Context *context, unsigned char *data, unsigned int *outLen, unsigned int length);
 void slapd_SECITEM_FreeItem(SECItem *zap, PRBool freeit);
 void slapd_pk11_DestroyPrivateKey(SECKEYPrivateKey *key);
@@ -1411,6 +1411,8 @@ send_specific_attrs(Slapi_Entry *e, char **attrs, Slapi_Operation *op, Slapi_PBl
     vattr_context *ctx;
     char **attrs_ext = NULL;
     char **my_searchattrs = NULL;
+    Slapi_Arena *arena = slapi_operation_get_arena(op);
+    Slapi_Arena_Mark mark;
 
     if (real_attrs_only == SLAPI_SEND_VATTR_FLAG_REALONLY) {
         vattr_flags = SLAPI_REALATTRS_ONLY;
@@ -1420,14 +1422,29 @@ send_specific_attrs(Slapi_Entry *e, char **attrs, Slapi_Operation *op, Slapi_PBl
             vattr_flags |= SLAPI_VIRTUALATTRS_ONLY;
     }
 
-    /* Create a copy of attrs with no duplicates */
+    /*
+     * Create a copy of attrs with no duplicates. It only lives for this
+     * entry: the arrays are taken from the operation arena, released at
+     * the end, and point to the strings of attrs and o_searchattrs.
+     */
+    slapi_arena_mark(arena, &mark);
     if (attrs) {
+        int n = 0;
+
+        for (i = 0; attrs[i]; i++)
+            ;
+        attrs_ext = (char **)slapi_arena_alloc(arena, (i + 1) * sizeof(char *));
+        my_searchattrs = (char **)slapi_arena_alloc(arena, (i + 1) * sizeof(char *));
         for (i = 0; attrs[i]; i++) {
+            attrs_ext[n] = NULL;
             if (!charray_inlist(attrs_ext, attrs[i])) {
-                slapi_ch_array_add(&attrs_ext, slapi_ch_strdup(attrs[i]));
-                slapi_ch_array_add(&my_searchattrs, slapi_ch_strdup(op->o_searchattrs[i]));
+                attrs_ext[n] = attrs[i];
+                my_searchattrs[n] = op->o_searchattrs[i];
+                n++;
             }
         }
+        attrs_ext[n] = NULL;
+        my_searchattrs[n] = NULL;
     }
     if (attrs_ext) {
         attrs = attrs_ext;
@@ -1458,7 +1475,7 @@ send_specific_attrs(Slapi_Entry *e, char **attrs, Slapi_Operation *op, Slapi_PBl
         }
         if (-1 != rc) {
             /* Means that some error happened */
-            return rc;
+            goto exit;
         } else {
             rc = 0; /* Means that we just didn't recognize this as a computed attr */
         }
@@ -1527,8 +1544,7 @@ send_specific_attrs(Slapi_Entry *e, char **attrs, Slapi_Operation *op, Slapi_PBl
         }
     }
 exit:
-    slapi_ch_array_free(attrs_ext);
-    slapi_ch_array_free(my_searchattrs);
+    slapi_arena_release(arena, &mark);
     return rc;
 }
 
@@ -1946,6 +1962,7 @@ static struct slapi_note_map notemap[] = {
     {SLAPI_OP_NOTE_FULL_UNINDEXED, "A", "Fully Unindexed Filter"},
     {SLAPI_OP_NOTE_FILTER_INVALID, "F", "Filter Element Missing From Schema"},
     {SLAPI_OP_NOTE_MFA_AUTH, "M", "Multi-factor Authentication"},
+    {SLAPI_OP_NOTE_FILTER_PLANNED, "Q", "Filter Components Skipped By Planner"},
 };
 
 #define SLAPI_NOTEMAP_COUNT (sizeof(notemap) / sizeof(struct slapi_note_map))
@@ -2183,6 +2200,30 @@ log_op_stat(Slapi_PBlock *pb, uint64_t connid, int32_t op_id, int32_t op_interna
                     }
                 }
             }
+            if ((LDAP_STAT_FILTER_PLAN & config_get_statlog_level()) &&
+                op_stat->search_stat && op_stat->search_stat->filter_plan) {
+                if (log_format != LOG_FORMAT_DEFAULT) {
+                    /* JSON logging */
+                    slapd_log_pblock_init(&logpb, log_format, pb);
+                    logpb.conn_time = start_time;
+                    logpb.conn_id = connid;
+                    logpb.op_id = op_id;
+                    logpb.op_internal_id = internal_op ? op_internal_id : -1;
+                    logpb.op_nested_count = internal_op ? op_nested_count : -1;
+                    logpb.stat_plan = op_stat->search_stat->filter_plan;
+                    slapd_log_access_stat(&logpb);
+                } else if (internal_op) {
+                    slapi_log_stat(LDAP_STAT_FILTER_PLAN,
+                                   connid == 0 ? STAT_LOG_CONN_OP_FMT_INT_INT "STAT filter plan: %s\n":
+                                                 STAT_LOG_CONN_OP_FMT_EXT_INT "STAT filter plan: %s\n",
+                                   connid, op_id, op_internal_id, op_nested_count,
+                                   op_stat->search_stat->filter_plan);
+                } else {
+                    slapi_log_stat(LDAP_STAT_FILTER_PLAN,
+                                   "conn=%" PRIu64 " op=%d STAT filter plan: %s\n",
+                                   connid, op_id, op_stat->search_stat->filter_plan);
+                }
+            }
             break;
         case SLAPI_OPERATION_ABANDON:
             break;
@@ -0,0 +1,623 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * result_writer.c - send the results of the operations from writer threads
+ *
+ * A worker that sends a PDU writes what the socket accepts at once, and the
+ * rest is copied to the output queue of the connection. A small set of
+ * writer threads wait with epoll until the sockets of the queues can be
+ * written, so a client that reads slowly does not keep a worker until
+ * nsslapd-ioblocktimeout. The bytes queued per connection are limited by
+ * nsslapd-conn-output-max-bytes: above it the worker waits for the writer,
+ * at most nsslapd-ioblocktimeout, as it used to wait for the socket.
+ *
+ * co_lock serializes all the writes on the socket of a connection. It is
+ * taken after c_pdumutex and c_mutex, and a writer thread never takes
+ * another lock while it holds it, but the list lock of its writer. A non
+ * empty queue is always registered with its writer (EPOLLONESHOT) or being
+ * written by it.
+ *
+ * The time of the last progress of a queue is kept: a writer disconnects the
+ * clients that did not read anything for nsslapd-ioblocktimeout, as a worker
+ * used to when its write timed out. A closing connection is given the same
+ * time to receive the results queued before it was closed, such as the ones
+ * of a search followed by an unbind.
+ */
+
+#include "slap.h"
+#include "fe.h"
+
+#define RESULT_WRITER_EVENTS 64
+#define RESULT_WRITER_WAIT 1000 /* msec, to check the shutdown and the stalled outputs */
+
+typedef struct conn_output_buf
+{
+    struct conn_output_buf *ob_next;
+    size_t ob_len;
+    size_t ob_off; /* bytes already sent */
+    char ob_data[];
+} conn_output_buf;
+
+typedef struct result_writer
+{
+    int rw_epfd;
+    pthread_mutex_t rw_lock;         /* protects rw_outputs, taken after co_lock */
+    struct conn_output *rw_outputs;  /* outputs registered with this writer */
+} result_writer;
+
+struct conn_output
+{
+    pthread_mutex_t co_lock;
+    pthread_cond_t co_cv; /* the queue was written or dropped */
+    conn_output_buf *co_head;
+    conn_output_buf *co_tail;
+    uint64_t co_bytes;    /* bytes in the queue */
+    uint64_t co_progress; /* msec, last time the queue was filled from empty or written */
+    int co_fd;            /* descriptor registered with the writer, -1 if none */
+    int co_error;         /* a write failed, the output is dropped */
+    int co_closing;       /* the connection waits for the queue to be sent to close */
+    Connection *co_conn;
+    uint64_t co_connid;           /* connection the registration was made for */
+    result_writer *co_writer;     /* writer co_fd is registered with */
+    struct conn_output *co_next;  /* in the list of co_writer */
+    struct conn_output *co_prev;
+};
+
+static int32_t result_writer_num;
+#ifdef ENABLE_EPOLL
+static result_writer *result_writers;
+#endif /* ENABLE_EPOLL */
+
+int
+result_writer_enabled(void)
+{
+    return __atomic_load_n(&result_writer_num, __ATOMIC_ACQUIRE) > 0;
+}
+
+static uint64_t
+result_writer_now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/* Deadline of a wait of timeout msec on co_cv */
+static void
+conn_output_deadline(struct timespec *deadline, int32_t timeout)
+{
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += timeout / 1000;
+    deadline->tv_nsec += (timeout % 1000) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+void
+result_writer_conn_init(Connection *conn)
+{
+    struct conn_output *out = (struct conn_output *)slapi_ch_calloc(1, sizeof(struct conn_output));
+    pthread_condattr_t condattr;
+
+    pthread_mutex_init(&out->co_lock, NULL);
+    pthread_condattr_init(&condattr);
+    pthread_condattr_setclock(&condattr, CLOCK_MONOTONIC);
+    pthread_cond_init(&out->co_cv, &condattr);
+    pthread_condattr_destroy(&condattr);
+    out->co_fd = -1;
+    out->co_conn = conn;
+    conn->c_output = out;
+}
+
+/* The caller holds co_lock */
+static void
+conn_output_drop(struct conn_output *out)
+{
+    while (out->co_head) {
+        conn_output_buf *buf = out->co_head;
+        out->co_head = buf->ob_next;
+        slapi_ch_free((void **)&buf);
+    }
+    out->co_tail = NULL;
+    __atomic_store_n(&out->co_bytes, 0, __ATOMIC_RELAXED);
+    pthread_cond_broadcast(&out->co_cv);
+}
+
+/* Remove the output from its writer, the caller holds co_lock */
+static void
+conn_output_unregister(struct conn_output *out)
+{
+#ifdef ENABLE_EPOLL
+    result_writer *rw = out->co_writer;
+
+    if (rw) {
+        epoll_ctl(rw->rw_epfd, EPOLL_CTL_DEL, out->co_fd, NULL);
+        pthread_mutex_lock(&rw->rw_lock);
+        if (out->co_prev) {
+            out->co_prev->co_next = out->co_next;
+        } else {
+            rw->rw_outputs = out->co_next;
+        }
+        if (out->co_next) {
+            out->co_next->co_prev = out->co_prev;
+        }
+        pthread_mutex_unlock(&rw->rw_lock);
+        out->co_next = out->co_prev = NULL;
+        out->co_writer = NULL;
+    }
+#endif /* ENABLE_EPOLL */
+    out->co_fd = -1;
+}
+
+/*
+ * Release the output of a closed connection, before its descriptor is
+ * closed. The results still queued are sent first, such as the end of a
+ * search the client sent an unbind after, waiting at most ioblocktimeout.
+ * The caller holds c_mutex.
+ */
+void
+result_writer_conn_reset(Connection *conn)
+{
+    struct conn_output *out = conn->c_output;
+
+    if (out == NULL) {
+        return;
+    }
+    if (result_writer_drain(conn) < 0) {
+        slapi_log_err(SLAPI_LOG_CONNS, "result_writer_conn_reset",
+                      "Dropping %" PRIu64 " bytes of output of closed connection %" PRIu64 "\n",
+                      result_writer_pending(conn), conn->c_connid);
+    }
+    pthread_mutex_lock(&out->co_lock);
+    conn_output_unregister(out);
+    out->co_error = 0;
+    out->co_closing = 0;
+    conn_output_drop(out);
+    pthread_mutex_unlock(&out->co_lock);
+}
+
+/*
+ * Tells the ct list thread whether a closing connection still has results
+ * being sent, in which case its descriptor is closed later. The writer
+ * drops the output of a client that does not read it for ioblocktimeout.
+ */
+int
+result_writer_close_pending(Connection *conn)
+{
+    struct conn_output *out = conn->c_output;
+    int pending;
+
+    if (out == NULL || __atomic_load_n(&out->co_bytes, __ATOMIC_RELAXED) == 0 ||
+        slapi_is_shutting_down()) {
+        return 0;
+    }
+    pthread_mutex_lock(&out->co_lock);
+    pending = out->co_head != NULL && !out->co_error;
+    out->co_closing = pending;
+    pthread_mutex_unlock(&out->co_lock);
+
+    return pending;
+}
+
+void
+result_writer_conn_free(Connection *conn)
+{
+    struct conn_output *out = conn->c_output;
+
+    if (out == NULL) {
+        return;
+    }
+    conn_output_drop(out);
+    pthread_cond_destroy(&out->co_cv);
+    pthread_mutex_destroy(&out->co_lock);
+    slapi_ch_free((void **)&conn->c_output);
+}
+
+/* Bytes waiting to be sent, read without lock */
+uint64_t
+result_writer_pending(Connection *conn)
+{
+    return conn->c_output ? __atomic_load_n(&conn->c_output->co_bytes, __ATOMIC_RELAXED) : 0;
+}
+
+#ifdef ENABLE_EPOLL
+/*
+ * Write without blocking, returns the bytes sent or -1 on an error
+ * with the NSPR error set. The caller holds co_lock.
+ */
+static PRInt32
+conn_output_send(Connection *conn, const char *data, size_t len)
+{
+    size_t sent = 0;
+
+    while (sent < len) {
+        PRInt32 bytes = PR_Write(conn->c_prfd, data + sent, len - sent);
+        if (bytes > 0) {
+            sent += bytes;
+        } else if (bytes < 0 && SLAPD_PR_WOULD_BLOCK_ERROR(PR_GetError())) {
+            break;
+        } else {
+            if (bytes == 0) {
+                PR_SetError(PR_PIPE_ERROR, EPIPE);
+            }
+            return -1;
+        }
+    }
+    return (PRInt32)sent;
+}
+
+/* Ask the writer to send the queue, the caller holds co_lock */
+static int
+conn_output_arm(Connection *conn)
+{
+    struct conn_output *out = conn->c_output;
+    struct epoll_event event = {.events = EPOLLOUT | EPOLLONESHOT, .data.ptr = conn};
+
+    if (out->co_fd == -1) {
+        /* the writer is kept until the connection is closed */
+        result_writer *rw = &result_writers[(conn->c_ct_list + conn->c_ci) % result_writer_num];
+
+        out->co_fd = PR_FileDesc2NativeHandle(conn->c_prfd);
+        if (epoll_ctl(rw->rw_epfd, EPOLL_CTL_ADD, out->co_fd, &event) == 0) {
+            out->co_writer = rw;
+            out->co_connid = conn->c_connid;
+            pthread_mutex_lock(&rw->rw_lock);
+            out->co_prev = NULL;
+            out->co_next = rw->rw_outputs;
+            if (rw->rw_outputs) {
+                rw->rw_outputs->co_prev = out;
+            }
+            rw->rw_outputs = out;
+            pthread_mutex_unlock(&rw->rw_lock);
+            return 0;
+        }
+    } else if (epoll_ctl(out->co_writer->rw_epfd, EPOLL_CTL_MOD, out->co_fd, &event) == 0) {
+        return 0;
+    }
+    slapi_log_err(SLAPI_LOG_ERR, "conn_output_arm",
+                  "epoll_ctl() failed for connection %" PRIu64 ": %s\n",
+                  conn->c_connid, strerror(errno));
+    conn_output_unregister(out);
+    return -1;
+}
+#endif /* ENABLE_EPOLL */
+
+/*
+ * Wait on co_cv until the deadline (no deadline if timeout is 0).
+ * Returns -1 when the deadline passed or the server shuts down.
+ */
+static int
+conn_output_wait(struct conn_output *out, struct timespec *deadline, int32_t timeout)
+{
+    struct timespec now;
+    struct timespec until;
+
+    if (slapi_is_shutting_down()) {
+        return -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (timeout > 0 && (now.tv_sec > deadline->tv_sec ||
+                        (now.tv_sec == deadline->tv_sec && now.tv_nsec >= deadline->tv_nsec))) {
+        return -1;
+    }
+    /* wake up regularly to check the shutdown */
+    until = now;
+    until.tv_sec += RESULT_WRITER_WAIT / 1000;
+    if (timeout > 0 && (until.tv_sec > deadline->tv_sec ||
+                        (until.tv_sec == deadline->tv_sec && until.tv_nsec > deadline->tv_nsec))) {
+        until = *deadline;
+    }
+    pthread_cond_timedwait(&out->co_cv, &out->co_lock, &until);
+    return 0;
+}
+
+/*
+ * Send len bytes of a PDU on the connection, called from the sockbuf write
+ * function. Returns len once the bytes are sent or queued, -1 on an error
+ * with the NSPR error set.
+ */
+ber_slen_t
+result_writer_write(Connection *conn, void *buf, ber_len_t len)
+{
+#ifdef ENABLE_EPOLL
+    struct conn_output *out = conn->c_output;
+    uint64_t max_bytes = (uint64_t)config_get_conn_output_max_bytes();
+    int32_t timeout = conn->c_ioblocktimeout;
+    struct timespec deadline;
+    conn_output_buf *obuf;
+    PRInt32 sent = 0;
+
+    pthread_mutex_lock(&out->co_lock);
+    if (out->co_error) {
+        pthread_mutex_unlock(&out->co_lock);
+        PR_SetError(PR_PIPE_ERROR, EPIPE);
+        return -1;
+    }
+    if (out->co_head == NULL) {
+        /* nothing is waiting: the socket takes what it can now */
+        if ((sent = conn_output_send(conn, buf, len)) < 0) {
+            pthread_mutex_unlock(&out->co_lock);
+            return -1;
+        }
+        if ((ber_len_t)sent == len) {
+            pthread_mutex_unlock(&out->co_lock);
+            return len;
+        }
+    }
+
+    /* A PDU larger than the limit is accepted in an empty queue */
+    conn_output_deadline(&deadline, timeout);
+    while (out->co_bytes > 0 && out->co_bytes + (len - sent) > max_bytes && !out->co_error) {
+        if (conn_output_wait(out, &deadline, timeout) < 0) {
+            slapi_log_err(SLAPI_LOG_CONNS, "result_writer_write",
+                          "Output of connection %" PRIu64 " is still over %" PRIu64 " bytes after ioblocktimeout\n",
+                          conn->c_connid, max_bytes);
+            pthread_mutex_unlock(&out->co_lock);
+            PR_SetError(PR_IO_TIMEOUT_ERROR, EAGAIN);
+            return -1;
+        }
+    }
+    if (out->co_error) {
+        pthread_mutex_unlock(&out->co_lock);
+        PR_SetError(PR_PIPE_ERROR, EPIPE);
+        return -1;
+    }
+
+    obuf = (conn_output_buf *)slapi_ch_malloc(sizeof(conn_output_buf) + len - sent);
+    obuf->ob_next = NULL;
+    obuf->ob_len = len - sent;
+    obuf->ob_off = 0;
+    memcpy(obuf->ob_data, (char *)buf + sent, obuf->ob_len);
+    if (out->co_tail) {
+        out->co_tail->ob_next = obuf;
+    } else {
+        out->co_head = obuf;
+        __atomic_store_n(&out->co_progress, result_writer_now(), __ATOMIC_RELAXED);
+        if (conn_output_arm(conn) < 0) {
+            out->co_head = NULL;
+            slapi_ch_free((void **)&obuf);
+            pthread_mutex_unlock(&out->co_lock);
+            PR_SetError(PR_IO_ERROR, errno);
+            return -1;
+        }
+    }
+    out->co_tail = obuf;
+    __atomic_add_fetch(&out->co_bytes, obuf->ob_len, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&out->co_lock);
+
+    return len;
+#else  /* !ENABLE_EPOLL */
+    PR_SetError(PR_NOT_IMPLEMENTED_ERROR, 0);
+    return -1;
+#endif /* ENABLE_EPOLL */
+}
+
+/*
+ * Wait until the queued output is sent, before the IO layers of the
+ * connection change. The caller holds c_mutex.
+ */
+int
+result_writer_drain(Connection *conn)
+{
+    struct conn_output *out = conn->c_output;
+    int32_t timeout = conn->c_ioblocktimeout;
+    struct timespec deadline;
+    int rc = 0;
+
+    if (out == NULL || __atomic_load_n(&out->co_bytes, __ATOMIC_RELAXED) == 0) {
+        return 0;
+    }
+    conn_output_deadline(&deadline, timeout);
+    pthread_mutex_lock(&out->co_lock);
+    while (out->co_head && !out->co_error) {
+        if (conn_output_wait(out, &deadline, timeout) < 0) {
+            rc = -1;
+            break;
+        }
+    }
+    if (out->co_error) {
+        rc = -1;
+    }
+    pthread_mutex_unlock(&out->co_lock);
+
+    return rc;
+}
+
+#ifdef ENABLE_EPOLL
+/* Send the queue of a connection that can be written */
+static void
+result_writer_flush(Connection *conn)
+{
+    struct conn_output *out = conn->c_output;
+    PRErrorCode prerr = 0;
+    uint64_t connid = conn->c_connid;
+    int failed = 0;
+    int closed = 0;
+
+    pthread_mutex_lock(&out->co_lock);
+    while (out->co_head) {
+        conn_output_buf *obuf = out->co_head;
+        PRInt32 sent = conn_output_send(conn, obuf->ob_data + obuf->ob_off, obuf->ob_len - obuf->ob_off);
+
+        if (sent < 0) {
+            prerr = PR_GetError();
+            slapi_log_err(SLAPI_LOG_CONNS, "result_writer_flush",
+                          "Failed to send the output of connection %" PRIu64 ", " SLAPI_COMPONENT_NAME_NSPR " error %d (%s)\n",
+                          connid, prerr, slapd_pr_strerror(prerr));
+            failed = 1;
+            break;
+        }
+        obuf->ob_off += sent;
+        __atomic_sub_fetch(&out->co_bytes, sent, __ATOMIC_RELAXED);
+        if (sent > 0) {
+            __atomic_store_n(&out->co_progress, result_writer_now(), __ATOMIC_RELAXED);
+        }
+        if (obuf->ob_off < obuf->ob_len) {
+            /* the socket is full again */
+            failed = conn_output_arm(conn) < 0;
+            break;
+        }
+        out->co_head = obuf->ob_next;
+        if (out->co_head == NULL) {
+            out->co_tail = NULL;
+        }
+        slapi_ch_free((void **)&obuf);
+    }
+    if (failed) {
+        out->co_error = 1;
+        conn_output_drop(out);
+    }
+    /* a closing connection waited for its queue to be sent */
+    closed = out->co_closing && out->co_head == NULL;
+    pthread_cond_broadcast(&out->co_cv);
+    pthread_mutex_unlock(&out->co_lock);
+
+    /* c_mutex is taken after co_lock is released */
+    if (failed) {
+        disconnect_server(conn, connid, -1, SLAPD_DISCONNECT_BER_FLUSH, prerr);
+    }
+    if (closed && conn->c_ct_list >= 0) {
+        signal_listner(conn->c_ct_list);
+    }
+}
+
+/*
+ * Disconnect the clients the output of which did not progress for
+ * ioblocktimeout. The list lock is released before co_lock is taken,
+ * the Connection structures are never freed and the connection id is
+ * checked again.
+ */
+static void
+result_writer_expire(result_writer *rw)
+{
+    struct
+    {
+        Connection *conn;
+        uint64_t connid;
+    } stalled[RESULT_WRITER_EVENTS];
+    uint64_t now = result_writer_now();
+    int nstalled = 0;
+
+    pthread_mutex_lock(&rw->rw_lock);
+    for (struct conn_output *out = rw->rw_outputs; out && nstalled < RESULT_WRITER_EVENTS; out = out->co_next) {
+        int32_t timeout = out->co_conn->c_ioblocktimeout;
+
+        if (timeout > 0 && __atomic_load_n(&out->co_bytes, __ATOMIC_RELAXED) > 0 &&
+            now - __atomic_load_n(&out->co_progress, __ATOMIC_RELAXED) > (uint64_t)timeout) {
+            stalled[nstalled].conn = out->co_conn;
+            stalled[nstalled].connid = out->co_connid;
+            nstalled++;
+        }
+    }
+    pthread_mutex_unlock(&rw->rw_lock);
+
+    for (int i = 0; i < nstalled; i++) {
+        Connection *conn = stalled[i].conn;
+        struct conn_output *out = conn->c_output;
+        int32_t timeout = conn->c_ioblocktimeout;
+        uint64_t pending = 0;
+
+        pthread_mutex_lock(&out->co_lock);
+        if (out->co_writer == rw && out->co_connid == stalled[i].connid &&
+            out->co_head && !out->co_error && timeout > 0 &&
+            now - out->co_progress > (uint64_t)timeout) {
+            pending = out->co_bytes;
+            out->co_error = 1;
+            conn_output_drop(out);
+        }
+        pthread_mutex_unlock(&out->co_lock);
+
+        if (pending) {
+            slapi_log_err(SLAPI_LOG_CONNS, "result_writer_expire",
+                          "Connection %" PRIu64 " did not read its results for %d ms, dropping %" PRIu64 " bytes\n",
+                          stalled[i].connid, timeout, pending);
+            disconnect_server(conn, stalled[i].connid, -1, SLAPD_DISCONNECT_IO_TIMEOUT, ETIMEDOUT);
+        }
+    }
+}
+
+static void
+result_writer_thread(void *arg)
+{
+    result_writer *rw = &result_writers[(uintptr_t)arg];
+    struct epoll_event events[RESULT_WRITER_EVENTS];
+    uint64_t last_expire = result_writer_now();
+
+    while (!slapi_is_shutting_down()) {
+        int n = epoll_wait(rw->rw_epfd, events, RESULT_WRITER_EVENTS, RESULT_WRITER_WAIT);
+        uint64_t now;
+
+        for (int i = 0; i < n; i++) {
+            result_writer_flush((Connection *)events[i].data.ptr);
+        }
+        now = result_writer_now();
+        if (now - last_expire >= RESULT_WRITER_WAIT) {
+            result_writer_expire(rw);
+            last_expire = now;
+        }
+    }
+    g_decr_active_threadcnt();
+}
+#endif /* ENABLE_EPOLL */
+
+/*
+ * Start the writer threads. Without them, or without epoll, the workers
+ * send the results themselves.
+ */
+void
+init_result_writer_threads(void)
+{
+#ifdef ENABLE_EPOLL
+    int32_t num = config_get_result_writer_threads();
+
+    if (num == 0) {
+        return;
+    }
+    result_writers = (result_writer *)slapi_ch_calloc(num, sizeof(result_writer));
+    for (int32_t i = 0; i < num; i++) {
+        if ((result_writers[i].rw_epfd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+            slapi_log_err(SLAPI_LOG_ERR, "init_result_writer_threads",
+                          "epoll_create1() failed: %s, the workers send the results\n", strerror(errno));
+            while (i-- > 0) {
+                close(result_writers[i].rw_epfd);
+                pthread_mutex_destroy(&result_writers[i].rw_lock);
+            }
+            slapi_ch_free((void **)&result_writers);
+            return;
+        }
+        pthread_mutex_init(&result_writers[i].rw_lock, NULL);
+    }
+    for (uintptr_t i = 0; i < (uintptr_t)num; i++) {
+        if (PR_CreateThread(PR_SYSTEM_THREAD,
+                            (VFP)(void *)result_writer_thread, (void *)i,
+                            PR_PRIORITY_NORMAL, PR_GLOBAL_THREAD,
+                            PR_UNJOINABLE_THREAD,
+                            SLAPD_DEFAULT_THREAD_STACKSIZE) == NULL) {
+            int prerr = PR_GetError();
+            slapi_log_err(SLAPI_LOG_ERR, "init_result_writer_threads",
+                          "PR_CreateThread failed - Shutting Down (" SLAPI_COMPONENT_NAME_NSPR " error %d (%s)\n",
+                          prerr, slapd_pr_strerror(prerr));
+            g_set_shutdown(SLAPI_SHUTDOWN_EXIT);
+            return;
+        }
+        g_incr_active_threadcnt();
+    }
+    __atomic_store_n(&result_writer_num, num, __ATOMIC_RELEASE);
+    slapi_log_err(SLAPI_LOG_INFO, "init_result_writer_threads",
+                  "%d threads send the results, up to %d bytes queued per connection\n",
+                  num, config_get_conn_output_max_bytes());
+#endif /* ENABLE_EPOLL */
+}
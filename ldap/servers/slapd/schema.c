@@ -2227,6 +2227,7 @@ modify_schema_dse(Slapi_PBlock *pb, Slapi_Entry *entryBefore, Slapi_Entry *entry
     }
 
     schema_dse_unlock();
+    attr_syntax_snapshot_publish();
 
     return rc;
 }
@@ -4430,6 +4431,9 @@ init_schema_dse(const char *configdir)
     }
     rc = init_schema_dse_ext(schemadir, NULL, &pschemadse, DSE_SCHEMA_NO_GLOCK);
     slapi_ch_free_string(&schemadir);
+    if (rc) {
+        attr_syntax_snapshot_publish();
+    }
     return rc;
 }
 
@@ -4925,6 +4929,7 @@ slapi_reload_schema_files(char *schemadir)
         attr_syntax_swap_ht();
         attr_syntax_unlock_write();
         slapi_reload_internal_attr_syntax();
+        attr_syntax_snapshot_publish();
 
         dse_destroy(pschemadse);
         pschemadse = my_pschemadse;
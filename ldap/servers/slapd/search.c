@@ -202,7 +202,7 @@ do_search(Slapi_PBlock *pb)
     /* filter - returns a "normalized" version */
     filter = NULL;
     fstr = NULL;
-    if ((err = get_filter(pb_conn, ber, scope, &filter, &fstr)) != 0) {
+    if ((err = get_filter(pb_conn, ber, scope, &filter, &fstr, slapi_operation_get_arena(operation))) != 0) {
         char *errtxt;
 
         if (LDAP_UNWILLING_TO_PERFORM == err) {
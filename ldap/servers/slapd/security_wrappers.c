@@ -387,6 +387,12 @@ slapd_pk11_Finalize(PK11Context *context)
     return PK11_Finalize(context);
 }
 
+SECStatus
+slapd_pk11_DigestBegin(PK11Context *context)
+{
+    return PK11_DigestBegin(context);
+}
+
 SECStatus
 slapd_pk11_DigestFinal(PK11Context *context, unsigned char *data, unsigned int *outLen, unsigned int length)
 {
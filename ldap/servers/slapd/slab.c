@@ -0,0 +1,375 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * slab.c - object pools for Slapi_Value, Slapi_Attr and Slapi_Entry
+ *
+ * Each class hands out objects of a single size carved from large slabs,
+ * so the many small structures of the entries in the cache do not end up
+ * scattered among the other allocations of the heap.
+ *
+ * A thread keeps the free objects of each class in a local cache and only
+ * goes to the shared depot of the class, under its lock, to exchange a
+ * batch of SLAB_BATCH objects when its cache is empty or too large. When
+ * the thread exits its cache goes back to the depot.
+ *
+ * The objects are reused, and a burst (an import, a large cache being
+ * emptied) would otherwise pin its memory for ever: every SLAB_TRIM_INTERVAL
+ * seconds, when more than a quarter of the objects of a class are free in
+ * its depot, the slabs whose objects are all in the depot are released.
+ * The free objects kept by the threads are not looked at, they only keep
+ * their slabs alive.
+ *
+ * With --enable-asan every object is a separate allocation again, so the
+ * sanitizer still sees the use after free of values and entries.
+ */
+
+#include "slap.h"
+
+#define SLAB_SIZE (64 * 1024) /* bytes carved at once for a class */
+#define SLAB_BATCH 64         /* objects exchanged with the depot */
+#define SLAB_ALIGN 16
+#define SLAB_ROUND(s) (((s) + SLAB_ALIGN - 1) & ~((size_t)SLAB_ALIGN - 1))
+#define SLAB_TRIM_INTERVAL 60 /* seconds between two trims */
+
+/* A free object, the first one of a batch also links the batches */
+typedef struct slab_obj
+{
+    struct slab_obj *so_next;  /* next object of the batch */
+    struct slab_obj *so_batch; /* next batch of the depot */
+    size_t so_count;           /* objects in the batch */
+} slab_obj;
+
+typedef struct slab_class
+{
+    size_t sc_size;
+    pthread_mutex_t sc_lock;
+    slab_obj *sc_depot; /* batches of free objects */
+    uint64_t sc_slabs;  /* slabs carved and not released */
+    uint64_t sc_free;   /* objects in the depot */
+    char **sc_list;     /* the slabs, sorted by address */
+} slab_class;
+
+static slab_class slab_classes[SLAB_CLASS_MAX] = {
+    [SLAB_CLASS_VALUE] = {SLAB_ROUND(sizeof(Slapi_Value)), PTHREAD_MUTEX_INITIALIZER, NULL, 0, 0, NULL},
+    [SLAB_CLASS_ATTR] = {SLAB_ROUND(sizeof(Slapi_Attr)), PTHREAD_MUTEX_INITIALIZER, NULL, 0, 0, NULL},
+    [SLAB_CLASS_ENTRY] = {SLAB_ROUND(sizeof(struct slapi_entry)), PTHREAD_MUTEX_INITIALIZER, NULL, 0, 0, NULL},
+};
+
+typedef struct slab_cache
+{
+    slab_obj *c_free[SLAB_CLASS_MAX];
+    size_t c_count[SLAB_CLASS_MAX];
+} slab_cache;
+
+/* Index of the slab holding ptr, or of the slab to insert before */
+static size_t
+slab_class_find(slab_class *sc, const char *ptr)
+{
+    size_t nobjs = SLAB_SIZE / sc->sc_size;
+    size_t low = 0;
+    size_t high = sc->sc_slabs;
+
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+
+        if (ptr < sc->sc_list[mid]) {
+            high = mid;
+        } else if (ptr >= sc->sc_list[mid] + nobjs * sc->sc_size) {
+            low = mid + 1;
+        } else {
+            return mid;
+        }
+    }
+    return low;
+}
+
+/* Cut a new slab in batches, called with the class lock held */
+static void
+slab_class_grow(slab_class *sc)
+{
+    size_t nobjs = SLAB_SIZE / sc->sc_size;
+    char *slab = (char *)slapi_ch_malloc(nobjs * sc->sc_size);
+    slab_obj *batch = NULL;
+    size_t pos = slab_class_find(sc, slab);
+
+    sc->sc_list = (char **)slapi_ch_realloc((char *)sc->sc_list, (sc->sc_slabs + 1) * sizeof(char *));
+    memmove(&sc->sc_list[pos + 1], &sc->sc_list[pos], (sc->sc_slabs - pos) * sizeof(char *));
+    sc->sc_list[pos] = slab;
+
+    for (size_t i = 0; i < nobjs; i++) {
+        slab_obj *obj = (slab_obj *)(slab + i * sc->sc_size);
+
+        if (batch && batch->so_count < SLAB_BATCH) {
+            obj->so_next = batch->so_next;
+            batch->so_next = obj;
+            batch->so_count++;
+            continue;
+        }
+        if (batch) {
+            batch->so_batch = sc->sc_depot;
+            sc->sc_depot = batch;
+        }
+        obj->so_next = NULL;
+        obj->so_count = 1;
+        batch = obj;
+    }
+    batch->so_batch = sc->sc_depot;
+    sc->sc_depot = batch;
+    sc->sc_slabs++;
+    sc->sc_free += nobjs;
+}
+
+/* Take a whole batch from the depot */
+static slab_obj *
+slab_depot_get(slab_class *sc, size_t *count)
+{
+    slab_obj *batch;
+
+    pthread_mutex_lock(&sc->sc_lock);
+    if (sc->sc_depot == NULL) {
+        slab_class_grow(sc);
+    }
+    batch = sc->sc_depot;
+    sc->sc_depot = batch->so_batch;
+    sc->sc_free -= batch->so_count;
+    pthread_mutex_unlock(&sc->sc_lock);
+
+    *count = batch->so_count;
+    return batch;
+}
+
+/* Give a list of count objects back to the depot */
+static void
+slab_depot_put(slab_class *sc, slab_obj *batch, size_t count)
+{
+    batch->so_count = count;
+    pthread_mutex_lock(&sc->sc_lock);
+    batch->so_batch = sc->sc_depot;
+    sc->sc_depot = batch;
+    sc->sc_free += count;
+    pthread_mutex_unlock(&sc->sc_lock);
+}
+
+/*
+ * Release the slabs whose objects are all free in the depot, and batch
+ * the remaining free objects again.
+ */
+static void
+slab_class_trim(slab_class *sc)
+{
+    size_t nobjs = SLAB_SIZE / sc->sc_size;
+    slab_obj *depot = NULL;
+    slab_obj *batch = NULL;
+    uint32_t *nfree = NULL;
+    uint64_t released = 0;
+    size_t kept = 0;
+
+    pthread_mutex_lock(&sc->sc_lock);
+    if (sc->sc_free * 4 <= sc->sc_slabs * nobjs || sc->sc_free < 2 * nobjs) {
+        pthread_mutex_unlock(&sc->sc_lock);
+        return;
+    }
+    nfree = (uint32_t *)slapi_ch_calloc(sc->sc_slabs, sizeof(uint32_t));
+    for (slab_obj *b = sc->sc_depot; b; b = b->so_batch) {
+        for (slab_obj *obj = b; obj; obj = obj->so_next) {
+            nfree[slab_class_find(sc, (char *)obj)]++;
+        }
+    }
+    /* batch again the objects of the slabs in use */
+    for (slab_obj *b = sc->sc_depot, *next_b; b; b = next_b) {
+        next_b = b->so_batch;
+        for (slab_obj *obj = b, *next; obj; obj = next) {
+            next = obj->so_next;
+            if (nfree[slab_class_find(sc, (char *)obj)] == nobjs) {
+                continue;
+            }
+            if (batch && batch->so_count < SLAB_BATCH) {
+                obj->so_next = batch->so_next;
+                batch->so_next = obj;
+                batch->so_count++;
+                continue;
+            }
+            if (batch) {
+                batch->so_batch = depot;
+                depot = batch;
+            }
+            obj->so_next = NULL;
+            obj->so_count = 1;
+            batch = obj;
+        }
+    }
+    if (batch) {
+        batch->so_batch = depot;
+        depot = batch;
+    }
+    sc->sc_depot = depot;
+    for (size_t i = 0; i < sc->sc_slabs; i++) {
+        if (nfree[i] == nobjs) {
+            slapi_ch_free((void **)&sc->sc_list[i]);
+            released++;
+        } else {
+            sc->sc_list[kept++] = sc->sc_list[i];
+        }
+    }
+    sc->sc_slabs = kept;
+    sc->sc_free -= released * nobjs;
+    pthread_mutex_unlock(&sc->sc_lock);
+    slapi_ch_free((void **)&nfree);
+
+    if (released) {
+        slapi_log_err(SLAPI_LOG_TRACE, "slab_class_trim",
+                      "Released %" PRIu64 " slabs of %" PRIu64 " bytes objects\n",
+                      released, (uint64_t)sc->sc_size);
+    }
+}
+
+/* Event queue callback, releases the unused slabs of every class */
+static void
+slab_trim(time_t when __attribute__((unused)), void *arg __attribute__((unused)))
+{
+    for (size_t i = 0; i < SLAB_CLASS_MAX; i++) {
+        slab_class_trim(&slab_classes[i]);
+    }
+}
+
+/* Called once the event queue runs */
+void
+slab_trim_start(void)
+{
+#ifdef __SANITIZE_ADDRESS__
+    return;
+#endif
+    slapi_eq_repeat_rel(slab_trim, NULL, slapi_current_rel_time_t() + SLAB_TRIM_INTERVAL,
+                        SLAB_TRIM_INTERVAL * 1000);
+}
+
+/* Called by the thread data destructor when a thread exits */
+void
+slab_cache_destroy(void *priv)
+{
+    slab_cache *cache = (slab_cache *)priv;
+
+    if (cache == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < SLAB_CLASS_MAX; i++) {
+        if (cache->c_free[i]) {
+            slab_depot_put(&slab_classes[i], cache->c_free[i], cache->c_count[i]);
+        }
+    }
+    slapi_ch_free((void **)&cache);
+}
+
+static slab_cache *
+slab_cache_get(void)
+{
+    slab_cache *cache = slapi_td_get_slab_cache();
+
+    if (cache == NULL) {
+        cache = (slab_cache *)slapi_ch_calloc(1, sizeof(slab_cache));
+        if (slapi_td_set_slab_cache(cache) != PR_SUCCESS) {
+            /* no thread data, use the depot directly */
+            slapi_ch_free((void **)&cache);
+        }
+    }
+    return cache;
+}
+
+void *
+slab_alloc(slab_class_t class)
+{
+    slab_class *sc = &slab_classes[class];
+    slab_cache *cache;
+    slab_obj *obj;
+
+#ifdef __SANITIZE_ADDRESS__
+    return slapi_ch_calloc(1, sc->sc_size);
+#endif
+    cache = slab_cache_get();
+    if (cache == NULL) {
+        size_t count;
+
+        obj = slab_depot_get(sc, &count);
+        if (obj->so_next) {
+            slab_depot_put(sc, obj->so_next, count - 1);
+        }
+    } else {
+        if (cache->c_free[class] == NULL) {
+            cache->c_free[class] = slab_depot_get(sc, &cache->c_count[class]);
+        }
+        obj = cache->c_free[class];
+        cache->c_free[class] = obj->so_next;
+        cache->c_count[class]--;
+    }
+    memset(obj, 0, sc->sc_size);
+    return obj;
+}
+
+void
+slab_free(slab_class_t class, void *ptr)
+{
+    slab_class *sc = &slab_classes[class];
+    slab_cache *cache;
+    slab_obj *obj = (slab_obj *)ptr;
+
+    if (obj == NULL) {
+        return;
+    }
+#ifdef __SANITIZE_ADDRESS__
+    slapi_ch_free((void **)&obj);
+    return;
+#endif
+    cache = slab_cache_get();
+    if (cache == NULL) {
+        obj->so_next = NULL;
+        slab_depot_put(sc, obj, 1);
+        return;
+    }
+    obj->so_next = cache->c_free[class];
+    cache->c_free[class] = obj;
+    if (++cache->c_count[class] == 2 * SLAB_BATCH) {
+        /* keep one batch for the next allocations and give back the other */
+        slab_obj *last = obj;
+
+        for (size_t i = 1; i < SLAB_BATCH; i++) {
+            last = last->so_next;
+        }
+        cache->c_free[class] = last->so_next;
+        cache->c_count[class] = SLAB_BATCH;
+        last->so_next = NULL;
+        slab_depot_put(sc, obj, SLAB_BATCH);
+    }
+}
+
+/* Bytes used by an object of a class */
+size_t
+slab_class_size(slab_class_t class)
+{
+    return slab_classes[class].sc_size;
+}
+
+/* Number of slabs of a class and the bytes they use */
+uint64_t
+slab_class_slabs(slab_class_t class, uint64_t *bytes)
+{
+    slab_class *sc = &slab_classes[class];
+    uint64_t slabs;
+
+    pthread_mutex_lock(&sc->sc_lock);
+    slabs = sc->sc_slabs;
+    pthread_mutex_unlock(&sc->sc_lock);
+    if (bytes) {
+        *bytes = slabs * (SLAB_SIZE / sc->sc_size) * sc->sc_size;
+    }
+    return slabs;
+}
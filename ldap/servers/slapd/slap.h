@@ -170,6 +170,11 @@ typedef struct symbol_t
 #define LDAP_CONTROL_GET_EFFECTIVE_RIGHTS "1.3.6.1.4.1.42.2.27.9.5.2"
 #endif
 
+/* FILTER PLAN control (shared by request and response) */
+#ifndef LDAP_CONTROL_FILTER_PLAN
+#define LDAP_CONTROL_FILTER_PLAN "2.16.840.1.113730.3.4.21"
+#endif
+
 /* PAGED RESULTS control (shared by request and response) */
 #ifndef LDAP_CONTROL_PAGEDRESULTS
 #define LDAP_CONTROL_PAGEDRESULTS "1.2.840.113556.1.4.319"
@@ -277,6 +282,14 @@ typedef void (*VFPV)(); /* takes undefined arguments */
 #define SLAPD_DEFAULT_MAX_SASLIO_SIZE_STR "2097152"
 #define SLAPD_DEFAULT_IOBLOCK_TIMEOUT 10000 /* 10 second in ms */
 #define SLAPD_DEFAULT_IOBLOCK_TIMEOUT_STR "10000"
+#define SLAPD_DEFAULT_PLUGIN_SLOW_THRESHOLD 0 /* in ms, 0 disables the log */
+#define SLAPD_DEFAULT_PLUGIN_SLOW_THRESHOLD_STR "0"
+#define SLAPD_DEFAULT_RESULT_WRITER_THREADS 2 /* 0 writes the results from the workers */
+#define SLAPD_DEFAULT_RESULT_WRITER_THREADS_STR "2"
+#define SLAPD_DEFAULT_CONN_OUTPUT_MAX_BYTES 1048576 /* 1MB */
+#define SLAPD_DEFAULT_CONN_OUTPUT_MAX_BYTES_STR "1048576"
+#define SLAPD_DEFAULT_ACCEPT_THREADS 1 /* > 1 shards the listeners with SO_REUSEPORT */
+#define SLAPD_DEFAULT_ACCEPT_THREADS_STR "1"
 #define SLAPD_DEFAULT_OUTBOUND_LDAP_IO_TIMEOUT 300000 /* 5 minutes in ms */
 #define SLAPD_DEFAULT_OUTBOUND_LDAP_IO_TIMEOUT_STR "300000"
 #define SLAPD_DEFAULT_RESERVE_FDS 64
@@ -674,6 +687,7 @@ struct slapi_attr
     struct slapdplugin *a_mr_eq_plugin;  /* for the attribute EQUALITY matching rule, if any */
     struct slapdplugin *a_mr_ord_plugin; /* for the attribute ORDERING matching rule, if any */
     struct slapdplugin *a_mr_sub_plugin; /* for the attribute SUBSTRING matching rule, if any */
+    uint32_t a_list_version;             /* on the head of an indexed list, see attrlist_index_find */
 };
 
 typedef struct oid_item
@@ -717,6 +731,25 @@ typedef struct asyntaxinfo
     struct asyntaxinfo *asi_prev;
 } asyntaxinfo;
 
+/*
+ * What the hot paths need of an attribute type, copied from the schema
+ * snapshot by attr_syntax_get_ref() without lock nor reference.
+ */
+typedef struct asyntaxref
+{
+    int32_t asr_id;                        /* interned id of the name, see attrsyntax.c */
+    unsigned long asr_flags;               /* SLAPI_ATTR_FLAG_... */
+    struct slapdplugin *asr_plugin;        /* syntax */
+    struct slapdplugin *asr_mr_eq_plugin;  /* EQUALITY matching rule plugin */
+    struct slapdplugin *asr_mr_sub_plugin; /* SUBSTR matching rule plugin */
+    struct slapdplugin *asr_mr_ord_plugin; /* ORDERING matching rule plugin */
+} asyntaxref;
+
+/* Return values of attr_syntax_get_ref() */
+#define ATTR_SYNTAX_REF_NOT_FOUND 0   /* unknown type */
+#define ATTR_SYNTAX_REF_FOUND 1       /* ref is set */
+#define ATTR_SYNTAX_REF_UNAVAILABLE 2 /* use attr_syntax_get_by_name() */
+
 /*
  * Note: most of the asi_flags values are defined in slapi-plugin.h, but
  * these ones are private to the DS.
@@ -872,6 +905,7 @@ struct slapi_entry
     void *e_extension;            /* A list of entry object extensions */
     unsigned char e_flags;
     Slapi_Attr *e_aux_attrs;      /* Attr list used for upgrade */
+    struct attrlist_index *e_attrs_index; /* index of e_attrs, built on the first lookup */
 };
 
 struct attrs_in_extension
@@ -1060,6 +1094,7 @@ struct slapdplugin
     PRUint64 plg_started;                   /* plugin is started/running */
     PRUint64 plg_stopped;                   /* plugin has been fully shutdown */
     Slapi_Counter *plg_op_counter;          /* operation counter, used for shutdown */
+    struct plugin_call_stats *plg_call_stats; /* calls and latencies of the callbacks */
 
     /* NOTE: These LDIF2DB and DB2LDIF fn pointers are internal only for now.
      * I don't believe you can get these functions from a plug-in and
@@ -1643,6 +1678,8 @@ typedef struct op
     struct slapi_operation_results o_results;
     int o_pagedresults_sizelimit;
     int o_reverse_search_state;
+    uint64_t o_repl_seq;                                       /* order of the update on a replication connection applying updates in parallel */
+    Slapi_Arena *o_arena;                                      /* short lived allocations, released by operation_done */
 } Operation;
 
 /*
@@ -1688,6 +1725,8 @@ typedef int (*Conn_IO_Layer_cb)(struct conn *, void *data);
 
 struct Conn_Private;
 typedef struct Conn_private Conn_private;
+struct repl_apply_pipeline;
+struct conn_output;
 
 typedef enum _conn_state {
     CONN_STATE_FREE = 0,
@@ -1733,6 +1772,8 @@ typedef struct conn
     int c_idletimeout;               /* local copy of idletimeout */
     int c_idletimeout_handle;        /* the resource limits handle */
     Conn_private *c_private;         /* data which is not shared outside connection.c */
+    struct repl_apply_pipeline *c_repl_apply; /* replicated updates applied in parallel, see connection.c */
+    struct conn_output *c_output;    /* results waiting for the writer threads, see result_writer.c */
     int c_flags;                     /* Misc flags used only for SSL status currently */
     int c_needpw;                    /* need new password           */
     int c_haproxyheader_read;        /* 0 if HAProxy header has not been read, 1 if it has been read */
@@ -1991,6 +2032,10 @@ typedef struct daemon_ports_s
     PRFileDesc **i_socket;
 #endif
     PRFileDesc **s_socket;
+    /* Number of accept threads. The n_socket and s_socket arrays hold
+     * accept_shards sockets per address, the one of shard s for the
+     * address a being at index a * accept_shards + s. */
+    int accept_shards;
 } daemon_ports_t;
 
 
@@ -2404,6 +2449,10 @@ typedef struct _slapdEntryPoints
 #define CONFIG_CONNECTION_NOCANON "nsslapd-connection-nocanon"
 #define CONFIG_PLUGIN_LOGGING "nsslapd-plugin-logging"
 #define CONFIG_LISTEN_BACKLOG_SIZE "nsslapd-listen-backlog-size"
+#define CONFIG_PLUGIN_SLOW_THRESHOLD "nsslapd-plugin-slow-threshold"
+#define CONFIG_RESULT_WRITER_THREADS "nsslapd-result-writer-threads"
+#define CONFIG_CONN_OUTPUT_MAX_BYTES "nsslapd-conn-output-max-bytes"
+#define CONFIG_ACCEPT_THREADS "nsslapd-accept-threads"
 #define CONFIG_DYNAMIC_PLUGINS "nsslapd-dynamic-plugins"
 #define CONFIG_RETURN_DEFAULT_OPATTR "nsslapd-return-default-opattr"
 #define CONFIG_REFERRAL_CHECK_PERIOD "nsslapd-referral-check-period"
@@ -2737,6 +2786,10 @@ typedef struct _slapdFrontendConfig
     slapi_int_t connection_buffer;    /* values are CONNECTION_BUFFER_* below */
     slapi_onoff_t connection_nocanon; /* if "on" sets LDAP_OPT_X_SASL_NOCANON */
     slapi_onoff_t plugin_logging;     /* log all internal plugin operations */
+    slapi_int_t plugin_slow_threshold; /* log the plugin calls longer than this (msec) */
+    slapi_int_t result_writer_threads; /* threads sending the queued results, 0 to send from the workers */
+    slapi_int_t conn_output_max_bytes; /* results queued per connection before the worker waits */
+    slapi_int_t accept_threads;        /* threads accepting connections, each on its own listeners */
     slapi_onoff_t ignore_time_skew;
     slapi_onoff_t dynamic_plugins;          /* allow plugins to be dynamically enabled/disabled */
     slapi_onoff_t cn_uses_dn_syntax_in_dns; /* indicates the cn value in dns has dn syntax */
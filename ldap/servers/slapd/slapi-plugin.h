@@ -2336,6 +2336,24 @@ int slapi_entry_apply_mod_extension(Slapi_Entry *e, const LDAPMod *mod, int modc
  */
 void slapi_entrycache_vattrcache_watermark_invalidate(void);
 
+/**
+ * Invalidate the cached values of a virtual attribute in the entries of a subtree.
+ *
+ * \param type The attribute type to invalidate, \c NULL for all the types.
+ * \param scope The base of the subtree, \c NULL for all the entries.
+ */
+void slapi_entrycache_vattrcache_invalidate_scope(const char *type, const Slapi_DN *scope);
+
+/**
+ * Invalidate the cached values of a virtual attribute in the entries of several subtrees.
+ *
+ * This takes a single invalidation, whatever the number of subtrees.
+ *
+ * \param type The attribute type to invalidate, \c NULL for all the types.
+ * \param scopes The \c NULL terminated bases of the subtrees, \c NULL for all the entries.
+ */
+void slapi_entrycache_vattrcache_invalidate_scopes(const char *type, const Slapi_DN **scopes);
+
 
 /*
  * Slapi_DN routines
@@ -5821,6 +5839,77 @@ struct berval *slapi_ch_bvdup(const struct berval *);
 struct berval **slapi_ch_bvecdup(struct berval **);
 void slapi_ch_bvfree(struct berval **v);
 char *slapi_ch_smprintf(const char *fmt, ...) __ATTRIBUTE__((format(printf, 1, 2)));
+
+/*
+ * Arena allocator
+ *
+ * Memory allocated from an arena is not freed individually: it is released
+ * all at once with slapi_arena_destroy(), or back to a previous mark with
+ * slapi_arena_release(). The chunks of memory are recycled through a per
+ * thread pool. An arena is not thread safe.
+ *
+ * Every operation owns an arena (see slapi_operation_get_arena()) released
+ * when the operation is done: it is meant for the short lived objects of
+ * the operation that are never freed by someone else. The nodes and the
+ * avas of a search filter are taken from it: slapi_filter_free() and the
+ * filter rewriting functions know them and leave them to the arena. The
+ * requested attributes and the controls of an operation are not, as the
+ * plugins may keep, replace or free them.
+ */
+typedef struct slapi_arena Slapi_Arena;
+
+/**
+ * A position in an arena, see slapi_arena_mark()
+ */
+typedef struct slapi_arena_mark
+{
+    void *am_chunk;
+    size_t am_used;
+} Slapi_Arena_Mark;
+
+/**
+ * Creates an empty arena
+ *
+ * \return A new arena, to free with slapi_arena_destroy()
+ */
+Slapi_Arena *slapi_arena_new(void) __ATTRIBUTE__((returns_nonnull));
+/**
+ * Releases all the memory of an arena and the arena itself
+ *
+ * \param arena Address of the arena to destroy, set to NULL
+ */
+void slapi_arena_destroy(Slapi_Arena **arena);
+/**
+ * Allocates memory from an arena, aligned for any type
+ *
+ * \param arena The arena
+ * \param size Number of bytes
+ * \return The memory, valid until the arena is destroyed or released
+ */
+void *slapi_arena_alloc(Slapi_Arena *arena, size_t size) __ATTRIBUTE__((returns_nonnull));
+void *slapi_arena_calloc(Slapi_Arena *arena, size_t nelem, size_t size) __ATTRIBUTE__((returns_nonnull));
+char *slapi_arena_strdup(Slapi_Arena *arena, const char *s);
+/**
+ * Gets the current position of an arena
+ *
+ * \param arena The arena
+ * \param mark Filled with the current position
+ */
+void slapi_arena_mark(Slapi_Arena *arena, Slapi_Arena_Mark *mark);
+/**
+ * Releases the memory allocated since a mark was taken
+ *
+ * \param arena The arena
+ * \param mark Position returned by slapi_arena_mark()
+ */
+void slapi_arena_release(Slapi_Arena *arena, const Slapi_Arena_Mark *mark);
+/**
+ * Gets the arena of an operation, released when the operation is done
+ *
+ * \param op The operation
+ * \return The arena of the operation
+ */
+Slapi_Arena *slapi_operation_get_arena(Slapi_Operation *op);
 /**
  * slapi_ct_memcmp is a constant time memory comparison function. This is for
  * use with password hashes and other locations which could lead to a timing
@@ -7329,6 +7418,7 @@ typedef enum _slapi_op_note_t {
     SLAPI_OP_NOTE_FULL_UNINDEXED = 0x04,
     SLAPI_OP_NOTE_FILTER_INVALID = 0x08,
     SLAPI_OP_NOTE_MFA_AUTH = 0x10,
+    SLAPI_OP_NOTE_FILTER_PLANNED = 0x20,
 } slapi_op_note_t;
 
 /**
@@ -7826,6 +7916,8 @@ int slapi_back_set_info(Slapi_Backend *be, int cmd, void *info);
  * BACK_INFO_CRYPT_DESTROY - Free allocated during init data (info: back_info_crypt_destroy)
  * BACK_INFO_CRYPT_ENCRYPT_VALUE - Encrypt the given value (info: back_info_crypt_value)
  * BACK_INFO_CRYPT_DECRYPT_VALUE - Decrypt the given value (info: back_info_crypt_value)
+ * BACK_INFO_SNAPSHOT_EXPORT - Walk a consistent snapshot of the databases (info: back_info_snapshot)
+ * BACK_INFO_SNAPSHOT_IMPORT - Install the records of a snapshot (info: back_info_snapshot)
  */
 int slapi_back_ctrl_info(Slapi_Backend *be, int cmd, void *info);
 
@@ -7852,7 +7944,9 @@ enum
     BACK_INFO_INDEX_KEY,           /* Get the status of a key in an index */
     BACK_INFO_DB_DIRECTORY,        /* Get the db directory */
     BACK_INFO_DBHOME_DIRECTORY,    /* Get the dbhome directory */
-    BACK_INFO_CLDB_FILENAME        /* Get the backend replication changelog name */
+    BACK_INFO_CLDB_FILENAME,       /* Get the backend replication changelog name */
+    BACK_INFO_SNAPSHOT_EXPORT,     /* Ctrl: walk the records of a database snapshot */
+    BACK_INFO_SNAPSHOT_IMPORT      /* Ctrl: install the records of a database snapshot */
 };
 
 struct _back_info_index_key
@@ -7894,6 +7988,34 @@ typedef struct _back_info_config_entry back_info_config_entry;
 
 #define BACK_CRYPT_OUTBUFF_EXTLEN 16
 
+/* back_info_snapshot states */
+#define BACK_SNAPSHOT_CHECK 0 /* Tell whether the backend can export/import a snapshot */
+#define BACK_SNAPSHOT_START 1 /* Export: walk the whole snapshot. Import: clear the backend */
+#define BACK_SNAPSHOT_ADD   2 /* Import: install a set of records */
+#define BACK_SNAPSHOT_DONE  3 /* Import: bring the backend back online */
+#define BACK_SNAPSHOT_ABORT 4 /* Import: give up, the backend is left empty */
+
+struct _back_info_snapshot_record
+{
+    char *dbname;          /* database file name, without the backend name */
+    struct berval key;
+    struct berval data;
+};
+typedef struct _back_info_snapshot_record back_info_snapshot_record;
+
+struct _back_info_snapshot
+{
+    int state;                           /* input -- BACK_SNAPSHOT_xxx */
+    /* export: called for every record of the snapshot, a non 0 value stops the walk */
+    int (*record_cb)(back_info_snapshot_record *rec, void *cb_arg);
+    void *cb_arg;
+    back_info_snapshot_record *records;  /* import input -- records to install */
+    size_t nbrecords;
+    uint64_t nbentries;                  /* output -- number of entries exported/installed */
+    void *state_priv;                    /* backend private import state */
+};
+typedef struct _back_info_snapshot back_info_snapshot;
+
 /**
  * Convert unsigned char (8 bit) value to a hex string.  Writes to the string.
  * The caller must ensure enough space to write 2 bytes.  If the upper parameter
@@ -59,8 +59,13 @@ typedef enum _slapi_filter_flags_t {
     SLAPI_FILTER_NORMALIZED_VALUE = 16,
     SLAPI_FILTER_INVALID_ATTR_UNDEFINE = 32,
     SLAPI_FILTER_INVALID_ATTR_WARN = 64,
+    SLAPI_FILTER_ARENA_NODE = 128, /* the node is allocated in the operation arena */
+    SLAPI_FILTER_ARENA_AVA = 256,  /* the ava type and value are in the operation arena */
 } slapi_filter_flags;
 
+/* ownership flags, they describe one node and are never copied to another */
+#define SLAPI_FILTER_ARENA (SLAPI_FILTER_ARENA_NODE | SLAPI_FILTER_ARENA_AVA)
+
 /*
     Optimized filter path. For example the following code was lifted from int.c (syntaxes plugin):
 
@@ -119,6 +124,7 @@ typedef struct slapi_mod
 } slapi_mod;
 
 void slapi_ch_free_ref(void *ptr);
+size_t slapi_ch_usable_size(const void *ptr);
 
 /*
  * file I/O
@@ -323,6 +329,9 @@ int entry_next_deleted_attribute(const Slapi_Entry *e, Slapi_Attr **a);
 int entry_apply_mods(Slapi_Entry *e, LDAPMod **mods);
 int is_type_protected(const char *type);
 int entry_apply_mods_ignore_error(Slapi_Entry *e, LDAPMod **mods, int ignore_error);
+size_t entry_size_update(Slapi_Entry *olde, size_t oldsize, Slapi_Entry *newe, char **types);
+uint64_t slapi_entry_vattrcache_size(void);
+void slapi_entry_vattrcache_get_stats(uint64_t *hits, uint64_t *tries);
 int slapi_entries_diff(Slapi_Entry **old_entries, Slapi_Entry **new_entries, int testall, const char *logging_prestr, const int force_update, void *plg_id);
 void set_attr_to_protected_list(char *attr, int flag);
 
@@ -471,6 +480,7 @@ typedef struct op_search_stat
     struct component_keys_lookup *keys_lookup;
     struct timespec keys_lookup_start;
     struct timespec keys_lookup_end;
+    char *filter_plan; /* evaluation order chosen by the filter planner */
 } Op_search_stat;
 
 /* structure store in the operation extension */
@@ -830,6 +840,11 @@ int slapi_stop_bulk_import(Slapi_PBlock *pb);
 /* allows plugins to close inbound connection */
 void slapi_disconnect_server(Slapi_Connection *conn);
 
+/* replicated updates applied in parallel on a replication connection (connection.c) */
+void slapi_connection_set_repl_apply_threads(Slapi_Connection *conn, int32_t nthreads);
+int32_t slapi_op_repl_apply_turn(Slapi_PBlock *pb, int32_t *dep_waited);
+void slapi_op_repl_apply_passed(Slapi_PBlock *pb);
+
 /* functions to look up instance names by suffixes (backend_manager.c) */
 int slapi_lookup_instance_name_by_suffixes(char **included,
                                            char **excluded,
@@ -1249,6 +1264,35 @@ struct slapi_td_log_op_state_t * slapi_td_get_log_op_state(void);
 void slapi_td_internal_op_start(void);
 void slapi_td_internal_op_finish(void);
 void slapi_td_reset_internal_logging(uint64_t conn_id, int32_t op_id, time_t start_time);
+struct arena_pool *slapi_td_get_arena_pool(void);
+int slapi_td_set_arena_pool(struct arena_pool *pool);
+struct slab_cache *slapi_td_get_slab_cache(void);
+int slapi_td_set_slab_cache(struct slab_cache *cache);
+struct epoch_slot *slapi_td_get_epoch_slot(void);
+int slapi_td_set_epoch_slot(struct epoch_slot *slot);
+
+/* arena.c */
+void arena_pool_destroy(void *priv);
+
+/* epoch.c */
+int32_t epoch_enter(void);
+void epoch_leave(void);
+void epoch_retire(void *obj, void (*free_fn)(void *obj));
+void epoch_slot_release(void *priv);
+
+/* slab.c */
+typedef enum {
+    SLAB_CLASS_VALUE, /* Slapi_Value */
+    SLAB_CLASS_ATTR,  /* Slapi_Attr */
+    SLAB_CLASS_ENTRY, /* Slapi_Entry */
+    SLAB_CLASS_MAX
+} slab_class_t;
+void *slab_alloc(slab_class_t class);
+size_t slab_class_size(slab_class_t class);
+void slab_free(slab_class_t class, void *ptr);
+uint64_t slab_class_slabs(slab_class_t class, uint64_t *bytes);
+void slab_cache_destroy(void *priv);
+void slab_trim_start(void);
 
 /*  Thread Local Storage Index Types - thread_data.c */
 
@@ -1328,6 +1372,7 @@ void bervalarray_add_berval_fast(struct berval ***vals, const struct berval *add
 /* this is the root configuration entry beneath which all plugin
    configuration entries will be found */
 #define PLUGIN_BASE_DN "cn=plugins,cn=config"
+#define PLUGIN_MONITOR_BASE_DN "cn=plugins,cn=monitor"
 
 #define SLAPI_PLUGIN_DEFAULT_CONFIG "cn=plugin default config,cn=config"
 
@@ -1395,6 +1440,11 @@ int slapi_plugin_call_preop_be_plugins(Slapi_PBlock *pb, int operation);
  */
 int slapi_plugin_call_postop_be_plugins(Slapi_PBlock *pb, int operation);
 
+/* plugin_acl.c */
+void plugin_acl_time_rule_add(void);
+void plugin_acl_time_rule_remove(void);
+PRBool plugin_acl_has_time_rules(void);
+
 /* protect_db.c */
 /* is_slapd_running()
  * returns 1 if slapd is running, 0 if not, -1 on error
@@ -1594,6 +1644,7 @@ typedef struct slapd_log_pblock {
     const char *stat_key;
     const char *stat_value;
     const char *stat_etime;
+    const char *stat_plan;
     int32_t stat_count;
     /*
      * VLV request:
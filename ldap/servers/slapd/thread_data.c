@@ -18,6 +18,10 @@
 static pthread_key_t td_requestor_dn; /* TD_REQUESTOR_DN */
 static pthread_key_t td_plugin_list;  /* SLAPI_TD_PLUGIN_LIST_LOCK - integer set to 1 or zero */
 static pthread_key_t td_op_state;
+static pthread_key_t td_arena_pool; /* chunks recycled by the arenas of the thread */
+static int32_t td_arena_pool_ready; /* arenas may be used before slapi_td_init (tools, tests) */
+static pthread_key_t td_slab_cache; /* free objects of the slab classes kept by the thread */
+static pthread_key_t td_epoch_slot; /* epoch announced by the thread, see epoch.c */
 
 /*
  *   Destructor Functions
@@ -52,6 +56,21 @@ slapi_td_init(void)
         return PR_FAILURE;
     }
 
+    if (pthread_key_create(&td_arena_pool, arena_pool_destroy) != 0) {
+        slapi_log_err(SLAPI_LOG_CRIT, "slapi_td_init", "Failed it create private thread index for td_arena_pool\n");
+        return PR_FAILURE;
+    }
+
+    if (pthread_key_create(&td_slab_cache, slab_cache_destroy) != 0) {
+        slapi_log_err(SLAPI_LOG_CRIT, "slapi_td_init", "Failed it create private thread index for td_slab_cache\n");
+        return PR_FAILURE;
+    }
+    if (pthread_key_create(&td_epoch_slot, epoch_slot_release) != 0) {
+        slapi_log_err(SLAPI_LOG_CRIT, "slapi_td_init", "Failed it create private thread index for td_epoch_slot\n");
+        return PR_FAILURE;
+    }
+    td_arena_pool_ready = 1;
+
     return PR_SUCCESS;
 }
 
@@ -115,6 +134,63 @@ slapi_td_get_dn(char **value)
     }
 }
 
+/* arena chunks pool */
+struct arena_pool *
+slapi_td_get_arena_pool(void)
+{
+    if (!td_arena_pool_ready) {
+        return NULL;
+    }
+    return pthread_getspecific(td_arena_pool);
+}
+
+int32_t
+slapi_td_set_arena_pool(struct arena_pool *pool)
+{
+    if (!td_arena_pool_ready || pthread_setspecific(td_arena_pool, pool) != 0) {
+        return PR_FAILURE;
+    }
+    return PR_SUCCESS;
+}
+
+/* slab objects cache, same availability as the arena pool */
+struct slab_cache *
+slapi_td_get_slab_cache(void)
+{
+    if (!td_arena_pool_ready) {
+        return NULL;
+    }
+    return pthread_getspecific(td_slab_cache);
+}
+
+int32_t
+slapi_td_set_slab_cache(struct slab_cache *cache)
+{
+    if (!td_arena_pool_ready || pthread_setspecific(td_slab_cache, cache) != 0) {
+        return PR_FAILURE;
+    }
+    return PR_SUCCESS;
+}
+
+/* epoch slot, same availability as the arena pool */
+struct epoch_slot *
+slapi_td_get_epoch_slot(void)
+{
+    if (!td_arena_pool_ready) {
+        return NULL;
+    }
+    return pthread_getspecific(td_epoch_slot);
+}
+
+int32_t
+slapi_td_set_epoch_slot(struct epoch_slot *slot)
+{
+    if (!td_arena_pool_ready || pthread_setspecific(td_epoch_slot, slot) != 0) {
+        return PR_FAILURE;
+    }
+    return PR_SUCCESS;
+}
+
 /* Worker op-state */
 struct slapi_td_log_op_state_t *
 slapi_td_get_log_op_state() {
@@ -442,6 +442,31 @@ _cl5ReadMods(char **buff, bool print_op)
 }
 
 
+/*
+ * The compressed mods are stored as
+ * <1 byte dictionary id><4 byte mods size><4 byte compressed size><compressed mods>
+ * the dictionary is only known by the replication plugin, so just show the sizes.
+ */
+static void
+print_changelog_mods(char **buff, bool print_op, bool compressed)
+{
+    uint32_t rawlen;
+    uint32_t zlen;
+    char *pos = *buff;
+
+    if (!compressed) {
+        _cl5ReadMods(buff, print_op);
+        return;
+    }
+    pos++;
+    memcpy((char *)&rawlen, pos, sizeof(rawlen));
+    pos += sizeof(rawlen);
+    memcpy((char *)&zlen, pos, sizeof(zlen));
+    pos += sizeof(zlen);
+    db_printf("\tcompressed mods: %u bytes (%u uncompressed)\n", ntohl(zlen), ntohl(rawlen));
+    *buff = pos + ntohl(zlen);
+}
+
 /** print_ber_attr - print one line of attribute, the value was stored
                      in ber format, length followed by string.
 */
@@ -578,11 +603,12 @@ print_changelog(unsigned char *data, int len __attribute__((unused)))
     uint32_t thetime32;
     time_t thetime;
     uint32_t replgen;
+    bool compressed = false;
 
     /* read byte of version */
     version = *((uint8_t *)pos);
-    if (version != 5 && version != 6) {
-        db_printf("Invalid changelog db version %i\nWorks for version 5 and 6 only.\n", version);
+    if (version != 5 && version != 6 && version != 7) {
+        db_printf("Invalid changelog db version %i\nWorks for version 5, 6 and 7 only.\n", version);
         exit(1);
     }
     pos += sizeof(version);
@@ -591,6 +617,12 @@ print_changelog(unsigned char *data, int len __attribute__((unused)))
         /* process the encrypted flag */
         db_printf("\tencrypted: %s\n", *pos ? "yes" : "no");
         pos += sizeof(encrypted);
+    } else if (version == 7) {
+        /* process the flags: 0x01 encrypted, 0x02 compressed mods */
+        encrypted = *((uint8_t *)pos);
+        db_printf("\tencrypted: %s\n", (encrypted & 0x01) ? "yes" : "no");
+        compressed = (encrypted & 0x02) != 0;
+        pos += sizeof(encrypted);
     }
 
     /* read change type */
@@ -618,13 +650,13 @@ print_changelog(unsigned char *data, int len __attribute__((unused)))
         print_attr("dn", &pos);
         /* convert mods to entry */
         db_printf("\toperation: add\n");
-        _cl5ReadMods(&pos, false);
+        print_changelog_mods(&pos, false, compressed);
         break;
 
     case SLAPI_OPERATION_MODIFY:
         print_attr("dn", &pos);
         db_printf("\toperation: modify\n");
-        _cl5ReadMods(&pos, true);
+        print_changelog_mods(&pos, true, compressed);
         break;
 
     case SLAPI_OPERATION_MODRDN: {
@@ -633,7 +665,7 @@ print_changelog(unsigned char *data, int len __attribute__((unused)))
         print_attr("newrdn", &pos);
         db_printf("\tdeleteoldrdn: %d\n", (int)(*pos++));
         print_attr("newsuperior", &pos);
-        _cl5ReadMods(&pos, false);
+        print_changelog_mods(&pos, false, compressed);
         break;
     }
     case SLAPI_OPERATION_DELETE:
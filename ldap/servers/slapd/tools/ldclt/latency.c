@@ -0,0 +1,624 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+
+/*
+    FILE :        latency.c
+    DESCRIPTION :
+            This file contains the latency measurement of ldclt.
+            Each thread records the response time of its operations
+            in log-linear histograms, one per operation type, that
+            are merged at the end of the run to report the mean and
+            the percentiles in text, JSON or CSV.
+            With -e rate the threads do not run closed-loop anymore:
+            the operations are started on a schedule (constant or
+            Poisson arrivals) and the response time is measured from
+            the scheduled start, so a slow answer also accounts for
+            the operations it delayed (coordinated omission).
+            With -e scenario each operation is chosen at random
+            following the weights given in a file.
+    LOCAL :        None.
+*/
+
+
+#include <stdio.h>   /* printf(), etc... */
+#include <stdlib.h>  /* malloc(), etc... */
+#include <string.h>  /* strcmp(), etc... */
+#include <errno.h>   /* errno, etc... */
+#include <ctype.h>   /* isspace(), etc... */
+#include <math.h>    /* log() */
+#include <time.h>    /* clock_gettime(), etc... */
+#include <unistd.h>  /* getpid(), etc... */
+#include <pthread.h> /* pthreads(), etc... */
+
+#include <lber.h> /* ldap C-API BER declarations */
+#include <ldap.h> /* ldap C-API declarations */
+#include "port.h"    /* Portability definitions */
+#include "ldclt.h"   /* This tool's include file */
+#include "utils.h"   /* Utilities functions */
+#include "latency.h" /* Latency specific definitions */
+
+
+/*
+ * Private data structures.
+ */
+latency_context latctx;
+
+static const char *latOperNames[LAT_OP_NB] = {
+    "search", "bind", "modify", "add", "delete", "rename"};
+
+
+/* ****************************************************************************
+    FUNCTION :    latNow
+    PURPOSE :    Monotonic clock in nanoseconds.
+ *****************************************************************************/
+static int64_t
+latNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+
+/* ****************************************************************************
+    FUNCTION :    latBucket
+    PURPOSE :    Index of the histogram bucket of a value.
+ *****************************************************************************/
+static int
+latBucket(
+    uint64_t value)
+{
+    int shift;
+
+    if (value >= ((uint64_t)1 << LAT_MAX_BITS))
+        value = ((uint64_t)1 << LAT_MAX_BITS) - 1;
+    if (value < 2 * LAT_SUB_HALF)
+        return ((int)value);
+    shift = 63 - __builtin_clzll(value) - (LAT_SUB_BITS - 1);
+    return ((shift + 1) * LAT_SUB_HALF + (int)(value >> shift) - LAT_SUB_HALF);
+}
+
+
+/* ****************************************************************************
+    FUNCTION :    latBucketValue
+    PURPOSE :    Highest value counted in a bucket.
+ *****************************************************************************/
+static uint64_t
+latBucketValue(
+    int bucket)
+{
+    int shift;
+
+    if (bucket < 2 * LAT_SUB_HALF)
+        return ((uint64_t)bucket);
+    shift = bucket / LAT_SUB_HALF - 1;
+    return ((((uint64_t)(bucket % LAT_SUB_HALF + LAT_SUB_HALF) + 1) << shift) - 1);
+}
+
+
+static void
+latRecord(
+    lat_histo *h,
+    uint64_t value)
+{
+    h->counts[latBucket(value)]++;
+    if (h->count == 0 || value < h->min)
+        h->min = value;
+    if (value > h->max)
+        h->max = value;
+    h->count++;
+    h->sum += value;
+}
+
+
+static void
+latMerge(
+    lat_histo *dst,
+    lat_histo *src)
+{
+    int i;
+
+    if (src->count == 0)
+        return;
+    for (i = 0; i < LAT_BUCKETS; i++)
+        dst->counts[i] += src->counts[i];
+    if (dst->count == 0 || src->min < dst->min)
+        dst->min = src->min;
+    if (src->max > dst->max)
+        dst->max = src->max;
+    dst->count += src->count;
+    dst->sum += src->sum;
+}
+
+
+/* ****************************************************************************
+    FUNCTION :    latPercentile
+    PURPOSE :    Value below which fall pct percent of the values.
+ *****************************************************************************/
+static uint64_t
+latPercentile(
+    lat_histo *h,
+    double pct)
+{
+    uint64_t target;
+    uint64_t seen = 0;
+    int i;
+
+    if (h->count == 0)
+        return (0);
+    target = (uint64_t)((pct / 100.0) * (double)h->count + 0.5);
+    if (target == 0)
+        target = 1;
+    for (i = 0; i < LAT_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= target)
+            return (latBucketValue(i) < h->max ? latBucketValue(i) : h->max);
+    }
+    return (h->max);
+}
+
+
+/* ****************************************************************************
+    FUNCTION :    latOperEnabled
+    PURPOSE :    Tell if the -e option of an operation was given.
+ *****************************************************************************/
+static int
+latOperEnabled(
+    int oper)
+{
+    switch (oper) {
+    case LAT_SEARCH:
+        return (mctx.mode & EXACT_SEARCH);
+    case LAT_BIND:
+        return (mctx.mod2 & M2_BINDONLY);
+    case LAT_MODIFY:
+        return ((mctx.mode & ATTR_REPLACE) || (mctx.mod2 & M2_ATTR_REPLACE_FILE));
+    case LAT_ADD:
+        return (mctx.mode & ADD_ENTRIES);
+    case LAT_DELETE:
+        return (mctx.mode & DELETE_ENTRIES);
+    case LAT_RENAME:
+        return (mctx.mode & RENAME_ENTRIES);
+    }
+    return (0);
+}
+
+
+const char *
+latencyOperName(
+    int oper)
+{
+    return (latOperNames[oper]);
+}
+
+
+/* ****************************************************************************
+    FUNCTION :    latReadScenario
+    PURPOSE :    Read the operations mix file.
+    INPUT :        fname    = file name
+    OUTPUT :    None.
+    RETURN :    -1 if error, 0 else.
+    DESCRIPTION :    Each line is an operation name followed by its weight,
+            e.g. "search 80", "bind 15", "modify 5". The lines
+            starting with '#' are comments.
+ *****************************************************************************/
+static int
+latReadScenario(
+    char *fname)
+{
+    FILE *fp;
+    char line[256];
+    char name[64];
+    int weight;
+    int lineNb = 0;
+    int oper;
+
+    if ((fp = fopen(fname, "r")) == NULL) {
+        fprintf(stderr, "Error: cannot open scenario %s, error=%d (%s)\n",
+                fname, errno, strerror(errno));
+        return (-1);
+    }
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        char *p = line;
+
+        lineNb++;
+        while (isspace((unsigned char)*p))
+            p++;
+        if ((*p == '\0') || (*p == '#'))
+            continue;
+        if (sscanf(p, "%63s %d", name, &weight) != 2) {
+            fprintf(stderr, "Error: %s line %d: expected \"<operation> <weight>\"\n",
+                    fname, lineNb);
+            fclose(fp);
+            return (-1);
+        }
+        for (oper = 0; oper < LAT_OP_NB; oper++)
+            if (strcasecmp(name, latOperNames[oper]) == 0)
+                break;
+        if (oper == LAT_OP_NB) {
+            fprintf(stderr, "Error: %s line %d: unknown operation \"%s\"\n",
+                    fname, lineNb, name);
+            fclose(fp);
+            return (-1);
+        }
+        if (weight < 0) {
+            fprintf(stderr, "Error: %s line %d: negative weight %d\n",
+                    fname, lineNb, weight);
+            fclose(fp);
+            return (-1);
+        }
+        if ((weight > 0) && !latOperEnabled(oper)) {
+            fprintf(stderr, "Error: scenario operation \"%s\" needs its -e option (esearch, bindonly, attreplace, add, delete or rename)\n",
+                    name);
+            fclose(fp);
+            return (-1);
+        }
+        latctx.weights[oper] += weight;
+        latctx.totalWeight += weight;
+    }
+    fclose(fp);
+
+    if (latctx.totalWeight <= 0) {
+        fprintf(stderr, "Error: scenario %s has no operation\n", fname);
+        return (-1);
+    }
+    return (0);
+}
+
+
+/* ****************************************************************************
+    FUNCTION :    latencyInit
+    PURPOSE :    Check the parameters of the latency mode.
+    INPUT :        None.
+    OUTPUT :    None.
+    RETURN :    -1 if error, 0 else.
+    DESCRIPTION :
+ *****************************************************************************/
+int
+latencyInit(void)
+{
+    int oper;
+
+    if (mctx.mode & ASYNC) {
+        fprintf(stderr, "Error: -e latency, rate and scenario need the synchronous mode (no -a)\n");
+        return (-1);
+    }
+    if ((mctx.mode & SCALAB01) || (mctx.mod2 & (M2_GENLDIF | M2_ABANDON))) {
+        fprintf(stderr, "Error: -e latency, rate and scenario do not support scalab01, genldif and abandon\n");
+        return (-1);
+    }
+    if ((latctx.arrival == LAT_ARRIVAL_POISSON) && (latctx.rate <= 0)) {
+        fprintf(stderr, "Error: -e arrival=poisson needs -e rate\n");
+        return (-1);
+    }
+    if ((latctx.scenarioFile != NULL) && (latReadScenario(latctx.scenarioFile) < 0))
+        return (-1);
+    for (oper = 0; oper < LAT_OP_NB; oper++)
+        if (latOperEnabled(oper))
+            break;
+    if (oper == LAT_OP_NB) {
+        fprintf(stderr, "Error: -e latency needs esearch, bindonly, attreplace, add, delete or rename\n");
+        return (-1);
+    }
+    latctx.start = latNow();
+    return (0);
+}
+
+
+/* ****************************************************************************
+    FUNCTION :    latNextInterval
+    PURPOSE :    Time until the next operation of a thread, in nsec.
+ *****************************************************************************/
+static int64_t
+latNextInterval(
+    latency_thread *lt)
+{
+    double mean = 1e9 * (double)mctx.nbThreads / latctx.rate;
+
+    if (latctx.arrival == LAT_ARRIVAL_POISSON)
+        return ((int64_t)(-log(1.0 - erand48(lt->seed)) * mean));
+    return ((int64_t)mean);
+}
+
+
+/* ****************************************************************************
+    FUNCTION :    latencyThreadInit
+    PURPOSE :    Allocate the histograms of a thread and plan its first
+            operation.
+    INPUT :        tttctx    = thread context
+    OUTPUT :    None.
+    RETURN :    -1 if error, 0 else.
+    DESCRIPTION :    The threads of a constant rate are shifted so that the
+            whole of them issue regularly spaced operations.
+ *****************************************************************************/
+int
+latencyThreadInit(
+    thread_context *tttctx)
+{
+    latency_thread *lt;
+
+    lt = (latency_thread *)calloc(1, sizeof(latency_thread));
+    if (lt == NULL) {
+        printf("ldclt[%d]: T%03d: cannot malloc(latency), error=%d (%s)\n",
+               mctx.pid, tttctx->thrdNum, errno, strerror(errno));
+        return (-1);
+    }
+    lt->seed[0] = (unsigned short)tttctx->thrdNum;
+    lt->seed[1] = (unsigned short)mctx.pid;
+    lt->seed[2] = (unsigned short)latNow();
+    lt->next = latNow();
+    if (latctx.rate > 0) {
+        if (latctx.arrival == LAT_ARRIVAL_POISSON)
+            lt->next += latNextInterval(lt);
+        else
+            lt->next += (int64_t)(1e9 * (double)tttctx->thrdNum / latctx.rate);
+    }
+    tttctx->latency = lt;
+    return (0);
+}
+
+
+/* ****************************************************************************
+    FUNCTION :    latWait
+    PURPOSE :    Wait until the next scheduled operation of the thread.
+    INPUT :        tttctx    = thread context
+    OUTPUT :    None.
+    RETURN :    -1 if error, 1 if the thread must shutdown, 0 else.
+    DESCRIPTION :    A thread that is late does not wait, it catches up
+            with the schedule.
+ *****************************************************************************/
+static int
+latWait(
+    thread_context *tttctx)
+{
+    latency_thread *lt = tttctx->latency;
+    struct timespec ts;
+    int64_t delay;
+    int status;
+
+    while ((delay = lt->next - latNow()) > 0) {
+        if (delay > 1000000000)
+            delay = 1000000000; /* check the status every second */
+        ts.tv_sec = delay / 1000000000;
+        ts.tv_nsec = delay % 1000000000;
+        nanosleep(&ts, NULL);
+        if (delay == 1000000000) {
+            if (getThreadStatus(tttctx, &status) < 0)
+                return (-1);
+            if (status == MUST_SHUTDOWN)
+                return (1);
+        }
+    }
+    return (0);
+}
+
+
+/* ****************************************************************************
+    FUNCTION :    latPickOper
+    PURPOSE :    Choose the next operation of the thread.
+ *****************************************************************************/
+static int
+latPickOper(
+    latency_thread *lt)
+{
+    int oper;
+
+    if (latctx.totalWeight > 0) {
+        int pick = (int)(erand48(lt->seed) * latctx.totalWeight);
+
+        for (oper = 0; oper < LAT_OP_NB - 1; oper++) {
+            if (pick < latctx.weights[oper])
+                break;
+            pick -= latctx.weights[oper];
+        }
+        return (oper);
+    }
+
+    /*
+   * No scenario, cycle through the operations given with -e
+   */
+    do {
+        oper = lt->nextOper;
+        lt->nextOper = (lt->nextOper + 1) % LAT_OP_NB;
+    } while (!latOperEnabled(oper));
+    return (oper);
+}
+
+
+/* ****************************************************************************
+    FUNCTION :    latencyOper
+    PURPOSE :    Issue one timed operation.
+    INPUT :        tttctx    = thread context
+    OUTPUT :    None.
+    RETURN :    -1 if error, 0 else.
+    DESCRIPTION :    Used by threadMain() instead of its sequence of
+            operations when the latency mode is on.
+ *****************************************************************************/
+int
+latencyOper(
+    thread_context *tttctx)
+{
+    latency_thread *lt = tttctx->latency;
+    int64_t start;
+    int oper;
+    int ret;
+
+    if (latctx.rate > 0) {
+        if ((ret = latWait(tttctx)) != 0)
+            return (ret < 0 ? -1 : 0);
+        start = lt->next;
+        lt->next += latNextInterval(lt);
+    } else
+        start = latNow();
+
+    oper = latPickOper(lt);
+    switch (oper) {
+    case LAT_SEARCH:
+        ret = doExactSearch(tttctx);
+        break;
+    case LAT_BIND:
+        ret = doBindOnly(tttctx);
+        break;
+    case LAT_MODIFY:
+        if (tttctx->mode & ATTR_REPLACE)
+            ret = doAttrReplace(tttctx);
+        else
+            ret = doAttrFileReplace(tttctx);
+        break;
+    case LAT_ADD:
+        ret = doAddEntry(tttctx);
+        break;
+    case LAT_DELETE:
+        ret = doDeleteEntry(tttctx);
+        break;
+    default:
+        ret = doRename(tttctx);
+        break;
+    }
+    if (ret < 0)
+        return (-1);
+
+    latRecord(&(lt->histo[oper]), (uint64_t)(latNow() - start) / 1000);
+    return (0);
+}
+
+
+/* ****************************************************************************
+    FUNCTION :    latPrintHisto
+    PURPOSE :    Print the statistics of one operation type.
+ *****************************************************************************/
+static void
+latPrintHisto(
+    FILE *fp,
+    const char *name,
+    lat_histo *h,
+    double duration,
+    int first)
+{
+    double mean = h->count ? (double)h->sum / (double)h->count : 0.0;
+    double throughput = duration > 0 ? (double)h->count / duration : 0.0;
+
+    switch (latctx.format) {
+    case LAT_FORMAT_JSON:
+        fprintf(fp, "%s\n    \"%s\": {\"count\": %lu, \"throughput\": %.2f, \"mean\": %.1f, "
+                    "\"min\": %lu, \"p50\": %lu, \"p90\": %lu, \"p99\": %lu, \"p999\": %lu, \"max\": %lu}",
+                first ? "" : ",", name, (unsigned long)h->count, throughput, mean,
+                (unsigned long)h->min,
+                (unsigned long)latPercentile(h, 50.0), (unsigned long)latPercentile(h, 90.0),
+                (unsigned long)latPercentile(h, 99.0), (unsigned long)latPercentile(h, 99.9),
+                (unsigned long)h->max);
+        break;
+    case LAT_FORMAT_CSV:
+        fprintf(fp, "%s,%lu,%.2f,%.1f,%lu,%lu,%lu,%lu,%lu,%lu\n",
+                name, (unsigned long)h->count, throughput, mean, (unsigned long)h->min,
+                (unsigned long)latPercentile(h, 50.0), (unsigned long)latPercentile(h, 90.0),
+                (unsigned long)latPercentile(h, 99.0), (unsigned long)latPercentile(h, 99.9),
+                (unsigned long)h->max);
+        break;
+    default:
+        fprintf(fp, "ldclt[%d]: Latency %-6s: count=%lu (%.2f/sec) mean=%.1fus min=%luus "
+                    "p50=%luus p90=%luus p99=%luus p99.9=%luus max=%luus\n",
+                mctx.pid, name, (unsigned long)h->count, throughput, mean, (unsigned long)h->min,
+                (unsigned long)latPercentile(h, 50.0), (unsigned long)latPercentile(h, 90.0),
+                (unsigned long)latPercentile(h, 99.0), (unsigned long)latPercentile(h, 99.9),
+                (unsigned long)h->max);
+        break;
+    }
+}
+
+
+/* ****************************************************************************
+    FUNCTION :    latencyReport
+    PURPOSE :    Merge the histograms of the threads and print them.
+    INPUT :        None.
+    OUTPUT :    None.
+    RETURN :    -1 if error, 0 else.
+    DESCRIPTION :    No mutex, the histograms may still move if the threads
+            are running (SIGQUIT), the report is then a snapshot.
+ *****************************************************************************/
+int
+latencyReport(void)
+{
+    lat_histo *merged;
+    lat_histo *all;
+    double duration;
+    FILE *fp = stdout;
+    int first = 1;
+    int oper;
+    int i;
+
+    merged = (lat_histo *)calloc(LAT_OP_NB + 1, sizeof(lat_histo));
+    if (merged == NULL) {
+        printf("ldclt[%d]: cannot malloc(latency report), error=%d (%s)\n",
+               mctx.pid, errno, strerror(errno));
+        return (-1);
+    }
+    all = &(merged[LAT_OP_NB]);
+    for (i = 0; i < mctx.nbThreads; i++) {
+        if (tctx[i].latency == NULL)
+            continue;
+        for (oper = 0; oper < LAT_OP_NB; oper++) {
+            latMerge(&(merged[oper]), &(tctx[i].latency->histo[oper]));
+            latMerge(all, &(tctx[i].latency->histo[oper]));
+        }
+    }
+    duration = (double)(latNow() - latctx.start) / 1e9;
+
+    if (latctx.outFile != NULL) {
+        if ((fp = fopen(latctx.outFile, "w")) == NULL) {
+            printf("ldclt[%d]: cannot open %s, error=%d (%s)\n",
+                   mctx.pid, latctx.outFile, errno, strerror(errno));
+            free(merged);
+            return (-1);
+        }
+    }
+
+    switch (latctx.format) {
+    case LAT_FORMAT_JSON:
+        fprintf(fp, "{\n  \"unit\": \"usec\",\n  \"threads\": %d,\n  \"duration\": %.3f,\n",
+                mctx.nbThreads, duration);
+        if (latctx.rate > 0)
+            fprintf(fp, "  \"rate\": %.2f,\n  \"arrival\": \"%s\",\n", latctx.rate,
+                    latctx.arrival == LAT_ARRIVAL_POISSON ? "poisson" : "constant");
+        fprintf(fp, "  \"operations\": {");
+        break;
+    case LAT_FORMAT_CSV:
+        fprintf(fp, "operation,count,throughput,mean,min,p50,p90,p99,p999,max\n");
+        break;
+    default:
+        if (latctx.rate > 0)
+            fprintf(fp, "ldclt[%d]: Latency from the scheduled start, %.2f ops/sec %s arrivals\n",
+                    mctx.pid, latctx.rate,
+                    latctx.arrival == LAT_ARRIVAL_POISSON ? "poisson" : "constant");
+        break;
+    }
+    for (oper = 0; oper < LAT_OP_NB; oper++) {
+        if (merged[oper].count == 0)
+            continue;
+        latPrintHisto(fp, latOperNames[oper], &(merged[oper]), duration, first);
+        first = 0;
+    }
+    latPrintHisto(fp, "all", all, duration, first);
+    if (latctx.format == LAT_FORMAT_JSON)
+        fprintf(fp, "\n  }\n}\n");
+
+    if (fp != stdout)
+        fclose(fp);
+    else
+        fflush(stdout);
+    free(merged);
+    return (0);
+}
+
+/* End of file */
@@ -0,0 +1,110 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+
+/*
+        FILE :        latency.h
+        DESCRIPTION :
+            This file contains the definitions related to the
+            latency measurement and open-loop modes of ldclt.
+ LOCAL :        None.
+*/
+
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+
+/*
+ * Operation types timed by the histograms.
+ */
+#define LAT_SEARCH 0
+#define LAT_BIND 1
+#define LAT_MODIFY 2
+#define LAT_ADD 3
+#define LAT_DELETE 4
+#define LAT_RENAME 5
+#define LAT_OP_NB 6
+
+/*
+ * Arrival laws of the open-loop mode (-e arrival)
+ */
+#define LAT_ARRIVAL_CONSTANT 0
+#define LAT_ARRIVAL_POISSON 1
+
+/*
+ * Output formats of the final report (-e latency)
+ */
+#define LAT_FORMAT_TEXT 0
+#define LAT_FORMAT_JSON 1
+#define LAT_FORMAT_CSV 2
+
+/*
+ * Log-linear histogram of the response times, in microseconds.
+ * The values below 2^LAT_SUB_BITS have their own bucket, then every
+ * power of two is split in 2^(LAT_SUB_BITS-1) buckets, i.e. the value
+ * of a bucket is known within 1/2^(LAT_SUB_BITS-1) (about 1.6%).
+ */
+#define LAT_SUB_BITS 7
+#define LAT_SUB_HALF (1 << (LAT_SUB_BITS - 1))
+#define LAT_MAX_BITS 36 /* 2^36 usec is 19 hours */
+#define LAT_BUCKETS ((LAT_MAX_BITS - LAT_SUB_BITS + 2) * LAT_SUB_HALF)
+
+typedef struct lat_histo
+{
+    uint64_t counts[LAT_BUCKETS];
+    uint64_t count; /* Nb of values */
+    uint64_t sum;   /* To compute the mean */
+    uint64_t min;
+    uint64_t max;
+} lat_histo;
+
+/*
+ * Per thread data, only written by its thread.
+ */
+typedef struct latency_thread
+{
+    lat_histo histo[LAT_OP_NB]; /* One per operation type */
+    int64_t next;               /* Next scheduled start (nsec) */
+    int nextOper;               /* Round robin without scenario */
+    unsigned short seed[3];     /* erand48() state */
+} latency_thread;
+
+/*
+ * This is the latency context structure.
+ */
+typedef struct latency_context
+{
+    double rate;                /* Ops/sec, 0 means closed loop */
+    int arrival;                /* LAT_ARRIVAL_xxx */
+    int format;                 /* LAT_FORMAT_xxx */
+    char *outFile;              /* Report file, NULL is stdout */
+    char *scenarioFile;         /* Operations mix */
+    int weights[LAT_OP_NB];     /* Weight of each operation */
+    int totalWeight;            /* Sum of the weights, 0 if no scenario */
+    int64_t start;              /* Start of the run (nsec) */
+} latency_context;
+
+/*
+ * Exported functions and structures
+ */
+extern latency_context latctx;
+extern int latencyInit(void);
+extern int latencyThreadInit(thread_context *tttctx);
+extern int latencyOper(thread_context *tttctx);
+extern int latencyReport(void);
+extern const char *latencyOperName(int oper);
+
+#endif /* LATENCY_H */
+
+/* End of file */
@@ -53,6 +53,7 @@
 #include "ldclt.h"                              /* This tool's include file */
 #include "utils.h" /* Utilities functions */    /*JLS 16-11-00*/
 #include "scalab01.h" /* Scalab01 specific */   /*JLS 12-01-01*/
+#include "latency.h"  /* Latency specific */
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -247,6 +248,7 @@ tttctxInit(
     tttctx->thrdNum = num;
     tttctx->totalReq = mctx.totalReq;
     tttctx->bufBindDN = NULL;
+    tttctx->latency = NULL;
     sprintf(tttctx->thrdId, "T%03d", tttctx->thrdNum);
 
     if (mctx.mod2 & M2_OBJECT) {
@@ -708,6 +710,13 @@ printGlobalStatistics(void)
     if (!found)
         printf("ldclt[%d]: Global no error occurs during this session.\n", mctx.pid);
 
+    /*
+   * Response times
+   */
+    if (mctx.mod2 & M2_LATENCY)
+        if (latencyReport() < 0)
+            return (-1);
+
     /*
    * Check threads statistics
    */
@@ -1437,6 +1446,8 @@ dumpModeValues(void)
         printf(" genldif=%s", mctx.genldifName); /*JLS 05-04-01*/
     if (mctx.mode & SCALAB01)                    /*JLS 08-01-01*/
         printf(" scalab01");                     /*JLS 08-01-01*/
+    if (mctx.mod2 & M2_LATENCY)
+        printf(" latency");
 
     if (mctx.mode & OC_EMAILPERSON)
         printf(" class=emailPerson");
@@ -1851,6 +1862,16 @@ char *execParams[] = {
     "timestamp",
 #define EP_NOZEROPAD 55 /* do not zero pad numbers created by XXX patterns in values and RDNs */
     "nozeropad",
+#define EP_LATENCY 56 /* response time histograms */
+    "latency",
+#define EP_LATENCY_FILE 57 /* where to write them */
+    "latencyfile",
+#define EP_RATE 58 /* open-loop mode, operations per second */
+    "rate",
+#define EP_ARRIVAL 59 /* constant or poisson arrivals */
+    "arrival",
+#define EP_SCENARIO 60 /* operations mix */
+    "scenario",
     NULL};
 
 /* ****************************************************************************
@@ -2166,6 +2187,52 @@ decodeExecParams(
                 mctx.tsfmt = strdup(DEFAULT_TIMESTAMP_FMT);
             }
             break;
+        case EP_LATENCY:
+            mctx.mod2 |= M2_LATENCY;
+            if ((subvalue == NULL) || (strcmp(subvalue, "text") == 0))
+                latctx.format = LAT_FORMAT_TEXT;
+            else if (strcmp(subvalue, "json") == 0)
+                latctx.format = LAT_FORMAT_JSON;
+            else if (strcmp(subvalue, "csv") == 0)
+                latctx.format = LAT_FORMAT_CSV;
+            else {
+                fprintf(stderr, "Error: -e latency=%s not text|json|csv\n", subvalue);
+                return (-1);
+            }
+            break;
+        case EP_LATENCY_FILE:
+            mctx.mod2 |= M2_LATENCY;
+            if (subvalue == NULL) {
+                fprintf(stderr, "Error: missing arg latencyfile\n");
+                return (-1);
+            }
+            latctx.outFile = strdup(subvalue);
+            break;
+        case EP_RATE:
+            mctx.mod2 |= M2_LATENCY;
+            if ((subvalue == NULL) || ((latctx.rate = atof(subvalue)) <= 0)) {
+                fprintf(stderr, "Error: -e rate needs a positive number of operations per second\n");
+                return (-1);
+            }
+            break;
+        case EP_ARRIVAL:
+            if ((subvalue != NULL) && (strcmp(subvalue, "constant") == 0))
+                latctx.arrival = LAT_ARRIVAL_CONSTANT;
+            else if ((subvalue != NULL) && (strcmp(subvalue, "poisson") == 0))
+                latctx.arrival = LAT_ARRIVAL_POISSON;
+            else {
+                fprintf(stderr, "Error: -e arrival=constant|poisson\n");
+                return (-1);
+            }
+            break;
+        case EP_SCENARIO:
+            mctx.mod2 |= M2_LATENCY;
+            if (subvalue == NULL) {
+                fprintf(stderr, "Error: missing arg scenario\n");
+                return (-1);
+            }
+            latctx.scenarioFile = strdup(subvalue);
+            break;
         default:
             fprintf(stderr, "Error: illegal option -e %s\n", subvalue);
             return (-1);
@@ -2780,6 +2847,11 @@ main(
         }                                                               /*JLS 12-01-01*/
         printf("LDAP oper. timeout = %d sec\n", mctx.timeout);
         printf("Sampling interval  = %d sec\n", mctx.sampling);
+        if (latctx.rate > 0)
+            printf("Operations rate    = %.2f/sec (%s)\n", latctx.rate,
+                   latctx.arrival == LAT_ARRIVAL_POISSON ? "poisson" : "constant");
+        if (latctx.scenarioFile != NULL)
+            printf("Scenario           = %s\n", latctx.scenarioFile);
         if (mctx.mode & EXACT_SEARCH) { /*JLS 03-01-01*/
             switch (mctx.scope) {
             case LDAP_SCOPE_BASE:
@@ -2855,6 +2927,12 @@ main(
         }
     }
 
+    /*
+   * Latency mode, checked last because it depends on the operations
+   */
+    if ((mctx.mod2 & M2_LATENCY) && (latencyInit() < 0))
+        ldcltExit(EXIT_PARAMS);
+
     /*
    * Let's go!
    */
@@ -106,6 +106,7 @@
 #define M2_DEREF 0x00000200                                     /* -e deref */
 #define M2_ATTR_REPLACE_FILE 0x00000400                         /* -e attreplacefile */
 #define M2_NOZEROPAD 0x00000800                                 /* -e nozeropad */
+#define M2_LATENCY 0x00001000                                   /* -e latency, rate, scenario */
 
 /*
  * Combinatory defines
@@ -514,6 +515,7 @@ typedef struct thread_context
     int startSaslAuthid;                      /* Insert random here */
     msgid_cell *firstMsgId;                   /* pending messages */
     msgid_cell *lastMsgId;                    /* last one */
+    struct latency_thread *latency;           /* Latency histograms */
 } thread_context;
 
 /*
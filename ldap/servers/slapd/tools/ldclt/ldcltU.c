@@ -43,6 +43,7 @@
  *         attreplace=name:mask    : replace attribute of existing entry.
  *         attrlist=name:name:name : specify list of attribs to retrieve
  *         attrsonly=0|1  : ldap_search() parameter. Set 0 to read values.
+ *         arrival=constant|poisson : arrival law of -e rate.
  *         bindeach    : ldap_bind() for each operation.
  *         bindonly    : only bind/unbind, no other operation is performed.
  *         close       : will close() the fd, rather than ldap_unbind().
@@ -69,6 +70,8 @@
  *         inetOrgPerson         : objectclass=inetOrgPerson (-e add only).
  *         keydbfile=file        : filename of the key database
  *         keydbpin=password     : password for accessing the key database
+ *         latency[=text|json|csv] : response time percentiles per operation.
+ *         latencyfile=file      : write the latency report to file.
  *         noglobalstats         : don't print periodical global statistics
  *         noloop                  : does not loop the incremental numbers.
  *         object=filename       : build object from input file
@@ -82,12 +85,14 @@
  *         randombinddnfromfile=file : retrieve bind DN & passwd from file
  *         randombinddnlow=value  : low value for random generator.
  *         randombinddnhigh=value : high value for random generator.
+ *         rate=value             : open loop, value operations/sec for all threads.
  *         rdn=attrname:value     : alternate for -f.
  *         referral=on|off|rebind : change referral behaviour.
  *         scalab01               : activates scalab01 scenario.
  *         scalab01_cnxduration   : maximum connection duration.
  *         scalab01_maxcnxnb      : modem pool size.
  *         scalab01_wait          : sleep() between 2 attempts to connect.
+ *         scenario=file          : operations mix, lines "<operation> <weight>".
  *         smoothshutdown         : main thread waits till the worker threads exit.
  *         string        : create random strings rather than random numbers.
  *         v2        : ldap v2.
@@ -148,6 +153,7 @@ usage(void)
     (void)printf("        attreplace=name:mask    : replace attribute of existing entry.\n");
     (void)printf("        attrlist=name:name:name : specify list of attribs to retrieve\n");
     (void)printf("        attrsonly=0|1     : ldap_search() parameter. Set 0 to read values.\n");
+    (void)printf("        arrival=constant|poisson : arrival law of -e rate.\n");
     (void)printf("        bindeach          : ldap_bind() for each operation.\n");
     (void)printf("        bindonly          : only bind/unbind, no other operation is performed.\n");
     (void)printf("        close             : will close() the fd, rather than ldap_unbind().\n");
@@ -174,6 +180,8 @@ usage(void)
     (void)printf("        inetOrgPerson     : objectclass=inetOrgPerson (-e add only).\n");
     (void)printf("        keydbfile=file    : filename of the key database\n");
     (void)printf("        keydbpin=password : password for accessing the key database\n");
+    (void)printf("        latency[=text|json|csv] : response time percentiles per operation.\n");
+    (void)printf("        latencyfile=file  : write the latency report to file.\n");
     (void)printf("        noglobalstats     : don't print periodical global statistics\n");
     (void)printf("        noloop            : does not loop the incremental numbers.\n");
     (void)printf("        object=filename   : build object from input file\n");
@@ -187,12 +195,14 @@ usage(void)
     (void)printf("        randombinddnfromfile=file : retrieve bind DN & passwd from file\n");
     (void)printf("        randombinddnlow=value  : low value for random generator.\n");
     (void)printf("        randombinddnhigh=value : high value for random generator.\n");
+    (void)printf("        rate=value             : open loop, value operations/sec for all threads.\n");
     (void)printf("        rdn=attrname:value     : alternate for -f.\n");
     (void)printf("        referral=on|off|rebind : change referral behaviour.\n");
     (void)printf("        scalab01               : activates scalab01 scenario.\n");
     (void)printf("        scalab01_cnxduration   : maximum connection duration.\n");
     (void)printf("        scalab01_maxcnxnb      : modem pool size.\n");
     (void)printf("        scalab01_wait          : sleep() between 2 attempts to connect.\n");
+    (void)printf("        scenario=file          : operations mix, lines \"<operation> <weight>\".\n");
     (void)printf("        smoothshutdown         : main thread waits till the worker threads exit.\n");
     (void)printf("        string                 : create random strings rather than random numbers.\n");
     (void)printf("        v2                     : ldap v2.\n");
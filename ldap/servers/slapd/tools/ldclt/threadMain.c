@@ -132,6 +132,7 @@ dd/mm/yy | Author    | Comments
 #include "ldclt.h"                              /* This tool's include file */
 #include "utils.h" /* Utilities functions */    /*JLS 14-11-00*/
 #include "scalab01.h" /* Scalab01 specific */   /*JLS 12-01-01*/
+#include "latency.h"  /* Latency specific */
 
 
 /* ****************************************************************************
@@ -980,6 +981,13 @@ threadMain(
     }
 
 
+    /*
+   * Latency histograms and schedule
+   */
+    if (mctx.mod2 & M2_LATENCY)
+        if (latencyThreadInit(tttctx) < 0)
+            ldcltExit(EXIT_INIT);
+
     /*
    * We are ready to go !
    */
@@ -1004,6 +1012,17 @@ threadMain(
                 break;                                /*JLS 17-11-00*/
         }                                             /*JLS 17-11-00*/
 
+        /*
+     * Latency mode : one timed operation on schedule
+     */
+        if (mctx.mod2 & M2_LATENCY) {
+            if (latencyOper(tttctx) < 0)
+                go = 0;
+            else if (getThreadStatus(tttctx, &status) < 0)
+                break;
+            continue;
+        }
+
         /*
      * Do a LDAP request
      */
@@ -1939,6 +1939,9 @@ struct oid_map oidmap[] = {
     {"2.16.840.1.113730.3.6.7", "REPL_CLEANRUV_GET_MAXCSN_OID"},
     {"2.16.840.1.113730.3.6.8", "REPL_CLEANRUV_CHECK_STATUS_OID"},
     {"2.16.840.1.113730.3.6.9", "REPL_ABORT_SESSION_OID"},
+    {"2.16.840.1.113730.3.6.10", "REPL_NSDS_SNAPSHOT_TOTAL_PROTOCOL_OID"},
+    {"2.16.840.1.113730.3.5.17", "REPL_NSDS_SNAPSHOT_CHUNK_REQUEST_OID"},
+    {"2.16.840.1.113730.3.5.18", "REPL_NSDS_BATCH_ENTRIES_REQUEST_OID"},
     {NULL, NULL},
 };
 
@@ -154,7 +154,7 @@ Slapi_Value *
 value_new(const struct berval *bval, CSNType t, const CSN *csn)
 {
     Slapi_Value *v;
-    v = (Slapi_Value *)slapi_ch_malloc(sizeof(Slapi_Value));
+    v = (Slapi_Value *)slab_alloc(SLAB_CLASS_VALUE);
     value_init(v, bval, t, csn);
     if (!counters_created) {
         PR_CREATE_COUNTER(slapi_value_counter_created, "Slapi_Value", "created", "");
@@ -210,7 +210,7 @@ slapi_value_free(Slapi_Value **v)
     if (v != NULL && *v != NULL) {
         VALUE_DUMP(*v, "value_free");
         value_done(*v);
-        slapi_ch_free((void **)v);
+        slab_free(SLAB_CLASS_VALUE, *v);
         *v = NULL;
         PR_INCREMENT_COUNTER(slapi_value_counter_deleted);
         PR_DECREMENT_COUNTER(slapi_value_counter_exist);
@@ -539,9 +539,9 @@ slapi_value_compare(const Slapi_Attr *a, const Slapi_Value *v1, const Slapi_Valu
 size_t
 value_size(const Slapi_Value *v)
 {
-    size_t s = v->bv.bv_len;
+    size_t s = slapi_ch_usable_size(v->bv.bv_val);
     s += csnset_size(v->v_csnset);
-    s += sizeof(Slapi_Value);
+    s += slab_class_size(SLAB_CLASS_VALUE);
     return s;
 }
 
@@ -854,6 +854,8 @@ valueset_size(const Slapi_ValueSet *vs)
     size_t s = 0;
     if (vs && !valuearray_isempty(vs->va)) {
         s = valuearray_size(vs->va);
+        s += slapi_ch_usable_size(vs->va);
+        s += slapi_ch_usable_size(vs->sorted);
     }
     return s;
 }
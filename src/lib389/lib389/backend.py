@@ -1282,6 +1282,10 @@ class DatabaseConfig(DSLdapObject):
             'nsslapd-idl-switch',
             'nsslapd-search-bypass-filter-test',
             'nsslapd-search-use-vlv-index',
+            'nsslapd-search-filter-planner',
+            'nsslapd-search-stream-threshold',
+            'nsslapd-search-snapshot-cachesize',
+            'nsslapd-vlv-rebuild-threads',
             'nsslapd-exclude-from-export',
             'nsslapd-serial-lock',
             'nsslapd-pagedlookthroughlimit',
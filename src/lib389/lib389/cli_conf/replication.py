@@ -48,11 +48,13 @@ arg_to_attr = {
         'repl_backoff_max': 'nsds5replicabackoffmax',
         'repl_release_timeout': 'nsds5replicareleasetimeout',
         'repl_keepalive_update_interval': 'nsds5replicakeepaliveupdateinterval',
+        'repl_apply_threads': 'nsds5replicaapplythreads',
         # Changelog
         'cl_dir': 'nsslapd-changelogdir',
         'max_entries': 'nsslapd-changelogmaxentries',
         'max_age': 'nsslapd-changelogmaxage',
         'trim_interval': 'nsslapd-changelogtrim-interval',
+        'compression': 'nsslapd-changelogcompression',
         'encrypt_algo': 'nsslapd-encryptionalgorithm',
         'encrypt_key': 'nssymmetrickey',
         # Agreement
@@ -77,6 +79,7 @@ arg_to_attr = {
         'session_pause_time': 'nsds5replicaSessionPauseTime',
         'flow_control_window': 'nsds5replicaflowcontrolwindow',
         'flow_control_pause': 'nsds5replicaflowcontrolpause',
+        'init_mode': 'nsds5replicainitmode',
         # Additional Winsync Agmt attrs
         'win_subtree': 'nsds7windowsreplicasubtree',
         'ds_subtree': 'nsds7directoryreplicasubtree',
@@ -1509,6 +1512,8 @@ def create_parser(subparsers):
     repl_set_per_backend_cl.add_argument('--max-entries', help="Sets the maximum number of entries to get in the replication changelog")
     repl_set_per_backend_cl.add_argument('--max-age', help="Set the maximum age of a replication changelog entry")
     repl_set_per_backend_cl.add_argument('--trim-interval', help="Sets the interval to check if the replication changelog can be trimmed")
+    repl_set_per_backend_cl.add_argument('--compression', choices=['on', 'off'],
+                                         help="Compresses the large changes written to the replication changelog")
     repl_set_per_backend_cl.add_argument('--encrypt', action='store_true',
                                          help="Sets the replication changelog to use encryption. You must export and "
                                               "import the changelog after setting this.")
@@ -1583,6 +1588,9 @@ def create_parser(subparsers):
     repl_set_parser.add_argument('--repl-keepalive-update-interval', help="Interval in seconds for how often the server will apply "
                                                                           "an internal update to keep the RUV from getting stale. "
                                                                           "The default is 1 hour (3600 seconds)")
+    repl_set_parser.add_argument('--repl-apply-threads', help="The number of updates received from a supplier that a consumer may "
+                                                              "apply in parallel when they do not depend on each other. "
+                                                              "The default is 1 (updates are applied in order)")
 
     repl_monitor_parser = repl_subcommands.add_parser('monitor', help='Display the full replication topology report', formatter_class=CustomHelpFormatter)
     repl_monitor_parser.set_defaults(func=get_repl_monitor_info)
@@ -1743,6 +1751,9 @@ def create_parser(subparsers):
     agmt_add_parser.add_argument('--flow-control-pause',
                                  help="Sets the time in milliseconds to pause after reaching the number of entries and "
                                       "updates set in \"--flow-control-window\"")
+    agmt_add_parser.add_argument('--init-mode',
+                                 help="Sets how the consumer is initialized: \"entry\" sends the entries, \"snapshot\" "
+                                      "sends a copy of the databases when both servers support it")
     agmt_add_parser.add_argument('--bootstrap-bind-dn',
                                  help="Sets an optional bind DN the agreement can use to bootstrap initialization when "
                                       "bind groups are being used")
@@ -1787,6 +1798,9 @@ def create_parser(subparsers):
     agmt_set_parser.add_argument('--flow-control-pause',
                                  help="Sets the time in milliseconds to pause after reaching the number of entries and "
                                       "updates set in \"--flow-control-window\"")
+    agmt_set_parser.add_argument('--init-mode',
+                                 help="Sets how the consumer is initialized: \"entry\" sends the entries, \"snapshot\" "
+                                      "sends a copy of the databases when both servers support it")
     agmt_set_parser.add_argument('--bootstrap-bind-dn',
                                  help="Sets an optional bind DN the agreement can use to bootstrap initialization when "
                                       "bind groups are being used")
@@ -7,7 +7,9 @@
 # --- END COPYRIGHT BLOCK ---
 
 import copy
+import re
 import psutil
+import ldap.dn
 from lib389._constants import *
 from lib389._mapped_object import DSLdapObject
 from lib389.utils import (ds_is_older)
@@ -181,6 +183,8 @@ class Monitor(DSLdapObject):
             'totalconnections',
             'currentconnectionsatmaxthreads',
             'maxthreadsperconnhits',
+            'currentconnectionsinturbo',
+            'turbomodehits',
             'dtablesize',
             'readwaiters',
             'opsinitiated',
@@ -261,6 +265,11 @@ class MonitorLDBM(DSLdapObject):
                 'maxnormalizeddncachesize', 'currentnormalizeddncachecount',
                 'normalizeddncachethreadsize', 'normalizeddncachethreadslots'
             ])
+        self._backend_keys.extend([
+            'searchsnapshottries', 'searchsnapshothits',
+            'currentsearchsnapshotsize', 'currentsearchsnapshotcount',
+            'currentvattrcachesize'
+        ])
 
     def get_status(self, use_json=False):
         ldbm_dict = self.get_attrs_vals_utf8(self._backend_keys)
@@ -382,6 +391,8 @@ class MonitorBackend(DSLdapObject):
                 'maxdncachesize',
                 'currentdncachecount',
                 'maxdncachecount',
+                'currentsearchsnapshotsize',
+                'currentcachememorysize',
             ]
             if ds_is_older("1.4.0", instance=self._instance):
                 self._backend_keys.extend([
@@ -403,6 +414,8 @@ class MonitorBackend(DSLdapObject):
                 'maxentrycachesize',
                 'currententrycachecount',
                 'maxentrycachecount',
+                'currentsearchsnapshotsize',
+                'currentcachememorysize',
             ]
 
 
@@ -524,3 +537,34 @@ class MonitorDiskSpace(DSLdapObject):
         """Get an information about partitions which contains a Directory Server data"""
 
         return self.get_attr_vals_utf8_l("dsDisk")
+
+
+class MonitorPlugin(DSLdapObject):
+    """A class for representing the "cn=<plugin>,cn=plugins,cn=monitor" entry
+    of a plugin, present when the plugin implements operation callbacks
+
+    :param instance: An instance
+    :type instance: lib389.DirSrv
+    :param name: The cn of the plugin configuration entry
+    :type name: str
+    """
+
+    def __init__(self, instance, name=None, dn=None):
+        super(MonitorPlugin, self).__init__(instance=instance, dn=dn)
+        if name is not None:
+            self._dn = 'cn=%s,cn=plugins,cn=monitor' % ldap.dn.escape_dn_chars(name)
+
+    def get_callstats(self):
+        """Get the statistics of each callback of the plugin
+
+        :returns: A list of dicts, with the plugin and callback names, the
+                  counters as ints and the latency histogram as a list
+        """
+        result = []
+        for value in self.get_attr_vals_utf8('callstats'):
+            stats = dict(re.findall(r'(\w+)="([^"]*)"', value))
+            for key in ('calls', 'failed', 'totalusec', 'maxusec', 'p50usec', 'p99usec'):
+                stats[key] = int(stats[key])
+            stats['latency'] = [int(n) for n in stats['latency'].split(',')]
+            result.append(stats)
+        return result
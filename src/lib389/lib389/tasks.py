@@ -257,6 +257,20 @@ class DBCompactTask(Task):
         super(DBCompactTask, self).__init__(instance, dn)
 
 
+class IndexStatisticsTask(Task):
+    """A single instance of index statistics task entry
+
+    :param instance: An instance
+    :type instance: lib389.DirSrv
+    """
+
+    def __init__(self, instance, dn=None):
+        self.cn = 'index_statistics_' + Task.get_timestamp()
+        dn = "cn=" + self.cn + ",cn=index statistics," + DN_TASKS
+        super(IndexStatisticsTask, self).__init__(instance, dn)
+        self._must_attributes.extend(['nsInstance'])
+
+
 class SchemaReloadTask(Task):
     """A single instance of schema reload task entry
 
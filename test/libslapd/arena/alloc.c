@@ -0,0 +1,73 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "../../test_slapd.h"
+
+void
+test_libslapd_arena_alloc(void **state __attribute__((unused)))
+{
+    Slapi_Arena *arena = slapi_arena_new();
+    char *small[64];
+    char *large = NULL;
+    char *s = NULL;
+    uint32_t *zeroes = NULL;
+
+    /* Many small allocations span several chunks and do not overlap */
+    for (size_t i = 0; i < 64; i++) {
+        small[i] = slapi_arena_alloc(arena, 500);
+        assert_true(((uintptr_t)small[i] % 16) == 0);
+        memset(small[i], (int)i, 500);
+    }
+    for (size_t i = 0; i < 64; i++) {
+        assert_int_equal(small[i][0], (char)i);
+        assert_int_equal(small[i][499], (char)i);
+    }
+
+    /* Larger than a chunk */
+    large = slapi_arena_alloc(arena, 100000);
+    memset(large, 'x', 100000);
+
+    zeroes = slapi_arena_calloc(arena, 100, sizeof(uint32_t));
+    for (size_t i = 0; i < 100; i++) {
+        assert_int_equal(zeroes[i], 0);
+    }
+
+    s = slapi_arena_strdup(arena, "uid=arena,dc=example,dc=com");
+    assert_string_equal(s, "uid=arena,dc=example,dc=com");
+    assert_null(slapi_arena_strdup(arena, NULL));
+
+    slapi_arena_destroy(&arena);
+    assert_null(arena);
+    /* Destroying twice is fine */
+    slapi_arena_destroy(&arena);
+}
+
+void
+test_libslapd_arena_mark(void **state __attribute__((unused)))
+{
+    Slapi_Arena *arena = slapi_arena_new();
+    Slapi_Arena_Mark mark;
+    char *kept = slapi_arena_strdup(arena, "kept");
+    char *first = NULL;
+    char *again = NULL;
+
+    slapi_arena_mark(arena, &mark);
+    first = slapi_arena_alloc(arena, 32);
+    /* go over several chunks before releasing */
+    for (size_t i = 0; i < 10; i++) {
+        slapi_arena_alloc(arena, 4000);
+    }
+    slapi_arena_release(arena, &mark);
+
+    /* The memory after the mark is reused, not the one before */
+    again = slapi_arena_alloc(arena, 32);
+    assert_ptr_equal(first, again);
+    assert_string_equal(kept, "kept");
+
+    slapi_arena_destroy(&arena);
+}
@@ -0,0 +1,84 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "../../test_slapd.h"
+
+#include <slapi-private.h>
+#include <pthread.h>
+
+static int32_t freed;
+
+static void
+reclaim_free(void *obj)
+{
+    freed++;
+    slapi_ch_free(&obj);
+}
+
+static void *
+reclaim_reader(void *arg)
+{
+    /* The exiting thread gives back its slot, without blocking the writer */
+    assert_int_equal(epoch_enter(), 1);
+    *(int32_t *)arg = 1;
+    epoch_leave();
+    return NULL;
+}
+
+void
+test_libslapd_epoch_reclaim(void **state __attribute__((unused)))
+{
+    pthread_t thread;
+    int32_t ran = 0;
+
+    /* Without thread data, the callers use their locked path */
+    assert_int_equal(epoch_enter(), 0);
+    assert_int_equal(slapi_td_init(), 0);
+
+    /* No section: freed at once */
+    freed = 0;
+    epoch_retire(slapi_ch_malloc(8), reclaim_free);
+    assert_int_equal(freed, 1);
+
+    /* Retired in a section: freed when the section is left */
+    freed = 0;
+    assert_int_equal(epoch_enter(), 1);
+    epoch_retire(slapi_ch_malloc(8), reclaim_free);
+    assert_int_equal(freed, 0);
+    epoch_leave();
+    assert_int_equal(freed, 1);
+
+    /* Nested sections: only the outermost one counts */
+    freed = 0;
+    assert_int_equal(epoch_enter(), 1);
+    assert_int_equal(epoch_enter(), 1);
+    epoch_retire(slapi_ch_malloc(8), reclaim_free);
+    epoch_leave();
+    assert_int_equal(freed, 0);
+    epoch_leave();
+    assert_int_equal(freed, 1);
+
+    /* A section entered after the retirement does not hold the object */
+    freed = 0;
+    assert_int_equal(epoch_enter(), 1);
+    epoch_retire(slapi_ch_malloc(8), reclaim_free);
+    epoch_leave();
+    assert_int_equal(epoch_enter(), 1);
+    epoch_retire(slapi_ch_malloc(8), reclaim_free);
+    assert_int_equal(freed, 1);
+    epoch_leave();
+    assert_int_equal(freed, 2);
+
+    /* Sections of other threads */
+    assert_int_equal(pthread_create(&thread, NULL, reclaim_reader, &ran), 0);
+    assert_int_equal(pthread_join(thread, NULL), 0);
+    assert_int_equal(ran, 1);
+    freed = 0;
+    epoch_retire(slapi_ch_malloc(8), reclaim_free);
+    assert_int_equal(freed, 1);
+}
@@ -0,0 +1,83 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "../../test_slapd.h"
+
+#include <slap.h>
+#include <pthread.h>
+
+#define SLAB_TEST_VALUES 5000
+
+void
+test_libslapd_slab_values(void **state __attribute__((unused)))
+{
+    Slapi_Value **values = (Slapi_Value **)slapi_ch_calloc(SLAB_TEST_VALUES, sizeof(Slapi_Value *));
+    uint64_t slabs = 0;
+    uint64_t bytes = 0;
+    char buf[32];
+
+    for (size_t i = 0; i < SLAB_TEST_VALUES; i++) {
+        snprintf(buf, sizeof(buf), "value %zu", i);
+        values[i] = slapi_value_new_string(buf);
+    }
+    for (size_t i = 0; i < SLAB_TEST_VALUES; i++) {
+        snprintf(buf, sizeof(buf), "value %zu", i);
+        assert_string_equal(slapi_value_get_string(values[i]), buf);
+        assert_int_equal(slapi_value_get_flags(values[i]), 0);
+    }
+    slabs = slab_class_slabs(SLAB_CLASS_VALUE, &bytes);
+    assert_true(slabs > 0);
+    assert_true(bytes >= SLAB_TEST_VALUES * sizeof(Slapi_Value));
+
+    for (size_t i = 0; i < SLAB_TEST_VALUES; i++) {
+        slapi_value_free(&values[i]);
+        assert_null(values[i]);
+    }
+
+    /* The freed objects are reused, no new slab is needed */
+    for (size_t i = 0; i < SLAB_TEST_VALUES; i++) {
+        values[i] = slapi_value_new_string("again");
+    }
+    assert_int_equal(slab_class_slabs(SLAB_CLASS_VALUE, NULL), slabs);
+    for (size_t i = 0; i < SLAB_TEST_VALUES; i++) {
+        slapi_value_free(&values[i]);
+    }
+    slapi_ch_free((void **)&values);
+}
+
+static void *
+slab_test_alloc_attrs(void *arg)
+{
+    Slapi_Attr **attrs = (Slapi_Attr **)arg;
+
+    for (size_t i = 0; i < SLAB_TEST_VALUES; i++) {
+        attrs[i] = slapi_attr_new();
+        assert_null(attrs[i]->a_type);
+        attrs[i]->a_flags = i;
+    }
+    return NULL;
+}
+
+void
+test_libslapd_slab_threads(void **state __attribute__((unused)))
+{
+    Slapi_Attr **attrs = (Slapi_Attr **)slapi_ch_calloc(SLAB_TEST_VALUES, sizeof(Slapi_Attr *));
+    pthread_t thread;
+
+    /* Objects allocated by a thread may be freed by another one */
+    assert_int_equal(pthread_create(&thread, NULL, slab_test_alloc_attrs, attrs), 0);
+    assert_int_equal(pthread_join(thread, NULL), 0);
+    for (size_t i = 0; i < SLAB_TEST_VALUES; i++) {
+        assert_int_equal(attrs[i]->a_flags, i);
+        for (size_t j = i + 1; j < SLAB_TEST_VALUES && j < i + 8; j++) {
+            assert_ptr_not_equal(attrs[i], attrs[j]);
+        }
+        slapi_attr_free(&attrs[i]);
+    }
+    slapi_ch_free((void **)&attrs);
+}
@@ -50,6 +50,20 @@ void test_libslapd_operation_v3c_target_spec(void **state);
 void test_libslapd_counters_atomic_usage(void **state);
 void test_libslapd_counters_atomic_overflow(void **state);
 
+/* libslapd-arena-alloc */
+
+void test_libslapd_arena_alloc(void **state);
+void test_libslapd_arena_mark(void **state);
+
+/* libslapd-epoch-reclaim */
+
+void test_libslapd_epoch_reclaim(void **state);
+
+/* libslapd-slab-pool */
+
+void test_libslapd_slab_values(void **state);
+void test_libslapd_slab_threads(void **state);
+
 /* libslapd-pal-meminfo */
 
 void test_libslapd_pal_meminfo(void **state);